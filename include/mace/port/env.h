@@ -42,6 +42,22 @@ class MallocLogger {
 class FileSystem;
 class LogWriter;
 
+// A CPU the process may run on. CPUs with the same core_id are SMT siblings,
+// and those with the same llc_id share the last level cache.
+struct CPUInfo {
+  size_t cpu_id;
+  int core_id;
+  int llc_id;
+  int numa_node;
+};
+
+struct CPUTopology {
+  // The CPUs allowed by the cpuset of the process, ascending
+  std::vector<CPUInfo> cpus;
+  // CPUs worth of time the CFS quota allows per period, 0 for no quota
+  float cpu_quota = 0;
+};
+
 class Env {
  public:
   virtual int64_t NowMicros() = 0;
@@ -50,6 +66,18 @@ class Env {
   virtual MaceStatus AdviseFree(void *addr, size_t length);
   virtual MaceStatus GetCPUMaxFreq(std::vector<float> *max_freqs);
   virtual MaceStatus SchedSetAffinity(const std::vector<size_t> &cpu_ids);
+  // Unlike SchedSetAffinity, which may be a no-op on some platforms, this
+  // always binds the calling thread if supported; it is used for explicit
+  // NUMA placement and the topology affinity policies.
+  virtual MaceStatus SchedSetNUMAAffinity(const std::vector<size_t> &cpu_ids);
+  virtual MaceStatus GetNUMANodeCPUs(int numa_node,
+                                     std::vector<size_t> *cpu_ids);
+  virtual MaceStatus GetCPUTopology(CPUTopology *topology);
+  // Map anonymous memory aligned to the huge page size. If numa_node is not
+  // negative, the pages are preferably allocated on that node.
+  virtual MaceStatus MapPages(size_t length, CPUMemoryPolicy policy,
+                              int numa_node, void **result);
+  virtual MaceStatus UnmapPages(void *addr, size_t length);
   virtual FileSystem *GetFileSystem() = 0;
   virtual LogWriter *GetLogWriter() = 0;
   // Return the current backtrace, will allocate memory inside the call
@@ -88,6 +116,28 @@ inline MaceStatus SchedSetAffinity(const std::vector<size_t> &cpu_ids) {
   return port::Env::Default()->SchedSetAffinity(cpu_ids);
 }
 
+inline MaceStatus SchedSetNUMAAffinity(const std::vector<size_t> &cpu_ids) {
+  return port::Env::Default()->SchedSetNUMAAffinity(cpu_ids);
+}
+
+inline MaceStatus GetNUMANodeCPUs(int numa_node,
+                                  std::vector<size_t> *cpu_ids) {
+  return port::Env::Default()->GetNUMANodeCPUs(numa_node, cpu_ids);
+}
+
+inline MaceStatus GetCPUTopology(port::CPUTopology *topology) {
+  return port::Env::Default()->GetCPUTopology(topology);
+}
+
+inline MaceStatus MapPages(size_t length, CPUMemoryPolicy policy,
+                           int numa_node, void **result) {
+  return port::Env::Default()->MapPages(length, policy, numa_node, result);
+}
+
+inline MaceStatus UnmapPages(void *addr, size_t length) {
+  return port::Env::Default()->UnmapPages(addr, length);
+}
+
 inline port::FileSystem *GetFileSystem() {
   return port::Env::Default()->GetFileSystem();
 }
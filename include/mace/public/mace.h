@@ -22,6 +22,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #ifndef MACE_API
@@ -116,12 +117,74 @@ enum GPUPriorityHint {
 // cores with bottom-num_threads_hint frequencies.
 // If 'num_threads_hint' is -1 or greater than number of available cores,
 // 'num_threads_hint' will be reset to number of available cores.
+// AFFINITY_PHYSICAL_CORES: initiate 'num_threads_hint' threads on one SMT
+// sibling of each physical core, for CPUs with equal frequencies such as x86.
+// Each thread is bound to its own core.
+// If 'num_threads_hint' is -1 or greater than number of physical cores,
+// 'num_threads_hint' will be reset to number of physical cores.
+// AFFINITY_SINGLE_LLC: same as AFFINITY_PHYSICAL_CORES, but only on the
+// physical cores sharing the last level cache with the most of them.
+// Available cores are the ones allowed by the cpuset of the process on Linux,
+// and the number of threads is also limited by its CFS quota (cpu.max),
+// rounded to the nearest number of CPUs.
 enum CPUAffinityPolicy {
   AFFINITY_NONE = 0,
   AFFINITY_BIG_ONLY = 1,
   AFFINITY_LITTLE_ONLY = 2,
   AFFINITY_HIGH_PERFORMANCE = 3,
   AFFINITY_POWER_SAVE = 4,
+  AFFINITY_PHYSICAL_CORES = 5,
+  AFFINITY_SINGLE_LLC = 6,
+};
+
+// CPU_MEMORY_DEFAULT: CPU buffers are allocated from the heap.
+// CPU_MEMORY_HUGE_PAGE: large CPU buffers (weights and the shared tensor
+// arena) are mapped with huge page alignment and advised to use transparent
+// huge pages; the others are aligned to the cache line.
+// CPU_MEMORY_EXPLICIT_HUGE_PAGE: same as CPU_MEMORY_HUGE_PAGE, but large
+// buffers are taken from the reserved huge page pool (hugetlbfs) first, and
+// fall back to transparent huge pages when the pool is exhausted.
+enum CPUMemoryPolicy {
+  CPU_MEMORY_DEFAULT = 0,
+  CPU_MEMORY_HUGE_PAGE = 1,
+  CPU_MEMORY_EXPLICIT_HUGE_PAGE = 2,
+};
+
+// Statistics to choose the quantization range of each activation with,
+// see MaceEngineConfig::SetCalibration.
+// CALIBRATION_MIN_MAX: the min and max values of all the samples.
+// CALIBRATION_PERCENTILE: clip the given percentile of values on both sides.
+// CALIBRATION_KL_DIVERGENCE: clip the absolute values at the threshold whose
+// 8-bit quantized distribution is the closest to the original one.
+enum CalibrationMethod {
+  CALIBRATION_NONE = 0,
+  CALIBRATION_MIN_MAX = 1,
+  CALIBRATION_PERCENTILE = 2,
+  CALIBRATION_KL_DIVERGENCE = 3,
+};
+
+// Channel order of color images.
+enum PixelOrder {
+  PIXEL_RGB = 0,
+  PIXEL_BGR = 1,
+};
+
+// Preprocessing of an image input, see MaceEngineConfig::SetInputPreprocess.
+// The pixels are fed as an IDT_UINT8 NHWC MaceTensor in source_order, and
+// the model input gets (pixel - mean[c]) / std[c] of the crop window, with
+// the channels in model_order. mean and std are per channel of the model
+// input, empty for 0 and 1. The crop window is
+// [crop_top, crop_top + crop_height) x [crop_left, crop_left + crop_width),
+// a crop_height or crop_width of 0 takes the rest of the image.
+struct InputPreprocess {
+  PixelOrder source_order = PIXEL_RGB;
+  PixelOrder model_order = PIXEL_RGB;
+  std::vector<float> mean;
+  std::vector<float> std;
+  int crop_top = 0;
+  int crop_left = 0;
+  int crop_height = 0;
+  int crop_width = 0;
 };
 
 enum class OpenCLCacheReusePolicy {
@@ -411,6 +474,38 @@ class MACE_API MaceEngineConfig {
   MaceStatus SetGPUHints(GPUPerfHint perf_hint,
                          GPUPriorityHint priority_hint);
 
+  /// \brief Set how OpenCL programs are built at initialization.
+  ///
+  /// By default every OpenCL program is built the first time an op needs
+  /// it, one by one. With num_threads not zero, the programs the GPU ops of
+  /// the model need, the ones built by the former runs on this GPU
+  /// (recorded in the OpenCL cache) and the ones in the precompiled OpenCL
+  /// binary are built on num_threads threads when the engine is
+  /// initialized. If background is true, Init does not wait for them; ops
+  /// wait only for the programs they use, and MaceEngine::IsGPUReady tells
+  /// whether all of them are built, so that the application can serve with
+  /// a CPU engine meanwhile. In background, an op using several programs
+  /// may build the ones after the first at its first run.
+  ///
+  /// \param num_threads 0 to disable, negative to use all cores.
+  /// \param background build the programs in background.
+  /// \return MaceStatus::MACE_SUCCESS for success, other for failure.
+  MaceStatus SetGPUProgramBuildPolicy(int num_threads, bool background);
+
+  /// \brief Replay the recorded OpenCL kernels for repeated input shapes
+  ///
+  /// When enabled, a run on GPU records the kernels it enqueues, and the next
+  /// run with the same input shapes enqueues them again without running the
+  /// ops, which cuts most of the host time for small models. The kernels are
+  /// recorded to a command buffer if the device supports
+  /// cl_khr_command_buffer. It only applies to graphs with all the ops on GPU
+  /// whose kernels depend on the input shapes only, and is skipped when
+  /// tuning, profiling or with MACE_OPENCL_QUEUE_WINDOW_SIZE. Disabled by
+  /// default.
+  /// \param enable enable or disable command replay.
+  /// \return MaceStatus::MACE_SUCCESS for success, other for failure.
+  MaceStatus SetGPUCommandReplay(bool enable);
+
   /// \brief Set CPU threads number and affinity policy.
   ///
   /// Caution: this function may hurt performance if improper
@@ -430,6 +525,66 @@ class MACE_API MaceEngineConfig {
   MaceStatus SetCPUThreadPolicy(int num_threads_hint,
                                 CPUAffinityPolicy policy);
 
+  /// \brief Set CPU memory policy and NUMA node.
+  ///
+  /// Large CPU buffers can be backed by huge pages to reduce TLB misses.
+  /// When numa_node is not negative, the thread pool is bound to the CPUs
+  /// of that node (combined with the affinity policy set by
+  /// SetCPUThreadPolicy), and large buffers are allocated on that node;
+  /// the other buffers are placed there by first touch of the bound
+  /// threads. Unsupported settings fall back to the default silently.
+  ///
+  /// \param policy one of CPUMemoryPolicy
+  /// \param numa_node the NUMA node to run on, -1 for no binding.
+  /// \return MaceStatus::MACE_SUCCESS for success, other for failure.
+  MaceStatus SetCPUMemoryPolicy(CPUMemoryPolicy policy, int numa_node);
+
+  /// \brief Share CPU weights with other engines in the same process
+  ///
+  /// When enabled, the CPU weights (including the converted and transposed
+  /// copies made at init time) are kept in a process-wide registry keyed by
+  /// content, so engines loading identical weights map the same read-only
+  /// buffer. The weights are always copied out of model data, so
+  /// model_data_unused will be true. Disabled by default.
+  /// \param enable enable or disable weight sharing.
+  /// \return MaceStatus::MACE_SUCCESS for success, other for failure.
+  MaceStatus SetWeightSharing(bool enable);
+
+  /// \brief Keep the graph for MaceEngine::SaveSnapshot
+  ///
+  /// The engine keeps a copy of the graph after Init only when enabled, so
+  /// that it can be saved to a snapshot later. Disabled by default.
+  /// \param enable enable or disable saving snapshots.
+  /// \return MaceStatus::MACE_SUCCESS for success, other for failure.
+  MaceStatus SetEngineSnapshot(bool enable);
+
+  /// \brief Collect the quantization ranges of the activations
+  ///
+  /// When enabled, the output tensors of each op are fed to a calibration
+  /// observer after the op runs, which accumulates their statistics over all
+  /// the runs of the engine. Get the ranges by
+  /// MaceEngine::GetCalibrationRanges or MaceEngine::SaveCalibrationRanges.
+  /// Only float tensors are observed, so the model should be converted with
+  /// `quantize_stat` to run on CPU. Disabled by default.
+  /// \param method one of CalibrationMethod, CALIBRATION_NONE to disable.
+  /// \param percentile the percentile of values kept, e.g. 99.99, only used
+  /// by CALIBRATION_PERCENTILE.
+  /// \return MaceStatus::MACE_SUCCESS for success, other for failure.
+  MaceStatus SetCalibration(CalibrationMethod method, float percentile);
+
+  /// \brief Convert an image input while feeding it
+  ///
+  /// When the input is fed as uint8 pixels (IDT_UINT8, NHWC), the channel
+  /// reordering, crop, normalization and the transpose to the model's data
+  /// format are done in one pass into the input tensor, instead of the
+  /// application converting the frame to float first. Only float inputs of
+  /// CPU graphs are supported, inputs fed as float are not affected.
+  /// \param input_name the name of the model input.
+  /// \param preprocess the preprocessing of the input, see InputPreprocess.
+  /// \return MaceStatus::MACE_SUCCESS for success, other for failure.
+  MaceStatus SetInputPreprocess(const std::string &input_name,
+                                const InputPreprocess &preprocess);
+
   /// \brief Set Hexagon NN to run on unsigned PD
   ///
   /// Caution: This function must be called before any Hexagon related
@@ -587,6 +742,72 @@ class MACE_API MaceEngine {
   /// \return MaceStatus::MACE_SUCCESS for success, other for failure.
   MaceStatus ReleaseIntermediateBuffer();
 
+  /// \brief Bind the memory of the inputs and outputs to the engine
+  ///
+  /// The network reads the bound inputs and writes the bound outputs in
+  /// place of copying them in and out of its own buffers, the memory
+  /// planner treats the bound outputs as fixed buffers. Only CPU float or
+  /// int32 tensors which need no conversion can be bound, e.g. 4D inputs
+  /// and outputs of CPU float models should be NCHW. The buffers must stay
+  /// valid while bound, and Run() should be passed the same tensors; other
+  /// tensors passed to Run() are copied from/to the bound memory.
+  /// Pass empty maps to unbind all buffers.
+  /// \param inputs the input tensors to bind, keyed by name
+  /// \param outputs the output tensors to bind, keyed by name
+  /// \return MaceStatus::MACE_SUCCESS for success,
+  ///         MACE_INVALID_ARGS for unknown names, MACE_UNSUPPORTED for
+  ///         tensors which can not be bound. Nothing stays bound on failure.
+  MaceStatus BindBuffers(const std::map<std::string, MaceTensor> &inputs,
+                         const std::map<std::string, MaceTensor> &outputs);
+
+  /// \brief Save the initialized engine to a snapshot file
+  ///
+  /// The snapshot holds the graph as adapted to the runtime with its memory
+  /// plan, and the weights as the engine holds them (decoded from fp16 or
+  /// 8-bit and transposed to the layout used by the CPU kernels). The filters
+  /// packed by the GEMM and Winograd kernels of the runs so far are saved as
+  /// well, so run the engine once before saving. Restore it with
+  /// CreateMaceEngineFromSnapshot, which maps the file and skips the weight
+  /// conversions, the graph adaptation, the memory planning and the packing.
+  /// Only CPU graphs are supported for now, and a snapshot can only be
+  /// restored by the same MACE version that saved it. The engine should be
+  /// created with MaceEngineConfig::SetEngineSnapshot enabled.
+  /// \param snapshot_file the path of the snapshot file to write
+  /// \return MaceStatus::MACE_SUCCESS for success,
+  ///         MaceStatus::MACE_INVALID_ARGS if snapshot is not enabled,
+  ///         MaceStatus::MACE_UNSUPPORTED if some graph can not be saved,
+  ///         other for failure.
+  MaceStatus SaveSnapshot(const std::string &snapshot_file);
+
+  /// \brief Get the quantization ranges collected by the runs so far
+  ///
+  /// See MaceEngineConfig::SetCalibration.
+  /// \param ranges the min and max values of each observed tensor.
+  /// \return MaceStatus::MACE_SUCCESS for success,
+  ///         MaceStatus::MACE_INVALID_ARGS if calibration is not enabled,
+  ///         other for failure.
+  MaceStatus GetCalibrationRanges(
+      std::map<std::string, std::pair<float, float>> *ranges);
+
+  /// \brief Save the quantization ranges collected by the runs so far
+  ///
+  /// Each line of the file is `tensor_name@@min,max`, the format of
+  /// `quantize_range_file` in the model deployment file.
+  /// \param range_file the path of the range file to write
+  /// \return MaceStatus::MACE_SUCCESS for success,
+  ///         MaceStatus::MACE_INVALID_ARGS if calibration is not enabled,
+  ///         other for failure.
+  MaceStatus SaveCalibrationRanges(const std::string &range_file);
+
+  /// \brief Whether the OpenCL programs are all built
+  ///
+  /// Always true unless the programs are built in background, see
+  /// MaceEngineConfig::SetGPUProgramBuildPolicy. Until then, Run on this
+  /// engine waits for the programs it uses, so the application may run a
+  /// CPU engine of the same model instead.
+  /// \return true if no OpenCL program is being built in background.
+  bool IsGPUReady();
+
   std::vector<RuntimeType> GetRuntimeTypes();
 
   // @Deprecated, will be removed in future version
@@ -654,6 +875,30 @@ MACE_API MaceStatus CreateMaceEngineFromProto(
     MaceEngine *tutor = nullptr,
     bool fake_warmup = false);
 
+/// \brief Create MaceEngine from a snapshot file
+///
+/// Create MaceEngine object from a file written by MaceEngine::SaveSnapshot.
+/// The weights are mapped from the file directly, so the file should not be
+/// modified while the engine is alive. The weight conversions and the graph
+/// adaptation are skipped, the tensors are placed by the saved memory plan,
+/// and the kernels take the saved packed filters instead of packing them.
+/// The ops are still created from the graph. Buffers bound by
+/// MaceEngine::BindBuffers make the memory be planned again.
+///
+/// \param snapshot_file[in]: the path of the snapshot file
+/// \param config[in]: configurations for MaceEngine.
+/// \param engine[out]: output MaceEngine object
+/// \param tutor[in]: the same as CreateMaceEngineFromProto
+/// \return MaceStatus::MACE_SUCCESS for success,
+///         MaceStatus::MACE_INVALID_ARGS for wrong arguments, a corrupted
+///         snapshot, or a snapshot saved by another MACE version,
+///         MaceStatus::MACE_OUT_OF_RESOURCES for resources is out of range.
+MACE_API MaceStatus CreateMaceEngineFromSnapshot(
+    const std::string &snapshot_file,
+    const MaceEngineConfig &config,
+    std::shared_ptr<MaceEngine> *engine,
+    MaceEngine *tutor = nullptr);
+
 /// \brief Create MaceEngine from files (model file + data file)
 /// Deprecated, will be removed in future version
 ///
@@ -35,9 +35,24 @@ class MaceEngineCfgImpl {
 
   MaceStatus SetGPUHints(GPUPerfHint perf_hint, GPUPriorityHint priority_hint);
 
+  MaceStatus SetGPUProgramBuildPolicy(int num_threads, bool background);
+
+  MaceStatus SetGPUCommandReplay(bool enable);
+
   MaceStatus SetCPUThreadPolicy(int num_threads_hint,
                                 CPUAffinityPolicy policy);
 
+  MaceStatus SetCPUMemoryPolicy(CPUMemoryPolicy policy, int numa_node);
+
+  MaceStatus SetWeightSharing(bool enable);
+
+  MaceStatus SetEngineSnapshot(bool enable);
+
+  MaceStatus SetCalibration(CalibrationMethod method, float percentile);
+
+  MaceStatus SetInputPreprocess(const std::string &input_name,
+                                const InputPreprocess &preprocess);
+
   MaceStatus SetHexagonToUnsignedPD();
 
   MaceStatus SetHexagonPower(HexagonNNCornerType corner,
@@ -57,12 +72,33 @@ class MaceEngineCfgImpl {
 
   CPUAffinityPolicy cpu_affinity_policy() const;
 
+  CPUMemoryPolicy cpu_memory_policy() const;
+
+  int numa_node() const;
+
+  bool weight_sharing() const;
+
+  bool engine_snapshot() const;
+
+  CalibrationMethod calibration_method() const;
+
+  float calibration_percentile() const;
+
+  // nullptr if the input is not preprocessed
+  const InputPreprocess *input_preprocess(const std::string &input_name) const;
+
   std::shared_ptr<OpenclContext> opencl_context() const;
 
   GPUPriorityHint gpu_priority_hint() const;
 
   GPUPerfHint gpu_perf_hint() const;
 
+  int gpu_program_build_threads() const;
+
+  bool gpu_program_build_background() const;
+
+  bool gpu_command_replay() const;
+
   HexagonNNCornerType hexagon_corner() const;
 
   bool hexagon_dcvs_enable() const;
@@ -86,9 +122,19 @@ class MaceEngineCfgImpl {
  private:
   int num_threads_;
   CPUAffinityPolicy cpu_affinity_policy_;
+  CPUMemoryPolicy cpu_memory_policy_;
+  int numa_node_;
+  bool weight_sharing_;
+  bool engine_snapshot_;
+  CalibrationMethod calibration_method_;
+  float calibration_percentile_;
+  std::unordered_map<std::string, InputPreprocess> input_preprocess_;
   std::shared_ptr<OpenclContext> opencl_context_;
   GPUPriorityHint gpu_priority_hint_;
   GPUPerfHint gpu_perf_hint_;
+  int gpu_program_build_threads_;
+  bool gpu_program_build_background_;
+  bool gpu_command_replay_;
   HexagonNNCornerType hexagon_corner_;
   bool hexagon_dcvs_enable_;
   int hexagon_latency_;
@@ -46,6 +46,14 @@ namespace mace {
 #define MACE_PREDICT_TRUE(x) (x)
 #endif
 
+// Hint the cpu to load the cache line holding addr for reading, which hides
+// the latency of data dependent loads such as the rows of an embedding table.
+#if defined(__GNUC__)
+#define MACE_PREFETCH(addr) __builtin_prefetch((addr), 0, 3)
+#else
+#define MACE_PREFETCH(addr) ((void)(addr))
+#endif
+
 }  // namespace mace
 
 #endif  // MACE_UTILS_MACROS_H_
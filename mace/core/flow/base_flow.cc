@@ -18,8 +18,11 @@
 #include <functional>
 
 #include "mace/core/mace_tensor_impl.h"
+#include "mace/core/memory/slice.h"
 #include "mace/core/net_def_adapter.h"
 #include "mace/core/proto/net_def_helper.h"
+#include "mace/ops/common/image_preprocess.h"
+#include "mace/utils/mace_engine_config.h"
 #include "mace/utils/math.h"
 #include "mace/utils/stl_util.h"
 #include "mace/utils/transpose.h"
@@ -50,6 +53,9 @@ MaceStatus BaseFlow::Init(const NetDef *net_def,
                           const int64_t model_data_size,
                           bool *model_data_unused) {
   name_ = net_def->name();
+  if (config_impl_ != nullptr) {
+    ws_->SetWeightSharing(config_impl_->weight_sharing());
+  }
   // Mark quantized model flag
   is_quantized_model_ = NetDefHelper::IsQuantizedModel(*net_def);
   net_data_type_ = net_def->data_type();
@@ -128,6 +134,81 @@ MaceStatus BaseFlow::AllocateIntermediateBuffer() {
   return MaceStatus::MACE_SUCCESS;
 }
 
+MaceStatus BaseFlow::BindBuffers(
+    const std::map<std::string, MaceTensor> &inputs,
+    const std::map<std::string, MaceTensor> &outputs) {
+  // Only the data used as it is can stay in the memory of the user
+  auto same_type = [](const MaceTensor &mace_tensor, const Tensor *tensor) {
+    return mace_tensor.memory_type() == MemoryType::CPU_BUFFER &&
+        tensor->memory_type() == MemoryType::CPU_BUFFER &&
+        ((mace_tensor.data_type() == IDT_FLOAT &&
+            tensor->dtype() == DT_FLOAT) ||
+         (mace_tensor.data_type() == IDT_INT32 &&
+             tensor->dtype() == DT_INT32));
+  };
+  for (auto &input : inputs) {
+    if (input_info_map_.count(input.first) == 0) {
+      LOG(ERROR) << "'" << input.first << "' is not an input of " << name_;
+      return MaceStatus::MACE_INVALID_ARGS;
+    }
+    Tensor *input_tensor = ws_->GetTensor(input.first);
+    std::vector<int> dst_dims;
+    DataFormat data_format = DataFormat::NONE;
+    MACE_RETURN_IF_ERROR(GetInputTransposeDims(
+        input, input_tensor, &dst_dims, &data_format));
+    if (!same_type(input.second, input_tensor) || !dst_dims.empty()) {
+      LOG(ERROR) << "Input " << input.first << " can not be bound, it is "
+                 << "converted or transposed when fed";
+      return MaceStatus::MACE_UNSUPPORTED;
+    }
+  }
+  for (auto &output : outputs) {
+    if (output_info_map_.count(output.first) == 0) {
+      LOG(ERROR) << "'" << output.first << "' is not an output of " << name_;
+      return MaceStatus::MACE_INVALID_ARGS;
+    }
+    Tensor *output_tensor = ws_->GetTensor(output.first);
+    std::pair<const std::string, MaceTensor> output_pair(output);
+    if (net_ == nullptr || output_tensor == nullptr ||
+        !same_type(output.second, output_tensor) ||
+        !GetOutputTransposeDims(*output_tensor, &output_pair).empty()) {
+      LOG(ERROR) << "Output " << output.first << " can not be bound, it is "
+                 << "converted or transposed when fetched";
+      return MaceStatus::MACE_UNSUPPORTED;
+    }
+  }
+
+  bound_inputs_ = inputs;
+  bound_outputs_ = outputs;
+  if (net_ != nullptr) {
+    ExternalMemoryMap external_outputs;
+    for (auto &output : bound_outputs_) {
+      const Tensor *output_tensor = ws_->GetTensor(output.first);
+      external_outputs[output.first] = ExternalMemory{
+          output.second.data<void>().get(),
+          output.second.impl_->buffer_size *
+              static_cast<index_t>(output_tensor->SizeOfType())};
+    }
+    net_->SetExternalOutputs(external_outputs);
+  }
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
+void BaseFlow::SetNetObserver(NetObserver *observer) {
+  if (net_ != nullptr) {
+    net_->SetObserver(observer);
+  }
+}
+
+MaceStatus BaseFlow::ExportWeights(NetDef *net_def,
+                                   std::vector<unsigned char> *data) {
+  MACE_UNUSED(net_def);
+  MACE_UNUSED(data);
+  LOG(WARNING) << "Flow " << name_ << " does not support exporting weights";
+  return MaceStatus::MACE_UNSUPPORTED;
+}
+
 MaceStatus BaseFlow::TransposeInput(
     const std::pair<const std::string, MaceTensor> &input,
     Tensor *input_tensor) {
@@ -136,16 +217,28 @@ MaceStatus BaseFlow::TransposeInput(
   MACE_RETURN_IF_ERROR(GetInputTransposeDims(
       input, input_tensor, &dst_dims, &data_format));
 
-  // Resize the input tensor
-  std::vector<index_t> output_shape = input.second.shape();
-  if (!dst_dims.empty()) {
-    output_shape = TransposeShape<int64_t, index_t>(input.second.shape(),
-                                                    dst_dims);
+  const InputPreprocess *preprocess = config_impl_ == nullptr ? nullptr :
+      config_impl_->input_preprocess(input.first);
+  MaceStatus status;
+  if (preprocess != nullptr && input.second.data_type() == IDT_UINT8) {
+    status = PreprocessInput(input, *preprocess, dst_dims, input_tensor);
+  } else {
+    // Resize the input tensor
+    std::vector<index_t> output_shape = input.second.shape();
+    if (!dst_dims.empty()) {
+      output_shape = TransposeShape<int64_t, index_t>(input.second.shape(),
+                                                      dst_dims);
+    }
+    MACE_RETURN_IF_ERROR(input_tensor->Resize(output_shape));
+
+    // Transpose or copy the mace tensor's data to input tensor, unless it
+    // is bound to the input tensor
+    if (!dst_dims.empty() ||
+        input_tensor->memory_type() != MemoryType::CPU_BUFFER ||
+        input_tensor->raw_data() != input.second.data<void>().get()) {
+      status = TransposeInputByDims(input.second, input_tensor, dst_dims);
+    }
   }
-  MACE_RETURN_IF_ERROR(input_tensor->Resize(output_shape));
-
-  // Transpose or copy the mace tensor's data to input tensor
-  auto status = TransposeInputByDims(input.second, input_tensor, dst_dims);
 
   // Set the data format
   input_tensor->set_data_format(data_format);
@@ -153,6 +246,80 @@ MaceStatus BaseFlow::TransposeInput(
   return status;
 }
 
+MaceStatus BaseFlow::PreprocessInput(
+    const std::pair<const std::string, MaceTensor> &input,
+    const InputPreprocess &preprocess, const std::vector<int> &dst_dims,
+    Tensor *input_tensor) {
+  const MaceTensor &mace_tensor = input.second;
+  const std::vector<int64_t> &shape = mace_tensor.shape();
+  const bool nchw = !dst_dims.empty();
+  if (input_tensor->dtype() != DT_FLOAT ||
+      input_tensor->memory_type() != MemoryType::CPU_BUFFER ||
+      shape.size() != 4 || mace_tensor.data_format() != DataFormat::NHWC ||
+      (nchw && dst_dims != std::vector<int>{0, 3, 1, 2})) {
+    LOG(ERROR) << "Input " << input.first << " can not be preprocessed, "
+               << "only NHWC pixels fed to float CPU inputs are supported";
+    return MaceStatus::MACE_UNSUPPORTED;
+  }
+
+  ops::ImagePreprocessParam param;
+  param.batch = shape[0];
+  param.src_height = shape[1];
+  param.src_width = shape[2];
+  param.channels = shape[3];
+  param.crop_top = preprocess.crop_top;
+  param.crop_left = preprocess.crop_left;
+  param.height = preprocess.crop_height > 0 ?
+      preprocess.crop_height : param.src_height - param.crop_top;
+  param.width = preprocess.crop_width > 0 ?
+      preprocess.crop_width : param.src_width - param.crop_left;
+  if (param.crop_top < 0 || param.crop_left < 0 ||
+      param.height <= 0 || param.width <= 0 ||
+      param.crop_top + param.height > param.src_height ||
+      param.crop_left + param.width > param.src_width) {
+    LOG(ERROR) << "Crop window of input " << input.first
+               << " exceeds the image " << MakeString(shape);
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  const index_t channels = param.channels;
+  const bool swap_rb = preprocess.source_order != preprocess.model_order;
+  if (swap_rb && channels != 3) {
+    LOG(ERROR) << "Input " << input.first << " with " << channels
+               << " channels can not be reordered";
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  if ((!preprocess.mean.empty() &&
+          static_cast<index_t>(preprocess.mean.size()) != channels) ||
+      (!preprocess.std.empty() &&
+          static_cast<index_t>(preprocess.std.size()) != channels)) {
+    LOG(ERROR) << "Mean and std of input " << input.first << " should have "
+               << channels << " channels";
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  param.channel_map.resize(channels);
+  param.scale.resize(channels);
+  param.bias.resize(channels);
+  for (index_t c = 0; c < channels; ++c) {
+    const float mean = preprocess.mean.empty() ? 0.f : preprocess.mean[c];
+    const float std = preprocess.std.empty() ? 1.f : preprocess.std[c];
+    param.channel_map[c] = swap_rb ? channels - 1 - c : c;
+    param.scale[c] = 1.f / std;
+    param.bias[c] = -mean / std;
+  }
+
+  std::vector<index_t> output_shape =
+      {param.batch, param.height, param.width, channels};
+  if (nchw) {
+    output_shape = {param.batch, channels, param.height, param.width};
+  }
+  MACE_RETURN_IF_ERROR(input_tensor->Resize(output_shape));
+  Tensor::MappingGuard input_guard(input_tensor);
+  ops::PreprocessImage(thread_pool_, mace_tensor.data<uint8_t>().get(), param,
+                       nchw, input_tensor->mutable_data<float>());
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
 MaceStatus BaseFlow::TransposeOutput(
     const mace::Tensor &output_tensor,
     std::pair<const std::string, mace::MaceTensor> *output) {
@@ -175,6 +342,14 @@ MaceStatus BaseFlow::TransposeOutput(
     << output->second.impl_->buffer_size;
   output->second.impl_->shape = shape;
 
+  // The net wrote the output tensor in the memory of the user when it is
+  // bound and stays there
+  if (dst_dims.empty() &&
+      output_tensor.memory_type() == MemoryType::CPU_BUFFER &&
+      output_tensor.raw_data() == output->second.data<void>().get()) {
+    return MaceStatus::MACE_SUCCESS;
+  }
+
   // Transpose output tensor
   return TransposeOutputByDims(output_tensor, &(output->second), dst_dims);
 }
@@ -324,6 +499,18 @@ MaceStatus BaseFlow::AllocateBufferForInputTensors() {
     const auto &input_name = input.first;
     Tensor *input_tensor = ws_->GetTensor(input_name);
 
+    auto bound = bound_inputs_.find(input_name);
+    if (bound != bound_inputs_.end()) {
+      // The net reads the memory of the user
+      MaceTensor &mace_tensor = bound->second;
+      main_runtime_->SetBufferToTensor(
+          make_unique<Slice>(MemoryType::CPU_BUFFER, input_tensor->dtype(),
+                             std::vector<index_t>{
+                                 mace_tensor.impl_->buffer_size},
+                             mace_tensor.data<void>().get()),
+          input_tensor);
+      continue;
+    }
     MACE_RETURN_IF_ERROR(main_runtime_->AllocateBufferForTensor(
         input_tensor, BufRentType::RENT_SHARE));
   }
@@ -84,6 +84,22 @@ class BaseFlow {
 
   MaceStatus AllocateIntermediateBuffer();
 
+  // Read the inputs from and write the outputs to the memory of `inputs`
+  // and `outputs` directly, from the next allocation of the intermediate
+  // buffers on. See MaceEngine::BindBuffers.
+  MaceStatus BindBuffers(const std::map<std::string, MaceTensor> &inputs,
+                         const std::map<std::string, MaceTensor> &outputs);
+
+  // Feed the output tensors of the net's operators to `observer`, flows
+  // without a net of MACE operators ignore it.
+  void SetNetObserver(NetObserver *observer);
+
+  // Point the const tensors of `net_def` at the weights as they are held by
+  // this flow after Init (decoded, converted and transposed), appending their
+  // bytes to `data`. Used to save engine snapshots.
+  virtual MaceStatus ExportWeights(NetDef *net_def,
+                                   std::vector<unsigned char> *data);
+
  protected:
   virtual MaceStatus GetInputTransposeDims(
       const std::pair<const std::string, MaceTensor> &input,
@@ -104,6 +120,12 @@ class BaseFlow {
   MaceStatus TransposeInput(
       const std::pair<const std::string, MaceTensor> &input,
       Tensor *input_tensor);
+  // Converts the uint8 pixels of `input` to the input tensor as `preprocess`,
+  // see MaceEngineConfig::SetInputPreprocess.
+  MaceStatus PreprocessInput(
+      const std::pair<const std::string, MaceTensor> &input,
+      const InputPreprocess &preprocess, const std::vector<int> &dst_dims,
+      Tensor *input_tensor);
 
   std::vector<int> GetOutputTransposeDims(
       const mace::Tensor &output_tensor,
@@ -125,6 +147,8 @@ class BaseFlow {
   DataType net_data_type_;
   std::unordered_map<std::string, mace::InputOutputInfo> input_info_map_;
   std::unordered_map<std::string, mace::InputOutputInfo> output_info_map_;
+  std::map<std::string, MaceTensor> bound_inputs_;
+  std::map<std::string, MaceTensor> bound_outputs_;
 
   // objects not retain
   OpRegistry *op_registry_;
@@ -133,6 +133,16 @@ const std::vector<unsigned char> *FileStorage::Find(const std::string &key) {
   return &(iter->second);
 }
 
+std::vector<std::string> FileStorage::Keys() {
+  utils::ReadLock lock(&data_mutex_);
+  std::vector<std::string> keys;
+  keys.reserve(data_.size());
+  for (auto &kv : data_) {
+    keys.push_back(kv.first);
+  }
+  return keys;
+}
+
 int FileStorage::Flush() {
   utils::WriteLock lock(&data_mutex_);
   if (!data_changed_)  return 0;
@@ -204,6 +214,15 @@ const std::vector<unsigned char>* ReadOnlyByteStreamStorage::Find(
   return &(iter->second);
 }
 
+std::vector<std::string> ReadOnlyByteStreamStorage::Keys() {
+  std::vector<std::string> keys;
+  keys.reserve(data_.size());
+  for (auto &kv : data_) {
+    keys.push_back(kv.first);
+  }
+  return keys;
+}
+
 bool ReadOnlyByteStreamStorage::Insert(
     const std::string &key,
     const std::vector<unsigned char> &value) {
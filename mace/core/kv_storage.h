@@ -35,6 +35,7 @@ class KVStorage {
   virtual bool Insert(const std::string &key,
                       const std::vector<unsigned char> &value) = 0;
   virtual const std::vector<unsigned char> *Find(const std::string &key) = 0;
+  virtual std::vector<std::string> Keys() = 0;
   // return: 0 for success, -1 for error
   virtual int Flush() = 0;
   virtual ~KVStorage() {}
@@ -71,6 +72,7 @@ class FileStorage : public KVStorage {
   bool Insert(const std::string &key,
               const std::vector<unsigned char> &value) override;
   const std::vector<unsigned char> *Find(const std::string &key) override;
+  std::vector<std::string> Keys() override;
   int Flush() override;
 
  private:
@@ -94,6 +96,7 @@ class ReadOnlyByteStreamStorage : public KVStorage {
   bool Insert(const std::string &key,
               const std::vector<unsigned char> &value) override;
   const std::vector<unsigned char> *Find(const std::string &key) override;
+  std::vector<std::string> Keys() override;
   int Flush() override;
 
  private:
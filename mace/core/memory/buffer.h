@@ -75,6 +75,11 @@ class Buffer : public MemInfo {
     return 0;
   }
 
+  // Bytes the buffer can hold, -1 if it is bounded by its memory block only.
+  virtual index_t capacity() {
+    return -1;
+  }
+
  private:
   void *buf_;
   void *host_;
@@ -14,6 +14,7 @@
 
 #include "mace/core/memory/general_memory_manager.h"
 
+#include <algorithm>
 #include <string>
 
 #include "mace/core/memory/allocator.h"
@@ -21,13 +22,21 @@
 
 namespace mace {
 
-GeneralMemoryManager::GeneralMemoryManager(Allocator *allocator)
-    : MemoryManager(allocator) {}
+GeneralMemoryManager::GeneralMemoryManager(Allocator *allocator,
+                                           bool scratch_arena)
+    : MemoryManager(allocator) {
+  if (scratch_arena) {
+    scratch_arena_ = make_unique<ScratchArena>(allocator);
+  }
+}
 
 GeneralMemoryManager::~GeneralMemoryManager() {}
 
 void *GeneralMemoryManager::ObtainMemory(const MemInfo &info,
                                          const BufRentType rent_type) {
+  if (rent_type == RENT_SCRATCH && scratch_arena_ != nullptr) {
+    return scratch_arena_->ObtainMemory(info);
+  }
   if (shared_pools_.count(rent_type) == 0) {
     shared_pools_.emplace(rent_type, make_unique<MemoryPool>(allocator_));
   }
@@ -36,6 +45,10 @@ void *GeneralMemoryManager::ObtainMemory(const MemInfo &info,
 
 void GeneralMemoryManager::ReleaseMemory(void *ptr,
                                          const BufRentType rent_type) {
+  if (rent_type == RENT_SCRATCH && scratch_arena_ != nullptr) {
+    // Released with all the scratch memory of the op
+    return;
+  }
   if (shared_pools_.count(rent_type) == 0) {
     LOG(WARNING) << "There is no memory in the rent pool: " << rent_type;
     return;
@@ -44,6 +57,12 @@ void GeneralMemoryManager::ReleaseMemory(void *ptr,
 }
 
 std::vector<index_t> GeneralMemoryManager::GetMemoryRealSize(const void *ptr) {
+  if (scratch_arena_ != nullptr) {
+    index_t bytes = scratch_arena_->GetMemoryRealSize(ptr);
+    if (bytes >= 0) {
+      return {bytes};
+    }
+  }
   for (auto i = shared_pools_.begin(); i != shared_pools_.end(); ++i) {
     auto real_shape = i->second->GetMemoryRealSize(ptr);
     if (real_shape.size() == 0) {
@@ -57,6 +76,10 @@ std::vector<index_t> GeneralMemoryManager::GetMemoryRealSize(const void *ptr) {
 
 void GeneralMemoryManager::ReleaseAllMemory(const BufRentType rent_type,
                                             bool del_buf) {
+  if (rent_type == RENT_SCRATCH && scratch_arena_ != nullptr) {
+    scratch_arena_->ReleaseAllMemory(del_buf);
+    return;
+  }
   if (shared_pools_.count(rent_type) > 0) {
     shared_pools_.at(rent_type)->ReleaseAllMemory(del_buf);
   }
@@ -153,6 +176,93 @@ void GeneralMemoryManager::MemoryPool::ReleaseAllMemory(bool del_buf) {
   }
 }
 
+GeneralMemoryManager::ScratchArena::ScratchArena(Allocator *allocator)
+    : allocator_(allocator),
+      block_(nullptr),
+      block_bytes_(0),
+      used_bytes_(0),
+      peak_bytes_(0) {}
+
+GeneralMemoryManager::ScratchArena::~ScratchArena() {
+  ClearMemory();
+}
+
+void GeneralMemoryManager::ScratchArena::ReleaseUsedMemory() {
+  for (void *block : overflow_blocks_) {
+    allocator_->Delete(block);
+  }
+  overflow_blocks_.clear();
+  used_blocks_.clear();
+  used_bytes_ = 0;
+}
+
+void GeneralMemoryManager::ScratchArena::ClearMemory() {
+  ReleaseUsedMemory();
+  if (block_ != nullptr) {
+    VLOG(2) << "Finally release scratch arena, size: " << block_bytes_;
+    allocator_->Delete(block_);
+    block_ = nullptr;
+  }
+  block_bytes_ = 0;
+  peak_bytes_ = 0;
+}
+
+void *GeneralMemoryManager::ScratchArena::ObtainMemory(
+    const MemInfo &mem_info) {
+  MACE_CHECK(mem_info.mem_type == allocator_->GetMemType());
+  const index_t bytes = std::max<index_t>(PadAlignSize(mem_info.bytes()),
+                                          kMaceAlignment);
+  void *ptr = nullptr;
+  if (used_bytes_ + bytes <= block_bytes_) {
+    ptr = static_cast<uint8_t *>(block_) + used_bytes_;
+  } else {
+    MemInfo overflow_info(mem_info.mem_type, DT_UINT8, {bytes});
+    MACE_CHECK_SUCCESS(allocator_->New(overflow_info, &ptr));
+    overflow_blocks_.push_back(ptr);
+    VLOG(2) << "ScratchArena::ObtainMemory overflow: " << bytes
+            << ", arena size = " << block_bytes_;
+  }
+  used_bytes_ += bytes;
+  peak_bytes_ = std::max(peak_bytes_, used_bytes_);
+  used_blocks_.emplace_back(ptr, bytes);
+  return ptr;
+}
+
+index_t GeneralMemoryManager::ScratchArena::GetMemoryRealSize(
+    const void *ptr) const {
+  for (auto &block : used_blocks_) {
+    if (block.first == ptr) {
+      return block.second;
+    }
+  }
+  const uint8_t *begin = static_cast<const uint8_t *>(block_);
+  const uint8_t *byte_ptr = static_cast<const uint8_t *>(ptr);
+  if (block_ != nullptr && byte_ptr >= begin &&
+      byte_ptr < begin + block_bytes_) {
+    return 0;
+  }
+  return -1;
+}
+
+void GeneralMemoryManager::ScratchArena::ReleaseAllMemory(bool del_buf) {
+  if (del_buf) {
+    ClearMemory();
+    return;
+  }
+
+  ReleaseUsedMemory();
+  if (peak_bytes_ > block_bytes_) {
+    if (block_ != nullptr) {
+      allocator_->Delete(block_);
+      block_ = nullptr;
+    }
+    MemInfo block_info(allocator_->GetMemType(), DT_UINT8, {peak_bytes_});
+    MACE_CHECK_SUCCESS(allocator_->New(block_info, &block_));
+    block_bytes_ = peak_bytes_;
+    VLOG(2) << "ScratchArena grows to " << block_bytes_;
+  }
+}
+
 }  // namespace mace
 
 
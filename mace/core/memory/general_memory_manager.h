@@ -20,6 +20,7 @@
 #include <map>
 #include <memory>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "mace/core/memory/memory_manager.h"
@@ -29,7 +30,10 @@ namespace mace {
 
 class GeneralMemoryManager : public MemoryManager {
  public:
-  explicit GeneralMemoryManager(Allocator *allocator);
+  // With `scratch_arena`, the RENT_SCRATCH memory comes from a ScratchArena,
+  // which needs memory addressable by the host.
+  explicit GeneralMemoryManager(Allocator *allocator,
+                                bool scratch_arena = false);
   ~GeneralMemoryManager();
 
   void *ObtainMemory(const MemInfo &info, const BufRentType rent_type) override;
@@ -59,10 +63,43 @@ class GeneralMemoryManager : public MemoryManager {
     Allocator *allocator_;
   };
 
+  // The scratch memory of one op is bumped out of a single block, and all
+  // of it is released at once before the next op. The requests which do not
+  // fit get their own memory for the op, and the block grows to the most
+  // scratch memory an op used, so it stops allocating after the first run.
+  // The block is not sized when the net is initialized: the ops obtain
+  // scratch memory by the shapes of their inputs, which are only known when
+  // they run, and the inputs may be resized between runs.
+  class ScratchArena {
+   public:
+    explicit ScratchArena(Allocator *allocator);
+    ~ScratchArena();
+
+    void *ObtainMemory(const MemInfo &info);
+    // Bytes obtained at ptr, 0 if it was released, -1 if not from the arena
+    index_t GetMemoryRealSize(const void *ptr) const;
+    void ReleaseAllMemory(bool del_buf);
+
+   private:
+    void ReleaseUsedMemory();
+    void ClearMemory();
+
+   private:
+    Allocator *allocator_;
+    void *block_;
+    index_t block_bytes_;
+    index_t used_bytes_;
+    // The most bytes obtained between two releases
+    index_t peak_bytes_;
+    std::vector<std::pair<void *, index_t>> used_blocks_;
+    std::vector<void *> overflow_blocks_;
+  };
+
  private:
   // namespace and buffer pool
   typedef std::unordered_map<int, std::unique_ptr<MemoryPool>> SharedPools;
   SharedPools shared_pools_;
+  std::unique_ptr<ScratchArena> scratch_arena_;
 };
 
 }  // namespace mace
@@ -28,14 +28,21 @@ class Slice : public Buffer {
       const std::vector<index_t> buffer_dims = std::vector<index_t>(),
       void *base_ptr = nullptr, index_t offset_bytes = 0)
       : Buffer(buffer_mt, dt, buffer_dims, base_ptr),
-        buf_offset(offset_bytes) {}
+        buf_offset(offset_bytes),
+        buf_capacity(bytes()) {}
 
   index_t offset() override {
     return buf_offset;
   }
 
+  // A slice may not grow into the memory after it, which belongs to others.
+  index_t capacity() override {
+    return buf_capacity;
+  }
+
  private:
   index_t buf_offset;
+  index_t buf_capacity;
 };
 
 }  // namespace mace
@@ -0,0 +1,171 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/core/memory/weight_registry.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "mace/core/memory/allocator.h"
+#include "mace/port/env.h"
+#include "mace/utils/logging.h"
+
+namespace mace {
+
+namespace {
+
+inline uint64_t RotateLeft(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t FinalMix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// Two independent 64-bit lanes over 8-byte words, good enough to tell
+// weight tensors apart without paying for a cryptographic hash at load time.
+void HashBytes(const void *src, index_t bytes, uint64_t *h1, uint64_t *h2) {
+  const uint64_t k1 = 0x87c37b91114253d5ULL;
+  const uint64_t k2 = 0x4cf5ad432745937fULL;
+  uint64_t a = 0x9e3779b97f4a7c15ULL ^ static_cast<uint64_t>(bytes);
+  uint64_t b = 0xcbf29ce484222325ULL;
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(src);
+  const index_t words = bytes / 8;
+  for (index_t i = 0; i < words; ++i) {
+    uint64_t w;
+    memcpy(&w, data + i * 8, 8);
+    a = RotateLeft(a ^ (w * k1), 31) * k2;
+    b = (b ^ w) * 0x100000001b3ULL;
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, data + words * 8, static_cast<size_t>(bytes - words * 8));
+  a = RotateLeft(a ^ (tail * k1), 31) * k2;
+  b = (b ^ tail) * 0x100000001b3ULL;
+  *h1 = FinalMix(a ^ b);
+  *h2 = FinalMix(b + a * k1);
+}
+
+}  // namespace
+
+WeightRegistry *WeightRegistry::Get() {
+  // Never destroyed: engines living in static storage may release their
+  // blocks after a function-local static would have been torn down.
+  static WeightRegistry *registry = new WeightRegistry();
+  return registry;
+}
+
+std::string WeightRegistry::MakeKey(const void *src, index_t src_bytes,
+                                    const std::string &target) {
+  uint64_t h1 = 0;
+  uint64_t h2 = 0;
+  HashBytes(src, src_bytes, &h1, &h2);
+  char digest[40];
+  snprintf(digest, sizeof(digest), "%016llx%016llx",
+           static_cast<unsigned long long>(h1),  // NOLINT(runtime/int)
+           static_cast<unsigned long long>(h2));  // NOLINT(runtime/int)
+  return MakeString(digest, ":", src_bytes, ":", target);
+}
+
+std::shared_ptr<void> WeightRegistry::Acquire(const std::string &key,
+                                              const void *src,
+                                              index_t src_bytes,
+                                              index_t bytes,
+                                              const FillFunc &fill) {
+  MACE_CHECK(bytes > 0, "can not share an empty weight block: ", key);
+  std::shared_ptr<void> block;
+  bool verbatim = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = entries_.find(key);
+    if (iter != entries_.end()) {
+      block = iter->second.block.lock();
+      verbatim = iter->second.verbatim;
+    }
+    if (block == nullptr) {
+      void *ptr = nullptr;
+      MACE_CHECK(Memalign(&ptr, kMaceAlignment, bytes) ==
+                     MaceStatus::MACE_SUCCESS,
+                 "failed to allocate shared weight of ", bytes, " bytes");
+      fill(ptr);
+      block.reset(ptr, [this, key, bytes](void *p) {
+        Release(key, p, bytes);
+      });
+      Entry &entry = entries_[key];
+      entry.block = block;
+      entry.ptr = ptr;
+      entry.bytes = bytes;
+      entry.verbatim = (src_bytes == bytes &&
+                        memcmp(ptr, src, static_cast<size_t>(bytes)) == 0);
+      total_bytes_ += bytes;
+      VLOG(3) << "Register shared weight " << key;
+      return block;
+    }
+    MACE_CHECK(iter->second.bytes == bytes,
+               "shared weight size mismatch: ", key);
+  }
+
+  // The block is immutable once registered, compare it out of the lock.
+  if (verbatim && src_bytes == bytes &&
+      memcmp(block.get(), src, static_cast<size_t>(bytes)) == 0) {
+    VLOG(3) << "Reuse shared weight " << key;
+    return block;
+  }
+  void *ptr = nullptr;
+  MACE_CHECK(Memalign(&ptr, kMaceAlignment, bytes) == MaceStatus::MACE_SUCCESS,
+             "failed to allocate weight of ", bytes, " bytes");
+  fill(ptr);
+  if (!verbatim &&
+      memcmp(block.get(), ptr, static_cast<size_t>(bytes)) == 0) {
+    free(ptr);
+    VLOG(3) << "Reuse shared weight " << key;
+    return block;
+  }
+  LOG(WARNING) << "Shared weight " << key
+               << " collides with a different weight, keep a private copy";
+  return std::shared_ptr<void>(ptr, [](void *p) { free(p); });
+}
+
+void WeightRegistry::Release(const std::string &key, void *ptr,
+                             index_t bytes) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    total_bytes_ -= bytes;
+    auto iter = entries_.find(key);
+    // The entry may already point to a newer block created after this one
+    // expired, only drop it when it is still ours.
+    if (iter != entries_.end() && iter->second.ptr == ptr) {
+      entries_.erase(iter);
+    }
+  }
+  VLOG(3) << "Free shared weight " << key;
+  free(ptr);
+}
+
+size_t WeightRegistry::EntryCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+index_t WeightRegistry::TotalBytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return total_bytes_;
+}
+
+}  // namespace mace
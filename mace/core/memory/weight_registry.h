@@ -0,0 +1,78 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_CORE_MEMORY_WEIGHT_REGISTRY_H_
+#define MACE_CORE_MEMORY_WEIGHT_REGISTRY_H_
+
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+
+#include "mace/core/types.h"
+#include "mace/utils/macros.h"
+
+namespace mace {
+
+// Process-wide store of immutable host weight blocks. Engines that load the
+// same bytes into the same representation get the same block, so N engines
+// of one model (or models sharing a backbone) keep one copy of the weights.
+// A block is freed when the last engine holding it is destroyed.
+class WeightRegistry {
+ public:
+  typedef std::function<void(void *dst)> FillFunc;
+
+  static WeightRegistry *Get();
+
+  // Build a key from the source bytes and a description of the target
+  // representation (data type, layout, shape, quantize params...).
+  static std::string MakeKey(const void *src, index_t src_bytes,
+                             const std::string &target);
+
+  // Return the block registered under `key`. If no live block exists,
+  // allocate `bytes` bytes and call `fill` to produce the content; `fill` is
+  // called under the registry lock, so other engines never observe a
+  // half-written block. The key is only a hash of `src`, so a live block is
+  // compared with the content this caller would produce (`src` itself when
+  // the block is a verbatim copy of it) before it is shared, and a private
+  // block that is not registered is returned if they differ.
+  std::shared_ptr<void> Acquire(const std::string &key, const void *src,
+                                index_t src_bytes, index_t bytes,
+                                const FillFunc &fill);
+
+  size_t EntryCount();
+  index_t TotalBytes();
+
+ private:
+  struct Entry {
+    std::weak_ptr<void> block;
+    void *ptr;
+    index_t bytes;
+    bool verbatim;
+  };
+
+  WeightRegistry() : total_bytes_(0) {}
+  void Release(const std::string &key, void *ptr, index_t bytes);
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, Entry> entries_;
+  index_t total_bytes_;
+
+  MACE_DISABLE_COPY_AND_ASSIGN(WeightRegistry);
+};
+
+}  // namespace mace
+
+#endif  // MACE_CORE_MEMORY_WEIGHT_REGISTRY_H_
@@ -14,8 +14,12 @@
 
 #include "mace/core/net/allocate_strategy.h"
 
+#include <algorithm>
 #include <list>
+#include <unordered_set>
 
+#include "mace/core/memory/slice.h"
+#include "mace/core/proto/arg_helper.h"
 #include "mace/core/tensor.h"
 #include "mace/utils/logging.h"
 
@@ -28,9 +32,26 @@ struct TensorRef {
   Tensor *tensor;
   int refs;
   Buffer *buffer;
+  // The buffer is memory of the user, never shared with other tensors
+  bool external;
 
   explicit TensorRef(Tensor *tensor_ptr)
-      : tensor(tensor_ptr), refs(1), buffer(nullptr) {}
+      : tensor(tensor_ptr), refs(1), buffer(nullptr), external(false) {}
+};
+
+// A tensor placed as a view of its parent, from offset_bytes on.
+struct TensorAlias {
+  Tensor *tensor;
+  Tensor *parent;
+  index_t offset_bytes;
+};
+
+typedef std::unordered_map<std::string, TensorAlias> AliasMap;
+
+// An output computed into the memory of an input which dies at its op.
+struct InPlacePair {
+  Tensor *output;
+  const Tensor *input;
 };
 
 // If *monotonous return false, the compare result is meaningless
@@ -154,8 +175,183 @@ void SimulateDeleteBuffer(std::shared_ptr<TensorRef> tensor_ref,
   used_buf_list->erase(idx);
 }
 
+// The tensor at the end of the alias chain of name, which owns the memory,
+// nullptr if name is not a view.
+Tensor *AliasRoot(const AliasMap &aliases, const std::string &name,
+                  index_t *offset_bytes) {
+  Tensor *root = nullptr;
+  *offset_bytes = 0;
+  for (auto alias = aliases.find(name); alias != aliases.end();
+       alias = aliases.find(root->name())) {
+    *offset_bytes += alias->second.offset_bytes;
+    root = alias->second.parent;
+  }
+  return root;
+}
+
+// Find the tensors that can be views of others: the inputs of ops like
+// Concat inside their output, and the outputs of ops like Split inside their
+// input, so the copies of these ops vanish. A view must be the only use of
+// the memory it shares, so the candidates are the CPU buffers which are
+// consumed only by the copy op, or which are the copy op's only input use,
+// and not involved in any other buffer reuse. The tensors in memory of the
+// user may hold views but are not views themselves.
+AliasMap FindTensorAliases(
+    const OperationArray &operators,
+    const std::unordered_map<std::string,
+                             std::shared_ptr<TensorRef>> &tensor_refs,
+    const ExternalMemoryMap &external_outputs) {
+  std::unordered_set<std::string> produced;
+  std::unordered_set<std::string> reused;
+  for (auto &op : operators) {
+    for (int i = 0; i < op->OutputSize(); ++i) {
+      produced.insert(op->Output(i)->name());
+      int reuse_input_idx = op->ReuseTensorMapId(i);
+      if (reuse_input_idx >= 0) {
+        reused.insert(op->Output(i)->name());
+        reused.insert(op->Input(reuse_input_idx)->name());
+      }
+    }
+  }
+
+  AliasMap aliases;
+  auto candidate = [&](const Tensor *tensor, const Tensor *parent) -> bool {
+    return parent != nullptr && !tensor->is_weight() && !parent->is_weight() &&
+        tensor->memory_type() == MemoryType::CPU_BUFFER &&
+        parent->memory_type() == MemoryType::CPU_BUFFER &&
+        tensor->dtype() == parent->dtype() &&
+        tensor->GetCurRuntime() == parent->GetCurRuntime() &&
+        tensor->dim_size() > 0 && parent->dim_size() > 0 &&
+        produced.count(tensor->name()) > 0 &&
+        produced.count(parent->name()) > 0 &&
+        reused.count(tensor->name()) == 0 &&
+        reused.count(parent->name()) == 0 &&
+        external_outputs.count(tensor->name()) == 0;
+  };
+  auto single_use = [&](const Tensor *tensor) -> bool {
+    auto ref = tensor_refs.find(tensor->name());
+    return ref != tensor_refs.end() && ref->second->refs == 1;
+  };
+  // Each tensor is a view of one parent at most, without cycles
+  auto can_alias = [&](const Tensor *tensor, const Tensor *parent) -> bool {
+    index_t offset_bytes = 0;
+    const Tensor *root = AliasRoot(aliases, parent->name(), &offset_bytes);
+    return aliases.count(tensor->name()) == 0 && root != tensor;
+  };
+
+  for (auto &op : operators) {
+    Tensor *output = op->OutputSize() > 0 ? op->Output(0) : nullptr;
+    for (int i = 0; i < op->InputSize(); ++i) {
+      const Tensor *input = op->Input(i);
+      index_t offset = op->InputViewOffset(i);
+      if (offset < 0 || !candidate(input, output) || !single_use(input) ||
+          !can_alias(input, output)) {
+        continue;
+      }
+      aliases.emplace(input->name(), TensorAlias{
+          const_cast<Tensor *>(input), output,
+          offset * static_cast<index_t>(input->SizeOfType())});
+    }
+
+    Tensor *input = op->InputSize() > 0 ?
+        const_cast<Tensor *>(op->Input(0)) : nullptr;
+    for (int i = 0; i < op->OutputSize(); ++i) {
+      index_t offset = op->OutputViewOffset(i);
+      if (offset < 0) {
+        continue;
+      }
+      Tensor *out = op->Output(i);
+      if (!candidate(out, input) || !single_use(input) ||
+          !can_alias(out, input)) {
+        continue;
+      }
+      aliases.emplace(out->name(), TensorAlias{
+          out, input,
+          offset * static_cast<index_t>(out->SizeOfType())});
+    }
+  }
+  return aliases;
+}
+
+// Find the outputs of ops like activations and Eltwise which can be computed
+// in place. The input must be consumed by the op only, produced by an earlier
+// op and not a model output, so nothing reads it after the op. It must have
+// the output's shape and element width and not share memory by reuse or as a
+// view, then its buffer simply passes on to the output. The outputs in memory
+// of the user stay there.
+std::vector<InPlacePair> FindInPlaceTensors(
+    const OperationArray &operators,
+    const std::unordered_map<std::string,
+                             std::shared_ptr<TensorRef>> &tensor_refs,
+    const AliasMap &aliases,
+    const std::unordered_set<std::string> &model_outputs) {
+  std::unordered_set<std::string> produced;
+  std::unordered_set<std::string> reused;
+  for (auto &op : operators) {
+    for (int i = 0; i < op->OutputSize(); ++i) {
+      int reuse_input_idx = op->ReuseTensorMapId(i);
+      if (reuse_input_idx >= 0) {
+        reused.insert(op->Output(i)->name());
+        reused.insert(op->Input(reuse_input_idx)->name());
+      }
+    }
+  }
+  auto shares_memory = [&](const Tensor *tensor) -> bool {
+    if (reused.count(tensor->name()) > 0 ||
+        aliases.count(tensor->name()) > 0) {
+      return true;
+    }
+    index_t offset_bytes = 0;
+    for (auto &alias : aliases) {
+      if (AliasRoot(aliases, alias.first, &offset_bytes) == tensor) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  std::vector<InPlacePair> in_place;
+  for (auto &op : operators) {
+    std::unordered_set<std::string> taken;
+    for (int i = 0; i < op->OutputSize(); ++i) {
+      Tensor *output = op->Output(i);
+      if (output->is_weight() ||
+          output->memory_type() != MemoryType::CPU_BUFFER ||
+          output->dim_size() == 0 || shares_memory(output) ||
+          (tensor_refs.count(output->name()) > 0 &&
+              tensor_refs.at(output->name())->external)) {
+        continue;
+      }
+      for (int j = 0; j < op->InputSize(); ++j) {
+        const Tensor *input = op->Input(j);
+        auto ref = tensor_refs.find(input->name());
+        if (!op->SupportsInPlace(i, j) || input->is_weight() ||
+            ref == tensor_refs.end() || ref->second->refs != 1 ||
+            produced.count(input->name()) == 0 ||
+            model_outputs.count(input->name()) > 0 ||
+            taken.count(input->name()) > 0 ||
+            input->memory_type() != MemoryType::CPU_BUFFER ||
+            input->GetCurRuntime() != output->GetCurRuntime() ||
+            input->SizeOfType() != output->SizeOfType() ||
+            input->shape() != output->shape() || shares_memory(input)) {
+          continue;
+        }
+        taken.insert(input->name());
+        in_place.push_back(InPlacePair{output, input});
+        break;
+      }
+    }
+    for (int i = 0; i < op->OutputSize(); ++i) {
+      produced.insert(op->Output(i)->name());
+    }
+  }
+  return in_place;
+}
+
 void ReallyAllocateBuffer(
-    std::unordered_map<std::string, std::shared_ptr<TensorRef>> tensor_refs) {
+    std::unordered_map<std::string, std::shared_ptr<TensorRef>> tensor_refs,
+    const AliasMap &aliases,
+    const std::vector<InPlacePair> &in_place) {
   for (auto i = tensor_refs.begin(); i != tensor_refs.end(); ++i) {
     Buffer *buffer = i->second->buffer;
     if (buffer == nullptr) {
@@ -173,13 +369,256 @@ void ReallyAllocateBuffer(
               << ", final refs: " << i->second->refs;
     }
     Tensor *tensor = i->second->tensor;
-    runtime->SetBufferToTensor(make_unique<Buffer>(*buffer), tensor);
+    if (i->second->external) {
+      // Slices may not grow, the tensors never leave the memory of the user
+      runtime->SetBufferToTensor(
+          make_unique<Slice>(buffer->mem_type, buffer->data_type,
+                             buffer->dims, buffer->mutable_memory<void>()),
+          tensor);
+    } else {
+      runtime->SetBufferToTensor(make_unique<Buffer>(*buffer), tensor);
+    }
+  }
+
+  for (auto &alias : aliases) {
+    index_t offset_bytes = 0;
+    AliasRoot(aliases, alias.first, &offset_bytes);
+    Buffer *buffer = tensor_refs.at(alias.first)->buffer;
+    MACE_CHECK(buffer != nullptr && buffer->memory<void>() != nullptr);
+    Tensor *tensor = alias.second.tensor;
+    VLOG(3) << "ReallyAllocateBuffer, tensor " << tensor->name()
+            << " is a view at " << offset_bytes << " of " << buffer;
+    MACE_CHECK_SUCCESS(tensor->GetCurRuntime()->AllocateBufferForTensor(
+        tensor, RENT_SLICE, buffer, offset_bytes));
+  }
+
+  // The in-place outputs keep their own data types, of the same width
+  for (auto &pair : in_place) {
+    Tensor *tensor = pair.output;
+    Buffer *buffer = tensor_refs.at(tensor->name())->buffer;
+    MACE_CHECK(buffer != nullptr && buffer->memory<void>() != nullptr);
+    VLOG(3) << "ReallyAllocateBuffer, tensor " << tensor->name()
+            << " is computed in place of " << pair.input->name();
+    DataType dtype = tensor->dtype();
+    tensor->GetCurRuntime()->SetBufferToTensor(make_unique<Buffer>(*buffer),
+                                               tensor);
+    tensor->SetDtype(dtype);
+  }
+}
+
+// Record which block each output is placed in. The blocks are numbered by
+// their first use, the views keep their offsets in the tensors owning them.
+void RecordMemoryPlan(
+    const OperationArray &operators,
+    const std::unordered_map<std::string,
+                             std::shared_ptr<TensorRef>> &tensor_refs,
+    const AliasMap &aliases, MemoryPlan *plan) {
+  plan->Clear();
+  MemoryPlan record;
+  std::unordered_map<const Buffer *, int> block_ids;
+  for (auto &op : operators) {
+    std::vector<int> ids;
+    std::vector<index_t> offsets;
+    for (int i = 0; i < op->OutputSize(); ++i) {
+      const Tensor *tensor = op->Output(i);
+      auto ref = tensor_refs.find(tensor->name());
+      if (tensor->memory_type() != MemoryType::CPU_BUFFER ||
+          ref == tensor_refs.end() || ref->second->external ||
+          ref->second->buffer == nullptr) {
+        VLOG(2) << "The placement of " << tensor->name()
+                << " can not be recorded";
+        return;
+      }
+      const Buffer *buffer = ref->second->buffer;
+      auto id = block_ids.find(buffer);
+      if (id == block_ids.end()) {
+        id = block_ids.emplace(
+            buffer, static_cast<int>(record.blocks.size())).first;
+        record.blocks.emplace_back(buffer->mem_type, buffer->data_type,
+                                   buffer->dims);
+      }
+      index_t offset_bytes = -1;
+      if (aliases.count(tensor->name()) > 0) {
+        AliasRoot(aliases, tensor->name(), &offset_bytes);
+      }
+      ids.push_back(id->second);
+      offsets.push_back(offset_bytes);
+    }
+    record.block_ids.emplace_back(std::move(ids));
+    record.view_offsets.emplace_back(std::move(offsets));
+  }
+  *plan = std::move(record);
+}
+
+const char kMemBlocksArgName[] = "mem_blocks";
+const char kMemViewOffsetsArgName[] = "mem_view_offsets";
+
+template <typename Def>
+void SetRepeatedIntArg(Def *def, const std::string &arg_name,
+                       const std::vector<int64_t> &values) {
+  Argument *arg = nullptr;
+  for (int i = 0; i < def->arg_size(); ++i) {
+    if (def->arg(i).name() == arg_name) {
+      arg = def->mutable_arg(i);
+      break;
+    }
+  }
+  if (arg == nullptr) {
+    arg = def->add_arg();
+    arg->set_name(arg_name);
+  }
+  arg->clear_ints();
+  for (auto value : values) {
+    arg->add_ints(value);
   }
 }
 }  // namespace
 
+void MemoryPlan::Clear() {
+  blocks.clear();
+  block_ids.clear();
+  view_offsets.clear();
+}
+
+bool ApplyTensorMemoryPlan(const OperationArray &operators,
+                           const MemoryPlan &plan) {
+  if (plan.empty() || plan.block_ids.size() != operators.size() ||
+      plan.view_offsets.size() != operators.size()) {
+    return false;
+  }
+  // Check the whole plan first, so that nothing is allocated for a stale one
+  const int block_count = static_cast<int>(plan.blocks.size());
+  std::vector<Runtime *> runtimes(plan.blocks.size(), nullptr);
+  for (size_t k = 0; k < operators.size(); ++k) {
+    auto &op = operators[k];
+    const auto &ids = plan.block_ids[k];
+    const auto &offsets = plan.view_offsets[k];
+    if (ids.size() != static_cast<size_t>(op->OutputSize()) ||
+        offsets.size() != ids.size()) {
+      return false;
+    }
+    for (int i = 0; i < op->OutputSize(); ++i) {
+      const Tensor *tensor = op->Output(i);
+      const int id = ids[i];
+      if (id < 0 || id >= block_count ||
+          tensor->memory_type() != MemoryType::CPU_BUFFER ||
+          plan.blocks[id].mem_type != MemoryType::CPU_BUFFER ||
+          std::max<index_t>(offsets[i], 0) + tensor->raw_size() >
+              plan.blocks[id].bytes()) {
+        VLOG(1) << "The memory plan does not fit " << tensor->name();
+        return false;
+      }
+      Runtime *runtime = tensor->GetCurRuntime();
+      if (runtimes[id] != nullptr && runtimes[id] != runtime) {
+        return false;
+      }
+      runtimes[id] = runtime;
+    }
+  }
+  for (auto runtime : runtimes) {
+    if (runtime == nullptr) {
+      return false;
+    }
+  }
+
+  std::vector<std::unique_ptr<Buffer>> buffers;
+  for (int id = 0; id < block_count; ++id) {
+    buffers.emplace_back(
+        runtimes[id]->ObtainBuffer(plan.blocks[id], RENT_SHARE));
+  }
+  for (size_t k = 0; k < operators.size(); ++k) {
+    auto &op = operators[k];
+    for (int i = 0; i < op->OutputSize(); ++i) {
+      Tensor *tensor = op->Output(i);
+      Buffer *buffer = buffers[plan.block_ids[k][i]].get();
+      const index_t offset_bytes = plan.view_offsets[k][i];
+      Runtime *runtime = tensor->GetCurRuntime();
+      if (offset_bytes >= 0) {
+        MACE_CHECK_SUCCESS(runtime->AllocateBufferForTensor(
+            tensor, RENT_SLICE, buffer, offset_bytes));
+      } else {
+        // The tensors sharing a block by reuse or in place keep their own
+        // data types, of the same width
+        DataType dtype = tensor->dtype();
+        runtime->SetBufferToTensor(make_unique<Buffer>(*buffer), tensor);
+        tensor->SetDtype(dtype);
+      }
+      auto data_format = ProtoArgHelper::GetOptionalArg<OperatorDef, int>(
+          op->debug_def(), "data_format", static_cast<int>(DataFormat::NONE));
+      tensor->set_data_format(static_cast<DataFormat>(data_format));
+    }
+  }
+  return true;
+}
+
+void SaveMemoryPlan(const MemoryPlan &plan, NetDef *net_def) {
+  MACE_CHECK(plan.empty() ||
+      plan.block_ids.size() == static_cast<size_t>(net_def->op_size()));
+  std::vector<int64_t> blocks;
+  for (auto &block : plan.blocks) {
+    blocks.push_back(static_cast<int64_t>(block.mem_type));
+    blocks.push_back(static_cast<int64_t>(block.data_type));
+    blocks.push_back(static_cast<int64_t>(block.dims.size()));
+    blocks.insert(blocks.end(), block.dims.begin(), block.dims.end());
+  }
+  SetRepeatedIntArg(net_def, kMemBlocksArgName, blocks);
+  for (int k = 0; k < net_def->op_size(); ++k) {
+    OperatorDef *op_def = net_def->mutable_op(k);
+    op_def->clear_mem_id();
+    if (plan.empty()) {
+      continue;
+    }
+    for (auto id : plan.block_ids[k]) {
+      op_def->add_mem_id(id);
+    }
+    SetRepeatedIntArg(op_def, kMemViewOffsetsArgName,
+                      std::vector<int64_t>(plan.view_offsets[k].begin(),
+                                           plan.view_offsets[k].end()));
+  }
+}
+
+bool LoadMemoryPlan(const NetDef &net_def, MemoryPlan *plan) {
+  plan->Clear();
+  auto blocks = ProtoArgHelper::GetRepeatedArgs<NetDef, int64_t>(
+      net_def, kMemBlocksArgName);
+  MemoryPlan load;
+  for (size_t i = 0; i < blocks.size();) {
+    // mem_type, data_type, rank and the dims of each block
+    if (i + 3 > blocks.size() || blocks[i + 2] < 0 ||
+        i + 3 + static_cast<size_t>(blocks[i + 2]) > blocks.size()) {
+      return false;
+    }
+    const size_t rank = static_cast<size_t>(blocks[i + 2]);
+    load.blocks.emplace_back(
+        static_cast<MemoryType>(blocks[i]),
+        static_cast<DataType>(blocks[i + 1]),
+        std::vector<index_t>(blocks.begin() + i + 3,
+                             blocks.begin() + i + 3 + rank));
+    i += 3 + rank;
+  }
+  if (load.empty()) {
+    return false;
+  }
+  for (auto &op_def : net_def.op()) {
+    auto offsets = ProtoArgHelper::GetRepeatedArgs<OperatorDef, int64_t>(
+        op_def, kMemViewOffsetsArgName);
+    if (offsets.size() != static_cast<size_t>(op_def.mem_id_size())) {
+      return false;
+    }
+    load.block_ids.emplace_back(op_def.mem_id().begin(),
+                                op_def.mem_id().end());
+    load.view_offsets.emplace_back(offsets.begin(), offsets.end());
+  }
+  *plan = std::move(load);
+  return true;
+}
+
 template<>
-MaceStatus AllocateTensorMemory<SERIAL_OPT>(const OperationArray &operators) {
+MaceStatus AllocateTensorMemory<SERIAL_OPT>(
+    const OperationArray &operators,
+    const std::unordered_set<std::string> &model_outputs,
+    const ExternalMemoryMap &external_outputs,
+    MemoryPlan *plan) {
   std::unordered_map<std::string, std::shared_ptr<TensorRef>> tensor_refs;
   // Collect the refs of input tensor
   for (auto &op : operators) {
@@ -199,6 +638,65 @@ MaceStatus AllocateTensorMemory<SERIAL_OPT>(const OperationArray &operators) {
     }
   }
 
+  // The model outputs bound to memory of the user take it from the start
+  BufferList external_buf_list;
+  for (auto &op : operators) {
+    for (int i = 0; i < op->OutputSize(); ++i) {
+      Tensor *tensor = op->Output(i);
+      auto external = external_outputs.find(tensor->name());
+      if (external == external_outputs.end() ||
+          tensor->memory_type() != MemoryType::CPU_BUFFER) {
+        continue;
+      }
+      if (tensor_refs.count(tensor->name()) == 0) {
+        tensor_refs.emplace(tensor->name(),
+                            std::make_shared<TensorRef>(tensor));
+      }
+      std::shared_ptr<TensorRef> tensor_ref = tensor_refs.at(tensor->name());
+      const index_t size_of_type = static_cast<index_t>(tensor->SizeOfType());
+      external_buf_list.emplace_back(make_unique<Buffer>(
+          MemoryType::CPU_BUFFER, tensor->dtype(),
+          std::vector<index_t>{external->second.bytes / size_of_type},
+          external->second.data));
+      tensor_ref->buffer = external_buf_list.back().get();
+      tensor_ref->external = true;
+    }
+  }
+
+  // Merge the refs of the views into the tensors owning their memory. The
+  // unconsumed tensors are model outputs, which are never released.
+  AliasMap aliases = FindTensorAliases(operators, tensor_refs,
+                                       external_outputs);
+  for (auto &alias : aliases) {
+    index_t offset_bytes = 0;
+    Tensor *root = AliasRoot(aliases, alias.first, &offset_bytes);
+    if (tensor_refs.count(root->name()) == 0) {
+      tensor_refs.emplace(root->name(), std::make_shared<TensorRef>(root));
+    }
+    std::shared_ptr<TensorRef> root_ref = tensor_refs.at(root->name());
+    if (tensor_refs.count(alias.first) == 0) {
+      root_ref->refs++;
+    } else {
+      root_ref->refs += tensor_refs.at(alias.first)->refs;
+    }
+    tensor_refs[alias.first] = root_ref;
+  }
+
+  // Pass the buffers of the inputs dying at in-place ops on to the outputs,
+  // the chains of in-place ops share one buffer.
+  std::vector<InPlacePair> in_place =
+      FindInPlaceTensors(operators, tensor_refs, aliases, model_outputs);
+  for (auto &pair : in_place) {
+    auto output_name = pair.output->name();
+    std::shared_ptr<TensorRef> input_ref = tensor_refs.at(pair.input->name());
+    if (tensor_refs.count(output_name) == 0) {
+      input_ref->refs++;
+    } else {
+      input_ref->refs += tensor_refs.at(output_name)->refs;
+    }
+    tensor_refs[output_name] = input_ref;
+  }
+
   // Merge the refs that reuse the buffer
   for (auto &op : operators) {
     size_t output_size = static_cast<size_t>(op->OutputSize());
@@ -215,6 +713,10 @@ MaceStatus AllocateTensorMemory<SERIAL_OPT>(const OperationArray &operators) {
           VLOG(2) << "tensor " << out_tensor_name << " is model's output";
           continue;
         }
+        if (tensor_refs.at(out_tensor_name)->external) {
+          VLOG(2) << "tensor " << out_tensor_name << " is in external memory";
+          continue;
+        }
 
         // Merge the refs
         auto reuse_in_tensor_name = reuse_in_tensor->name();
@@ -243,9 +745,12 @@ MaceStatus AllocateTensorMemory<SERIAL_OPT>(const OperationArray &operators) {
       }
 
       std::shared_ptr<TensorRef> tensor_ref = tensor_refs.at(tensor_name);
-      // The reused tensor does not need to allocate buffer
+      // The reused tensor does not need to allocate buffer, the views
+      // allocate for the tensor owning their memory if they come first
       auto essential_tensor_name = tensor_ref->tensor->name();
-      if (tensor_name == essential_tensor_name) {
+      if (tensor_ref->buffer == nullptr &&
+          (tensor_name == essential_tensor_name ||
+           aliases.count(tensor_name) > 0)) {
         SimulateAllocateBuffer(tensor_refs.at(tensor_name),
                                &used_buf_list, &free_buf_list);
       } else {
@@ -273,14 +778,17 @@ MaceStatus AllocateTensorMemory<SERIAL_OPT>(const OperationArray &operators) {
         VLOG(3) << "find a model input: " << tensor_name;
         continue;
       }
-      if (ref_num == 1) {
+      if (ref_num == 1 && !tensor_refs[tensor_name]->external) {
         SimulateDeleteBuffer(tensor_refs[tensor_name],
                              &used_buf_list, &free_buf_list);
       }
     }
   }
 
-  ReallyAllocateBuffer(tensor_refs);
+  ReallyAllocateBuffer(tensor_refs, aliases, in_place);
+  if (plan != nullptr) {
+    RecordMemoryPlan(operators, tensor_refs, aliases, plan);
+  }
 
   return MaceStatus::MACE_SUCCESS;
 }
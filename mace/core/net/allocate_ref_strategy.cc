@@ -47,7 +47,16 @@ struct MemBlock {
 
 
 template <>
-MaceStatus AllocateTensorMemory<SERIAL_REF>(const OperationArray &operators) {
+MaceStatus AllocateTensorMemory<SERIAL_REF>(
+    const OperationArray &operators,
+    const std::unordered_set<std::string> &model_outputs,
+    const ExternalMemoryMap &external_outputs,
+    MemoryPlan *plan) {
+  MACE_UNUSED(model_outputs);
+  MACE_UNUSED(external_outputs);
+  if (plan != nullptr) {
+    plan->Clear();
+  }
   std::unordered_map<std::string, std::shared_ptr<MemBlock>> tensor_refs;
   // Collect the refs of input tensor
   for (auto &op : operators) {
@@ -16,8 +16,12 @@
 #define MACE_CORE_NET_ALLOCATE_STRATEGY_H_
 
 #include <memory>
+#include <string>
+#include <unordered_set>
 #include <vector>
 
+#include "mace/core/memory/allocator.h"
+#include "mace/core/net/base_net.h"
 #include "mace/core/ops/operator.h"
 
 namespace mace {
@@ -28,8 +32,41 @@ enum AllocateStrategy {
 
 typedef std::vector<std::unique_ptr<Operation>> OperationArray;
 
+// Where the outputs of the operators are placed: the memory blocks, and for
+// each output of each operator the block it is in, -1 if none, and its byte
+// offset if it is a view inside the block, -1 otherwise.
+struct MemoryPlan {
+  std::vector<MemInfo> blocks;
+  std::vector<std::vector<int>> block_ids;
+  std::vector<std::vector<index_t>> view_offsets;
+
+  bool empty() const { return blocks.empty(); }
+  void Clear();
+};
+
+// The model outputs must keep their contents after the ops consuming them,
+// the ones in external_outputs are placed in the given memory. SERIAL_OPT
+// records the placement to `plan` if it is not null, the plan is left empty
+// if an output is in memory of the user or not in a CPU buffer.
 template <AllocateStrategy S>
-MaceStatus AllocateTensorMemory(const OperationArray &operators_);
+MaceStatus AllocateTensorMemory(
+    const OperationArray &operators_,
+    const std::unordered_set<std::string> &model_outputs =
+        std::unordered_set<std::string>(),
+    const ExternalMemoryMap &external_outputs = ExternalMemoryMap(),
+    MemoryPlan *plan = nullptr);
+
+// Place the outputs as a plan made by AllocateTensorMemory for the same
+// operators says, without planning again. Returns false, and allocates
+// nothing, if the plan does not fit the operators.
+bool ApplyTensorMemoryPlan(const OperationArray &operators,
+                           const MemoryPlan &plan);
+
+// The plan is kept in `net_def`, whose ops are the ones of the operators:
+// the blocks in the "mem_blocks" argument of the net, the block ids in
+// mem_id and the view offsets in the "mem_view_offsets" argument of the ops.
+void SaveMemoryPlan(const MemoryPlan &plan, NetDef *net_def);
+bool LoadMemoryPlan(const NetDef &net_def, MemoryPlan *plan);
 
 }  // namespace mace
 
@@ -15,6 +15,11 @@
 #ifndef MACE_CORE_NET_BASE_NET_H_
 #define MACE_CORE_NET_BASE_NET_H_
 
+#include <string>
+#include <unordered_map>
+
+#include "mace/core/net/net_observer.h"
+#include "mace/core/types.h"
 #include "mace/public/mace.h"
 #include "mace/utils/macros.h"
 
@@ -34,6 +39,15 @@ enum NetSubType {
 
 class RunMetadata;
 
+// Memory of the user which a model output is written into,
+// see MaceEngine::BindBuffers.
+struct ExternalMemory {
+  void *data;
+  index_t bytes;
+};
+
+typedef std::unordered_map<std::string, ExternalMemory> ExternalMemoryMap;
+
 class BaseNet {
  public:
   BaseNet() noexcept = default;
@@ -46,7 +60,24 @@ class BaseNet {
 
   virtual MaceStatus AllocateIntermediateBuffer() = 0;
 
+  // Fake warmup that goes on after the operators failing, returns how many
+  // failed. Used to see the OpenCL programs the operators build.
+  virtual int FakeWarmupEachOperator() = 0;
+
+  // Feed the output tensors of the operators to `observer` on each run,
+  // nullptr to stop. The net does not take the ownership.
+  void SetObserver(NetObserver *observer) { observer_ = observer; }
+
+  // Place the model outputs in `outputs` instead of the shared memory, from
+  // the next allocation of the intermediate buffers on.
+  void SetExternalOutputs(const ExternalMemoryMap &outputs) {
+    external_outputs_ = outputs;
+  }
+
  protected:
+  NetObserver *observer_ = nullptr;
+  ExternalMemoryMap external_outputs_;
+
   MACE_DISABLE_COPY_AND_ASSIGN(BaseNet);
 };
 
@@ -0,0 +1,292 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/core/net/calibration_observer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <sstream>
+
+#include "mace/core/tensor.h"
+#include "mace/port/env.h"
+#include "mace/port/file_system.h"
+#include "mace/utils/logging.h"
+#include "mace/utils/math.h"
+#include "mace/utils/thread_pool.h"
+
+namespace mace {
+
+namespace {
+// Even halves of it make the histogram of the absolute values
+const int kHistogramBins = 4096;
+const int kAbsHistogramBins = kHistogramBins / 2;
+const index_t kMinPartSize = 8192;
+const index_t kMaxParts = 16;
+const float kMinHistogramRange = 1e-6f;
+const double kKLEpsilon = 1e-10;
+
+index_t PartCount(const index_t size) {
+  return std::min(RoundUpDiv(size, kMinPartSize), kMaxParts);
+}
+}  // namespace
+
+CalibrationObserver::CalibrationObserver(CalibrationMethod method,
+                                         float percentile,
+                                         utils::ThreadPool *thread_pool)
+    : method_(method), percentile_(percentile), thread_pool_(thread_pool) {
+  MACE_CHECK(method_ != CalibrationMethod::CALIBRATION_NONE);
+  part_mins_.resize(kMaxParts);
+  part_maxs_.resize(kMaxParts);
+  if (method_ != CalibrationMethod::CALIBRATION_MIN_MAX) {
+    part_histograms_.resize(kMaxParts * kHistogramBins);
+  }
+}
+
+MaceStatus CalibrationObserver::Observe(const std::string &tensor_name,
+                                        const Tensor *tensor) {
+  if (tensor->dtype() != DataType::DT_FLOAT || tensor->size() == 0) {
+    return MaceStatus::MACE_SUCCESS;
+  }
+  Tensor::MappingGuard guard(tensor);
+  const float *data = tensor->data<float>();
+  const index_t size = tensor->size();
+
+  float min = 0;
+  float max = 0;
+  ComputeMinMax(data, size, &min, &max);
+
+  auto iter = tensor_stats_.find(tensor_name);
+  if (iter == tensor_stats_.end()) {
+    TensorStats stats;
+    stats.min = min;
+    stats.max = max;
+    stats.histogram_range = 0;
+    iter = tensor_stats_.emplace(tensor_name, std::move(stats)).first;
+    tensor_names_.push_back(tensor_name);
+  } else {
+    iter->second.min = std::min(iter->second.min, min);
+    iter->second.max = std::max(iter->second.max, max);
+  }
+
+  if (method_ != CalibrationMethod::CALIBRATION_MIN_MAX) {
+    AccumulateHistogram(data, size, std::max(std::abs(min), std::abs(max)),
+                        &iter->second);
+  }
+  return MaceStatus::MACE_SUCCESS;
+}
+
+void CalibrationObserver::ComputeMinMax(const float *data,
+                                        const index_t size,
+                                        float *min, float *max) {
+  const index_t part_count = PartCount(size);
+  const index_t part_size = RoundUpDiv(size, part_count);
+  float *part_mins = part_mins_.data();
+  float *part_maxs = part_maxs_.data();
+  thread_pool_->Compute1D([=](index_t start, index_t end, index_t step) {
+    for (index_t p = start; p < end; p += step) {
+      const index_t begin = p * part_size;
+      const index_t stop = std::min(begin + part_size, size);
+      float part_min = std::numeric_limits<float>::max();
+      float part_max = std::numeric_limits<float>::lowest();
+      for (index_t i = begin; i < stop; ++i) {
+        part_min = std::min(part_min, data[i]);
+        part_max = std::max(part_max, data[i]);
+      }
+      part_mins[p] = part_min;
+      part_maxs[p] = part_max;
+    }
+  }, 0, part_count, 1, 1);
+
+  *min = *std::min_element(part_mins, part_mins + part_count);
+  *max = *std::max_element(part_maxs, part_maxs + part_count);
+}
+
+void CalibrationObserver::AccumulateHistogram(const float *data,
+                                              const index_t size,
+                                              const float abs_max,
+                                              TensorStats *stats) {
+  std::vector<int64_t> &histogram = stats->histogram;
+  if (histogram.empty()) {
+    histogram.resize(kHistogramBins, 0);
+    stats->histogram_range = std::max(abs_max, kMinHistogramRange);
+  }
+  while (abs_max > stats->histogram_range) {
+    // Bins 2k and 2k + 1 cover the same range as bin k + kHistogramBins / 4
+    // of the doubled range.
+    std::vector<int64_t> merged(kHistogramBins, 0);
+    for (int b = 0; b < kHistogramBins; ++b) {
+      merged[b / 2 + kHistogramBins / 4] += histogram[b];
+    }
+    histogram.swap(merged);
+    stats->histogram_range *= 2;
+  }
+
+  const float range = stats->histogram_range;
+  const float scale = kHistogramBins / (2 * range);
+  const index_t part_count = PartCount(size);
+  const index_t part_size = RoundUpDiv(size, part_count);
+  uint32_t *part_histograms = part_histograms_.data();
+  thread_pool_->Compute1D([=](index_t start, index_t end, index_t step) {
+    for (index_t p = start; p < end; p += step) {
+      uint32_t *part_histogram = part_histograms + p * kHistogramBins;
+      std::fill_n(part_histogram, kHistogramBins, 0);
+      const index_t begin = p * part_size;
+      const index_t stop = std::min(begin + part_size, size);
+      for (index_t i = begin; i < stop; ++i) {
+        // NaN goes to the first bin
+        const float pos = (data[i] + range) * scale;
+        const int bin = pos > 0 ? (pos < kHistogramBins ?
+            static_cast<int>(pos) : kHistogramBins - 1) : 0;
+        ++part_histogram[bin];
+      }
+    }
+  }, 0, part_count, 1, 1);
+
+  for (index_t p = 0; p < part_count; ++p) {
+    const uint32_t *part_histogram = part_histograms + p * kHistogramBins;
+    for (int b = 0; b < kHistogramBins; ++b) {
+      histogram[b] += part_histogram[b];
+    }
+  }
+}
+
+CalibrationObserver::Range CalibrationObserver::PercentileRange(
+    const TensorStats &stats) const {
+  const std::vector<int64_t> &histogram = stats.histogram;
+  int64_t total = 0;
+  for (int b = 0; b < kHistogramBins; ++b) {
+    total += histogram[b];
+  }
+  const double tail = total * (100.0 - percentile_) / 100.0;
+  const float bin_width = 2 * stats.histogram_range / kHistogramBins;
+
+  int lower_bin = 0;
+  int64_t count = 0;
+  for (; lower_bin < kHistogramBins - 1; ++lower_bin) {
+    count += histogram[lower_bin];
+    if (count > tail) break;
+  }
+  int upper_bin = kHistogramBins - 1;
+  count = 0;
+  for (; upper_bin > 0; --upper_bin) {
+    count += histogram[upper_bin];
+    if (count > tail) break;
+  }
+
+  const float lower = -stats.histogram_range + lower_bin * bin_width;
+  const float upper = -stats.histogram_range + (upper_bin + 1) * bin_width;
+  return Range(std::max(stats.min, std::min(lower, stats.max)),
+               std::min(stats.max, std::max(upper, stats.min)));
+}
+
+// Search the clipping threshold of the absolute values as TensorRT's entropy
+// calibration: the histogram clipped at the threshold (with the outliers
+// added to the last bin) is compared with its 8-bit quantized version by KL
+// divergence, the threshold with the least divergence is chosen.
+CalibrationObserver::Range CalibrationObserver::KLDivergenceRange(
+    const TensorStats &stats) {
+  std::vector<int64_t> abs_histogram(kAbsHistogramBins);
+  for (int b = 0; b < kAbsHistogramBins; ++b) {
+    abs_histogram[b] = stats.histogram[kAbsHistogramBins + b] +
+        stats.histogram[kAbsHistogramBins - 1 - b];
+  }
+  // Prefix sums of the counts and of the non-empty bins
+  std::vector<int64_t> count_sums(kAbsHistogramBins + 1, 0);
+  std::vector<int> nonzero_sums(kAbsHistogramBins + 1, 0);
+  for (int b = 0; b < kAbsHistogramBins; ++b) {
+    count_sums[b + 1] = count_sums[b] + abs_histogram[b];
+    nonzero_sums[b + 1] = nonzero_sums[b] + (abs_histogram[b] != 0);
+  }
+  const int64_t total = count_sums[kAbsHistogramBins];
+
+  // Non-negative tensors use all the 8-bit levels for one side
+  const int quantized_bins = stats.min >= 0 ? 256 : 128;
+  std::vector<double> divergences(kAbsHistogramBins + 1,
+                                  std::numeric_limits<double>::max());
+  const int64_t *histogram = abs_histogram.data();
+  const int64_t *counts = count_sums.data();
+  const int *nonzeros = nonzero_sums.data();
+  double *divergence = divergences.data();
+  thread_pool_->Compute1D([=](index_t start, index_t end, index_t step) {
+    for (index_t bins = start; bins < end; bins += step) {
+      const int64_t outliers = total - counts[bins];
+      const double clipped_total = static_cast<double>(counts[bins]);
+      if (clipped_total == 0) continue;
+      double kl = 0;
+      for (int q = 0; q < quantized_bins; ++q) {
+        const index_t begin = q * bins / quantized_bins;
+        const index_t stop = (q + 1) * bins / quantized_bins;
+        const int nonzero = nonzeros[stop] - nonzeros[begin];
+        const double expanded = nonzero == 0 ? 0 :
+            (counts[stop] - counts[begin]) / static_cast<double>(nonzero);
+        for (index_t b = begin; b < stop; ++b) {
+          const int64_t p_count =
+              histogram[b] + (b == bins - 1 ? outliers : 0);
+          if (p_count == 0) continue;
+          const double p = p_count / static_cast<double>(total);
+          const double q_value = histogram[b] == 0 ? kKLEpsilon :
+              std::max(expanded / clipped_total, kKLEpsilon);
+          kl += p * std::log(p / q_value);
+        }
+      }
+      divergence[bins] = kl;
+    }
+  }, quantized_bins, kAbsHistogramBins + 1, 1);
+
+  const int best_bins = static_cast<int>(
+      std::min_element(divergences.begin(), divergences.end()) -
+      divergences.begin());
+  const float threshold =
+      best_bins * stats.histogram_range / kAbsHistogramBins;
+  return Range(std::max(stats.min, std::min(-threshold, stats.max)),
+               std::min(stats.max, std::max(threshold, stats.min)));
+}
+
+void CalibrationObserver::GetRanges(
+    std::vector<std::pair<std::string, Range>> *ranges) {
+  ranges->clear();
+  for (const auto &tensor_name : tensor_names_) {
+    const TensorStats &stats = tensor_stats_.at(tensor_name);
+    Range range(stats.min, stats.max);
+    if (method_ == CalibrationMethod::CALIBRATION_PERCENTILE) {
+      range = PercentileRange(stats);
+    } else if (method_ == CalibrationMethod::CALIBRATION_KL_DIVERGENCE) {
+      range = KLDivergenceRange(stats);
+    }
+    ranges->emplace_back(tensor_name, range);
+  }
+}
+
+MaceStatus CalibrationObserver::SaveRanges(const std::string &range_file) {
+  std::vector<std::pair<std::string, Range>> ranges;
+  GetRanges(&ranges);
+  std::ostringstream content;
+  content.precision(std::numeric_limits<float>::max_digits10);
+  for (const auto &range : ranges) {
+    content << range.first << "@@" << range.second.first << ","
+            << range.second.second << "\n";
+  }
+
+  const std::string data = content.str();
+  std::unique_ptr<port::WritableFile> file;
+  MACE_RETURN_IF_ERROR(GetFileSystem()->NewWritableFile(
+      range_file.c_str(), &file));
+  MACE_RETURN_IF_ERROR(file->Append(data.data(), data.size()));
+  MACE_RETURN_IF_ERROR(file->Flush());
+  return file->Close();
+}
+
+}  // namespace mace
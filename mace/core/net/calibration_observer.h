@@ -0,0 +1,89 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_CORE_NET_CALIBRATION_OBSERVER_H_
+#define MACE_CORE_NET_CALIBRATION_OBSERVER_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mace/core/net/net_observer.h"
+#include "mace/core/types.h"
+#include "mace/public/mace.h"
+#include "mace/utils/macros.h"
+
+namespace mace {
+
+namespace utils {
+class ThreadPool;
+}  // namespace utils
+
+// Accumulates the statistics of the float tensors over the runs of a net to
+// choose their quantization ranges, see CalibrationMethod.
+class CalibrationObserver : public NetObserver {
+ public:
+  typedef std::pair<float, float> Range;
+
+  CalibrationObserver(CalibrationMethod method,
+                      float percentile,
+                      utils::ThreadPool *thread_pool);
+  ~CalibrationObserver() = default;
+
+  MaceStatus Observe(const std::string &tensor_name,
+                     const Tensor *tensor) override;
+
+  // The ranges in the order the tensors are first observed
+  void GetRanges(std::vector<std::pair<std::string, Range>> *ranges);
+
+  // Lines of `tensor_name@@min,max`, which is read by the converter as
+  // `quantize_range_file`
+  MaceStatus SaveRanges(const std::string &range_file);
+
+ private:
+  struct TensorStats {
+    float min;
+    float max;
+    // Counts of the values in kHistogramBins equal bins of
+    // [-histogram_range, histogram_range], the range doubles by merging
+    // neighbouring bins when a larger value comes.
+    float histogram_range;
+    std::vector<int64_t> histogram;
+  };
+
+  void ComputeMinMax(const float *data, const index_t size,
+                     float *min, float *max);
+  void AccumulateHistogram(const float *data, const index_t size,
+                           const float abs_max, TensorStats *stats);
+  Range PercentileRange(const TensorStats &stats) const;
+  Range KLDivergenceRange(const TensorStats &stats);
+
+  const CalibrationMethod method_;
+  const float percentile_;
+  utils::ThreadPool *thread_pool_;
+  std::vector<std::string> tensor_names_;
+  std::unordered_map<std::string, TensorStats> tensor_stats_;
+  // Partial results of the parallel parts
+  std::vector<float> part_mins_;
+  std::vector<float> part_maxs_;
+  std::vector<uint32_t> part_histograms_;
+
+  MACE_DISABLE_COPY_AND_ASSIGN(CalibrationObserver);
+};
+
+}  // namespace mace
+
+#endif  // MACE_CORE_NET_CALIBRATION_OBSERVER_H_
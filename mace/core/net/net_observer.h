@@ -0,0 +1,40 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_CORE_NET_NET_OBSERVER_H_
+#define MACE_CORE_NET_NET_OBSERVER_H_
+
+#include <string>
+
+#include "mace/public/mace.h"
+
+namespace mace {
+
+class Tensor;
+
+// Receives the output tensors of the operators while a net runs
+class NetObserver {
+ public:
+  NetObserver() = default;
+  virtual ~NetObserver() = default;
+
+  // Called after the operator producing `tensor` runs, the tensor is only
+  // valid until the call returns.
+  virtual MaceStatus Observe(const std::string &tensor_name,
+                             const Tensor *tensor) = 0;
+};
+
+}  // namespace mace
+
+#endif  // MACE_CORE_NET_NET_OBSERVER_H_
@@ -15,7 +15,6 @@
 #include "mace/core/net/serial_net.h"
 
 #include <algorithm>
-#include <limits>
 #include <set>
 #include <unordered_set>
 #include <utility>
@@ -27,7 +26,6 @@
 #include "mace/core/registry/ops_registry.h"
 #include "mace/public/mace.h"
 #include "mace/port/env.h"
-#include "mace/utils/conf_util.h"
 #include "mace/utils/logging.h"
 #include "mace/utils/macros.h"
 #include "mace/utils/math.h"
@@ -42,15 +40,28 @@ SerialNet::SerialNet(const OpRegistry *op_registry,
                      Workspace *ws,
                      Runtime *target_runtime,
                      Runtime *cpu_runtime)
+    : SerialNet(op_registry, std::make_shared<NetDef>(*net_def), ws,
+                target_runtime, cpu_runtime) {}
+
+SerialNet::SerialNet(const OpRegistry *op_registry,
+                     std::shared_ptr<NetDef> net_def,
+                     Workspace *ws,
+                     Runtime *target_runtime,
+                     Runtime *cpu_runtime)
     : BaseNet(),
       ws_(ws),
       target_runtime_(target_runtime),
-      cpu_runtime_(cpu_runtime) {
+      cpu_runtime_(cpu_runtime),
+      net_def_(net_def),
+      command_replay_(false) {
   MACE_LATENCY_LOGGER(1, "Constructing SerialNet");
 
+  for (auto &output_info : net_def->output_info()) {
+    model_outputs_.insert(output_info.name());
+  }
   OpConstructContext construct_context(ws_);
   for (int idx = 0; idx < net_def->op_size(); ++idx) {
-    std::shared_ptr<OperatorDef> op_def(new OperatorDef(net_def->op(idx)));
+    std::shared_ptr<OperatorDef> op_def(net_def, net_def->mutable_op(idx));
     // Create operation
     auto op_runtime_type = static_cast<RuntimeType>(op_def->device_type());
     if (op_runtime_type == target_runtime_->GetRuntimeType()) {
@@ -71,6 +82,9 @@ SerialNet::SerialNet(const OpRegistry *op_registry,
 
 SerialNet::~SerialNet() {
   VLOG(1) << "Destroy SerialNet";
+  if (command_replay_) {
+    target_runtime_->ReleaseCommandRecord(this);
+  }
 }
 
 MaceStatus SerialNet::Init() {
@@ -85,13 +99,83 @@ MaceStatus SerialNet::Init() {
     MACE_RETURN_IF_ERROR(op->Init(&init_context));
   }
 
-  MACE_RETURN_IF_ERROR(AllocateTensorMemory<SERIAL_OPT>(operators_));
+  // A graph saved with the memory plan of an earlier init is placed as the
+  // plan says, otherwise the plan made now is kept in the graph.
+  MemoryPlan plan;
+  if (external_outputs_.empty() && LoadMemoryPlan(*net_def_, &plan) &&
+      ApplyTensorMemoryPlan(operators_, plan)) {
+    VLOG(1) << "Tensors are placed by the saved memory plan";
+  } else {
+    MACE_RETURN_IF_ERROR(AllocateTensorMemory<SERIAL_OPT>(
+        operators_, model_outputs_, external_outputs_, &plan));
+    SaveMemoryPlan(plan, net_def_.get());
+  }
+
+  // The recorded commands can not include the host work of CPU ops.
+  command_replay_ = target_runtime_->CommandReplayEnabled();
+  for (auto &op : operators_) {
+    if (op->runtime_type() != target_runtime_->GetRuntimeType()) {
+      command_replay_ = false;
+      break;
+    }
+  }
 
   return MaceStatus::MACE_SUCCESS;
 }
 
+void SerialNet::GetRunSignature(std::vector<index_t> *signature) {
+  signature->clear();
+  auto append_tensor = [signature](const Tensor *tensor) {
+    signature->push_back(reinterpret_cast<intptr_t>(tensor->memory<void>()));
+    signature->push_back(tensor->dim_size());
+    signature->insert(signature->end(), tensor->shape().begin(),
+                      tensor->shape().end());
+  };
+  for (auto &op : operators_) {
+    for (int i = 0; i < op->InputSize(); ++i) {
+      append_tensor(op->Input(i));
+    }
+    for (int i = 0; i < op->OutputSize(); ++i) {
+      append_tensor(op->Output(i));
+    }
+  }
+}
+
 MaceStatus SerialNet::Run(RunMetadata *run_metadata,
                           bool fake_warmup) {
+  // The observer needs the outputs of the operators one by one.
+  if (!command_replay_ || run_metadata != nullptr || fake_warmup ||
+      observer_ != nullptr) {
+    return RunOperators(run_metadata, fake_warmup);
+  }
+
+  // With the same shapes and memory as the last run, the ops would issue
+  // the same commands again.
+  std::vector<index_t> signature;
+  GetRunSignature(&signature);
+  if (signature == record_signature_ &&
+      target_runtime_->ReplayCommands(this) == MaceStatus::MACE_SUCCESS) {
+    return MaceStatus::MACE_SUCCESS;
+  }
+
+  record_signature_.clear();
+  MACE_RETURN_IF_ERROR(target_runtime_->StartCommandRecord(this));
+  MaceStatus status = RunOperators(nullptr, false);
+  MaceStatus record_status = target_runtime_->StopCommandRecord(
+      this, status == MaceStatus::MACE_SUCCESS);
+  if (record_status == MaceStatus::MACE_UNSUPPORTED) {
+    VLOG(1) << "The commands of the net can not be replayed";
+    target_runtime_->ReleaseCommandRecord(this);
+    command_replay_ = false;
+  } else if (status == MaceStatus::MACE_SUCCESS &&
+             record_status == MaceStatus::MACE_SUCCESS) {
+    GetRunSignature(&record_signature_);
+  }
+  return status;
+}
+
+MaceStatus SerialNet::RunOperators(RunMetadata *run_metadata,
+                                   bool fake_warmup) {
   const char *profiling = getenv("MACE_OPENCL_PROFILING");
   bool enable_opencl_profiling =
       profiling != nullptr && strlen(profiling) == 1 && profiling[0] == '1';
@@ -182,44 +266,10 @@ MaceStatus SerialNet::Run(RunMetadata *run_metadata,
     VLOG(3) << "Operator " << op->debug_def().name()
             << " has shape: " << MakeString(op->Output(0)->shape());
 
-    if (EnvConfEnabled("MACE_LOG_TENSOR_RANGE")) {
+    if (observer_ != nullptr) {
       for (int i = 0; i < op->OutputSize(); ++i) {
-        if (op->debug_def().quantize_info_size() == 0) {
-          int data_type = op->GetOptionalArg("T", static_cast<int>(DT_FLOAT));
-          MACE_CHECK(data_type == static_cast<int>(DT_FLOAT),
-                     "On quantize_stata mode, must use float32 model");
-          float max_v = std::numeric_limits<float>::lowest();
-          float min_v = std::numeric_limits<float>::max();
-          Tensor::MappingGuard guard(op->Output(i));
-          auto *output_data = op->Output(i)->data<float>();
-          for (index_t j = 0; j < op->Output(i)->size(); ++j) {
-            max_v = std::max(max_v, output_data[j]);
-            min_v = std::min(min_v, output_data[j]);
-          }
-          LOG(INFO) << "Tensor range @@" << op->debug_def().output(i) << "@@"
-                    << min_v << "," << max_v;
-        } else {
-          const int bin_size = 2048;
-          for (int ind = 0; ind < op->debug_def().quantize_info_size(); ++ind) {
-            float min_v = op->debug_def().quantize_info(ind).minval();
-            float max_v = op->debug_def().quantize_info(ind).maxval();
-            std::vector<int> bin_distribution(bin_size, 0);
-            float bin_v = (max_v - min_v) / bin_size;
-            Tensor::MappingGuard guard(op->Output(i));
-            auto *output_data = op->Output(i)->data<float>();
-            for (index_t j = 0; j < op->Output(i)->size(); ++j) {
-              int index = static_cast<int>((output_data[j] - min_v) / bin_v);
-              if (index < 0)
-                index = 0;
-              else if (index > bin_size - 1)
-                index = bin_size - 1;
-              bin_distribution[index]++;
-            }
-            LOG(INFO) << "Tensor range @@" << op->debug_def().output(i)
-                      << "@@" << min_v << "," << max_v << "@@"
-                      << MakeString(bin_distribution);
-          }
-        }
+        MACE_RETURN_IF_ERROR(
+            observer_->Observe(op->debug_def().output(i), op->Output(i)));
       }
     }
   }
@@ -227,8 +277,26 @@ MaceStatus SerialNet::Run(RunMetadata *run_metadata,
   return MaceStatus::MACE_SUCCESS;
 }
 
+int SerialNet::FakeWarmupEachOperator() {
+  OpContext context(ws_, target_runtime_);
+  context.set_fake_warmup(true);
+  int failed_ops = 0;
+  for (auto &op : operators_) {
+    // Fake warm up is only used for OpenCL runtime.
+    if (op->runtime_type() != RuntimeType::RT_OPENCL) {
+      continue;
+    }
+    if (op->Forward(&context) != MaceStatus::MACE_SUCCESS) {
+      ++failed_ops;
+    }
+  }
+  return failed_ops;
+}
+
 MaceStatus SerialNet::AllocateIntermediateBuffer() {
-  MACE_RETURN_IF_ERROR(AllocateTensorMemory<SERIAL_OPT>(operators_));
+  record_signature_.clear();
+  MACE_RETURN_IF_ERROR(AllocateTensorMemory<SERIAL_OPT>(
+      operators_, model_outputs_, external_outputs_));
   return MaceStatus::MACE_SUCCESS;
 }
 
@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <sstream>
 
 #include "mace/core/ops/operator.h"
@@ -36,6 +37,13 @@ class SerialNet : public BaseNet {
             Workspace *ws,
             Runtime *target_runtime,
             Runtime *cpu_runtime);
+  // Take over `net_def`, the operators refer to their definitions in it
+  // instead of copying them.
+  SerialNet(const OpRegistry *op_registry,
+            std::shared_ptr<NetDef> net_def,
+            Workspace *ws,
+            Runtime *target_runtime,
+            Runtime *cpu_runtime);
   virtual ~SerialNet();
 
   MaceStatus Init() override;
@@ -45,12 +53,25 @@ class SerialNet : public BaseNet {
 
   MaceStatus AllocateIntermediateBuffer() override;
 
+  int FakeWarmupEachOperator() override;
+
+ protected:
+  MaceStatus RunOperators(RunMetadata *run_metadata, bool fake_warmup);
+  // Shapes and memory of the tensors used by the operators
+  void GetRunSignature(std::vector<index_t> *signature);
+
  protected:
   Workspace *ws_;
   Runtime *target_runtime_;
   // CPU is base device.
   Runtime *cpu_runtime_;
+  // The definitions of the operators, which also keep the memory plan
+  std::shared_ptr<NetDef> net_def_;
   std::vector<std::unique_ptr<Operation>> operators_;
+  std::unordered_set<std::string> model_outputs_;
+  // Replay the commands recorded by the last run when nothing changed
+  bool command_replay_;
+  std::vector<index_t> record_signature_;
 
  protected:
   MACE_DISABLE_COPY_AND_ASSIGN(SerialNet);
@@ -128,6 +128,22 @@ int Operation::ReuseTensorMapId(size_t output_idx) const {
   return -1;
 }
 
+index_t Operation::InputViewOffset(size_t input_idx) const {
+  MACE_UNUSED(input_idx);
+  return -1;
+}
+
+index_t Operation::OutputViewOffset(size_t output_idx) const {
+  MACE_UNUSED(output_idx);
+  return -1;
+}
+
+bool Operation::SupportsInPlace(size_t output_idx, size_t input_idx) const {
+  MACE_UNUSED(output_idx);
+  MACE_UNUSED(input_idx);
+  return false;
+}
+
 BufferContentType Operation::GetInputTensorContentType(size_t idx) const {
   MACE_UNUSED(idx);
   return BufferContentType::IN_OUT_CHANNEL;
@@ -90,6 +90,19 @@ class Operation {
   virtual MaceStatus Forward(OpContext *context);
   virtual MaceStatus Run(OpContext *context) = 0;
   virtual int ReuseTensorMapId(size_t output_idx) const;
+  // Element offset of input `input_idx` inside output 0 when the memory
+  // planner may place the input as a view of the output, -1 if it may not.
+  // Used by copy-only ops like Concat, which must still run correctly when
+  // the tensors are not placed as views.
+  virtual index_t InputViewOffset(size_t input_idx) const;
+  // Element offset of output `output_idx` inside input 0 when the memory
+  // planner may place the output as a view of the input, -1 if it may not.
+  virtual index_t OutputViewOffset(size_t output_idx) const;
+  // Whether output `output_idx` may be computed into the memory of input
+  // `input_idx` when the input dies at this op. The input is then a distinct
+  // tensor sharing the output's memory, each of its elements must be read
+  // before the output element at the same index is written.
+  virtual bool SupportsInPlace(size_t output_idx, size_t input_idx) const;
 
   const OperatorDef &debug_def() const {
     MACE_CHECK(has_debug_def(), "operator_def was null!");
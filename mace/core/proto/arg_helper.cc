@@ -15,32 +15,43 @@
 #include "mace/core/proto/arg_helper.h"
 
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "mace/utils/logging.h"
 
 namespace mace {
 
-ProtoArgHelper::ProtoArgHelper(const OperatorDef &def) {
+ProtoArgHelper::ProtoArgHelper(const OperatorDef &def) : args_(&def.arg()) {
+  std::unordered_set<std::string> names;
   for (auto &arg : def.arg()) {
-    if (arg_map_.count(arg.name())) {
+    if (!names.insert(arg.name()).second) {
       LOG(WARNING) << "Duplicated argument " << arg.name()
                    << " found in operator " << def.name();
     }
-    arg_map_[arg.name()] = arg;
   }
 }
 
-ProtoArgHelper::ProtoArgHelper(const NetDef &netdef) {
+ProtoArgHelper::ProtoArgHelper(const NetDef &netdef) : args_(&netdef.arg()) {
+  std::unordered_set<std::string> names;
   for (auto &arg : netdef.arg()) {
-    MACE_CHECK(arg_map_.count(arg.name()) == 0,
+    MACE_CHECK(names.insert(arg.name()).second,
                "Duplicated argument found in net def.");
-    arg_map_[arg.name()] = arg;
   }
 }
 
+const Argument *ProtoArgHelper::FindArg(const ArgumentList &args,
+                                        const std::string &arg_name) {
+  for (int i = args.size() - 1; i >= 0; --i) {
+    if (args.Get(i).name() == arg_name) {
+      return &args.Get(i);
+    }
+  }
+  return nullptr;
+}
+
 bool ProtoArgHelper::ExistArg(const std::string &arg_name) const {
-  return (arg_map_.count(arg_name) > 0);
+  return FindArg(*args_, arg_name) != nullptr;
 }
 
 namespace {
@@ -52,22 +63,27 @@ inline bool IsCastLossless(const InputType &value) {
 
 #define MACE_GET_OPTIONAL_ARGUMENT_FUNC(T, fieldname, lossless_conversion)     \
   template <>                                                                  \
-  T ProtoArgHelper::GetOptionalArg<T>(const std::string &arg_name,             \
-                                      const T &default_value) const {          \
-    if (arg_map_.count(arg_name) == 0) {                                       \
+  T ProtoArgHelper::GetArgValue<T>(const Argument *arg,                        \
+                                   const std::string &arg_name,                \
+                                   const T &default_value) {                   \
+    if (arg == nullptr) {                                                      \
       VLOG(3) << "Using default parameter " << default_value << " for "        \
               << arg_name;                                                     \
       return default_value;                                                    \
     }                                                                          \
-    MACE_CHECK(arg_map_.at(arg_name).has_##fieldname(), "Argument ", arg_name, \
-               " not found!");                                                 \
-    auto value = arg_map_.at(arg_name).fieldname();                            \
+    MACE_CHECK(arg->has_##fieldname(), "Argument ", arg_name, " not found!");  \
+    auto value = arg->fieldname();                                             \
     if (lossless_conversion) {                                                 \
       const bool castLossless = IsCastLossless<decltype(value), T>(value);     \
       MACE_CHECK(castLossless, "Value", value, " of argument ", arg_name,      \
                  "cannot be casted losslessly to a target type");              \
     }                                                                          \
     return value;                                                              \
+  }                                                                            \
+  template <>                                                                  \
+  T ProtoArgHelper::GetOptionalArg<T>(const std::string &arg_name,             \
+                                      const T &default_value) const {          \
+    return GetArgValue<T>(FindArg(*args_, arg_name), arg_name, default_value); \
   }
 
 MACE_GET_OPTIONAL_ARGUMENT_FUNC(float, f, false)
@@ -78,11 +94,11 @@ MACE_GET_OPTIONAL_ARGUMENT_FUNC(std::string, s, false)
 
 #define MACE_GET_REPEATED_ARGUMENT_FUNC(T, fieldname, lossless_conversion) \
   template <>                                                              \
-  std::vector<T> ProtoArgHelper::GetRepeatedArgs<T>(                       \
-      const std::string &arg_name) const {                                 \
-    MACE_CHECK(arg_map_.count(arg_name) > 0, arg_name, "not exist.");      \
+  std::vector<T> ProtoArgHelper::GetRepeatedValues<T>(                     \
+      const Argument &arg, const std::string &arg_name) {                  \
     std::vector<T> values;                                                 \
-    for (const auto &v : arg_map_.at(arg_name).fieldname()) {              \
+    values.reserve(arg.fieldname##_size());                                \
+    for (const auto &v : arg.fieldname()) {                                \
       if (lossless_conversion) {                                           \
         const bool castLossless = IsCastLossless<decltype(v), T>(v);       \
         MACE_CHECK(castLossless, "Value", v, " of argument ", arg_name,    \
@@ -93,13 +109,21 @@ MACE_GET_OPTIONAL_ARGUMENT_FUNC(std::string, s, false)
     return values;                                                         \
   }                                                                        \
   template <>                                                              \
+  std::vector<T> ProtoArgHelper::GetRepeatedArgs<T>(                       \
+      const std::string &arg_name) const {                                 \
+    const Argument *arg = FindArg(*args_, arg_name);                       \
+    MACE_CHECK(arg != nullptr, arg_name, "not exist.");                    \
+    return GetRepeatedValues<T>(*arg, arg_name);                           \
+  }                                                                        \
+  template <>                                                              \
   std::vector<T> ProtoArgHelper::GetRepeatedArgs<T>(                       \
       const std::string &arg_name, const std::vector<T> &default_value)    \
       const {                                                              \
-    if (arg_map_.count(arg_name) == 0) {                                   \
+    const Argument *arg = FindArg(*args_, arg_name);                       \
+    if (arg == nullptr) {                                                  \
       return default_value;                                                \
     } else {                                                               \
-      return GetRepeatedArgs<T>(arg_name);                                 \
+      return GetRepeatedValues<T>(*arg, arg_name);                         \
     }                                                                      \
   }
 
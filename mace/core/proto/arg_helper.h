@@ -30,7 +30,8 @@ class ProtoArgHelper {
   static T GetOptionalArg(const Def &def,
                           const std::string &arg_name,
                           const T &default_value) {
-    return ProtoArgHelper(def).GetOptionalArg<T>(arg_name, default_value);
+    return GetArgValue<T>(FindArg(def.arg(), arg_name), arg_name,
+                          default_value);
   }
 
   template <typename Def, typename T>
@@ -38,12 +39,16 @@ class ProtoArgHelper {
       const Def &def,
       const std::string &arg_name,
       const std::vector<T> &default_value = std::vector<T>()) {
-    return ProtoArgHelper(def).GetRepeatedArgs<T>(arg_name, default_value);
+    const Argument *arg = FindArg(def.arg(), arg_name);
+    if (arg == nullptr) {
+      return default_value;
+    }
+    return GetRepeatedValues<T>(*arg, arg_name);
   }
 
   template <typename Def>
   static bool ExistArg(const Def &def, const std::string &arg_name) {
-    return ProtoArgHelper(def).ExistArg(arg_name);
+    return FindArg(def.arg(), arg_name) != nullptr;
   }
 
   explicit ProtoArgHelper(const OperatorDef &def);
@@ -63,7 +68,23 @@ class ProtoArgHelper {
   bool ExistArg(const std::string &arg_name) const;
 
  private:
-  std::map<std::string, Argument> arg_map_;
+  typedef google::protobuf::RepeatedPtrField<Argument> ArgumentList;
+
+  // Look up the argument in place, so a lookup neither builds an index nor
+  // copies the arguments. The last one wins if an argument is duplicated.
+  static const Argument *FindArg(const ArgumentList &args,
+                                 const std::string &arg_name);
+
+  template <typename T>
+  static T GetArgValue(const Argument *arg,
+                       const std::string &arg_name,
+                       const T &default_value);
+
+  template <typename T>
+  static std::vector<T> GetRepeatedValues(const Argument &arg,
+                                          const std::string &arg_name);
+
+  const ArgumentList *args_;
 };
 
 template <typename T>
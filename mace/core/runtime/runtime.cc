@@ -56,6 +56,34 @@ MaceStatus Runtime::AfterRun() {
   return MaceStatus::MACE_SUCCESS;
 }
 
+bool Runtime::IsReady() {
+  return true;
+}
+
+bool Runtime::CommandReplayEnabled() {
+  return false;
+}
+
+MaceStatus Runtime::StartCommandRecord(const void *owner) {
+  MACE_UNUSED(owner);
+  return MaceStatus::MACE_UNSUPPORTED;
+}
+
+MaceStatus Runtime::StopCommandRecord(const void *owner, bool keep) {
+  MACE_UNUSED(owner);
+  MACE_UNUSED(keep);
+  return MaceStatus::MACE_UNSUPPORTED;
+}
+
+MaceStatus Runtime::ReplayCommands(const void *owner) {
+  MACE_UNUSED(owner);
+  return MaceStatus::MACE_UNSUPPORTED;
+}
+
+void Runtime::ReleaseCommandRecord(const void *owner) {
+  MACE_UNUSED(owner);
+}
+
 MaceStatus Runtime::MapBuffer(Buffer *buffer, bool wait_for_finish) {
   MACE_UNUSED(wait_for_finish);
   buffer->SetHost(buffer->mutable_memory<uint8_t>() + buffer->offset());
@@ -68,8 +96,10 @@ bool Runtime::CanReuseBuffer(
     const BufferContentType content_type, const unsigned int content_param) {
   MACE_UNUSED(content_type);
   MACE_UNUSED(content_param);
-  auto size_bytes = std::accumulate(shape.begin(), shape.end(),
-                                    1, std::multiplies<index_t>());
+  auto size_bytes = std::accumulate(
+      shape.begin(), shape.end(),
+      static_cast<index_t>(GetEnumTypeSize(buffer->data_type)),
+      std::multiplies<index_t>());
   MemoryManager *memory_manager = GetMemoryManager(buffer->mem_type);
   auto real_shape = memory_manager->GetMemoryRealSize(buffer->memory<void>());
   MACE_CHECK(real_shape.size() == 1, "Only support dim 1");
@@ -203,8 +233,9 @@ void Runtime::SetBufferToTensor(
 
 void Runtime::ReleaseIntermediateBuffer(const BaseEngine *engine) {
   has_ever_released_inter_mem_ = true;
-  auto state = inter_mem_state_map_.at(engine);
-  MACE_CHECK(state == InterMemState::CREATED || state == InterMemState::STABLE);
+  // The engine may not have run since its buffers were created at init
+  MACE_CHECK(inter_mem_state_map_.count(engine) == 0 ||
+      inter_mem_state_map_.at(engine) != InterMemState::RELEASED);
   inter_mem_state_map_[engine] = InterMemState::RELEASED;
 
   for (auto info : inter_mem_state_map_) {
@@ -238,8 +269,18 @@ bool Runtime::IntermediateBufferStable(const OpContext *op_context) const {
   }
 
   auto engine = op_context->workspace()->GetMaceFlow()->GetMaceEngine();
-  MACE_CHECK(inter_mem_state_map_.count(engine) != 0);
-  return inter_mem_state_map_.at(engine) == InterMemState::STABLE;
+  auto iter = inter_mem_state_map_.find(engine);
+  // An engine sharing the runtime but not run yet has no kernel arguments
+  // to keep.
+  return iter == inter_mem_state_map_.end() ||
+      iter->second == InterMemState::STABLE;
+}
+
+void Runtime::OnKernelArgsStale(const BaseEngine *engine) {
+  MACE_CHECK(inter_mem_state_map_.count(engine) == 0 ||
+      inter_mem_state_map_.at(engine) != InterMemState::RELEASED);
+  has_ever_released_inter_mem_ = true;  // Turn off the shortcut
+  inter_mem_state_map_[engine] = InterMemState::CREATED;
 }
 
 }  // namespace mace
@@ -50,6 +50,18 @@ class Runtime {
 
   virtual MaceStatus BeforeRun(MaceEngineCfgImpl *config);
   virtual MaceStatus AfterRun();
+  // false while the runtime is still preparing in background
+  virtual bool IsReady();
+
+  // Record the device commands issued by one run of `owner` and replay
+  // them later without running the ops again, see SerialNet::Run.
+  // StopCommandRecord returns MACE_UNSUPPORTED if the commands can not be
+  // replayed, e.g. the host accessed device memory in between.
+  virtual bool CommandReplayEnabled();
+  virtual MaceStatus StartCommandRecord(const void *owner);
+  virtual MaceStatus StopCommandRecord(const void *owner, bool keep);
+  virtual MaceStatus ReplayCommands(const void *owner);
+  virtual void ReleaseCommandRecord(const void *owner);
 
   virtual MaceStatus MapBuffer(Buffer *buffer, bool wait_for_finish);
   virtual MaceStatus UnMapBuffer(Buffer *buffer);
@@ -94,6 +106,9 @@ class Runtime {
   void OnIntermediateBufferUsed(const BaseEngine *engine);
   bool IntermediateBufferCreated(const BaseEngine *engine) const;
   bool IntermediateBufferStable(const OpContext *op_context) const;
+  // The ops of `engine` set their kernel arguments again at the next run,
+  // e.g. after a fake warmup they left halfway.
+  void OnKernelArgsStale(const BaseEngine *engine);
 
  protected:
   utils::ThreadPool *thread_pool_;
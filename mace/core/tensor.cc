@@ -163,8 +163,15 @@ MaceStatus Tensor::Resize(const std::vector<index_t> &shape) {
   bool need_new =
       (buffer_->memory<void>() == nullptr || buffer_->dims.size() == 0);
   if (!need_new) {
-    need_new = !runtime_->CanReuseBuffer(buffer_.get(), shape, content_type_,
-                                         content_param_);
+    const index_t capacity = buffer_->capacity();
+    if (capacity >= 0) {
+      need_new = std::accumulate(shape.begin(), shape.end(),
+                                 static_cast<index_t>(SizeOfType()),
+                                 std::multiplies<index_t>()) > capacity;
+    } else {
+      need_new = !runtime_->CanReuseBuffer(buffer_.get(), shape,
+                                           content_type_, content_param_);
+    }
   }
 
   shape_ = shape;
@@ -181,6 +188,18 @@ MaceStatus Tensor::Resize(const std::vector<index_t> &shape) {
   return ret;
 }
 
+bool Tensor::SharesMemoryWith(const Tensor &other) const {
+  if (buffer_ == nullptr || other.buffer_ == nullptr ||
+      buffer_->memory<void>() == nullptr ||
+      buffer_->memory<void>() != other.buffer_->memory<void>()) {
+    return false;
+  }
+  const index_t begin = buffer_->offset();
+  const index_t other_begin = other.buffer_->offset();
+  return begin < other_begin + other.raw_size() &&
+      other_begin < begin + raw_size();
+}
+
 // Make this tensor reuse other tensor's buffer.
 // This tensor has the same dtype, shape and image_shape.
 // It could be reshaped later (with image shape unchanged).
@@ -269,6 +288,10 @@ bool Tensor::is_weight() const {
   return is_weight_;
 }
 
+bool Tensor::is_shared() const {
+  return is_shared_;
+}
+
 float Tensor::scale() const {
   return scale_;
 }
@@ -298,6 +321,10 @@ void Tensor::SetIsWeight(bool is_weight) {
   is_weight_ = is_weight;
 }
 
+void Tensor::SetIsShared(bool is_shared) {
+  is_shared_ = is_shared;
+}
+
 void Tensor::SetMinVal(float minval) {
   minval_ = minval;
 }
@@ -113,6 +113,7 @@ class Tensor {
         unused_(false),
         name_(name),
         is_weight_(is_weight),
+        is_shared_(false),
         scale_(0.f),
         zero_point_(0),
         minval_(0.f),
@@ -132,6 +133,7 @@ class Tensor {
         unused_(false),
         name_(name),
         is_weight_(is_weight),
+        is_shared_(false),
         scale_(0.f),
         zero_point_(0),
         minval_(0.f),
@@ -216,6 +218,8 @@ class Tensor {
   void Copy(const Tensor &other);
   size_t SizeOfType() const;
   Buffer *UnderlyingBuffer() const;
+  // Whether the data of this tensor and other overlap in memory.
+  bool SharesMemoryWith(const Tensor &other) const;
   void DebugPrint() const;
 
   void Map(bool wait_for_finish) const;
@@ -232,6 +236,9 @@ class Tensor {
   };
 
   bool is_weight() const;
+  // The buffer is shared with other engines, e.g. a weight block of the
+  // WeightRegistry, so its pages must not be released by AdviseFree.
+  bool is_shared() const;
   float scale() const;
   int32_t zero_point() const;
 
@@ -241,6 +248,7 @@ class Tensor {
   void SetScale(float scale);
   void SetZeroPoint(int32_t zero_point);
   void SetIsWeight(bool is_weight);
+  void SetIsShared(bool is_shared);
   void SetMinVal(float minval);
   void SetMaxVal(float maxval);
 
@@ -252,6 +260,7 @@ class Tensor {
   bool unused_;
   std::string name_;
   bool is_weight_;
+  bool is_shared_;
   float scale_;
   int32_t zero_point_;
   float minval_;
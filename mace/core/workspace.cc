@@ -29,22 +29,70 @@ template<typename T>
 void DequantizeTensor(Runtime *runtime,
                       const unsigned char *model_data,
                       const ConstTensor &const_tensor,
-                      Tensor *output_tensor) {
-  Tensor::MappingGuard guard(output_tensor);
+                      const index_t size,
+                      T *dequantized_data) {
   auto quantized_data = reinterpret_cast<const uint8_t *>(
       model_data + const_tensor.offset());
-  auto dequantized_data = output_tensor->mutable_data<T>();
   QuantizeUtil<T, uint8_t> quantize_util(&(runtime->thread_pool()));
   quantize_util.Dequantize(quantized_data,
-                           output_tensor->size(),
+                           size,
                            const_tensor.scale(),
                            const_tensor.zero_point(),
                            dequantized_data);
 }
 
+// Decode `const_tensor` from model data into host memory `dst` of
+// `size` elements of `dst_data_type`.
+void LoadConstTensorData(Runtime *runtime,
+                         const unsigned char *model_data,
+                         const ConstTensor &const_tensor,
+                         const DataType dst_data_type,
+                         const bool is_quantize_model,
+                         const index_t size,
+                         void *dst) {
+  if (runtime->GetRuntimeType() == RuntimeType::RT_CPU &&
+      const_tensor.data_type() == DataType::DT_HALF) {
+    // uncompress the weights of fp16
+    auto org_data = reinterpret_cast<const half *>(
+        model_data + const_tensor.offset());
+    float *dst_data = static_cast<float *>(dst);
+    for (int i = 0; i < const_tensor.data_size(); ++i) {
+      dst_data[i] = half_float::half_cast<float>(org_data[i]);
+    }
+  } else if (!is_quantize_model && const_tensor.quantized()) {
+    // uncompress the weights of uint8
+    if (dst_data_type != DT_FLOAT) {
+      DequantizeTensor<half>(runtime, model_data, const_tensor, size,
+                             static_cast<half *>(dst));
+    } else {
+      DequantizeTensor<float>(runtime, model_data, const_tensor, size,
+                              static_cast<float *>(dst));
+    }
+  } else {
+    memcpy(dst, model_data + const_tensor.offset(),
+           const_tensor.data_size() *
+               GetEnumTypeSize(const_tensor.data_type()));
+  }
+}
+
+// Everything besides the source bytes that decides what
+// LoadConstTensorData produces.
+std::string ConstTensorTarget(const ConstTensor &const_tensor,
+                              const DataType dst_data_type) {
+  std::string target = MakeString("load_", static_cast<int>(dst_data_type),
+                                  "_", static_cast<int>(
+                                      const_tensor.data_type()));
+  if (const_tensor.quantized()) {
+    target += MakeString("_q", const_tensor.scale(), "_",
+                         const_tensor.zero_point());
+  }
+  return target;
+}
+
 }  // namespace
 
 Workspace::Workspace(const OpDelegatorRegistry *registry, BaseFlow *flow) :
+    weight_sharing_(false),
     op_delegator_registry_(registry),
     parent_flow_(flow) {}
 
@@ -71,6 +119,37 @@ Tensor *Workspace::CreateTensor(const std::string &name, Runtime *runtime,
   return GetTensor(name);
 }
 
+Tensor *Workspace::GetPackedWeight(const std::string &name, Runtime *runtime,
+                                   DataType dt,
+                                   const std::vector<index_t> &shape,
+                                   bool *filled) {
+  *filled = false;
+  // Only float weights load back as they are, e.g. half ones become float
+  if (dt != DT_FLOAT ||
+      runtime->GetRuntimeType() != RuntimeType::RT_CPU) {
+    return nullptr;
+  }
+  Tensor *tensor = GetTensor(name);
+  if (tensor != nullptr) {
+    if (!tensor->is_weight() || tensor->dtype() != dt ||
+        tensor->shape() != shape) {
+      LOG(WARNING) << "Tensor " << name << " is not the packed weight";
+      return nullptr;
+    }
+    *filled = true;
+    return tensor;
+  }
+  auto packed = make_unique<Tensor>(runtime, dt, MemoryType::CPU_BUFFER,
+                                    shape, true, name);
+  if (runtime->AllocateBufferForTensor(packed.get(), RENT_PRIVATE) !=
+      MaceStatus::MACE_SUCCESS) {
+    return nullptr;
+  }
+  tensor = packed.get();
+  tensor_map_[name] = std::move(packed);
+  return tensor;
+}
+
 Workspace::~Workspace() {
   VLOG(1) << "Destroy Workspace";
 }
@@ -118,8 +197,14 @@ MaceStatus Workspace::LoadModelTensor(const NetDef &net_def, Runtime *runtime,
   }
 
   const RuntimeType runtime_type = runtime->GetRuntimeType();
-  auto slice_parent = runtime->MakeSliceBuffer(net_def, model_data,
-                                               valid_data_size);
+  const bool share_weights =
+      weight_sharing_ && runtime_type == RuntimeType::RT_CPU &&
+      runtime->GetUsedMemoryType() == MemoryType::CPU_BUFFER;
+  std::unique_ptr<Buffer> slice_parent;
+  if (!share_weights) {
+    slice_parent = runtime->MakeSliceBuffer(net_def, model_data,
+                                            valid_data_size);
+  }
   diffused_buffer_ = (slice_parent == nullptr);
   if (diffused_buffer_) {
     bool is_quantize_model = NetDefHelper::IsQuantizedModel(net_def);
@@ -138,39 +223,29 @@ MaceStatus Workspace::LoadModelTensor(const NetDef &net_def, Runtime *runtime,
           runtime->GetComputeDataType(net_def, const_tensor);
       auto tensor = make_unique<Tensor>(
           runtime, dst_data_type, dims, true, const_tensor.name());
-      runtime->AllocateBufferForTensor(tensor.get(), BufRentType::RENT_PRIVATE);
 
-      const index_t tensor_end = const_tensor.offset() +
+      const index_t src_bytes =
           tensor->size() * GetEnumTypeSize(const_tensor.data_type());
+      const index_t tensor_end = const_tensor.offset() + src_bytes;
       MACE_CHECK(tensor_end <= model_data_size, "tensor_end (", tensor_end,
                  ") should <= ", model_data_size);
 
-      if (runtime_type == RuntimeType::RT_CPU &&
-          const_tensor.data_type() == DataType::DT_HALF) {
-        // uncompress the weights of fp16
-        auto org_data = reinterpret_cast<const half *>(
-            model_data + const_tensor.offset());
-        float *dst_data = tensor->mutable_data<float>();
-        for (int i = 0; i < const_tensor.data_size(); ++i) {
-          dst_data[i] = half_float::half_cast<float>(org_data[i]);
-        }
-      } else if (!is_quantize_model && const_tensor.quantized()) {
-        // uncompress the weights of uint8
-        if (dst_data_type != DT_FLOAT) {
-          DequantizeTensor<half>(runtime,
-                                 model_data,
-                                 const_tensor,
-                                 tensor.get());
-        } else {
-          DequantizeTensor<float>(runtime,
-                                  model_data,
-                                  const_tensor,
-                                  tensor.get());
-        }
+      const index_t size = tensor->size();
+      auto fill = [=, &const_tensor](void *dst) {
+        LoadConstTensorData(runtime, model_data, const_tensor, dst_data_type,
+                            is_quantize_model, size, dst);
+      };
+      if (share_weights) {
+        const unsigned char *src = model_data + const_tensor.offset();
+        std::string key = WeightRegistry::MakeKey(
+            src, src_bytes, ConstTensorTarget(const_tensor, dst_data_type));
+        MACE_RETURN_IF_ERROR(MapSharedWeight(tensor.get(), runtime, key,
+                                             src, src_bytes, fill));
       } else {
-        tensor->CopyBytes(model_data + const_tensor.offset(),
-                          const_tensor.data_size() *
-                              GetEnumTypeSize(const_tensor.data_type()));
+        runtime->AllocateBufferForTensor(tensor.get(),
+                                         BufRentType::RENT_PRIVATE);
+        Tensor::MappingGuard guard(tensor.get());
+        fill(tensor->raw_mutable_data());
       }
 
       tensor_map_[const_tensor.name()] = std::move(tensor);
@@ -201,6 +276,24 @@ MaceStatus Workspace::LoadModelTensor(const NetDef &net_def, Runtime *runtime,
   return MaceStatus::MACE_SUCCESS;
 }
 
+MaceStatus Workspace::MapSharedWeight(Tensor *tensor, Runtime *runtime,
+                                      const std::string &key,
+                                      const void *src, index_t src_bytes,
+                                      const WeightRegistry::FillFunc &fill) {
+  const index_t bytes = tensor->raw_size();
+  if (bytes == 0) {
+    return runtime->AllocateBufferForTensor(tensor, RENT_PRIVATE);
+  }
+  std::shared_ptr<void> block = WeightRegistry::Get()->Acquire(
+      key, src, src_bytes, bytes, fill);
+  Buffer parent(MemoryType::CPU_BUFFER, DT_UINT8, {bytes}, block.get());
+  MACE_RETURN_IF_ERROR(runtime->AllocateBufferForTensor(
+      tensor, RENT_SLICE, &parent, 0));
+  tensor->SetIsShared(true);
+  shared_weights_[tensor->name()] = std::move(block);
+  return MaceStatus::MACE_SUCCESS;
+}
+
 MaceStatus Workspace::AddQuantizeInfoForOutputTensor(
     const mace::NetDef &net_def, Runtime *runtime) {
   // add quantize info for output tensors.
@@ -230,6 +323,7 @@ void Workspace::RemoveUnusedBuffer() {
   while (iter != end_iter) {
     auto old_iter = iter++;
     if (old_iter->second->unused()) {
+      shared_weights_.erase(old_iter->first);
       tensor_map_.erase(old_iter);
     }
   }
@@ -298,6 +392,7 @@ void Workspace::RemoveTensor(const std::string &name) {
   if (iter != tensor_map_.end()) {
     tensor_map_.erase(iter);
   }
+  shared_weights_.erase(name);
 }
 
 const OpDelegatorRegistry *Workspace::GetDelegatorRegistry() const {
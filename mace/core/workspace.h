@@ -20,6 +20,7 @@
 #include <vector>
 #include <memory>
 
+#include "mace/core/memory/weight_registry.h"
 #include "mace/core/runtime/runtime.h"
 #include "mace/core/tensor.h"
 #include "mace/public/mace.h"
@@ -51,6 +52,31 @@ class Workspace {
     return diffused_buffer_;
   }
 
+  // Load CPU weights through the process-wide WeightRegistry instead of
+  // private copies, must be set before LoadModelTensor.
+  inline void SetWeightSharing(bool enable) {
+    weight_sharing_ = enable;
+  }
+
+  inline bool weight_sharing() const {
+    return weight_sharing_;
+  }
+
+  // Back `tensor` with the shared block registered under `key`, `fill`
+  // produces the content from `src` when this is the first engine loading it.
+  MaceStatus MapSharedWeight(Tensor *tensor, Runtime *runtime,
+                             const std::string &key, const void *src,
+                             index_t src_bytes,
+                             const WeightRegistry::FillFunc &fill);
+
+  // A CPU weight the ops derive from another one, e.g. a packed filter, kept
+  // here so that it is exported with the other weights. Returns the tensor
+  // made by an earlier op or loaded from a snapshot with *filled set, or a
+  // new one to be filled, nullptr if the ops should keep the copy themselves.
+  Tensor *GetPackedWeight(const std::string &name, Runtime *runtime,
+                          DataType dt, const std::vector<index_t> &shape,
+                          bool *filled);
+
   Tensor *GetTensor(const std::string &name) const;
   MaceStatus AddTensor(const std::string &name, std::unique_ptr<Tensor> tensor);
 
@@ -77,9 +103,12 @@ class Workspace {
                                        Runtime *cpu_runtime);
 
  private:
+  // Declared before tensor_map_ so that tensors go away first.
+  std::map<std::string, std::shared_ptr<void>> shared_weights_;
   TensorMap tensor_map_;
   std::unique_ptr<Buffer> tensor_buffer_;
   bool diffused_buffer_;
+  bool weight_sharing_;
 
   const OpDelegatorRegistry *op_delegator_registry_;
   BaseFlow *parent_flow_;
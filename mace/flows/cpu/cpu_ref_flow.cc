@@ -16,14 +16,27 @@
 #include "mace/flows/cpu/cpu_ref_flow.h"
 #include "mace/flows/cpu/transpose_const.h"
 
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <unordered_set>
+
 #include "mace/core/flow/flow_registry.h"
 #include "mace/core/net_def_adapter.h"
+#include "mace/core/net/allocate_strategy.h"
 #include "mace/core/net/serial_net.h"
+#include "mace/core/proto/arg_helper.h"
 #include "mace/core/workspace.h"
 #include "mace/proto/mace.pb.h"
+#include "mace/utils/math.h"
 
 namespace mace {
 
+namespace {
+// Set on the graphs exported by CpuRefFlow, which are adapted to CPU
+const char kAdaptedGraphArgName[] = "adapted_graph";
+}  // namespace
+
 CpuRefFlow::CpuRefFlow(FlowContext *flow_context)
     : CommonFp32Flow(flow_context) {
   VLOG(3) << "CpuRefFlow::CpuRefFlow";
@@ -39,17 +52,30 @@ MaceStatus CpuRefFlow::Init(const NetDef *net_def,
   MACE_RETURN_IF_ERROR(ws_->LoadModelTensor(
       *net_def, main_runtime_, model_data, model_data_size));
 
-  NetDef adapted_net_def;
-  NetDefAdapter net_def_adapter(op_registry_, ws_.get());
-  net_def_adapter.AdaptNetDef(net_def, main_runtime_,
-                              cpu_runtime_, &adapted_net_def);
-  if (!is_quantized_model_) {
-    TransposeConstForCPU(&cpu_runtime_->thread_pool(), ws_.get(), cpu_runtime_,
-                         &adapted_net_def);
+  std::shared_ptr<NetDef> adapted_net_def;
+  if (ProtoArgHelper::GetOptionalArg<NetDef, int>(
+          *net_def, kAdaptedGraphArgName, 0) != 0) {
+    // Saved by ExportWeights, with the consts made for CPU already
+    if (main_runtime_->GetRuntimeType() != RuntimeType::RT_CPU) {
+      LOG(ERROR) << "The graph of flow " << name_ << " is adapted to CPU, "
+                 << "but runs on runtime " << main_runtime_->GetRuntimeType();
+      return MaceStatus::MACE_UNSUPPORTED;
+    }
+    adapted_net_def = std::make_shared<NetDef>(*net_def);
+  } else {
+    adapted_net_def = std::make_shared<NetDef>();
+    NetDefAdapter net_def_adapter(op_registry_, ws_.get());
+    net_def_adapter.AdaptNetDef(net_def, main_runtime_,
+                                cpu_runtime_, adapted_net_def.get());
+    if (!is_quantized_model_) {
+      TransposeConstForCPU(&cpu_runtime_->thread_pool(), ws_.get(),
+                           cpu_runtime_, adapted_net_def.get());
+    }
   }
+  adapted_net_def_ = adapted_net_def;
   // Init model
   net_ = std::unique_ptr<BaseNet>(new SerialNet(op_registry_,
-                                                &adapted_net_def,
+                                                adapted_net_def,
                                                 ws_.get(),
                                                 main_runtime_,
                                                 cpu_runtime_));
@@ -57,13 +83,13 @@ MaceStatus CpuRefFlow::Init(const NetDef *net_def,
     *model_data_unused = ws_->diffused_buffer();
   }
   if (main_runtime_->GetRuntimeType() == RuntimeType::RT_OPENCL) {
-    ws_->RemoveAndReloadBuffer(adapted_net_def, model_data, main_runtime_);
+    ws_->RemoveAndReloadBuffer(*adapted_net_def, model_data, main_runtime_);
     if (model_data_unused != nullptr) {
       *model_data_unused = true;
     }
   }
   MACE_RETURN_IF_ERROR(net_->Init());
-  MACE_RETURN_IF_ERROR(ws_->AddQuantizeInfoForOutputTensor(adapted_net_def,
+  MACE_RETURN_IF_ERROR(ws_->AddQuantizeInfoForOutputTensor(*adapted_net_def,
                                                            main_runtime_));
 
   return MaceStatus::MACE_SUCCESS;
@@ -78,6 +104,104 @@ MaceStatus CpuRefFlow::Run(TensorMap *input_tensors,
   return net_->Run(run_metadata, false);
 }
 
+MaceStatus CpuRefFlow::ExportWeights(NetDef *net_def,
+                                     std::vector<unsigned char> *data) {
+  if (main_runtime_->GetRuntimeType() != RuntimeType::RT_CPU) {
+    LOG(WARNING) << "Only CPU flows can export weights, but flow " << name_
+                 << " runs on runtime " << main_runtime_->GetRuntimeType();
+    return MaceStatus::MACE_UNSUPPORTED;
+  }
+
+  // The ops are saved as adapted, with the memory plan made by the net, so
+  // that a restored flow skips the adaptation and the planning.
+  if (adapted_net_def_ != nullptr) {
+    net_def->mutable_op()->CopyFrom(adapted_net_def_->op());
+    MemoryPlan plan;
+    LoadMemoryPlan(*adapted_net_def_, &plan);
+    SaveMemoryPlan(plan, net_def);
+    SetProtoArg<int>(net_def, kAdaptedGraphArgName, 1);
+  }
+
+  // The originals of the weights transposed by TransposeConstForCPU are dead,
+  // so the ops take the transposed copies and only those are exported.
+  std::unordered_set<std::string> dead_names;
+  for (const auto &name : ws_->Tensors()) {
+    if (ws_->GetTensor(name)->unused() &&
+        ws_->GetTensor(name + kCpuConstSuffix) != nullptr) {
+      dead_names.insert(name);
+    }
+  }
+  for (auto &op : *net_def->mutable_op()) {
+    for (int i = 0; i < op.input_size(); ++i) {
+      if (dead_names.count(op.input(i)) > 0) {
+        op.set_input(i, op.input(i) + kCpuConstSuffix);
+      }
+    }
+  }
+  auto *const_tensors = net_def->mutable_tensors();
+  int live_count = 0;
+  for (int i = 0; i < const_tensors->size(); ++i) {
+    if (dead_names.count(const_tensors->Get(i).name()) == 0) {
+      const_tensors->SwapElements(i, live_count++);
+    }
+  }
+  const_tensors->DeleteSubrange(live_count,
+                                const_tensors->size() - live_count);
+
+  // Weights created at init time, e.g. by TransposeConstForCPU, are exported
+  // as extra const tensors so that they need not be made again.
+  std::unordered_set<std::string> const_names;
+  for (const auto &const_tensor : net_def->tensors()) {
+    const_names.insert(const_tensor.name());
+  }
+  for (const auto &name : ws_->Tensors()) {
+    const Tensor *tensor = ws_->GetTensor(name);
+    if (tensor->is_weight() && const_names.count(name) == 0 &&
+        dead_names.count(name) == 0 &&
+        tensor->memory_type() == MemoryType::CPU_BUFFER) {
+      ConstTensor *const_tensor = net_def->add_tensors();
+      const_tensor->set_name(name);
+      for (const index_t d : tensor->shape()) {
+        const_tensor->add_dims(d);
+      }
+    }
+  }
+
+  const index_t data_begin = RoundUp<index_t>(data->size(), kMaceAlignment);
+  data->resize(data_begin);
+  for (auto &const_tensor : *net_def->mutable_tensors()) {
+    const Tensor *tensor = ws_->GetTensor(const_tensor.name());
+    if (tensor == nullptr) {
+      LOG(ERROR) << "Weight " << const_tensor.name() << " of flow " << name_
+                 << " is not loaded";
+      return MaceStatus::MACE_RUNTIME_ERROR;
+    }
+    if (tensor->dtype() != const_tensor.data_type()) {
+      // decoded from fp16 or dequantized at load time
+      const_tensor.set_quantized(false);
+      const_tensor.set_data_type(tensor->dtype());
+    }
+    const index_t offset = RoundUp<index_t>(data->size(), kMaceAlignment);
+    const index_t bytes = tensor->raw_size();
+    const_tensor.set_offset(offset - data_begin);
+    const_tensor.set_data_size(tensor->size());
+    data->resize(offset + bytes);
+    if (bytes > 0) {
+      Tensor::MappingGuard guard(tensor);
+      memcpy(data->data() + offset, tensor->raw_data(), bytes);
+    }
+  }
+  if (data->size() >
+      static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+    LOG(ERROR) << "Weights are too large to export: " << data->size();
+    return MaceStatus::MACE_OUT_OF_RESOURCES;
+  }
+  net_def->set_data_offset(static_cast<int32_t>(data_begin));
+  net_def->set_data_size(static_cast<int32_t>(data->size() - data_begin));
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
 MaceStatus CpuRefFlow::GetInputTransposeDims(
     const std::pair<const std::string, MaceTensor> &input,
     const Tensor *input_tensor,
@@ -36,6 +36,10 @@ class CpuRefFlow : public CommonFp32Flow {
 
   MaceStatus Run(TensorMap *input_tensors, TensorMap *output_tensors,
                  RunMetadata *run_metadata) override;
+
+  MaceStatus ExportWeights(NetDef *net_def,
+                           std::vector<unsigned char> *data) override;
+
  protected:
   MaceStatus GetInputTransposeDims(
       const std::pair<const std::string, MaceTensor> &input,
@@ -43,6 +47,9 @@ class CpuRefFlow : public CommonFp32Flow {
       DataFormat *data_format) override;
 
  private:
+  // The graph the net runs, exported by ExportWeights
+  std::shared_ptr<NetDef> adapted_net_def_;
+
   MACE_DISABLE_COPY_AND_ASSIGN(CpuRefFlow);
 };
 
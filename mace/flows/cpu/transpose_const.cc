@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
@@ -28,94 +29,32 @@
 namespace mace {
 
 namespace {
-static std::vector<index_t> GetTensorStride(const Tensor *tensor) {
-    int32_t ndim = static_cast<int32_t>(tensor->dim_size());
+static std::vector<index_t> GetTensorStride(
+    const std::vector<index_t> &shape) {
+    int32_t ndim = static_cast<int32_t>(shape.size());
     std::vector<index_t> stride(ndim, 1);
     for (int32_t i = ndim - 2; i >= 0; --i) {
-      stride[i] = stride[i+1] * static_cast<index_t>(tensor->dim(i+1));
+      stride[i] = stride[i+1] * shape[i+1];
     }
     return stride;
   }
-}
-
-MaceStatus DoTransposeConstForCPU(
-    mace::utils::ThreadPool *thread_pool,
-    Workspace *ws,
-    Runtime *runtime,
-    OperatorDef *op_def,
-    const int input_idx) {
 
-  MACE_UNUSED(thread_pool);
-  std::string input_name = op_def->input(input_idx);
-  Tensor *input = ws->GetTensor(input_name);
-
-  MemoryType src_mem_type = input->memory_type();
-  DataType src_dt = input->dtype();
-  MACE_CHECK(src_mem_type == CPU_BUFFER || src_mem_type == GPU_BUFFER,
-             "Only support transform CPU_BUFFER or GPU_BUFFER,",
-             " but ", input_name, " has ", static_cast<int>(src_mem_type));
-  DataType dst_dt = static_cast<DataType>(
-            ProtoArgHelper::GetOptionalArg<OperatorDef, int>(
-                *op_def, "T", static_cast<int>(DataType::DT_FLOAT)));
-  MACE_CHECK((src_dt == DT_FLOAT || src_dt == DT_HALF) &&
-             (dst_dt == DT_FLOAT || dst_dt == DT_HALF),
-             "Only support transform DT_FLOAT or DT_HALF,",
-             " but ", input_name, " has ", static_cast<int>(src_dt));
-  // Only support: half/float -> float, half -> half.
-  // Float -> half is not supported.
-  if (dst_dt == DT_HALF) {
-    MACE_CHECK(src_dt == DT_HALF, "When dst_dt is DT_HALF, "
-               "src_dt must be DT_HALF, but ", input_name,
-               " has data type of ", static_cast<int>(src_dt));
-  }
-  MemoryType dst_mem_type = CPU_BUFFER;
-  std::vector<index_t> input_shape = input->shape();
-  std::vector<index_t> output_shape = input_shape;
-  DataFormat op_data_format =
-      static_cast<DataFormat>(ProtoArgHelper::GetOptionalArg<OperatorDef, int>(
-          *op_def, "data_format",
-          static_cast<int>(DataFormat::NONE)));
-  bool cpu_nhwc = (op_data_format == DataFormat::NHWC &&
-                   input_shape.size() == 4);
-  bool cpu_nchw = (op_data_format == DataFormat::NCHW &&
-                   input_shape.size() == 4);
-  if (src_mem_type == dst_mem_type &&
-      src_dt == dst_dt &&
-      (input_shape.size() != 4 || cpu_nhwc)) {
-    return MaceStatus::MACE_SUCCESS;
-  }
-  std::vector<int> dims = {0, 3, 1, 2};
-  if (cpu_nchw) {
-    for (size_t i = 0; i < dims.size(); ++i) {
-      output_shape[i] = input_shape[dims[i]];
-    }
-  }
-  std::string output_name = input_name + std::string("_const_used_by_cpu");
-  Tensor *output = ws->GetTensor(output_name);
-  MACE_CHECK(output == nullptr || output->shape() == output_shape,
-             output_name, " should not exist, ",
-             "or it must be of shape ", MakeString(output_shape));
-  bool already_transposed = (output != nullptr &&
-                             output->shape() == output_shape);
-  if (output == nullptr) {
-    std::unique_ptr<Tensor> output_tensor =
-        make_unique<Tensor>(runtime, dst_dt, dst_mem_type,
-                            output_shape, true, output_name);
-    output = output_tensor.get();
-    runtime->AllocateBufferForTensor(output, RENT_PRIVATE);
-    ws->AddTensor(output_name, std::move(output_tensor));
-  }
-  op_def->set_input(input_idx, output_name);
-  if (already_transposed) {
-    return MaceStatus::MACE_SUCCESS;
-  }
-  input->Map(true);
+// Convert the const `input` to dst_dt, transposing NHWC to NCHW when
+// `transpose` is set, and write the result to `dst`.
+void ConvertConstForCPU(mace::utils::ThreadPool *thread_pool,
+                        const Tensor *input,
+                        const std::vector<index_t> &output_shape,
+                        const bool transpose,
+                        const DataType src_dt,
+                        const DataType dst_dt,
+                        void *dst) {
   const float *input_data = input->data<float>();
-  float *output_data = output->mutable_data<float>();
+  float *output_data = static_cast<float *>(dst);
   size_t num_elem = input->size();
-  size_t dst_bytes = output->raw_size();
+  size_t dst_bytes = num_elem * GetEnumTypeSize(dst_dt);
+  const std::vector<index_t> &input_shape = input->shape();
 
-  if (input_shape.size() != 4 || cpu_nhwc) {
+  if (!transpose) {
     if (src_dt == dst_dt) {
       memcpy(reinterpret_cast<void*>(output_data),
              reinterpret_cast<const void*>(input_data), dst_bytes);
@@ -128,14 +67,14 @@ MaceStatus DoTransposeConstForCPU(
         }
       }, 0, num_elem, 1);
     }
-    return MaceStatus::MACE_SUCCESS;
+    return;
   }
   index_t N = input_shape[0];
   index_t H = input_shape[1];
   index_t W = input_shape[2];
   index_t C = input_shape[3];
-  std::vector<index_t> input_stride = GetTensorStride(input);
-  std::vector<index_t> output_stride = GetTensorStride(output);
+  std::vector<index_t> input_stride = GetTensorStride(input_shape);
+  std::vector<index_t> output_stride = GetTensorStride(output_shape);
   if (src_dt == DT_HALF && dst_dt == DT_FLOAT) {
     const half *input_ptr = reinterpret_cast<const half*>(input_data);
     float *output_ptr = reinterpret_cast<float*>(output_data);
@@ -190,7 +129,108 @@ MaceStatus DoTransposeConstForCPU(
   } else {
     LOG(FATAL) << "Transposing from DT_FLOAT to DT_HALF is not supported";
   }
-  input->MarkUnused();
+}
+}  // namespace
+
+MaceStatus DoTransposeConstForCPU(
+    mace::utils::ThreadPool *thread_pool,
+    Workspace *ws,
+    Runtime *runtime,
+    OperatorDef *op_def,
+    const int input_idx) {
+  std::string input_name = op_def->input(input_idx);
+  // Already made for CPU, e.g. restored from a snapshot
+  const size_t suffix_size = strlen(kCpuConstSuffix);
+  if (input_name.size() > suffix_size &&
+      input_name.compare(input_name.size() - suffix_size, suffix_size,
+                         kCpuConstSuffix) == 0) {
+    return MaceStatus::MACE_SUCCESS;
+  }
+  Tensor *input = ws->GetTensor(input_name);
+
+  MemoryType src_mem_type = input->memory_type();
+  DataType src_dt = input->dtype();
+  MACE_CHECK(src_mem_type == CPU_BUFFER || src_mem_type == GPU_BUFFER,
+             "Only support transform CPU_BUFFER or GPU_BUFFER,",
+             " but ", input_name, " has ", static_cast<int>(src_mem_type));
+  DataType dst_dt = static_cast<DataType>(
+            ProtoArgHelper::GetOptionalArg<OperatorDef, int>(
+                *op_def, "T", static_cast<int>(DataType::DT_FLOAT)));
+  MACE_CHECK((src_dt == DT_FLOAT || src_dt == DT_HALF) &&
+             (dst_dt == DT_FLOAT || dst_dt == DT_HALF),
+             "Only support transform DT_FLOAT or DT_HALF,",
+             " but ", input_name, " has ", static_cast<int>(src_dt));
+  // Only support: half/float -> float, half -> half.
+  // Float -> half is not supported.
+  if (dst_dt == DT_HALF) {
+    MACE_CHECK(src_dt == DT_HALF, "When dst_dt is DT_HALF, "
+               "src_dt must be DT_HALF, but ", input_name,
+               " has data type of ", static_cast<int>(src_dt));
+  }
+  MemoryType dst_mem_type = CPU_BUFFER;
+  std::vector<index_t> input_shape = input->shape();
+  std::vector<index_t> output_shape = input_shape;
+  DataFormat op_data_format =
+      static_cast<DataFormat>(ProtoArgHelper::GetOptionalArg<OperatorDef, int>(
+          *op_def, "data_format",
+          static_cast<int>(DataFormat::NONE)));
+  bool cpu_nhwc = (op_data_format == DataFormat::NHWC &&
+                   input_shape.size() == 4);
+  bool cpu_nchw = (op_data_format == DataFormat::NCHW &&
+                   input_shape.size() == 4);
+  if (src_mem_type == dst_mem_type &&
+      src_dt == dst_dt &&
+      (input_shape.size() != 4 || cpu_nhwc)) {
+    return MaceStatus::MACE_SUCCESS;
+  }
+  std::vector<int> dims = {0, 3, 1, 2};
+  if (cpu_nchw) {
+    for (size_t i = 0; i < dims.size(); ++i) {
+      output_shape[i] = input_shape[dims[i]];
+    }
+  }
+  std::string output_name = input_name + kCpuConstSuffix;
+  Tensor *output = ws->GetTensor(output_name);
+  MACE_CHECK(output == nullptr || output->shape() == output_shape,
+             output_name, " should not exist, ",
+             "or it must be of shape ", MakeString(output_shape));
+  bool already_transposed = (output != nullptr &&
+                             output->shape() == output_shape);
+  if (output == nullptr) {
+    std::unique_ptr<Tensor> output_tensor =
+        make_unique<Tensor>(runtime, dst_dt, dst_mem_type,
+                            output_shape, true, output_name);
+    output = output_tensor.get();
+    ws->AddTensor(output_name, std::move(output_tensor));
+  }
+  op_def->set_input(input_idx, output_name);
+  if (already_transposed) {
+    return MaceStatus::MACE_SUCCESS;
+  }
+  input->Map(true);
+  const bool transpose = (input_shape.size() == 4 && !cpu_nhwc);
+  auto fill = [=](void *dst) {
+    ConvertConstForCPU(thread_pool, input, output_shape, transpose,
+                       src_dt, dst_dt, dst);
+  };
+  if (ws->weight_sharing()) {
+    std::string target = MakeString("cpu_const_", static_cast<int>(src_dt),
+                                    "_", static_cast<int>(dst_dt));
+    if (transpose) {
+      target += "_nchw" + MakeString(input_shape);
+    }
+    std::string key = WeightRegistry::MakeKey(input->raw_data(),
+                                              input->raw_size(), target);
+    MACE_RETURN_IF_ERROR(ws->MapSharedWeight(output, runtime, key,
+                                             input->raw_data(),
+                                             input->raw_size(), fill));
+  } else {
+    runtime->AllocateBufferForTensor(output, RENT_PRIVATE);
+    fill(output->raw_mutable_data());
+  }
+  if (transpose) {
+    input->MarkUnused();
+  }
   return MaceStatus::MACE_SUCCESS;
 }
 
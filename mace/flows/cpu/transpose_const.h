@@ -19,7 +19,12 @@
 #include "mace/utils/thread_pool.h"
 
 namespace mace {
+class Runtime;
 class Workspace;
+
+// Suffix of the copies of the const tensors made for the CPU ops
+constexpr char kCpuConstSuffix[] = "_const_used_by_cpu";
+
 MaceStatus TransposeConstForCPU(
     mace::utils::ThreadPool *thread_pool,
     Workspace *ws,
@@ -16,11 +16,14 @@
 #include "mace/flows/opencl/opencl_ref_flow.h"
 
 #include <memory>
+#include <set>
+#include <string>
 
 #include "mace/core/flow/flow_registry.h"
 #include "mace/runtimes/opencl/core/opencl_executor.h"
 #include "mace/runtimes/opencl/opencl_runtime.h"
 #include "mace/runtimes/opencl/transform/buffer_transformer.h"
+#include "mace/utils/mace_engine_config.h"
 
 namespace mace {
 
@@ -47,6 +50,54 @@ OpenclRefFlow::OpenclRefFlow(FlowContext *flow_context)
   VLOG(3) << "OpenclRefFlow::OpenclRefFlow";
 }
 
+MaceStatus OpenclRefFlow::Init(const NetDef *net_def,
+                               const unsigned char *model_data,
+                               const int64_t model_data_size,
+                               bool *model_data_unused) {
+  MACE_RETURN_IF_ERROR(CpuRefFlow::Init(net_def, model_data, model_data_size,
+                                        model_data_unused));
+  int build_threads = config_impl_->gpu_program_build_threads();
+  if (build_threads != 0) {
+    MACE_RETURN_IF_ERROR(BuildProgramsAhead(
+        build_threads, !config_impl_->gpu_program_build_background()));
+  }
+  return MaceStatus::MACE_SUCCESS;
+}
+
+MaceStatus OpenclRefFlow::BuildProgramsAhead(int num_threads, bool wait) {
+  auto *opencl_runtime = static_cast<OpenclRuntime *>(main_runtime_);
+  auto *opencl_executor = opencl_runtime->GetOpenclExecutor();
+  // An op stops at the first program not built yet, so its later programs
+  // show up once the former ones are built. Without waiting for the builds,
+  // those are left to the first run (and recorded for the next Init).
+  std::set<std::string> tried_keys;
+  while (true) {
+    opencl_executor->StartCollectingPrograms();
+    int failed_ops = net_->FakeWarmupEachOperator();
+    std::set<std::string> keys = opencl_executor->StopCollectingPrograms();
+    std::set<std::string> new_keys;
+    for (auto &key : keys) {
+      if (tried_keys.insert(key).second) {
+        new_keys.insert(key);
+      }
+    }
+    VLOG(1) << "Flow " << name_ << ": " << failed_ops << " ops need "
+            << new_keys.size() << " more OpenCL programs";
+    if (new_keys.empty()) {
+      break;
+    }
+    MACE_RETURN_IF_ERROR(opencl_executor->BuildProgramsInParallel(
+        new_keys, num_threads, wait));
+    if (!wait) {
+      break;
+    }
+  }
+  // The ops left halfway may have kept the input shapes without setting the
+  // kernel arguments.
+  main_runtime_->OnKernelArgsStale(GetMaceEngine());
+  return MaceStatus::MACE_SUCCESS;
+}
+
 MaceStatus OpenclRefFlow::TransposeInputByDims(
     const MaceTensor &mace_tensor,
     Tensor *input_tensor, const std::vector<int> &dst_dims) {
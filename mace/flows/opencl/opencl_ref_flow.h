@@ -28,6 +28,10 @@ class OpenclRefFlow : public CpuRefFlow {
   explicit OpenclRefFlow(FlowContext *flow_context);
   virtual ~OpenclRefFlow() = default;
 
+  MaceStatus Init(const NetDef *net_def,
+                  const unsigned char *model_data,
+                  const int64_t model_data_size,
+                  bool *model_data_unused) override;
   MaceStatus Run(TensorMap *input_tensors,
                  TensorMap *output_tensors,
                  RunMetadata *run_metadata) override;
@@ -47,6 +51,9 @@ class OpenclRefFlow : public CpuRefFlow {
 
  private:
   void AfterRun();
+  // Build the programs the ops of the net need on `num_threads` threads, see
+  // MaceEngineConfig::SetGPUProgramBuildPolicy.
+  MaceStatus BuildProgramsAhead(int num_threads, bool wait);
   MACE_DISABLE_COPY_AND_ASSIGN(OpenclRefFlow);
 };
 
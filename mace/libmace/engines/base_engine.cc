@@ -39,7 +39,8 @@ namespace mace {
 
 BaseEngine::BaseEngine(const MaceEngineConfig &config)
     : thread_pool_(new utils::ThreadPool(config.impl_->num_threads(),
-                                         config.impl_->cpu_affinity_policy())),
+                                         config.impl_->cpu_affinity_policy(),
+                                         config.impl_->numa_node())),
       model_data_(nullptr), op_registry_(new OpRegistry),
       op_delegator_registry_(new OpDelegatorRegistry),
       config_impl_(config.impl_) {
@@ -167,6 +168,34 @@ MaceStatus BaseEngine::AllocateIntermediateBuffer() {
   return MaceStatus::MACE_UNSUPPORTED;
 }
 
+MaceStatus BaseEngine::BindBuffers(
+    const std::map<std::string, MaceTensor> &inputs,
+    const std::map<std::string, MaceTensor> &outputs) {
+  MACE_UNUSED(inputs);
+  MACE_UNUSED(outputs);
+  LOG(WARNING) << "This engine does not support binding buffers";
+  return MaceStatus::MACE_UNSUPPORTED;
+}
+
+MaceStatus BaseEngine::SaveSnapshot(const std::string &snapshot_file) {
+  MACE_UNUSED(snapshot_file);
+  LOG(WARNING) << "This engine does not support snapshot";
+  return MaceStatus::MACE_UNSUPPORTED;
+}
+
+MaceStatus BaseEngine::GetCalibrationRanges(
+    std::map<std::string, std::pair<float, float>> *ranges) {
+  MACE_UNUSED(ranges);
+  LOG(WARNING) << "This engine does not support calibration";
+  return MaceStatus::MACE_UNSUPPORTED;
+}
+
+MaceStatus BaseEngine::SaveCalibrationRanges(const std::string &range_file) {
+  MACE_UNUSED(range_file);
+  LOG(WARNING) << "This engine does not support calibration";
+  return MaceStatus::MACE_UNSUPPORTED;
+}
+
 RuntimesMap &BaseEngine::GetRuntimesOfTutor(BaseEngine *tutor) {
   MACE_CHECK(!tutor->runtimes_.empty(),
              "Before using the tutor engine, you must init it.");
@@ -182,6 +211,15 @@ std::vector<RuntimeType> BaseEngine::GetRuntimeTypes() {
   return std::vector<RuntimeType>(runtime_types.begin(), runtime_types.end());
 }
 
+bool BaseEngine::IsRuntimesReady() {
+  for (auto &runtime : runtimes_) {
+    if (!runtime.second->IsReady()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 MaceStatus BaseEngine::Forward(const std::map<std::string, MaceTensor> &inputs,
                                std::map<std::string, MaceTensor> *outputs,
                                RunMetadata *run_metadata) {
@@ -18,6 +18,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "mace/core/registry/op_delegator_registry.h"
@@ -75,9 +76,17 @@ class BaseEngine {
 
   virtual MaceStatus ReleaseIntermediateBuffer();
   virtual MaceStatus AllocateIntermediateBuffer();
+  virtual MaceStatus BindBuffers(
+      const std::map<std::string, MaceTensor> &inputs,
+      const std::map<std::string, MaceTensor> &outputs);
+  virtual MaceStatus SaveSnapshot(const std::string &snapshot_file);
+  virtual MaceStatus GetCalibrationRanges(
+      std::map<std::string, std::pair<float, float>> *ranges);
+  virtual MaceStatus SaveCalibrationRanges(const std::string &range_file);
 
   RuntimesMap &GetRuntimesOfTutor(BaseEngine *tutor);
   std::vector<RuntimeType> GetRuntimeTypes();
+  bool IsRuntimesReady();
 
  protected:
   virtual MaceStatus BeforeRun();
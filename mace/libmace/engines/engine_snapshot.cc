@@ -0,0 +1,122 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/libmace/engines/engine_snapshot.h"
+
+#include <cstring>
+#include <memory>
+
+#include "mace/port/env.h"
+#include "mace/port/file_system.h"
+#include "mace/utils/logging.h"
+
+namespace mace {
+
+namespace {
+
+const char kSnapshotMagic[8] = {'M', 'A', 'C', 'E', 'S', 'N', 'A', 'P'};
+
+struct EngineSnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t graph_crc;
+  uint64_t graph_offset;
+  uint64_t graph_size;
+  // Kernels and weight layouts may change between builds, a snapshot is only
+  // restored by the same MACE version that saved it.
+  char mace_version[64];
+};
+
+static_assert(sizeof(EngineSnapshotHeader) <= kEngineSnapshotDataOffset,
+              "snapshot header should fit before the weights");
+
+}  // namespace
+
+MaceStatus WriteEngineSnapshot(const std::string &snapshot_file,
+                               const MultiNetDef &multi_net_def,
+                               std::vector<unsigned char> *data) {
+  MACE_CHECK(data->size() >= kEngineSnapshotDataOffset);
+  const size_t graph_size = multi_net_def.ByteSizeLong();
+  const size_t graph_offset = data->size();
+  data->resize(graph_offset + graph_size);
+  if (!multi_net_def.SerializeToArray(data->data() + graph_offset,
+                                      static_cast<int>(graph_size))) {
+    LOG(ERROR) << "Serialize the snapshot graph failed";
+    return MaceStatus::MACE_RUNTIME_ERROR;
+  }
+
+  EngineSnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+  header.version = kEngineSnapshotVersion;
+  header.graph_crc = CalculateCRC32(data->data() + graph_offset, graph_size);
+  header.graph_offset = graph_offset;
+  header.graph_size = graph_size;
+  strncpy(header.mace_version, MaceVersion(), sizeof(header.mace_version) - 1);
+  memcpy(data->data(), &header, sizeof(header));
+
+  std::unique_ptr<port::WritableFile> file;
+  MACE_RETURN_IF_ERROR(GetFileSystem()->NewWritableFile(
+      snapshot_file.c_str(), &file));
+  MACE_RETURN_IF_ERROR(file->Append(
+      reinterpret_cast<const char *>(data->data()), data->size()));
+  MACE_RETURN_IF_ERROR(file->Flush());
+  return file->Close();
+}
+
+MaceStatus ReadEngineSnapshot(const std::string &snapshot_file,
+                              MultiNetDef *multi_net_def) {
+  std::unique_ptr<port::ReadOnlyMemoryRegion> region;
+  MACE_RETURN_IF_ERROR(GetFileSystem()->NewReadOnlyMemoryRegionFromFile(
+      snapshot_file.c_str(), &region));
+  auto file_data = static_cast<const unsigned char *>(region->data());
+  const uint64_t file_size = region->length();
+
+  EngineSnapshotHeader header;
+  if (file_size < kEngineSnapshotDataOffset) {
+    LOG(ERROR) << snapshot_file << " is not a MACE engine snapshot";
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  memcpy(&header, file_data, sizeof(header));
+  if (memcmp(header.magic, kSnapshotMagic, sizeof(header.magic)) != 0) {
+    LOG(ERROR) << snapshot_file << " is not a MACE engine snapshot";
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  header.mace_version[sizeof(header.mace_version) - 1] = '\0';
+  if (header.version != kEngineSnapshotVersion ||
+      strcmp(header.mace_version, MaceVersion()) != 0) {
+    LOG(ERROR) << "Snapshot " << snapshot_file << " (format "
+               << header.version << ", MACE " << header.mace_version
+               << ") is not compatible with this build (format "
+               << kEngineSnapshotVersion << ", MACE " << MaceVersion()
+               << "), please save it again";
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  if (header.graph_offset < kEngineSnapshotDataOffset ||
+      header.graph_offset + header.graph_size > file_size) {
+    LOG(ERROR) << "Snapshot " << snapshot_file << " is truncated";
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  const unsigned char *graph = file_data + header.graph_offset;
+  if (CalculateCRC32(graph, header.graph_size) != header.graph_crc ||
+      !multi_net_def->ParseFromArray(graph,
+                                     static_cast<int>(header.graph_size))) {
+    LOG(ERROR) << "Snapshot " << snapshot_file << " is corrupted";
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
+}  // namespace mace
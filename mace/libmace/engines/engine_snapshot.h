@@ -0,0 +1,46 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_LIBMACE_ENGINES_ENGINE_SNAPSHOT_H_
+#define MACE_LIBMACE_ENGINES_ENGINE_SNAPSHOT_H_
+
+#include <string>
+#include <vector>
+
+#include "mace/proto/mace.pb.h"
+#include "mace/public/mace.h"
+
+namespace mace {
+
+// Snapshot file layout:
+//   [header][padding to kEngineSnapshotDataOffset][weights][graph]
+// The weights are laid out exactly as the flows hold them after Init, each
+// tensor aligned to kMaceAlignment, and the graph is a MultiNetDef whose
+// data offsets are absolute file offsets. So the file can be mmapped and
+// passed as model data directly, without any weight conversion.
+constexpr uint32_t kEngineSnapshotVersion = 1;
+constexpr size_t kEngineSnapshotDataOffset = 4096;
+
+// `data` holds the weights, starting at kEngineSnapshotDataOffset, the bytes
+// before are reserved for the header.
+MaceStatus WriteEngineSnapshot(const std::string &snapshot_file,
+                               const MultiNetDef &multi_net_def,
+                               std::vector<unsigned char> *data);
+
+MaceStatus ReadEngineSnapshot(const std::string &snapshot_file,
+                              MultiNetDef *multi_net_def);
+
+}  // namespace mace
+
+#endif  // MACE_LIBMACE_ENGINES_ENGINE_SNAPSHOT_H_
@@ -23,8 +23,10 @@
 #include <utility>
 #include <vector>
 
+#include "mace/core/net/calibration_observer.h"
 #include "mace/core/runtime/runtime.h"
 #include "mace/core/runtime/runtime_registry.h"
+#include "mace/libmace/engines/engine_snapshot.h"
 
 namespace mace {
 SerialEngine::SerialEngine(const MaceEngineConfig &config)
@@ -155,6 +157,109 @@ MaceStatus SerialEngine::AllocateIntermediateBuffer() {
   return MaceStatus::MACE_SUCCESS;
 }
 
+MaceStatus SerialEngine::BindBuffers(
+    const std::map<std::string, MaceTensor> &inputs,
+    const std::map<std::string, MaceTensor> &outputs) {
+  for (const auto &tensors : {&inputs, &outputs}) {
+    for (auto iter = tensors->begin(); iter != tensors->end(); ++iter) {
+      if (run_helper_.count(iter->first) == 0) {
+        LOG(ERROR) << "'" << iter->first
+                   << "' is not an input or output of the model";
+        return MaceStatus::MACE_INVALID_ARGS;
+      }
+    }
+  }
+
+  // Split the buffers by the flows reading or writing them
+  MaceStatus status = MaceStatus::MACE_SUCCESS;
+  for (auto &flow : flows_) {
+    const auto *flow_inputs = input_tensors_[flow.get()].get();
+    const auto *flow_outputs = output_tensors_[flow.get()].get();
+    MaceTensorInfo bound_inputs;
+    MaceTensorInfo bound_outputs;
+    for (auto iter = inputs.begin(); iter != inputs.end(); ++iter) {
+      if (run_helper_[iter->first].get() == flow_inputs) {
+        bound_inputs.emplace(*iter);
+      }
+    }
+    for (auto iter = outputs.begin(); iter != outputs.end(); ++iter) {
+      if (run_helper_[iter->first].get() == flow_outputs) {
+        bound_outputs.emplace(*iter);
+      }
+    }
+    status = flow->BindBuffers(bound_inputs, bound_outputs);
+    if (status != MaceStatus::MACE_SUCCESS) {
+      break;
+    }
+  }
+  if (status != MaceStatus::MACE_SUCCESS) {
+    for (auto &flow : flows_) {
+      flow->BindBuffers(MaceTensorInfo(), MaceTensorInfo());
+    }
+  }
+
+  // The bindings take effect at the next allocation
+  ReleaseIntermediateBuffer();
+  return status;
+}
+
+MaceStatus SerialEngine::SaveSnapshot(const std::string &snapshot_file) {
+  if (multi_net_def_ == nullptr) {
+    LOG(ERROR) << "Snapshot is not enabled by MaceEngineConfig, "
+               << "or the engine is not initialized";
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  MultiNetDef multi_net_def(*multi_net_def_);
+  multi_net_def.clear_input_tensor();
+  multi_net_def.clear_output_tensor();
+  for (const auto &input_node : input_nodes_) {
+    multi_net_def.add_input_tensor(input_node);
+  }
+  for (const auto &output_node : output_nodes_) {
+    multi_net_def.add_output_tensor(output_node);
+  }
+
+  // flows_ are created in the order of infer_order
+  std::map<int, NetDef *> net_defs;
+  for (int i = 0; i < multi_net_def.net_def_size(); ++i) {
+    NetDef *net_def = multi_net_def.mutable_net_def(i);
+    net_defs.emplace(net_def->infer_order(), net_def);
+  }
+  if (net_defs.size() != flows_.size()) {
+    LOG(ERROR) << "The engine has " << flows_.size() << " flows, but the graph"
+               << " has " << net_defs.size() << " nets";
+    return MaceStatus::MACE_RUNTIME_ERROR;
+  }
+  std::vector<unsigned char> data(kEngineSnapshotDataOffset, 0);
+  int k = 0;
+  for (auto iter = net_defs.begin(); iter != net_defs.end(); ++iter) {
+    MACE_RETURN_IF_ERROR(flows_[k++]->ExportWeights(iter->second, &data));
+  }
+
+  return WriteEngineSnapshot(snapshot_file, multi_net_def, &data);
+}
+
+MaceStatus SerialEngine::GetCalibrationRanges(
+    std::map<std::string, std::pair<float, float>> *ranges) {
+  if (calibration_observer_ == nullptr) {
+    LOG(ERROR) << "Calibration is not enabled by MaceEngineConfig";
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  std::vector<std::pair<std::string, CalibrationObserver::Range>> range_list;
+  calibration_observer_->GetRanges(&range_list);
+  ranges->clear();
+  ranges->insert(range_list.begin(), range_list.end());
+  return MaceStatus::MACE_SUCCESS;
+}
+
+MaceStatus SerialEngine::SaveCalibrationRanges(const std::string &range_file) {
+  if (calibration_observer_ == nullptr) {
+    LOG(ERROR) << "Calibration is not enabled by MaceEngineConfig";
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  return calibration_observer_->SaveRanges(range_file);
+}
+
 MaceStatus SerialEngine::CreateAndInitRuntimes(
     const NetDefMap &net_defs, NetRuntimeMap *runtime_map, BaseEngine *tutor) {
   // create runtime
@@ -430,6 +535,11 @@ MaceStatus SerialEngine::DoInit(
   std::unordered_map<const NetDef *, std::shared_ptr<Runtime>> runtime_map;
   MaceStatus ret = CreateAndInitRuntimes(net_defs, &runtime_map, tutor);
   MACE_RETURN_IF_ERROR(ret);
+  if (config_impl_->engine_snapshot()) {
+    multi_net_def_ = make_unique<MultiNetDef>(*multi_net_def);
+    input_nodes_ = input_nodes;
+    output_nodes_ = output_nodes;
+  }
 
   // create and init flows
   ret = CreateAndInitFlows(net_defs, runtime_map, model_data,
@@ -446,6 +556,16 @@ MaceStatus SerialEngine::DoInit(
   auto output_tensor_size = output_tensors_.size();
   MACE_CHECK(input_tensor_size == flow_num && output_tensor_size == flow_num);
 
+  if (config_impl_->calibration_method() !=
+      CalibrationMethod::CALIBRATION_NONE) {
+    calibration_observer_ = make_unique<CalibrationObserver>(
+        config_impl_->calibration_method(),
+        config_impl_->calibration_percentile(), thread_pool_.get());
+    for (auto &flow : flows_) {
+      flow->SetNetObserver(calibration_observer_.get());
+    }
+  }
+
   return MaceStatus::MACE_SUCCESS;
 }
 
@@ -19,6 +19,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "mace/core/flow/base_flow.h"
@@ -26,6 +27,9 @@
 #include "mace/public/mace.h"
 
 namespace mace {
+
+class CalibrationObserver;
+
 class SerialEngine : public BaseEngine {
  public:
   explicit SerialEngine(const MaceEngineConfig &config);
@@ -50,6 +54,13 @@ class SerialEngine : public BaseEngine {
 
   MaceStatus ReleaseIntermediateBuffer() override;
   MaceStatus AllocateIntermediateBuffer() override;
+  MaceStatus BindBuffers(
+      const std::map<std::string, MaceTensor> &inputs,
+      const std::map<std::string, MaceTensor> &outputs) override;
+  MaceStatus SaveSnapshot(const std::string &snapshot_file) override;
+  MaceStatus GetCalibrationRanges(
+      std::map<std::string, std::pair<float, float>> *ranges) override;
+  MaceStatus SaveCalibrationRanges(const std::string &range_file) override;
 
  protected:
   MaceStatus BeforeRun() override;
@@ -101,6 +112,14 @@ class SerialEngine : public BaseEngine {
 
   bool inter_mem_released_;
 
+  // The graph with runtimes resolved, kept for SaveSnapshot if it is enabled
+  std::unique_ptr<MultiNetDef> multi_net_def_;
+  std::vector<std::string> input_nodes_;
+  std::vector<std::string> output_nodes_;
+
+  // Observes the flows when calibration is enabled
+  std::unique_ptr<CalibrationObserver> calibration_observer_;
+
   MACE_DISABLE_COPY_AND_ASSIGN(SerialEngine);
 };
 
@@ -14,6 +14,7 @@
 
 #include "mace/libmace/engines/base_engine.h"
 #include "mace/libmace/engines/engine_registry.h"
+#include "mace/libmace/engines/engine_snapshot.h"
 #include "mace/port/logger.h"
 #include "mace/port/port.h"
 #include "mace/public/mace.h"
@@ -66,6 +67,18 @@ class MaceEngine::Impl {
 
   MaceStatus ReleaseIntermediateBuffer();
 
+  MaceStatus BindBuffers(const std::map<std::string, MaceTensor> &inputs,
+                         const std::map<std::string, MaceTensor> &outputs);
+
+  MaceStatus SaveSnapshot(const std::string &snapshot_file);
+
+  MaceStatus GetCalibrationRanges(
+      std::map<std::string, std::pair<float, float>> *ranges);
+
+  MaceStatus SaveCalibrationRanges(const std::string &range_file);
+
+  bool IsGPUReady();
+
   std::vector<RuntimeType> GetRuntimeTypes();
 
  private:
@@ -146,6 +159,30 @@ MaceStatus MaceEngine::Impl::ReleaseIntermediateBuffer() {
   return engine_->ReleaseIntermediateBuffer();
 }
 
+MaceStatus MaceEngine::Impl::BindBuffers(
+    const std::map<std::string, MaceTensor> &inputs,
+    const std::map<std::string, MaceTensor> &outputs) {
+  return engine_->BindBuffers(inputs, outputs);
+}
+
+MaceStatus MaceEngine::Impl::SaveSnapshot(const std::string &snapshot_file) {
+  return engine_->SaveSnapshot(snapshot_file);
+}
+
+MaceStatus MaceEngine::Impl::GetCalibrationRanges(
+    std::map<std::string, std::pair<float, float>> *ranges) {
+  return engine_->GetCalibrationRanges(ranges);
+}
+
+MaceStatus MaceEngine::Impl::SaveCalibrationRanges(
+    const std::string &range_file) {
+  return engine_->SaveCalibrationRanges(range_file);
+}
+
+bool MaceEngine::Impl::IsGPUReady() {
+  return engine_->IsRuntimesReady();
+}
+
 std::vector<RuntimeType> MaceEngine::Impl::GetRuntimeTypes() {
   return engine_->GetRuntimeTypes();
 }
@@ -225,6 +262,28 @@ MaceStatus MaceEngine::ReleaseIntermediateBuffer() {
   return impl_->ReleaseIntermediateBuffer();
 }
 
+MaceStatus MaceEngine::BindBuffers(
+    const std::map<std::string, MaceTensor> &inputs,
+    const std::map<std::string, MaceTensor> &outputs) {
+  return impl_->BindBuffers(inputs, outputs);
+}
+
+MaceStatus MaceEngine::SaveSnapshot(const std::string &snapshot_file) {
+  return impl_->SaveSnapshot(snapshot_file);
+}
+
+MaceStatus MaceEngine::GetCalibrationRanges(
+    std::map<std::string, std::pair<float, float>> *ranges) {
+  return impl_->GetCalibrationRanges(ranges);
+}
+
+MaceStatus MaceEngine::SaveCalibrationRanges(const std::string &range_file) {
+  return impl_->SaveCalibrationRanges(range_file);
+}
+
+bool MaceEngine::IsGPUReady() {
+  return impl_->IsGPUReady();
+}
 
 std::vector<RuntimeType> MaceEngine::GetRuntimeTypes() {
   return impl_->GetRuntimeTypes();
@@ -273,6 +332,33 @@ MaceStatus CreateMaceEngineFromProto(
   return status;
 }
 
+MaceStatus CreateMaceEngineFromSnapshot(
+    const std::string &snapshot_file,
+    const MaceEngineConfig &config,
+    std::shared_ptr<MaceEngine> *engine,
+    MaceEngine *tutor) {
+  VLOG(1) << "Create MaceEngine from snapshot " << snapshot_file;
+
+  if (engine == nullptr) {
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+
+  auto multi_net_def = std::make_shared<MultiNetDef>();
+  MACE_RETURN_IF_ERROR(ReadEngineSnapshot(snapshot_file,
+                                          multi_net_def.get()));
+  std::vector<std::string> input_nodes(multi_net_def->input_tensor().begin(),
+                                       multi_net_def->input_tensor().end());
+  std::vector<std::string> output_nodes(
+      multi_net_def->output_tensor().begin(),
+      multi_net_def->output_tensor().end());
+
+  // The data offsets in the snapshot graph are file offsets, so the whole
+  // file is mapped as model data.
+  engine->reset(new mace::MaceEngine(config));
+  return (*engine)->Init(multi_net_def.get(), input_nodes, output_nodes,
+                         snapshot_file, tutor);
+}
+
 // Deprecated, will be removed in future version.
 MaceStatus CreateMaceEngineFromProto(
     const std::vector<unsigned char> &model_pb,
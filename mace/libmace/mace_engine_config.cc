@@ -25,9 +25,18 @@ namespace mace {
 MaceEngineCfgImpl::MaceEngineCfgImpl()
     : num_threads_(-1),
       cpu_affinity_policy_(CPUAffinityPolicy::AFFINITY_NONE),
+      cpu_memory_policy_(CPUMemoryPolicy::CPU_MEMORY_DEFAULT),
+      numa_node_(-1),
+      weight_sharing_(false),
+      engine_snapshot_(false),
+      calibration_method_(CalibrationMethod::CALIBRATION_NONE),
+      calibration_percentile_(99.99f),
       opencl_context_(nullptr),
       gpu_priority_hint_(GPUPriorityHint::PRIORITY_LOW),
       gpu_perf_hint_(GPUPerfHint::PERF_NORMAL),
+      gpu_program_build_threads_(0),
+      gpu_program_build_background_(false),
+      gpu_command_replay_(false),
       hexagon_corner_(HexagonNNCornerType::HEXAGON_NN_CORNER_TURBO),
       hexagon_dcvs_enable_(true),
       hexagon_latency_(100),
@@ -52,6 +61,36 @@ CPUAffinityPolicy MaceEngineCfgImpl::cpu_affinity_policy() const {
   return cpu_affinity_policy_;
 }
 
+CPUMemoryPolicy MaceEngineCfgImpl::cpu_memory_policy() const {
+  return cpu_memory_policy_;
+}
+
+int MaceEngineCfgImpl::numa_node() const {
+  return numa_node_;
+}
+
+bool MaceEngineCfgImpl::weight_sharing() const {
+  return weight_sharing_;
+}
+
+bool MaceEngineCfgImpl::engine_snapshot() const {
+  return engine_snapshot_;
+}
+
+CalibrationMethod MaceEngineCfgImpl::calibration_method() const {
+  return calibration_method_;
+}
+
+float MaceEngineCfgImpl::calibration_percentile() const {
+  return calibration_percentile_;
+}
+
+const InputPreprocess *MaceEngineCfgImpl::input_preprocess(
+    const std::string &input_name) const {
+  auto iter = input_preprocess_.find(input_name);
+  return iter == input_preprocess_.end() ? nullptr : &iter->second;
+}
+
 std::shared_ptr<OpenclContext> MaceEngineCfgImpl::opencl_context() const {
   return opencl_context_;
 }
@@ -64,6 +103,18 @@ GPUPerfHint MaceEngineCfgImpl::gpu_perf_hint() const {
   return gpu_perf_hint_;
 }
 
+int MaceEngineCfgImpl::gpu_program_build_threads() const {
+  return gpu_program_build_threads_;
+}
+
+bool MaceEngineCfgImpl::gpu_program_build_background() const {
+  return gpu_program_build_background_;
+}
+
+bool MaceEngineCfgImpl::gpu_command_replay() const {
+  return gpu_command_replay_;
+}
+
 HexagonNNCornerType MaceEngineCfgImpl::hexagon_corner() const {
   return hexagon_corner_;
 }
@@ -125,6 +176,18 @@ MaceStatus MaceEngineCfgImpl::SetGPUHints(
   return MaceStatus::MACE_SUCCESS;
 }
 
+MaceStatus MaceEngineCfgImpl::SetGPUProgramBuildPolicy(int num_threads,
+                                                       bool background) {
+  gpu_program_build_threads_ = num_threads;
+  gpu_program_build_background_ = background;
+  return MaceStatus::MACE_SUCCESS;
+}
+
+MaceStatus MaceEngineCfgImpl::SetGPUCommandReplay(bool enable) {
+  gpu_command_replay_ = enable;
+  return MaceStatus::MACE_SUCCESS;
+}
+
 MaceStatus MaceEngineCfgImpl::SetCPUThreadPolicy(
     int num_threads,
     CPUAffinityPolicy policy) {
@@ -133,6 +196,58 @@ MaceStatus MaceEngineCfgImpl::SetCPUThreadPolicy(
   return MaceStatus::MACE_SUCCESS;
 }
 
+MaceStatus MaceEngineCfgImpl::SetCPUMemoryPolicy(CPUMemoryPolicy policy,
+                                                 int numa_node) {
+  cpu_memory_policy_ = policy;
+  numa_node_ = numa_node < 0 ? -1 : numa_node;
+  return MaceStatus::MACE_SUCCESS;
+}
+
+MaceStatus MaceEngineCfgImpl::SetWeightSharing(bool enable) {
+  weight_sharing_ = enable;
+  return MaceStatus::MACE_SUCCESS;
+}
+
+MaceStatus MaceEngineCfgImpl::SetEngineSnapshot(bool enable) {
+  engine_snapshot_ = enable;
+  return MaceStatus::MACE_SUCCESS;
+}
+
+MaceStatus MaceEngineCfgImpl::SetCalibration(CalibrationMethod method,
+                                             float percentile) {
+  if (percentile <= 50.f || percentile > 100.f) {
+    LOG(ERROR) << "The calibration percentile should be in (50, 100], but "
+               << percentile << " is given";
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  calibration_method_ = method;
+  calibration_percentile_ = percentile;
+  return MaceStatus::MACE_SUCCESS;
+}
+
+MaceStatus MaceEngineCfgImpl::SetInputPreprocess(
+    const std::string &input_name, const InputPreprocess &preprocess) {
+  if (preprocess.crop_top < 0 || preprocess.crop_left < 0 ||
+      preprocess.crop_height < 0 || preprocess.crop_width < 0) {
+    LOG(ERROR) << "Invalid crop window of input " << input_name;
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  if (!preprocess.mean.empty() && !preprocess.std.empty() &&
+      preprocess.mean.size() != preprocess.std.size()) {
+    LOG(ERROR) << "The mean and std of input " << input_name
+               << " have different channels";
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  for (float std : preprocess.std) {
+    if (std == 0.f) {
+      LOG(ERROR) << "The std of input " << input_name << " has zero";
+      return MaceStatus::MACE_INVALID_ARGS;
+    }
+  }
+  input_preprocess_[input_name] = preprocess;
+  return MaceStatus::MACE_SUCCESS;
+}
+
 MaceStatus MaceEngineCfgImpl::SetHexagonToUnsignedPD() {
   bool ret = false;
 #ifdef MACE_ENABLE_HEXAGON
@@ -216,12 +331,44 @@ MaceStatus MaceEngineConfig::SetGPUHints(
   return impl_->SetGPUHints(perf_hint, priority_hint);
 }
 
+MaceStatus MaceEngineConfig::SetGPUProgramBuildPolicy(int num_threads,
+                                                      bool background) {
+  return impl_->SetGPUProgramBuildPolicy(num_threads, background);
+}
+
+MaceStatus MaceEngineConfig::SetGPUCommandReplay(bool enable) {
+  return impl_->SetGPUCommandReplay(enable);
+}
+
 MaceStatus MaceEngineConfig::SetCPUThreadPolicy(
     int num_threads_hint,
     CPUAffinityPolicy policy) {
   return impl_->SetCPUThreadPolicy(num_threads_hint, policy);
 }
 
+MaceStatus MaceEngineConfig::SetCPUMemoryPolicy(CPUMemoryPolicy policy,
+                                                int numa_node) {
+  return impl_->SetCPUMemoryPolicy(policy, numa_node);
+}
+
+MaceStatus MaceEngineConfig::SetWeightSharing(bool enable) {
+  return impl_->SetWeightSharing(enable);
+}
+
+MaceStatus MaceEngineConfig::SetEngineSnapshot(bool enable) {
+  return impl_->SetEngineSnapshot(enable);
+}
+
+MaceStatus MaceEngineConfig::SetCalibration(CalibrationMethod method,
+                                            float percentile) {
+  return impl_->SetCalibration(method, percentile);
+}
+
+MaceStatus MaceEngineConfig::SetInputPreprocess(
+    const std::string &input_name, const InputPreprocess &preprocess) {
+  return impl_->SetInputPreprocess(input_name, preprocess);
+}
+
 MaceStatus MaceEngineConfig::SetHexagonToUnsignedPD() {
   return impl_->SetHexagonToUnsignedPD();
 }
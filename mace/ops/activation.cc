@@ -73,6 +73,10 @@ class ActivationOp<RuntimeType::RT_CPU, T> : public Operation {
     return MaceStatus::MACE_SUCCESS;
   }
 
+  bool SupportsInPlace(size_t output_idx, size_t input_idx) const override {
+    return output_idx == 0 && input_idx == 0;
+  }
+
  private:
   ActivationType activation_type_;
   std::unique_ptr<delegator::Activation> activation_delegator_;
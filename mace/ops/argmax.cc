@@ -20,6 +20,7 @@
 
 #include "mace/core/ops/operator.h"
 #include "mace/core/registry/ops_registry.h"
+#include "mace/ops/common/top_k.h"
 
 namespace mace {
 namespace ops {
@@ -40,7 +41,6 @@ class ArgMaxOp : public Operation {
         keep_dims_(Operation::GetOptionalArg<bool>("keepdims", true)) {}
 
   MaceStatus Run(OpContext *context) override {
-    MACE_UNUSED(context);
     const Tensor *input = this->Input(0);
     Tensor *output = this->Output(0);
 
@@ -49,64 +49,51 @@ class ArgMaxOp : public Operation {
     const auto axis_value = GetAxisValue(input_dim_size);
     MACE_RETURN_IF_ERROR(ResizeOutputTensor(output, input, axis_value));
 
-    auto input_data = input->data<T>();
-
-    int axis_dim = 0;
-    int axis_dist = 0;
+    index_t axis_dim = 0;
+    index_t axis_dist = 0;
     const auto &input_shape = input->shape();
     if (axis_value != 0) {
       axis_dim = input->dim(axis_value);
       axis_dist = std::accumulate(input_shape.begin() + axis_value,
                                   input_shape.end(),
-                                  1, std::multiplies<int>()) / axis_dim;
+                                  1, std::multiplies<index_t>()) / axis_dim;
     } else {
       axis_dim = input->dim(0);
       axis_dist = 1;
     }
     const auto output_loop = input->size() / axis_dim;
 
-    for (int i = 0; i < output_loop; i += 1) {
-      std::vector<std::pair<T, int>> input_data_vector(axis_dim);
-      const auto axis_base = i / axis_dist * axis_dim;
-      const auto axis_offset = i % axis_dist;
-      for (int d = 0; d < axis_dim; ++d) {
-        const auto input_idx = (axis_base + d) * axis_dist + axis_offset;
-        input_data_vector[d] = std::make_pair(input_data[input_idx], d);
-      }
-
-      if (argmin_) {
-        std::partial_sort(input_data_vector.begin(),
-                          input_data_vector.begin() + top_k_,
-                          input_data_vector.end(),
-                          std::less<std::pair<T, int>>());
-      } else {
-        std::partial_sort(input_data_vector.begin(),
-                          input_data_vector.begin() + top_k_,
-                          input_data_vector.end(),
-                          std::greater<std::pair<T, int>>());
-      }
+    const float *rows = TopKRows(input->data<T>(), output_loop / axis_dist,
+                                 axis_dim, axis_dist, &rows_buffer_);
+    candidates_.resize(output_loop * top_k_);
+    TopKSelector selector(top_k_, !argmin_, true);
+    selector.Select(&context->runtime()->thread_pool(), rows, output_loop,
+                    axis_dim, candidates_.data());
 
+    for (index_t i = 0; i < output_loop; i += 1) {
+      const TopKCandidate *top_k = candidates_.data() + i * top_k_;
+      const auto axis_offset = i % axis_dist;
       if (!out_val_) {
         auto output_data = output->mutable_data<int32_t>();
         const auto top_k_base = i / axis_dist * top_k_;
         for (int j = 0; j < top_k_; ++j) {
           const auto output_idx = (top_k_base + j) * axis_dist + axis_offset;
-          output_data[output_idx] = input_data_vector[j].second;
+          output_data[output_idx] = top_k[j].index;
         }
       } else if (has_axis_) {  // Produces max/min value per axis
         auto output_data = output->mutable_data<T>();
         const auto top_k_base = i / axis_dist * top_k_;
         for (int j = 0; j < top_k_; ++j) {
           auto output_idx = (top_k_base + j) * axis_dist + axis_offset;
-          output_data[output_idx] = input_data_vector[j].first;
+          output_data[output_idx] = static_cast<T>(top_k[j].value);
         }
       } else {  // Produces max_ind and max/min value
         auto output_data = output->mutable_data<T>();
         const auto top_k_base_pos = 2 * i * top_k_;
         const auto top_k_base_value = top_k_base_pos + top_k_;
         for (int j = 0; j < top_k_; ++j) {
-          output_data[top_k_base_pos + j] = input_data_vector[j].second;
-          output_data[top_k_base_value + j] = input_data_vector[j].first;
+          output_data[top_k_base_pos + j] = static_cast<T>(top_k[j].index);
+          output_data[top_k_base_value + j] = static_cast<T>(top_k[j].value);
         }
       }
     }
@@ -182,6 +169,9 @@ class ArgMaxOp : public Operation {
 
   // for ONNX
   const bool keep_dims_;
+
+  std::vector<float> rows_buffer_;
+  std::vector<TopKCandidate> candidates_;
 };
 
 void RegisterArgMax(OpRegistry *op_registry) {
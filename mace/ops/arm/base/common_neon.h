@@ -75,6 +75,16 @@ inline float32x4_t neon_vfma_lane_3(float32x4_t a,
 #endif
 }
 
+inline float32x4_t neon_vfma_n(float32x4_t a,
+                               float32x4_t b,
+                               float c) {
+#ifdef __aarch64__
+  return vfmaq_n_f32(a, b, c);
+#else
+  return vmlaq_n_f32(a, b, c);
+#endif
+}
+
 inline void neon_vec_left_shift_1(const float32x4_t &src,
                                   float32x4_t *dst) {
   (*dst)[0] = src[1];
@@ -0,0 +1,198 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/ops/arm/base/conv_2d_3x3_dilated_winograd.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "mace/core/runtime/runtime.h"
+#include "mace/utils/memory.h"
+
+namespace mace {
+namespace ops {
+namespace arm {
+
+template<typename T>
+MaceStatus Conv2dK3x3DilatedWinograd<T>::Compute(const OpContext *context,
+                                                 const Tensor *input,
+                                                 const Tensor *filter,
+                                                 Tensor *output) {
+  std::vector<index_t> output_shape(4);
+  std::vector<int> paddings(2);
+  CalOutputShapeAndInputPadSize(input->shape(), filter->shape(),
+                                &output_shape, &paddings);
+  MACE_RETURN_IF_ERROR(output->Resize(output_shape));
+
+  const index_t batch = input->dim(0);
+  const index_t in_channels = input->dim(1);
+  const index_t out_channels = output_shape[1];
+  // All the sub-images have the size of the largest one, the extra outputs
+  // are dropped.
+  const index_t sub_batch = batch * dilations_[0] * dilations_[1];
+  const index_t sub_out_height = RoundUpDiv<index_t>(output_shape[2],
+                                                     dilations_[0]);
+  const index_t sub_out_width = RoundUpDiv<index_t>(output_shape[3],
+                                                    dilations_[1]);
+
+  Runtime *runtime = context->runtime();
+  std::vector<index_t> sub_input_shape =
+      {sub_batch, in_channels, sub_out_height + 2, sub_out_width + 2};
+  std::unique_ptr<Tensor> sub_input = make_unique<Tensor>(
+      runtime, input->dtype(), MemoryType::CPU_BUFFER, sub_input_shape);
+  runtime->AllocateBufferForTensor(sub_input.get(), RENT_SCRATCH);
+  std::vector<index_t> sub_output_shape =
+      {sub_batch, out_channels, sub_out_height, sub_out_width};
+  std::unique_ptr<Tensor> sub_output = make_unique<Tensor>(
+      runtime, output->dtype(), MemoryType::CPU_BUFFER, sub_output_shape);
+  runtime->AllocateBufferForTensor(sub_output.get(), RENT_SCRATCH);
+
+  SpaceToBatch(context, input, paddings[0] >> 1, paddings[1] >> 1,
+               sub_input.get());
+  if (winograd_conv2d_ == nullptr) {
+    winograd_conv2d_ = delegator::Conv2d::Create(
+        context->workspace(),
+        MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU,
+                              T, ImplType::NEON, K3x3Winograd),
+        delegator::Conv2dParam(unit_strides_, unit_dilations_,
+                               no_paddings_, Padding::VALID));
+  }
+  MACE_RETURN_IF_ERROR(winograd_conv2d_->Compute(
+      context, sub_input.get(), filter, sub_output.get()));
+  BatchToSpace(context, sub_output.get(), output);
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
+// Sub-image (ph, pw) of an image holds the pixels (ph + i * dh, pw + j * dw)
+// of the padded input.
+template<typename T>
+void Conv2dK3x3DilatedWinograd<T>::SpaceToBatch(const OpContext *context,
+                                                const Tensor *input,
+                                                const int pad_top,
+                                                const int pad_left,
+                                                Tensor *sub_input) {
+  const index_t in_channels = input->dim(1);
+  const index_t in_height = input->dim(2);
+  const index_t in_width = input->dim(3);
+  const index_t sub_batch = sub_input->dim(0);
+  const index_t sub_height = sub_input->dim(2);
+  const index_t sub_width = sub_input->dim(3);
+  const index_t dilation_h = dilations_[0];
+  const index_t dilation_w = dilations_[1];
+  const index_t in_image_size = in_height * in_width;
+  const index_t sub_image_size = sub_height * sub_width;
+
+  const T *input_data = input->data<T>();
+  T *sub_input_data = sub_input->mutable_data<T>();
+
+  utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+  thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
+                            index_t start1, index_t end1, index_t step1) {
+    for (index_t n = start0; n < end0; n += step0) {
+      const index_t b = n / (dilation_h * dilation_w);
+      const index_t ph = (n / dilation_w) % dilation_h;
+      const index_t pw = n % dilation_w;
+      // the sub-image columns in [w_begin, w_end) are inside the input
+      const index_t w_offset = pw - pad_left;
+      const index_t w_begin = w_offset >= 0 ? 0 :
+          std::min(RoundUpDiv(-w_offset, dilation_w), sub_width);
+      const index_t w_end = w_offset >= in_width ? w_begin :
+          std::max(w_begin, std::min(
+              (in_width - 1 - w_offset) / dilation_w + 1, sub_width));
+      for (index_t c = start1; c < end1; c += step1) {
+        const T *in_base =
+            input_data + (b * in_channels + c) * in_image_size;
+        T *sub_ptr = sub_input_data + (n * in_channels + c) * sub_image_size;
+        for (index_t h = 0; h < sub_height; ++h) {
+          const index_t ih = ph + h * dilation_h - pad_top;
+          if (ih < 0 || ih >= in_height) {
+            std::fill_n(sub_ptr, sub_width, static_cast<T>(0.f));
+          } else {
+            const T *in_ptr = in_base + ih * in_width + w_offset;
+            std::fill_n(sub_ptr, w_begin, static_cast<T>(0.f));
+            for (index_t w = w_begin; w < w_end; ++w) {
+              sub_ptr[w] = in_ptr[w * dilation_w];
+            }
+            std::fill_n(sub_ptr + w_end, sub_width - w_end,
+                        static_cast<T>(0.f));
+          }
+          sub_ptr += sub_width;
+        }  // h
+      }  // c
+    }  // n
+  }, 0, sub_batch, 1, 0, in_channels, 1);
+}
+
+template<typename T>
+void Conv2dK3x3DilatedWinograd<T>::BatchToSpace(const OpContext *context,
+                                                const Tensor *sub_output,
+                                                Tensor *output) {
+  const index_t batch = output->dim(0);
+  const index_t out_channels = output->dim(1);
+  const index_t out_height = output->dim(2);
+  const index_t out_width = output->dim(3);
+  const index_t sub_height = sub_output->dim(2);
+  const index_t sub_width = sub_output->dim(3);
+  const index_t dilation_h = dilations_[0];
+  const index_t dilation_w = dilations_[1];
+  const index_t out_image_size = out_height * out_width;
+  const index_t sub_image_size = sub_height * sub_width;
+
+  const T *sub_output_data = sub_output->data<T>();
+  T *output_data = output->mutable_data<T>();
+
+  utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+  thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
+                            index_t start1, index_t end1, index_t step1) {
+    for (index_t b = start0; b < end0; b += step0) {
+      for (index_t m = start1; m < end1; m += step1) {
+        T *out_ptr = output_data + (b * out_channels + m) * out_image_size;
+        for (index_t h = 0; h < out_height; ++h) {
+          const index_t ph = h % dilation_h;
+          const index_t sub_h = h / dilation_h;
+          for (index_t pw = 0; pw < dilation_w; ++pw) {
+            const index_t n = (b * dilation_h + ph) * dilation_w + pw;
+            const T *sub_ptr = sub_output_data
+                + (n * out_channels + m) * sub_image_size
+                + sub_h * sub_width;
+            for (index_t w = pw, sub_w = 0; w < out_width;
+                 w += dilation_w, ++sub_w) {
+              out_ptr[w] = sub_ptr[sub_w];
+            }
+          }  // pw
+          out_ptr += out_width;
+        }  // h
+      }  // m
+    }  // b
+  }, 0, batch, 1, 0, out_channels, 1);
+}
+
+void RegisterConv2dK3x3DilatedWinogradDelegator(
+    OpDelegatorRegistry *registry) {
+  MACE_REGISTER_DELEGATOR(
+      registry, Conv2dK3x3DilatedWinograd<float>, delegator::Conv2dParam,
+      MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU,
+                            float, ImplType::NEON, K3x3DilatedWinograd));
+
+  MACE_REGISTER_BF16_DELEGATOR(
+      registry, Conv2dK3x3DilatedWinograd<BFloat16>, delegator::Conv2dParam,
+      MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU,
+                            BFloat16, ImplType::NEON, K3x3DilatedWinograd));
+}
+
+}  // namespace arm
+}  // namespace ops
+}  // namespace mace
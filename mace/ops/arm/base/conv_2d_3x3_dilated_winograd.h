@@ -0,0 +1,70 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_ARM_BASE_CONV_2D_3X3_DILATED_WINOGRAD_H_
+#define MACE_OPS_ARM_BASE_CONV_2D_3X3_DILATED_WINOGRAD_H_
+
+#include <memory>
+#include <vector>
+
+#include "mace/core/ops/op_context.h"
+#include "mace/core/tensor.h"
+#include "mace/ops/arm/base/conv_2d.h"
+#include "mace/public/mace.h"
+
+namespace mace {
+namespace ops {
+namespace arm {
+
+// A stride 1 3x3 convolution with dilations (dh, dw) is dh x dw independent
+// dense 3x3 convolutions of the sub-images sampled with steps (dh, dw)
+// (space to batch), which run as one batch of the winograd convolution and
+// are interleaved back into the output (batch to space).
+template<typename T>
+class Conv2dK3x3DilatedWinograd : public Conv2dBase {
+ public:
+  explicit Conv2dK3x3DilatedWinograd(const delegator::Conv2dParam &param)
+      : Conv2dBase(param, sizeof(T)),
+        unit_strides_({1, 1}),
+        unit_dilations_({1, 1}) {}
+  virtual ~Conv2dK3x3DilatedWinograd() {}
+
+  MaceStatus Compute(
+      const OpContext *context,
+      const Tensor *input,
+      const Tensor *filter,
+      Tensor *output) override;
+
+ private:
+  void SpaceToBatch(const OpContext *context,
+                    const Tensor *input,
+                    const int pad_top,
+                    const int pad_left,
+                    Tensor *sub_input);
+
+  void BatchToSpace(const OpContext *context,
+                    const Tensor *sub_output,
+                    Tensor *output);
+
+  const std::vector<int> unit_strides_;
+  const std::vector<int> unit_dilations_;
+  const std::vector<int> no_paddings_;
+  std::unique_ptr<delegator::Conv2d> winograd_conv2d_;
+};
+
+}  // namespace arm
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_ARM_BASE_CONV_2D_3X3_DILATED_WINOGRAD_H_
@@ -119,28 +119,45 @@ MaceStatus Conv2dK3x3Winograd<T>::Compute(const OpContext *context,
 
   if (!filter->is_weight() || out_tile_size != out_tile_size_) {
     out_tile_size_ = out_tile_size;
-    auto filter_shape = {in_tile_area, out_channels, in_channels};
-    transformed_filter_.reset(new Tensor(runtime, DataTypeToEnum<T>::v(),
-                                         mem_type, filter_shape));
-    runtime->AllocateBufferForTensor(transformed_filter_.get(), RENT_PRIVATE);
+    std::vector<index_t> filter_shape = {in_tile_area, out_channels,
+                                         in_channels};
+    // A weight is transformed once into the workspace, so that snapshots
+    // keep the transformed filter and restored engines skip the transform
+    bool filled = false;
+    transformed_filter_ = nullptr;
+    if (filter->is_weight() && !filter->name().empty()) {
+      transformed_filter_ = context->workspace()->GetPackedWeight(
+          MakeString(filter->name(), "_winograd_", out_tile_size), runtime,
+          DataTypeToEnum<T>::v(), filter_shape, &filled);
+    }
+    if (transformed_filter_ == nullptr) {
+      private_filter_.reset(new Tensor(runtime, DataTypeToEnum<T>::v(),
+                                       mem_type, filter_shape));
+      runtime->AllocateBufferForTensor(private_filter_.get(), RENT_PRIVATE);
+      transformed_filter_ = private_filter_.get();
+    } else {
+      private_filter_.reset();
+    }
     auto transformed_filter_data = transformed_filter_->mutable_data<T>();
 
-    switch (out_tile_size) {
-      case 2:
-        TransformFilter4x4(context,
-                           filter_data,
-                           in_channels,
-                           out_channels,
-                           transformed_filter_data);
-        break;
-      case 6:
-        TransformFilter8x8(context,
-                           filter_data,
-                           in_channels,
-                           out_channels,
-                           transformed_filter_data);
-        break;
-      default:MACE_NOT_IMPLEMENTED;
+    if (!filled) {
+      switch (out_tile_size) {
+        case 2:
+          TransformFilter4x4(context,
+                             filter_data,
+                             in_channels,
+                             out_channels,
+                             transformed_filter_data);
+          break;
+        case 6:
+          TransformFilter8x8(context,
+                             filter_data,
+                             in_channels,
+                             out_channels,
+                             transformed_filter_data);
+          break;
+        default:MACE_NOT_IMPLEMENTED;
+      }
     }
   }
 
@@ -189,7 +206,7 @@ MaceStatus Conv2dK3x3Winograd<T>::Compute(const OpContext *context,
     transformed_out_this_batch.Clear();
 
     gemm_.Compute(context,
-                  transformed_filter_.get(),
+                  transformed_filter_,
                   &transformed_in_this_batch,
                   in_tile_area,
                   out_channels,
@@ -95,7 +95,9 @@ class Conv2dK3x3Winograd : public Conv2dBase {
                           T *output);
 
   Gemm<T> gemm_;
-  std::unique_ptr<Tensor> transformed_filter_;
+  // In the workspace if the filter is a weight, else in private_filter_
+  Tensor *transformed_filter_;
+  std::unique_ptr<Tensor> private_filter_;
   index_t out_tile_size_;
 };
 
@@ -0,0 +1,261 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/ops/arm/base/conv_2d_dilated.h"
+
+#include "mace/ops/arm/base/common_neon.h"
+
+namespace mace {
+namespace ops {
+namespace arm {
+
+template<typename T>
+MaceStatus Conv2dK3x3Dilated<T>::DoCompute(
+    const ConvComputeParam &p, const T *filter_data,
+    const T *input_data, T *output_data) {
+  const index_t dilation_h = this->dilations_[0];
+  const index_t dilation_w = this->dilations_[1];
+  const index_t row_offset1 = dilation_h * p.in_width;
+  const index_t row_offset2 = 2 * row_offset1;
+
+  p.thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
+                              index_t start1, index_t end1, index_t step1) {
+    for (index_t b = start0; b < end0; b += step0) {
+      for (index_t m = start1; m < end1; m += step1) {
+        if (m + 3 < p.out_channels) {
+          T *out_ptr0_base =
+              output_data + b * p.out_batch_size + m * p.out_image_size;
+          T *out_ptr1_base = out_ptr0_base + p.out_image_size;
+          T *out_ptr2_base = out_ptr1_base + p.out_image_size;
+          T *out_ptr3_base = out_ptr2_base + p.out_image_size;
+          for (index_t h = 0; h < p.out_height; ++h) {
+            for (index_t w = 0; w + 3 < p.out_width; w += 4) {
+              const index_t out_offset = h * p.out_width + w;
+              // output (4 outch x 1 height x 4 width): vo_outch
+              float32x4_t vo0 = vdupq_n_f32(0.f);
+              float32x4_t vo1 = vdupq_n_f32(0.f);
+              float32x4_t vo2 = vdupq_n_f32(0.f);
+              float32x4_t vo3 = vdupq_n_f32(0.f);
+              const T *in_ptr =
+                  input_data + b * p.in_batch_size + h * p.in_width + w;
+              const T *filter_ptr0 = filter_data + m * p.in_channels * 9;
+              const T *filter_ptr1 = filter_ptr0 + p.in_channels * 9;
+              const T *filter_ptr2 = filter_ptr1 + p.in_channels * 9;
+              const T *filter_ptr3 = filter_ptr2 + p.in_channels * 9;
+              for (index_t c = 0; c < p.in_channels; ++c) {
+                const T *row_ptrs[3] = {in_ptr, in_ptr + row_offset1,
+                                        in_ptr + row_offset2};
+                for (int kh = 0; kh < 3; ++kh) {
+                  const T *row_ptr = row_ptrs[kh];
+                  // input (3 taps x 4 width): vi_tap
+                  float32x4_t vi0 = vld1q(row_ptr);
+                  float32x4_t vi1 = vld1q(row_ptr + dilation_w);
+                  float32x4_t vi2 = vld1q(row_ptr + 2 * dilation_w);
+                  const int k = kh * 3;
+                  // outch 0
+                  vo0 = neon_vfma_n(vo0, vi0, filter_ptr0[k]);
+                  vo0 = neon_vfma_n(vo0, vi1, filter_ptr0[k + 1]);
+                  vo0 = neon_vfma_n(vo0, vi2, filter_ptr0[k + 2]);
+                  // outch 1
+                  vo1 = neon_vfma_n(vo1, vi0, filter_ptr1[k]);
+                  vo1 = neon_vfma_n(vo1, vi1, filter_ptr1[k + 1]);
+                  vo1 = neon_vfma_n(vo1, vi2, filter_ptr1[k + 2]);
+                  // outch 2
+                  vo2 = neon_vfma_n(vo2, vi0, filter_ptr2[k]);
+                  vo2 = neon_vfma_n(vo2, vi1, filter_ptr2[k + 1]);
+                  vo2 = neon_vfma_n(vo2, vi2, filter_ptr2[k + 2]);
+                  // outch 3
+                  vo3 = neon_vfma_n(vo3, vi0, filter_ptr3[k]);
+                  vo3 = neon_vfma_n(vo3, vi1, filter_ptr3[k + 1]);
+                  vo3 = neon_vfma_n(vo3, vi2, filter_ptr3[k + 2]);
+                }  // kh
+                in_ptr += p.in_image_size;
+                filter_ptr0 += 9;
+                filter_ptr1 += 9;
+                filter_ptr2 += 9;
+                filter_ptr3 += 9;
+              }  // c
+              vst1q(out_ptr0_base + out_offset, vo0);
+              vst1q(out_ptr1_base + out_offset, vo1);
+              vst1q(out_ptr2_base + out_offset, vo2);
+              vst1q(out_ptr3_base + out_offset, vo3);
+            }  // w
+          }  // h
+        } else {
+          for (index_t mm = m; mm < p.out_channels; ++mm) {
+            T *out_ptr0_base =
+                output_data + b * p.out_batch_size + mm * p.out_image_size;
+            for (index_t h = 0; h < p.out_height; ++h) {
+              for (index_t w = 0; w + 3 < p.out_width; w += 4) {
+                const index_t out_offset = h * p.out_width + w;
+                // output (1 outch x 1 height x 4 width)
+                float32x4_t vo0 = vdupq_n_f32(0.f);
+                const T *in_ptr =
+                    input_data + b * p.in_batch_size + h * p.in_width + w;
+                const T *filter_ptr0 = filter_data + mm * p.in_channels * 9;
+                for (index_t c = 0; c < p.in_channels; ++c) {
+                  const T *row_ptrs[3] = {in_ptr, in_ptr + row_offset1,
+                                          in_ptr + row_offset2};
+                  for (int kh = 0; kh < 3; ++kh) {
+                    const T *row_ptr = row_ptrs[kh];
+                    float32x4_t vi0 = vld1q(row_ptr);
+                    float32x4_t vi1 = vld1q(row_ptr + dilation_w);
+                    float32x4_t vi2 = vld1q(row_ptr + 2 * dilation_w);
+                    const int k = kh * 3;
+                    vo0 = neon_vfma_n(vo0, vi0, filter_ptr0[k]);
+                    vo0 = neon_vfma_n(vo0, vi1, filter_ptr0[k + 1]);
+                    vo0 = neon_vfma_n(vo0, vi2, filter_ptr0[k + 2]);
+                  }  // kh
+                  in_ptr += p.in_image_size;
+                  filter_ptr0 += 9;
+                }  // c
+                vst1q(out_ptr0_base + out_offset, vo0);
+              }  // w
+            }  // h
+          }  // mm
+        }  // if
+      }  // m
+    }  // b
+  }, 0, p.batch, 1, 0, p.out_channels, 4);
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
+template<typename T>
+MaceStatus Conv2dKLineDilated<T>::Compute(const OpContext *context,
+                                          const Tensor *input,
+                                          const Tensor *filter,
+                                          Tensor *output) {
+  filter_length_ = FilterLength(filter);
+  return Conv2dKMxN<T>::Compute(context, input, filter, output);
+}
+
+template<typename T>
+MaceStatus Conv2dKLineDilated<T>::DoCompute(
+    const ConvComputeParam &p, const T *filter_data,
+    const T *input_data, T *output_data) {
+  const index_t filter_length = filter_length_;
+  const index_t filter_size = p.in_channels * filter_length;
+  const index_t tap_offset = TapOffset(p);
+
+  p.thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
+                              index_t start1, index_t end1, index_t step1) {
+    for (index_t b = start0; b < end0; b += step0) {
+      for (index_t m = start1; m < end1; m += step1) {
+        if (m + 3 < p.out_channels) {
+          T *out_ptr0_base =
+              output_data + b * p.out_batch_size + m * p.out_image_size;
+          T *out_ptr1_base = out_ptr0_base + p.out_image_size;
+          T *out_ptr2_base = out_ptr1_base + p.out_image_size;
+          T *out_ptr3_base = out_ptr2_base + p.out_image_size;
+          for (index_t h = 0; h < p.out_height; ++h) {
+            for (index_t w = 0; w + 3 < p.out_width; w += 4) {
+              const index_t out_offset = h * p.out_width + w;
+              // output (4 outch x 1 height x 4 width): vo_outch
+              float32x4_t vo0 = vdupq_n_f32(0.f);
+              float32x4_t vo1 = vdupq_n_f32(0.f);
+              float32x4_t vo2 = vdupq_n_f32(0.f);
+              float32x4_t vo3 = vdupq_n_f32(0.f);
+              const T *in_ptr =
+                  input_data + b * p.in_batch_size + h * p.in_width + w;
+              const T *filter_ptr0 = filter_data + m * filter_size;
+              const T *filter_ptr1 = filter_ptr0 + filter_size;
+              const T *filter_ptr2 = filter_ptr1 + filter_size;
+              const T *filter_ptr3 = filter_ptr2 + filter_size;
+              for (index_t c = 0; c < p.in_channels; ++c) {
+                const T *tap_ptr = in_ptr;
+                for (index_t k = 0; k < filter_length; ++k) {
+                  float32x4_t vi = vld1q(tap_ptr);
+                  vo0 = neon_vfma_n(vo0, vi, filter_ptr0[k]);
+                  vo1 = neon_vfma_n(vo1, vi, filter_ptr1[k]);
+                  vo2 = neon_vfma_n(vo2, vi, filter_ptr2[k]);
+                  vo3 = neon_vfma_n(vo3, vi, filter_ptr3[k]);
+                  tap_ptr += tap_offset;
+                }  // k
+                in_ptr += p.in_image_size;
+                filter_ptr0 += filter_length;
+                filter_ptr1 += filter_length;
+                filter_ptr2 += filter_length;
+                filter_ptr3 += filter_length;
+              }  // c
+              vst1q(out_ptr0_base + out_offset, vo0);
+              vst1q(out_ptr1_base + out_offset, vo1);
+              vst1q(out_ptr2_base + out_offset, vo2);
+              vst1q(out_ptr3_base + out_offset, vo3);
+            }  // w
+          }  // h
+        } else {
+          for (index_t mm = m; mm < p.out_channels; ++mm) {
+            T *out_ptr0_base =
+                output_data + b * p.out_batch_size + mm * p.out_image_size;
+            for (index_t h = 0; h < p.out_height; ++h) {
+              for (index_t w = 0; w + 3 < p.out_width; w += 4) {
+                const index_t out_offset = h * p.out_width + w;
+                // output (1 outch x 1 height x 4 width)
+                float32x4_t vo0 = vdupq_n_f32(0.f);
+                const T *in_ptr =
+                    input_data + b * p.in_batch_size + h * p.in_width + w;
+                const T *filter_ptr0 = filter_data + mm * filter_size;
+                for (index_t c = 0; c < p.in_channels; ++c) {
+                  const T *tap_ptr = in_ptr;
+                  for (index_t k = 0; k < filter_length; ++k) {
+                    vo0 = neon_vfma_n(vo0, vld1q(tap_ptr), filter_ptr0[k]);
+                    tap_ptr += tap_offset;
+                  }  // k
+                  in_ptr += p.in_image_size;
+                  filter_ptr0 += filter_length;
+                }  // c
+                vst1q(out_ptr0_base + out_offset, vo0);
+              }  // w
+            }  // h
+          }  // mm
+        }  // if
+      }  // m
+    }  // b
+  }, 0, p.batch, 1, 0, p.out_channels, 4);
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
+void RegisterConv2dDilatedDelegator(OpDelegatorRegistry *registry) {
+  MACE_REGISTER_DELEGATOR(
+      registry, Conv2dK3x3Dilated<float>, delegator::Conv2dParam,
+      MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU,
+                            float, ImplType::NEON, K3x3Dilated));
+  MACE_REGISTER_DELEGATOR(
+      registry, Conv2dK1xNDilated<float>, delegator::Conv2dParam,
+      MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU,
+                            float, ImplType::NEON, K1xNDilated));
+  MACE_REGISTER_DELEGATOR(
+      registry, Conv2dKNx1Dilated<float>, delegator::Conv2dParam,
+      MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU,
+                            float, ImplType::NEON, KNx1Dilated));
+
+  MACE_REGISTER_BF16_DELEGATOR(
+      registry, Conv2dK3x3Dilated<BFloat16>, delegator::Conv2dParam,
+      MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU,
+                            BFloat16, ImplType::NEON, K3x3Dilated));
+  MACE_REGISTER_BF16_DELEGATOR(
+      registry, Conv2dK1xNDilated<BFloat16>, delegator::Conv2dParam,
+      MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU,
+                            BFloat16, ImplType::NEON, K1xNDilated));
+  MACE_REGISTER_BF16_DELEGATOR(
+      registry, Conv2dKNx1Dilated<BFloat16>, delegator::Conv2dParam,
+      MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU,
+                            BFloat16, ImplType::NEON, KNx1Dilated));
+}
+
+}  // namespace arm
+}  // namespace ops
+}  // namespace mace
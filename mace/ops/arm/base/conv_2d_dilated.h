@@ -0,0 +1,102 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_ARM_BASE_CONV_2D_DILATED_H_
+#define MACE_OPS_ARM_BASE_CONV_2D_DILATED_H_
+
+#include <vector>
+
+#include "mace/core/ops/op_context.h"
+#include "mace/core/tensor.h"
+#include "mace/ops/arm/base/conv_2d_mxn.h"
+#include "mace/public/mace.h"
+
+namespace mace {
+namespace ops {
+namespace arm {
+
+// Stride 1 convolutions with dilations: each tap of 4 neighbouring outputs
+// reads 4 contiguous inputs, so the taps are loaded as vectors.
+template<typename T>
+class Conv2dK3x3Dilated : public Conv2dKMxN<T> {
+ public:
+  explicit Conv2dK3x3Dilated(const delegator::Conv2dParam &param)
+      : Conv2dKMxN<T>(param, 1, 4) {}
+  virtual ~Conv2dK3x3Dilated() {}
+
+  MaceStatus DoCompute(const ConvComputeParam &p, const T *filter,
+                       const T *input_data, T *output_data) override;
+};
+
+// 1xN and Nx1 filters of any length, the taps are along one dimension
+template<typename T>
+class Conv2dKLineDilated : public Conv2dKMxN<T> {
+ public:
+  explicit Conv2dKLineDilated(const delegator::Conv2dParam &param)
+      : Conv2dKMxN<T>(param, 1, 4), filter_length_(0) {}
+  virtual ~Conv2dKLineDilated() {}
+
+  MaceStatus Compute(const OpContext *context, const Tensor *input,
+                     const Tensor *filter, Tensor *output) override;
+
+  MaceStatus DoCompute(const ConvComputeParam &p, const T *filter,
+                       const T *input_data, T *output_data) override;
+
+ protected:
+  // Offset between two neighbouring taps in the padded input image
+  virtual index_t TapOffset(const ConvComputeParam &p) const = 0;
+  virtual index_t FilterLength(const Tensor *filter) const = 0;
+
+ private:
+  index_t filter_length_;
+};
+
+template<typename T>
+class Conv2dK1xNDilated : public Conv2dKLineDilated<T> {
+ public:
+  explicit Conv2dK1xNDilated(const delegator::Conv2dParam &param)
+      : Conv2dKLineDilated<T>(param) {}
+  virtual ~Conv2dK1xNDilated() {}
+
+ protected:
+  index_t TapOffset(const ConvComputeParam &p) const override {
+    MACE_UNUSED(p);
+    return this->dilations_[1];
+  }
+  index_t FilterLength(const Tensor *filter) const override {
+    return filter->dim(3);
+  }
+};
+
+template<typename T>
+class Conv2dKNx1Dilated : public Conv2dKLineDilated<T> {
+ public:
+  explicit Conv2dKNx1Dilated(const delegator::Conv2dParam &param)
+      : Conv2dKLineDilated<T>(param) {}
+  virtual ~Conv2dKNx1Dilated() {}
+
+ protected:
+  index_t TapOffset(const ConvComputeParam &p) const override {
+    return this->dilations_[0] * p.in_width;
+  }
+  index_t FilterLength(const Tensor *filter) const override {
+    return filter->dim(2);
+  }
+};
+
+}  // namespace arm
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_ARM_BASE_CONV_2D_DILATED_H_
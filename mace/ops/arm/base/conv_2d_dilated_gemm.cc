@@ -0,0 +1,152 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/ops/arm/base/conv_2d_dilated_gemm.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "mace/core/runtime/runtime.h"
+#include "mace/utils/memory.h"
+
+namespace mace {
+namespace ops {
+namespace arm {
+
+template<typename T>
+MaceStatus Conv2dDilatedGemm<T>::Compute(const OpContext *context,
+                                         const Tensor *input,
+                                         const Tensor *filter,
+                                         Tensor *output) {
+  std::vector<index_t> output_shape(4);
+  std::vector<int> paddings(2);
+  CalOutputShapeAndInputPadSize(input->shape(), filter->shape(),
+                                &output_shape, &paddings);
+  MACE_RETURN_IF_ERROR(output->Resize(output_shape));
+
+  const index_t batch = input->dim(0);
+  const index_t in_channels = input->dim(1);
+  const index_t out_channels = output_shape[1];
+  const index_t out_image_size = output_shape[2] * output_shape[3];
+  const index_t depth = in_channels * filter->dim(2) * filter->dim(3);
+
+  Runtime *runtime = context->runtime();
+  std::vector<index_t> columns_shape = {batch, depth, out_image_size};
+  std::unique_ptr<Tensor> columns = make_unique<Tensor>(
+      runtime, input->dtype(), MemoryType::CPU_BUFFER, columns_shape);
+  runtime->AllocateBufferForTensor(columns.get(), RENT_SCRATCH);
+  Im2col(context, input, filter->shape(), output_shape,
+         paddings[0] >> 1, paddings[1] >> 1, columns.get());
+
+  return gemm_.Compute(context, filter, columns.get(), batch, out_channels,
+                       depth, depth, out_image_size, false, false, false,
+                       false, true, output);
+}
+
+// Row (c, kh, kw) of the columns of an image holds the input pixels read by
+// the tap (kh, kw) of channel c for all the outputs.
+template<typename T>
+void Conv2dDilatedGemm<T>::Im2col(const OpContext *context,
+                                  const Tensor *input,
+                                  const std::vector<index_t> &filter_shape,
+                                  const std::vector<index_t> &output_shape,
+                                  const int pad_top,
+                                  const int pad_left,
+                                  Tensor *columns) {
+  const index_t batch = input->dim(0);
+  const index_t in_channels = input->dim(1);
+  const index_t in_height = input->dim(2);
+  const index_t in_width = input->dim(3);
+  const index_t filter_h = filter_shape[2];
+  const index_t filter_w = filter_shape[3];
+  const index_t out_height = output_shape[2];
+  const index_t out_width = output_shape[3];
+  const index_t stride_h = strides_[0];
+  const index_t stride_w = strides_[1];
+  const index_t dilation_h = dilations_[0];
+  const index_t dilation_w = dilations_[1];
+  const index_t filter_size = filter_h * filter_w;
+  const index_t depth = in_channels * filter_size;
+  const index_t in_image_size = in_height * in_width;
+  const index_t out_image_size = out_height * out_width;
+
+  const T *input_data = input->data<T>();
+  T *columns_data = columns->mutable_data<T>();
+
+  utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+  thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
+                            index_t start1, index_t end1, index_t step1) {
+    for (index_t b = start0; b < end0; b += step0) {
+      for (index_t d = start1; d < end1; d += step1) {
+        const index_t c = d / filter_size;
+        const index_t kh = (d % filter_size) / filter_w;
+        const index_t kw = d % filter_w;
+        const T *in_base =
+            input_data + (b * in_channels + c) * in_image_size;
+        T *col_ptr = columns_data + (b * depth + d) * out_image_size;
+
+        // the outputs in [w_begin, w_end) read inside the input row
+        const index_t w_offset = kw * dilation_w - pad_left;
+        const index_t w_begin = w_offset >= 0 ? 0 :
+            std::min(RoundUpDiv(-w_offset, stride_w), out_width);
+        const index_t w_end = w_offset >= in_width ? w_begin :
+            std::max(w_begin, std::min(
+                (in_width - 1 - w_offset) / stride_w + 1, out_width));
+
+        for (index_t h = 0; h < out_height; ++h) {
+          const index_t ih = h * stride_h + kh * dilation_h - pad_top;
+          if (ih < 0 || ih >= in_height) {
+            std::fill_n(col_ptr, out_width, static_cast<T>(0.f));
+          } else {
+            const T *in_ptr = in_base + ih * in_width + w_offset;
+            std::fill_n(col_ptr, w_begin, static_cast<T>(0.f));
+            if (stride_w == 1) {
+              memcpy(col_ptr + w_begin, in_ptr + w_begin,
+                     (w_end - w_begin) * sizeof(T));
+            } else {
+              for (index_t w = w_begin; w < w_end; ++w) {
+                col_ptr[w] = in_ptr[w * stride_w];
+              }
+            }
+            std::fill_n(col_ptr + w_end, out_width - w_end,
+                        static_cast<T>(0.f));
+          }
+          col_ptr += out_width;
+        }  // h
+      }  // d
+    }  // b
+  }, 0, batch, 1, 0, depth, 1);
+}
+
+void RegisterConv2dDilatedGemmDelegator(OpDelegatorRegistry *registry) {
+  MACE_REGISTER_DELEGATOR(
+      registry, Conv2dDilatedGemm<float>, delegator::Conv2dParam,
+      MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU,
+                            float, ImplType::NEON, KDilatedGemm));
+
+  MACE_REGISTER_BF16_DELEGATOR(
+      registry, Conv2dDilatedGemm<BFloat16>, delegator::Conv2dParam,
+      MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU,
+                            BFloat16, ImplType::NEON, KDilatedGemm));
+  MACE_REGISTER_FP16_DELEGATOR(
+      registry, Conv2dDilatedGemm<float16_t>, delegator::Conv2dParam,
+      MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU,
+                            float16_t, ImplType::NEON, KDilatedGemm));
+}
+
+}  // namespace arm
+}  // namespace ops
+}  // namespace mace
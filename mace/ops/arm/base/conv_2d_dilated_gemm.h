@@ -0,0 +1,60 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_ARM_BASE_CONV_2D_DILATED_GEMM_H_
+#define MACE_OPS_ARM_BASE_CONV_2D_DILATED_GEMM_H_
+
+#include <vector>
+
+#include "mace/ops/arm/base/conv_2d.h"
+#include "mace/ops/arm/base/gemm.h"
+
+namespace mace {
+namespace ops {
+namespace arm {
+
+// Gathers the dilated patches of the input into columns (im2col) and
+// multiplies them with the filter, for any filter size, stride and dilation.
+// It pays off when the filter depth (in_channels x filter size) is large.
+template<typename T>
+class Conv2dDilatedGemm : public Conv2dBase {
+ public:
+  explicit Conv2dDilatedGemm(const delegator::Conv2dParam &param)
+      : Conv2dBase(param, sizeof(T)),
+        gemm_(delegator::GemmParam()) {}
+  virtual ~Conv2dDilatedGemm() {}
+
+  MaceStatus Compute(
+      const OpContext *context,
+      const Tensor *input,
+      const Tensor *filter,
+      Tensor *output) override;
+
+ private:
+  void Im2col(const OpContext *context,
+              const Tensor *input,
+              const std::vector<index_t> &filter_shape,
+              const std::vector<index_t> &output_shape,
+              const int pad_top,
+              const int pad_left,
+              Tensor *columns);
+
+  Gemm<T> gemm_;
+};
+
+}  // namespace arm
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_ARM_BASE_CONV_2D_DILATED_GEMM_H_
@@ -0,0 +1,188 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/ops/arm/base/deconv_2d_gemm.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "mace/core/memory/buffer.h"
+#include "mace/core/runtime/runtime.h"
+#include "mace/utils/memory.h"
+
+namespace mace {
+namespace ops {
+namespace arm {
+
+template<typename T>
+MaceStatus Deconv2dGemm<T>::Compute(const OpContext *context,
+                                    const Tensor *input,
+                                    const Tensor *filter,
+                                    const Tensor *output_shape,
+                                    Tensor *output) {
+  std::unique_ptr<Tensor> padded_out;
+  std::vector<int> out_pad_size;
+  MACE_RETURN_IF_ERROR(ResizeOutAndPadOut(context, input, filter,
+                                          output_shape, output,
+                                          &out_pad_size, &padded_out));
+  Tensor *out_tensor = output;
+  if (padded_out != nullptr) {
+    out_tensor = padded_out.get();
+  }
+
+  const index_t batch = input->dim(0);
+  const index_t in_channels = input->dim(1);
+  const index_t in_height = input->dim(2);
+  const index_t in_width = input->dim(3);
+  const index_t out_channels = out_tensor->dim(1);
+  const index_t kernel_h = filter->dim(2);
+  const index_t kernel_w = filter->dim(3);
+  const index_t rows = out_channels * kernel_h * kernel_w;
+  const index_t in_image_size = in_height * in_width;
+
+  if (!filter->is_weight() || packed_filter_ == nullptr) {
+    PackFilter(context, filter);
+  }
+
+  // The columns of one image are reused by every image of the batch, which
+  // keeps the scratch memory independent of the batch size.
+  Runtime *runtime = context->runtime();
+  const MemoryType mem_type = MemoryType::CPU_BUFFER;
+  std::vector<index_t> columns_shape = {rows, in_image_size};
+  std::unique_ptr<Tensor> columns = make_unique<Tensor>(
+      runtime, input->dtype(), mem_type, columns_shape);
+  runtime->AllocateBufferForTensor(columns.get(), RENT_SCRATCH);
+
+  Buffer input_parent(mem_type, input->dtype(), {input->size()},
+                      const_cast<T *>(input->data<T>()));
+  const index_t in_image_bytes = in_channels * in_image_size * sizeof(T);
+  std::vector<index_t> in_image_shape = {in_channels, in_image_size};
+  for (index_t b = 0; b < batch; ++b) {
+    Tensor input_image(runtime, input->dtype(), mem_type, in_image_shape);
+    runtime->AllocateBufferForTensor(&input_image, RENT_SLICE,
+                                     &input_parent, b * in_image_bytes);
+    MACE_RETURN_IF_ERROR(gemm_.Compute(
+        context, packed_filter_.get(), &input_image, 1, rows, in_image_size,
+        in_channels, RowMajor, RowMajor, RowMajor, false, false,
+        columns.get()));
+    Col2im(context, columns.get(), b, kernel_h, kernel_w, in_height, in_width,
+           out_tensor);
+  }
+  UnPadOutput(*out_tensor, out_pad_size, output);
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
+template<typename T>
+void Deconv2dGemm<T>::PackFilter(const OpContext *context,
+                                 const Tensor *filter) {
+  const index_t out_channels = filter->dim(0);
+  const index_t in_channels = filter->dim(1);
+  const index_t kernel_size = filter->dim(2) * filter->dim(3);
+
+  Runtime *runtime = context->runtime();
+  std::vector<index_t> packed_shape = {out_channels * kernel_size,
+                                       in_channels};
+  // marked as weight so that gemm caches the packed lhs
+  packed_filter_ = make_unique<Tensor>(
+      runtime, filter->dtype(), MemoryType::CPU_BUFFER, packed_shape,
+      filter->is_weight());
+  runtime->AllocateBufferForTensor(packed_filter_.get(), RENT_PRIVATE);
+
+  const T *filter_data = filter->data<T>();
+  T *packed_data = packed_filter_->mutable_data<T>();
+
+  utils::ThreadPool &thread_pool = runtime->thread_pool();
+  thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
+    for (index_t oc = start; oc < end; oc += step) {
+      for (index_t ic = 0; ic < in_channels; ++ic) {
+        const T *src = filter_data + (oc * in_channels + ic) * kernel_size;
+        T *dst = packed_data + oc * kernel_size * in_channels + ic;
+        for (index_t k = 0; k < kernel_size; ++k) {
+          dst[k * in_channels] = src[k];
+        }
+      }
+    }
+  }, 0, out_channels, 1);
+}
+
+// Row (oc, kh, kw) of the columns of image `b` holds the contribution of tap
+// (kh, kw) to output channel oc for every input pixel, it is added to the
+// output pixels (ih * stride_h + kh, iw * stride_w + kw). Each output plane
+// is owned by one task, so no synchronization is needed.
+template<typename T>
+void Deconv2dGemm<T>::Col2im(const OpContext *context,
+                             const Tensor *columns,
+                             const index_t b,
+                             const index_t kernel_h,
+                             const index_t kernel_w,
+                             const index_t in_height,
+                             const index_t in_width,
+                             Tensor *out_tensor) {
+  const index_t out_channels = out_tensor->dim(1);
+  const index_t out_height = out_tensor->dim(2);
+  const index_t out_width = out_tensor->dim(3);
+  const index_t stride_h = strides_[0];
+  const index_t stride_w = strides_[1];
+  const index_t kernel_size = kernel_h * kernel_w;
+  const index_t in_image_size = in_height * in_width;
+  const index_t out_image_size = out_height * out_width;
+
+  const T *columns_data = columns->data<T>();
+  T *out_data = out_tensor->mutable_data<T>();
+
+  utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+  thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
+    for (index_t oc = start; oc < end; oc += step) {
+      T *out_base = out_data + (b * out_channels + oc) * out_image_size;
+      std::fill_n(out_base, out_image_size, static_cast<T>(0.f));
+      const T *col_ptr = columns_data + oc * kernel_size * in_image_size;
+      for (index_t kh = 0; kh < kernel_h; ++kh) {
+        for (index_t kw = 0; kw < kernel_w; ++kw) {
+          for (index_t h = 0; h < in_height; ++h) {
+            T *out_ptr =
+                out_base + (h * stride_h + kh) * out_width + kw;
+            if (stride_w == 1) {
+              for (index_t w = 0; w < in_width; ++w) {
+                out_ptr[w] += col_ptr[w];
+              }
+            } else {
+              for (index_t w = 0; w < in_width; ++w) {
+                out_ptr[w * stride_w] += col_ptr[w];
+              }
+            }
+            col_ptr += in_width;
+          }  // h
+        }  // kw
+      }  // kh
+    }  // oc
+  }, 0, out_channels, 1);
+}
+
+void RegisterDeconv2dGemmDelegator(OpDelegatorRegistry *registry) {
+  MACE_REGISTER_DELEGATOR(
+      registry, Deconv2dGemm<float>, delegator::Deconv2dParam,
+      MACE_DELEGATOR_KEY_EX(Deconv2d, RuntimeType::RT_CPU,
+                            float, ImplType::NEON, KGemm));
+
+  MACE_REGISTER_BF16_DELEGATOR(
+      registry, Deconv2dGemm<BFloat16>, delegator::Deconv2dParam,
+      MACE_DELEGATOR_KEY_EX(Deconv2d, RuntimeType::RT_CPU,
+                            BFloat16, ImplType::NEON, KGemm));
+}
+
+}  // namespace arm
+}  // namespace ops
+}  // namespace mace
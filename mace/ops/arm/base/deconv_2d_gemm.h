@@ -0,0 +1,74 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_ARM_BASE_DECONV_2D_GEMM_H_
+#define MACE_OPS_ARM_BASE_DECONV_2D_GEMM_H_
+
+#include <memory>
+#include <vector>
+
+#include "mace/core/ops/op_context.h"
+#include "mace/core/tensor.h"
+#include "mace/ops/arm/base/deconv_2d.h"
+#include "mace/ops/arm/base/gemm.h"
+#include "mace/public/mace.h"
+
+namespace mace {
+namespace ops {
+namespace arm {
+
+// Computes the transposed convolution as the product of the transposed filter
+// and the input, which gives the contribution of every input pixel to each
+// tap (out_channels x kernel_h x kernel_w rows by in_height x in_width
+// columns), followed by col2im which adds the rows into the output planes.
+// It works for any kernel size and stride, and pays off when in_channels is
+// large enough to keep the gemm busy.
+template<typename T>
+class Deconv2dGemm : public Deconv2dBase {
+ public:
+  explicit Deconv2dGemm(const delegator::Deconv2dParam &param)
+      : Deconv2dBase(param, sizeof(T)),
+        gemm_(delegator::GemmParam(true)),
+        packed_filter_(nullptr) {}
+  virtual ~Deconv2dGemm() {}
+
+  MaceStatus Compute(
+      const OpContext *context,
+      const Tensor *input,
+      const Tensor *filter,
+      const Tensor *output_shape,
+      Tensor *output) override;
+
+ private:
+  void PackFilter(const OpContext *context, const Tensor *filter);
+
+  void Col2im(const OpContext *context,
+              const Tensor *columns,
+              const index_t b,
+              const index_t kernel_h,
+              const index_t kernel_w,
+              const index_t in_height,
+              const index_t in_width,
+              Tensor *out_tensor);
+
+  Gemm<T> gemm_;
+  // filter laid out as (out_channels x kernel_h x kernel_w, in_channels)
+  std::unique_ptr<Tensor> packed_filter_;
+};
+
+}  // namespace arm
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_ARM_BASE_DECONV_2D_GEMM_H_
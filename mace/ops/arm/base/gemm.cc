@@ -517,12 +517,37 @@ void Gemm<T>::UnpackOutput(const T *packed_output, MatrixMap<T> *output) {
 }
 
 template<typename T>
-MaceStatus Gemm<T>::Compute(
+T *Gemm<T>::ObtainPackCache(const OpContext *context, const Tensor *weight,
+                            const std::string &layout, const index_t size,
+                            bool *filled) {
+  *filled = false;
+  // The packed weight is kept in the workspace, so that it is saved in
+  // snapshots and other ops packing the same weight take it as it is
+  Workspace *ws = context->workspace();
+  Tensor *packed = nullptr;
+  if (ws != nullptr && !weight->name().empty()) {
+    packed = ws->GetPackedWeight(weight->name() + layout, context->runtime(),
+                                 DataTypeToEnum<T>::value, {size}, filled);
+  }
+  if (packed != nullptr) {
+    pack_cache_.reset();
+    pack_cache_data_ = packed->mutable_data<T>();
+  } else {
+    MemInfo mem_info(MemoryType::CPU_BUFFER, DataTypeToEnum<T>::value, {size});
+    pack_cache_ = context->runtime()->ObtainBuffer(mem_info, RENT_PRIVATE);
+    pack_cache_data_ = pack_cache_->mutable_data<T>();
+  }
+  return pack_cache_data_;
+}
+
+template<typename T>
+MaceStatus Gemm<T>::ComputeImpl(
     const OpContext *context, const Tensor *lhs, const Tensor *rhs,
     const index_t batch, const index_t rows, const index_t cols,
     const index_t depth, const MatrixMajor lhs_major,
     const MatrixMajor rhs_major, const MatrixMajor output_major,
-    const bool lhs_batched, const bool rhs_batched, Tensor *output) {
+    const bool lhs_batched, const bool rhs_batched,
+    const GemmEpilogue *epilogue, Tensor *output) {
   MACE_CHECK(output->size() == batch * rows * cols,
              "Need resize output tensor before call gemm.");
   const T *lhs_data = lhs->data<T>();
@@ -559,19 +584,27 @@ MaceStatus Gemm<T>::Compute(
 
   int cache_side = kNoCache;
   if (cached_ == kCacheLhs) {
-    packed_lhs_data = pack_cache_->mutable_data<T>();
+    packed_lhs_data = pack_cache_data_;
   } else if (cached_ == kCacheRhs) {
-    packed_rhs_data = pack_cache_->mutable_data<T>();
+    packed_rhs_data = pack_cache_data_;
   } else if (should_cache_pack_) {
+    bool filled = false;
     if (lhs->is_weight() && (!lhs_batched || batch == 1)) {
-      cache_side = kCacheLhs;
-      pack_cache_->Resize({packed_lhs_buffer->size()});
-      packed_lhs_data = pack_cache_->mutable_data<T>();
-
+      packed_lhs_data = ObtainPackCache(
+          context, lhs, MakeString("_gemm_lhs_", rows, "x", depth, "_",
+                                   static_cast<int>(lhs_major), "_",
+                                   row_block_size),
+          rows_padded * depth_padded, &filled);
+      cache_side = filled ? kNoCache : kCacheLhs;
+      cached_ = filled ? kCacheLhs : kNoCache;
     } else if (rhs->is_weight() && (!rhs_batched || batch == 1)) {
-      cache_side = kCacheRhs;
-      pack_cache_->Resize({packed_rhs_buffer->size()});
-      packed_rhs_data = pack_cache_->mutable_data<T>();
+      packed_rhs_data = ObtainPackCache(
+          context, rhs, MakeString("_gemm_rhs_", depth, "x", cols, "_",
+                                   static_cast<int>(rhs_major), "_",
+                                   col_block_size),
+          depth_padded * cols_padded, &filled);
+      cache_side = filled ? kNoCache : kCacheRhs;
+      cached_ = filled ? kCacheRhs : kNoCache;
     }
   }
 
@@ -612,7 +645,11 @@ MaceStatus Gemm<T>::Compute(
 
       if (cache_side == kCacheLhs) {
         cached_ = kCacheLhs;
-        if (lhs->GetCurRuntime()->GetRuntimeType() == RT_CPU) {
+        // The caller of the epilogue still reads the weight, e.g. the
+        // fully connected op runs gemv with it for small batches, and other
+        // engines read a shared weight
+        if (epilogue == nullptr && !lhs->is_shared() &&
+            lhs->GetCurRuntime()->GetRuntimeType() == RT_CPU) {
           AdviseFree(const_cast<T *>(lhs->data<T>()), lhs->raw_size());
         }
       }
@@ -637,7 +674,8 @@ MaceStatus Gemm<T>::Compute(
 
       if (cache_side == kCacheRhs) {
         cached_ = kCacheRhs;
-        if (rhs->GetCurRuntime()->GetRuntimeType() == RT_CPU) {
+        if (epilogue == nullptr && !rhs->is_shared() &&
+            rhs->GetCurRuntime()->GetRuntimeType() == RT_CPU) {
           AdviseFree(const_cast<T *>(rhs->data<T>()), rhs->raw_size());
         }
       }
@@ -674,6 +712,9 @@ MaceStatus Gemm<T>::Compute(
                                                           row_block_len,
                                                           col_block_len);
           UnpackOutput(packed_output_data_block, &output_block);
+          if (epilogue != nullptr) {
+            ApplyEpilogue(*epilogue, start_col, &output_block);
+          }
         }  // col_block_idx
       }  // row_block_idx
     }, 0, row_block_count, 1);
@@ -16,6 +16,7 @@
 #define MACE_OPS_ARM_BASE_GEMM_H_
 
 #include <memory>
+#include <string>
 
 #include "mace/core/ops/op_context.h"
 #include "mace/core/tensor.h"
@@ -38,6 +39,7 @@ class Gemm : public delegator::Gemm {
  public:
   explicit Gemm(const delegator::GemmParam &param)
       : delegator::Gemm(param),
+        pack_cache_data_(nullptr),
         should_cache_pack_(param.should_cache_pack_),
         cached_(0) {}
   ~Gemm() {}
@@ -55,7 +57,11 @@ class Gemm : public delegator::Gemm {
       const MatrixMajor output_major,
       const bool lhs_batched,
       const bool rhs_batched,
-      Tensor *output) override;
+      Tensor *output) override {
+    return ComputeImpl(context, lhs, rhs, batch, rows, cols, depth, lhs_major,
+                       rhs_major, output_major, lhs_batched, rhs_batched,
+                       nullptr, output);
+  }
 
   // Original matrix before transpose has row-major
   MaceStatus Compute(
@@ -98,7 +104,49 @@ class Gemm : public delegator::Gemm {
                    output);
   }
 
+  MaceStatus ComputeWithEpilogue(const OpContext *context,
+                                 const Tensor *lhs,
+                                 const Tensor *rhs,
+                                 const index_t rows,
+                                 const index_t cols,
+                                 const index_t depth,
+                                 const MatrixMajor lhs_major,
+                                 const MatrixMajor rhs_major,
+                                 const GemmEpilogue &epilogue,
+                                 Tensor *output) override {
+    return ComputeImpl(context, lhs, rhs, 1, rows, cols, depth, lhs_major,
+                       rhs_major, RowMajor, false, false, &epilogue, output);
+  }
+
  protected:
+  // `epilogue` is applied to each unpacked output tile if it is not null
+  MaceStatus ComputeImpl(const OpContext *context,
+                         const Tensor *lhs,
+                         const Tensor *rhs,
+                         const index_t batch,
+                         const index_t rows,
+                         const index_t cols,
+                         const index_t depth,
+                         const MatrixMajor lhs_major,
+                         const MatrixMajor rhs_major,
+                         const MatrixMajor output_major,
+                         const bool lhs_batched,
+                         const bool rhs_batched,
+                         const GemmEpilogue *epilogue,
+                         Tensor *output);
+
+  // The output block is row-major, and still in cache after unpacking
+  void ApplyEpilogue(const GemmEpilogue &epilogue,
+                     const index_t start_col,
+                     MatrixMap<T> *output_block) {
+    const T *bias = epilogue.bias == nullptr ?
+                    nullptr : epilogue.bias->data<T>() + start_col;
+    for (index_t r = 0; r < output_block->rows(); ++r) {
+      ApplyGemmEpilogue(epilogue, bias, output_block->cols(),
+                        output_block->data(r, 0));
+    }
+  }
+
   void ComputeBlock(const T *packed_lhs_data,
                     const T *packed_rhs_data,
                     const index_t depth_padded,
@@ -123,8 +171,15 @@ class Gemm : public delegator::Gemm {
                MatrixMajor dst_major,
                T *packed_matrix);
 
+  // The memory of the packed weight, a weight in the workspace if it can be
+  // kept there, *filled is set if it is packed already.
+  T *ObtainPackCache(const OpContext *context, const Tensor *weight,
+                     const std::string &layout, const index_t size,
+                     bool *filled);
+
  private:
   std::unique_ptr<Buffer> pack_cache_;
+  T *pack_cache_data_;
   bool should_cache_pack_;
   int cached_;
 };
@@ -572,19 +572,20 @@ void Gemm<float16_t>::ComputeBlock(const float16_t *packed_lhs_data,
 }
 
 template<>
-MaceStatus Gemm<float16_t>::Compute(const OpContext *context,
-                                    const Tensor *lhs,
-                                    const Tensor *rhs,
-                                    const index_t batch,
-                                    const index_t rows,
-                                    const index_t cols,
-                                    const index_t depth,
-                                    const MatrixMajor lhs_major,
-                                    const MatrixMajor rhs_major,
-                                    const MatrixMajor output_major,
-                                    const bool lhs_batched,
-                                    const bool rhs_batched,
-                                    Tensor *output) {
+MaceStatus Gemm<float16_t>::ComputeImpl(const OpContext *context,
+                                        const Tensor *lhs,
+                                        const Tensor *rhs,
+                                        const index_t batch,
+                                        const index_t rows,
+                                        const index_t cols,
+                                        const index_t depth,
+                                        const MatrixMajor lhs_major,
+                                        const MatrixMajor rhs_major,
+                                        const MatrixMajor output_major,
+                                        const bool lhs_batched,
+                                        const bool rhs_batched,
+                                        const GemmEpilogue *epilogue,
+                                        Tensor *output) {
   MACE_CHECK(output->size() == batch * rows * cols,
              "Need resize output tensor before call gemm.");
   const float16_t *lhs_data = lhs->data<float16_t>();
@@ -622,11 +623,13 @@ MaceStatus Gemm<float16_t>::Compute(const OpContext *context,
   } else if (should_cache_pack_) {
     if (lhs->is_weight() && (!lhs_batched || batch == 1)) {
       cache_side = kCacheLhs;
-      pack_cache_->Resize({packed_lhs_buffer->size()});
+      mem_info.dims = {rows_padded * depth_padded};
+      pack_cache_ = runtime->ObtainBuffer(mem_info, RENT_PRIVATE);
       packed_lhs_data = pack_cache_->mutable_data<float16_t>();
     } else if (rhs->is_weight() && (!rhs_batched || batch == 1)) {
       cache_side = kCacheRhs;
-      pack_cache_->Resize({packed_rhs_buffer->size()});
+      mem_info.dims = {depth_padded * cols_padded};
+      pack_cache_ = runtime->ObtainBuffer(mem_info, RENT_PRIVATE);
       packed_rhs_data = pack_cache_->mutable_data<float16_t>();
     }
   }
@@ -668,7 +671,8 @@ MaceStatus Gemm<float16_t>::Compute(const OpContext *context,
 
       if (cache_side == kCacheLhs) {
         cached_ = kCacheLhs;
-        if (lhs->GetCurRuntime()->GetRuntimeType() == RT_CPU) {
+        if (epilogue == nullptr && !lhs->is_shared() &&
+            lhs->GetCurRuntime()->GetRuntimeType() == RT_CPU) {
           AdviseFree(const_cast<float16_t *>(lhs->data<float16_t>()),
                      lhs->raw_size());
         }
@@ -694,7 +698,8 @@ MaceStatus Gemm<float16_t>::Compute(const OpContext *context,
 
       if (cache_side == kCacheRhs) {
         cached_ = kCacheRhs;
-        if (rhs->GetCurRuntime()->GetRuntimeType() == RT_CPU) {
+        if (epilogue == nullptr && !rhs->is_shared() &&
+            rhs->GetCurRuntime()->GetRuntimeType() == RT_CPU) {
           AdviseFree(const_cast<float16_t *>(rhs->data<float16_t>()),
                      rhs->raw_size());
         }
@@ -733,6 +738,9 @@ MaceStatus Gemm<float16_t>::Compute(const OpContext *context,
                                   row_block_len,
                                   col_block_len);
           UnpackOutput(packed_output_data_block, &output_block);
+          if (epilogue != nullptr) {
+            ApplyEpilogue(*epilogue, start_col, &output_block);
+          }
         }  // col_block_idx
       }  // row_block_idx
     }, 0, row_block_count, 1);
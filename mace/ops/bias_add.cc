@@ -64,6 +64,10 @@ class BiasAddOp<RuntimeType::RT_CPU, T> : public Operation {
     return MaceStatus::MACE_SUCCESS;
   }
 
+  bool SupportsInPlace(size_t output_idx, size_t input_idx) const override {
+    return output_idx == 0 && input_idx == 0;
+  }
+
  private:
   int has_data_format_;
   std::unique_ptr<delegator::BiasAdd> bias_add_delegator_;
@@ -48,6 +48,12 @@ class CastOp : public Operation {
     return MaceStatus::MACE_SUCCESS;
   }
 
+  // Each element is converted in place, the planner only shares the memory
+  // of types with the same width.
+  bool SupportsInPlace(size_t output_idx, size_t input_idx) const override {
+    return output_idx == OUTPUT && input_idx == INPUT;
+  }
+
  private:
   MACE_OP_INPUT_TAGS(INPUT);
   MACE_OP_OUTPUT_TAGS(OUTPUT);
@@ -0,0 +1,58 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_COMMON_EMBEDDING_UTILS_H_
+#define MACE_OPS_COMMON_EMBEDDING_UTILS_H_
+
+#include <algorithm>
+#include <cstring>
+
+#include "mace/core/types.h"
+#include "mace/utils/macros.h"
+
+namespace mace {
+namespace ops {
+
+// Rows of an embedding table are read in index order, which is random, so
+// the row of the index kEmbeddingPrefetchDistance items ahead is prefetched.
+constexpr index_t kEmbeddingPrefetchDistance = 8;
+// Only the head of a row is prefetched, the hardware prefetcher follows the
+// sequential reads of the rest.
+constexpr index_t kEmbeddingPrefetchBytes = 256;
+constexpr index_t kCacheLineBytes = 64;
+
+inline void PrefetchRow(const void *row, index_t row_bytes) {
+  const char *ptr = static_cast<const char *>(row);
+  const index_t bytes = std::min(row_bytes, kEmbeddingPrefetchBytes);
+  for (index_t i = 0; i < bytes; i += kCacheLineBytes) {
+    MACE_PREFETCH(ptr + i);
+  }
+}
+
+template<typename SrcT, typename DstT>
+inline void CopyRow(const SrcT *src, index_t size, DstT *dst) {
+  for (index_t i = 0; i < size; ++i) {
+    dst[i] = static_cast<DstT>(src[i]);
+  }
+}
+
+template<typename T>
+inline void CopyRow(const T *src, index_t size, T *dst) {
+  memcpy(dst, src, size * sizeof(T));
+}
+
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_COMMON_EMBEDDING_UTILS_H_
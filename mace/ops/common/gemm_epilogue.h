@@ -0,0 +1,125 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_COMMON_GEMM_EPILOGUE_H_
+#define MACE_OPS_COMMON_GEMM_EPILOGUE_H_
+
+#include <algorithm>
+#include <cmath>
+
+#include "mace/core/tensor.h"
+#include "mace/ops/common/activation_type.h"
+
+namespace mace {
+namespace ops {
+
+// Bias and activation applied to a gemm output while it is written
+struct GemmEpilogue {
+  GemmEpilogue()
+      : bias(nullptr),
+        activation(NOOP),
+        relux_max_limit(0.f),
+        activation_coefficient(0.f),
+        hardsigmoid_alpha(0.f),
+        hardsigmoid_beta(0.f) {}
+
+  static bool IsSupported(const ActivationType activation) {
+    // PRELU needs the alpha tensor
+    return activation != PRELU;
+  }
+
+  // One value per output column, may be null
+  const Tensor *bias;
+  ActivationType activation;
+  float relux_max_limit;
+  float activation_coefficient;
+  float hardsigmoid_alpha;
+  float hardsigmoid_beta;
+};
+
+// Add the bias and activate `size` values of an output row in place, `bias`
+// points to the bias of the first value.
+template<typename T>
+void ApplyGemmEpilogue(const GemmEpilogue &epilogue,
+                       const T *bias,
+                       const index_t size,
+                       T *output) {
+  if (bias != nullptr) {
+    for (index_t i = 0; i < size; ++i) {
+      output[i] = static_cast<float>(output[i]) + static_cast<float>(bias[i]);
+    }
+  }
+
+  switch (epilogue.activation) {
+    case RELU: {
+      for (index_t i = 0; i < size; ++i) {
+        output[i] = std::max(0.f, static_cast<float>(output[i]));
+      }
+      break;
+    }
+    case RELUX: {
+      for (index_t i = 0; i < size; ++i) {
+        output[i] = std::max(0.f, std::min(epilogue.relux_max_limit,
+                                           static_cast<float>(output[i])));
+      }
+      break;
+    }
+    case LEAKYRELU: {
+      for (index_t i = 0; i < size; ++i) {
+        const float in = output[i];
+        output[i] = std::max(in, 0.f) +
+            std::min(in, 0.f) * epilogue.activation_coefficient;
+      }
+      break;
+    }
+    case TANH: {
+      for (index_t i = 0; i < size; ++i) {
+        output[i] = std::tanh(static_cast<float>(output[i]));
+      }
+      break;
+    }
+    case SIGMOID: {
+      for (index_t i = 0; i < size; ++i) {
+        output[i] = 1 / (1 + std::exp(-static_cast<float>(output[i])));
+      }
+      break;
+    }
+    case HARDSIGMOID: {
+      for (index_t i = 0; i < size; ++i) {
+        output[i] = std::max(0.f, std::min(1.f,
+            epilogue.hardsigmoid_alpha * static_cast<float>(output[i]) +
+                epilogue.hardsigmoid_beta));
+      }
+      break;
+    }
+    case ELU: {
+      for (index_t i = 0; i < size; ++i) {
+        const float in = output[i];
+        if (in < 0) {
+          output[i] = (std::exp(in) - 1) * epilogue.activation_coefficient;
+        }
+      }
+      break;
+    }
+    case NOOP:
+      break;
+    default:
+      MACE_NOT_IMPLEMENTED;
+  }
+}
+
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_COMMON_GEMM_EPILOGUE_H_
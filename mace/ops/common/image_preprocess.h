@@ -0,0 +1,212 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_COMMON_IMAGE_PREPROCESS_H_
+#define MACE_OPS_COMMON_IMAGE_PREPROCESS_H_
+
+#if defined(MACE_ENABLE_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "mace/core/types.h"
+#include "mace/utils/thread_pool.h"
+
+namespace mace {
+namespace ops {
+
+// Crop window and per channel transform of PreprocessImage.
+struct ImagePreprocessParam {
+  index_t batch;
+  index_t src_height;
+  index_t src_width;
+  index_t channels;
+  index_t crop_top;
+  index_t crop_left;
+  index_t height;
+  index_t width;
+  // output channel c = input channel channel_map[c] * scale[c] + bias[c]
+  std::vector<index_t> channel_map;
+  std::vector<float> scale;
+  std::vector<float> bias;
+};
+
+#if defined(MACE_ENABLE_NEON)
+inline void Uint8ToFloat(const uint8x8_t in, float32x4_t *lo,
+                         float32x4_t *hi) {
+  const uint16x8_t in16 = vmovl_u8(in);
+  *lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(in16)));
+  *hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(in16)));
+}
+#elif defined(__SSE2__)
+// Loads 4 pixels of 3 uint8 channels to one float vector per channel
+inline void Load3x4(const uint8_t *in, __m128 *vc) {
+  int32_t tail;
+  memcpy(&tail, in + 8, sizeof(tail));
+  const __m128i in8 = _mm_unpacklo_epi64(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in)),
+      _mm_cvtsi32_si128(tail));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i lo16 = _mm_unpacklo_epi8(in8, zero);
+  const __m128i hi16 = _mm_unpackhi_epi8(in8, zero);
+  // v0 ... v11 in the order of memory
+  const __m128 f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo16, zero));
+  const __m128 f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo16, zero));
+  const __m128 f2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi16, zero));
+  // v0 v3 v6 v9
+  vc[0] = _mm_shuffle_ps(f0, _mm_shuffle_ps(f1, f2, _MM_SHUFFLE(1, 1, 2, 2)),
+                         _MM_SHUFFLE(2, 0, 3, 0));
+  // v1 v4 v7 v10
+  vc[1] = _mm_shuffle_ps(_mm_shuffle_ps(f0, f1, _MM_SHUFFLE(0, 0, 1, 1)),
+                         _mm_shuffle_ps(f1, f2, _MM_SHUFFLE(2, 2, 3, 3)),
+                         _MM_SHUFFLE(2, 0, 2, 0));
+  // v2 v5 v8 v11
+  vc[2] = _mm_shuffle_ps(_mm_shuffle_ps(f0, f1, _MM_SHUFFLE(1, 1, 2, 2)),
+                         _mm_shuffle_ps(f2, f2, _MM_SHUFFLE(3, 3, 0, 0)),
+                         _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+// Stores one float vector per channel as 4 interleaved pixels
+inline void Store3x4(const __m128 *vc, float *out) {
+  _mm_storeu_ps(out, _mm_shuffle_ps(
+      _mm_shuffle_ps(vc[0], vc[1], _MM_SHUFFLE(0, 0, 0, 0)),
+      _mm_shuffle_ps(vc[2], vc[0], _MM_SHUFFLE(1, 1, 0, 0)),
+      _MM_SHUFFLE(2, 0, 2, 0)));
+  _mm_storeu_ps(out + 4, _mm_shuffle_ps(
+      _mm_shuffle_ps(vc[1], vc[2], _MM_SHUFFLE(1, 1, 1, 1)),
+      _mm_shuffle_ps(vc[0], vc[1], _MM_SHUFFLE(2, 2, 2, 2)),
+      _MM_SHUFFLE(2, 0, 2, 0)));
+  _mm_storeu_ps(out + 8, _mm_shuffle_ps(
+      _mm_shuffle_ps(vc[2], vc[0], _MM_SHUFFLE(3, 3, 2, 2)),
+      _mm_shuffle_ps(vc[1], vc[2], _MM_SHUFFLE(3, 3, 3, 3)),
+      _MM_SHUFFLE(2, 0, 2, 0)));
+}
+#endif
+
+// Converts the crop window of the uint8 NHWC image `input` to float `output`
+// in NCHW (nchw) or NHWC, transforming the channels as `param` in the same
+// pass.
+inline void PreprocessImage(utils::ThreadPool *thread_pool,
+                            const uint8_t *input,
+                            const ImagePreprocessParam &param,
+                            const bool nchw,
+                            float *output) {
+  const index_t channels = param.channels;
+  const index_t height = param.height;
+  const index_t width = param.width;
+  const index_t *channel_map = param.channel_map.data();
+  const float *scale = param.scale.data();
+  const float *bias = param.bias.data();
+
+  thread_pool->Compute2D([=, &param](index_t start0, index_t end0,
+                                     index_t step0, index_t start1,
+                                     index_t end1, index_t step1) {
+    for (index_t b = start0; b < end0; b += step0) {
+      for (index_t h = start1; h < end1; h += step1) {
+        const uint8_t *in_row = input +
+            ((b * param.src_height + param.crop_top + h) * param.src_width +
+                param.crop_left) * channels;
+        index_t w = 0;
+        if (nchw) {
+          const index_t image_size = height * width;
+          float *out_row = output + b * channels * image_size + h * width;
+#if defined(MACE_ENABLE_NEON)
+          if (channels == 3) {
+            float *outs[3] = {out_row, out_row + image_size,
+                              out_row + 2 * image_size};
+            for (; w + 7 < width; w += 8) {
+              const uint8x8x3_t vi = vld3_u8(in_row + w * 3);
+              for (int c = 0; c < 3; ++c) {
+                float32x4_t lo, hi;
+                Uint8ToFloat(vi.val[channel_map[c]], &lo, &hi);
+                const float32x4_t vb = vdupq_n_f32(bias[c]);
+                vst1q_f32(outs[c] + w, vmlaq_n_f32(vb, lo, scale[c]));
+                vst1q_f32(outs[c] + w + 4, vmlaq_n_f32(vb, hi, scale[c]));
+              }
+            }
+          }
+#elif defined(__SSE2__)
+          if (channels == 3) {
+            for (; w + 3 < width; w += 4) {
+              __m128 vi[3];
+              Load3x4(in_row + w * 3, vi);
+              for (int c = 0; c < 3; ++c) {
+                _mm_storeu_ps(out_row + c * image_size + w, _mm_add_ps(
+                    _mm_mul_ps(vi[channel_map[c]], _mm_set1_ps(scale[c])),
+                    _mm_set1_ps(bias[c])));
+              }
+            }
+          }
+#endif
+          for (index_t c = 0; c < channels; ++c) {
+            const uint8_t *in = in_row + channel_map[c];
+            float *out = out_row + c * image_size;
+            for (index_t i = w; i < width; ++i) {
+              out[i] = in[i * channels] * scale[c] + bias[c];
+            }
+          }
+        } else {
+          float *out_row = output + (b * height + h) * width * channels;
+#if defined(MACE_ENABLE_NEON)
+          if (channels == 3) {
+            for (; w + 7 < width; w += 8) {
+              const uint8x8x3_t vi = vld3_u8(in_row + w * 3);
+              float32x4x3_t lo, hi;
+              for (int c = 0; c < 3; ++c) {
+                float32x4_t vlo, vhi;
+                Uint8ToFloat(vi.val[channel_map[c]], &vlo, &vhi);
+                const float32x4_t vb = vdupq_n_f32(bias[c]);
+                lo.val[c] = vmlaq_n_f32(vb, vlo, scale[c]);
+                hi.val[c] = vmlaq_n_f32(vb, vhi, scale[c]);
+              }
+              vst3q_f32(out_row + w * 3, lo);
+              vst3q_f32(out_row + w * 3 + 12, hi);
+            }
+          }
+#elif defined(__SSE2__)
+          if (channels == 3) {
+            for (; w + 3 < width; w += 4) {
+              __m128 vi[3];
+              __m128 vo[3];
+              Load3x4(in_row + w * 3, vi);
+              for (int c = 0; c < 3; ++c) {
+                vo[c] = _mm_add_ps(
+                    _mm_mul_ps(vi[channel_map[c]], _mm_set1_ps(scale[c])),
+                    _mm_set1_ps(bias[c]));
+              }
+              Store3x4(vo, out_row + w * 3);
+            }
+          }
+#endif
+          for (index_t i = w; i < width; ++i) {
+            const uint8_t *in = in_row + i * channels;
+            float *out = out_row + i * channels;
+            for (index_t c = 0; c < channels; ++c) {
+              out[c] = in[channel_map[c]] * scale[c] + bias[c];
+            }
+          }
+        }
+      }
+    }
+  }, 0, param.batch, 1, 0, height, 1);
+}
+
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_COMMON_IMAGE_PREPROCESS_H_
@@ -0,0 +1,127 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/ops/common/recurrent.h"
+
+#if defined(MACE_ENABLE_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#include <algorithm>
+
+#include "mace/utils/logging.h"
+#include "mace/utils/math.h"
+
+namespace mace {
+namespace ops {
+
+namespace {
+constexpr index_t kRecurrentBlockRows = 8;
+
+// sum[r] = sum_k block[k * kRecurrentBlockRows + r] * input[k]
+inline void MultiplyBlock(const float *block, const float *input,
+                          const index_t depth, float *sum) {
+#if defined(MACE_ENABLE_NEON)
+  float32x4_t sum0 = vdupq_n_f32(0.f);
+  float32x4_t sum1 = vdupq_n_f32(0.f);
+  for (index_t k = 0; k < depth; ++k) {
+    const float32x4_t in = vdupq_n_f32(input[k]);
+    sum0 = vmlaq_f32(sum0, vld1q_f32(block), in);
+    sum1 = vmlaq_f32(sum1, vld1q_f32(block + 4), in);
+    block += kRecurrentBlockRows;
+  }
+  vst1q_f32(sum, sum0);
+  vst1q_f32(sum + 4, sum1);
+#elif defined(__SSE__)
+  __m128 sum0 = _mm_setzero_ps();
+  __m128 sum1 = _mm_setzero_ps();
+  for (index_t k = 0; k < depth; ++k) {
+    const __m128 in = _mm_set1_ps(input[k]);
+    sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(block), in));
+    sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(block + 4), in));
+    block += kRecurrentBlockRows;
+  }
+  _mm_storeu_ps(sum, sum0);
+  _mm_storeu_ps(sum + 4, sum1);
+#else
+  std::fill_n(sum, kRecurrentBlockRows, 0.f);
+  for (index_t k = 0; k < depth; ++k) {
+    for (index_t r = 0; r < kRecurrentBlockRows; ++r) {
+      sum[r] += block[r] * input[k];
+    }
+    block += kRecurrentBlockRows;
+  }
+#endif
+}
+}  // namespace
+
+RecurrentDirection StringToRecurrentDirection(const std::string &direction) {
+  if (direction == "forward") {
+    return RecurrentDirection::FORWARD;
+  } else if (direction == "reverse") {
+    return RecurrentDirection::REVERSE;
+  } else if (direction == "bidirectional") {
+    return RecurrentDirection::BIDIRECTIONAL;
+  } else {
+    LOG(FATAL) << "Unknown recurrent direction: " << direction;
+  }
+  return RecurrentDirection::FORWARD;
+}
+
+void RecurrentWeights::Pack(const float *weights, index_t rows,
+                            index_t depth) {
+  rows_ = rows;
+  depth_ = depth;
+  const index_t blocks = RoundUpDiv(rows, kRecurrentBlockRows);
+  // The rows of the last block past the matrix are zeros.
+  packed_.assign(blocks * kRecurrentBlockRows * depth, 0.f);
+  for (index_t r = 0; r < rows; ++r) {
+    float *block = packed_.data() + (r / kRecurrentBlockRows) * depth
+        * kRecurrentBlockRows + r % kRecurrentBlockRows;
+    const float *row = weights + r * depth;
+    for (index_t k = 0; k < depth; ++k) {
+      block[k * kRecurrentBlockRows] = row[k];
+    }
+  }
+}
+
+void RecurrentWeights::Multiply(utils::ThreadPool *thread_pool,
+                                const float *input,
+                                index_t input_stride,
+                                index_t batch,
+                                float *output,
+                                index_t output_stride) const {
+  MACE_CHECK(packed(), "recurrent weights are not packed");
+  const index_t rows = rows_;
+  const index_t depth = depth_;
+  const float *packed = packed_.data();
+  thread_pool->Compute1D([=](index_t start, index_t end, index_t step) {
+    float sum[kRecurrentBlockRows];
+    for (index_t blk = start; blk < end; blk += step) {
+      const float *block = packed + blk * depth * kRecurrentBlockRows;
+      const index_t row = blk * kRecurrentBlockRows;
+      const index_t block_rows = std::min(kRecurrentBlockRows, rows - row);
+      for (index_t b = 0; b < batch; ++b) {
+        MultiplyBlock(block, input + b * input_stride, depth, sum);
+        std::copy_n(sum, block_rows, output + b * output_stride + row);
+      }
+    }
+  }, 0, RoundUpDiv(rows, kRecurrentBlockRows), 1, 0,
+     static_cast<int>(depth * batch * kRecurrentBlockRows));
+}
+
+}  // namespace ops
+}  // namespace mace
@@ -0,0 +1,72 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_COMMON_RECURRENT_H_
+#define MACE_OPS_COMMON_RECURRENT_H_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "mace/core/types.h"
+#include "mace/utils/thread_pool.h"
+
+namespace mace {
+namespace ops {
+
+enum RecurrentDirection {
+  FORWARD = 0,
+  REVERSE = 1,
+  BIDIRECTIONAL = 2,
+};
+
+RecurrentDirection StringToRecurrentDirection(const std::string &direction);
+
+// Clips a gate pre-activation to [-clip, clip], a clip <= 0 disables it.
+inline float RecurrentClip(float in, float clip) {
+  return clip > 0.f ? std::max(-clip, std::min(clip, in)) : in;
+}
+
+// Recurrent weights packed for the matrix-vector products of every timestep.
+// Blocks of kRecurrentBlockRows rows are interleaved column by column, so
+// one pass over the hidden state produces a whole block with SIMD, and the
+// blocks are read sequentially at every step.
+class RecurrentWeights {
+ public:
+  RecurrentWeights() : rows_(0), depth_(0) {}
+
+  // Packs a row-major [rows, depth] matrix.
+  void Pack(const float *weights, index_t rows, index_t depth);
+
+  // output[b * output_stride + r] = sum_k weights[r, k] *
+  // input[b * input_stride + k] for b < batch and r < rows.
+  void Multiply(utils::ThreadPool *thread_pool,
+                const float *input,
+                index_t input_stride,
+                index_t batch,
+                float *output,
+                index_t output_stride) const;
+
+  bool packed() const { return rows_ > 0; }
+
+ private:
+  std::vector<float> packed_;
+  index_t rows_;
+  index_t depth_;
+};
+
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_COMMON_RECURRENT_H_
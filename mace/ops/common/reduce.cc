@@ -0,0 +1,115 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/ops/common/reduce.h"
+
+#include "mace/utils/logging.h"
+
+namespace mace {
+namespace ops {
+
+namespace {
+// Threads share a reduce axis only when each chunk has this many elements
+constexpr index_t kMinSplitSize = 16384;
+// Split at most into this many chunks, and only the passes with fewer
+// outputs (rows or column blocks) than that
+constexpr index_t kMaxSplits = 8;
+}  // namespace
+
+std::vector<ReduceStep> PlanReduce(const std::vector<index_t> &shape,
+                                   const std::vector<bool> &reduced) {
+  MACE_CHECK(shape.size() == reduced.size());
+  // Alternating groups of kept and reduced axes
+  std::vector<index_t> dims;
+  std::vector<bool> flags;
+  for (size_t i = 0; i < shape.size(); ++i) {
+    if (shape[i] == 1) {
+      continue;
+    }
+    if (!flags.empty() && flags.back() == reduced[i]) {
+      dims.back() *= shape[i];
+    } else {
+      dims.push_back(shape[i]);
+      flags.push_back(reduced[i]);
+    }
+  }
+
+  std::vector<ReduceStep> steps;
+  while (true) {
+    int group = static_cast<int>(flags.size()) - 1;
+    while (group >= 0 && !flags[group]) {
+      --group;
+    }
+    if (group < 0) {
+      break;
+    }
+    ReduceStep step = {1, dims[group], 1};
+    for (int i = 0; i < group; ++i) {
+      step.outer *= dims[i];
+    }
+    for (size_t i = group + 1; i < dims.size(); ++i) {
+      step.inner *= dims[i];
+    }
+    steps.push_back(step);
+
+    // The kept groups around the reduced one become adjacent
+    if (group > 0 && group + 1 < static_cast<int>(dims.size())) {
+      dims[group - 1] *= dims[group + 1];
+      dims.erase(dims.begin() + group, dims.begin() + group + 2);
+      flags.erase(flags.begin() + group, flags.begin() + group + 2);
+    } else {
+      dims.erase(dims.begin() + group);
+      flags.erase(flags.begin() + group);
+    }
+  }
+
+  if (steps.empty()) {
+    // Nothing to reduce, the output is a copy of the input
+    index_t size = 1;
+    for (auto dim : dims) {
+      size *= dim;
+    }
+    steps.push_back({size, 1, 1});
+  }
+  return steps;
+}
+
+index_t ReduceSplits(const ReduceStep &step) {
+  const index_t blocks =
+      (step.inner + kReduceColumnBlock - 1) / kReduceColumnBlock;
+  const index_t tasks = step.inner == 1 ? step.outer : step.outer * blocks;
+  if (tasks >= kMaxSplits) {
+    return 1;
+  }
+  const index_t size = step.outer * step.reduce * step.inner;
+  return std::max<index_t>(1, std::min(kMaxSplits, size / kMinSplitSize));
+}
+
+index_t ReduceScratchSize(const std::vector<ReduceStep> &steps) {
+  index_t size = 0;
+  for (const auto &step : steps) {
+    const index_t splits = ReduceSplits(step);
+    if (splits > 1) {
+      size = std::max(size, splits * step.outer * step.inner);
+    }
+  }
+  // Results of the passes but the last one, in two buffers used in turn
+  for (size_t i = 0; i + 1 < steps.size() && i < 2; ++i) {
+    size += steps[i].outer * steps[i].inner;
+  }
+  return size;
+}
+
+}  // namespace ops
+}  // namespace mace
@@ -0,0 +1,278 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_COMMON_REDUCE_H_
+#define MACE_OPS_COMMON_REDUCE_H_
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "mace/core/types.h"
+#include "mace/utils/macros.h"
+#include "mace/utils/thread_pool.h"
+
+namespace mace {
+namespace ops {
+
+// One pass of a reduction: the input is viewed as [outer, reduce, inner]
+// and reduced over the middle axis to [outer, inner].
+struct ReduceStep {
+  index_t outer;
+  index_t reduce;
+  index_t inner;
+};
+
+// Number of columns one task accumulates when reducing vertically.
+constexpr index_t kReduceColumnBlock = 64;
+
+// Coalesces the adjacent reduced and kept axes of `shape`, dropping the axes
+// of size 1, and returns the passes reducing them, innermost first. It is a
+// single pass unless reduced axes are separated by kept ones.
+std::vector<ReduceStep> PlanReduce(const std::vector<index_t> &shape,
+                                   const std::vector<bool> &reduced);
+
+// Number of chunks the reduce axis of `step` is split into so that threads
+// share it when there are too few outputs to parallelize over.
+index_t ReduceSplits(const ReduceStep &step);
+
+// Number of accumulators `steps` need besides the input and output: the
+// partial results of split passes and the results between passes.
+index_t ReduceScratchSize(const std::vector<ReduceStep> &steps);
+
+// The reduce operations, `Type` is the accumulator type.
+template<typename T>
+struct ReduceSumOp {
+  typedef T Type;
+  static T Init() { return static_cast<T>(0); }
+  static T Apply(T a, T b) { return a + b; }
+};
+
+template<typename T>
+struct ReduceProdOp {
+  typedef T Type;
+  static T Init() { return static_cast<T>(1); }
+  static T Apply(T a, T b) { return a * b; }
+};
+
+template<typename T>
+struct ReduceMinOp {
+  typedef T Type;
+  static T Init() {
+    return std::numeric_limits<T>::has_infinity ?
+           std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+  }
+  static T Apply(T a, T b) { return std::min(a, b); }
+};
+
+template<typename T>
+struct ReduceMaxOp {
+  typedef T Type;
+  static T Init() {
+    return std::numeric_limits<T>::has_infinity ?
+           -std::numeric_limits<T>::infinity() :
+           std::numeric_limits<T>::lowest();
+  }
+  static T Apply(T a, T b) { return std::max(a, b); }
+};
+
+// Reads the input elements as accumulators, `map(o, x)` is also given the
+// outer index o of the element.
+template<typename Acc>
+struct ReduceCast {
+  template<typename In>
+  Acc operator()(index_t o, In x) const {
+    MACE_UNUSED(o);
+    return static_cast<Acc>(x);
+  }
+};
+
+// Reduces the contiguous row `input` of `size` elements. Independent lanes
+// are accumulated so that the loop vectorizes, and then folded as a tree.
+template<typename Op, typename In, typename Map>
+typename Op::Type ReduceRow(const In *input, index_t size, index_t o,
+                            const Map &map) {
+  typedef typename Op::Type Acc;
+  constexpr int kLanes = 8;
+  Acc lanes[kLanes];
+  for (int l = 0; l < kLanes; ++l) {
+    lanes[l] = Op::Init();
+  }
+  index_t i = 0;
+  for (; i + kLanes <= size; i += kLanes) {
+    for (int l = 0; l < kLanes; ++l) {
+      lanes[l] = Op::Apply(lanes[l], map(o, input[i + l]));
+    }
+  }
+  for (int half = kLanes / 2; half > 0; half /= 2) {
+    for (int l = 0; l < half; ++l) {
+      lanes[l] = Op::Apply(lanes[l], lanes[l + half]);
+    }
+  }
+  Acc acc = lanes[0];
+  for (; i < size; ++i) {
+    acc = Op::Apply(acc, map(o, input[i]));
+  }
+  return acc;
+}
+
+// Accumulates `rows` rows of `width` elements, `stride` apart, into `acc`
+// element-wise.
+template<typename Op, typename In, typename Map>
+void ReduceColumns(const In *input, index_t rows, index_t stride,
+                   index_t width, index_t o, const Map &map,
+                   typename Op::Type *acc) {
+  for (index_t r = 0; r < rows; ++r) {
+    const In *row = input + r * stride;
+    for (index_t j = 0; j < width; ++j) {
+      acc[j] = Op::Apply(acc[j], map(o, row[j]));
+    }
+  }
+}
+
+// Runs one pass: output[o * inner + j] =
+//     finalize(reduce of map(o, input[(o * reduce + r) * inner + j]) over r).
+// Rows (inner == 1) are reduced horizontally and the others vertically, in
+// parallel over the outputs, or over chunks of the reduce axis combined in
+// `partials` when ReduceSplits(step) > 1.
+template<typename Op, typename In, typename Out, typename Map,
+    typename Finalize>
+void ReduceStepCompute(utils::ThreadPool *thread_pool,
+                       const In *input,
+                       const ReduceStep &step,
+                       const Map &map,
+                       const Finalize &finalize,
+                       typename Op::Type *partials,
+                       Out *output) {
+  typedef typename Op::Type Acc;
+  const index_t outer = step.outer;
+  const index_t reduce = step.reduce;
+  const index_t inner = step.inner;
+  const index_t splits = ReduceSplits(step);
+
+  if (splits == 1) {
+    if (inner == 1) {
+      thread_pool->Compute1D([=, &map, &finalize](index_t start, index_t end,
+                                                  index_t step) {
+        for (index_t o = start; o < end; o += step) {
+          output[o] = static_cast<Out>(finalize(
+              ReduceRow<Op>(input + o * reduce, reduce, o, map)));
+        }
+      }, 0, outer, 1);
+    } else {
+      thread_pool->Compute2D([=, &map, &finalize](index_t start0,
+                                                  index_t end0,
+                                                  index_t step0,
+                                                  index_t start1,
+                                                  index_t end1,
+                                                  index_t step1) {
+        Acc acc[kReduceColumnBlock];
+        for (index_t o = start0; o < end0; o += step0) {
+          for (index_t j = start1; j < end1; j += step1) {
+            const index_t width = std::min(kReduceColumnBlock, inner - j);
+            std::fill_n(acc, width, Op::Init());
+            ReduceColumns<Op>(input + o * reduce * inner + j, reduce, inner,
+                              width, o, map, acc);
+            Out *out = output + o * inner + j;
+            for (index_t k = 0; k < width; ++k) {
+              out[k] = static_cast<Out>(finalize(acc[k]));
+            }
+          }
+        }
+      }, 0, outer, 1, 0, inner, kReduceColumnBlock);
+    }
+    return;
+  }
+
+  // Split the reduce axis among the threads, then combine the chunks
+  const index_t chunk = (reduce + splits - 1) / splits;
+  const index_t out_size = outer * inner;
+  thread_pool->Compute2D([=, &map](index_t start0, index_t end0,
+                                   index_t step0, index_t start1,
+                                   index_t end1, index_t step1) {
+    for (index_t s = start0; s < end0; s += step0) {
+      const index_t begin = std::min(s * chunk, reduce);
+      const index_t rows = std::min(chunk, reduce - begin);
+      Acc *acc = partials + s * out_size;
+      for (index_t o = start1; o < end1; o += step1) {
+        if (inner == 1) {
+          acc[o] = ReduceRow<Op>(input + o * reduce + begin, rows, o, map);
+        } else {
+          std::fill_n(acc + o * inner, inner, Op::Init());
+          ReduceColumns<Op>(input + (o * reduce + begin) * inner, rows, inner,
+                            inner, o, map, acc + o * inner);
+        }
+      }
+    }
+  }, 0, splits, 1, 0, outer, 1);
+  thread_pool->Compute1D([=, &finalize](index_t start, index_t end,
+                                        index_t step) {
+    for (index_t i = start; i < end; i += step) {
+      Acc acc = partials[i];
+      for (index_t s = 1; s < splits; ++s) {
+        acc = Op::Apply(acc, partials[s * out_size + i]);
+      }
+      output[i] = static_cast<Out>(finalize(acc));
+    }
+  }, 0, out_size, 1);
+}
+
+// Runs the passes planned by PlanReduce, mapping the input elements with
+// `map` and the results with `finalize`. `scratch` holds
+// ReduceScratchSize(steps) accumulators.
+template<typename Op, typename In, typename Out, typename Map,
+    typename Finalize>
+void ReduceCompute(utils::ThreadPool *thread_pool,
+                   const In *input,
+                   const std::vector<ReduceStep> &steps,
+                   const Map &map,
+                   const Finalize &finalize,
+                   typename Op::Type *scratch,
+                   Out *output) {
+  typedef typename Op::Type Acc;
+  const size_t passes = steps.size();
+  if (passes == 1) {
+    ReduceStepCompute<Op>(thread_pool, input, steps[0], map, finalize,
+                          scratch, output);
+    return;
+  }
+
+  // The passes but the last one write to two buffers in turn, after the
+  // partials of the largest split pass
+  index_t partial_size = 0;
+  for (const auto &step : steps) {
+    const index_t splits = ReduceSplits(step);
+    if (splits > 1) {
+      partial_size = std::max(partial_size, splits * step.outer * step.inner);
+    }
+  }
+  Acc *results[2] = {scratch + partial_size,
+                     scratch + partial_size + steps[0].outer * steps[0].inner};
+  auto identity = [](Acc a) { return a; };
+  ReduceStepCompute<Op>(thread_pool, input, steps[0], map, identity, scratch,
+                        results[0]);
+  for (size_t i = 1; i + 1 < passes; ++i) {
+    ReduceStepCompute<Op>(thread_pool, results[(i - 1) % 2], steps[i],
+                          ReduceCast<Acc>(), identity, scratch,
+                          results[i % 2]);
+  }
+  ReduceStepCompute<Op>(thread_pool, results[(passes - 2) % 2],
+                        steps[passes - 1], ReduceCast<Acc>(), finalize,
+                        scratch, output);
+}
+
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_COMMON_REDUCE_H_
@@ -0,0 +1,63 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/ops/common/resize_plan.h"
+
+#include <cmath>
+
+namespace mace {
+namespace ops {
+
+void ResizeAxisPlan::Init(index_t out_size, int taps) {
+  size = out_size;
+  this->taps = taps;
+  indices.resize(out_size * taps);
+  weights.resize(out_size * taps);
+  fixed_weights.clear();
+}
+
+void ResizeAxisPlan::QuantizeWeights() {
+  const int one = 1 << kResizeWeightBits;
+  fixed_weights.resize(weights.size());
+  for (index_t i = 0; i < size; ++i) {
+    const float *weight = weights.data() + i * taps;
+    int16_t *fixed_weight = fixed_weights.data() + i * taps;
+    // The largest weight takes the rounding error.
+    int sum = 0;
+    int max_k = 0;
+    for (int k = 0; k < taps; ++k) {
+      fixed_weight[k] = static_cast<int16_t>(lrintf(weight[k] * one));
+      sum += fixed_weight[k];
+      if (weight[k] > weight[max_k]) {
+        max_k = k;
+      }
+    }
+    fixed_weight[max_k] += one - sum;
+  }
+}
+
+bool ResizePlan::Update(index_t in_height, index_t in_width,
+                        index_t out_height, index_t out_width,
+                        CoordinateTransformationMode mode) {
+  std::vector<index_t> key =
+      {in_height, in_width, out_height, out_width, mode};
+  if (key == key_) {
+    return false;
+  }
+  key_.swap(key);
+  return true;
+}
+
+}  // namespace ops
+}  // namespace mace
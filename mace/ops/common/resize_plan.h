@@ -0,0 +1,116 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_COMMON_RESIZE_PLAN_H_
+#define MACE_OPS_COMMON_RESIZE_PLAN_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "mace/core/types.h"
+#include "mace/utils/logging.h"
+#include "mace/ops/common/coordinate_transformation_mode.h"
+
+namespace mace {
+namespace ops {
+
+// Number of fractional bits of the fixed point weights, the weights of one
+// output sum up to exactly 1 << kResizeWeightBits.
+constexpr int kResizeWeightBits = 11;
+
+// Source indices and weights of one axis of a resize: output i reads the
+// inputs indices[i * taps + k] with weights[i * taps + k], 0 <= k < taps.
+struct ResizeAxisPlan {
+  void Init(index_t out_size, int taps);
+  // Fills fixed_weights from weights, rounding so that the taps of each
+  // output still sum up to one.
+  void QuantizeWeights();
+
+  index_t size = 0;
+  int taps = 0;
+  std::vector<index_t> indices;
+  std::vector<float> weights;
+  std::vector<int16_t> fixed_weights;
+};
+
+// The interpolation plan of a resize op. Computing indices and weights is
+// per output row and column, so it is done once and reused by every plane
+// until the input or output shape changes.
+class ResizePlan {
+ public:
+  // Returns true if the plan was built for another key and has to be
+  // rebuilt; the new key is recorded.
+  bool Update(index_t in_height, index_t in_width,
+              index_t out_height, index_t out_width,
+              CoordinateTransformationMode mode);
+
+  ResizeAxisPlan ys;
+  ResizeAxisPlan xs;
+
+ private:
+  std::vector<index_t> key_;
+};
+
+// Horizontally resized source rows of one plane. Consecutive output rows
+// mostly read the same source rows, which are then resized only once.
+template<typename T>
+class ResizeRowCache {
+ public:
+  ResizeRowCache(int num_rows, index_t row_size)
+      : buffer_(num_rows * row_size),
+        row_ids_(num_rows, -1),
+        row_size_(row_size) {}
+
+  void Clear() {
+    std::fill(row_ids_.begin(), row_ids_.end(), -1);
+  }
+
+  bool Contains(index_t y) const {
+    return std::find(row_ids_.begin(), row_ids_.end(), y) != row_ids_.end();
+  }
+
+  // Returns the buffer of source row y, which is one of the num_needed rows
+  // read by the current output row. If the row is not cached, a buffer not
+  // holding any needed row is returned with *cached set to false, and the
+  // caller has to fill it.
+  T *Row(index_t y, const index_t *needed, int num_needed, bool *cached) {
+    const int num_rows = static_cast<int>(row_ids_.size());
+    for (int i = 0; i < num_rows; ++i) {
+      if (row_ids_[i] == y) {
+        *cached = true;
+        return buffer_.data() + i * row_size_;
+      }
+    }
+    for (int i = 0; i < num_rows; ++i) {
+      if (std::find(needed, needed + num_needed, row_ids_[i])
+          == needed + num_needed) {
+        row_ids_[i] = y;
+        *cached = false;
+        return buffer_.data() + i * row_size_;
+      }
+    }
+    LOG(FATAL) << "Resize row cache is too small: " << num_rows;
+    return nullptr;
+  }
+
+ private:
+  std::vector<T> buffer_;
+  std::vector<index_t> row_ids_;
+  const index_t row_size_;
+};
+
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_COMMON_RESIZE_PLAN_H_
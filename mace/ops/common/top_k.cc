@@ -0,0 +1,219 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/ops/common/top_k.h"
+
+#if defined(MACE_ENABLE_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#include <algorithm>
+#include <limits>
+
+#include "mace/utils/logging.h"
+#include "mace/utils/math.h"
+
+namespace mace {
+namespace ops {
+
+namespace {
+// Values of a block are compared with the worst selected value at once.
+constexpr index_t kTopKBlockSize = 16;
+// Rows longer than two chunks are split into chunks selected in parallel.
+constexpr index_t kTopKChunkSize = 16384;
+
+template<bool Largest>
+inline bool Better(float a, float b) {
+  return Largest ? a > b : a < b;
+}
+
+template<bool Largest>
+struct BetterCandidate {
+  bool operator()(const TopKCandidate &a, const TopKCandidate &b) const {
+    return Better<Largest>(a.value, b.value)
+        || (a.value == b.value && a.index < b.index);
+  }
+};
+
+template<bool Largest>
+inline float BlockBest(const float *data) {
+#if defined(MACE_ENABLE_NEON)
+  float32x4_t v0 = vld1q_f32(data);
+  float32x4_t v1 = vld1q_f32(data + 4);
+  float32x4_t v2 = vld1q_f32(data + 8);
+  float32x4_t v3 = vld1q_f32(data + 12);
+  float32x2_t best;
+  if (Largest) {
+    v0 = vmaxq_f32(vmaxq_f32(v0, v1), vmaxq_f32(v2, v3));
+    best = vmax_f32(vget_low_f32(v0), vget_high_f32(v0));
+    best = vpmax_f32(best, best);
+  } else {
+    v0 = vminq_f32(vminq_f32(v0, v1), vminq_f32(v2, v3));
+    best = vmin_f32(vget_low_f32(v0), vget_high_f32(v0));
+    best = vpmin_f32(best, best);
+  }
+  return vget_lane_f32(best, 0);
+#elif defined(__SSE__)
+  __m128 v0 = _mm_loadu_ps(data);
+  __m128 v1 = _mm_loadu_ps(data + 4);
+  __m128 v2 = _mm_loadu_ps(data + 8);
+  __m128 v3 = _mm_loadu_ps(data + 12);
+  if (Largest) {
+    v0 = _mm_max_ps(_mm_max_ps(v0, v1), _mm_max_ps(v2, v3));
+    v0 = _mm_max_ps(v0, _mm_movehl_ps(v0, v0));
+    v0 = _mm_max_ss(v0, _mm_shuffle_ps(v0, v0, 1));
+  } else {
+    v0 = _mm_min_ps(_mm_min_ps(v0, v1), _mm_min_ps(v2, v3));
+    v0 = _mm_min_ps(v0, _mm_movehl_ps(v0, v0));
+    v0 = _mm_min_ss(v0, _mm_shuffle_ps(v0, v0, 1));
+  }
+  return _mm_cvtss_f32(v0);
+#else
+  float best = data[0];
+  for (index_t i = 1; i < kTopKBlockSize; ++i) {
+    best = Better<Largest>(data[i], best) ? data[i] : best;
+  }
+  return best;
+#endif
+}
+
+// Selects the top k of row[begin, end) into out, k <= end - begin.
+template<bool Largest>
+void SelectRange(const float *row, index_t begin, index_t end, index_t k,
+                 bool sorted, TopKCandidate *out) {
+  const BetterCandidate<Largest> better;
+  const index_t size = end - begin;
+  if (k > 1 && k * 8 >= size) {
+    // Few values are skipped with a large k, select among all of them.
+    std::vector<TopKCandidate> candidates(size);
+    for (index_t i = 0; i < size; ++i) {
+      candidates[i] = {row[begin + i], static_cast<int32_t>(begin + i)};
+    }
+    if (sorted) {
+      std::partial_sort(candidates.begin(), candidates.begin() + k,
+                        candidates.end(), better);
+    } else if (k < size) {
+      std::nth_element(candidates.begin(), candidates.begin() + k - 1,
+                       candidates.end(), better);
+    }
+    std::copy(candidates.begin(), candidates.begin() + k, out);
+    return;
+  }
+
+  // The root of the heap is the worst selected value, which every later
+  // value has to beat. Later values have larger indices, so an equal value
+  // never does.
+  TopKCandidate *heap = out;
+  for (index_t i = 0; i < k; ++i) {
+    heap[i] = {row[begin + i], static_cast<int32_t>(begin + i)};
+  }
+  std::make_heap(heap, heap + k, better);
+  auto push = [&](index_t i) {
+    if (Better<Largest>(row[i], heap[0].value)) {
+      std::pop_heap(heap, heap + k, better);
+      heap[k - 1] = {row[i], static_cast<int32_t>(i)};
+      std::push_heap(heap, heap + k, better);
+    }
+  };
+  index_t i = begin + k;
+  for (; i + kTopKBlockSize <= end; i += kTopKBlockSize) {
+    if (!Better<Largest>(BlockBest<Largest>(row + i), heap[0].value)) {
+      continue;
+    }
+    for (index_t j = i; j < i + kTopKBlockSize; ++j) {
+      push(j);
+    }
+  }
+  for (; i < end; ++i) {
+    push(i);
+  }
+  if (sorted) {
+    std::sort_heap(heap, heap + k, better);
+  }
+}
+
+template<bool Largest>
+void SelectRows(utils::ThreadPool *thread_pool, const float *input,
+                index_t rows, index_t size, index_t k, bool sorted,
+                std::vector<TopKCandidate> *chunk_candidates,
+                TopKCandidate *out) {
+  const index_t chunks =
+      size >= 2 * kTopKChunkSize ? RoundUpDiv(size, kTopKChunkSize) : 1;
+  if (chunks == 1) {
+    thread_pool->Compute1D([=](index_t start, index_t end, index_t step) {
+      for (index_t r = start; r < end; r += step) {
+        SelectRange<Largest>(input + r * size, 0, size, k, sorted,
+                             out + r * k);
+      }
+    }, 0, rows, 1, 0, static_cast<int>(size));
+    return;
+  }
+
+  // Each chunk keeps its own top k, the top k of a row is among them.
+  const index_t chunk_k = std::min(k, kTopKChunkSize);
+  chunk_candidates->resize(rows * chunks * chunk_k);
+  TopKCandidate *candidates = chunk_candidates->data();
+  thread_pool->Compute2D([=](index_t start0, index_t end0, index_t step0,
+                             index_t start1, index_t end1, index_t step1) {
+    for (index_t r = start0; r < end0; r += step0) {
+      for (index_t c = start1; c < end1; c += step1) {
+        const index_t begin = c * kTopKChunkSize;
+        const index_t end = std::min(size, begin + kTopKChunkSize);
+        TopKCandidate *chunk_out = candidates + (r * chunks + c) * chunk_k;
+        const index_t selected = std::min(chunk_k, end - begin);
+        SelectRange<Largest>(input + r * size, begin, end, selected, false,
+                             chunk_out);
+        // Only the last chunk may be shorter than chunk_k, it is padded
+        // with candidates worse than any value.
+        for (index_t i = selected; i < chunk_k; ++i) {
+          chunk_out[i] = {Largest ? -std::numeric_limits<float>::infinity()
+                                  : std::numeric_limits<float>::infinity(),
+                          std::numeric_limits<int32_t>::max()};
+        }
+      }
+    }
+  }, 0, rows, 1, 0, chunks, 1, 1, 1);
+
+  const BetterCandidate<Largest> better;
+  for (index_t r = 0; r < rows; ++r) {
+    TopKCandidate *row_candidates = candidates + r * chunks * chunk_k;
+    TopKCandidate *row_end = row_candidates + chunks * chunk_k;
+    if (sorted) {
+      std::partial_sort(row_candidates, row_candidates + k, row_end, better);
+    } else {
+      std::nth_element(row_candidates, row_candidates + k - 1, row_end,
+                       better);
+    }
+    std::copy(row_candidates, row_candidates + k, out + r * k);
+  }
+}
+}  // namespace
+
+void TopKSelector::Select(utils::ThreadPool *thread_pool, const float *input,
+                          index_t rows, index_t size, TopKCandidate *out) {
+  MACE_CHECK(k_ > 0 && k_ <= size, "top k ", k_, " is out of range [1, ",
+             size, "]");
+  if (largest_) {
+    SelectRows<true>(thread_pool, input, rows, size, k_, sorted_,
+                     &chunk_candidates_, out);
+  } else {
+    SelectRows<false>(thread_pool, input, rows, size, k_, sorted_,
+                      &chunk_candidates_, out);
+  }
+}
+
+}  // namespace ops
+}  // namespace mace
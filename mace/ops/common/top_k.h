@@ -0,0 +1,82 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_COMMON_TOP_K_H_
+#define MACE_OPS_COMMON_TOP_K_H_
+
+#include <type_traits>
+#include <vector>
+
+#include "mace/core/types.h"
+#include "mace/utils/thread_pool.h"
+
+namespace mace {
+namespace ops {
+
+struct TopKCandidate {
+  float value;
+  int32_t index;
+};
+
+// Selects the k largest (or smallest) values of every row, the engine of
+// TopK and ArgMax. Blocks of a row whose best value can not enter the
+// current top k are skipped after a SIMD max (or min), the other values go
+// through a heap of size k. Long rows are split into chunks which are
+// selected in parallel and merged.
+class TopKSelector {
+ public:
+  TopKSelector(index_t k, bool largest, bool sorted)
+      : k_(k), largest_(largest), sorted_(sorted) {}
+
+  // Selects from `rows` contiguous rows of `size` values, size >= k. The top
+  // k of row r are written to out[r * k, (r + 1) * k), best first if sorted.
+  // Equal values are ordered by their index.
+  void Select(utils::ThreadPool *thread_pool, const float *input,
+              index_t rows, index_t size, TopKCandidate *out);
+
+ private:
+  const index_t k_;
+  const bool largest_;
+  const bool sorted_;
+  std::vector<TopKCandidate> chunk_candidates_;
+};
+
+// Returns the values along the axis of an [outer, axis_dim, inner] tensor
+// as contiguous float rows, row o * inner + i holding the axis of (o, i).
+// The input itself is returned when it is already laid out so, otherwise
+// the rows are copied into buffer.
+template<typename T>
+const float *TopKRows(const T *input, index_t outer, index_t axis_dim,
+                      index_t inner, std::vector<float> *buffer) {
+  if (std::is_same<T, float>::value && inner == 1) {
+    return reinterpret_cast<const float *>(input);
+  }
+  buffer->resize(outer * axis_dim * inner);
+  float *rows = buffer->data();
+  for (index_t o = 0; o < outer; ++o) {
+    const T *in = input + o * axis_dim * inner;
+    float *out = rows + o * inner * axis_dim;
+    for (index_t d = 0; d < axis_dim; ++d) {
+      for (index_t i = 0; i < inner; ++i) {
+        out[i * axis_dim + d] = static_cast<float>(in[d * inner + i]);
+      }
+    }
+  }
+  return rows;
+}
+
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_COMMON_TOP_K_H_
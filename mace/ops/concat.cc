@@ -12,7 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "mace/core/ops/operator.h"
 #include "mace/core/registry/ops_registry.h"
@@ -60,12 +62,7 @@ class ConcatOp<RuntimeType::RT_CPU, T> : public ConcatOpBase {
 
   MaceStatus Run(OpContext *context) override {
     MACE_UNUSED(context);
-    int axis = FormatAxis();
-    if (has_data_format_ && this->Input(0)->dim_size() == 4) {
-      if (axis == 3) axis = 1;
-      else if (axis == 2) axis = 3;
-      else if (axis == 1) axis = 2;
-    }
+    const int axis = DataAxis(FormatAxis(), this->Input(0)->dim_size());
     const std::vector<const Tensor *> &inputs = this->Inputs();
     Tensor *output = this->Output(0);
     const Tensor *input0 = inputs.front();
@@ -97,28 +94,93 @@ class ConcatOp<RuntimeType::RT_CPU, T> : public ConcatOpBase {
 
     T *output_ptr = output->mutable_data<T>();
     std::vector<const T *> input_ptrs(inputs.size(), nullptr);
+    // Inputs placed as views of the output by the memory planner are already
+    // in place. The ones which overlap the output elsewhere, e.g. after the
+    // shapes changed, are staged before the output is written.
+    std::vector<bool> in_place(inputs_count, false);
+    std::vector<bool> staged(inputs_count, false);
+    index_t staged_size = 0;
+    index_t offset = 0;
     for (size_t i = 0; i < inputs_count; ++i) {
       input_ptrs[i] = inputs[i]->data<T>();
+      if (inner_size == 1 && input_ptrs[i] == output_ptr + offset) {
+        in_place[i] = true;
+      } else if (inputs[i]->SharesMemoryWith(*output)) {
+        staged[i] = true;
+        staged_size += inputs[i]->size();
+      }
+      offset += outer_sizes[i];
+    }
+    if (staged_size > 0) {
+      staged_inputs_.resize(staged_size);
+      T *staged_ptr = staged_inputs_.data();
+      for (size_t i = 0; i < inputs_count; ++i) {
+        if (staged[i]) {
+          std::copy_n(input_ptrs[i], inputs[i]->size(), staged_ptr);
+          input_ptrs[i] = staged_ptr;
+          staged_ptr += inputs[i]->size();
+        }
+      }
     }
+
     for (int inner_idx = 0; inner_idx < inner_size; ++inner_idx) {
       for (size_t i = 0; i < inputs_count; ++i) {
-        if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
-          memcpy(output_ptr, input_ptrs[i], outer_sizes[i] * sizeof(T));
-          output_ptr += outer_sizes[i];
-          input_ptrs[i] += outer_sizes[i];
-        } else {
-          for (index_t k = 0; k < outer_sizes[i]; ++k) {
-            *output_ptr++ = *input_ptrs[i]++;
+        if (!in_place[i]) {
+          if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
+            memcpy(output_ptr, input_ptrs[i], outer_sizes[i] * sizeof(T));
+          } else {
+            std::copy_n(input_ptrs[i], outer_sizes[i], output_ptr);
           }
         }
+        output_ptr += outer_sizes[i];
+        input_ptrs[i] += outer_sizes[i];
       }
     }
 
     return MaceStatus::MACE_SUCCESS;
   }
 
+  // The inputs are consecutive ranges of the output when all the dims before
+  // the axis are 1, e.g. the channels of NCHW with batch 1.
+  index_t InputViewOffset(size_t input_idx) const override {
+    const std::vector<const Tensor *> &inputs = this->Inputs();
+    const Tensor *output = outputs_[0];
+    const index_t rank = output->dim_size();
+    const int axis = DataAxis(axis_ < 0 ? axis_ + rank : axis_, rank);
+    if (input_idx >= inputs.size() || rank == 0 || axis < 0 || axis >= rank) {
+      return -1;
+    }
+    for (int i = 0; i < axis; ++i) {
+      if (output->dim(i) != 1) {
+        return -1;
+      }
+    }
+    index_t offset = 0;
+    index_t total_size = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (inputs[i]->dim_size() != rank) {
+        return -1;
+      }
+      if (i < input_idx) {
+        offset += inputs[i]->size();
+      }
+      total_size += inputs[i]->size();
+    }
+    return total_size == output->size() ? offset : -1;
+  }
+
  private:
+  int DataAxis(const int axis, const index_t rank) const {
+    if (has_data_format_ && rank == 4) {
+      if (axis == 3) return 1;
+      else if (axis == 2) return 3;
+      else if (axis == 1) return 2;
+    }
+    return axis;
+  }
+
   bool has_data_format_;
+  std::vector<T> staged_inputs_;
 };
 
 #ifdef MACE_ENABLE_QUANTIZE
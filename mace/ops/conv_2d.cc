@@ -88,7 +88,7 @@ class Conv2dOp<RuntimeType::RT_CPU, T> : public ConvPool2dOpBase {
     if (conv2d_delegator_ == nullptr) {
       auto tag = MACE_DELEGATOR_KEY(Conv2d,
                                     RuntimeType::RT_CPU, T, kCpuImplType);
-      if (kCpuImplType == NEON) {
+      if (kCpuImplType != REF) {
         // the following params are used to decide which conv delegator to use
         const index_t stride_h = strides_[0];
         const index_t stride_w = strides_[1];
@@ -160,6 +160,8 @@ class Conv2dOp<RuntimeType::RT_CPU, T> : public ConvPool2dOpBase {
             && dilation_w == 1) {
           tag = MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU, T,
                                       kCpuImplType, K15x1S1);
+        } else if (dilation_h > 1 || dilation_w > 1) {
+          tag = DilatedConv2dKey(input, filter);
         }
       }
       delegator::Conv2dParam param(strides_, dilations_,
@@ -176,6 +178,90 @@ class Conv2dOp<RuntimeType::RT_CPU, T> : public ConvPool2dOpBase {
   }
 
  private:
+  // Dilated convolutions (atrous CNNs, TDNNs) pick the variant with the least
+  // estimated cost: the direct kernels (stride 1 3x3, 1xN and Nx1 only), the
+  // im2col gemm, or the winograd of the sub-images (stride 1 3x3 only).
+  DelegatorInfo DilatedConv2dKey(const Tensor *input, const Tensor *filter) {
+    // Rough relative costs per multiply-accumulate or per copied element,
+    // the copies include the packing of the gemm
+    const float kDirectMacCost = 1.f;
+    const float kGemmMacCost = 0.5f;
+    const float kWinogradMacCost = 0.25f;
+    const float kCopyCost = 2.f;
+    // Larger im2col columns of an image do not pay off
+    const index_t kMaxColumnsSize = 1 << 24;
+
+    std::vector<index_t> output_shape(4);
+    std::vector<int> paddings(2);
+    if (paddings_.empty()) {
+      CalcNCHWPaddingAndOutputSize(input->shape().data(),
+                                   filter->shape().data(),
+                                   dilations_.data(), strides_.data(),
+                                   padding_type_, output_shape.data(),
+                                   paddings.data());
+    } else {
+      CalcNCHWOutputSize(input->shape().data(), filter->shape().data(),
+                         paddings_.data(), dilations_.data(), strides_.data(),
+                         RoundType::FLOOR, output_shape.data());
+    }
+    const index_t in_channels = input->dim(1);
+    const index_t out_channels = filter->dim(0);
+    const index_t filter_h = filter->dim(2);
+    const index_t filter_w = filter->dim(3);
+    const index_t out_height = output_shape[2];
+    const index_t out_width = output_shape[3];
+    const bool stride1 = strides_[0] == 1 && strides_[1] == 1;
+    const float depth = static_cast<float>(in_channels * filter_h * filter_w);
+    const float macs = depth * out_channels * out_height * out_width;
+
+    float min_cost = std::numeric_limits<float>::max();
+    auto key = MACE_DELEGATOR_KEY(Conv2d, RuntimeType::RT_CPU, T,
+                                  kCpuImplType);
+    if (depth * out_height * out_width <= kMaxColumnsSize) {
+      // The gemm computes blocks of 8 output channels
+      min_cost = macs * kGemmMacCost * RoundUp<index_t>(out_channels, 8)
+          / out_channels + depth * out_height * out_width * kCopyCost;
+      key = MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU, T,
+                                  kCpuImplType, KDilatedGemm);
+    }
+    if (stride1 && (filter_h == 1 || filter_w == 1
+        || (filter_h == 3 && filter_w == 3))) {
+      const float direct_cost = macs * kDirectMacCost;
+      if (direct_cost < min_cost) {
+        min_cost = direct_cost;
+        if (filter_h == 3 && filter_w == 3) {
+          key = MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU, T,
+                                      kCpuImplType, K3x3Dilated);
+        } else if (filter_h == 1) {
+          key = MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU, T,
+                                      kCpuImplType, K1xNDilated);
+        } else {
+          key = MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU, T,
+                                      kCpuImplType, KNx1Dilated);
+        }
+      }
+    }
+    if (stride1 && filter_h == 3 && filter_w == 3
+        && in_channels >= 8 && out_channels >= 8) {
+      // The winograd computes output tiles of 4x4 or more
+      const index_t sub_height =
+          RoundUp<index_t>(RoundUpDiv<index_t>(out_height, dilations_[0]), 4);
+      const index_t sub_width =
+          RoundUp<index_t>(RoundUpDiv<index_t>(out_width, dilations_[1]), 4);
+      const float sub_area =
+          static_cast<float>(dilations_[0] * dilations_[1]) *
+              sub_height * sub_width;
+      const float winograd_cost =
+          depth * out_channels * sub_area * kWinogradMacCost
+              + (in_channels + out_channels) * sub_area * kCopyCost;
+      if (winograd_cost < min_cost) {
+        key = MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU, T,
+                                    kCpuImplType, K3x3DilatedWinograd);
+      }
+    }
+    return key;
+  }
+
   std::unique_ptr<delegator::Activation> activation_delegator_;
   std::unique_ptr<delegator::BiasAdd> bias_add_delegator_;
   std::unique_ptr<delegator::Conv2d> conv2d_delegator_;
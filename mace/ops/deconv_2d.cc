@@ -89,7 +89,7 @@ class Deconv2dOp<RuntimeType::RT_CPU, T> : public Deconv2dOpBase {
     if (deconv2d_delegator_ == nullptr) {
       auto tag = MACE_DELEGATOR_KEY(Deconv2d, RuntimeType::RT_CPU,
                                     T, kCpuImplType);
-      if (kCpuImplType == NEON) {
+      if (kCpuImplType != REF) {
         const index_t kernel_h = filter->dim(2);
         const index_t kernel_w = filter->dim(3);
 
@@ -108,7 +108,14 @@ class Deconv2dOp<RuntimeType::RT_CPU, T> : public Deconv2dOpBase {
         bool use_neon_4x4_s2 = kernel_h == kernel_w && kernel_h == 4 &&
             strides_[0] == strides_[1] && strides_[0] == 2;
 
-        if (use_neon_2x2_s1) {
+        const bool has_direct_kernel = use_neon_2x2_s1 || use_neon_2x2_s2 ||
+            use_neon_3x3_s1 || use_neon_3x3_s2 ||
+            use_neon_4x4_s1 || use_neon_4x4_s2;
+
+        if (UseGemmDeconv(input, filter, has_direct_kernel)) {
+          tag = MACE_DELEGATOR_KEY_EX(Deconv2d, RuntimeType::RT_CPU, T,
+                                      kCpuImplType, KGemm);
+        } else if (use_neon_2x2_s1) {
           tag = MACE_DELEGATOR_KEY_EX(Deconv2d, RuntimeType::RT_CPU, T,
                                       kCpuImplType, K2x2S1);
         } else if (use_neon_2x2_s2) {
@@ -143,6 +150,30 @@ class Deconv2dOp<RuntimeType::RT_CPU, T> : public Deconv2dOpBase {
   }
 
  private:
+  // The gemm + col2im variant replaces the scatter loops of the general
+  // kernel once in_channels is large enough to keep the gemm busy, and the
+  // direct kernels only when both channel counts are large.
+  bool UseGemmDeconv(const Tensor *input, const Tensor *filter,
+                     const bool has_direct_kernel) {
+    const index_t kMinChannels = 8;
+    const index_t kMinChannelsOverDirect = 64;
+    // Larger columns of an image do not pay off
+    const index_t kMaxColumnsSize = 1 << 24;
+
+    const index_t in_channels = input->dim(1);
+    const index_t out_channels = filter->dim(0);
+    const index_t columns_size = out_channels * filter->dim(2)
+        * filter->dim(3) * input->dim(2) * input->dim(3);
+    if (columns_size > kMaxColumnsSize) {
+      return false;
+    }
+    if (has_direct_kernel) {
+      return in_channels >= kMinChannelsOverDirect &&
+          out_channels >= kMinChannelsOverDirect;
+    }
+    return in_channels >= kMinChannels;
+  }
+
   std::unique_ptr<delegator::Activation> activation_delegator_;
   std::unique_ptr<delegator::BiasAdd> bias_add_delegator_;
   std::unique_ptr<delegator::Deconv2d> deconv2d_delegator_;
@@ -39,6 +39,11 @@ enum ConvType {
   K7x7S1,
   K7x7S2,
   K7x7S3,
+  K3x3Dilated,
+  K3x3DilatedWinograd,
+  K1xNDilated,
+  KNx1Dilated,
+  KDilatedGemm,
 };
 
 namespace delegator {
@@ -33,6 +33,7 @@ enum DeconvType {
   K3x3S2,
   K4x4S1,
   K4x4S2,
+  KGemm,
 };
 
 namespace delegator {
@@ -19,6 +19,7 @@
 #include "mace/core/ops/op_context.h"
 #include "mace/core/ops/op_delegator.h"
 #include "mace/core/registry/op_delegator_registry.h"
+#include "mace/ops/common/gemm_epilogue.h"
 #include "mace/ops/common/matrix.h"
 
 namespace mace {
@@ -67,6 +68,19 @@ class Gemm : public OpDelegator {
                              const bool lhs_batched,
                              const bool rhs_batched,
                              Tensor *output) = 0;
+  // output = activation(lhs * rhs + bias), the output is row-major, and
+  // the bias and activation are applied while each output tile is written.
+  // The packed rhs is cached if it is a weight and should_cache_pack is set.
+  virtual MaceStatus ComputeWithEpilogue(const OpContext *context,
+                                         const Tensor *lhs,
+                                         const Tensor *rhs,
+                                         const index_t rows,
+                                         const index_t cols,
+                                         const index_t depth,
+                                         const MatrixMajor lhs_major,
+                                         const MatrixMajor rhs_major,
+                                         const GemmEpilogue &epilogue,
+                                         Tensor *output) = 0;
 };
 
 }  // namespace delegator
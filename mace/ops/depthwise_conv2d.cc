@@ -100,7 +100,7 @@ class DepthwiseConv2dOp<RuntimeType::RT_CPU, T> : public DepthwiseConv2dOpBase {
     if (depthwise_conv2d_delegator_ == nullptr) {
       auto tag = MACE_DELEGATOR_KEY(DepthwiseConv2d, RuntimeType::RT_CPU,
                                     T, ImplType::REF);
-      if (kCpuImplType == NEON) {
+      if (kCpuImplType != REF) {
         const index_t filter_h = filter->dim(2);
         const index_t filter_w = filter->dim(3);
         const index_t stride_h = strides_[0];
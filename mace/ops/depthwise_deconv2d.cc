@@ -78,7 +78,7 @@ class DepthwiseDeconv2dOp<RuntimeType::RT_CPU, T>
     bool is_depthwise = group_ == in_channels;
 
     if (depthwise_deconv2d_delegator_ == nullptr) {
-      if (kCpuImplType == NEON) {
+      if (kCpuImplType != REF) {
         const index_t kernel_h = filter->dim(2);
         const index_t kernel_w = filter->dim(3);
         bool use_neon_3x3_s1 = kernel_h == kernel_w && kernel_h == 3 &&
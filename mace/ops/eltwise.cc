@@ -975,7 +975,8 @@ class EltwiseOp : public Operation {
       if (scalar_tensor_ == nullptr) {
         scalar_tensor_.reset(new Tensor(
             runtime, input0->dtype(), MemoryType::CPU_BUFFER));
-        runtime->AllocateBufferForTensor(scalar_tensor_.get(), RENT_SCRATCH);
+        // Kept across runs, the scratch memory only lives through one op
+        runtime->AllocateBufferForTensor(scalar_tensor_.get(), RENT_PRIVATE);
       }
       auto scalar_data = scalar_tensor_->mutable_data<T>();
       scalar_data[0] = static_cast<T>(scalar_input_);
@@ -995,6 +996,12 @@ class EltwiseOp : public Operation {
     }
   }
 
+  // The operands with the output's shape are read once per element, the
+  // broadcast ones are staged in DoEltwise if they share the output's memory.
+  bool SupportsInPlace(size_t output_idx, size_t input_idx) const override {
+    return output_idx == 0 && input_idx < 2;
+  }
+
  private:
   template<typename DstType>
   MaceStatus DoEltwise(const OpContext *context,
@@ -1064,6 +1071,7 @@ class EltwiseOp : public Operation {
     if (has_data_format_ && input0->dim_size() == 4 && input1->dim_size() > 0) {
       MACE_RETURN_IF_ERROR(output->ResizeLike(input0));
       DstType *output_ptr = output->mutable_data<DstType>();
+      StageBroadcastOperands(input0, input1, output, &input0_ptr, &input1_ptr);
       if (input1->dim_size() < input0->dim_size()) {
         TensorEltwisePerChannel(context,
                                 type_,
@@ -1098,6 +1106,7 @@ class EltwiseOp : public Operation {
       }
       MACE_RETURN_IF_ERROR(output->Resize(output_shape));
       DstType *output_ptr = output->mutable_data<DstType>();
+      StageBroadcastOperands(input0, input1, output, &input0_ptr, &input1_ptr);
 
       bool need_general_broadcast = false;
       for (uint32_t i = 0; i < input1->dim_size(); ++i) {
@@ -1133,6 +1142,38 @@ class EltwiseOp : public Operation {
     return MaceStatus::MACE_SUCCESS;
   }
 
+  // An operand smaller than the output is read repeatedly, so it is copied
+  // out first if the output is computed into its memory.
+  void StageBroadcastOperands(const Tensor *input0,
+                              const Tensor *input1,
+                              const Tensor *output,
+                              const T **input0_ptr,
+                              const T **input1_ptr) {
+    const Tensor *inputs[] = {input0, input1};
+    const T **input_ptrs[] = {input0_ptr, input1_ptr};
+    bool staged[] = {false, false};
+    index_t staged_size = 0;
+    for (int i = 0; i < 2; ++i) {
+      if (inputs[i]->size() != output->size() &&
+          inputs[i]->SharesMemoryWith(*output)) {
+        staged[i] = true;
+        staged_size += inputs[i]->size();
+      }
+    }
+    if (staged_size == 0) {
+      return;
+    }
+    staged_inputs_.resize(staged_size);
+    T *staged_ptr = staged_inputs_.data();
+    for (int i = 0; i < 2; ++i) {
+      if (staged[i]) {
+        std::copy_n(*input_ptrs[i], inputs[i]->size(), staged_ptr);
+        *input_ptrs[i] = staged_ptr;
+        staged_ptr += inputs[i]->size();
+      }
+    }
+  }
+
  private:
   EltwiseType type_;
   std::vector<float> coeff_;
@@ -1141,6 +1182,7 @@ class EltwiseOp : public Operation {
   int has_data_format_;
   bool is_fallback_;
   std::unique_ptr<Tensor> scalar_tensor_;
+  std::vector<T> staged_inputs_;
 };
 
 #ifdef MACE_ENABLE_QUANTIZE
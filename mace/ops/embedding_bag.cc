@@ -0,0 +1,254 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "mace/core/ops/operator.h"
+#include "mace/core/quantize.h"
+#include "mace/core/registry/ops_registry.h"
+#include "mace/ops/common/embedding_utils.h"
+#include "mace/ops/common/reduce_type.h"
+
+namespace mace {
+namespace ops {
+
+// Looks up the rows of an embedding table and pools every bag of them, a
+// bag being the last dimension of the indices. It is the fused form of
+// Gather(axis = 0) followed by a sum, mean or max Reduce over the bag, which
+// never materializes the gathered rows.
+template<RuntimeType D, class T>
+class EmbeddingBagOp;
+
+class EmbeddingBagOpBase : public Operation {
+ public:
+  explicit EmbeddingBagOpBase(OpConstructContext *context)
+      : Operation(context),
+        reduce_type_(static_cast<ReduceType>(
+                         Operation::GetOptionalArg<int>(
+                             "reduce_type", static_cast<int>(SUM)))),
+        keep_dims_(Operation::GetOptionalArg<bool>("keepdims", false)) {}
+
+ protected:
+  MaceStatus Validate(OpContext *context) {
+    MACE_UNUSED(context);
+    const Tensor *params = this->Input(PARAMS);
+    const Tensor *indices = this->Input(INDICES);
+    Tensor *output = this->Output(OUTPUT);
+    MACE_CHECK(reduce_type_ == SUM || reduce_type_ == MEAN
+                   || reduce_type_ == MAX,
+               "EmbeddingBag only supports sum, mean and max pooling, got ",
+               static_cast<int>(reduce_type_));
+    MACE_CHECK(params->dim_size() >= 1 && indices->dim_size() >= 1,
+               "EmbeddingBag needs a table and at least rank 1 indices");
+    bag_size_ = indices->dim(indices->dim_size() - 1);
+    MACE_CHECK(bag_size_ > 0, "EmbeddingBag bags should not be empty");
+    num_bags_ = indices->size() / bag_size_;
+    vocab_size_ = params->dim(0);
+    row_size_ = params->size() / vocab_size_;
+
+    std::vector<index_t> output_shape(indices->shape().begin(),
+                                      indices->shape().end() - 1);
+    if (keep_dims_) {
+      output_shape.push_back(1);
+    }
+    output_shape.insert(output_shape.end(), params->shape().begin() + 1,
+                        params->shape().end());
+    return output->Resize(output_shape);
+  }
+
+  ReduceType reduce_type_;
+  bool keep_dims_;
+  index_t bag_size_;
+  index_t num_bags_;
+  index_t vocab_size_;
+  index_t row_size_;
+
+  MACE_OP_INPUT_TAGS(PARAMS, INDICES);
+  MACE_OP_OUTPUT_TAGS(OUTPUT);
+};
+
+template<class T>
+class EmbeddingBagOp<RuntimeType::RT_CPU, T> : public EmbeddingBagOpBase {
+ public:
+  explicit EmbeddingBagOp(OpConstructContext *context)
+      : EmbeddingBagOpBase(context) {}
+
+  MaceStatus Run(OpContext *context) override {
+    MACE_RETURN_IF_ERROR(Validate(context));
+    Tensor *output = this->Output(OUTPUT);
+    if (output->dtype() == DataTypeToEnum<T>::v()) {
+      Compute(context, output->mutable_data<T>());
+    } else {
+      // A half precision table is pooled into a float output directly.
+      MACE_CHECK(DataTypeToEnum<T>::v() == DT_FLOAT16
+                     && output->dtype() == DT_FLOAT,
+                 "EmbeddingBag does not support converting ",
+                 DataTypeToEnum<T>::v(), " to ", output->dtype());
+      Compute(context, output->mutable_data<float>());
+    }
+    return MaceStatus::MACE_SUCCESS;
+  }
+
+ private:
+  template<typename DstT>
+  void Compute(const OpContext *context, DstT *output_data) {
+    const T *params_data = this->Input(PARAMS)->template data<T>();
+    const int32_t *indices_data =
+        this->Input(INDICES)->template data<int32_t>();
+    const ReduceType reduce_type = reduce_type_;
+    const index_t bag_size = bag_size_;
+    const index_t vocab_size = vocab_size_;
+    const index_t row_size = row_size_;
+    const index_t row_bytes = row_size * sizeof(T);
+
+    utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+    thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
+      // Rows are accumulated in float whatever the table type is.
+      std::vector<float> sum(row_size);
+      const index_t last = end * bag_size;
+      for (index_t b = start; b < end; b += step) {
+        const int32_t *bag = indices_data + b * bag_size;
+        for (index_t j = 0; j < bag_size; ++j) {
+          const index_t ahead =
+              b * bag_size + j + kEmbeddingPrefetchDistance;
+          if (ahead < last) {
+            PrefetchRow(params_data + indices_data[ahead] * row_size,
+                        row_bytes);
+          }
+          MACE_ASSERT(bag[j] >= 0 && bag[j] < vocab_size,
+                      "idx out of bound: ", bag[j]);
+          const T *row = params_data + bag[j] * row_size;
+          if (j == 0) {
+            CopyRow(row, row_size, sum.data());
+          } else if (reduce_type == MAX) {
+            for (index_t i = 0; i < row_size; ++i) {
+              sum[i] = std::max(sum[i], static_cast<float>(row[i]));
+            }
+          } else {
+            for (index_t i = 0; i < row_size; ++i) {
+              sum[i] += static_cast<float>(row[i]);
+            }
+          }
+        }
+        if (reduce_type == MEAN) {
+          const float inv_bag_size = 1.f / bag_size;
+          for (index_t i = 0; i < row_size; ++i) {
+            sum[i] *= inv_bag_size;
+          }
+        }
+        CopyRow(sum.data(), row_size, output_data + b * row_size);
+      }
+    }, 0, num_bags_, 1, 0, static_cast<int>(bag_size * row_size));
+  }
+};
+
+#ifdef MACE_ENABLE_QUANTIZE
+template<>
+class EmbeddingBagOp<RuntimeType::RT_CPU, uint8_t>
+    : public EmbeddingBagOpBase {
+ public:
+  explicit EmbeddingBagOp(OpConstructContext *context)
+      : EmbeddingBagOpBase(context) {}
+
+  MaceStatus Run(OpContext *context) override {
+    const Tensor *params = this->Input(PARAMS);
+    Tensor *output = this->Output(OUTPUT);
+    if (reduce_type_ != SUM) {
+      // Use the same scale and zero point with the table and output.
+      output->SetScale(params->scale());
+      output->SetZeroPoint(params->zero_point());
+    }
+    MACE_RETURN_IF_ERROR(Validate(context));
+
+    const uint8_t *params_data = params->data<uint8_t>();
+    const int32_t *indices_data = this->Input(INDICES)->data<int32_t>();
+    uint8_t *output_data = output->mutable_data<uint8_t>();
+    const ReduceType reduce_type = reduce_type_;
+    const index_t bag_size = bag_size_;
+    const index_t vocab_size = vocab_size_;
+    const index_t row_size = row_size_;
+    const int32_t in_zero_point = params->zero_point();
+    const int32_t out_zero_point = output->zero_point();
+    const float scale = params->scale() / output->scale();
+
+    utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+    thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
+      std::vector<int32_t> sum(row_size);
+      const index_t last = end * bag_size;
+      for (index_t b = start; b < end; b += step) {
+        const int32_t *bag = indices_data + b * bag_size;
+        for (index_t j = 0; j < bag_size; ++j) {
+          const index_t ahead =
+              b * bag_size + j + kEmbeddingPrefetchDistance;
+          if (ahead < last) {
+            PrefetchRow(params_data + indices_data[ahead] * row_size,
+                        row_size);
+          }
+          MACE_ASSERT(bag[j] >= 0 && bag[j] < vocab_size,
+                      "idx out of bound: ", bag[j]);
+          const uint8_t *row = params_data + bag[j] * row_size;
+          if (j == 0) {
+            CopyRow(row, row_size, sum.data());
+          } else if (reduce_type == MAX) {
+            for (index_t i = 0; i < row_size; ++i) {
+              sum[i] = std::max<int32_t>(sum[i], row[i]);
+            }
+          } else {
+            for (index_t i = 0; i < row_size; ++i) {
+              sum[i] += row[i];
+            }
+          }
+        }
+        uint8_t *out = output_data + b * row_size;
+        if (reduce_type == MAX) {
+          CopyRow(sum.data(), row_size, out);
+        } else if (reduce_type == MEAN) {
+          for (index_t i = 0; i < row_size; ++i) {
+            out[i] = static_cast<uint8_t>(
+                (sum[i] + bag_size / 2) / bag_size);
+          }
+        } else {
+          for (index_t i = 0; i < row_size; ++i) {
+            const float f = (sum[i] - in_zero_point * bag_size) * scale;
+            out[i] = Saturate<uint8_t>(std::roundf(f + out_zero_point));
+          }
+        }
+      }
+    }, 0, num_bags_, 1, 0, static_cast<int>(bag_size * row_size));
+
+    return MaceStatus::MACE_SUCCESS;
+  }
+};
+#endif  // MACE_ENABLE_QUANTIZE
+
+void RegisterEmbeddingBag(OpRegistry *op_registry) {
+  MACE_REGISTER_OP(op_registry, "EmbeddingBag", EmbeddingBagOp,
+                   RuntimeType::RT_CPU, float);
+  MACE_REGISTER_BF16_OP(op_registry, "EmbeddingBag", EmbeddingBagOp,
+                        RuntimeType::RT_CPU);
+
+#ifdef MACE_ENABLE_QUANTIZE
+  MACE_REGISTER_OP(op_registry, "EmbeddingBag", EmbeddingBagOp,
+                   RuntimeType::RT_CPU, uint8_t);
+#endif  // MACE_ENABLE_QUANTIZE
+#if defined(MACE_ENABLE_NEON) && defined(__ANDROID__)
+  MACE_REGISTER_OP(op_registry, "EmbeddingBag", EmbeddingBagOp,
+                   RuntimeType::RT_CPU, float16_t);
+#endif
+}
+
+}  // namespace ops
+}  // namespace mace
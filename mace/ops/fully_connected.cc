@@ -22,6 +22,7 @@
 #include "mace/core/tensor.h"
 #include "mace/ops/activation.h"
 #include "mace/ops/delegator/activation.h"
+#include "mace/ops/delegator/gemm.h"
 #include "mace/ops/delegator/gemv.h"
 
 #ifdef MACE_ENABLE_OPENCL
@@ -57,6 +58,10 @@ class FullyConnectedOpBase : public Operation {
 template<RuntimeType D, class T>
 class FullyConnectedOp;
 
+// From this batch size on, the weight is packed once and multiplied by
+// blocks of the batch instead of being streamed once per batch row
+constexpr index_t kFullyConnectedGemmMinBatch = 4;
+
 template<class T>
 class FullyConnectedOp<RuntimeType::RT_CPU, T> : public FullyConnectedOpBase {
  public:
@@ -77,7 +82,19 @@ class FullyConnectedOp<RuntimeType::RT_CPU, T> : public FullyConnectedOpBase {
         gemv_(delegator::Gemv::Create(
             context->workspace(),
             MACE_DELEGATOR_KEY(Gemv, RuntimeType::RT_CPU, T, kCpuImplType),
-            DelegatorParam())) {}
+            DelegatorParam())),
+        gemm_(delegator::Gemm::Create(
+            context->workspace(),
+            MACE_DELEGATOR_KEY(Gemm, RuntimeType::RT_CPU, T, kCpuImplType),
+            delegator::GemmParam(true))) {
+    epilogue_.activation = activation_;
+    epilogue_.relux_max_limit = relux_max_limit_;
+    epilogue_.activation_coefficient = activation_coefficient_;
+    epilogue_.hardsigmoid_alpha =
+        Operation::GetOptionalArg<float>("hardsigmoid_alpha", 0.f);
+    epilogue_.hardsigmoid_beta =
+        Operation::GetOptionalArg<float>("hardsigmoid_beta", 0.f);
+  }
 
   MaceStatus Run(OpContext *context) override {
     MACE_UNUSED(context);
@@ -104,6 +121,23 @@ class FullyConnectedOp<RuntimeType::RT_CPU, T> : public FullyConnectedOpBase {
     const index_t input_size = weight->dim(1) * weight->dim(2) * weight->dim(3);
     const index_t output_size = weight->dim(0);
 
+    if (batch >= kFullyConnectedGemmMinBatch &&
+        GemmEpilogue::IsSupported(activation_)) {
+      // output(batch, output_size) = input(batch, input_size) * weight^T,
+      // the OIHW weight is a column-major (input_size, output_size) matrix
+      epilogue_.bias = bias;
+      return gemm_->ComputeWithEpilogue(context,
+                                        input,
+                                        weight,
+                                        batch,
+                                        output_size,
+                                        input_size,
+                                        RowMajor,
+                                        ColMajor,
+                                        epilogue_,
+                                        output);
+    }
+
     gemv_->Compute(context,
                    weight,
                    input,
@@ -123,6 +157,8 @@ class FullyConnectedOp<RuntimeType::RT_CPU, T> : public FullyConnectedOpBase {
  private:
   std::unique_ptr<delegator::Activation> activation_delegator_;
   std::unique_ptr<delegator::Gemv> gemv_;
+  std::unique_ptr<delegator::Gemm> gemm_;
+  GemmEpilogue epilogue_;
 };
 
 #ifdef MACE_ENABLE_QUANTIZE
@@ -16,10 +16,43 @@
 
 #include "mace/core/ops/operator.h"
 #include "mace/core/registry/ops_registry.h"
+#include "mace/ops/common/embedding_utils.h"
 
 namespace mace {
 namespace ops {
 
+namespace {
+template <typename SrcT, typename DstT>
+void GatherRows(const OpContext *context,
+                const SrcT *params_data,
+                const int32_t *indices_data,
+                const index_t lhs_size,
+                const index_t axis_dim_size,
+                const index_t index_size,
+                const index_t rhs_size,
+                DstT *output_data) {
+  const index_t row_bytes = rhs_size * sizeof(SrcT);
+  utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+  thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
+                            index_t start1, index_t end1, index_t step1) {
+    for (index_t l = start0; l < end0; l += step0) {
+      const SrcT *lhs_params = params_data + l * axis_dim_size * rhs_size;
+      DstT *lhs_output = output_data + l * index_size * rhs_size;
+      for (index_t idx = start1; idx < end1; idx += step1) {
+        const index_t ahead = idx + kEmbeddingPrefetchDistance * step1;
+        if (ahead < end1) {
+          PrefetchRow(lhs_params + indices_data[ahead] * rhs_size, row_bytes);
+        }
+        MACE_ASSERT(indices_data[idx] < axis_dim_size, "idx out of bound: ",
+                    indices_data[idx]);
+        CopyRow(lhs_params + indices_data[idx] * rhs_size, rhs_size,
+                lhs_output + idx * rhs_size);
+      }
+    }
+  }, 0, lhs_size, 1, 0, index_size, 1, 0, 0, static_cast<int>(rhs_size));
+}
+}  // namespace
+
 template <RuntimeType D, class T>
 class GatherOp : public Operation {
  public:
@@ -28,7 +61,6 @@ class GatherOp : public Operation {
         axis_(Operation::GetOptionalArg<int>("axis", 0)) {}
 
   MaceStatus Run(OpContext *context) override {
-    MACE_UNUSED(context);
     const Tensor *params = this->Input(PARAMS);
     const Tensor *indices = this->Input(INDICES);
     Tensor *output = this->Output(OUTPUT);
@@ -49,7 +81,6 @@ class GatherOp : public Operation {
 
     const int32_t *indices_data = indices->data<int32_t>();
     const T *params_data = params->data<T>();
-    T *output_data = output->mutable_data<T>();
 
     const index_t axis_dim_size = params->dim(axis_);
     const index_t lhs_size = std::accumulate(params->shape().begin(),
@@ -60,15 +91,17 @@ class GatherOp : public Operation {
                         params->shape().end(), 1, std::multiplies<index_t>());
     const index_t index_size = indices->size();
 
-    for (index_t l = 0; l < lhs_size; ++l) {
-      for (index_t idx = 0; idx < index_size; ++idx) {
-        MACE_ASSERT(indices_data[idx] < axis_dim_size, "idx out of bound: ",
-                    indices_data[idx]);
-        memcpy(
-            output_data + ((l * index_size) + idx) * rhs_size,
-            params_data + ((l * axis_dim_size) + indices_data[idx]) * rhs_size,
-            sizeof(T) * rhs_size);
-      }
+    if (output->dtype() == params->dtype()) {
+      GatherRows(context, params_data, indices_data, lhs_size, axis_dim_size,
+                 index_size, rhs_size, output->mutable_data<T>());
+    } else {
+      // A half precision table is widened while gathering, which saves the
+      // Cast op after the lookup.
+      MACE_CHECK(params->dtype() == DT_FLOAT16 && output->dtype() == DT_FLOAT,
+                 "Gather does not support converting ", params->dtype(),
+                 " to ", output->dtype());
+      GatherRows(context, params_data, indices_data, lhs_size, axis_dim_size,
+                 index_size, rhs_size, output->mutable_data<float>());
     }
 
     output->SetScale(params->scale());
@@ -0,0 +1,179 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "mace/core/ops/operator.h"
+#include "mace/core/registry/ops_registry.h"
+#include "mace/ops/recurrent_base.h"
+#include "mace/utils/math.h"
+
+namespace mace {
+namespace ops {
+
+// GRU over a whole sequence, with the ONNX gate order z, r, h:
+//   z = sigmoid(x_z + h_prev * R_z^T + b_z), r alike
+//   n = tanh(x_h + (r * h_prev) * R_h^T + b_h), or with linear_before_reset
+//   n = tanh(x_h + r * (h_prev * R_h^T + Rb_h))
+//   h = (1 - z) * n + z * h_prev
+// where x is the hoisted input projection.
+template<RuntimeType D, class T>
+class GRUOp;
+
+template<>
+class GRUOp<RuntimeType::RT_CPU, float> : public RecurrentOpBase {
+ public:
+  explicit GRUOp(OpConstructContext *context)
+      : RecurrentOpBase(context, 3),
+        linear_before_reset_(
+            Operation::GetOptionalArg<bool>("linear_before_reset", false)) {}
+
+  MaceStatus Run(OpContext *context) override {
+    MACE_RETURN_IF_ERROR(Prepare());
+    MACE_CHECK(this->InputSize() <= INITIAL_C,
+               "GRU has no initial cell state");
+    const Tensor *recurrence = this->Input(RECURRENCE);
+    const index_t hidden = hidden_size_;
+    const index_t gate_size = 3 * hidden;
+    if (update_reset_weights_.empty() || !recurrence->is_weight()) {
+      update_reset_weights_.resize(directions_);
+      hidden_weights_.resize(directions_);
+      for (index_t d = 0; d < directions_; ++d) {
+        const float *r_data = recurrence->data<float>()
+            + d * gate_size * hidden;
+        update_reset_weights_[d].Pack(r_data, 2 * hidden, hidden);
+        hidden_weights_[d].Pack(r_data + 2 * hidden * hidden, hidden,
+                                hidden);
+      }
+    }
+
+    // The recurrent bias of the hidden gate is inside the reset with
+    // linear_before_reset, it is added at each step then.
+    std::unique_ptr<Tensor> projection;
+    MACE_RETURN_IF_ERROR(
+        ProjectInput(context, linear_before_reset_ ? 2 : 3, &projection));
+
+    utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+    const index_t batch = batch_;
+    const index_t directions = directions_;
+    const index_t projection_stride = directions * gate_size;
+    const float clip = clip_;
+    const float *projection_data = projection->data<float>();
+    const float *bias_data = this->Input(BIAS)->data<float>();
+    float *output_data = this->Output(OUTPUT)->mutable_data<float>();
+    update_reset_.resize(batch * 2 * hidden);
+    hidden_gate_.resize(batch * hidden);
+    reset_hidden_.resize(batch * hidden);
+    float *update_reset = update_reset_.data();
+    float *hidden_gate = hidden_gate_.data();
+    float *reset_hidden = reset_hidden_.data();
+
+    for (index_t d = 0; d < directions; ++d) {
+      const float *hidden_bias =
+          bias_data + d * 2 * gate_size + gate_size + 2 * hidden;
+      const float *prev = InitialState(INITIAL_H, d);
+      for (index_t s = 0; s < seq_length_; ++s) {
+        const index_t t = StepTime(d, s);
+        const float *x =
+            projection_data + t * batch * projection_stride + d * gate_size;
+        float *h = output_data + (t * directions + d) * batch * hidden;
+        update_reset_weights_[d].Multiply(&thread_pool, prev, hidden, batch,
+                                          update_reset, 2 * hidden);
+        if (linear_before_reset_) {
+          hidden_weights_[d].Multiply(&thread_pool, prev, hidden, batch,
+                                      hidden_gate, hidden);
+          thread_pool.Compute2D([=](index_t start0, index_t end0,
+                                    index_t step0, index_t start1,
+                                    index_t end1, index_t step1) {
+            for (index_t b = start0; b < end0; b += step0) {
+              const float *xb = x + b * projection_stride;
+              const float *rb = update_reset + b * 2 * hidden;
+              for (index_t j = start1; j < end1; j += step1) {
+                const index_t idx = b * hidden + j;
+                const float z = ScalarSigmoid(
+                    RecurrentClip(xb[j] + rb[j], clip));
+                const float r = ScalarSigmoid(
+                    RecurrentClip(xb[hidden + j] + rb[hidden + j], clip));
+                const float n = ScalarTanh(RecurrentClip(
+                    xb[2 * hidden + j]
+                        + r * (hidden_gate[idx] + hidden_bias[j]), clip));
+                h[idx] = (1.f - z) * n + z * prev[idx];
+              }
+            }
+          }, 0, batch, 1, 0, hidden, 1, 0, 0, 30);
+        } else {
+          // The reset applies before the recurrent product of the hidden
+          // gate, which needs a second product after z and r.
+          thread_pool.Compute2D([=](index_t start0, index_t end0,
+                                    index_t step0, index_t start1,
+                                    index_t end1, index_t step1) {
+            for (index_t b = start0; b < end0; b += step0) {
+              const float *xb = x + b * projection_stride;
+              float *rb = update_reset + b * 2 * hidden;
+              for (index_t j = start1; j < end1; j += step1) {
+                const index_t idx = b * hidden + j;
+                rb[j] = ScalarSigmoid(RecurrentClip(xb[j] + rb[j], clip));
+                const float r = ScalarSigmoid(
+                    RecurrentClip(xb[hidden + j] + rb[hidden + j], clip));
+                reset_hidden[idx] = r * prev[idx];
+              }
+            }
+          }, 0, batch, 1, 0, hidden, 1, 0, 0, 20);
+          hidden_weights_[d].Multiply(&thread_pool, reset_hidden, hidden,
+                                      batch, hidden_gate, hidden);
+          thread_pool.Compute2D([=](index_t start0, index_t end0,
+                                    index_t step0, index_t start1,
+                                    index_t end1, index_t step1) {
+            for (index_t b = start0; b < end0; b += step0) {
+              const float *xb = x + b * projection_stride;
+              const float *zb = update_reset + b * 2 * hidden;
+              for (index_t j = start1; j < end1; j += step1) {
+                const index_t idx = b * hidden + j;
+                const float n = ScalarTanh(RecurrentClip(
+                    xb[2 * hidden + j] + hidden_gate[idx], clip));
+                h[idx] = (1.f - zb[j]) * n + zb[j] * prev[idx];
+              }
+            }
+          }, 0, batch, 1, 0, hidden, 1, 0, 0, 15);
+        }
+        prev = h;
+      }
+
+      if (this->OutputSize() > OUTPUT_H) {
+        std::copy_n(prev, batch * hidden,
+                    this->Output(OUTPUT_H)->mutable_data<float>()
+                        + d * batch * hidden);
+      }
+    }
+
+    return MaceStatus::MACE_SUCCESS;
+  }
+
+ private:
+  const bool linear_before_reset_;
+  std::vector<RecurrentWeights> update_reset_weights_;
+  std::vector<RecurrentWeights> hidden_weights_;
+  std::vector<float> update_reset_;
+  std::vector<float> hidden_gate_;
+  std::vector<float> reset_hidden_;
+};
+
+void RegisterGRU(OpRegistry *op_registry) {
+  MACE_REGISTER_OP(op_registry, "GRU", GRUOp, RuntimeType::RT_CPU, float);
+}
+
+}  // namespace ops
+}  // namespace mace
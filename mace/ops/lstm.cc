@@ -0,0 +1,132 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "mace/core/ops/operator.h"
+#include "mace/core/registry/ops_registry.h"
+#include "mace/ops/recurrent_base.h"
+#include "mace/utils/math.h"
+
+namespace mace {
+namespace ops {
+
+// LSTM over a whole sequence, with the ONNX gate order i, o, f, c:
+//   i = sigmoid(x_i + h * R_i^T + b_i), o and f alike
+//   c = f * c_prev + i * tanh(x_c + h * R_c^T + b_c)
+//   h = o * tanh(c)
+// where x is the hoisted input projection. Peepholes are not supported.
+template<RuntimeType D, class T>
+class LSTMOp;
+
+template<>
+class LSTMOp<RuntimeType::RT_CPU, float> : public RecurrentOpBase {
+ public:
+  explicit LSTMOp(OpConstructContext *context)
+      : RecurrentOpBase(context, 4) {}
+
+  MaceStatus Run(OpContext *context) override {
+    MACE_RETURN_IF_ERROR(Prepare());
+    const Tensor *recurrence = this->Input(RECURRENCE);
+    const index_t hidden = hidden_size_;
+    const index_t gate_size = 4 * hidden;
+    if (recurrent_weights_.empty() || !recurrence->is_weight()) {
+      recurrent_weights_.resize(directions_);
+      for (index_t d = 0; d < directions_; ++d) {
+        recurrent_weights_[d].Pack(
+            recurrence->data<float>() + d * gate_size * hidden, gate_size,
+            hidden);
+      }
+    }
+
+    std::unique_ptr<Tensor> projection;
+    MACE_RETURN_IF_ERROR(ProjectInput(context, 4, &projection));
+
+    utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+    const index_t batch = batch_;
+    const index_t directions = directions_;
+    const index_t projection_stride = directions * gate_size;
+    const float clip = clip_;
+    const float *projection_data = projection->data<float>();
+    float *output_data = this->Output(OUTPUT)->mutable_data<float>();
+    recurrent_.resize(batch * gate_size);
+    cell_.resize(batch * hidden);
+    float *recurrent = recurrent_.data();
+    float *cell = cell_.data();
+
+    for (index_t d = 0; d < directions; ++d) {
+      const float *initial_c = InitialState(INITIAL_C, d);
+      std::copy_n(initial_c, batch * hidden, cell);
+      const float *prev = InitialState(INITIAL_H, d);
+      for (index_t s = 0; s < seq_length_; ++s) {
+        const index_t t = StepTime(d, s);
+        recurrent_weights_[d].Multiply(&thread_pool, prev, hidden, batch,
+                                       recurrent, gate_size);
+        const float *x =
+            projection_data + t * batch * projection_stride + d * gate_size;
+        float *h = output_data + (t * directions + d) * batch * hidden;
+        // All the gates of a hidden unit are fused in one pass
+        thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
+                                  index_t start1, index_t end1,
+                                  index_t step1) {
+          for (index_t b = start0; b < end0; b += step0) {
+            const float *xb = x + b * projection_stride;
+            const float *rb = recurrent + b * gate_size;
+            for (index_t j = start1; j < end1; j += step1) {
+              const float i_t = ScalarSigmoid(
+                  RecurrentClip(xb[j] + rb[j], clip));
+              const float o_t = ScalarSigmoid(
+                  RecurrentClip(xb[hidden + j] + rb[hidden + j], clip));
+              const float f_t = ScalarSigmoid(RecurrentClip(
+                  xb[2 * hidden + j] + rb[2 * hidden + j], clip));
+              const float c_in = ScalarTanh(RecurrentClip(
+                  xb[3 * hidden + j] + rb[3 * hidden + j], clip));
+              const float c_t = f_t * cell[b * hidden + j] + i_t * c_in;
+              cell[b * hidden + j] = c_t;
+              h[b * hidden + j] = o_t * ScalarTanh(c_t);
+            }
+          }
+        }, 0, batch, 1, 0, hidden, 1, 0, 0, 40);
+        prev = h;
+      }
+
+      if (this->OutputSize() > OUTPUT_H) {
+        std::copy_n(prev, batch * hidden,
+                    this->Output(OUTPUT_H)->mutable_data<float>()
+                        + d * batch * hidden);
+      }
+      if (this->OutputSize() > OUTPUT_C) {
+        std::copy_n(cell, batch * hidden,
+                    this->Output(OUTPUT_C)->mutable_data<float>()
+                        + d * batch * hidden);
+      }
+    }
+
+    return MaceStatus::MACE_SUCCESS;
+  }
+
+ private:
+  std::vector<RecurrentWeights> recurrent_weights_;
+  std::vector<float> recurrent_;
+  std::vector<float> cell_;
+};
+
+void RegisterLSTM(OpRegistry *op_registry) {
+  MACE_REGISTER_OP(op_registry, "LSTM", LSTMOp, RuntimeType::RT_CPU, float);
+}
+
+}  // namespace ops
+}  // namespace mace
@@ -13,11 +13,14 @@
 // limitations under the License.
 
 
+#include <cmath>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "mace/core/ops/operator.h"
 #include "mace/core/registry/ops_registry.h"
+#include "mace/ops/common/reduce.h"
 
 #ifdef MACE_ENABLE_OPENCL
 #include "mace/ops/opencl/image/mvnorm.h"
@@ -42,7 +45,6 @@ class MVNormOp<RuntimeType::RT_CPU, T> : public Operation {
         eps_(Operation::GetOptionalArg<float>("epsilon", 1e-9)) {}
 
   MaceStatus Run(OpContext *context) override {
-    MACE_UNUSED(context);
     const Tensor *input = this->Input(0);
     Tensor *output = this->Output(0);
     MACE_CHECK(input->data_format() == DataFormat::NCHW,
@@ -59,69 +61,51 @@ class MVNormOp<RuntimeType::RT_CPU, T> : public Operation {
     const auto inner_loop = input_size / outer_loop;
     utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
 
+    const std::vector<ReduceStep> steps = {{outer_loop, inner_loop, 1}};
     auto *runtime = context->runtime();
-    MemInfo mem_info(input->memory_type(), DataType::DT_FLOAT, {outer_loop});
-    auto mean_buffer = runtime->ObtainBuffer(mem_info, RENT_SCRATCH);
-    auto *mean_ptr = mean_buffer->mutable_data<float>();
+    MemInfo mem_info(input->memory_type(), DataType::DT_FLOAT,
+                     {2 * outer_loop + ReduceScratchSize(steps)});
+    auto buffer = runtime->ObtainBuffer(mem_info, RENT_SCRATCH);
+    float *mean_ptr = buffer->mutable_data<float>();
+    float *std_ptr = mean_ptr + outer_loop;
+    float *partials = std_ptr + outer_loop;
 
     // compute EX
-    thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
-      for (index_t i = start; i < end; i += step) {
-        const auto offset = inner_loop * i;
-        mean_ptr[i] = std::accumulate(input_data + offset,
-                                      input_data + offset + inner_loop,
-                                      static_cast<T>(0.0f));
-        mean_ptr[i] /= inner_loop;
-      }
-    }, 0, outer_loop, 1);
+    ReduceStepCompute<ReduceSumOp<float>>(
+        &thread_pool, input_data, steps[0], ReduceCast<float>(),
+        [inner_loop](float sum) { return sum / inner_loop; },
+        partials, mean_ptr);
 
-    // compute (X - EX)
+    if (normalize_variance_) {
+      // compute E((X - EX)^2)^0.5 + eps_
+      const float eps = eps_;
+      ReduceStepCompute<ReduceSumOp<float>>(
+          &thread_pool, input_data, steps[0],
+          [mean_ptr](index_t i, T x) {
+            const float diff = static_cast<float>(x) - mean_ptr[i];
+            return diff * diff;
+          },
+          [inner_loop, eps](float sum) {
+            return std::sqrt(sum / inner_loop) + eps;
+          },
+          partials, std_ptr);
+    }
+
+    // compute (X - EX) or (X - EX) / (E((X - EX)^2)^0.5 + eps_)
+    const bool normalize_variance = normalize_variance_;
     thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
                               index_t start1, index_t end1, index_t step1) {
       for (index_t i = start0; i < end0; i += step0) {
         const auto offset = i * inner_loop;
+        const float mean = mean_ptr[i];
+        const float stddev = normalize_variance ? std_ptr[i] : 1.f;
         for (index_t j = start1; j < end1; j += step1) {
-          output_data[offset + j] = input_data[offset + j] - mean_ptr[i];
+          output_data[offset + j] =
+              (static_cast<float>(input_data[offset + j]) - mean) / stddev;
         }
       }
     }, 0, outer_loop, 1, 0, inner_loop, 1);
 
-    if (normalize_variance_) {
-      // compute (X - EX)^2
-      thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
-        for (index_t i = start; i < end; i += step) {
-          output_data[i] = output_data[i] * output_data[i];
-        }
-      }, 0, input_size, 1);
-
-      auto *runtime = context->runtime();
-      MemInfo mem_info(input->memory_type(), DataType::DT_FLOAT, {outer_loop});
-      auto mean_v_buffer = runtime->ObtainBuffer(mem_info, RENT_SCRATCH);
-      float *mean_v_ptr = mean_v_buffer->mutable_data<float>();
-      // compute E((X - EX)^2)^0.5 + eps_
-      thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
-        for (index_t i = start; i < end; i += step) {
-          auto output_data_base = output_data + inner_loop * i;
-          mean_v_ptr[i] = std::accumulate(output_data_base,
-                                          output_data_base + inner_loop,
-                                          static_cast<T>(0.0f));
-          mean_v_ptr[i] = std::pow(mean_v_ptr[i] / inner_loop, 0.5f) + eps_;
-        }
-      }, 0, outer_loop, 1);
-
-      // compute (X - EX) / (E((X - EX)^2)^0.5 + eps_)
-      thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
-                                index_t start1, index_t end1, index_t step1) {
-        for (index_t i = start0; i < end0; i += step0) {
-          const auto offset = i * inner_loop;
-          for (index_t j = start1; j < end1; j += step1) {
-            output_data[offset + j] =
-                (input_data[offset + j] - mean_ptr[i]) / mean_v_ptr[i];
-          }
-        }
-      }, 0, outer_loop, 1, 0, inner_loop, 1);
-    }
-
     return MaceStatus::MACE_SUCCESS;
   }
 
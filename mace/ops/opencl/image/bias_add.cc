@@ -71,7 +71,7 @@ MaceStatus BiasAddKernel::Compute(
   if (!context->fake_warmup()) {
     cl_int error;
     if (executor->IsNonUniformWorkgroupsSupported()) {
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           kernel_, cl::NullRange, cl::NDRange(gws[0], gws[1], gws[2]),
           cl::NDRange(lws[0], lws[1], lws[2]), nullptr, &event);
     } else {
@@ -80,7 +80,7 @@ MaceStatus BiasAddKernel::Compute(
         if (lws[i] != 0) roundup_gws[i] = RoundUp(gws[i], lws[i]);
       }
 
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           kernel_, cl::NullRange,
           cl::NDRange(roundup_gws[0], roundup_gws[1], roundup_gws[2]),
           cl::NDRange(lws[0], lws[1], lws[2]), nullptr, &event);
@@ -174,7 +174,7 @@ MaceStatus ConcatN(OpContext *context,
     if (!context->fake_warmup()) {
       cl_int error;
       if (executor->IsNonUniformWorkgroupsSupported()) {
-        error = executor->command_queue().enqueueNDRangeKernel(
+        error = executor->EnqueueNDRangeKernel(
             *kernel, cl::NullRange, cl::NDRange(gws[0], gws[1], gws[2]),
             cl::NDRange(lws[0], lws[1], lws[2]), nullptr, &event);
       } else {
@@ -182,7 +182,7 @@ MaceStatus ConcatN(OpContext *context,
         for (size_t j = 0; j < 3; ++j) {
           roundup_gws[j] = RoundUp(gws[j], lws[j]);
         }
-        error = executor->command_queue().enqueueNDRangeKernel(
+        error = executor->EnqueueNDRangeKernel(
             *kernel, cl::NullRange,
             cl::NDRange(roundup_gws[0], roundup_gws[1], roundup_gws[2]),
             cl::NDRange(lws[0], lws[1], lws[2]), nullptr, &event);
@@ -109,7 +109,7 @@ MaceStatus FullyConnectedKernel::Compute(
   if (!context->fake_warmup()) {
     cl_int error;
     if (executor->IsNonUniformWorkgroupsSupported()) {
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           kernel_, cl::NullRange, cl::NDRange(gws_[0], gws_[1], gws_[2]),
           cl::NDRange(lws_[0], lws_[1], lws_[2]), nullptr, &event);
     } else {
@@ -117,7 +117,7 @@ MaceStatus FullyConnectedKernel::Compute(
       for (size_t i = 0; i < lws_.size(); ++i) {
         roundup_gws[i] = RoundUp(gws_[i], lws_[i]);
       }
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           kernel_, cl::NullRange,
           cl::NDRange(roundup_gws[0], roundup_gws[1], roundup_gws[2]),
           cl::NDRange(lws_[0], lws_[1], lws_[2]), nullptr, &event);
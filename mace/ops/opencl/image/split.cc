@@ -78,7 +78,7 @@ MaceStatus SplitKernel::Compute(
     if (!context->fake_warmup()) {
       cl_int error;
       if (executor->IsNonUniformWorkgroupsSupported()) {
-        error = executor->command_queue().enqueueNDRangeKernel(
+        error = executor->EnqueueNDRangeKernel(
             kernel_, cl::NullRange, cl::NDRange(gws[0], gws[1], gws[2]),
             cl::NDRange(lws[0], lws[1], lws[2]), nullptr, &event);
       } else {
@@ -87,7 +87,7 @@ MaceStatus SplitKernel::Compute(
           roundup_gws[j] = RoundUp(gws[j], lws[j]);
         }
 
-        error = executor->command_queue().enqueueNDRangeKernel(
+        error = executor->EnqueueNDRangeKernel(
             kernel_, cl::NullRange,
             cl::NDRange(roundup_gws[0], roundup_gws[1], roundup_gws[2]),
             cl::NDRange(lws[0], lws[1], lws[2]), nullptr, &event);
@@ -106,7 +106,7 @@ MaceStatus SqrDiffMeanKernel::Compute(
   if (!context->fake_warmup()) {
     cl_int error;
     if (executor->IsNonUniformWorkgroupsSupported()) {
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           kernel_, cl::NullRange, cl::NDRange(gws[0], gws[1], gws[2]),
           cl::NDRange(lws[0], lws[1], lws[2]), nullptr, &event);
     } else {
@@ -114,7 +114,7 @@ MaceStatus SqrDiffMeanKernel::Compute(
       for (size_t i = 0; i < lws.size(); ++i) {
         roundup_gws[i] = RoundUp(gws[i], lws[i]);
       }
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           kernel_, cl::NullRange,
           cl::NDRange(roundup_gws[0], roundup_gws[1], roundup_gws[2]),
           cl::NDRange(lws[0], lws[1], lws[2]), nullptr, &event);
@@ -14,6 +14,8 @@
 
 #if defined(MACE_ENABLE_NEON)
 #include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
 #endif
 
 #include <algorithm>
@@ -32,11 +34,201 @@
 #include "mace/ops/opencl/image/pooling.h"
 #include "mace/ops/opencl/buffer/pooling.h"
 #endif  // MACE_ENABLE_OPENCL
+#include "mace/utils/math.h"
 #include "mace/utils/memory.h"
 
 namespace mace {
 namespace ops {
 
+namespace {
+// Vectorized row primitives of the float pooling kernels
+float ReduceSum(const float *data, const index_t size) {
+  float res = 0.f;
+  index_t i = 0;
+#if defined(MACE_ENABLE_NEON)
+  if (size >= 4) {
+    float32x4_t sum = vld1q_f32(data);
+    for (i = 4; i + 3 < size; i += 4) {
+      sum = vaddq_f32(sum, vld1q_f32(data + i));
+    }
+    float32x2_t sum2 = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+    res = vget_lane_f32(vpadd_f32(sum2, sum2), 0);
+  }
+#elif defined(__SSE__)
+  if (size >= 4) {
+    __m128 sum = _mm_loadu_ps(data);
+    for (i = 4; i + 3 < size; i += 4) {
+      sum = _mm_add_ps(sum, _mm_loadu_ps(data + i));
+    }
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    res = _mm_cvtss_f32(sum);
+  }
+#endif
+  for (; i < size; ++i) {
+    res += data[i];
+  }
+  return res;
+}
+
+float ReduceMax(const float *data, const index_t size) {
+  float res = std::numeric_limits<float>::lowest();
+  index_t i = 0;
+#if defined(MACE_ENABLE_NEON)
+  if (size >= 4) {
+    float32x4_t max = vld1q_f32(data);
+    for (i = 4; i + 3 < size; i += 4) {
+      max = vmaxq_f32(max, vld1q_f32(data + i));
+    }
+    float32x2_t max2 = vmax_f32(vget_low_f32(max), vget_high_f32(max));
+    res = vget_lane_f32(vpmax_f32(max2, max2), 0);
+  }
+#elif defined(__SSE__)
+  if (size >= 4) {
+    __m128 max = _mm_loadu_ps(data);
+    for (i = 4; i + 3 < size; i += 4) {
+      max = _mm_max_ps(max, _mm_loadu_ps(data + i));
+    }
+    max = _mm_max_ps(max, _mm_movehl_ps(max, max));
+    max = _mm_max_ss(max, _mm_shuffle_ps(max, max, 1));
+    res = _mm_cvtss_f32(max);
+  }
+#endif
+  for (; i < size; ++i) {
+    res = std::max(res, data[i]);
+  }
+  return res;
+}
+
+// dst = dst + src
+void AddRow(const float *src, const index_t size, float *dst) {
+  index_t i = 0;
+#if defined(MACE_ENABLE_NEON)
+  for (; i + 3 < size; i += 4) {
+    vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+  }
+#elif defined(__SSE__)
+  for (; i + 3 < size; i += 4) {
+    _mm_storeu_ps(dst + i,
+                  _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+  }
+#endif
+  for (; i < size; ++i) {
+    dst[i] += src[i];
+  }
+}
+
+// dst = dst - src
+void SubRow(const float *src, const index_t size, float *dst) {
+  index_t i = 0;
+#if defined(MACE_ENABLE_NEON)
+  for (; i + 3 < size; i += 4) {
+    vst1q_f32(dst + i, vsubq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+  }
+#elif defined(__SSE__)
+  for (; i + 3 < size; i += 4) {
+    _mm_storeu_ps(dst + i,
+                  _mm_sub_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+  }
+#endif
+  for (; i < size; ++i) {
+    dst[i] -= src[i];
+  }
+}
+
+// dst = max(dst, src)
+void MaxRow(const float *src, const index_t size, float *dst) {
+  index_t i = 0;
+#if defined(MACE_ENABLE_NEON)
+  for (; i + 3 < size; i += 4) {
+    vst1q_f32(dst + i, vmaxq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+  }
+#elif defined(__SSE__)
+  for (; i + 3 < size; i += 4) {
+    _mm_storeu_ps(dst + i,
+                  _mm_max_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+  }
+#endif
+  for (; i < size; ++i) {
+    dst[i] = std::max(dst[i], src[i]);
+  }
+}
+
+// dst = src * scales * scale
+void ScaleRow(const float *src, const float *scales, const float scale,
+              const index_t size, float *dst) {
+  index_t i = 0;
+#if defined(MACE_ENABLE_NEON)
+  for (; i + 3 < size; i += 4) {
+    vst1q_f32(dst + i, vmulq_n_f32(
+        vmulq_f32(vld1q_f32(src + i), vld1q_f32(scales + i)), scale));
+  }
+#elif defined(__SSE__)
+  const __m128 scale4 = _mm_set1_ps(scale);
+  for (; i + 3 < size; i += 4) {
+    _mm_storeu_ps(dst + i, _mm_mul_ps(
+        _mm_mul_ps(_mm_loadu_ps(src + i), _mm_loadu_ps(scales + i)), scale4));
+  }
+#endif
+  for (; i < size; ++i) {
+    dst[i] = src[i] * scales[i] * scale;
+  }
+}
+
+// Sums the windows [ranges[2 * i], ranges[2 * i + 1]) of a row, the windows
+// slide to the right so the running sum adds and drops each input once.
+void RowWindowSum(const float *input, const index_t *ranges,
+                  const index_t size, float *output) {
+  double sum = 0.0;  // no drift over long rows
+  index_t begin = 0;
+  index_t end = 0;
+  for (index_t i = 0; i < size; ++i) {
+    const index_t window_begin = ranges[2 * i];
+    const index_t window_end = ranges[2 * i + 1];
+    if (window_begin >= end) {
+      sum = 0.0;
+      begin = end = window_begin;
+    }
+    for (; end < window_end; ++end) {
+      sum += input[end];
+    }
+    for (; begin < window_begin; ++begin) {
+      sum -= input[begin];
+    }
+    output[i] = static_cast<float>(sum);
+  }
+}
+
+// Max of the windows of a row with a monotonic deque: it holds the indices of
+// the inputs which may still be the max of a window, with decreasing values,
+// so each input is pushed and popped at most once.
+void RowWindowMax(const float *input, const index_t *ranges,
+                  const index_t size, index_t *deque, float *output) {
+  index_t head = 0;
+  index_t tail = 0;
+  index_t next = 0;
+  for (index_t i = 0; i < size; ++i) {
+    const index_t window_begin = ranges[2 * i];
+    const index_t window_end = ranges[2 * i + 1];
+    for (; next < window_end; ++next) {
+      while (tail > head && input[deque[tail - 1]] <= input[next]) {
+        --tail;
+      }
+      deque[tail++] = next;
+    }
+    while (head < tail && deque[head] < window_begin) {
+      ++head;
+    }
+    output[i] = head < tail ? input[deque[head]]
+                            : std::numeric_limits<float>::lowest();
+  }
+}
+
+// Windows with at least this many elements (and no dilation) are pooled with
+// the sliding-window kernels
+const int kSlidingWindowMinArea = 25;
+}  // namespace
+
 class PoolingOpBase : public ConvPool2dOpBase {
  public:
   explicit PoolingOpBase(OpConstructContext *context)
@@ -280,7 +472,27 @@ class PoolingOp<RuntimeType::RT_CPU, float> : public PoolingOpBase {
     const index_t *input_shape = input_tensor->shape().data();
     int pad_hw[2] = {paddings[0] / 2, paddings[1] / 2};
 
-    if (pooling_type_ == PoolingType::MAX) {
+    const bool is_global = output_shape[2] == 1 && output_shape[3] == 1 &&
+        kernels_[0] == input_shape[2] && kernels_[1] == input_shape[3];
+    const bool use_sliding_window =
+        dilations_[0] == 1 && dilations_[1] == 1 &&
+        kernels_[0] * kernels_[1] >= kSlidingWindowMinArea;
+
+    if (pooling_type_ != PoolingType::MAX &&
+        pooling_type_ != PoolingType::AVG) {
+      MACE_NOT_IMPLEMENTED;
+    } else if (is_global) {
+      GlobalPooling(context, input, input_shape, output);
+    } else if (use_sliding_window) {
+      SlidingWindowPooling(context,
+                           input,
+                           input_shape,
+                           output_shape.data(),
+                           kernels_.data(),
+                           strides_.data(),
+                           pad_hw,
+                           output);
+    } else if (pooling_type_ == PoolingType::MAX) {
       MaxPooling(context,
                  input,
                  input_shape,
@@ -300,14 +512,179 @@ class PoolingOp<RuntimeType::RT_CPU, float> : public PoolingOpBase {
                  dilations_.data(),
                  pad_hw,
                  output);
-    } else {
-      MACE_NOT_IMPLEMENTED;
     }
 
     return MaceStatus::MACE_SUCCESS;
   }
 
  private:
+  // Global pooling reduces each plane with SIMD. When there are too few
+  // planes to keep the threads busy, the planes are split into chunks which
+  // are reduced in parallel and combined afterwards.
+  void GlobalPooling(const OpContext *context,
+                     const float *input,
+                     const index_t *in_shape,
+                     float *output) {
+    const index_t kChunkSize = 8192;
+    const index_t kMaxPlanesToSplit = 16;
+    const index_t planes = in_shape[0] * in_shape[1];
+    const index_t image_size = in_shape[2] * in_shape[3];
+    const bool is_max = pooling_type_ == PoolingType::MAX;
+
+    utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+
+    if (planes >= kMaxPlanesToSplit || image_size < 2 * kChunkSize) {
+      thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
+        for (index_t i = start; i < end; i += step) {
+          const float *in_ptr = input + i * image_size;
+          output[i] = is_max ? ReduceMax(in_ptr, image_size)
+                             : ReduceSum(in_ptr, image_size) / image_size;
+        }
+      }, 0, planes, 1);
+      return;
+    }
+
+    const index_t chunks = RoundUpDiv(image_size, kChunkSize);
+    std::vector<float> partials(planes * chunks);
+    float *partial_data = partials.data();
+    thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
+                              index_t start1, index_t end1, index_t step1) {
+      for (index_t i = start0; i < end0; i += step0) {
+        for (index_t j = start1; j < end1; j += step1) {
+          const index_t begin = j * kChunkSize;
+          const index_t size = std::min(kChunkSize, image_size - begin);
+          const float *in_ptr = input + i * image_size + begin;
+          partial_data[i * chunks + j] =
+              is_max ? ReduceMax(in_ptr, size) : ReduceSum(in_ptr, size);
+        }
+      }
+    }, 0, planes, 1, 0, chunks, 1);
+    for (index_t i = 0; i < planes; ++i) {
+      const float *partial = partial_data + i * chunks;
+      output[i] = is_max ? ReduceMax(partial, chunks)
+                         : ReduceSum(partial, chunks) / image_size;
+    }
+  }
+
+  // Large windows are pooled separably: every input row is first reduced to
+  // the output columns with O(1) work per output (RowWindowSum or
+  // RowWindowMax), then the reduced rows are combined into the output rows
+  // with SIMD, keeping a running sum of the rows for AVG. Tiles of output
+  // rows run in parallel, so big planes with few channels use all threads.
+  void SlidingWindowPooling(const OpContext *context,
+                            const float *input,
+                            const index_t *in_shape,
+                            const index_t *out_shape,
+                            const int *filter_hw,
+                            const int *stride_hw,
+                            const int *pad_hw,
+                            float *output) {
+    const index_t planes = out_shape[0] * out_shape[1];
+    const index_t in_height = in_shape[2];
+    const index_t in_width = in_shape[3];
+    const index_t out_height = out_shape[2];
+    const index_t out_width = out_shape[3];
+    const index_t in_image_size = in_height * in_width;
+    const index_t out_image_size = out_height * out_width;
+    const index_t filter_h = filter_hw[0];
+    const index_t stride_h = stride_hw[0];
+    const index_t pad_h = pad_hw[0];
+    const bool is_max = pooling_type_ == PoolingType::MAX;
+
+    // the input columns [begin, end) of each output column and the inverse
+    // of their count
+    std::vector<index_t> w_ranges(2 * out_width);
+    std::vector<float> w_scales(out_width);
+    for (index_t w = 0; w < out_width; ++w) {
+      const index_t begin = w * stride_hw[1] - pad_hw[1];
+      w_ranges[2 * w] = std::min(std::max<index_t>(begin, 0), in_width);
+      w_ranges[2 * w + 1] = std::max(
+          w_ranges[2 * w], std::min(begin + filter_hw[1], in_width));
+      const index_t count = w_ranges[2 * w + 1] - w_ranges[2 * w];
+      w_scales[w] = count > 0 ? 1.f / count : 0.f;
+    }
+    const index_t *w_ranges_data = w_ranges.data();
+    const float *w_scales_data = w_scales.data();
+
+    // neighbouring tiles both reduce the input rows they share, so a tile
+    // spans at least twice the window
+    const index_t tile_height =
+        std::max<index_t>(8, RoundUpDiv(2 * filter_h, stride_h));
+    const index_t max_tile_rows = (tile_height - 1) * stride_h + filter_h;
+
+    utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+
+    thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
+                              index_t start1, index_t end1, index_t step1) {
+      std::vector<float> rows_buffer(max_tile_rows * out_width);
+      std::vector<float> sum_buffer(out_width);
+      std::vector<index_t> deque_buffer(in_width);
+      float *rows = rows_buffer.data();
+      float *sum = sum_buffer.data();
+      for (index_t p = start0; p < end0; p += step0) {
+        const float *in_plane = input + p * in_image_size;
+        float *out_plane = output + p * out_image_size;
+        for (index_t h0 = start1; h0 < end1; h0 += step1) {
+          const index_t h1 = std::min(h0 + tile_height, out_height);
+          const index_t row_begin = std::min(
+              std::max<index_t>(h0 * stride_h - pad_h, 0), in_height);
+          const index_t row_end = std::max(row_begin, std::min(
+              (h1 - 1) * stride_h - pad_h + filter_h, in_height));
+          for (index_t ih = row_begin; ih < row_end; ++ih) {
+            const float *in_row = in_plane + ih * in_width;
+            float *row = rows + (ih - row_begin) * out_width;
+            if (is_max) {
+              RowWindowMax(in_row, w_ranges_data, out_width,
+                           deque_buffer.data(), row);
+            } else {
+              RowWindowSum(in_row, w_ranges_data, out_width, row);
+            }
+          }
+
+          index_t sum_begin = 0;
+          index_t sum_end = 0;
+          index_t last_reset = h0;
+          for (index_t h = h0; h < h1; ++h) {
+            const index_t begin = std::min(
+                std::max<index_t>(h * stride_h - pad_h, 0), in_height);
+            const index_t end = std::max(
+                begin, std::min(h * stride_h - pad_h + filter_h, in_height));
+            float *out_row = out_plane + h * out_width;
+            if (is_max) {
+              if (begin == end) {
+                std::fill_n(out_row, out_width,
+                            std::numeric_limits<float>::lowest());
+                continue;
+              }
+              const float *row = rows + (begin - row_begin) * out_width;
+              std::copy_n(row, out_width, out_row);
+              for (index_t ih = begin + 1; ih < end; ++ih) {
+                MaxRow(row += out_width, out_width, out_row);
+              }
+              continue;
+            }
+            // restart the running sum once the window has been renewed, so
+            // that the rounding errors do not pile up
+            if (h == h0 || begin >= sum_end || h - last_reset >= filter_h) {
+              std::fill_n(sum, out_width, 0.f);
+              sum_begin = sum_end = begin;
+              last_reset = h;
+            }
+            for (; sum_end < end; ++sum_end) {
+              AddRow(rows + (sum_end - row_begin) * out_width, out_width, sum);
+            }
+            for (; sum_begin < begin; ++sum_begin) {
+              SubRow(rows + (sum_begin - row_begin) * out_width, out_width,
+                     sum);
+            }
+            const float h_scale = end > begin ? 1.f / (end - begin) : 0.f;
+            ScaleRow(sum, w_scales_data, h_scale, out_width, out_row);
+          }  // h
+        }  // h0
+      }  // p
+    }, 0, planes, 1, 0, out_height, tile_height);
+  }
+
   void MaxPoolingPad(const float *input,
                      int in_base,
                      int in_width,
@@ -382,124 +759,83 @@ class PoolingOp<RuntimeType::RT_CPU, float> : public PoolingOpBase {
 
     utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
 
-    if (out_image_size == 1 && filter_hw[0] == in_height && filter_hw[1] == in_width) {
-      thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
-                                index_t start1, index_t end1, index_t step1) {
-        for (index_t b = start0; b < end0; b += step0) {
-          for (index_t c = start1; c < end1; c += step1) {
-            const index_t out_base = b * out_batch_size + c;
-            const index_t in_base = b * in_batch_size + c * in_image_size;
-            float res = std::numeric_limits<float>::lowest();
-            index_t i = 0;
-#if defined(MACE_ENABLE_NEON)
-#ifndef __aarch64__
-#define vmaxvq_f32(v)               \
-  ({                                \
-      float __m = v[0];                 \
-      for (int i = 1; i < 4; i++) { \
-          if (v[i] > __m)           \
-              __m = v[i];           \
-      }                             \
-      __m;                          \
-  })
-#endif
-            if (i + 3 < in_image_size) {
-              float32x4_t maxx4 = vld1q_f32(input + in_base);
-              i += 4;
-              for (; i + 3 < in_image_size; i += 4) {
-                  maxx4 = vmaxq_f32(maxx4, vld1q_f32(input + in_base + i));
+    int l = 0, t = 0, r = out_width, b = out_height;
+    for (; l * stride_hw[1] - pad_hw[1] < 0 && l < out_width; l++) {
+      // do nothing
+    }
+    for (; t * stride_hw[0] - pad_hw[0] < 0 && t < out_height; t++) {
+      // do nothing
+    }
+    for (; (r - 1) * stride_hw[1] - pad_hw[1] + (filter_hw[1] - 1) * dilation_hw[1] >= in_width && r > l; r--) {
+      // do nothing
+    }
+    for (; (b - 1) * stride_hw[0] - pad_hw[0] + (filter_hw[0] - 1) * dilation_hw[0] >= in_height && b > t; b--) {
+      // do nothing
+    }
+    int pad_left = l, pad_right = r, pad_top = t, pad_bottom = b;
+    thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
+                              index_t start1, index_t end1, index_t step1) {
+      for (index_t b = start0; b < end0; b += step0) {
+        for (index_t c = start1; c < end1; c += step1) {
+          const index_t out_base = b * out_batch_size + c * out_image_size;
+          const index_t in_base = b * in_batch_size + c * in_image_size;
+          { // handle paddings
+            for (index_t h = 0; h < pad_top; ++h) {
+              index_t inh_base = h * stride_hw[0] - pad_hw[0];
+              for (index_t w = 0; w < out_width; ++w) {
+                const index_t out_offset = out_base + h * out_width + w;
+                index_t inw_base = w * stride_hw[1] - pad_hw[1];
+                MaxPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
+                              filter_hw, dilation_hw, &output[out_offset]);
               }
-              float val = vmaxvq_f32(maxx4);
-              if (val > res)
-                  res = val;
             }
-#endif
-            for (; i < in_image_size; ++i) {
-              res = std::max(res, input[in_base + i]);
-            }
-            output[out_base] = res;
-          }
-        }
-      }, 0, batch, 1, 0, out_channels, 1);
-    } else {
-      int l = 0, t = 0, r = out_width, b = out_height;
-      for (; l * stride_hw[1] - pad_hw[1] < 0 && l < out_width; l++) {
-        // do nothing
-      }
-      for (; t * stride_hw[0] - pad_hw[0] < 0 && t < out_height; t++) {
-        // do nothing
-      }
-      for (; (r - 1) * stride_hw[1] - pad_hw[1] + (filter_hw[1] - 1) * dilation_hw[1] >= in_width && r > l; r--) {
-        // do nothing
-      }
-      for (; (b - 1) * stride_hw[0] - pad_hw[0] + (filter_hw[0] - 1) * dilation_hw[0] >= in_height && b > t; b--) {
-        // do nothing
-      }
-      int pad_left = l, pad_right = r, pad_top = t, pad_bottom = b;
-      thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
-                                index_t start1, index_t end1, index_t step1) {
-        for (index_t b = start0; b < end0; b += step0) {
-          for (index_t c = start1; c < end1; c += step1) {
-            const index_t out_base = b * out_batch_size + c * out_image_size;
-            const index_t in_base = b * in_batch_size + c * in_image_size;
-            { // handle paddings
-              for (index_t h = 0; h < pad_top; ++h) {
-                index_t inh_base = h * stride_hw[0] - pad_hw[0];
-                for (index_t w = 0; w < out_width; ++w) {
-                  const index_t out_offset = out_base + h * out_width + w;
-                  index_t inw_base = w * stride_hw[1] - pad_hw[1];
-                  MaxPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
-                                filter_hw, dilation_hw, &output[out_offset]);
-                }
+            for (index_t h = pad_top; h < pad_bottom; ++h) {
+              index_t inh_base = h * stride_hw[0] - pad_hw[0];
+              for (index_t w = 0; w < pad_left; ++w) {
+                const index_t out_offset = out_base + h * out_width + w;
+                index_t inw_base = w * stride_hw[1] - pad_hw[1];
+                MaxPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
+                              filter_hw, dilation_hw, output + out_offset);
               }
-              for (index_t h = pad_top; h < pad_bottom; ++h) {
-                index_t inh_base = h * stride_hw[0] - pad_hw[0];
-                for (index_t w = 0; w < pad_left; ++w) {
-                  const index_t out_offset = out_base + h * out_width + w;
-                  index_t inw_base = w * stride_hw[1] - pad_hw[1];
-                  MaxPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
-                                filter_hw, dilation_hw, output + out_offset);
-                }
-                for (index_t w = pad_right; w < out_width; ++w) {
-                  const index_t out_offset = out_base + h * out_width + w;
-                  index_t inw_base = w * stride_hw[1] - pad_hw[1];
-                  MaxPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
-                                filter_hw, dilation_hw, output + out_offset);
-                }
+              for (index_t w = pad_right; w < out_width; ++w) {
+                const index_t out_offset = out_base + h * out_width + w;
+                index_t inw_base = w * stride_hw[1] - pad_hw[1];
+                MaxPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
+                              filter_hw, dilation_hw, output + out_offset);
               }
-              for (index_t h = pad_bottom; h < out_height; ++h) {
-                index_t inh_base = h * stride_hw[0] - pad_hw[0];
-                for (index_t w = 0; w < out_width; ++w) {
-                  const index_t out_offset = out_base + h * out_width + w;
-                  index_t inw_base = w * stride_hw[1] - pad_hw[1];
-                  MaxPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
-                                filter_hw, dilation_hw, output + out_offset);
-                }
+            }
+            for (index_t h = pad_bottom; h < out_height; ++h) {
+              index_t inh_base = h * stride_hw[0] - pad_hw[0];
+              for (index_t w = 0; w < out_width; ++w) {
+                const index_t out_offset = out_base + h * out_width + w;
+                index_t inw_base = w * stride_hw[1] - pad_hw[1];
+                MaxPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
+                              filter_hw, dilation_hw, output + out_offset);
               }
             }
-            { // handle no paddings
-              for (index_t h = pad_top; h < pad_bottom; ++h) {
-                index_t inh_base = h * stride_hw[0] - pad_hw[0];
-                for (index_t w = pad_left; w < pad_right; ++w) {
-                  index_t inw_base = w * stride_hw[1] - pad_hw[1];
-                  const index_t out_offset = out_base + h * out_width + w;
-                  float res = std::numeric_limits<float>::lowest();
-                  for (int fh = 0; fh < filter_hw[0]; ++fh) {
-                    index_t inh = inh_base + fh * dilation_hw[0];
-                    for (int fw = 0; fw < filter_hw[1]; ++fw) {
-                      index_t inw = inw_base + fw * dilation_hw[1];
-                      index_t input_offset = in_base + inh * in_width + inw;
-                      res = std::max(res, input[input_offset]);
-                    }
+          }
+          { // handle no paddings
+            for (index_t h = pad_top; h < pad_bottom; ++h) {
+              index_t inh_base = h * stride_hw[0] - pad_hw[0];
+              for (index_t w = pad_left; w < pad_right; ++w) {
+                index_t inw_base = w * stride_hw[1] - pad_hw[1];
+                const index_t out_offset = out_base + h * out_width + w;
+                float res = std::numeric_limits<float>::lowest();
+                for (int fh = 0; fh < filter_hw[0]; ++fh) {
+                  index_t inh = inh_base + fh * dilation_hw[0];
+                  for (int fw = 0; fw < filter_hw[1]; ++fw) {
+                    index_t inw = inw_base + fw * dilation_hw[1];
+                    index_t input_offset = in_base + inh * in_width + inw;
+                    res = std::max(res, input[input_offset]);
                   }
-                  output[out_offset] = res;
                 }
+                output[out_offset] = res;
               }
             }
           }
         }
-      }, 0, batch, 1, 0, out_channels, 1);
-    }
+      }
+    }, 0, batch, 1, 0, out_channels, 1);
   }
 
   void AvgPooling(const OpContext *context,
@@ -526,112 +862,84 @@ class PoolingOp<RuntimeType::RT_CPU, float> : public PoolingOpBase {
 
     utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
 
-    if (out_image_size == 1 && filter_hw[0] == in_height && filter_hw[1] == in_width) {
-      thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
-                                index_t start1, index_t end1, index_t step1) {
-        for (index_t b = start0; b < end0; b += step0) {
-          for (index_t c = start1; c < end1; c += step1) {
-            const index_t out_base = b * out_batch_size + c;
-            const index_t in_base = b * in_batch_size + c * in_image_size;
-            float res = 0;
-            index_t i = 0;
-#if defined(MACE_ENABLE_NEON)
-            if (i + 3 < in_image_size) {
-              float32x4_t sumx4 = vld1q_f32(input + in_base);
-              i += 4;
-              for (; i + 3 < in_image_size; i += 4) {
-                sumx4 = vaddq_f32(sumx4, vld1q_f32(input + in_base + i));
+    int l = 0, t = 0, r = out_width, b = out_height;
+    for (; l * stride_hw[1] - pad_hw[1] < 0 && l < out_width; l++) {
+      // do nothing
+    }
+    for (; t * stride_hw[0] - pad_hw[0] < 0 && t < out_height; t++) {
+      // do nothing
+    }
+    for (; (r - 1) * stride_hw[1] - pad_hw[1] + (filter_hw[1] - 1) * dilation_hw[1] >= in_width && r > l; r--) {
+      // do nothing
+    }
+    for (; (b - 1) * stride_hw[0] - pad_hw[0] + (filter_hw[0] - 1) * dilation_hw[0] >= in_height && b > t; b--) {
+      // do nothing
+    }
+    int pad_left = l, pad_right = r, pad_top = t, pad_bottom = b;
+    thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
+                              index_t start1, index_t end1, index_t step1) {
+      for (index_t b = start0; b < end0; b += step0) {
+        for (index_t c = start1; c < end1; c += step1) {
+          const index_t out_base = b * out_batch_size + c * out_image_size;
+          const index_t in_base = b * in_batch_size + c * in_image_size;
+          { // handle paddings
+            for (index_t h = 0; h < pad_top; ++h) {
+              index_t inh_base = h * stride_hw[0] - pad_hw[0];
+              for (index_t w = 0; w < out_width; ++w) {
+                const index_t out_offset = out_base + h * out_width + w;
+                index_t inw_base = w * stride_hw[1] - pad_hw[1];
+                AvgPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
+                              filter_hw, dilation_hw, output + out_offset);
               }
-              res += (sumx4[0] + sumx4[1] + sumx4[2] + sumx4[3]);
             }
-#endif
-            for (; i < in_image_size; ++i) {
-              res += input[in_base + i];
-            }
-            output[out_base] = res / in_image_size;
-          }
-        }
-      }, 0, batch, 1, 0, out_channels, 1);
-    } else {
-      int l = 0, t = 0, r = out_width, b = out_height;
-      for (; l * stride_hw[1] - pad_hw[1] < 0 && l < out_width; l++) {
-        // do nothing
-      }
-      for (; t * stride_hw[0] - pad_hw[0] < 0 && t < out_height; t++) {
-        // do nothing
-      }
-      for (; (r - 1) * stride_hw[1] - pad_hw[1] + (filter_hw[1] - 1) * dilation_hw[1] >= in_width && r > l; r--) {
-        // do nothing
-      }
-      for (; (b - 1) * stride_hw[0] - pad_hw[0] + (filter_hw[0] - 1) * dilation_hw[0] >= in_height && b > t; b--) {
-        // do nothing
-      }
-      int pad_left = l, pad_right = r, pad_top = t, pad_bottom = b;
-      thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
-                                index_t start1, index_t end1, index_t step1) {
-        for (index_t b = start0; b < end0; b += step0) {
-          for (index_t c = start1; c < end1; c += step1) {
-            const index_t out_base = b * out_batch_size + c * out_image_size;
-            const index_t in_base = b * in_batch_size + c * in_image_size;
-            { // handle paddings
-              for (index_t h = 0; h < pad_top; ++h) {
-                index_t inh_base = h * stride_hw[0] - pad_hw[0];
-                for (index_t w = 0; w < out_width; ++w) {
-                  const index_t out_offset = out_base + h * out_width + w;
-                  index_t inw_base = w * stride_hw[1] - pad_hw[1];
-                  AvgPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
-                                filter_hw, dilation_hw, output + out_offset);
-                }
+            for (index_t h = pad_top; h < pad_bottom; ++h) {
+              index_t inh_base = h * stride_hw[0] - pad_hw[0];
+              for (index_t w = 0; w < pad_left; ++w) {
+                const index_t out_offset = out_base + h * out_width + w;
+                index_t inw_base = w * stride_hw[1] - pad_hw[1];
+                AvgPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
+                              filter_hw, dilation_hw, output + out_offset);
               }
-              for (index_t h = pad_top; h < pad_bottom; ++h) {
-                index_t inh_base = h * stride_hw[0] - pad_hw[0];
-                for (index_t w = 0; w < pad_left; ++w) {
-                  const index_t out_offset = out_base + h * out_width + w;
-                  index_t inw_base = w * stride_hw[1] - pad_hw[1];
-                  AvgPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
-                                filter_hw, dilation_hw, output + out_offset);
-                }
-                for (index_t w = pad_right; w < out_width; ++w) {
-                  const index_t out_offset = out_base + h * out_width + w;
-                  index_t inw_base = w * stride_hw[1] - pad_hw[1];
-                  AvgPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
-                                filter_hw, dilation_hw, output + out_offset);
-                }
+              for (index_t w = pad_right; w < out_width; ++w) {
+                const index_t out_offset = out_base + h * out_width + w;
+                index_t inw_base = w * stride_hw[1] - pad_hw[1];
+                AvgPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
+                              filter_hw, dilation_hw, output + out_offset);
               }
-              for (index_t h = pad_bottom; h < out_height; ++h) {
-                index_t inh_base = h * stride_hw[0] - pad_hw[0];
-                for (index_t w = 0; w < out_width; ++w) {
-                  const index_t out_offset = out_base + h * out_width + w;
-                  index_t inw_base = w * stride_hw[1] - pad_hw[1];
-                  AvgPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
-                                filter_hw, dilation_hw, output + out_offset);
-                }
+            }
+            for (index_t h = pad_bottom; h < out_height; ++h) {
+              index_t inh_base = h * stride_hw[0] - pad_hw[0];
+              for (index_t w = 0; w < out_width; ++w) {
+                const index_t out_offset = out_base + h * out_width + w;
+                index_t inw_base = w * stride_hw[1] - pad_hw[1];
+                AvgPoolingPad(input, in_base, in_width, in_height, inw_base, inh_base,
+                              filter_hw, dilation_hw, output + out_offset);
               }
             }
-            { // handle no paddings
-              int block_size = filter_hw[0] * filter_hw[1];
-              for (index_t h = pad_top; h < pad_bottom; ++h) {
-                index_t inh_base = h * stride_hw[0] - pad_hw[0];
-                for (index_t w = pad_left; w < pad_right; ++w) {
-                  index_t inw_base = w * stride_hw[1] - pad_hw[1];
-                  const index_t out_offset = out_base + h * out_width + w;
-                  float res = 0;
-                  for (int fh = 0; fh < filter_hw[0]; ++fh) {
-                    index_t inh = inh_base + fh * dilation_hw[0];
-                    for (int fw = 0; fw < filter_hw[1]; ++fw) {
-                      index_t inw = inw_base + fw * dilation_hw[1];
-                      index_t input_offset = in_base + inh * in_width + inw;
-                      res += input[input_offset];
-                    }
+          }
+          { // handle no paddings
+            int block_size = filter_hw[0] * filter_hw[1];
+            for (index_t h = pad_top; h < pad_bottom; ++h) {
+              index_t inh_base = h * stride_hw[0] - pad_hw[0];
+              for (index_t w = pad_left; w < pad_right; ++w) {
+                index_t inw_base = w * stride_hw[1] - pad_hw[1];
+                const index_t out_offset = out_base + h * out_width + w;
+                float res = 0;
+                for (int fh = 0; fh < filter_hw[0]; ++fh) {
+                  index_t inh = inh_base + fh * dilation_hw[0];
+                  for (int fw = 0; fw < filter_hw[1]; ++fw) {
+                    index_t inw = inw_base + fw * dilation_hw[1];
+                    index_t input_offset = in_base + inh * in_width + inw;
+                    res += input[input_offset];
                   }
-                  output[out_offset] = res / block_size;
                 }
+                output[out_offset] = res / block_size;
               }
             }
           }
         }
-      }, 0, batch, 1, 0, out_channels, 1);
-    }
+      }
+    }, 0, batch, 1, 0, out_channels, 1);
   }
 };
 
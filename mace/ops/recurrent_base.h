@@ -0,0 +1,181 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_RECURRENT_BASE_H_
+#define MACE_OPS_RECURRENT_BASE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mace/core/ops/operator.h"
+#include "mace/core/tensor.h"
+#include "mace/ops/common/recurrent.h"
+#include "mace/ops/delegator/gemm.h"
+#include "mace/utils/memory.h"
+
+namespace mace {
+namespace ops {
+
+// Base of the sequence LSTM and GRU ops, which follow ONNX:
+//   X: [seq_length, batch, input_size]
+//   W: [directions, gates * hidden_size, input_size]
+//   R: [directions, gates * hidden_size, hidden_size]
+//   B: [directions, 2 * gates * hidden_size], W biases then R biases
+//   initial_h (initial_c): optional, [directions, batch, hidden_size]
+//   Y: [seq_length, directions, batch, hidden_size]
+//   Y_h (Y_c): optional, last hidden (cell) state of each direction
+// The input projections of all timesteps and directions are one gemm, only
+// the recurrent products are left to the sequential part.
+class RecurrentOpBase : public Operation {
+ public:
+  RecurrentOpBase(OpConstructContext *context, const index_t gates)
+      : Operation(context),
+        gates_(gates),
+        direction_(StringToRecurrentDirection(
+            Operation::GetOptionalArg<std::string>("direction", "forward"))),
+        clip_(Operation::GetOptionalArg<float>("clip", 0.f)),
+        gemm_(delegator::Gemm::Create(
+            context->workspace(),
+            MACE_DELEGATOR_KEY(Gemm, RuntimeType::RT_CPU, float,
+                               kCpuImplType),
+            delegator::GemmParam(true))) {}
+
+ protected:
+  // Checks the inputs and resizes the outputs.
+  MaceStatus Prepare() {
+    const Tensor *input = this->Input(INPUT);
+    const Tensor *weight = this->Input(WEIGHT);
+    const Tensor *recurrence = this->Input(RECURRENCE);
+    const Tensor *bias = this->Input(BIAS);
+    MACE_CHECK(input->dim_size() == 3, "recurrent input should be 3D: ",
+               MakeString(input->shape()));
+    seq_length_ = input->dim(0);
+    batch_ = input->dim(1);
+    input_size_ = input->dim(2);
+    directions_ = direction_ == BIDIRECTIONAL ? 2 : 1;
+    hidden_size_ = recurrence->dim(2);
+    const std::vector<index_t> weight_shape =
+        {directions_, gates_ * hidden_size_, input_size_};
+    const std::vector<index_t> recurrence_shape =
+        {directions_, gates_ * hidden_size_, hidden_size_};
+    const std::vector<index_t> bias_shape =
+        {directions_, 2 * gates_ * hidden_size_};
+    MACE_CHECK(weight->shape() == weight_shape, "W shape ",
+               MakeString(weight->shape()), " should be ",
+               MakeString(weight_shape));
+    MACE_CHECK(recurrence->shape() == recurrence_shape, "R shape ",
+               MakeString(recurrence->shape()), " should be ",
+               MakeString(recurrence_shape));
+    MACE_CHECK(bias->shape() == bias_shape, "B shape ",
+               MakeString(bias->shape()), " should be ",
+               MakeString(bias_shape));
+    const std::vector<index_t> state_shape =
+        {directions_, batch_, hidden_size_};
+    for (int i = INITIAL_H; i < this->InputSize(); ++i) {
+      MACE_CHECK(this->Input(i)->shape() == state_shape,
+                 "initial state shape ", MakeString(this->Input(i)->shape()),
+                 " should be ", MakeString(state_shape));
+    }
+
+    MACE_RETURN_IF_ERROR(this->Output(OUTPUT)->Resize(
+        {seq_length_, directions_, batch_, hidden_size_}));
+    for (int i = OUTPUT_H; i < this->OutputSize(); ++i) {
+      MACE_RETURN_IF_ERROR(this->Output(i)->Resize(state_shape));
+    }
+    zero_state_.assign(batch_ * hidden_size_, 0.f);
+    return MaceStatus::MACE_SUCCESS;
+  }
+
+  // projection[t * batch + b, d * gates * hidden + g] =
+  //     X[t, b, :] . W[d, g, :] + B[d, g] + B[d, (gates + g)]
+  // The recurrent biases of gates [folded_gates, gates) are left out.
+  MaceStatus ProjectInput(OpContext *context,
+                          const index_t folded_gates,
+                          std::unique_ptr<Tensor> *projection) {
+    Runtime *runtime = context->runtime();
+    const index_t gate_size = gates_ * hidden_size_;
+    if (combined_bias_ == nullptr) {
+      combined_bias_ = make_unique<Tensor>(
+          runtime, DT_FLOAT, MemoryType::CPU_BUFFER,
+          std::vector<index_t>{directions_ * gate_size});
+      runtime->AllocateBufferForTensor(combined_bias_.get(), RENT_PRIVATE);
+    }
+    const float *bias_data = this->Input(BIAS)->data<float>();
+    float *combined_data = combined_bias_->mutable_data<float>();
+    for (index_t d = 0; d < directions_; ++d) {
+      const float *w_bias = bias_data + d * 2 * gate_size;
+      const float *r_bias = w_bias + gate_size;
+      float *combined = combined_data + d * gate_size;
+      for (index_t i = 0; i < gate_size; ++i) {
+        combined[i] = w_bias[i]
+            + (i < folded_gates * hidden_size_ ? r_bias[i] : 0.f);
+      }
+    }
+
+    *projection = make_unique<Tensor>(
+        runtime, DT_FLOAT, MemoryType::CPU_BUFFER,
+        std::vector<index_t>{seq_length_ * batch_, directions_ * gate_size});
+    runtime->AllocateBufferForTensor(projection->get(), RENT_SCRATCH);
+
+    // W is a column-major (input_size, directions * gates * hidden) matrix
+    GemmEpilogue epilogue;
+    epilogue.bias = combined_bias_.get();
+    return gemm_->ComputeWithEpilogue(context,
+                                      this->Input(INPUT),
+                                      this->Input(WEIGHT),
+                                      seq_length_ * batch_,
+                                      directions_ * gate_size,
+                                      input_size_,
+                                      RowMajor,
+                                      ColMajor,
+                                      epilogue,
+                                      projection->get());
+  }
+
+  // Initial state of direction d, zeros if it is not given.
+  const float *InitialState(const int idx, const index_t d) {
+    if (this->InputSize() <= idx) {
+      return zero_state_.data();
+    }
+    return this->Input(idx)->data<float>() + d * batch_ * hidden_size_;
+  }
+
+  // The t-th step of direction d runs on timestep StepTime(d, t).
+  index_t StepTime(const index_t d, const index_t t) const {
+    return (direction_ == REVERSE || d == 1) ? seq_length_ - 1 - t : t;
+  }
+
+  const index_t gates_;
+  const RecurrentDirection direction_;
+  const float clip_;
+  index_t seq_length_;
+  index_t batch_;
+  index_t input_size_;
+  index_t hidden_size_;
+  index_t directions_;
+
+  MACE_OP_INPUT_TAGS(INPUT, WEIGHT, RECURRENCE, BIAS, INITIAL_H, INITIAL_C);
+  MACE_OP_OUTPUT_TAGS(OUTPUT, OUTPUT_H, OUTPUT_C);
+
+ private:
+  std::unique_ptr<delegator::Gemm> gemm_;
+  std::unique_ptr<Tensor> combined_bias_;
+  std::vector<float> zero_state_;
+};
+
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_RECURRENT_BASE_H_
@@ -22,6 +22,7 @@
 #include "mace/core/quantize.h"
 #include "mace/core/registry/ops_registry.h"
 #include "mace/core/tensor.h"
+#include "mace/ops/common/reduce.h"
 #include "mace/ops/common/reduce_type.h"
 #include "mace/runtimes/cpu/cpu_runtime.h"
 #ifdef MACE_ENABLE_OPENCL
@@ -64,14 +65,31 @@ class ReduceOpBase : public Operation {
 template<RuntimeType D, class T>
 class ReduceOp;
 
+// Accumulator type of the CPU reductions
+template<typename T>
+struct ReduceAccumulator {
+  typedef float Type;
+};
+
+template<>
+struct ReduceAccumulator<int> {
+  typedef int Type;
+};
+
+template<>
+struct ReduceAccumulator<uint8_t> {
+  typedef int32_t Type;
+};
+
 template<typename T>
 class ReduceOp<RuntimeType::RT_CPU, T> : public ReduceOpBase {
  public:
+  typedef typename ReduceAccumulator<T>::Type Acc;
+
   explicit ReduceOp(OpConstructContext *context)
       : ReduceOpBase(context) {}
 
   MaceStatus Run(OpContext *context) override {
-    MACE_UNUSED(context);
     Validate();
     const Tensor *input = this->Input(0);
     Tensor *output = this->Output(0);
@@ -81,8 +99,22 @@ class ReduceOp<RuntimeType::RT_CPU, T> : public ReduceOpBase {
       output->SetScale(input->scale());
       output->SetZeroPoint(input->zero_point());
     }
-    output->Resize(out_shape_);
-    Compute(context, input, output);
+    MACE_RETURN_IF_ERROR(output->Resize(out_shape_));
+    if (input->size() == 0) {
+      return MaceStatus::MACE_SUCCESS;
+    }
+
+    auto *runtime = context->runtime();
+    std::unique_ptr<Buffer> scratch_buffer;
+    Acc *scratch = nullptr;
+    const index_t scratch_size = ReduceScratchSize(steps_);
+    if (scratch_size > 0) {
+      MemInfo mem_info(MemoryType::CPU_BUFFER, DataTypeToEnum<Acc>::v(),
+                       {scratch_size});
+      scratch_buffer = runtime->ObtainBuffer(mem_info, RENT_SCRATCH);
+      scratch = scratch_buffer->mutable_data<Acc>();
+    }
+    Compute(&runtime->thread_pool(), input, scratch, output);
     return MaceStatus::MACE_SUCCESS;
   }
 
@@ -116,929 +148,80 @@ class ReduceOp<RuntimeType::RT_CPU, T> : public ReduceOpBase {
         out_shape_.push_back(1);
       }
     }
-    data_reshape_.clear();
-    unsigned int dim_index = 0;
-    for (; dim_index < input->dim_size(); ++dim_index) {
-      if (input->dim(dim_index) != 1) break;
-    }
-    if (dim_index >= input->dim_size()) {
-      reduce_first_axis_ = true;
-      data_reshape_.push_back(1);
-    } else {
-      reduce_first_axis_ = bitmap[dim_index];
-      data_reshape_.push_back(input->dim(dim_index));
-      ++dim_index;
-      for (; dim_index < input->dim_size(); ++dim_index) {
-        const int n = input->dim(dim_index);
-        if (n == 1) {
-          bitmap[dim_index] = bitmap[dim_index - 1];
-        }
-        if (bitmap[dim_index - 1] != bitmap[dim_index]) {
-          data_reshape_.push_back(n);
-        } else {
-          data_reshape_.back() *= n;
-        }
-      }
-    }
-  }
-
-  void Reduce1Dims(const OpContext *context,
-                   const Tensor *input_tensor,
-                   ReduceType type,
-                   Tensor *output_tensor) {
-    MACE_UNUSED(context);
-    const T *input = input_tensor->data<T>();
-    T *output = output_tensor->mutable_data<T>();
-    if (reduce_first_axis_) {
-      if (type == ReduceType::MEAN) {
-        T tmp = 0.f;
-        for (int i = 0; i < data_reshape_[0]; ++i) {
-          tmp = tmp + input[i];
-        }
-        output[0] = tmp / data_reshape_[0];
-      } else if (type == ReduceType::MIN) {
-        T tmp = input[0];
-        for (int i = 1; i < data_reshape_[0]; ++i) {
-          tmp = std::min<T>(tmp, input[i]);
-        }
-        output[0] = tmp;
-      } else if (type == ReduceType::MAX) {
-        T tmp = input[0];
-        for (int i = 1; i < data_reshape_[0]; ++i) {
-          tmp = std::max<T>(tmp, input[i]);
-        }
-        output[0] = tmp;
-      } else if (type == ReduceType::PROD) {
-        T tmp = input[0];
-        for (int i = 1; i < data_reshape_[0]; ++i) {
-          tmp = tmp * input[i];
-        }
-        output[0] = tmp;
-      } else if (type == ReduceType::SUM) {
-        T tmp = 0.f;
-        for (int i = 0; i < data_reshape_[0]; ++i) {
-          tmp = tmp + input[i];
-        }
-        output[0] = tmp;
-      } else {
-        MACE_NOT_IMPLEMENTED;
-      }
-    } else {
-      memcpy(output, input, data_reshape_[0] * sizeof(T));
-    }
+    steps_ = PlanReduce(input->shape(), bitmap);
   }
 
-  void Reduce2Dims(const OpContext *context,
-                   const Tensor *input_tensor,
-                   ReduceType type,
-                   Tensor *output_tensor) {
-    utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
-
-    const T *input = input_tensor->data<T>();
-    T *output = output_tensor->mutable_data<T>();
-    if (reduce_first_axis_) {
-      thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
-        if (type == ReduceType::MEAN) {
-          for (index_t i = start; i < end; i += step) {
-            T tmp = 0.f;
-            for (int j = 0; j < data_reshape_[0]; ++j) {
-              tmp += input[j * data_reshape_[1] + i];
-            }
-            output[i] = tmp / data_reshape_[0];
-          }
-        } else if (type == ReduceType::MIN) {
-          for (index_t i = start; i < end; i += step) {
-            T tmp = input[i];
-            for (int j = 1; j < data_reshape_[0]; ++j) {
-              tmp = std::min(tmp, input[j * data_reshape_[1] + i]);
-            }
-            output[i] = tmp;
-          }
-        } else if (type == ReduceType::MAX) {
-          for (index_t i = start; i < end; i += step) {
-            T tmp = input[i];
-            for (int j = 1; j < data_reshape_[0]; ++j) {
-              tmp = std::max(tmp, input[j * data_reshape_[1] + i]);
-            }
-            output[i] = tmp;
-          }
-        } else if (type == ReduceType::PROD) {
-          for (index_t i = start; i < end; i += step) {
-            T tmp = input[i];
-            for (int j = 1; j < data_reshape_[0]; ++j) {
-              tmp = tmp * input[j * data_reshape_[1] + i];
-            }
-            output[i] = tmp;
-          }
-        } else if (type == ReduceType::SUM) {
-          for (index_t i = start; i < end; i += step) {
-            T tmp = 0.f;
-            for (int j = 0; j < data_reshape_[0]; ++j) {
-              tmp += input[j * data_reshape_[1] + i];
-            }
-            output[i] = tmp;
-          }
-        } else {
-          MACE_NOT_IMPLEMENTED;
-        }
-      }, 0, data_reshape_[1], 1);
-    } else {
-      thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
-        if (type == ReduceType::MEAN) {
-          for (index_t i = start; i < end; i += step) {
-            T tmp = 0.f;
-            for (int j = 0; j < data_reshape_[1]; ++j) {
-              tmp += input[i * data_reshape_[1] + j];
-            }
-            output[i] = tmp / data_reshape_[1];
-          }
-        } else if (type == ReduceType::MIN) {
-          for (index_t i = start; i < end; i += step) {
-            T tmp = input[i * data_reshape_[1]];
-            for (int j = 1; j < data_reshape_[1]; ++j) {
-              tmp = std::min(tmp, input[i * data_reshape_[1] + j]);
-            }
-            output[i] = tmp;
-          }
-        } else if (type == ReduceType::MAX) {
-          for (index_t i = start; i < end; i += step) {
-            T tmp = input[i * data_reshape_[1]];
-            for (int j = 1; j < data_reshape_[1]; ++j) {
-              tmp = std::max(tmp, input[i * data_reshape_[1] + j]);
-            }
-            output[i] = tmp;
-          }
-        } else if (type == ReduceType::PROD) {
-          for (index_t i = start; i < end; i += step) {
-            T tmp = input[i * data_reshape_[1]];
-            for (int j = 1; j < data_reshape_[1]; ++j) {
-              tmp = tmp * input[i * data_reshape_[1] + j];
-            }
-            output[i] = tmp;
-          }
-        } else if (type == ReduceType::SUM) {
-          for (index_t i = start; i < end; i += step) {
-            T tmp = 0.f;
-            for (int j = 0; j < data_reshape_[1]; ++j) {
-              tmp += input[i * data_reshape_[1] + j];
-            }
-            output[i] = tmp;
-          }
-        } else {
-          MACE_NOT_IMPLEMENTED;
-        }
-      }, 0, data_reshape_[0], 1);
-    }
-  }
-
-  void Reduce3Dims(const OpContext *context,
-                   const Tensor *input_tensor,
-                   ReduceType type,
-                   Tensor *output_tensor) {
-    utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
-
-    const T *input = input_tensor->data<T>();
-    T *output = output_tensor->mutable_data<T>();
-    if (reduce_first_axis_) {
-      thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
-        if (type == ReduceType::MEAN) {
-          for (index_t i = start; i < end; i += step) {
-            for (int j = 0; j < data_reshape_[2]; ++j) {
-              for (int k = 0; k < data_reshape_[0]; ++k) {
-                output[i] +=
-                    input[(k * data_reshape_[1] + i) * data_reshape_[2]
-                        + j];
-              }
-            }
-            output[i] /= (data_reshape_[0] * data_reshape_[2]);
-          }
-        } else if (type == ReduceType::MIN) {
-          for (index_t i = start; i < end; i += step) {
-            T tmp = input[i * data_reshape_[2]];
-            for (int j = 0; j < data_reshape_[2]; ++j) {
-              for (int k = 0; k < data_reshape_[0]; ++k) {
-                tmp = std::min(tmp,
-                               input[
-                                   (k * data_reshape_[1] + i) * data_reshape_[2]
-                                       + j]);
-              }
-            }
-            output[i] = tmp;
-          }
-        } else if (type == ReduceType::MAX) {
-          for (index_t i = start; i < end; i += step) {
-            T tmp = input[i * data_reshape_[2]];
-            for (int j = 0; j < data_reshape_[2]; ++j) {
-              for (int k = 0; k < data_reshape_[0]; ++k) {
-                tmp =
-                    std::max(tmp,
-                             input[(k * data_reshape_[1] + i)
-                                 * data_reshape_[2] + j]);
-              }
-            }
-            output[i] = tmp;
-          }
-        } else if (type == ReduceType::PROD) {
-          for (index_t i = start; i < end; i += step) {
-            T tmp = 1;
-            for (int j = 0; j < data_reshape_[2]; ++j) {
-              for (int k = 0; k < data_reshape_[0]; ++k) {
-                tmp *= input[(k * data_reshape_[1] + i) * data_reshape_[2] + j];
-              }
-            }
-            output[i] = tmp;
-          }
-        } else if (type == ReduceType::SUM) {
-          for (index_t i = start; i < end; i += step) {
-            for (int j = 0; j < data_reshape_[2]; ++j) {
-              for (int k = 0; k < data_reshape_[0]; ++k) {
-                output[i] +=
-                    input[(k * data_reshape_[1] + i) * data_reshape_[2]
-                        + j];
-              }
-            }
-          }
-        } else {
-          MACE_NOT_IMPLEMENTED;
-        }
-      }, 0, data_reshape_[1], 1);
-    } else {
-      thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
-        if (type == ReduceType::MEAN) {
-          for (index_t i = start; i < end; i += step) {
-            for (int j = 0; j < data_reshape_[2]; ++j) {
-              for (int k = 0; k < data_reshape_[1]; ++k) {
-                output[i * data_reshape_[2] + j] +=
-                    input[(i * data_reshape_[1] + k) * data_reshape_[2]
-                        + j];
-              }
-              output[i * data_reshape_[2] + j] /= data_reshape_[1];
-            }
-          }
-        } else if (type == ReduceType::MIN) {
-          for (index_t i = start; i < end; i += step) {
-            for (int j = 0; j < data_reshape_[2]; ++j) {
-              T tmp = input[i * data_reshape_[1] * data_reshape_[2] + j];
-              for (int k = 1; k < data_reshape_[1]; ++k) {
-                tmp = std::min(tmp,
-                               input[(i * data_reshape_[1] + k) *
-                                   data_reshape_[2] + j]);
-              }
-              output[i * data_reshape_[2] + j] = tmp;
-            }
-          }
-        } else if (type == ReduceType::MAX) {
-          for (index_t i = start; i < end; i += step) {
-            for (int j = 0; j < data_reshape_[2]; ++j) {
-              T tmp = input[i * data_reshape_[1] * data_reshape_[2] + j];
-              for (int k = 1; k < data_reshape_[1]; ++k) {
-                tmp = std::max(tmp,
-                               input[(i * data_reshape_[1] + k) *
-                                   data_reshape_[2] + j]);
-              }
-              output[i * data_reshape_[2] + j] = tmp;
-            }
-          }
-        } else if (type == ReduceType::PROD) {
-          for (index_t i = start; i < end; i += step) {
-            for (int j = 0; j < data_reshape_[2]; ++j) {
-              T tmp = input[i * data_reshape_[1] * data_reshape_[2] + j];
-              for (int k = 1; k < data_reshape_[1]; ++k) {
-                tmp *= input[(i * data_reshape_[1] + k) *
-                    data_reshape_[2] + j];
-              }
-              output[i * data_reshape_[2] + j] = tmp;
-            }
-          }
-        } else if (type == ReduceType::SUM) {
-          for (index_t i = start; i < end; i += step) {
-            for (int j = 0; j < data_reshape_[2]; ++j) {
-              for (int k = 0; k < data_reshape_[1]; ++k) {
-                output[i * data_reshape_[2] + j] +=
-                    input[(i * data_reshape_[1] + k) * data_reshape_[2] + j];
-              }
-            }
-          }
-        } else {
-          MACE_NOT_IMPLEMENTED;
-        }
-      }, 0, data_reshape_[0], 1);
-    }
-  }
-
-  void Reduce4Dims(const OpContext *context,
-                   const Tensor *input_tensor,
-                   ReduceType type,
-                   Tensor *output_tensor) {
-    utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
-
-    const T *input = input_tensor->data<T>();
-    T *output = output_tensor->mutable_data<T>();
-    if (reduce_first_axis_) {
-      thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
-                                index_t start1, index_t end1, index_t step1) {
-        if (type == ReduceType::MEAN) {
-          for (index_t i = start0; i < end0; i += step0) {
-            for (index_t j = start1; j < end1; j += step1) {
-              for (int k = 0; k < data_reshape_[2]; ++k) {
-                for (int t = 0; t < data_reshape_[0]; ++t) {
-                  output[i * data_reshape_[3] + j] +=
-                      input[((t * data_reshape_[1] + i) *
-                          data_reshape_[2] + k) * data_reshape_[3] + j];
-                }
-              }
-              output[i * data_reshape_[3] + j] /=
-                  (data_reshape_[0] * data_reshape_[2]);
-            }
-          }
-        } else if (type == ReduceType::MIN) {
-          for (index_t i = start0; i < end0; i += step0) {
-            for (index_t j = start1; j < end1; j += step1) {
-              T tmp = input[i * data_reshape_[2] * data_reshape_[3] + j];
-              for (int k = 0; k < data_reshape_[2]; ++k) {
-                for (int t = 0; t < data_reshape_[0]; ++t) {
-                  tmp = std::min(tmp,
-                                 input[((t * data_reshape_[1] + i) *
-                                     data_reshape_[2] + k) * data_reshape_[3]
-                                     + j]);
-                }
-              }
-              output[i * data_reshape_[3] + j] = tmp;
-            }
-          }
-        } else if (type == ReduceType::MAX) {
-          for (index_t i = start0; i < end0; i += step0) {
-            for (index_t j = start1; j < end1; j += step1) {
-              T tmp = input[i * data_reshape_[2] * data_reshape_[3] + j];
-              for (int k = 0; k < data_reshape_[2]; ++k) {
-                for (int t = 0; t < data_reshape_[0]; ++t) {
-                  tmp = std::max(tmp,
-                                 input[((t * data_reshape_[1] + i) *
-                                     data_reshape_[2] + k) * data_reshape_[3]
-                                     + j]);
-                }
-              }
-              output[i * data_reshape_[3] + j] = tmp;
-            }
-          }
-        } else if (type == ReduceType::PROD) {
-          for (index_t i = start0; i < end0; i += step0) {
-            for (index_t j = start1; j < end1; j += step1) {
-              T tmp = 1;
-              for (int k = 0; k < data_reshape_[2]; ++k) {
-                for (int t = 0; t < data_reshape_[0]; ++t) {
-                  tmp = tmp * input[((t * data_reshape_[1] + i) *
-                      data_reshape_[2] + k) * data_reshape_[3] + j];
-                }
-              }
-              output[i * data_reshape_[3] + j] = tmp;
-            }
-          }
-        } else if (type == ReduceType::SUM) {
-          for (index_t i = start0; i < end0; i += step0) {
-            for (index_t j = start1; j < end1; j += step1) {
-              for (int k = 0; k < data_reshape_[2]; ++k) {
-                for (int t = 0; t < data_reshape_[0]; ++t) {
-                  output[i * data_reshape_[3] + j] +=
-                      input[((t * data_reshape_[1] + i) *
-                          data_reshape_[2] + k) * data_reshape_[3] + j];
-                }
-              }
-            }
-          }
-        } else {
-          MACE_NOT_IMPLEMENTED;
-        }
-      }, 0, data_reshape_[1], 1, 0, data_reshape_[3], 1);
-    } else {
-      thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
-                                index_t start1, index_t end1, index_t step1) {
-        if (type == ReduceType::MEAN) {
-          for (index_t i = start0; i < end0; i += step0) {
-            for (index_t j = start1; j < end1; j += step1) {
-              for (int k = 0; k < data_reshape_[1]; ++k) {
-                for (int t = 0; t < data_reshape_[3]; ++t) {
-                  output[i * data_reshape_[2] + j] +=
-                      input[((i * data_reshape_[1] + k) *
-                          data_reshape_[2] + j) * data_reshape_[3] + t];
-                }
-              }
-              output[i * data_reshape_[2] + j] /=
-                  (data_reshape_[1] * data_reshape_[3]);
-            }
-          }
-        } else if (type == ReduceType::MIN) {
-          for (index_t i = start0; i < end0; i += step0) {
-            for (index_t j = start1; j < end1; j += step1) {
-              T tmp = input[(i * data_reshape_[1] *
-                  data_reshape_[2] + j) * data_reshape_[3]];
-              for (int k = 0; k < data_reshape_[1]; ++k) {
-                for (int t = 0; t < data_reshape_[3]; ++t) {
-                  tmp =
-                      std::min(tmp,
-                               input[((i * data_reshape_[1] + k) *
-                                   data_reshape_[2] + j) * data_reshape_[3]
-                                   + t]);
-                }
-              }
-              output[i * data_reshape_[2] + j] = tmp;
-            }
-          }
-        } else if (type == ReduceType::MAX) {
-          for (index_t i = start0; i < end0; i += step0) {
-            for (index_t j = start1; j < end1; j += step1) {
-              T tmp = input[(i * data_reshape_[1] *
-                  data_reshape_[2] + j) * data_reshape_[3]];
-              for (int k = 0; k < data_reshape_[1]; ++k) {
-                for (int t = 0; t < data_reshape_[3]; ++t) {
-                  tmp =
-                      std::max(tmp,
-                               input[((i * data_reshape_[1] + k) *
-                                   data_reshape_[2] + j) * data_reshape_[3]
-                                   + t]);
-                }
-              }
-              output[i * data_reshape_[2] + j] = tmp;
-            }
-          }
-        } else if (type == ReduceType::PROD) {
-          for (index_t i = start0; i < end0; i += step0) {
-            for (index_t j = start1; j < end1; j += step1) {
-              T tmp = 1;
-              for (int k = 0; k < data_reshape_[1]; ++k) {
-                for (int t = 0; t < data_reshape_[3]; ++t) {
-                  tmp = tmp * input[((i * data_reshape_[1] + k) *
-                      data_reshape_[2] + j) * data_reshape_[3] + t];
-                }
-              }
-              output[i * data_reshape_[2] + j] = tmp;
-            }
-          }
-        } else if (type == ReduceType::SUM) {
-          for (index_t i = start0; i < end0; i += step0) {
-            for (index_t j = start1; j < end1; j += step1) {
-              for (int k = 0; k < data_reshape_[1]; ++k) {
-                for (int t = 0; t < data_reshape_[3]; ++t) {
-                  output[i * data_reshape_[2] + j] +=
-                      input[((i * data_reshape_[1] + k) *
-                          data_reshape_[2] + j) * data_reshape_[3] + t];
-                }
-              }
-            }
-          }
-        } else {
-          MACE_NOT_IMPLEMENTED;
-        }
-      }, 0, data_reshape_[0], 1, 0, data_reshape_[2], 1);
-    }
+  template<typename Op, typename Finalize>
+  void Reduce(utils::ThreadPool *thread_pool, const Tensor *input,
+              const Finalize &finalize, Acc *scratch, Tensor *output) {
+    ReduceCompute<Op>(thread_pool, input->data<T>(), steps_,
+                      ReduceCast<Acc>(), finalize, scratch,
+                      output->mutable_data<T>());
   }
 
-  void Compute(const OpContext *context, const Tensor *input, Tensor *output) {
-    T *output_ptr = output->mutable_data<T>();
-    memset(static_cast<void *>(output_ptr), 0, output->size() * sizeof(T));
-    switch (data_reshape_.size()) {
-      case 1:Reduce1Dims(context, input, reduce_type_, output);
+  void Compute(utils::ThreadPool *thread_pool, const Tensor *input,
+               Acc *scratch, Tensor *output) {
+    const index_t count = input->size() / output->size();
+    auto cast = [](Acc a) { return static_cast<T>(a); };
+    switch (reduce_type_) {
+      case ReduceType::MEAN:
+        Reduce<ReduceSumOp<Acc>>(thread_pool, input, [count](Acc a) {
+          return static_cast<T>(a / count);
+        }, scratch, output);
         break;
-      case 2:Reduce2Dims(context, input, reduce_type_, output);
+      case ReduceType::MIN:
+        Reduce<ReduceMinOp<Acc>>(thread_pool, input, cast, scratch, output);
         break;
-      case 3:Reduce3Dims(context, input, reduce_type_, output);
+      case ReduceType::MAX:
+        Reduce<ReduceMaxOp<Acc>>(thread_pool, input, cast, scratch, output);
         break;
-      case 4:Reduce4Dims(context, input, reduce_type_, output);
+      case ReduceType::PROD:
+        Reduce<ReduceProdOp<Acc>>(thread_pool, input, cast, scratch, output);
         break;
-      default:MACE_CHECK(false, "not implemented in mace")
-          << ", data reshape size: " << data_reshape_.size()
-          << ", reduce first axis: " << reduce_first_axis_;
+      case ReduceType::SUM:
+        Reduce<ReduceSumOp<Acc>>(thread_pool, input, cast, scratch, output);
         break;
+      default:
+        MACE_NOT_IMPLEMENTED;
     }
   }
 
  private:
-  bool reduce_first_axis_;
-  std::vector<int> data_reshape_;
+  std::vector<ReduceStep> steps_;
   std::vector<index_t> out_shape_;
 };
 
 #ifdef MACE_ENABLE_QUANTIZE
 template<>
-void ReduceOp<RuntimeType::RT_CPU, uint8_t>::Reduce1Dims(
-    const OpContext *context,
-    const Tensor *input_tensor, ReduceType type, Tensor *output_tensor) {
-  MACE_UNUSED(context);
-  const uint8_t *input = input_tensor->data<uint8_t>();
-  uint8_t *output = output_tensor->mutable_data<uint8_t>();
-  if (reduce_first_axis_) {
-    if (type == ReduceType::MEAN) {
-      uint32_t tmp = 0;
-      for (int i = 0; i < data_reshape_[0]; ++i) {
-        tmp = tmp + input[i];
-      }
-      output[0] = static_cast<uint8_t>(
-          (tmp + data_reshape_[0] / 2) / data_reshape_[0]);
-    } else if (type == ReduceType::MIN) {
-      uint8_t tmp = input[0];
-      for (int i = 1; i < data_reshape_[0]; ++i) {
-        tmp = std::min<uint8_t>(tmp, input[i]);
-      }
-      output[0] = tmp;
-    } else if (type == ReduceType::MAX) {
-      uint8_t tmp = input[0];
-      for (int i = 1; i < data_reshape_[0]; ++i) {
-        tmp = std::max<uint8_t>(tmp, input[i]);
-      }
-      output[0] = tmp;
-    } else if (type == ReduceType::SUM) {
-      int32_t sum = 0;
-      const auto in_zero_point = input_tensor->zero_point();
-      const auto out_zero_point = output_tensor->zero_point();
-      const auto scale = input_tensor->scale() / output_tensor->scale();
-      for (int i = 0; i < data_reshape_[0]; ++i) {
-        sum = sum + input[i];
-      }
-      const float f = (sum - in_zero_point * data_reshape_[0]) * scale;
-      output[0] = Saturate<uint8_t>(std::roundf(f + out_zero_point));
-    } else {
-      MACE_NOT_IMPLEMENTED;
+void ReduceOp<RuntimeType::RT_CPU, uint8_t>::Compute(
+    utils::ThreadPool *thread_pool, const Tensor *input, int32_t *scratch,
+    Tensor *output) {
+  const index_t count = input->size() / output->size();
+  auto cast = [](int32_t a) { return static_cast<uint8_t>(a); };
+  switch (reduce_type_) {
+    case ReduceType::MEAN:
+      Reduce<ReduceSumOp<int32_t>>(thread_pool, input, [count](int32_t a) {
+        return static_cast<uint8_t>((a + count / 2) / count);
+      }, scratch, output);
+      break;
+    case ReduceType::MIN:
+      Reduce<ReduceMinOp<int32_t>>(thread_pool, input, cast, scratch, output);
+      break;
+    case ReduceType::MAX:
+      Reduce<ReduceMaxOp<int32_t>>(thread_pool, input, cast, scratch, output);
+      break;
+    case ReduceType::SUM: {
+      const auto in_zero_point = input->zero_point();
+      const auto out_zero_point = output->zero_point();
+      const auto scale = input->scale() / output->scale();
+      Reduce<ReduceSumOp<int32_t>>(thread_pool, input, [=](int32_t sum) {
+        const float f = (sum - in_zero_point * count) * scale;
+        return Saturate<uint8_t>(std::roundf(f + out_zero_point));
+      }, scratch, output);
+      break;
     }
-  } else {
-    memcpy(output, input, data_reshape_[0] * sizeof(uint8_t));
-  }
-}
-
-template<>
-void ReduceOp<RuntimeType::RT_CPU, uint8_t>::Reduce2Dims(
-    const OpContext *context,
-    const Tensor *input_tensor, ReduceType type, Tensor *output_tensor) {
-  utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
-
-  const uint8_t *input = input_tensor->data<uint8_t>();
-  uint8_t *output = output_tensor->mutable_data<uint8_t>();
-  if (reduce_first_axis_) {
-    thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
-      if (type == ReduceType::MEAN) {
-        for (index_t i = start; i < end; i += step) {
-          uint32_t tmp = 0;
-          for (int j = 0; j < data_reshape_[0]; ++j) {
-            tmp += input[j * data_reshape_[1] + i];
-          }
-          output[i] = static_cast<uint8_t>(
-              (tmp + data_reshape_[0] / 2) / data_reshape_[0]);
-        }
-      } else if (type == ReduceType::MIN) {
-        for (index_t i = start; i < end; i += step) {
-          uint8_t tmp = input[i];
-          for (int j = 1; j < data_reshape_[0]; ++j) {
-            tmp = std::min(tmp, input[j * data_reshape_[1] + i]);
-          }
-          output[i] = tmp;
-        }
-      } else if (type == ReduceType::MAX) {
-        for (index_t i = start; i < end; i += step) {
-          uint8_t tmp = input[i];
-          for (int j = 1; j < data_reshape_[0]; ++j) {
-            tmp = std::max(tmp, input[j * data_reshape_[1] + i]);
-          }
-          output[i] = tmp;
-        }
-      } else if (type == ReduceType::SUM) {
-        const auto in_zero_point = input_tensor->zero_point();
-        const auto out_zero_point = output_tensor->zero_point();
-        const auto scale = input_tensor->scale() / output_tensor->scale();
-        for (index_t i = start; i < end; i += step) {
-          int32_t sum = 0;
-          for (int j = 0; j < data_reshape_[0]; ++j) {
-            sum += input[j * data_reshape_[1] + i];
-          }
-          const float f = (sum - in_zero_point * data_reshape_[0]) * scale;
-          output[i] = Saturate<uint8_t>(std::roundf(f + out_zero_point));
-        }
-      } else {
-        MACE_NOT_IMPLEMENTED;
-      }
-    }, 0, data_reshape_[1], 1);
-  } else {
-    thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
-      if (type == ReduceType::MEAN) {
-        for (index_t i = start; i < end; i += step) {
-          uint32_t tmp = 0;
-          for (int j = 0; j < data_reshape_[1]; ++j) {
-            tmp += input[i * data_reshape_[1] + j];
-          }
-          output[i] = static_cast<uint8_t>(
-              (tmp + data_reshape_[1] / 2) / data_reshape_[1]);
-        }
-      } else if (type == ReduceType::MIN) {
-        for (index_t i = start; i < end; i += step) {
-          uint8_t tmp = input[i * data_reshape_[1]];
-          for (int j = 1; j < data_reshape_[1]; ++j) {
-            tmp = std::min(tmp, input[i * data_reshape_[1] + j]);
-          }
-          output[i] = tmp;
-        }
-      } else if (type == ReduceType::MAX) {
-        for (index_t i = start; i < end; i += step) {
-          uint8_t tmp = input[i * data_reshape_[1]];
-          for (int j = 1; j < data_reshape_[1]; ++j) {
-            tmp = std::max(tmp, input[i * data_reshape_[1] + j]);
-          }
-          output[i] = tmp;
-        }
-      } else if (type == ReduceType::SUM) {
-        const auto in_zero_point = input_tensor->zero_point();
-        const auto out_zero_point = output_tensor->zero_point();
-        const auto scale = input_tensor->scale() / output_tensor->scale();
-        for (index_t i = start; i < end; i += step) {
-          int32_t sum = 0;
-          for (int j = 0; j < data_reshape_[1]; ++j) {
-            sum += input[i * data_reshape_[1] + j];
-          }
-          const float f = (sum - in_zero_point * data_reshape_[1]) * scale;
-          output[i] = Saturate<uint8_t>(std::roundf(f + out_zero_point));
-        }
-      } else {
-        MACE_NOT_IMPLEMENTED;
-      }
-    }, 0, data_reshape_[0], 1);
-  }
-}
-
-template<>
-void ReduceOp<RuntimeType::RT_CPU, uint8_t>::Reduce3Dims(
-    const OpContext *context,
-    const Tensor *input_tensor, ReduceType type, Tensor *output_tensor) {
-  utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
-
-  const uint8_t *input = input_tensor->data<uint8_t>();
-  uint8_t *output = output_tensor->mutable_data<uint8_t>();
-  if (reduce_first_axis_) {
-    thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
-      if (type == ReduceType::MEAN) {
-        for (index_t i = start; i < end; i += step) {
-          uint32_t tmp = 0;
-          for (int j = 0; j < data_reshape_[2]; ++j) {
-            for (int k = 0; k < data_reshape_[0]; ++k) {
-              tmp += input[(k * data_reshape_[1] + i) * data_reshape_[2] + j];
-            }
-          }
-          index_t dim = data_reshape_[0] * data_reshape_[2];
-          output[i] = static_cast<uint8_t>((tmp + dim / 2) / dim);
-        }
-      } else if (type == ReduceType::MIN) {
-        for (index_t i = start; i < end; i += step) {
-          uint8_t tmp = input[i * data_reshape_[2]];
-          for (int j = 0; j < data_reshape_[2]; ++j) {
-            for (int k = 0; k < data_reshape_[0]; ++k) {
-              tmp = std::min(tmp,
-                             input[(k * data_reshape_[1] + i) * data_reshape_[2]
-                                 + j]);
-            }
-          }
-          output[i] = tmp;
-        }
-      } else if (type == ReduceType::MAX) {
-        for (index_t i = start; i < end; i += step) {
-          uint8_t tmp = input[i * data_reshape_[2]];
-          for (int j = 0; j < data_reshape_[2]; ++j) {
-            for (int k = 0; k < data_reshape_[0]; ++k) {
-              tmp =
-                  std::max(tmp,
-                           input[(k * data_reshape_[1] + i)
-                               * data_reshape_[2] + j]);
-            }
-          }
-          output[i] = tmp;
-        }
-      } else if (type == ReduceType::SUM) {
-        const auto in_zero_point = input_tensor->zero_point();
-        const auto out_zero_point = output_tensor->zero_point();
-        const auto scale = input_tensor->scale() / output_tensor->scale();
-        for (index_t i = start; i < end; i += step) {
-          int32_t sum = 0;
-          for (int j = 0; j < data_reshape_[2]; ++j) {
-            for (int k = 0; k < data_reshape_[0]; ++k) {
-              sum += input[(k * data_reshape_[1] + i) * data_reshape_[2] + j];
-            }
-          }
-          const auto count = data_reshape_[2] * data_reshape_[0];
-          const float f = (sum - in_zero_point * count) * scale;
-          output[i] = Saturate<uint8_t>(std::roundf(f + out_zero_point));
-        }
-      } else {
-        MACE_NOT_IMPLEMENTED;
-      }
-    }, 0, data_reshape_[1], 1);
-  } else {
-    thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
-                              index_t start1, index_t end1, index_t step1) {
-      if (type == ReduceType::MEAN) {
-        for (index_t i = start0; i < end0; i += step0) {
-          for (index_t j = start1; j < end1; j += step1) {
-            uint32_t tmp = 0;
-            for (int k = 0; k < data_reshape_[1]; ++k) {
-              tmp += input[(i * data_reshape_[1] + k) * data_reshape_[2] + j];
-            }
-            output[i * data_reshape_[2] + j] =
-                static_cast<uint8_t>((tmp + data_reshape_[1] / 2) /
-                    data_reshape_[1]);
-          }
-        }
-      } else if (type == ReduceType::MIN) {
-        for (index_t i = start0; i < end0; i += step0) {
-          for (index_t j = start1; j < end1; j += step1) {
-            uint8_t tmp = input[i * data_reshape_[1] * data_reshape_[2] + j];
-            for (int k = 1; k < data_reshape_[1]; ++k) {
-              tmp = std::min(tmp,
-                             input[(i * data_reshape_[1] + k) *
-                                 data_reshape_[2] + j]);
-            }
-            output[i * data_reshape_[2] + j] = tmp;
-          }
-        }
-      } else if (type == ReduceType::MAX) {
-        for (index_t i = start0; i < end0; i += step0) {
-          for (index_t j = start1; j < end1; j += step1) {
-            uint8_t tmp = input[i * data_reshape_[1] * data_reshape_[2] + j];
-            for (int k = 1; k < data_reshape_[1]; ++k) {
-              tmp = std::max(tmp,
-                             input[(i * data_reshape_[1] + k) *
-                                 data_reshape_[2] + j]);
-            }
-            output[i * data_reshape_[2] + j] = tmp;
-          }
-        }
-      } else if (type == ReduceType::SUM) {
-        const auto in_zero_point = input_tensor->zero_point();
-        const auto out_zero_point = output_tensor->zero_point();
-        const auto scale = input_tensor->scale() / output_tensor->scale();
-        for (index_t i = start0; i < end0; i += step0) {
-          for (index_t j = start1; j < end1; j += step1) {
-            int32_t sum = 0;
-            for (int k = 0; k < data_reshape_[1]; ++k) {
-              sum += input[(i * data_reshape_[1] + k) * data_reshape_[2] + j];
-            }
-            const float f = (sum - in_zero_point * data_reshape_[1]) * scale;
-            output[i * data_reshape_[2] + j] =
-                Saturate<uint8_t>(std::roundf(f + out_zero_point));
-          }
-        }
-      } else {
-        MACE_NOT_IMPLEMENTED;
-      }
-    }, 0, data_reshape_[0], 1, 0, data_reshape_[2], 1);
-  }
-}
-
-template<>
-void ReduceOp<RuntimeType::RT_CPU, uint8_t>::Reduce4Dims(
-    const OpContext *context,
-    const Tensor *input_tensor, ReduceType type, Tensor *output_tensor) {
-  utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
-
-  const uint8_t *input = input_tensor->data<uint8_t>();
-  uint8_t *output = output_tensor->mutable_data<uint8_t>();
-  if (reduce_first_axis_) {
-    thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
-                              index_t start1, index_t end1, index_t step1) {
-      if (type == ReduceType::MEAN) {
-        for (index_t i = start0; i < end0; i += step0) {
-          for (index_t j = start1; j < end1; j += step1) {
-            uint32_t tmp = 0;
-            for (int k = 0; k < data_reshape_[2]; ++k) {
-              for (int t = 0; t < data_reshape_[0]; ++t) {
-                tmp += input[((t * data_reshape_[1] + i) *
-                    data_reshape_[2] + k) * data_reshape_[3] + j];
-              }
-            }
-            index_t dim = data_reshape_[0] * data_reshape_[2];
-            output[i * data_reshape_[3] + j] =
-                static_cast<uint8_t>((tmp + dim / 2) / dim);
-          }
-        }
-      } else if (type == ReduceType::MIN) {
-        for (index_t i = start0; i < end0; i += step0) {
-          for (index_t j = start1; j < end1; j += step1) {
-            uint8_t tmp = input[i * data_reshape_[2] * data_reshape_[3] + j];
-            for (int k = 0; k < data_reshape_[2]; ++k) {
-              for (int t = 0; t < data_reshape_[0]; ++t) {
-                tmp = std::min(tmp,
-                               input[((t * data_reshape_[1] + i) *
-                                   data_reshape_[2] + k) * data_reshape_[3]
-                                   + j]);
-              }
-            }
-            output[i * data_reshape_[3] + j] = tmp;
-          }
-        }
-      } else if (type == ReduceType::MAX) {
-        for (index_t i = start0; i < end0; i += step0) {
-          for (index_t j = start1; j < end1; j += step1) {
-            uint8_t tmp = input[i * data_reshape_[2] * data_reshape_[3] + j];
-            for (int k = 0; k < data_reshape_[2]; ++k) {
-              for (int t = 0; t < data_reshape_[0]; ++t) {
-                tmp = std::max(tmp,
-                               input[((t * data_reshape_[1] + i) *
-                                   data_reshape_[2] + k) * data_reshape_[3]
-                                   + j]);
-              }
-            }
-            output[i * data_reshape_[3] + j] = tmp;
-          }
-        }
-      } else if (type == ReduceType::SUM) {
-        const auto in_zero_point = input_tensor->zero_point();
-        const auto out_zero_point = output_tensor->zero_point();
-        const auto scale = input_tensor->scale() / output_tensor->scale();
-        for (index_t i = start0; i < end0; i += step0) {
-          for (index_t j = start1; j < end1; j += step1) {
-            int32_t sum = 0;
-            for (int k = 0; k < data_reshape_[2]; ++k) {
-              for (int t = 0; t < data_reshape_[0]; ++t) {
-                sum += input[((t * data_reshape_[1] + i) *
-                    data_reshape_[2] + k) * data_reshape_[3] + j];
-              }
-            }
-            const auto count = data_reshape_[2] * data_reshape_[0];
-            const float f = (sum - in_zero_point * count) * scale;
-            output[i * data_reshape_[3] + j] =
-                Saturate<uint8_t>(std::roundf(f + out_zero_point));
-          }
-        }
-      } else {
-        MACE_NOT_IMPLEMENTED;
-      }
-    }, 0, data_reshape_[1], 1, 0, data_reshape_[3], 1);
-  } else {
-    thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
-                              index_t start1, index_t end1, index_t step1) {
-      if (type == ReduceType::MEAN) {
-        for (index_t i = start0; i < end0; i += step0) {
-          for (index_t j = start1; j < end1; j += step1) {
-            uint32_t tmp = 0;
-            for (int k = 0; k < data_reshape_[1]; ++k) {
-              for (int t = 0; t < data_reshape_[3]; ++t) {
-                tmp += input[((i * data_reshape_[1] + k) *
-                    data_reshape_[2] + j) * data_reshape_[3] + t];
-              }
-            }
-            index_t dim = data_reshape_[1] * data_reshape_[3];
-            output[i * data_reshape_[2] + j] =
-                static_cast<uint8_t>((tmp + dim / 2) / dim);
-          }
-        }
-      } else if (type == ReduceType::MIN) {
-        for (index_t i = start0; i < end0; i += step0) {
-          for (index_t j = start1; j < end1; j += step1) {
-            uint8_t tmp = input[(i * data_reshape_[1] *
-                data_reshape_[2] + j) * data_reshape_[3]];
-            for (int k = 0; k < data_reshape_[1]; ++k) {
-              for (int t = 0; t < data_reshape_[3]; ++t) {
-                tmp =
-                    std::min(tmp,
-                             input[((i * data_reshape_[1] + k) *
-                                 data_reshape_[2] + j) * data_reshape_[3] + t]);
-              }
-            }
-            output[i * data_reshape_[2] + j] = tmp;
-          }
-        }
-      } else if (type == ReduceType::MAX) {
-        for (index_t i = start0; i < end0; i += step0) {
-          for (index_t j = start1; j < end1; j += step1) {
-            uint8_t tmp = input[(i * data_reshape_[1] *
-                data_reshape_[2] + j) * data_reshape_[3]];
-            for (int k = 0; k < data_reshape_[1]; ++k) {
-              for (int t = 0; t < data_reshape_[3]; ++t) {
-                tmp =
-                    std::max(tmp,
-                             input[((i * data_reshape_[1] + k) *
-                                 data_reshape_[2] + j) * data_reshape_[3] + t]);
-              }
-            }
-            output[i * data_reshape_[2] + j] = tmp;
-          }
-        }
-      } else if (type == ReduceType::SUM) {
-        const auto in_zero_point = input_tensor->zero_point();
-        const auto out_zero_point = output_tensor->zero_point();
-        const auto scale = input_tensor->scale() / output_tensor->scale();
-        for (index_t i = start0; i < end0; i += step0) {
-          for (index_t j = start1; j < end1; j += step1) {
-            int32_t sum = 0;
-            for (int k = 0; k < data_reshape_[1]; ++k) {
-              for (int t = 0; t < data_reshape_[3]; ++t) {
-                sum += input[((i * data_reshape_[1] + k) *
-                    data_reshape_[2] + j) * data_reshape_[3] + t];
-              }
-            }
-            const auto count = data_reshape_[1] * data_reshape_[3];
-            const float f = (sum - in_zero_point * count) * scale;
-            output[i * data_reshape_[2] + j] =
-                Saturate<uint8_t>(std::roundf(f + out_zero_point));
-          }
-        }
-      } else {
-        MACE_NOT_IMPLEMENTED;
-      }
-    }, 0, data_reshape_[0], 1, 0, data_reshape_[2], 1);
+    default:
+      MACE_NOT_IMPLEMENTED;
   }
 }
 #endif  // MACE_ENABLE_QUANTIZE
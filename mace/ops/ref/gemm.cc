@@ -12,16 +12,29 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <vector>
+
 #include "mace/ops/delegator/gemm.h"
+#include "mace/utils/math.h"
 
 namespace mace {
 namespace ops {
 namespace ref {
 
+namespace {
+const index_t kRowBlockSize = 4;
+const index_t kColBlockSize = 8;
+}  // namespace
+
 template<typename T>
 class Gemm : public delegator::Gemm {
  public:
-  explicit Gemm(const delegator::GemmParam &param) : delegator::Gemm(param) {}
+  explicit Gemm(const delegator::GemmParam &param)
+      : delegator::Gemm(param),
+        packed_weight_(nullptr),
+        should_cache_pack_(param.should_cache_pack_),
+        rhs_cached_(false) {}
   ~Gemm() {}
   MaceStatus Compute(const OpContext *context,
                      const Tensor *lhs,
@@ -52,6 +65,28 @@ class Gemm : public delegator::Gemm {
       const bool lhs_batched,
       const bool rhs_batched,
       Tensor *output) override;
+
+  MaceStatus ComputeWithEpilogue(const OpContext *context,
+                                 const Tensor *lhs,
+                                 const Tensor *rhs,
+                                 const index_t rows,
+                                 const index_t cols,
+                                 const index_t depth,
+                                 const MatrixMajor lhs_major,
+                                 const MatrixMajor rhs_major,
+                                 const GemmEpilogue &epilogue,
+                                 Tensor *output) override;
+
+ private:
+  // Pack rhs to panels of kColBlockSize columns, each panel is depth rows of
+  // kColBlockSize contiguous values, padded with zeros.
+  void PackRhs(const MatrixMap<const T> &rhs, float *packed_rhs);
+
+  std::vector<float> packed_rhs_;
+  // The packed rhs kept in the workspace instead of packed_rhs_
+  Tensor *packed_weight_;
+  bool should_cache_pack_;
+  bool rhs_cached_;
 };
 
 template<typename T>
@@ -145,6 +180,125 @@ MaceStatus Gemm<T>::Compute(const OpContext *context,
                           output);
 }
 
+template<typename T>
+void Gemm<T>::PackRhs(const MatrixMap<const T> &rhs, float *packed_rhs) {
+  const index_t depth = rhs.rows();
+  const index_t cols = rhs.cols();
+  const index_t col_block_count = RoundUpDiv(cols, kColBlockSize);
+  for (index_t block_idx = 0; block_idx < col_block_count; ++block_idx) {
+    const index_t start_col = block_idx * kColBlockSize;
+    const index_t col_block_len = std::min(kColBlockSize, cols - start_col);
+    float *packed_block = packed_rhs + block_idx * kColBlockSize * depth;
+    for (index_t d = 0; d < depth; ++d) {
+      float *packed_ptr = packed_block + d * kColBlockSize;
+      for (index_t c = 0; c < col_block_len; ++c) {
+        packed_ptr[c] = rhs(d, start_col + c);
+      }
+      for (index_t c = col_block_len; c < kColBlockSize; ++c) {
+        packed_ptr[c] = 0.f;
+      }
+    }  // d
+  }  // block_idx
+}
+
+template<typename T>
+MaceStatus Gemm<T>::ComputeWithEpilogue(const OpContext *context,
+                                        const Tensor *lhs,
+                                        const Tensor *rhs,
+                                        const index_t rows,
+                                        const index_t cols,
+                                        const index_t depth,
+                                        const MatrixMajor lhs_major,
+                                        const MatrixMajor rhs_major,
+                                        const GemmEpilogue &epilogue,
+                                        Tensor *output) {
+  MACE_CHECK(output->size() == rows * cols,
+             "Need resize output tensor before call gemm.");
+  const T *lhs_data = lhs->data<T>();
+  const T *bias_data =
+      epilogue.bias == nullptr ? nullptr : epilogue.bias->data<T>();
+  T *output_data = output->mutable_data<T>();
+
+  const index_t col_block_count = RoundUpDiv(cols, kColBlockSize);
+  const index_t packed_size = col_block_count * kColBlockSize * depth;
+  const bool cache_rhs = should_cache_pack_ && rhs->is_weight();
+  if (!cache_rhs || !rhs_cached_) {
+    // The packed weight is kept in the workspace, so that it is saved in
+    // snapshots and other ops packing the same weight take it as it is
+    bool filled = false;
+    Workspace *ws = context->workspace();
+    packed_weight_ = nullptr;
+    if (cache_rhs && ws != nullptr && !rhs->name().empty()) {
+      packed_weight_ = ws->GetPackedWeight(
+          MakeString(rhs->name(), "_gemm_ref_rhs_", depth, "x", cols, "_",
+                     static_cast<int>(rhs_major)),
+          context->runtime(), DT_FLOAT, {packed_size}, &filled);
+    }
+    float *packed_rhs = nullptr;
+    if (packed_weight_ != nullptr) {
+      packed_rhs_.clear();
+      packed_rhs = packed_weight_->mutable_data<float>();
+    } else {
+      packed_rhs_.resize(packed_size);
+      packed_rhs = packed_rhs_.data();
+    }
+    if (!filled) {
+      MatrixMap<const T> rhs_matrix(rhs->data<T>(), rhs_major, depth, cols);
+      PackRhs(rhs_matrix, packed_rhs);
+    }
+    rhs_cached_ = cache_rhs;
+  }
+  const float *packed_rhs_data = packed_weight_ != nullptr ?
+      packed_weight_->data<float>() : packed_rhs_.data();
+  MACE_CHECK((packed_weight_ != nullptr ? packed_weight_->size() :
+              static_cast<index_t>(packed_rhs_.size())) == packed_size,
+             "The shape of the cached gemm weight changed");
+  MatrixMap<const T> lhs_matrix(lhs_data, lhs_major, rows, depth);
+
+  // Each task owns whole weight panels, so a panel is loaded from memory
+  // once and reused by every row of lhs while it stays in cache.
+  utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+  thread_pool.Compute1D([=, &lhs_matrix, &epilogue](index_t start,
+                                                     index_t end,
+                                                     index_t step) {
+    for (index_t block_idx = start; block_idx < end; block_idx += step) {
+      const index_t start_col = block_idx * kColBlockSize;
+      const index_t col_block_len = std::min(kColBlockSize, cols - start_col);
+      const float *packed_block =
+          packed_rhs_data + block_idx * kColBlockSize * depth;
+
+      for (index_t start_row = 0; start_row < rows;
+           start_row += kRowBlockSize) {
+        const index_t row_block_len =
+            std::min(kRowBlockSize, rows - start_row);
+        float sum[kRowBlockSize][kColBlockSize] = {{0}};
+        for (index_t d = 0; d < depth; ++d) {
+          const float *rhs_ptr = packed_block + d * kColBlockSize;
+          for (index_t r = 0; r < row_block_len; ++r) {
+            const float lhs_value = lhs_matrix(start_row + r, d);
+            for (index_t c = 0; c < kColBlockSize; ++c) {
+              sum[r][c] += lhs_value * rhs_ptr[c];
+            }  // c
+          }  // r
+        }  // d
+
+        for (index_t r = 0; r < row_block_len; ++r) {
+          T *output_ptr = output_data + (start_row + r) * cols + start_col;
+          for (index_t c = 0; c < col_block_len; ++c) {
+            output_ptr[c] = sum[r][c];
+          }
+          ApplyGemmEpilogue(
+              epilogue,
+              bias_data == nullptr ? nullptr : bias_data + start_col,
+              col_block_len, output_ptr);
+        }  // r
+      }  // start_row
+    }  // block_idx
+  }, 0, col_block_count, 1);
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
 void RegisterGemmDelegator(OpDelegatorRegistry *registry) {
   MACE_REGISTER_DELEGATOR(
       registry, Gemm<float>, delegator::GemmParam,
@@ -48,11 +48,16 @@ extern void RegisterConv2dK3x3Delegator(OpDelegatorRegistry *registry);
 extern void RegisterConv2dK5x5Delegator(OpDelegatorRegistry *registry);
 extern void RegisterConv2dK7x7Delegator(OpDelegatorRegistry *registry);
 extern void RegisterConv2dGeneralDelegator(OpDelegatorRegistry *registry);
+extern void RegisterConv2dDilatedDelegator(OpDelegatorRegistry *registry);
+extern void RegisterConv2dDilatedGemmDelegator(OpDelegatorRegistry *registry);
+extern void RegisterConv2dK3x3DilatedWinogradDelegator(
+    OpDelegatorRegistry *registry);
 
 extern void RegisterDeconv2dK2x2Delegator(OpDelegatorRegistry *registry);
 extern void RegisterDeconv2dK3x3Delegator(OpDelegatorRegistry *registry);
 extern void RegisterDeconv2dK4x4Delegator(OpDelegatorRegistry *registry);
 extern void RegisterDeconv2dGeneralDelegator(OpDelegatorRegistry *registry);
+extern void RegisterDeconv2dGemmDelegator(OpDelegatorRegistry *registry);
 
 extern void RegisterDepthwiseConv2dK3x3Delegator(
     OpDelegatorRegistry *registry);
@@ -84,6 +89,18 @@ extern void RegisterGemvDelegator(OpDelegatorRegistry *registry);
 }  // namespace arm
 #endif  // MACE_ENABLE_NEON
 
+#ifdef MACE_ENABLE_X86
+namespace x86 {
+#ifdef MACE_ENABLE_BFLOAT16
+namespace bf16 {
+extern void RegisterConv2dK1x1Delegator(OpDelegatorRegistry *registry);
+extern void RegisterGemmDelegator(OpDelegatorRegistry *registry);
+extern void RegisterGemvDelegator(OpDelegatorRegistry *registry);
+}  // namespace bf16
+#endif  // MACE_ENABLE_BFLOAT16
+}  // namespace x86
+#endif  // MACE_ENABLE_X86
+
 void RegisterAllOpDelegators(OpDelegatorRegistry *registry) {
 #ifdef MACE_ENABLE_CPU
   ref::RegisterActivationDelegator(registry);
@@ -111,11 +128,15 @@ void RegisterAllOpDelegators(OpDelegatorRegistry *registry) {
   arm::RegisterConv2dK5x5Delegator(registry);
   arm::RegisterConv2dK7x7Delegator(registry);
   arm::RegisterConv2dGeneralDelegator(registry);
+  arm::RegisterConv2dDilatedDelegator(registry);
+  arm::RegisterConv2dDilatedGemmDelegator(registry);
+  arm::RegisterConv2dK3x3DilatedWinogradDelegator(registry);
 
   arm::RegisterDeconv2dK2x2Delegator(registry);
   arm::RegisterDeconv2dK3x3Delegator(registry);
   arm::RegisterDeconv2dK4x4Delegator(registry);
   arm::RegisterDeconv2dGeneralDelegator(registry);
+  arm::RegisterDeconv2dGemmDelegator(registry);
 
   arm::RegisterDepthwiseConv2dK3x3Delegator(registry);
   arm::RegisterDepthwiseDeconv2dK3x3Delegator(registry);
@@ -137,6 +158,12 @@ void RegisterAllOpDelegators(OpDelegatorRegistry *registry) {
 #endif  // MACE_ENABLE_QUANTIZE
 
 #endif  // MACE_ENABLE_NEON
+
+#if defined(MACE_ENABLE_X86) && defined(MACE_ENABLE_BFLOAT16)
+  x86::bf16::RegisterConv2dK1x1Delegator(registry);
+  x86::bf16::RegisterGemmDelegator(registry);
+  x86::bf16::RegisterGemvDelegator(registry);
+#endif  // MACE_ENABLE_X86 && MACE_ENABLE_BFLOAT16
 #else
   MACE_UNUSED(registry);
 #endif  // MACE_ENABLE_CPU
@@ -37,12 +37,14 @@ extern void RegisterDepthwiseConv2d(OpRegistry *op_registry);
 extern void RegisterDepthwiseDeconv2d(OpRegistry *op_registry);
 extern void RegisterDynamicLSTM(OpRegistry *op_registry);
 extern void RegisterEltwise(OpRegistry *op_registry);
+extern void RegisterEmbeddingBag(OpRegistry *op_registry);
 extern void RegisterExpandDims(OpRegistry *op_registry);
 extern void RegisterExtractPooling(OpRegistry *op_registry);
 extern void RegisterFill(OpRegistry *op_registry);
 extern void RegisterFullyConnected(OpRegistry *op_registry);
 extern void RegisterGather(OpRegistry *op_registry);
 extern void RegisterGroupNorm(OpRegistry *op_registry);
+extern void RegisterGRU(OpRegistry *op_registry);
 extern void RegisterIdentity(OpRegistry *op_registry);
 extern void RegisterIfDefined(OpRegistry *op_registry);
 extern void RegisterInferConv2dShape(OpRegistry *op_registry);
@@ -50,6 +52,7 @@ extern void RegisterInstanceNorm(OpRegistry *op_registry);
 extern void RegisterKaldiBatchNorm(OpRegistry *op_registry);
 extern void RegisterLocalResponseNorm(OpRegistry *op_registry);
 extern void RegisterLpNorm(OpRegistry *op_registry);
+extern void RegisterLSTM(OpRegistry *op_registry);
 extern void RegisterLSTMNonlinear(OpRegistry *op_registry);
 extern void RegisterMatMul(OpRegistry *op_registry);
 extern void RegisterMVNorm(OpRegistry *op_registry);
@@ -85,6 +88,7 @@ extern void RegisterSubsample(OpRegistry *op_registry);
 extern void RegisterSumGroup(OpRegistry *op_registry);
 extern void RegisterTargetRMSNorm(OpRegistry *op_registry);
 extern void RegisterTile(OpRegistry *op_registry);
+extern void RegisterTopK(OpRegistry *op_registry);
 extern void RegisterTranspose(OpRegistry *op_registry);
 extern void RegisterUnstack(OpRegistry *op_registry);
 extern void RegisterUnsqueeze(OpRegistry *op_registry);
@@ -123,12 +127,14 @@ void RegisterAllOps(OpRegistry *registry) {
   ops::RegisterDepthwiseDeconv2d(registry);
   ops::RegisterDynamicLSTM(registry);
   ops::RegisterEltwise(registry);
+  ops::RegisterEmbeddingBag(registry);
   ops::RegisterExpandDims(registry);
   ops::RegisterExtractPooling(registry);
   ops::RegisterFill(registry);
   ops::RegisterFullyConnected(registry);
   ops::RegisterGather(registry);
   ops::RegisterGroupNorm(registry);
+  ops::RegisterGRU(registry);
   ops::RegisterIdentity(registry);
   ops::RegisterIfDefined(registry);
   ops::RegisterInferConv2dShape(registry);
@@ -136,6 +142,7 @@ void RegisterAllOps(OpRegistry *registry) {
   ops::RegisterKaldiBatchNorm(registry);
   ops::RegisterLocalResponseNorm(registry);
   ops::RegisterLpNorm(registry);
+  ops::RegisterLSTM(registry);
   ops::RegisterLSTMNonlinear(registry);
   ops::RegisterMatMul(registry);
   ops::RegisterMVNorm(registry);
@@ -171,6 +178,7 @@ void RegisterAllOps(OpRegistry *registry) {
   ops::RegisterSumGroup(registry);
   ops::RegisterTargetRMSNorm(registry);
   ops::RegisterTile(registry);
+  ops::RegisterTopK(registry);
   ops::RegisterTranspose(registry);
   ops::RegisterUnstack(registry);
   ops::RegisterUnsqueeze(registry);
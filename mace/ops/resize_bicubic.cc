@@ -12,6 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#if defined(MACE_ENABLE_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
 #include <algorithm>
 #include <cmath>
 #include <memory>
@@ -20,6 +26,7 @@
 #include "mace/core/ops/operator.h"
 #include "mace/core/registry/ops_registry.h"
 #include "mace/ops/common/coordinate_transformation_mode.h"
+#include "mace/ops/common/resize_plan.h"
 #include "mace/ops/common/utils.h"
 #ifdef MACE_ENABLE_OPENCL
 #include "mace/ops/opencl/image/resize_bicubic.h"
@@ -114,12 +121,79 @@ inline void GetWeightsAndIndices(
   }
 }
 
-inline float Interpolate1D(const std::vector<float> &weights,
-                           const std::vector<float> &values) {
-  return values[0] * weights[0] + values[1] * weights[1] +
-      values[2] * weights[2] + values[3] * weights[3];
+namespace {
+inline void BuildAxisPlan(
+    const index_t out_size,
+    const index_t in_size,
+    const float scale,
+    const CoordinateTransformationMode coordinate_transformation_mode,
+    ResizeAxisPlan *plan) {
+  plan->Init(out_size, 4);
+  std::vector<float> weights;
+  std::vector<index_t> indices;
+  for (index_t i = 0; i < out_size; ++i) {
+    GetWeightsAndIndices(scale, coordinate_transformation_mode, i, out_size,
+                         in_size, &weights, &indices);
+    std::copy_n(indices.begin(), 4, plan->indices.begin() + i * 4);
+    std::copy_n(weights.begin(), 4, plan->weights.begin() + i * 4);
+  }
+}
+
+inline void HorizontalInterpolate(const float *input,
+                                  const ResizeAxisPlan &xs,
+                                  float *output) {
+  const index_t *indices = xs.indices.data();
+  const float *weights = xs.weights.data();
+  for (index_t x = 0; x < xs.size; ++x) {
+    const index_t *index = indices + x * 4;
+    const float *weight = weights + x * 4;
+    output[x] = input[index[0]] * weight[0] + input[index[1]] * weight[1] +
+        input[index[2]] * weight[2] + input[index[3]] * weight[3];
+  }
+}
+
+inline void VerticalInterpolate(const float *const *rows,
+                                const float *weights,
+                                const index_t size,
+                                float *output) {
+  const float *row0 = rows[0];
+  const float *row1 = rows[1];
+  const float *row2 = rows[2];
+  const float *row3 = rows[3];
+  index_t x = 0;
+#if defined(MACE_ENABLE_NEON)
+  const float32x4_t vw0 = vdupq_n_f32(weights[0]);
+  const float32x4_t vw1 = vdupq_n_f32(weights[1]);
+  const float32x4_t vw2 = vdupq_n_f32(weights[2]);
+  const float32x4_t vw3 = vdupq_n_f32(weights[3]);
+  for (; x + 4 <= size; x += 4) {
+    float32x4_t vout = vmulq_f32(vld1q_f32(row0 + x), vw0);
+    vout = vaddq_f32(vout, vmulq_f32(vld1q_f32(row1 + x), vw1));
+    vout = vaddq_f32(vout, vmulq_f32(vld1q_f32(row2 + x), vw2));
+    vout = vaddq_f32(vout, vmulq_f32(vld1q_f32(row3 + x), vw3));
+    vst1q_f32(output + x, vout);
+  }
+#elif defined(__SSE__)
+  const __m128 vw0 = _mm_set1_ps(weights[0]);
+  const __m128 vw1 = _mm_set1_ps(weights[1]);
+  const __m128 vw2 = _mm_set1_ps(weights[2]);
+  const __m128 vw3 = _mm_set1_ps(weights[3]);
+  for (; x + 4 <= size; x += 4) {
+    __m128 vout = _mm_mul_ps(_mm_loadu_ps(row0 + x), vw0);
+    vout = _mm_add_ps(vout, _mm_mul_ps(_mm_loadu_ps(row1 + x), vw1));
+    vout = _mm_add_ps(vout, _mm_mul_ps(_mm_loadu_ps(row2 + x), vw2));
+    vout = _mm_add_ps(vout, _mm_mul_ps(_mm_loadu_ps(row3 + x), vw3));
+    _mm_storeu_ps(output + x, vout);
+  }
+#endif
+  for (; x < size; ++x) {
+    output[x] = row0[x] * weights[0] + row1[x] * weights[1] +
+        row2[x] * weights[2] + row3[x] * weights[3];
+  }
 }
 
+// Resizes each 4x4 patch separably: the four source rows of an output row
+// are resized horizontally, then combined vertically.
 inline void ResizeImage(
     const OpContext *context,
     const float *images,
@@ -129,49 +203,44 @@ inline void ResizeImage(
     const index_t out_height,
     const index_t out_width,
     const index_t channels,
-    const float height_scale,
-    const float width_scale,
-    const CoordinateTransformationMode coordinate_transformation_mode,
+    const ResizePlan &plan,
     float *output) {
+  const ResizeAxisPlan *xs = &plan.xs;
+  const ResizeAxisPlan *ys = &plan.ys;
+  // Output rows of a plane computed by one task, which share the
+  // horizontally resized source rows.
+  const index_t tile_height = 16;
+
   utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
   thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
                             index_t start1, index_t end1, index_t step1) {
-    for (index_t b = start0; b < end0; b += step0) {
-      for (index_t y = start1; y < end1; y += step1) {
-        std::vector<float> y_weights;
-        std::vector<index_t> y_indices;
-        GetWeightsAndIndices(height_scale, coordinate_transformation_mode, y,
-                             out_height, in_height, &y_weights, &y_indices);
-        for (index_t x = 0; x < out_width; ++x) {
-          std::vector<float> x_weights;
-          std::vector<index_t> x_indices;
-          GetWeightsAndIndices(width_scale, coordinate_transformation_mode, x,
-                               out_width, in_width, &x_weights, &x_indices);
-
-          for (index_t c = 0; c < channels; ++c) {
-            // Use a 4x4 patch to compute the interpolated output value at
-            // (b, y, x, c).
-            const float *channel_input_ptr =
-                images + (b * channels + c) * in_height * in_width;
-            float *channel_output_ptr =
-                output + (b * channels + c) * out_height * out_width;
-            std::vector<float> coeff(4, 0.0);
-            for (index_t i = 0; i < 4; ++i) {
-              const std::vector<float> values = {
-                  channel_input_ptr[y_indices[i] * in_width + x_indices[0]],
-                  channel_input_ptr[y_indices[i] * in_width + x_indices[1]],
-                  channel_input_ptr[y_indices[i] * in_width + x_indices[2]],
-                  channel_input_ptr[y_indices[i] * in_width + x_indices[3]]};
-              coeff[i] = Interpolate1D(x_weights, values);
+    ResizeRowCache<float> rows(4, out_width);
+    for (index_t i = start0; i < end0; i += step0) {
+      const float *channel_input_ptr = images + i * in_height * in_width;
+      float *channel_output_ptr = output + i * out_height * out_width;
+      rows.Clear();
+      for (index_t h = start1; h < end1; h += step1) {
+        const index_t h_end = std::min(h + tile_height, out_height);
+        for (index_t y = h; y < h_end; ++y) {
+          const index_t *y_indices = ys->indices.data() + y * 4;
+          const float *y_rows[4];
+          for (int k = 0; k < 4; ++k) {
+            bool cached = false;
+            float *row = rows.Row(y_indices[k], y_indices, 4, &cached);
+            if (!cached) {
+              HorizontalInterpolate(
+                  channel_input_ptr + y_indices[k] * in_width, *xs, row);
             }
-            channel_output_ptr[y * out_width + x] =
-                Interpolate1D(y_weights, coeff);
+            y_rows[k] = row;
           }
+          VerticalInterpolate(y_rows, ys->weights.data() + y * 4, out_width,
+                              channel_output_ptr + y * out_width);
         }
       }
     }
-  }, 0, batch_size, 1, 0, out_height, 1);
+  }, 0, batch_size * channels, 1, 0, out_height, tile_height);
 }
+}  // namespace
 
 template<RuntimeType D, class T>
 class ResizeBicubicOp;
@@ -223,14 +292,21 @@ class ResizeBicubicOp<RuntimeType::RT_CPU, float> : public Operation {
       return MaceStatus::MACE_SUCCESS;
     }
 
-    float height_scale =
-        common::utils::CalculateResizeScale(in_height,
-                                            out_height,
-                                            align_corners_);
-    float width_scale =
-        common::utils::CalculateResizeScale(in_width,
-                                            out_width,
-                                            align_corners_);
+    if (plan_.Update(in_height, in_width, out_height, out_width,
+                     coordinate_transformation_mode_)) {
+      float height_scale =
+          common::utils::CalculateResizeScale(in_height,
+                                              out_height,
+                                              align_corners_);
+      float width_scale =
+          common::utils::CalculateResizeScale(in_width,
+                                              out_width,
+                                              align_corners_);
+      BuildAxisPlan(out_height, in_height, height_scale,
+                    coordinate_transformation_mode_, &plan_.ys);
+      BuildAxisPlan(out_width, in_width, width_scale,
+                    coordinate_transformation_mode_, &plan_.xs);
+    }
 
     ResizeImage(context,
                 input_data,
@@ -240,9 +316,7 @@ class ResizeBicubicOp<RuntimeType::RT_CPU, float> : public Operation {
                 out_height,
                 out_width,
                 channels,
-                height_scale,
-                width_scale,
-                coordinate_transformation_mode_,
+                plan_,
                 output_data);
 
     return MaceStatus::MACE_SUCCESS;
@@ -252,6 +326,7 @@ class ResizeBicubicOp<RuntimeType::RT_CPU, float> : public Operation {
   bool align_corners_;
   CoordinateTransformationMode coordinate_transformation_mode_;
   std::vector<index_t> size_;
+  ResizePlan plan_;
 };
 
 #ifdef MACE_ENABLE_OPENCL
@@ -12,6 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#if defined(MACE_ENABLE_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
 #include <algorithm>
 #include <memory>
 #include <vector>
@@ -21,6 +27,7 @@
 #include "mace/utils/memory.h"
 #include "mace/core/quantize.h"
 #include "mace/ops/common/coordinate_transformation_mode.h"
+#include "mace/ops/common/resize_plan.h"
 #include "mace/ops/common/utils.h"
 #ifdef MACE_ENABLE_OPENCL
 #include "mace/ops/opencl/image/resize_bilinear.h"
@@ -61,28 +68,193 @@ inline void ComputeInterpolationWeights(
   }
 }
 
+namespace {
+inline void BuildAxisPlan(
+    const index_t out_size,
+    const index_t in_size,
+    const float scale,
+    const CoordinateTransformationMode coordinate_transformation_mode,
+    ResizeAxisPlan *plan) {
+  std::vector<CachedInterpolation> interpolation(out_size + 1);
+  ComputeInterpolationWeights(out_size, in_size, scale,
+                              coordinate_transformation_mode,
+                              interpolation.data());
+  plan->Init(out_size, 2);
+  for (index_t i = 0; i < out_size; ++i) {
+    plan->indices[i * 2] = interpolation[i].lower;
+    plan->indices[i * 2 + 1] = interpolation[i].upper;
+    plan->weights[i * 2] = 1.f - interpolation[i].lerp;
+    plan->weights[i * 2 + 1] = interpolation[i].lerp;
+  }
+}
+
+// Output rows of a plane computed by one task, which share the horizontally
+// resized source rows.
+const index_t kTileHeight = 16;
+
 template<typename T>
-inline T ComputeLerp(const T top_left,
-                     const T top_right,
-                     const T bottom_left,
-                     const T bottom_right,
-                     const float x_lerp,
-                     const float y_lerp) {
-  const float top = top_left + (top_right - top_left) * x_lerp;
-  const float bottom = bottom_left + (bottom_right - bottom_left) * x_lerp;
-  return top + (bottom - top) * y_lerp;
+void HorizontalLerp(const T *input, const ResizeAxisPlan &xs, float *output) {
+  const index_t *indices = xs.indices.data();
+  const float *weights = xs.weights.data();
+  for (index_t x = 0; x < xs.size; ++x) {
+    const float left = input[indices[x * 2]];
+    const float right = input[indices[x * 2 + 1]];
+    output[x] = left + (right - left) * weights[x * 2 + 1];
+  }
+}
+
+template<typename T>
+void VerticalLerp(const float *top, const float *bottom, const float lerp,
+                  const index_t size, T *output) {
+  for (index_t x = 0; x < size; ++x) {
+    output[x] = top[x] + (bottom[x] - top[x]) * lerp;
+  }
 }
 
 template<>
-inline uint8_t ComputeLerp<uint8_t>(const uint8_t top_left,
-                                    const uint8_t top_right,
-                                    const uint8_t bottom_left,
-                                    const uint8_t bottom_right,
-                                    const float x_lerp,
-                                    const float y_lerp) {
-  const float top = top_left + (top_right - top_left) * x_lerp;
-  const float bottom = bottom_left + (bottom_right - bottom_left) * x_lerp;
-  return Saturate<uint8_t>(roundf(top + (bottom - top) * y_lerp));
+void VerticalLerp<float>(const float *top, const float *bottom,
+                         const float lerp, const index_t size,
+                         float *output) {
+  index_t x = 0;
+#if defined(MACE_ENABLE_NEON)
+  const float32x4_t vlerp = vdupq_n_f32(lerp);
+  for (; x + 4 <= size; x += 4) {
+    const float32x4_t vtop = vld1q_f32(top + x);
+    const float32x4_t vbottom = vld1q_f32(bottom + x);
+    vst1q_f32(output + x,
+              vaddq_f32(vtop, vmulq_f32(vsubq_f32(vbottom, vtop), vlerp)));
+  }
+#elif defined(__SSE__)
+  const __m128 vlerp = _mm_set1_ps(lerp);
+  for (; x + 4 <= size; x += 4) {
+    const __m128 vtop = _mm_loadu_ps(top + x);
+    const __m128 vbottom = _mm_loadu_ps(bottom + x);
+    _mm_storeu_ps(output + x,
+                  _mm_add_ps(vtop, _mm_mul_ps(_mm_sub_ps(vbottom, vtop),
+                                              vlerp)));
+  }
+#endif
+  for (; x < size; ++x) {
+    output[x] = top[x] + (bottom[x] - top[x]) * lerp;
+  }
+}
+
+// Fixed point lerp of the pixels (channels values each) of an NHWC row, the
+// results keep kResizeWeightBits fractional bits.
+inline void HorizontalLerp(const uint8_t *input, const ResizeAxisPlan &xs,
+                           const index_t channels, uint32_t *output) {
+  const index_t *indices = xs.indices.data();
+  const int16_t *weights = xs.fixed_weights.data();
+  for (index_t x = 0; x < xs.size; ++x) {
+    const uint8_t *left = input + indices[x * 2] * channels;
+    const uint8_t *right = input + indices[x * 2 + 1] * channels;
+    const uint16_t left_weight = static_cast<uint16_t>(weights[x * 2]);
+    const uint16_t right_weight = static_cast<uint16_t>(weights[x * 2 + 1]);
+    uint32_t *output_ptr = output + x * channels;
+    index_t c = 0;
+#if defined(MACE_ENABLE_NEON)
+    for (; c + 8 <= channels; c += 8) {
+      const uint16x8_t vleft = vmovl_u8(vld1_u8(left + c));
+      const uint16x8_t vright = vmovl_u8(vld1_u8(right + c));
+      uint32x4_t vlow = vmull_n_u16(vget_low_u16(vleft), left_weight);
+      vlow = vmlal_n_u16(vlow, vget_low_u16(vright), right_weight);
+      uint32x4_t vhigh = vmull_n_u16(vget_high_u16(vleft), left_weight);
+      vhigh = vmlal_n_u16(vhigh, vget_high_u16(vright), right_weight);
+      vst1q_u32(output_ptr + c, vlow);
+      vst1q_u32(output_ptr + c + 4, vhigh);
+    }
+#endif
+    for (; c < channels; ++c) {
+      output_ptr[c] = left[c] * left_weight + right[c] * right_weight;
+    }
+  }
+}
+
+inline void VerticalLerp(const uint32_t *top, const uint32_t *bottom,
+                         const uint32_t top_weight,
+                         const uint32_t bottom_weight,
+                         const index_t size, uint8_t *output) {
+  const int shift = kResizeWeightBits * 2;
+  index_t x = 0;
+#if defined(MACE_ENABLE_NEON)
+  for (; x + 8 <= size; x += 8) {
+    uint32x4_t vlow = vmulq_n_u32(vld1q_u32(top + x), top_weight);
+    vlow = vmlaq_n_u32(vlow, vld1q_u32(bottom + x), bottom_weight);
+    uint32x4_t vhigh = vmulq_n_u32(vld1q_u32(top + x + 4), top_weight);
+    vhigh = vmlaq_n_u32(vhigh, vld1q_u32(bottom + x + 4), bottom_weight);
+    const uint16x8_t vout =
+        vcombine_u16(vmovn_u32(vrshrq_n_u32(vlow, shift)),
+                     vmovn_u32(vrshrq_n_u32(vhigh, shift)));
+    vst1_u8(output + x, vqmovn_u16(vout));
+  }
+#endif
+  const uint32_t round = 1u << (shift - 1);
+  for (; x < size; ++x) {
+    output[x] = static_cast<uint8_t>(
+        (top[x] * top_weight + bottom[x] * bottom_weight + round) >> shift);
+  }
+}
+
+// Both passes at once, for source rows read by a single output row as when
+// downsampling, which saves storing and reloading the resized rows.
+template<typename T>
+void Lerp2D(const T *top, const T *bottom, const ResizeAxisPlan &xs,
+            const float y_lerp, T *output) {
+  const index_t *indices = xs.indices.data();
+  const float *weights = xs.weights.data();
+  for (index_t x = 0; x < xs.size; ++x) {
+    const index_t left = indices[x * 2];
+    const index_t right = indices[x * 2 + 1];
+    const float x_lerp = weights[x * 2 + 1];
+    const float top_left = top[left];
+    const float bottom_left = bottom[left];
+    const float top_value = top_left + (top[right] - top_left) * x_lerp;
+    const float bottom_value =
+        bottom_left + (bottom[right] - bottom_left) * x_lerp;
+    output[x] = top_value + (bottom_value - top_value) * y_lerp;
+  }
+}
+
+inline void Lerp2D(const uint8_t *top, const uint8_t *bottom,
+                   const ResizeAxisPlan &xs, const index_t channels,
+                   const uint32_t top_weight, const uint32_t bottom_weight,
+                   uint8_t *output) {
+  const int shift = kResizeWeightBits * 2;
+  const uint32_t round = 1u << (shift - 1);
+  const index_t *indices = xs.indices.data();
+  const int16_t *weights = xs.fixed_weights.data();
+  for (index_t x = 0; x < xs.size; ++x) {
+    const index_t left = indices[x * 2] * channels;
+    const index_t right = indices[x * 2 + 1] * channels;
+    const uint32_t left_weight = static_cast<uint32_t>(weights[x * 2]);
+    const uint32_t right_weight = static_cast<uint32_t>(weights[x * 2 + 1]);
+    uint8_t *output_ptr = output + x * channels;
+    for (index_t c = 0; c < channels; ++c) {
+      const uint32_t top_value =
+          top[left + c] * left_weight + top[right + c] * right_weight;
+      const uint32_t bottom_value =
+          bottom[left + c] * left_weight + bottom[right + c] * right_weight;
+      output_ptr[c] = static_cast<uint8_t>(
+          (top_value * top_weight + bottom_value * bottom_weight + round)
+              >> shift);
+    }
+  }
+}
+
+// Whether the source rows of output row y are resized once and kept for the
+// next output row.
+template<typename T>
+bool UseRowCache(const ResizeRowCache<T> &rows, const index_t *y_indices,
+                 const bool has_next) {
+  if (rows.Contains(y_indices[0]) || rows.Contains(y_indices[1])) {
+    return true;
+  }
+  if (!has_next) {
+    return false;
+  }
+  const index_t *next = y_indices + 2;
+  return next[0] == y_indices[0] || next[0] == y_indices[1] ||
+      next[1] == y_indices[0] || next[1] == y_indices[1];
 }
 
 template<typename T>
@@ -94,91 +266,106 @@ inline void ResizeImageNCHW(const OpContext *context,
                             const index_t out_height,
                             const index_t out_width,
                             const index_t channels,
-                            const std::vector<CachedInterpolation> &xs_vec,
-                            const std::vector<CachedInterpolation> &ys,
+                            const ResizePlan &plan,
                             T *output) {
-  const CachedInterpolation *xs = xs_vec.data();
+  const ResizeAxisPlan *xs = &plan.xs;
+  const ResizeAxisPlan *ys = &plan.ys;
 
   utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
 
   thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
                             index_t start1, index_t end1, index_t step1) {
-    for (index_t b = start0; b < end0; b += step0) {
-      for (index_t c = start1; c < end1; c += step1) {
-        const T
-            *channel_input_ptr =
-            images + (b * channels + c) * in_height * in_width;
-        T *channel_output_ptr =
-            output + (b * channels + c) * out_height * out_width;
-        for (index_t y = 0; y < out_height; ++y) {
-          const T *y_lower_input_ptr =
-              channel_input_ptr + ys[y].lower * in_width;
-          const T *y_upper_input_ptr =
-              channel_input_ptr + ys[y].upper * in_width;
-          const float ys_lerp = ys[y].lerp;
-
-          for (index_t x = 0; x < out_width; ++x) {
-            const float xs_lerp = xs[x].lerp;
-            const T top_left = y_lower_input_ptr[xs[x].lower];
-            const T top_right = y_lower_input_ptr[xs[x].upper];
-            const T bottom_left = y_upper_input_ptr[xs[x].lower];
-            const T bottom_right = y_upper_input_ptr[xs[x].upper];
-            channel_output_ptr[y * out_width + x] =
-                ComputeLerp(top_left, top_right, bottom_left,
-                            bottom_right, xs_lerp, ys_lerp);
+    ResizeRowCache<float> rows(2, out_width);
+    for (index_t i = start0; i < end0; i += step0) {
+      const T *channel_input_ptr = images + i * in_height * in_width;
+      T *channel_output_ptr = output + i * out_height * out_width;
+      rows.Clear();
+      for (index_t h = start1; h < end1; h += step1) {
+        const index_t h_end = std::min(h + kTileHeight, out_height);
+        for (index_t y = h; y < h_end; ++y) {
+          const index_t *y_indices = ys->indices.data() + y * 2;
+          if (!UseRowCache(rows, y_indices, y + 1 < h_end)) {
+            Lerp2D(channel_input_ptr + y_indices[0] * in_width,
+                   channel_input_ptr + y_indices[1] * in_width, *xs,
+                   ys->weights[y * 2 + 1],
+                   channel_output_ptr + y * out_width);
+            continue;
+          }
+          const float *y_rows[2];
+          for (int k = 0; k < 2; ++k) {
+            bool cached = false;
+            float *row = rows.Row(y_indices[k], y_indices, 2, &cached);
+            if (!cached) {
+              HorizontalLerp(channel_input_ptr + y_indices[k] * in_width,
+                             *xs, row);
+            }
+            y_rows[k] = row;
           }
+          VerticalLerp(y_rows[0], y_rows[1], ys->weights[y * 2 + 1],
+                       out_width, channel_output_ptr + y * out_width);
         }
       }
     }
-  }, 0, batch_size, 1, 0, channels, 1);
+  }, 0, batch_size * channels, 1, 0, out_height, kTileHeight);
 }
 
-template<typename T>
 inline void ResizeImageNHWC(const OpContext *context,
-                            const T *images,
+                            const uint8_t *images,
                             const index_t batch_size,
                             const index_t in_height,
                             const index_t in_width,
                             const index_t out_height,
                             const index_t out_width,
                             const index_t channels,
-                            const std::vector<CachedInterpolation> &xs_vec,
-                            const std::vector<CachedInterpolation> &ys,
-                            T *output) {
-  const CachedInterpolation *xs = xs_vec.data();
+                            const ResizePlan &plan,
+                            uint8_t *output) {
+  const ResizeAxisPlan *xs = &plan.xs;
+  const ResizeAxisPlan *ys = &plan.ys;
+  const index_t in_row_size = in_width * channels;
+  const index_t out_row_size = out_width * channels;
 
   utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
 
-  for (index_t b = 0; b < batch_size; ++b) {
-    const T *input_base = images + b * channels * in_height * in_width;
-    T *output_base = output + b * channels * out_height * out_width;
-
-    thread_pool.Compute1D([=](index_t start, index_t end, index_t step) {
-      for (index_t y = start; y < end; y += step) {
-        const T
-            *y_lower_input_ptr = input_base + ys[y].lower * in_width * channels;
-        const T
-            *y_upper_input_ptr = input_base + ys[y].upper * in_width * channels;
-        const float ys_lerp = ys[y].lerp;
-
-        for (index_t x = 0; x < out_width; ++x) {
-          const float xs_lerp = xs[x].lerp;
-          const T *top_left = y_lower_input_ptr + xs[x].lower * channels;
-          const T *top_right = y_lower_input_ptr + xs[x].upper * channels;
-          const T *bottom_left = y_upper_input_ptr + xs[x].lower * channels;
-          const T *bottom_right = y_upper_input_ptr + xs[x].upper * channels;
-
-          T *output_ptr = output_base + (y * out_width + x) * channels;
-          for (index_t c = 0; c < channels; ++c) {
-            output_ptr[c] =
-                ComputeLerp(top_left[c], top_right[c], bottom_left[c],
-                            bottom_right[c], xs_lerp, ys_lerp);
+  thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
+                            index_t start1, index_t end1, index_t step1) {
+    ResizeRowCache<uint32_t> rows(2, out_row_size);
+    for (index_t b = start0; b < end0; b += step0) {
+      const uint8_t *input_base = images + b * in_height * in_row_size;
+      uint8_t *output_base = output + b * out_height * out_row_size;
+      rows.Clear();
+      for (index_t h = start1; h < end1; h += step1) {
+        const index_t h_end = std::min(h + kTileHeight, out_height);
+        for (index_t y = h; y < h_end; ++y) {
+          const index_t *y_indices = ys->indices.data() + y * 2;
+          const int16_t *y_weights = ys->fixed_weights.data() + y * 2;
+          if (!UseRowCache(rows, y_indices, y + 1 < h_end)) {
+            Lerp2D(input_base + y_indices[0] * in_row_size,
+                   input_base + y_indices[1] * in_row_size, *xs, channels,
+                   static_cast<uint32_t>(y_weights[0]),
+                   static_cast<uint32_t>(y_weights[1]),
+                   output_base + y * out_row_size);
+            continue;
+          }
+          const uint32_t *y_rows[2];
+          for (int k = 0; k < 2; ++k) {
+            bool cached = false;
+            uint32_t *row = rows.Row(y_indices[k], y_indices, 2, &cached);
+            if (!cached) {
+              HorizontalLerp(input_base + y_indices[k] * in_row_size,
+                             *xs, channels, row);
+            }
+            y_rows[k] = row;
           }
+          VerticalLerp(y_rows[0], y_rows[1],
+                       static_cast<uint32_t>(y_weights[0]),
+                       static_cast<uint32_t>(y_weights[1]),
+                       out_row_size, output_base + y * out_row_size);
         }
       }
-    }, 0, out_height, 1);
-  }
+    }
+  }, 0, batch_size, 1, 0, out_height, kTileHeight);
 }
+}  // namespace
 
 template<RuntimeType D, typename T>
 class ResizeBilinearOp;
@@ -235,22 +422,20 @@ class ResizeBilinearOp<RuntimeType::RT_CPU, T> : public Operation {
       return MaceStatus::MACE_SUCCESS;
     }
 
-    // ONNX's scale is the opposite of ours
-    float height_scale = common::utils::CalculateResizeScale(in_height,
-                                                             out_height,
-                                                             align_corners_);
-    float width_scale = common::utils::CalculateResizeScale(in_width,
-                                                            out_width,
-                                                            align_corners_);
-
-    std::vector<CachedInterpolation> ys(out_height + 1);
-    std::vector<CachedInterpolation> xs(out_width + 1);
-
-    // Compute the cached interpolation weights on the x and y dimensions.
-    ComputeInterpolationWeights(out_height, in_height, height_scale,
-                                coordinate_transformation_mode_, ys.data());
-    ComputeInterpolationWeights(out_width, in_width, width_scale,
-                                coordinate_transformation_mode_, xs.data());
+    if (plan_.Update(in_height, in_width, out_height, out_width,
+                     coordinate_transformation_mode_)) {
+      // ONNX's scale is the opposite of ours
+      float height_scale = common::utils::CalculateResizeScale(
+          in_height, out_height, align_corners_);
+      float width_scale = common::utils::CalculateResizeScale(
+          in_width, out_width, align_corners_);
+
+      // Compute the cached interpolation weights on the x and y dimensions.
+      BuildAxisPlan(out_height, in_height, height_scale,
+                    coordinate_transformation_mode_, &plan_.ys);
+      BuildAxisPlan(out_width, in_width, width_scale,
+                    coordinate_transformation_mode_, &plan_.xs);
+    }
 
     ResizeImageNCHW(context,
                     input_data,
@@ -260,8 +445,7 @@ class ResizeBilinearOp<RuntimeType::RT_CPU, T> : public Operation {
                     out_height,
                     out_width,
                     channels,
-                    xs,
-                    ys,
+                    plan_,
                     output_data);
 
     return MaceStatus::MACE_SUCCESS;
@@ -273,6 +457,7 @@ class ResizeBilinearOp<RuntimeType::RT_CPU, T> : public Operation {
   float height_scale_;
   float width_scale_;
   CoordinateTransformationMode coordinate_transformation_mode_;
+  ResizePlan plan_;
 };
 
 #ifdef MACE_ENABLE_QUANTIZE
@@ -326,24 +511,25 @@ class ResizeBilinearOp<RuntimeType::RT_CPU, uint8_t> : public Operation {
       return MaceStatus::MACE_SUCCESS;
     }
 
-    // ONNX's scale is the opposite of ours
-    float height_scale = height_scale_ > 0 ? 1 / height_scale_ :
-                         common::utils::CalculateResizeScale(in_height,
-                                                             out_height,
-                                                             align_corners_);
-    float width_scale = width_scale_ > 0 ? 1 / width_scale_ :
-                        common::utils::CalculateResizeScale(in_width,
-                                                            out_width,
-                                                            align_corners_);
-
-    std::vector<CachedInterpolation> ys(out_height + 1);
-    std::vector<CachedInterpolation> xs(out_width + 1);
-
-    // Compute the cached interpolation weights on the x and y dimensions.
-    ComputeInterpolationWeights(out_height, in_height, height_scale,
-                                coordinate_transformation_mode_, ys.data());
-    ComputeInterpolationWeights(out_width, in_width, width_scale,
-                                coordinate_transformation_mode_, xs.data());
+    if (plan_.Update(in_height, in_width, out_height, out_width,
+                     coordinate_transformation_mode_)) {
+      // ONNX's scale is the opposite of ours
+      float height_scale = height_scale_ > 0 ? 1 / height_scale_ :
+          common::utils::CalculateResizeScale(in_height, out_height,
+                                              align_corners_);
+      float width_scale = width_scale_ > 0 ? 1 / width_scale_ :
+          common::utils::CalculateResizeScale(in_width, out_width,
+                                              align_corners_);
+
+      // Compute the cached interpolation weights on the x and y dimensions,
+      // which are applied in fixed point.
+      BuildAxisPlan(out_height, in_height, height_scale,
+                    coordinate_transformation_mode_, &plan_.ys);
+      BuildAxisPlan(out_width, in_width, width_scale,
+                    coordinate_transformation_mode_, &plan_.xs);
+      plan_.ys.QuantizeWeights();
+      plan_.xs.QuantizeWeights();
+    }
 
     ResizeImageNHWC(context,
                     input_data,
@@ -353,8 +539,7 @@ class ResizeBilinearOp<RuntimeType::RT_CPU, uint8_t> : public Operation {
                     out_height,
                     out_width,
                     channels,
-                    xs,
-                    ys,
+                    plan_,
                     output_data);
 
     return MaceStatus::MACE_SUCCESS;
@@ -366,6 +551,7 @@ class ResizeBilinearOp<RuntimeType::RT_CPU, uint8_t> : public Operation {
   float height_scale_;
   float width_scale_;
   CoordinateTransformationMode coordinate_transformation_mode_;
+  ResizePlan plan_;
 };
 #endif  // MACE_ENABLE_QUANTIZE
 
@@ -21,6 +21,7 @@
 #include "mace/core/ops/operator.h"
 #include "mace/core/registry/ops_registry.h"
 #include "mace/ops/common/coordinate_transformation_mode.h"
+#include "mace/ops/common/resize_plan.h"
 #include "mace/ops/common/utils.h"
 #ifdef MACE_ENABLE_OPENCL
 #include "mace/ops/opencl/image/resize_nearest_neighbor.h"
@@ -57,7 +58,25 @@ namespace {
     };
   }
 
-}  // namespace
+inline void BuildAxisPlan(
+    const index_t out_size,
+    const index_t in_size,
+    const float scale,
+    const bool align_corners,
+    const CoordinateTransformationMode coordinate_transformation_mode,
+    const NearestFunc &nearest_func,
+    ResizeAxisPlan *plan) {
+  plan->Init(out_size, 1);
+  for (index_t i = 0; i < out_size; ++i) {
+    const float in_f = coordinate_transformation_mode == HALF_PIXEL ?
+                       (static_cast<float>(i) + 0.5f) * scale : i * scale;
+    plan->indices[i] = std::min(
+        align_corners ? static_cast<index_t>(roundf(in_f))
+                      : static_cast<index_t>(nearest_func(in_f)),
+        in_size - 1);
+    plan->weights[i] = 1.f;
+  }
+}
 
 template <typename T>
 inline void ResizeImageNCHW(
@@ -69,47 +88,39 @@ inline void ResizeImageNCHW(
     const index_t out_height,
     const index_t out_width,
     const index_t channels,
-    const float height_scale,
-    const float width_scale,
-    const bool align_corners,
-    const CoordinateTransformationMode coordinate_transformation_mode,
-    const NearestFunc nearest_func,
+    const ResizePlan &plan,
     T *output) {
+  const index_t *xs = plan.xs.indices.data();
+  const index_t *ys = plan.ys.indices.data();
+  // Output rows of a plane computed by one task
+  const index_t tile_height = 16;
+
   utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
 
   thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
                             index_t start1, index_t end1, index_t step1) {
-    for (index_t b = start0; b < end0; b += step0) {
-      for (index_t c = start1; c < end1; c += step1) {
-        const T
-            *channel_input_ptr =
-            images + (b * channels + c) * in_height * in_width;
-        T *channel_output_ptr =
-            output + (b * channels + c) * out_height * out_width;
-        for (index_t y = 0; y < out_height; ++y) {
-          const float in_f_y = coordinate_transformation_mode == HALF_PIXEL ?
-                               (static_cast<float>(y) + 0.5f) * height_scale :
-                               y * height_scale;
-          const index_t in_y = std::min(
-              (align_corners) ? static_cast<index_t>(roundf(in_f_y))
-                              : static_cast<index_t>(nearest_func(in_f_y)),
-              in_height - 1);
-          for (int x = 0; x < out_width; ++x) {
-            const float in_f_x = coordinate_transformation_mode == HALF_PIXEL ?
-                                 (static_cast<float>(x) + 0.5f) * width_scale :
-                                 x * width_scale;
-            const index_t in_x = std::min(
-                (align_corners) ? static_cast<index_t>(roundf(in_f_x))
-                                : static_cast<index_t>(nearest_func(in_f_x)),
-                in_width - 1);
-            channel_output_ptr[y * out_width + x] =
-                channel_input_ptr[in_y * in_width + in_x];
+    for (index_t i = start0; i < end0; i += step0) {
+      const T *channel_input_ptr = images + i * in_height * in_width;
+      T *channel_output_ptr = output + i * out_height * out_width;
+      for (index_t h = start1; h < end1; h += step1) {
+        const index_t h_end = std::min(h + tile_height, out_height);
+        for (index_t y = h; y < h_end; ++y) {
+          T *output_ptr = channel_output_ptr + y * out_width;
+          if (y > h && ys[y] == ys[y - 1]) {
+            // upsampling repeats the previous row
+            std::copy_n(output_ptr - out_width, out_width, output_ptr);
+            continue;
+          }
+          const T *input_ptr = channel_input_ptr + ys[y] * in_width;
+          for (index_t x = 0; x < out_width; ++x) {
+            output_ptr[x] = input_ptr[xs[x]];
           }
         }
       }
     }
-  }, 0, batch_size, 1, 0, channels, 1);
+  }, 0, batch_size * channels, 1, 0, out_height, tile_height);
 }
+}  // namespace
 
 template<RuntimeType D, typename T>
 class ResizeNearestNeighborOp;
@@ -177,15 +188,22 @@ class ResizeNearestNeighborOp<RuntimeType::RT_CPU, T> : public Operation {
       return MaceStatus::MACE_SUCCESS;
     }
 
-    // Caffe/ONNX's scale is the opposite of ours
-    float height_scale = height_scale_ > 0 ? 1 / height_scale_ :
-                         common::utils::CalculateResizeScale(in_height,
-                                                             out_height,
-                                                             align_corners_);
-    float width_scale = width_scale_ > 0 ? 1 / width_scale_ :
-                        common::utils::CalculateResizeScale(in_width,
-                                                            out_width,
-                                                            align_corners_);
+    if (plan_.Update(in_height, in_width, out_height, out_width,
+                     coordinate_transformation_mode_)) {
+      // Caffe/ONNX's scale is the opposite of ours
+      float height_scale = height_scale_ > 0 ? 1 / height_scale_ :
+          common::utils::CalculateResizeScale(in_height, out_height,
+                                              align_corners_);
+      float width_scale = width_scale_ > 0 ? 1 / width_scale_ :
+          common::utils::CalculateResizeScale(in_width, out_width,
+                                              align_corners_);
+      BuildAxisPlan(out_height, in_height, height_scale, align_corners_,
+                    coordinate_transformation_mode_, nearest_func_,
+                    &plan_.ys);
+      BuildAxisPlan(out_width, in_width, width_scale, align_corners_,
+                    coordinate_transformation_mode_, nearest_func_,
+                    &plan_.xs);
+    }
     ResizeImageNCHW(context,
                     input_data,
                     batch,
@@ -194,11 +212,7 @@ class ResizeNearestNeighborOp<RuntimeType::RT_CPU, T> : public Operation {
                     out_height,
                     out_width,
                     channels,
-                    height_scale,
-                    width_scale,
-                    align_corners_,
-                    coordinate_transformation_mode_,
-                    nearest_func_,
+                    plan_,
                     output_data);
     return MaceStatus::MACE_SUCCESS;
   }
@@ -211,6 +225,7 @@ class ResizeNearestNeighborOp<RuntimeType::RT_CPU, T> : public Operation {
   float height_scale_;
   float width_scale_;
   NearestFunc nearest_func_;
+  ResizePlan plan_;
 };
 
 #ifdef MACE_ENABLE_OPENCL
@@ -145,6 +145,11 @@ class ScalarMathOp : public Operation {
     return MaceStatus::MACE_SUCCESS;
   }
 
+  bool SupportsInPlace(size_t output_idx, size_t input_idx) const override {
+    MACE_UNUSED(input_idx);
+    return output_idx == 0;
+  }
+
  private:
   EltwiseType type_;
   std::vector<float> coeff_;
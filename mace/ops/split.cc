@@ -12,8 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "mace/core/ops/operator.h"
 #include "mace/core/registry/ops_registry.h"
@@ -37,16 +39,7 @@ class SplitOp<RuntimeType::RT_CPU, T> : public Operation {
         checked_(false) {}
 
   void Validate() {
-    if (axis_ < 0) {
-      axis_ += this->Input(0)->dim_size();
-    }
-    auto has_df = Operation::GetOptionalArg<int>(
-        "has_data_format", 0);
-    if (has_df && this->Input(0)->dim_size() == 4) {
-      if (axis_ == 3) axis_ = 1;
-      else if (axis_ == 2) axis_ = 3;
-      else if (axis_ == 1) axis_ = 2;
-    }
+    axis_ = DataAxis(axis_, this->Input(0)->dim_size());
     MACE_CHECK(this->OutputSize() >= 2)
       << "There must be at least two outputs for slicing";
     const Tensor *split_tensor =
@@ -120,12 +113,35 @@ class SplitOp<RuntimeType::RT_CPU, T> : public Operation {
       output_ptrs[i] = output_list[i]->mutable_data<T>();
     }
     const T *input_ptr = input->data<T>();
+    // Outputs placed as views of the input by the memory planner are already
+    // in place. If an output overlaps the input elsewhere, e.g. after the
+    // shapes changed, all of them are copied from a staged input.
+    std::vector<bool> in_place(outputs_count, false);
+    bool stage_input = false;
+    index_t offset = 0;
+    for (size_t i = 0; i < outputs_count; ++i) {
+      if (outer_size == 1 && output_ptrs[i] == input_ptr + offset) {
+        in_place[i] = true;
+      } else if (output_list[i]->SharesMemoryWith(*input)) {
+        stage_input = true;
+      }
+      offset += output_channels_list[i] * inner_size;
+    }
+    if (stage_input) {
+      staged_input_.assign(input_ptr, input_ptr + input->size());
+      input_ptr = staged_input_.data();
+      std::fill(in_place.begin(), in_place.end(), false);
+    }
 
     for (int outer_idx = 0; outer_idx < outer_size; ++outer_idx) {
       index_t input_idx = outer_idx * input_channels * inner_size;
       index_t multiplier = outer_idx * inner_size;
       for (size_t i = 0; i < outputs_count; ++i) {
         index_t output_idx = multiplier * output_channels_list[i];
+        if (in_place[i]) {
+          input_idx += output_channels_list[i] * inner_size;
+          continue;
+        }
         if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
           memcpy(output_ptrs[i] + output_idx, input_ptr + input_idx,
                  output_channels_list[i] * inner_size * sizeof(T));
@@ -140,9 +156,53 @@ class SplitOp<RuntimeType::RT_CPU, T> : public Operation {
     return MaceStatus::MACE_SUCCESS;
   }
 
+  // The outputs are consecutive ranges of the input when all the dims before
+  // the axis are 1, e.g. the channels of NCHW with batch 1.
+  index_t OutputViewOffset(size_t output_idx) const override {
+    const Tensor *input = inputs_[0];
+    const index_t rank = input->dim_size();
+    const int axis = DataAxis(Operation::GetOptionalArg<int>("axis", 3), rank);
+    if (output_idx >= outputs_.size() || rank == 0 || axis < 0 ||
+        axis >= rank) {
+      return -1;
+    }
+    for (int i = 0; i < axis; ++i) {
+      if (input->dim(i) != 1) {
+        return -1;
+      }
+    }
+    index_t offset = 0;
+    index_t total_size = 0;
+    for (size_t i = 0; i < outputs_.size(); ++i) {
+      if (outputs_[i]->dim_size() != rank) {
+        return -1;
+      }
+      if (i < output_idx) {
+        offset += outputs_[i]->size();
+      }
+      total_size += outputs_[i]->size();
+    }
+    return total_size == input->size() ? offset : -1;
+  }
+
  private:
+  int DataAxis(int axis, const index_t rank) const {
+    if (axis < 0) {
+      axis += rank;
+    }
+    auto has_df = Operation::GetOptionalArg<int>(
+        "has_data_format", 0);
+    if (has_df && rank == 4) {
+      if (axis == 3) axis = 1;
+      else if (axis == 2) axis = 3;
+      else if (axis == 1) axis = 2;
+    }
+    return axis;
+  }
+
   int32_t axis_;
   bool checked_;
+  std::vector<T> staged_input_;
 };
 
 #ifdef MACE_ENABLE_OPENCL
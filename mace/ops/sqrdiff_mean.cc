@@ -17,6 +17,7 @@
 
 #include "mace/core/ops/operator.h"
 #include "mace/core/registry/ops_registry.h"
+#include "mace/ops/common/reduce.h"
 #ifdef MACE_ENABLE_OPENCL
 #include "mace/ops/opencl/image/sqrdiff_mean.h"
 #endif  // MACE_ENABLE_OPENCL
@@ -32,7 +33,6 @@ class SqrDiffMeanOp : public Operation {
       : Operation(context) {}
 
   MaceStatus Run(OpContext *context) override {
-    MACE_UNUSED(context);
     const Tensor *input0 = this->Input(0);
     const Tensor *input1 = this->Input(1);
     Tensor *output = this->Output(0);
@@ -48,30 +48,39 @@ class SqrDiffMeanOp : public Operation {
     out_shape[3] = 1;
 
     output->Resize(out_shape);
-    Compute(input0, input1, output);
+    Compute(context, input0, input1, output);
     return MaceStatus::MACE_SUCCESS;
   }
 
  private:
-  void Compute(const Tensor *input0,
+  void Compute(OpContext *context,
+               const Tensor *input0,
                const Tensor *input1,
                Tensor *output) {
-    const T *input_ptr0 = input0->data<T>();
     const T *input_ptr1 = input1->data<T>();
-    T *output_ptr = output->mutable_data<T>();
-    memset(static_cast<void *>(output_ptr), 0, output->size() * sizeof(T));
-
     const index_t img_size = input0->dim(2) * input0->dim(3);
     const index_t bc = input0->dim(0) * input0->dim(1);
 
-    // TODO(luxuhui): cache the output_ptr[i]
-    for (int i = 0; i < bc; ++i) {
-      for (int j = 0; j < img_size; ++j) {
-        float diff = input_ptr0[i * img_size + j] - input_ptr1[i];
-        output_ptr[i] += diff * diff;
-      }
-      output_ptr[i] /= img_size;
+    const std::vector<ReduceStep> steps = {{bc, img_size, 1}};
+    auto *runtime = context->runtime();
+    std::unique_ptr<Buffer> scratch_buffer;
+    float *partials = nullptr;
+    const index_t scratch_size = ReduceScratchSize(steps);
+    if (scratch_size > 0) {
+      MemInfo mem_info(MemoryType::CPU_BUFFER, DataType::DT_FLOAT,
+                       {scratch_size});
+      scratch_buffer = runtime->ObtainBuffer(mem_info, RENT_SCRATCH);
+      partials = scratch_buffer->mutable_data<float>();
     }
+    ReduceStepCompute<ReduceSumOp<float>>(
+        &runtime->thread_pool(), input0->data<T>(), steps[0],
+        [input_ptr1](index_t i, T x) {
+          const float diff =
+              static_cast<float>(x) - static_cast<float>(input_ptr1[i]);
+          return diff * diff;
+        },
+        [img_size](float sum) { return sum / img_size; },
+        partials, output->mutable_data<T>());
   }
 };
 
@@ -0,0 +1,115 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "mace/core/ops/operator.h"
+#include "mace/core/registry/ops_registry.h"
+#include "mace/ops/common/top_k.h"
+
+namespace mace {
+namespace ops {
+
+// Outputs the k largest (or smallest) values along an axis and their
+// indices, like tf.math.top_k and ONNX TopK. k is either the "top_k"
+// argument or the optional second input.
+template<RuntimeType D, class T>
+class TopKOp : public Operation {
+ public:
+  explicit TopKOp(OpConstructContext *context)
+      : Operation(context),
+        top_k_(Operation::GetOptionalArg<int>("top_k", 1)),
+        axis_(Operation::GetOptionalArg<int>("axis", -1)),
+        largest_(Operation::GetOptionalArg<bool>("largest", true)),
+        sorted_(Operation::GetOptionalArg<bool>("sorted", true)) {}
+
+  MaceStatus Run(OpContext *context) override {
+    const Tensor *input = this->Input(INPUT);
+    Tensor *values = this->Output(VALUES);
+    Tensor *indices = this->Output(INDICES);
+
+    const int input_dim_size = input->dim_size();
+    MACE_CHECK(input_dim_size > 0, "TopK input should not be a scalar");
+    const int axis = axis_ < 0 ? axis_ + input_dim_size : axis_;
+    MACE_CHECK(axis >= 0 && axis < input_dim_size,
+               "axis is out of bound: ", axis_);
+    index_t k = top_k_;
+    if (this->InputSize() > 1) {
+      const Tensor *k_tensor = this->Input(K);
+      MACE_CHECK(k_tensor->size() == 1, "TopK k should be a scalar");
+      k = k_tensor->data<int32_t>()[0];
+    }
+
+    const auto &input_shape = input->shape();
+    const index_t axis_dim = input_shape[axis];
+    const index_t outer = std::accumulate(input_shape.begin(),
+                                          input_shape.begin() + axis, 1,
+                                          std::multiplies<index_t>());
+    const index_t inner = std::accumulate(input_shape.begin() + axis + 1,
+                                          input_shape.end(), 1,
+                                          std::multiplies<index_t>());
+    std::vector<index_t> output_shape(input_shape);
+    output_shape[axis] = k;
+    MACE_RETURN_IF_ERROR(values->Resize(output_shape));
+    MACE_RETURN_IF_ERROR(indices->Resize(output_shape));
+    if (values->size() == 0) {
+      return MaceStatus::MACE_SUCCESS;
+    }
+
+    const float *rows = TopKRows(input->data<T>(), outer, axis_dim, inner,
+                                 &rows_buffer_);
+    candidates_.resize(outer * inner * k);
+    TopKSelector selector(k, largest_, sorted_);
+    selector.Select(&context->runtime()->thread_pool(), rows, outer * inner,
+                    axis_dim, candidates_.data());
+
+    T *values_data = values->mutable_data<T>();
+    int32_t *indices_data = indices->mutable_data<int32_t>();
+    for (index_t o = 0; o < outer; ++o) {
+      for (index_t i = 0; i < inner; ++i) {
+        const TopKCandidate *row_candidates =
+            candidates_.data() + (o * inner + i) * k;
+        for (index_t j = 0; j < k; ++j) {
+          const index_t output_idx = (o * k + j) * inner + i;
+          values_data[output_idx] = static_cast<T>(row_candidates[j].value);
+          indices_data[output_idx] = row_candidates[j].index;
+        }
+      }
+    }
+
+    return MaceStatus::MACE_SUCCESS;
+  }
+
+ private:
+  const int top_k_;
+  const int axis_;
+  const bool largest_;
+  const bool sorted_;
+  std::vector<float> rows_buffer_;
+  std::vector<TopKCandidate> candidates_;
+
+  MACE_OP_INPUT_TAGS(INPUT, K);
+  MACE_OP_OUTPUT_TAGS(VALUES, INDICES);
+};
+
+void RegisterTopK(OpRegistry *op_registry) {
+  MACE_REGISTER_OP(op_registry, "TopK", TopKOp, RuntimeType::RT_CPU, float);
+  MACE_REGISTER_BF16_OP(op_registry, "TopK", TopKOp, RuntimeType::RT_CPU);
+}
+
+}  // namespace ops
+}  // namespace mace
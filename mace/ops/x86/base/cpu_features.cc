@@ -0,0 +1,121 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/ops/x86/base/cpu_features.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#if defined(__linux__) && defined(__x86_64__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+
+#include "mace/utils/logging.h"
+
+namespace mace {
+namespace ops {
+namespace x86 {
+
+namespace {
+
+#if defined(__x86_64__) || defined(__i386__)
+// XCR0 bits of the register states the OS saves on context switches
+constexpr uint64_t kXcr0Avx = 0x6;  // xmm, ymm
+constexpr uint64_t kXcr0Avx512 = 0xe0;  // opmask, zmm0-15 upper, zmm16-31
+constexpr uint64_t kXcr0Amx = 0x60000;  // tile config, tile data
+
+uint64_t ReadXcr0() {
+  uint32_t eax = 0;
+  uint32_t edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+
+bool RequestAmxPermission() {
+#if defined(__linux__) && defined(__x86_64__)
+  const int kArchReqXcompPerm = 0x1023;
+  const int kXfeatureXtiledata = 18;
+  if (syscall(SYS_arch_prctl, kArchReqXcompPerm, kXfeatureXtiledata) != 0) {
+    VLOG(1) << "The kernel does not allow to use AMX tiles";
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+CpuFeatures DetectCpuFeatures() {
+  CpuFeatures features = {};
+  uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return features;
+  }
+  const bool osxsave = (ecx & (1u << 27)) != 0;
+  const bool avx = (ecx & (1u << 28)) != 0;
+  const bool fma = (ecx & (1u << 12)) != 0;
+  const bool f16c = (ecx & (1u << 29)) != 0;
+  if (!osxsave || !avx) {
+    return features;
+  }
+  const uint64_t xcr0 = ReadXcr0();
+  if ((xcr0 & kXcr0Avx) != kXcr0Avx) {
+    return features;
+  }
+  features.fma = fma;
+  features.f16c = f16c;
+
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return features;
+  }
+  const uint32_t max_subleaf = eax;
+  features.avx2 = (ebx & (1u << 5)) != 0;
+  features.avx512f = (ebx & (1u << 16)) != 0 &&
+      (xcr0 & kXcr0Avx512) == kXcr0Avx512;
+  const bool amx_bf16 = (edx & (1u << 22)) != 0;
+  const bool amx_tile = (edx & (1u << 24)) != 0;
+
+  if (max_subleaf >= 1 && __get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx)) {
+    features.avx512bf16 = features.avx512f && (eax & (1u << 5)) != 0;
+  }
+  if (amx_bf16 && amx_tile && (xcr0 & kXcr0Amx) == kXcr0Amx) {
+    features.amx_bf16 = RequestAmxPermission();
+  }
+
+  VLOG(1) << "x86 cpu features: avx2 " << features.avx2
+          << ", fma " << features.fma << ", f16c " << features.f16c
+          << ", avx512f " << features.avx512f
+          << ", avx512bf16 " << features.avx512bf16
+          << ", amx_bf16 " << features.amx_bf16;
+  return features;
+}
+#else
+CpuFeatures DetectCpuFeatures() {
+  return CpuFeatures();
+}
+#endif
+
+}  // namespace
+
+const CpuFeatures &GetCpuFeatures() {
+  static const CpuFeatures features = DetectCpuFeatures();
+  return features;
+}
+
+}  // namespace x86
+}  // namespace ops
+}  // namespace mace
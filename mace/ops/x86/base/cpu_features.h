@@ -0,0 +1,42 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_X86_BASE_CPU_FEATURES_H_
+#define MACE_OPS_X86_BASE_CPU_FEATURES_H_
+
+namespace mace {
+namespace ops {
+namespace x86 {
+
+// Instruction set extensions reported by cpuid and enabled by the OS. The
+// x86 kernels are compiled with function target attributes, and registered
+// only if the cpu running them has the features they use.
+struct CpuFeatures {
+  bool avx2;
+  bool fma;
+  // Not used yet, see the F16C fp16 storage item in ROADMAP.md
+  bool f16c;
+  bool avx512f;
+  bool avx512bf16;
+  // The tile data state is also requested from the kernel (Linux only)
+  bool amx_bf16;
+};
+
+const CpuFeatures &GetCpuFeatures();
+
+}  // namespace x86
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_X86_BASE_CPU_FEATURES_H_
@@ -0,0 +1,102 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <vector>
+
+#include "mace/ops/delegator/conv_2d.h"
+#include "mace/ops/x86/base/cpu_features.h"
+#include "mace/ops/x86/bf16/gemm.h"
+
+namespace mace {
+namespace ops {
+namespace x86 {
+namespace bf16 {
+
+// A 1x1 convolution without padding is a gemm of the filter and each input
+// image, padded ones are rare and left to the reference delegator.
+class Conv2dK1x1 : public delegator::Conv2d {
+ public:
+  explicit Conv2dK1x1(const delegator::Conv2dParam &param)
+      : delegator::Conv2d(param),
+        gemm_(delegator::GemmParam()) {}
+  ~Conv2dK1x1() {}
+
+  MaceStatus Compute(const OpContext *context,
+                     const Tensor *input,
+                     const Tensor *filter,
+                     Tensor *output) override;
+
+ private:
+  Gemm gemm_;
+  std::unique_ptr<delegator::Conv2d> ref_conv2d_;
+};
+
+MaceStatus Conv2dK1x1::Compute(const OpContext *context,
+                               const Tensor *input,
+                               const Tensor *filter,
+                               Tensor *output) {
+  std::vector<index_t> output_shape(4);
+  std::vector<int> paddings(2);
+  if (paddings_.empty()) {
+    CalcNCHWPaddingAndOutputSize(input->shape().data(),
+                                 filter->shape().data(),
+                                 dilations_.data(),
+                                 strides_.data(),
+                                 padding_type_,
+                                 output_shape.data(),
+                                 paddings.data());
+  } else {
+    paddings = paddings_;
+  }
+
+  if (paddings[0] != 0 || paddings[1] != 0) {
+    if (ref_conv2d_ == nullptr) {
+      ref_conv2d_ = delegator::Conv2d::Create(
+          context->workspace(),
+          MACE_DELEGATOR_KEY(Conv2d, RuntimeType::RT_CPU,
+                             BFloat16, ImplType::REF),
+          delegator::Conv2dParam(strides_, dilations_,
+                                 paddings_, padding_type_));
+    }
+    return ref_conv2d_->Compute(context, input, filter, output);
+  }
+
+  const index_t batch = input->dim(0);
+  const index_t in_channels = input->dim(1);
+  const index_t out_channels = filter->dim(0);
+  const index_t image_size = input->dim(2) * input->dim(3);
+  MACE_RETURN_IF_ERROR(output->Resize(
+      {batch, out_channels, input->dim(2), input->dim(3)}));
+
+  return gemm_.Compute(context, filter, input, batch, out_channels,
+                       in_channels, in_channels, image_size, false, false,
+                       false, false, true, output);
+}
+
+void RegisterConv2dK1x1Delegator(OpDelegatorRegistry *registry) {
+  const CpuFeatures &features = GetCpuFeatures();
+  if (!features.avx512bf16 && !features.amx_bf16) {
+    return;
+  }
+  MACE_REGISTER_BF16_DELEGATOR(
+      registry, Conv2dK1x1, delegator::Conv2dParam,
+      MACE_DELEGATOR_KEY_EX(Conv2d, RuntimeType::RT_CPU,
+                            BFloat16, ImplType::X86, K1x1));
+}
+
+}  // namespace bf16
+}  // namespace x86
+}  // namespace ops
+}  // namespace mace
@@ -0,0 +1,451 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/ops/x86/bf16/gemm.h"
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cstring>
+
+#include "mace/core/runtime/runtime.h"
+#include "mace/ops/x86/base/cpu_features.h"
+#include "mace/utils/math.h"
+
+namespace mace {
+namespace ops {
+namespace x86 {
+namespace bf16 {
+
+static_assert(sizeof(BFloat16) == sizeof(uint16_t),
+              "BFloat16 should be stored as 16 bits");
+
+namespace {
+enum { kNoCache, kCacheLhs, kCacheRhs };
+
+// An output block is computed by one AMX tile multiplication of a 16 x 32
+// lhs tile and two 16 x 16 pairs rhs tiles, or by two 8-row AVX-512 blocks.
+const index_t kRowBlockSize = 16;
+const index_t kColBlockSize = 32;
+const index_t kPanelCols = 16;
+const index_t kDepthBlockSize = 32;
+
+struct TileConfig {
+  uint8_t palette_id;
+  uint8_t start_row;
+  uint8_t reserved[14];
+  uint16_t colsb[16];
+  uint8_t rows[16];
+};
+
+TileConfig MakeTileConfig() {
+  TileConfig config;
+  memset(&config, 0, sizeof(config));
+  config.palette_id = 1;
+  // tmm0, tmm1: output, tmm2: lhs, tmm3, tmm4: rhs
+  for (int i = 0; i < 5; ++i) {
+    config.rows[i] = 16;
+    config.colsb[i] = 64;
+  }
+  return config;
+}
+
+// The tile configuration is per thread. It is kept in static storage since
+// the compiler does not see ldtilecfg reading a local one and drops the
+// stores.
+__attribute__((target("amx-tile")))
+void LoadTileConfig() {
+  static const TileConfig config = MakeTileConfig();
+  _tile_loadconfig(&config);
+}
+
+__attribute__((target("amx-tile")))
+void ReleaseTiles() {
+  _tile_release();
+}
+
+__attribute__((target("amx-tile,amx-bf16")))
+void ComputeBlockAmx(const uint16_t *packed_lhs,
+                     const uint16_t *packed_rhs,
+                     const index_t depth_padded,
+                     float *output) {
+  const uint16_t *packed_rhs1 = packed_rhs + depth_padded * kPanelCols;
+  _tile_zero(0);
+  _tile_zero(1);
+  for (index_t d = 0; d < depth_padded; d += kDepthBlockSize) {
+    _tile_loadd(2, packed_lhs + d, depth_padded * sizeof(uint16_t));
+    _tile_loadd(3, packed_rhs + d * kPanelCols, 64);
+    _tile_loadd(4, packed_rhs1 + d * kPanelCols, 64);
+    _tile_dpbf16ps(0, 2, 3);
+    _tile_dpbf16ps(1, 2, 4);
+  }
+  _tile_stored(0, output, kColBlockSize * sizeof(float));
+  _tile_stored(1, output + kPanelCols, kColBlockSize * sizeof(float));
+}
+
+__attribute__((target("avx512f,avx512bf16")))
+inline __m512bh BroadcastPair(const uint16_t *data) {
+  int32_t pair;
+  memcpy(&pair, data, sizeof(pair));
+  return (__m512bh)_mm512_set1_epi32(pair);
+}
+
+#define MACE_BF16_DOT_ROW(r)                                          \
+  {                                                                   \
+    const __m512bh a = BroadcastPair(lhs_ptr + r * depth_padded);     \
+    acc##r##0 = _mm512_dpbf16_ps(acc##r##0, a, b0);                   \
+    acc##r##1 = _mm512_dpbf16_ps(acc##r##1, a, b1);                   \
+  }
+
+#define MACE_BF16_STORE_ROW(r)                                        \
+  _mm512_storeu_ps(output + r * kColBlockSize, acc##r##0);            \
+  _mm512_storeu_ps(output + r * kColBlockSize + kPanelCols, acc##r##1);
+
+// 8 x 32 output block, each dot product accumulates a pair of depth values
+__attribute__((target("avx512f,avx512bf16")))
+void ComputeBlockAvx512(const uint16_t *packed_lhs,
+                        const uint16_t *packed_rhs,
+                        const index_t depth_padded,
+                        float *output) {
+  const uint16_t *packed_rhs1 = packed_rhs + depth_padded * kPanelCols;
+  __m512 acc00 = _mm512_setzero_ps(), acc01 = _mm512_setzero_ps();
+  __m512 acc10 = _mm512_setzero_ps(), acc11 = _mm512_setzero_ps();
+  __m512 acc20 = _mm512_setzero_ps(), acc21 = _mm512_setzero_ps();
+  __m512 acc30 = _mm512_setzero_ps(), acc31 = _mm512_setzero_ps();
+  __m512 acc40 = _mm512_setzero_ps(), acc41 = _mm512_setzero_ps();
+  __m512 acc50 = _mm512_setzero_ps(), acc51 = _mm512_setzero_ps();
+  __m512 acc60 = _mm512_setzero_ps(), acc61 = _mm512_setzero_ps();
+  __m512 acc70 = _mm512_setzero_ps(), acc71 = _mm512_setzero_ps();
+  for (index_t d = 0; d < depth_padded; d += 2) {
+    const __m512bh b0 =
+        (__m512bh)_mm512_loadu_si512(packed_rhs + d * kPanelCols);
+    const __m512bh b1 =
+        (__m512bh)_mm512_loadu_si512(packed_rhs1 + d * kPanelCols);
+    const uint16_t *lhs_ptr = packed_lhs + d;
+    MACE_BF16_DOT_ROW(0);
+    MACE_BF16_DOT_ROW(1);
+    MACE_BF16_DOT_ROW(2);
+    MACE_BF16_DOT_ROW(3);
+    MACE_BF16_DOT_ROW(4);
+    MACE_BF16_DOT_ROW(5);
+    MACE_BF16_DOT_ROW(6);
+    MACE_BF16_DOT_ROW(7);
+  }
+  MACE_BF16_STORE_ROW(0);
+  MACE_BF16_STORE_ROW(1);
+  MACE_BF16_STORE_ROW(2);
+  MACE_BF16_STORE_ROW(3);
+  MACE_BF16_STORE_ROW(4);
+  MACE_BF16_STORE_ROW(5);
+  MACE_BF16_STORE_ROW(6);
+  MACE_BF16_STORE_ROW(7);
+}
+
+#undef MACE_BF16_DOT_ROW
+#undef MACE_BF16_STORE_ROW
+
+inline uint16_t RawBits(const BFloat16 &value) {
+  uint16_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+}  // namespace
+
+Gemm::Gemm(const delegator::GemmParam &param)
+    : delegator::Gemm(param),
+      should_cache_pack_(param.should_cache_pack_),
+      use_amx_(GetCpuFeatures().amx_bf16),
+      cached_(kNoCache) {}
+
+void Gemm::PackLhs(const OpContext *context,
+                   const MatrixMap<const BFloat16> &lhs,
+                   const index_t depth_padded,
+                   uint16_t *packed_lhs) {
+  const index_t rows = lhs.rows();
+  const index_t depth = lhs.cols();
+  const index_t rows_padded = RoundUp(rows, kRowBlockSize);
+  utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+  thread_pool.Compute1D([=, &lhs](index_t start, index_t end, index_t step) {
+    for (index_t r = start; r < end; r += step) {
+      uint16_t *packed_ptr = packed_lhs + r * depth_padded;
+      if (r >= rows) {
+        memset(packed_ptr, 0, depth_padded * sizeof(uint16_t));
+        continue;
+      }
+      if (lhs.cols_stride() == 1) {
+        memcpy(packed_ptr, lhs.data(r, 0), depth * sizeof(uint16_t));
+      } else {
+        for (index_t d = 0; d < depth; ++d) {
+          packed_ptr[d] = RawBits(lhs(r, d));
+        }
+      }
+      memset(packed_ptr + depth, 0, (depth_padded - depth) * sizeof(uint16_t));
+    }
+  }, 0, rows_padded, 1);
+}
+
+void Gemm::PackRhs(const OpContext *context,
+                   const MatrixMap<const BFloat16> &rhs,
+                   const index_t depth_padded,
+                   uint16_t *packed_rhs) {
+  const index_t depth = rhs.rows();
+  const index_t cols = rhs.cols();
+  const index_t panel_count = RoundUp(cols, kColBlockSize) / kPanelCols;
+  utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+  thread_pool.Compute1D([=, &rhs](index_t start, index_t end, index_t step) {
+    for (index_t panel = start; panel < end; panel += step) {
+      uint16_t *packed_ptr = packed_rhs + panel * depth_padded * kPanelCols;
+      for (index_t d = 0; d < depth_padded; d += 2) {
+        for (index_t c = 0; c < kPanelCols; ++c) {
+          const index_t col = panel * kPanelCols + c;
+          const bool valid_col = col < cols;
+          packed_ptr[2 * c] = valid_col && d < depth ? RawBits(rhs(d, col)) : 0;
+          packed_ptr[2 * c + 1] =
+              valid_col && d + 1 < depth ? RawBits(rhs(d + 1, col)) : 0;
+        }  // c
+        packed_ptr += 2 * kPanelCols;
+      }  // d
+    }  // panel
+  }, 0, panel_count, 1);
+}
+
+MaceStatus Gemm::ComputeImpl(const OpContext *context,
+                             const Tensor *lhs,
+                             const Tensor *rhs,
+                             const index_t batch,
+                             const index_t rows,
+                             const index_t cols,
+                             const index_t depth,
+                             const MatrixMajor lhs_major,
+                             const MatrixMajor rhs_major,
+                             const MatrixMajor output_major,
+                             const bool lhs_batched,
+                             const bool rhs_batched,
+                             const GemmEpilogue *epilogue,
+                             Tensor *output) {
+  MACE_CHECK(output->size() == batch * rows * cols,
+             "Need resize output tensor before call gemm.");
+  const BFloat16 *lhs_data = lhs->data<BFloat16>();
+  const BFloat16 *rhs_data = rhs->data<BFloat16>();
+  BFloat16 *output_data = output->mutable_data<BFloat16>();
+  const BFloat16 *bias_data = nullptr;
+  if (epilogue != nullptr && epilogue->bias != nullptr) {
+    bias_data = epilogue->bias->data<BFloat16>();
+  }
+
+  const index_t row_block_count = RoundUpDiv(rows, kRowBlockSize);
+  const index_t col_block_count = RoundUpDiv(cols, kColBlockSize);
+  const index_t rows_padded = row_block_count * kRowBlockSize;
+  const index_t cols_padded = col_block_count * kColBlockSize;
+  const index_t depth_padded = RoundUp(depth, kDepthBlockSize);
+
+  auto *runtime = context->runtime();
+  MemInfo mem_info(output->memory_type(), DT_BFLOAT16,
+                   {rows_padded * depth_padded});
+  auto packed_lhs_buffer = runtime->ObtainBuffer(mem_info, RENT_SCRATCH);
+  mem_info.dims = {depth_padded * cols_padded};
+  auto packed_rhs_buffer = runtime->ObtainBuffer(mem_info, RENT_SCRATCH);
+  uint16_t *packed_lhs_data = packed_lhs_buffer->mutable_data<uint16_t>();
+  uint16_t *packed_rhs_data = packed_rhs_buffer->mutable_data<uint16_t>();
+
+  int cache_side = kNoCache;
+  if (cached_ == kCacheLhs) {
+    packed_lhs_data = pack_cache_->mutable_data<uint16_t>();
+  } else if (cached_ == kCacheRhs) {
+    packed_rhs_data = pack_cache_->mutable_data<uint16_t>();
+  } else if (should_cache_pack_) {
+    if (lhs->is_weight() && (!lhs_batched || batch == 1)) {
+      cache_side = kCacheLhs;
+      mem_info.dims = {rows_padded * depth_padded};
+      pack_cache_ = runtime->ObtainBuffer(mem_info, RENT_PRIVATE);
+      packed_lhs_data = pack_cache_->mutable_data<uint16_t>();
+    } else if (rhs->is_weight() && (!rhs_batched || batch == 1)) {
+      cache_side = kCacheRhs;
+      mem_info.dims = {depth_padded * cols_padded};
+      pack_cache_ = runtime->ObtainBuffer(mem_info, RENT_PRIVATE);
+      packed_rhs_data = pack_cache_->mutable_data<uint16_t>();
+    }
+  }
+
+  utils::ThreadPool &thread_pool = context->runtime()->thread_pool();
+  const bool use_amx = use_amx_;
+
+  for (index_t b = 0; b < batch; ++b) {
+    MatrixMap<const BFloat16>
+        lhs_matrix
+        (lhs_data + static_cast<index_t>(lhs_batched) * b * rows * depth,
+         lhs_major,
+         rows,
+         depth);
+    MatrixMap<const BFloat16>
+        rhs_matrix
+        (rhs_data + static_cast<index_t>(rhs_batched) * b * depth * cols,
+         rhs_major,
+         depth,
+         cols);
+    MatrixMap<BFloat16> output_matrix
+        (output_data + b * rows * cols, output_major, rows, cols);
+
+    if (cached_ != kCacheLhs) {
+      PackLhs(context, lhs_matrix, depth_padded, packed_lhs_data);
+      if (cache_side == kCacheLhs) {
+        cached_ = kCacheLhs;
+      }
+    }
+    if (cached_ != kCacheRhs) {
+      PackRhs(context, rhs_matrix, depth_padded, packed_rhs_data);
+      if (cache_side == kCacheRhs) {
+        cached_ = kCacheRhs;
+      }
+    }
+
+    thread_pool.Compute2D([=, &output_matrix](index_t start0, index_t end0,
+                                              index_t step0, index_t start1,
+                                              index_t end1, index_t step1) {
+      if (use_amx) {
+        LoadTileConfig();
+      }
+      float block[kRowBlockSize * kColBlockSize];
+      for (index_t row_block_idx = start0; row_block_idx < end0;
+           row_block_idx += step0) {
+        const index_t start_row = row_block_idx * kRowBlockSize;
+        const index_t row_block_len =
+            std::min(kRowBlockSize, rows - start_row);
+        const uint16_t *packed_lhs_block =
+            packed_lhs_data + start_row * depth_padded;
+        for (index_t col_block_idx = start1; col_block_idx < end1;
+             col_block_idx += step1) {
+          const index_t start_col = col_block_idx * kColBlockSize;
+          const index_t col_block_len =
+              std::min(kColBlockSize, cols - start_col);
+          const uint16_t *packed_rhs_block =
+              packed_rhs_data + start_col * depth_padded;
+          if (use_amx) {
+            ComputeBlockAmx(packed_lhs_block, packed_rhs_block,
+                            depth_padded, block);
+          } else {
+            ComputeBlockAvx512(packed_lhs_block, packed_rhs_block,
+                               depth_padded, block);
+            ComputeBlockAvx512(packed_lhs_block + 8 * depth_padded,
+                               packed_rhs_block, depth_padded,
+                               block + 8 * kColBlockSize);
+          }
+
+          for (index_t r = 0; r < row_block_len; ++r) {
+            const float *block_ptr = block + r * kColBlockSize;
+            for (index_t c = 0; c < col_block_len; ++c) {
+              output_matrix(start_row + r, start_col + c) = block_ptr[c];
+            }
+            if (epilogue != nullptr) {
+              ApplyGemmEpilogue(
+                  *epilogue,
+                  bias_data == nullptr ? nullptr : bias_data + start_col,
+                  col_block_len, output_matrix.data(start_row + r, start_col));
+            }
+          }  // r
+        }  // col_block_idx
+      }  // row_block_idx
+      if (use_amx) {
+        ReleaseTiles();
+      }
+    }, 0, row_block_count, 1, 0, col_block_count, 1);
+  }  // b
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
+MaceStatus Gemm::Compute(const OpContext *context,
+                         const Tensor *lhs,
+                         const Tensor *rhs,
+                         const index_t batch,
+                         const index_t rows,
+                         const index_t cols,
+                         const index_t depth,
+                         const MatrixMajor lhs_major,
+                         const MatrixMajor rhs_major,
+                         const MatrixMajor output_major,
+                         const bool lhs_batched,
+                         const bool rhs_batched,
+                         Tensor *output) {
+  return ComputeImpl(context, lhs, rhs, batch, rows, cols, depth, lhs_major,
+                     rhs_major, output_major, lhs_batched, rhs_batched,
+                     nullptr, output);
+}
+
+MaceStatus Gemm::Compute(const OpContext *context,
+                         const Tensor *lhs,
+                         const Tensor *rhs,
+                         const index_t batch,
+                         const index_t lhs_rows,
+                         const index_t lhs_cols,
+                         const index_t rhs_rows,
+                         const index_t rhs_cols,
+                         const bool transpose_lhs,
+                         const bool transpose_rhs,
+                         const bool transpose_out,
+                         const bool lhs_batched,
+                         const bool rhs_batched,
+                         Tensor *output) {
+  index_t rows = transpose_lhs ? lhs_cols : lhs_rows;
+  index_t depth = transpose_lhs ? lhs_rows : lhs_cols;
+  index_t cols = transpose_rhs ? rhs_rows : rhs_cols;
+  index_t depth2 = transpose_rhs ? rhs_cols : rhs_rows;
+  MACE_CHECK(depth == depth2,
+             "Matrices that multiply have inconsistent depth dim: ",
+             depth,
+             " vs. ",
+             depth2);
+
+  return Compute(context,
+                 lhs,
+                 rhs,
+                 batch,
+                 rows,
+                 cols,
+                 depth,
+                 transpose_lhs ? ColMajor : RowMajor,
+                 transpose_rhs ? ColMajor : RowMajor,
+                 transpose_out ? ColMajor : RowMajor,
+                 lhs_batched,
+                 rhs_batched,
+                 output);
+}
+
+MaceStatus Gemm::ComputeWithEpilogue(const OpContext *context,
+                                     const Tensor *lhs,
+                                     const Tensor *rhs,
+                                     const index_t rows,
+                                     const index_t cols,
+                                     const index_t depth,
+                                     const MatrixMajor lhs_major,
+                                     const MatrixMajor rhs_major,
+                                     const GemmEpilogue &epilogue,
+                                     Tensor *output) {
+  return ComputeImpl(context, lhs, rhs, 1, rows, cols, depth, lhs_major,
+                     rhs_major, RowMajor, false, false, &epilogue, output);
+}
+
+void RegisterGemmDelegator(OpDelegatorRegistry *registry) {
+  const CpuFeatures &features = GetCpuFeatures();
+  if (!features.avx512bf16 && !features.amx_bf16) {
+    return;
+  }
+  MACE_REGISTER_BF16_DELEGATOR(
+      registry, Gemm, delegator::GemmParam,
+      MACE_DELEGATOR_KEY(Gemm, RuntimeType::RT_CPU, BFloat16, ImplType::X86));
+}
+
+}  // namespace bf16
+}  // namespace x86
+}  // namespace ops
+}  // namespace mace
@@ -0,0 +1,123 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_OPS_X86_BF16_GEMM_H_
+#define MACE_OPS_X86_BF16_GEMM_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "mace/core/ops/op_context.h"
+#include "mace/core/tensor.h"
+#include "mace/ops/common/matrix.h"
+#include "mace/ops/delegator/gemm.h"
+#include "mace/public/mace.h"
+
+// bfloat16 matrix-matrix multiplication with fp32 accumulation, by AMX tiles
+// if the cpu has them, otherwise by AVX-512 BF16 dot products.
+
+namespace mace {
+namespace ops {
+namespace x86 {
+namespace bf16 {
+
+class Gemm : public delegator::Gemm {
+ public:
+  explicit Gemm(const delegator::GemmParam &param);
+  ~Gemm() {}
+
+  MaceStatus Compute(
+      const OpContext *context,
+      const Tensor *lhs,
+      const Tensor *rhs,
+      const index_t batch,
+      const index_t rows,
+      const index_t cols,
+      const index_t depth,
+      const MatrixMajor lhs_major,
+      const MatrixMajor rhs_major,
+      const MatrixMajor output_major,
+      const bool lhs_batched,
+      const bool rhs_batched,
+      Tensor *output) override;
+
+  // Original matrix before transpose has row-major
+  MaceStatus Compute(
+      const OpContext *context,
+      const Tensor *lhs,
+      const Tensor *rhs,
+      const index_t batch,
+      const index_t lhs_rows,
+      const index_t lhs_cols,
+      const index_t rhs_rows,
+      const index_t rhs_cols,
+      const bool transpose_lhs,
+      const bool transpose_rhs,
+      const bool transpose_out,
+      const bool lhs_batched,
+      const bool rhs_batched,
+      Tensor *output) override;
+
+  MaceStatus ComputeWithEpilogue(const OpContext *context,
+                                 const Tensor *lhs,
+                                 const Tensor *rhs,
+                                 const index_t rows,
+                                 const index_t cols,
+                                 const index_t depth,
+                                 const MatrixMajor lhs_major,
+                                 const MatrixMajor rhs_major,
+                                 const GemmEpilogue &epilogue,
+                                 Tensor *output) override;
+
+ private:
+  MaceStatus ComputeImpl(const OpContext *context,
+                         const Tensor *lhs,
+                         const Tensor *rhs,
+                         const index_t batch,
+                         const index_t rows,
+                         const index_t cols,
+                         const index_t depth,
+                         const MatrixMajor lhs_major,
+                         const MatrixMajor rhs_major,
+                         const MatrixMajor output_major,
+                         const bool lhs_batched,
+                         const bool rhs_batched,
+                         const GemmEpilogue *epilogue,
+                         Tensor *output);
+
+  // Row-major rows of depth_padded values, padded with zero rows
+  void PackLhs(const OpContext *context,
+               const MatrixMap<const BFloat16> &lhs,
+               const index_t depth_padded,
+               uint16_t *packed_lhs);
+
+  // Panels of 16 columns, each is depth_padded / 2 rows of 16 pairs of
+  // successive depth values, the layout of an AMX B tile
+  void PackRhs(const OpContext *context,
+               const MatrixMap<const BFloat16> &rhs,
+               const index_t depth_padded,
+               uint16_t *packed_rhs);
+
+  std::unique_ptr<Buffer> pack_cache_;
+  const bool should_cache_pack_;
+  const bool use_amx_;
+  int cached_;
+};
+
+}  // namespace bf16
+}  // namespace x86
+}  // namespace ops
+}  // namespace mace
+
+#endif  // MACE_OPS_X86_BF16_GEMM_H_
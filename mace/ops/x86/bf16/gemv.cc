@@ -0,0 +1,165 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/ops/x86/bf16/gemv.h"
+
+#include <immintrin.h>
+
+#include "mace/core/runtime/runtime.h"
+#include "mace/ops/x86/base/cpu_features.h"
+#include "mace/utils/math.h"
+
+namespace mace {
+namespace ops {
+namespace x86 {
+namespace bf16 {
+
+namespace {
+const index_t kRowBlockSize = 4;
+
+// Sums the 16 lanes. The extract intrinsics used by _mm512_reduce_add_ps
+// trip -Wuninitialized in the gcc 12 headers, so the lanes go through memory.
+__attribute__((target("avx512f")))
+inline float ReduceAdd(const __m512 v) {
+  alignas(64) float lanes[16];
+  _mm512_store_ps(lanes, v);
+  __m128 sum4 = _mm_add_ps(_mm_add_ps(_mm_load_ps(lanes),
+                                      _mm_load_ps(lanes + 4)),
+                           _mm_add_ps(_mm_load_ps(lanes + 8),
+                                      _mm_load_ps(lanes + 12)));
+  sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+  sum4 = _mm_add_ss(sum4, _mm_movehdup_ps(sum4));
+  return _mm_cvtss_f32(sum4);
+}
+
+// Dot products of 4 rows with the same vector, 32 bfloat16 values per step
+__attribute__((target("avx512f,avx512bf16")))
+void DotRows4(const BFloat16 *lhs, const index_t lhs_width,
+              const BFloat16 *rhs, float *sums) {
+  const BFloat16 *lhs0 = lhs;
+  const BFloat16 *lhs1 = lhs0 + lhs_width;
+  const BFloat16 *lhs2 = lhs1 + lhs_width;
+  const BFloat16 *lhs3 = lhs2 + lhs_width;
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  __m512 acc2 = _mm512_setzero_ps();
+  __m512 acc3 = _mm512_setzero_ps();
+  index_t w = 0;
+  for (; w + 32 <= lhs_width; w += 32) {
+    const __m512bh b = (__m512bh)_mm512_loadu_si512(rhs + w);
+    acc0 = _mm512_dpbf16_ps(acc0, (__m512bh)_mm512_loadu_si512(lhs0 + w), b);
+    acc1 = _mm512_dpbf16_ps(acc1, (__m512bh)_mm512_loadu_si512(lhs1 + w), b);
+    acc2 = _mm512_dpbf16_ps(acc2, (__m512bh)_mm512_loadu_si512(lhs2 + w), b);
+    acc3 = _mm512_dpbf16_ps(acc3, (__m512bh)_mm512_loadu_si512(lhs3 + w), b);
+  }
+  sums[0] = ReduceAdd(acc0);
+  sums[1] = ReduceAdd(acc1);
+  sums[2] = ReduceAdd(acc2);
+  sums[3] = ReduceAdd(acc3);
+  for (; w < lhs_width; ++w) {
+    const float rhs_value = rhs[w];
+    sums[0] += lhs0[w] * rhs_value;
+    sums[1] += lhs1[w] * rhs_value;
+    sums[2] += lhs2[w] * rhs_value;
+    sums[3] += lhs3[w] * rhs_value;
+  }
+}
+
+__attribute__((target("avx512f,avx512bf16")))
+float DotRow(const BFloat16 *lhs, const index_t lhs_width,
+             const BFloat16 *rhs) {
+  __m512 acc = _mm512_setzero_ps();
+  index_t w = 0;
+  for (; w + 32 <= lhs_width; w += 32) {
+    acc = _mm512_dpbf16_ps(acc, (__m512bh)_mm512_loadu_si512(lhs + w),
+                           (__m512bh)_mm512_loadu_si512(rhs + w));
+  }
+  float sum = ReduceAdd(acc);
+  for (; w < lhs_width; ++w) {
+    sum += lhs[w] * rhs[w];
+  }
+  return sum;
+}
+}  // namespace
+
+MaceStatus Gemv::Compute(const OpContext *context,
+                         const Tensor *lhs,
+                         const Tensor *rhs,
+                         const Tensor *bias,
+                         const index_t batch,
+                         const index_t lhs_height,
+                         const index_t lhs_width,
+                         const bool lhs_batched,
+                         const bool rhs_batched,
+                         Tensor *output) {
+  const BFloat16 *lhs_data = lhs->data<BFloat16>();
+  const BFloat16 *rhs_data = rhs->data<BFloat16>();
+  const BFloat16 *bias_data = nullptr;
+  if (bias) {
+    bias_data = bias->data<BFloat16>();
+  }
+  BFloat16 *output_data = output->mutable_data<BFloat16>();
+
+  const index_t row_block_count = RoundUpDiv(lhs_height, kRowBlockSize);
+  utils::ThreadPool
+      &thread_pool = context->runtime()->thread_pool();
+  thread_pool.Compute2D([=](index_t start0, index_t end0, index_t step0,
+                            index_t start1, index_t end1, index_t step1) {
+    for (index_t b = start0; b < end0; b += step0) {
+      const BFloat16 *lhs_base = lhs_data
+          + static_cast<index_t>(lhs_batched) * b * lhs_height * lhs_width;
+      const BFloat16 *rhs_base =
+          rhs_data + static_cast<index_t>(rhs_batched) * b * lhs_width;
+      BFloat16 *output_base = output_data + b * lhs_height;
+      for (index_t row_block_idx = start1; row_block_idx < end1;
+           row_block_idx += step1) {
+        const index_t h_start = row_block_idx * kRowBlockSize;
+        float sums[kRowBlockSize];
+        index_t h_count = kRowBlockSize;
+        if (h_start + kRowBlockSize <= lhs_height) {
+          DotRows4(lhs_base + h_start * lhs_width, lhs_width, rhs_base, sums);
+        } else {
+          h_count = lhs_height - h_start;
+          for (index_t h = 0; h < h_count; ++h) {
+            sums[h] = DotRow(lhs_base + (h_start + h) * lhs_width,
+                             lhs_width, rhs_base);
+          }
+        }
+        for (index_t h = 0; h < h_count; ++h) {
+          float sum = sums[h];
+          if (bias_data != nullptr) {
+            sum += bias_data[h_start + h];
+          }
+          output_base[h_start + h] = sum;
+        }
+      }  // row_block_idx
+    }  // b
+  }, 0, batch, 1, 0, row_block_count, 1);
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
+void RegisterGemvDelegator(OpDelegatorRegistry *registry) {
+  if (!GetCpuFeatures().avx512bf16) {
+    return;
+  }
+  MACE_REGISTER_BF16_DELEGATOR(
+      registry, Gemv, DelegatorParam,
+      MACE_DELEGATOR_KEY(Gemv, RuntimeType::RT_CPU, BFloat16, ImplType::X86));
+}
+
+}  // namespace bf16
+}  // namespace x86
+}  // namespace ops
+}  // namespace mace
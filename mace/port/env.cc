@@ -34,6 +34,27 @@ MaceStatus Env::SchedSetAffinity(const std::vector<size_t> &cpu_ids) {
   return MaceStatus::MACE_UNSUPPORTED;
 }
 
+MaceStatus Env::SchedSetNUMAAffinity(const std::vector<size_t> &cpu_ids) {
+  return SchedSetAffinity(cpu_ids);
+}
+
+MaceStatus Env::GetNUMANodeCPUs(int numa_node, std::vector<size_t> *cpu_ids) {
+  return MaceStatus::MACE_UNSUPPORTED;
+}
+
+MaceStatus Env::GetCPUTopology(CPUTopology *topology) {
+  return MaceStatus::MACE_UNSUPPORTED;
+}
+
+MaceStatus Env::MapPages(size_t length, CPUMemoryPolicy policy,
+                         int numa_node, void **result) {
+  return MaceStatus::MACE_UNSUPPORTED;
+}
+
+MaceStatus Env::UnmapPages(void *addr, size_t length) {
+  return MaceStatus::MACE_UNSUPPORTED;
+}
+
 std::unique_ptr<MallocLogger> Env::NewMallocLogger(
       std::ostringstream *oss,
       const std::string &name) {
@@ -15,14 +15,20 @@
 #include "mace/port/linux_base/env.h"
 
 #include <errno.h>
+#include <sys/stat.h>
 #include <sys/syscall.h>
 #include <sys/time.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cctype>
 #include <cstddef>
 #include <fstream>
+#include <iterator>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "mace/port/posix/file_system.h"
@@ -34,6 +40,12 @@ namespace port {
 
 namespace {
 
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+#ifdef SYS_mbind
+// MPOL_PREFERRED in linux/mempolicy.h, which some toolchains don't ship.
+constexpr int kMpolPreferred = 1;
+#endif
+
 int GetCPUCount() {
   int cpu_count = 0;
   std::string cpu_sys_conf = "/proc/cpuinfo";
@@ -61,6 +73,192 @@ int GetCPUCount() {
   return cpu_count;
 }
 
+bool ReadFirstLine(const std::string &path, std::string *line) {
+  std::ifstream f(path);
+  if (!f.is_open()) {
+    return false;
+  }
+  std::getline(f, *line);
+  return !f.bad();
+}
+
+// The list looks like "0-7,16-23"
+std::vector<size_t> ParseCPUList(const std::string &list) {
+  std::vector<size_t> cpu_ids;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || !isdigit(range[0])) {
+      continue;
+    }
+    char *end = nullptr;
+    size_t first = strtoul(range.c_str(), &end, 10);
+    size_t last = first;
+    if (*end == '-') {
+      last = strtoul(end + 1, nullptr, 10);
+    }
+    for (size_t cpu_id = first; cpu_id <= last; ++cpu_id) {
+      cpu_ids.push_back(cpu_id);
+    }
+  }
+  return cpu_ids;
+}
+
+// Returns the directories of the cgroup of the process, from its own up to
+// the root of the hierarchy, in the v1 hierarchy of `controller` or in the
+// v2 one if `controller` is empty.
+std::vector<std::string> GetCgroupDirs(const std::string &controller) {
+  std::ifstream f("/proc/self/cgroup");
+  std::string line;
+  while (std::getline(f, line)) {
+    // The lines look like "4:cpu,cpuacct:/docker/1a2b" or "0::/user.slice"
+    const size_t first = line.find(':');
+    const size_t second = line.find(':', first + 1);
+    if (first == std::string::npos || second == std::string::npos) {
+      continue;
+    }
+    const std::string controllers =
+        line.substr(first + 1, second - first - 1);
+    if (controller.empty() != controllers.empty() ||
+        (!controller.empty() &&
+            ("," + controllers + ",").find("," + controller + ",") ==
+                std::string::npos)) {
+      continue;
+    }
+    const std::string root = controller.empty() ?
+                             "/sys/fs/cgroup" : "/sys/fs/cgroup/" + controllers;
+    std::string dir = root + line.substr(second + 1);
+    while (dir.size() > root.size() && dir.back() == '/') {
+      dir.pop_back();
+    }
+    // Without a cgroup namespace the path is the one on the host, while a
+    // container sees its own cgroup at the root.
+    struct stat st;
+    if (stat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+      dir = root;
+    }
+    std::vector<std::string> dirs;
+    while (true) {
+      dirs.push_back(dir);
+      if (dir.size() <= root.size()) {
+        break;
+      }
+      dir = dir.substr(0, dir.rfind('/'));
+    }
+    return dirs;
+  }
+  return {};
+}
+
+// The CPUs of the cpuset of the process, empty if not limited by a cgroup.
+std::vector<size_t> GetCgroupCPUs() {
+  const std::vector<std::pair<std::string, std::vector<std::string>>> files = {
+      {"", {"cpuset.cpus.effective"}},
+      {"cpuset", {"cpuset.effective_cpus", "cpuset.cpus"}}};
+  for (const auto &controller_files : files) {
+    for (const auto &dir : GetCgroupDirs(controller_files.first)) {
+      for (const auto &file : controller_files.second) {
+        std::string line;
+        if (ReadFirstLine(dir + "/" + file, &line)) {
+          std::vector<size_t> cpu_ids = ParseCPUList(line);
+          if (!cpu_ids.empty()) {
+            return cpu_ids;
+          }
+        }
+      }
+    }
+  }
+  return {};
+}
+
+// The CFS quota of the process in CPUs, the smallest one of its cgroup and
+// the ancestors, or 0 if there is none.
+float GetCgroupCPUQuota() {
+  float cpu_quota = 0;
+  auto limit = [&cpu_quota](float quota_us, float period_us) {
+    if (quota_us > 0 && period_us > 0) {
+      const float quota = quota_us / period_us;
+      cpu_quota = cpu_quota == 0 ? quota : std::min(cpu_quota, quota);
+    }
+  };
+  for (const auto &dir : GetCgroupDirs("")) {
+    // The line looks like "max 100000" or "200000 100000"
+    std::string line;
+    if (ReadFirstLine(dir + "/cpu.max", &line) && isdigit(line[0])) {
+      char *end = nullptr;
+      const float quota_us = strtof(line.c_str(), &end);
+      limit(quota_us, strtof(end, nullptr));
+    }
+  }
+  if (cpu_quota > 0) {
+    return cpu_quota;
+  }
+  for (const auto &dir : GetCgroupDirs("cpu")) {
+    std::string quota_us;
+    std::string period_us;
+    if (ReadFirstLine(dir + "/cpu.cfs_quota_us", &quota_us) &&
+        ReadFirstLine(dir + "/cpu.cfs_period_us", &period_us)) {
+      limit(strtof(quota_us.c_str(), nullptr),
+            strtof(period_us.c_str(), nullptr));
+    }
+  }
+  return cpu_quota;
+}
+
+// The first CPU of the list in `path` identifies the CPUs sharing a
+// resource, -1 if it is unknown.
+int GetSharingCPU(const std::string &path) {
+  std::string line;
+  if (!ReadFirstLine(path, &line)) {
+    return -1;
+  }
+  const std::vector<size_t> cpu_ids = ParseCPUList(line);
+  return cpu_ids.empty() ? -1 : static_cast<int>(cpu_ids[0]);
+}
+
+int GetLLCId(size_t cpu_id) {
+  int llc_id = -1;
+  int llc_level = 0;
+  for (int index = 0;; ++index) {
+    const std::string cache_dir = MakeString(
+        "/sys/devices/system/cpu/cpu", cpu_id, "/cache/index", index);
+    std::string level;
+    if (!ReadFirstLine(cache_dir + "/level", &level)) {
+      break;
+    }
+    std::string type;
+    if (ReadFirstLine(cache_dir + "/type", &type) && type == "Instruction") {
+      continue;
+    }
+    const int cache_level = atoi(level.c_str());
+    const int sharing_cpu = GetSharingCPU(cache_dir + "/shared_cpu_list");
+    if (cache_level > llc_level && sharing_cpu >= 0) {
+      llc_level = cache_level;
+      llc_id = sharing_cpu;
+    }
+  }
+  return llc_id;
+}
+
+MaceStatus SetThreadAffinity(const std::vector<size_t> &cpu_ids) {
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (auto cpu_id : cpu_ids) {
+    CPU_SET(cpu_id, &mask);
+  }
+
+  pid_t pid = syscall(SYS_gettid);
+  int err = sched_setaffinity(pid, sizeof(mask), &mask);
+  if (err) {
+    LOG(WARNING) << "SchedSetAffinity failed: " << strerror(errno);
+    return MaceStatus(MaceStatus::MACE_INVALID_ARGS,
+                      "SchedSetAffinity failed: " +
+                          std::string(strerror(errno)));
+  }
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
 }  // namespace
 
 int64_t LinuxBaseEnv::NowMicros() {
@@ -104,21 +302,184 @@ MaceStatus LinuxBaseEnv::GetCPUMaxFreq(std::vector<float> *max_freqs) {
 }
 
 MaceStatus LinuxBaseEnv::SchedSetAffinity(const std::vector<size_t> &cpu_ids) {
-  cpu_set_t mask;
-  CPU_ZERO(&mask);
+  return SetThreadAffinity(cpu_ids);
+}
+
+MaceStatus LinuxBaseEnv::SchedSetNUMAAffinity(
+    const std::vector<size_t> &cpu_ids) {
+  return SetThreadAffinity(cpu_ids);
+}
+
+MaceStatus LinuxBaseEnv::GetNUMANodeCPUs(int numa_node,
+                                         std::vector<size_t> *cpu_ids) {
+  MACE_CHECK_NOTNULL(cpu_ids);
+  std::string cpulist_sys_conf = MakeString(
+      "/sys/devices/system/node/node", numa_node, "/cpulist");
+  std::string line;
+  if (!ReadFirstLine(cpulist_sys_conf, &line)) {
+    LOG(WARNING) << "failed to open " << cpulist_sys_conf;
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  *cpu_ids = ParseCPUList(line);
+  if (cpu_ids->empty()) {
+    LOG(WARNING) << "NUMA node " << numa_node << " has no CPU";
+    return MaceStatus::MACE_INVALID_ARGS;
+  }
+  VLOG(1) << "NUMA node " << numa_node << " CPUs: " << MakeString(*cpu_ids);
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
+MaceStatus LinuxBaseEnv::GetCPUTopology(CPUTopology *topology) {
+  MACE_CHECK_NOTNULL(topology);
+  // The affinity of the process is not used, as it is changed by the thread
+  // pools themselves
+  std::vector<size_t> cpu_ids;
+  std::string line;
+  if (ReadFirstLine("/sys/devices/system/cpu/online", &line)) {
+    cpu_ids = ParseCPUList(line);
+  }
+  if (cpu_ids.empty()) {
+    const int cpu_count = GetCPUCount();
+    if (cpu_count <= 0) {
+      return MaceStatus::MACE_RUNTIME_ERROR;
+    }
+    for (int cpu_id = 0; cpu_id < cpu_count; ++cpu_id) {
+      cpu_ids.push_back(static_cast<size_t>(cpu_id));
+    }
+  }
+  const std::vector<size_t> cgroup_cpu_ids = GetCgroupCPUs();
+  if (!cgroup_cpu_ids.empty()) {
+    std::vector<size_t> allowed_cpu_ids;
+    std::set_intersection(cpu_ids.begin(), cpu_ids.end(),
+                          cgroup_cpu_ids.begin(), cgroup_cpu_ids.end(),
+                          std::back_inserter(allowed_cpu_ids));
+    cpu_ids.swap(allowed_cpu_ids);
+  }
+  if (cpu_ids.empty()) {
+    LOG(WARNING) << "No CPU is allowed by the cpuset";
+    return MaceStatus::MACE_RUNTIME_ERROR;
+  }
+
+  std::vector<int> numa_nodes;
+  if (ReadFirstLine("/sys/devices/system/node/online", &line)) {
+    for (auto node : ParseCPUList(line)) {
+      numa_nodes.push_back(static_cast<int>(node));
+    }
+  }
+  std::vector<std::vector<size_t>> numa_cpu_ids(numa_nodes.size());
+  for (size_t i = 0; i < numa_nodes.size(); ++i) {
+    if (ReadFirstLine(MakeString("/sys/devices/system/node/node",
+                                 numa_nodes[i], "/cpulist"), &line)) {
+      numa_cpu_ids[i] = ParseCPUList(line);
+    }
+  }
+
+  topology->cpus.clear();
   for (auto cpu_id : cpu_ids) {
-    CPU_SET(cpu_id, &mask);
+    CPUInfo cpu;
+    cpu.cpu_id = cpu_id;
+    // CPUs without topology info are taken as separate cores on one node
+    cpu.core_id = GetSharingCPU(MakeString(
+        "/sys/devices/system/cpu/cpu", cpu_id,
+        "/topology/thread_siblings_list"));
+    if (cpu.core_id < 0) {
+      cpu.core_id = static_cast<int>(cpu_id);
+    }
+    cpu.llc_id = std::max(GetLLCId(cpu_id), 0);
+    cpu.numa_node = 0;
+    for (size_t i = 0; i < numa_nodes.size(); ++i) {
+      if (std::find(numa_cpu_ids[i].begin(), numa_cpu_ids[i].end(), cpu_id)
+          != numa_cpu_ids[i].end()) {
+        cpu.numa_node = numa_nodes[i];
+        break;
+      }
+    }
+    topology->cpus.push_back(cpu);
   }
+  topology->cpu_quota = GetCgroupCPUQuota();
 
-  pid_t pid = syscall(SYS_gettid);
-  int err = sched_setaffinity(pid, sizeof(mask), &mask);
-  if (err) {
-    LOG(WARNING) << "SchedSetAffinity failed: " << strerror(errno);
-    return MaceStatus(MaceStatus::MACE_INVALID_ARGS,
-                      "SchedSetAffinity failed: " +
-                          std::string(strerror(errno)));
+  VLOG(1) << "Allowed CPUs: " << MakeString(cpu_ids)
+          << ", CPU quota: " << topology->cpu_quota;
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
+MaceStatus LinuxBaseEnv::MapPages(size_t length, CPUMemoryPolicy policy,
+                                  int numa_node, void **result) {
+  MACE_CHECK_NOTNULL(result);
+  const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  length = (length + page_size - 1) & (~(page_size - 1));
+
+  void *addr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (policy == CPUMemoryPolicy::CPU_MEMORY_EXPLICIT_HUGE_PAGE &&
+      length % kHugePageSize == 0) {
+    addr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr == MAP_FAILED) {
+      VLOG(1) << "Explicit huge pages unavailable: " << strerror(errno);
+    }
+  }
+#endif
+  if (addr == MAP_FAILED) {
+    // Over-map by one huge page and trim both ends, so that the region is
+    // huge page aligned and can be backed by transparent huge pages.
+    const size_t padded_length = length + kHugePageSize;
+    void *padded = mmap(nullptr, padded_length, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (padded == MAP_FAILED) {
+      LOG(WARNING) << "Map pages failed: " << strerror(errno);
+      return MaceStatus::MACE_OUT_OF_RESOURCES;
+    }
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(padded);
+    const uintptr_t aligned =
+        (begin + kHugePageSize - 1) & (~(kHugePageSize - 1));
+    const size_t head = aligned - begin;
+    const size_t tail = padded_length - head - length;
+    if (head > 0) {
+      munmap(padded, head);
+    }
+    if (tail > 0) {
+      munmap(reinterpret_cast<void *>(aligned + length), tail);
+    }
+    addr = reinterpret_cast<void *>(aligned);
+#ifdef MADV_HUGEPAGE
+    if (policy != CPUMemoryPolicy::CPU_MEMORY_DEFAULT &&
+        madvise(addr, length, MADV_HUGEPAGE) != 0) {
+      VLOG(1) << "Advise huge page failed: " << strerror(errno);
+    }
+#endif
   }
 
+#ifdef SYS_mbind
+  if (numa_node >= 0) {
+    // Prefer (rather than require) the node, so that the allocation can
+    // still succeed when the node is out of memory. If mbind is not
+    // permitted, the first touch from the bound threads places the pages.
+    const size_t bits_per_long = sizeof(unsigned long) * 8;  // NOLINT
+    std::vector<unsigned long> nodemask(  // NOLINT(runtime/int)
+        numa_node / bits_per_long + 1, 0);
+    nodemask[numa_node / bits_per_long] |= 1UL << (numa_node % bits_per_long);
+    if (syscall(SYS_mbind, addr, length, kMpolPreferred, nodemask.data(),
+                nodemask.size() * bits_per_long + 1, 0) != 0) {
+      VLOG(1) << "Bind memory to NUMA node " << numa_node
+              << " failed: " << strerror(errno);
+    }
+  }
+#else
+  MACE_UNUSED(numa_node);
+#endif
+
+  *result = addr;
+  return MaceStatus::MACE_SUCCESS;
+}
+
+MaceStatus LinuxBaseEnv::UnmapPages(void *addr, size_t length) {
+  if (munmap(addr, length) != 0) {
+    LOG(ERROR) << "Unmap pages failed: " << strerror(errno);
+    return MaceStatus::MACE_RUNTIME_ERROR;
+  }
   return MaceStatus::MACE_SUCCESS;
 }
 
@@ -30,6 +30,14 @@ class LinuxBaseEnv : public Env {
   MaceStatus GetCPUMaxFreq(std::vector<float> *max_freqs) override;
   FileSystem *GetFileSystem() override;
   MaceStatus SchedSetAffinity(const std::vector<size_t> &cpu_ids) override;
+  MaceStatus SchedSetNUMAAffinity(
+      const std::vector<size_t> &cpu_ids) override;
+  MaceStatus GetNUMANodeCPUs(int numa_node,
+                             std::vector<size_t> *cpu_ids) override;
+  MaceStatus GetCPUTopology(CPUTopology *topology) override;
+  MaceStatus MapPages(size_t length, CPUMemoryPolicy policy,
+                      int numa_node, void **result) override;
+  MaceStatus UnmapPages(void *addr, size_t length) override;
 
  protected:
   PosixFileSystem posix_file_system_;
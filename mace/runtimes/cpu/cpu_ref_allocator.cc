@@ -14,11 +14,30 @@
 
 #include "mace/runtimes/cpu/cpu_ref_allocator.h"
 
+#include <algorithm>
+
 #include "mace/core/runtime_failure_mock.h"
+#include "mace/port/env.h"
 #include "mace/utils/logging.h"
+#include "mace/utils/math.h"
 
 namespace mace {
 
+CpuRefAllocator::CpuRefAllocator()
+    : policy_(CPUMemoryPolicy::CPU_MEMORY_DEFAULT), numa_node_(-1) {}
+
+CpuRefAllocator::~CpuRefAllocator() {
+  if (!mapped_buffers_.empty()) {
+    LOG(WARNING) << mapped_buffers_.size() << " mapped CPU buffers leaked";
+  }
+}
+
+void CpuRefAllocator::SetMemoryPolicy(CPUMemoryPolicy policy,
+                                      int numa_node) {
+  policy_ = policy;
+  numa_node_ = numa_node;
+}
+
 MemoryType CpuRefAllocator::GetMemType() {
   return MemoryType::CPU_BUFFER;
 }
@@ -34,7 +53,26 @@ MaceStatus CpuRefAllocator::New(const MemInfo &info, void **result) {
     return MaceStatus::MACE_OUT_OF_RESOURCES;
   }
 
-  MACE_RETURN_IF_ERROR(Memalign(result, kMaceAlignment, nbytes));
+  const bool map_pages =
+      policy_ != CPUMemoryPolicy::CPU_MEMORY_DEFAULT || numa_node_ >= 0;
+  if (map_pages && static_cast<size_t>(nbytes) >= kCpuHugePageSize) {
+    size_t length = static_cast<size_t>(nbytes);
+    if (policy_ == CPUMemoryPolicy::CPU_MEMORY_EXPLICIT_HUGE_PAGE) {
+      length = RoundUp(length, kCpuHugePageSize);
+    }
+    if (MapPages(length, policy_, numa_node_, result)
+        == MaceStatus::MACE_SUCCESS) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      mapped_buffers_[*result] = length;
+      return MaceStatus::MACE_SUCCESS;
+    }
+    VLOG(1) << "Map pages failed, fall back to heap allocation";
+  }
+
+  const size_t alignment = policy_ == CPUMemoryPolicy::CPU_MEMORY_DEFAULT ?
+                           kMaceAlignment :
+                           std::max(kMaceAlignment, kCpuCacheLineSize);
+  MACE_RETURN_IF_ERROR(Memalign(result, alignment, nbytes));
 
   return MaceStatus::MACE_SUCCESS;
 }
@@ -42,6 +80,15 @@ MaceStatus CpuRefAllocator::New(const MemInfo &info, void **result) {
 void CpuRefAllocator::Delete(void *data) {
   MACE_CHECK_NOTNULL(data);
   VLOG(3) << "Free CPU buffer";
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = mapped_buffers_.find(data);
+    if (iter != mapped_buffers_.end()) {
+      UnmapPages(data, iter->second);
+      mapped_buffers_.erase(iter);
+      return;
+    }
+  }
   free(data);
 }
 
@@ -15,17 +15,36 @@
 #ifndef MACE_RUNTIMES_CPU_CPU_REF_ALLOCATOR_H_
 #define MACE_RUNTIMES_CPU_CPU_REF_ALLOCATOR_H_
 
+#include <mutex>  // NOLINT(build/c++11)
+#include <unordered_map>
+
 #include "mace/core/memory/allocator.h"
 
 namespace mace {
+
+// Buffers at least this large are mapped page by page, so that they can be
+// backed by huge pages and bound to a NUMA node.
+constexpr size_t kCpuHugePageSize = 2 * 1024 * 1024;
+constexpr size_t kCpuCacheLineSize = 64;
+
 class CpuRefAllocator : public Allocator {
  public:
-  CpuRefAllocator() {}
-  ~CpuRefAllocator() {}
+  CpuRefAllocator();
+  ~CpuRefAllocator();
+
+  // Only affects the buffers allocated afterwards.
+  void SetMemoryPolicy(CPUMemoryPolicy policy, int numa_node);
 
   MemoryType GetMemType() override;
   MaceStatus New(const MemInfo &info, void **result) override;
   void Delete(void *data) override;
+
+ private:
+  CPUMemoryPolicy policy_;
+  int numa_node_;
+  std::mutex mutex_;
+  // mapped buffer -> mapped length
+  std::unordered_map<void *, size_t> mapped_buffers_;
 };
 
 }  // namespace mace
@@ -18,6 +18,7 @@
 
 #include "mace/core/memory/buffer.h"
 #include "mace/core/runtime/runtime_registry.h"
+#include "mace/utils/mace_engine_config.h"
 #include "mace/utils/memory.h"
 
 namespace mace {
@@ -26,12 +27,20 @@ CpuRefRuntime::CpuRefRuntime(RuntimeContext *runtime_context)
     : CpuRuntime(runtime_context),
       buffer_allocator_(make_unique<CpuRefAllocator>()),
       buffer_manager_(
-          make_unique<GeneralMemoryManager>(buffer_allocator_.get())) {}
+          make_unique<GeneralMemoryManager>(buffer_allocator_.get(), true)) {}
 
 CpuRefRuntime::~CpuRefRuntime() {
   VLOG(1) << "Destroy CpuRefRuntime";
 }
 
+MaceStatus CpuRefRuntime::Init(const MaceEngineCfgImpl *engine_config,
+                               const MemoryType mem_type) {
+  MACE_RETURN_IF_ERROR(CpuRuntime::Init(engine_config, mem_type));
+  buffer_allocator_->SetMemoryPolicy(engine_config->cpu_memory_policy(),
+                                     engine_config->numa_node());
+  return MaceStatus::MACE_SUCCESS;
+}
+
 MemoryManager *CpuRefRuntime::GetMemoryManager(MemoryType mem_type) {
   MemoryManager *buffer_manager = nullptr;
   if (mem_type == MemoryType::CPU_BUFFER) {
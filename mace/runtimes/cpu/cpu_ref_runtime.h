@@ -28,6 +28,9 @@ class CpuRefRuntime : public CpuRuntime {
   explicit CpuRefRuntime(RuntimeContext *runtime_context);
   ~CpuRefRuntime();
 
+  MaceStatus Init(const MaceEngineCfgImpl *engine_config,
+                  const MemoryType mem_type) override;
+
  protected:
   MemoryManager *GetMemoryManager(MemoryType mem_type) override;
 
@@ -32,7 +32,8 @@ MaceStatus CpuRuntime::Init(const MaceEngineCfgImpl *engine_config,
   MACE_CHECK_NOTNULL(GetGemmlowpContext());
 #endif  // MACE_ENABLE_QUANTIZE
   SetThreadsHintAndAffinityPolicy(engine_config->num_threads(),
-                                  engine_config->cpu_affinity_policy());
+                                  engine_config->cpu_affinity_policy(),
+                                  engine_config->numa_node());
 
   return MaceStatus::MACE_SUCCESS;
 }
@@ -70,17 +71,32 @@ DataType CpuRuntime::GetComputeDataType(const NetDef &net_def,
 }
 
 MaceStatus CpuRuntime::SetThreadsHintAndAffinityPolicy(
-    int num_threads_hint, CPUAffinityPolicy policy) {
+    int num_threads_hint, CPUAffinityPolicy policy, int numa_node) {
+  std::vector<size_t> numa_cpus;
+  if (numa_node >= 0 &&
+      GetNUMANodeCPUs(numa_node, &numa_cpus) != MaceStatus::MACE_SUCCESS) {
+    numa_cpus.clear();
+  }
+
+  port::CPUTopology topology;
+  if (GetCPUTopology(&topology) != MaceStatus::MACE_SUCCESS) {
+    topology.cpus.clear();
+  }
+
   // get cpu frequency info
   std::vector<float> cpu_max_freqs;
-  MACE_RETURN_IF_ERROR(GetCPUMaxFreq(&cpu_max_freqs));
-  if (cpu_max_freqs.empty()) {
-    return MaceStatus::MACE_RUNTIME_ERROR;
+  MaceStatus freq_status = GetCPUMaxFreq(&cpu_max_freqs);
+  if (numa_cpus.empty() && topology.cpus.empty()) {
+    MACE_RETURN_IF_ERROR(freq_status);
+    if (cpu_max_freqs.empty()) {
+      return MaceStatus::MACE_RUNTIME_ERROR;
+    }
   }
   std::vector<size_t> cores_to_use;
   MACE_RETURN_IF_ERROR(
-      mace::utils::GetCPUCoresToUse(
-          cpu_max_freqs, policy, &num_threads_hint, &cores_to_use));
+      mace::utils::GetCPUCoresToUse(cpu_max_freqs, topology, policy,
+                                    numa_cpus, &num_threads_hint,
+                                    &cores_to_use));
 
 #ifdef MACE_ENABLE_QUANTIZE
   if (gemm_context_ != nullptr) {
@@ -89,7 +105,17 @@ MaceStatus CpuRuntime::SetThreadsHintAndAffinityPolicy(
 #endif  // MACE_ENABLE_QUANTIZE
 
   MaceStatus status = MaceStatus::MACE_SUCCESS;
-  if (policy != CPUAffinityPolicy::AFFINITY_NONE) {
+  if (mace::utils::IsTopologyAffinityPolicy(policy) &&
+      !cores_to_use.empty()) {
+    // The calling thread is thread 0 of the pool, which has its own core
+    auto thread_cores = mace::utils::GetThreadCores(cores_to_use, policy,
+                                                    num_threads_hint);
+    status = SchedSetNUMAAffinity(thread_cores[0]);
+    VLOG(1) << "Set topology affinity : " << MakeString(thread_cores[0]);
+  } else if (!numa_cpus.empty()) {
+    status = SchedSetNUMAAffinity(cores_to_use);
+    VLOG(1) << "Set NUMA affinity : " << MakeString(cores_to_use);
+  } else if (policy != CPUAffinityPolicy::AFFINITY_NONE) {
     if (!cores_to_use.empty()) {
       status = SchedSetAffinity(cores_to_use);
       VLOG(1) << "Set affinity : " << MakeString(cores_to_use);
@@ -51,7 +51,8 @@ class CpuRuntime : public Runtime {
 
  private:
   MaceStatus SetThreadsHintAndAffinityPolicy(int num_threads_hint,
-                                             CPUAffinityPolicy policy);
+                                             CPUAffinityPolicy policy,
+                                             int numa_node);
 
  private:
 #ifdef MACE_ENABLE_QUANTIZE
@@ -101,12 +101,12 @@ class QuantizeTransformer<RuntimeType::RT_OPENCL> : public BaseTransformer {
     cl::Event event;
     cl_int error;
     if (executor->IsNonUniformWorkgroupsSupported()) {
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           kernel_, cl::NullRange, cl::NDRange(gws), cl::NDRange(lws), nullptr,
           &event);
     } else {
       uint32_t roundup_gws = RoundUp(gws, lws);
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           kernel_, cl::NullRange, cl::NDRange(roundup_gws), cl::NDRange(lws),
           nullptr, &event);
     }
@@ -187,12 +187,12 @@ class DequantizeTransformer<RuntimeType::RT_OPENCL> : public BaseTransformer {
     cl::Event event;
     cl_int error;
     if (executor->IsNonUniformWorkgroupsSupported()) {
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           kernel_, cl::NullRange, cl::NDRange(gws), cl::NDRange(lws), nullptr,
           &event);
     } else {
       uint32_t roundup_gws = RoundUp(gws, lws);
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           kernel_, cl::NullRange, cl::NDRange(roundup_gws), cl::NDRange(lws),
           nullptr, &event);
     }
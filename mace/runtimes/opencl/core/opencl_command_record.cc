@@ -0,0 +1,176 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/runtimes/opencl/core/opencl_command_record.h"
+
+#include "mace/runtimes/opencl/core/opencl_executor.h"
+#include "mace/utils/logging.h"
+
+namespace mace {
+
+namespace {
+const size_t *NDRangeOrNull(const cl::NDRange &range) {
+  if (range.dimensions() == 0) {
+    return nullptr;
+  }
+  return static_cast<const size_t *>(range);
+}
+}  // namespace
+
+OpenclCommandBufferFuncs::OpenclCommandBufferFuncs()
+    : create(nullptr),
+      finalize(nullptr),
+      release(nullptr),
+      enqueue(nullptr),
+      ndrange_kernel(nullptr) {}
+
+void OpenclCommandBufferFuncs::Load(cl_platform_id platform) {
+  create = reinterpret_cast<clCreateCommandBufferKHR_fn>(
+      clGetExtensionFunctionAddressForPlatform(
+          platform, "clCreateCommandBufferKHR"));
+  finalize = reinterpret_cast<clFinalizeCommandBufferKHR_fn>(
+      clGetExtensionFunctionAddressForPlatform(
+          platform, "clFinalizeCommandBufferKHR"));
+  release = reinterpret_cast<clReleaseCommandBufferKHR_fn>(
+      clGetExtensionFunctionAddressForPlatform(
+          platform, "clReleaseCommandBufferKHR"));
+  enqueue = reinterpret_cast<clEnqueueCommandBufferKHR_fn>(
+      clGetExtensionFunctionAddressForPlatform(
+          platform, "clEnqueueCommandBufferKHR"));
+  ndrange_kernel = reinterpret_cast<clCommandNDRangeKernelKHR_fn>(
+      clGetExtensionFunctionAddressForPlatform(
+          platform, "clCommandNDRangeKernelKHR"));
+}
+
+bool OpenclCommandBufferFuncs::IsValid() const {
+  return create != nullptr && finalize != nullptr && release != nullptr &&
+      enqueue != nullptr && ndrange_kernel != nullptr;
+}
+
+OpenclCommandRecord::OpenclCommandRecord(
+    const cl::CommandQueue &queue, const OpenclCommandBufferFuncs *funcs)
+    : queue_(queue),
+      funcs_(funcs),
+      command_buffer_(nullptr),
+      kernel_repeated_(false),
+      valid_(true) {
+  if (funcs_ != nullptr && funcs_->IsValid()) {
+    cl_command_queue raw_queue = queue_();
+    cl_int error = CL_SUCCESS;
+    command_buffer_ = funcs_->create(1, &raw_queue, nullptr, &error);
+    if (error != CL_SUCCESS) {
+      VLOG(1) << "Create OpenCL command buffer failed: "
+              << OpenCLErrorToString(error);
+      command_buffer_ = nullptr;
+    }
+  }
+}
+
+OpenclCommandRecord::~OpenclCommandRecord() {
+  ReleaseCommandBuffer();
+}
+
+void OpenclCommandRecord::ReleaseCommandBuffer() {
+  if (command_buffer_ != nullptr) {
+    funcs_->release(command_buffer_);
+    command_buffer_ = nullptr;
+  }
+}
+
+void OpenclCommandRecord::AddKernel(const cl::Kernel &kernel,
+                                    const cl::NDRange &offset,
+                                    const cl::NDRange &global,
+                                    const cl::NDRange &local) {
+  if (!valid_) {
+    return;
+  }
+  // Keep the list anyway, in case recording to the command buffer fails.
+  launches_.push_back({kernel, offset, global, local});
+  if (!kernels_.insert(kernel()).second) {
+    kernel_repeated_ = true;
+  }
+
+  if (command_buffer_ != nullptr) {
+    // Chain the commands, as they are run one by one by an in-order queue.
+    cl_sync_point_khr sync_point = 0;
+    cl_int error = funcs_->ndrange_kernel(
+        command_buffer_, nullptr, nullptr, kernel(),
+        static_cast<cl_uint>(global.dimensions()), NDRangeOrNull(offset),
+        NDRangeOrNull(global), NDRangeOrNull(local),
+        static_cast<cl_uint>(last_sync_point_.size()),
+        last_sync_point_.empty() ? nullptr : last_sync_point_.data(),
+        &sync_point, nullptr);
+    if (error == CL_SUCCESS) {
+      last_sync_point_.assign(1, sync_point);
+    } else {
+      VLOG(1) << "Record kernel to OpenCL command buffer failed: "
+              << OpenCLErrorToString(error);
+      ReleaseCommandBuffer();
+    }
+  }
+}
+
+void OpenclCommandRecord::Invalidate() {
+  valid_ = false;
+  launches_.clear();
+  kernels_.clear();
+  ReleaseCommandBuffer();
+}
+
+MaceStatus OpenclCommandRecord::Finish() {
+  if (valid_ && command_buffer_ != nullptr) {
+    cl_int error = funcs_->finalize(command_buffer_);
+    if (error != CL_SUCCESS) {
+      VLOG(1) << "Finalize OpenCL command buffer failed: "
+              << OpenCLErrorToString(error);
+      ReleaseCommandBuffer();
+    }
+  }
+  if (valid_ && command_buffer_ == nullptr && kernel_repeated_) {
+    Invalidate();
+  }
+
+  return valid_ ? MaceStatus::MACE_SUCCESS : MaceStatus::MACE_UNSUPPORTED;
+}
+
+cl_int OpenclCommandRecord::Replay() {
+  MACE_CHECK(valid_, "Replay an invalid OpenCL command record");
+  if (command_buffer_ != nullptr) {
+    return funcs_->enqueue(0, nullptr, command_buffer_, 0, nullptr, nullptr);
+  }
+
+  cl_int error = CL_SUCCESS;
+  for (auto &launch : launches_) {
+    error = queue_.enqueueNDRangeKernel(launch.kernel, launch.offset,
+                                        launch.global, launch.local);
+    if (error != CL_SUCCESS) {
+      break;
+    }
+  }
+  return error;
+}
+
+bool OpenclCommandRecord::valid() const {
+  return valid_;
+}
+
+bool OpenclCommandRecord::use_command_buffer() const {
+  return command_buffer_ != nullptr;
+}
+
+size_t OpenclCommandRecord::size() const {
+  return launches_.size();
+}
+
+}  // namespace mace
@@ -0,0 +1,90 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MACE_RUNTIMES_OPENCL_CORE_OPENCL_COMMAND_RECORD_H_
+#define MACE_RUNTIMES_OPENCL_CORE_OPENCL_COMMAND_RECORD_H_
+
+#include <set>
+#include <vector>
+
+#include "mace/public/mace.h"
+#include "mace/runtimes/opencl/core/cl2_header.h"
+#include "mace/runtimes/opencl/core/opencl_extension.h"
+#include "mace/utils/macros.h"
+
+namespace mace {
+
+// Functions of cl_khr_command_buffer, null if the device does not support it
+struct OpenclCommandBufferFuncs {
+  OpenclCommandBufferFuncs();
+  void Load(cl_platform_id platform);
+  bool IsValid() const;
+
+  clCreateCommandBufferKHR_fn create;
+  clFinalizeCommandBufferKHR_fn finalize;
+  clReleaseCommandBufferKHR_fn release;
+  clEnqueueCommandBufferKHR_fn enqueue;
+  clCommandNDRangeKernelKHR_fn ndrange_kernel;
+};
+
+// The kernel launches of one run, which can be enqueued again without
+// setting the kernel arguments. With cl_khr_command_buffer they are recorded
+// to a command buffer, which captures the arguments at record time.
+// Otherwise the launches are kept as a list, relying on the kernels keeping
+// the arguments the run set, so a kernel launched twice (maybe with
+// different arguments) makes the record unusable.
+class OpenclCommandRecord {
+ public:
+  OpenclCommandRecord(const cl::CommandQueue &queue,
+                      const OpenclCommandBufferFuncs *funcs);
+  ~OpenclCommandRecord();
+
+  void AddKernel(const cl::Kernel &kernel,
+                 const cl::NDRange &offset,
+                 const cl::NDRange &global,
+                 const cl::NDRange &local);
+  void Invalidate();
+  // Return MACE_UNSUPPORTED if the record can not be replayed
+  MaceStatus Finish();
+  cl_int Replay();
+
+  bool valid() const;
+  bool use_command_buffer() const;
+  size_t size() const;
+
+ private:
+  void ReleaseCommandBuffer();
+
+  struct KernelLaunch {
+    cl::Kernel kernel;
+    cl::NDRange offset;
+    cl::NDRange global;
+    cl::NDRange local;
+  };
+
+  cl::CommandQueue queue_;
+  const OpenclCommandBufferFuncs *funcs_;
+  cl_command_buffer_khr command_buffer_;
+  std::vector<cl_sync_point_khr> last_sync_point_;
+  std::vector<KernelLaunch> launches_;
+  std::set<cl_kernel> kernels_;
+  bool kernel_repeated_;
+  bool valid_;
+
+  MACE_DISABLE_COPY_AND_ASSIGN(OpenclCommandRecord);
+};
+
+}  // namespace mace
+
+#endif  // MACE_RUNTIMES_OPENCL_CORE_OPENCL_COMMAND_RECORD_H_
@@ -14,6 +14,7 @@
 
 #include "mace/runtimes/opencl/core/opencl_executor.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <memory>
@@ -27,6 +28,7 @@
 #include "mace/core/kv_storage.h"
 #include "mace/runtimes/opencl/core/opencl_extension.h"
 #include "mace/utils/macros.h"
+#include "mace/utils/memory.h"
 #include "mace/utils/tuner.h"
 
 namespace mace {
@@ -291,6 +293,9 @@ const char *kOpenCLDeviceNameKey =
     "mace_opencl_precompiled_device_name_key";
 }  // namespace
 
+const char *kOpenCLProgramKeysKey =
+    "mace_opencl_built_program_keys_key";
+
 void OpenCLProfilingTimer::StartTiming() {}
 
 void OpenCLProfilingTimer::StopTiming() {
@@ -422,6 +427,10 @@ OpenclExecutor::OpenclExecutor() : is_opencl_avaliable_(false),
                                    is_profiling_enabled_(false),
                                    opencl_version_(CL_VER_UNKNOWN),
                                    gpu_type_(UNKNOWN),
+                                   built_program_keys_changed_(false),
+                                   build_threads_running_(0),
+                                   stop_building_(false),
+                                   recording_owner_(nullptr),
                                    program_key_hash_prefix_("program_hash_ ") {}
 
 MaceStatus OpenclExecutor::Init(std::shared_ptr<OpenclContext> opencl_context,
@@ -500,6 +509,14 @@ MaceStatus OpenclExecutor::Init(std::shared_ptr<OpenclContext> opencl_context,
     return MaceStatus::MACE_OUT_OF_RESOURCES;
   }
 
+  const auto device_extensions = device_->getInfo<CL_DEVICE_EXTENSIONS>();
+  if (device_extensions.find(MACE_CL_KHR_COMMAND_BUFFER_STR) !=
+      std::string::npos) {
+    command_buffer_funcs_.Load(default_platform());
+  }
+  VLOG(1) << "OpenCL command buffer supported: "
+          << IsCommandBufferSupported();
+
   std::string cached_binary_platform_info;
   std::string cached_binary_device_name;
   auto cache_storage = opencl_context_->opencl_cache_storage();
@@ -510,6 +527,7 @@ MaceStatus OpenclExecutor::Init(std::shared_ptr<OpenclContext> opencl_context,
                    << "the file is not modified illegally, "
                    << "and you have Write&Read permission";
     }
+    std::string program_keys = ReadProgramManifest(cache_storage.get());
     auto platform_info_array = cache_storage->Find(kOpenCLPlatformInfoKey);
     auto *device_name_array = cache_storage->Find(kOpenCLDeviceNameKey);
     if (device_name_array != nullptr) {
@@ -529,6 +547,7 @@ MaceStatus OpenclExecutor::Init(std::shared_ptr<OpenclContext> opencl_context,
                                 (platform_info_ == cached_binary_platform_info);
       if (!same_gpu) {
         cache_storage->Clear();
+        program_keys.clear();
       } else if (!same_platform_info) {
         auto opencl_cache_reuse_policy =
             opencl_context_->opencl_cache_reuse_policy();
@@ -549,6 +568,9 @@ MaceStatus OpenclExecutor::Init(std::shared_ptr<OpenclContext> opencl_context,
         }
       }
     }
+    // The programs built for this GPU are still needed after a driver
+    // update, keep their keys for BuildProgramsInParallel.
+    RestoreProgramManifest(program_keys, cache_storage.get());
   }
 
   if (cached_binary_platform_info != platform_info_) {
@@ -598,10 +620,14 @@ void OpenclExecutor::SetOpenclContext(
 }
 
 OpenclExecutor::~OpenclExecutor() {
+  stop_building_ = true;
+  JoinBuildThreads();
   if (command_queue_ != nullptr) {
     command_queue_->finish();
   }
   built_program_map_.clear();
+  recording_.reset();
+  command_records_.clear();
   // We need to control the destruction order, which has dependencies
   command_queue_.reset();
   context_.reset();
@@ -807,7 +833,8 @@ bool OpenclExecutor::BuildProgramFromSource(
     const std::string &program_name,
     const std::string &built_program_key,
     const std::string &build_options_str,
-    cl::Program *program) {
+    cl::Program *program,
+    bool *need_store) {
   std::string kernel_source;
   MaceStatus status = GetProgramSourceByName(program_name, &kernel_source);
   if (status == MaceStatus::MACE_SUCCESS && !kernel_source.empty()) {
@@ -828,7 +855,7 @@ bool OpenclExecutor::BuildProgramFromSource(
     }
 
     VLOG(3) << "Program from source: " << built_program_key;
-    programs_need_store_.insert(built_program_key);
+    *need_store = true;
   }
   return true;
 }
@@ -836,8 +863,10 @@ bool OpenclExecutor::BuildProgramFromSource(
 bool OpenclExecutor::BuildProgram(const std::string &program_name,
                                   const std::string &built_program_key,
                                   const std::string &build_options,
-                                  cl::Program *program) {
+                                  cl::Program *program,
+                                  bool *need_store) {
   MACE_CHECK_NOTNULL(program);
+  *need_store = false;
 
   std::string build_options_str =
       build_options + " -Werror -cl-mad-enable -cl-fast-relaxed-math";
@@ -849,12 +878,75 @@ bool OpenclExecutor::BuildProgram(const std::string &program_name,
                                             build_options_str, program);
     if (!ret) {
       ret = BuildProgramFromSource(program_name, built_program_key,
-                                   build_options_str, program);
+                                   build_options_str, program, need_store);
     }
   }
   return ret;
 }
 
+std::string OpenclExecutor::ReadProgramManifest(KVStorage *cache_storage) {
+  auto *program_keys_array = cache_storage->Find(kOpenCLProgramKeysKey);
+  if (program_keys_array == nullptr) {
+    return "";
+  }
+  return std::string(program_keys_array->begin(), program_keys_array->end());
+}
+
+void OpenclExecutor::RestoreProgramManifest(const std::string &program_keys,
+                                            KVStorage *cache_storage) {
+  std::lock_guard<std::mutex> lock(program_build_mutex_);
+  for (auto &key : Split(program_keys, '\n')) {
+    if (!key.empty()) {
+      built_program_keys_.insert(key);
+    }
+  }
+  if (!program_keys.empty() &&
+      cache_storage->Find(kOpenCLProgramKeysKey) == nullptr) {
+    cache_storage->Insert(kOpenCLProgramKeysKey,
+                          std::vector<unsigned char>(program_keys.begin(),
+                                                     program_keys.end()));
+  }
+}
+
+MaceStatus OpenclExecutor::GetOrBuildProgram(
+    const std::string &program_name,
+    const std::string &built_program_key,
+    const std::string &build_options,
+    cl::Program *program) {
+  std::unique_lock<std::mutex> lock(program_build_mutex_);
+  // Another thread is building it, wait rather than building it twice.
+  program_build_cond_.wait(lock, [this, &built_program_key]() {
+    return programs_building_.count(built_program_key) == 0;
+  });
+  auto built_program_it = built_program_map_.find(built_program_key);
+  if (built_program_it != built_program_map_.end()) {
+    *program = built_program_it->second;
+    return MaceStatus::MACE_SUCCESS;
+  }
+
+  // Build without holding the lock, so that different programs are built
+  // at the same time.
+  programs_building_.insert(built_program_key);
+  lock.unlock();
+  bool need_store = false;
+  bool ret = this->BuildProgram(program_name, built_program_key,
+                                build_options, program, &need_store);
+  lock.lock();
+  programs_building_.erase(built_program_key);
+  if (ret) {
+    built_program_map_.emplace(built_program_key, *program);
+    if (need_store) {
+      programs_need_store_.insert(built_program_key);
+    }
+    if (built_program_keys_.insert(built_program_key).second) {
+      built_program_keys_changed_ = true;
+    }
+  }
+  program_build_cond_.notify_all();
+
+  return ret ? MaceStatus::MACE_SUCCESS : MaceStatus::MACE_OUT_OF_RESOURCES;
+}
+
 MaceStatus OpenclExecutor::BuildKernel(
     const std::string &program_name,
     const std::string &kernel_name,
@@ -865,29 +957,218 @@ MaceStatus OpenclExecutor::BuildKernel(
     build_options_str += " " + option;
   }
   std::string built_program_key = program_name + build_options_str;
+  if (CollectProgram(built_program_key)) {
+    return MaceStatus(MaceStatus::MACE_OUT_OF_RESOURCES,
+                      "Program " + built_program_key + " is not built yet");
+  }
 
-  std::lock_guard<std::mutex> lock(program_build_mutex_);
-  auto built_program_it = built_program_map_.find(built_program_key);
   cl::Program program;
-  if (built_program_it != built_program_map_.end()) {
-    program = built_program_it->second;
-  } else {
-    bool ret = this->BuildProgram(program_name, built_program_key,
-                                  build_options_str, &program);
-    if (!ret) {
-      return MaceStatus::MACE_OUT_OF_RESOURCES;
-    }
-    built_program_map_.emplace(built_program_key, program);
-  }
+  MACE_RETURN_IF_ERROR(GetOrBuildProgram(program_name, built_program_key,
+                                         build_options_str, &program));
   cl_int err;
   *kernel = cl::Kernel(program, kernel_name.c_str(), &err);
   MACE_CL_RET_STATUS(err);
   return MaceStatus::MACE_SUCCESS;
 }
 
+MaceStatus OpenclExecutor::BuildProgramsInParallel(int num_threads,
+                                                   bool wait) {
+  std::set<std::string> keys;
+  {
+    std::lock_guard<std::mutex> lock(program_build_mutex_);
+    keys = built_program_keys_;
+  }
+  auto precompiled_binary_storage = opencl_context_->opencl_binary_storage();
+  if (precompiled_binary_storage != nullptr) {
+    auto binary_keys = precompiled_binary_storage->Keys();
+    keys.insert(binary_keys.begin(), binary_keys.end());
+  }
+  return BuildProgramsInParallel(keys, num_threads, wait);
+}
+
+MaceStatus OpenclExecutor::BuildProgramsInParallel(
+    const std::set<std::string> &keys, int num_threads, bool wait) {
+  // (program name, built program key)
+  auto programs =
+      std::make_shared<std::vector<std::pair<std::string, std::string>>>();
+  {
+    std::lock_guard<std::mutex> lock(program_build_mutex_);
+    const auto &kEncryptedProgramMap = mace::codegen::kEncryptedProgramMap;
+    for (auto &key : keys) {
+      std::string program_name;
+      ParseProgramNameByKey(key, &program_name);
+      // Skip the platform info and the like
+      if (kEncryptedProgramMap.count(program_name) == 0 ||
+          built_program_map_.count(key) > 0 ||
+          programs_building_.count(key) > 0) {
+        continue;
+      }
+      programs->emplace_back(program_name, key);
+    }
+  }
+  if (programs->empty()) {
+    if (wait) {
+      JoinBuildThreads();
+    }
+    return MaceStatus::MACE_SUCCESS;
+  }
+
+  if (num_threads <= 0) {
+    num_threads = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  num_threads = std::max(1, std::min(num_threads,
+                                     static_cast<int>(programs->size())));
+  VLOG(1) << "Build " << programs->size() << " OpenCL programs on "
+          << num_threads << " threads";
+
+  auto next_program = std::make_shared<std::atomic<size_t>>(0);
+  // The threads of an earlier call may still be running
+  build_threads_running_ += num_threads;
+  for (int i = 0; i < num_threads; ++i) {
+    build_threads_.emplace_back([this, programs, next_program]() {
+      for (size_t idx = (*next_program)++;
+           idx < programs->size() && !stop_building_;
+           idx = (*next_program)++) {
+        const std::string &program_name = (*programs)[idx].first;
+        const std::string &key = (*programs)[idx].second;
+        cl::Program program;
+        if (GetOrBuildProgram(program_name, key,
+                              key.substr(program_name.size()), &program)
+            != MaceStatus::MACE_SUCCESS) {
+          LOG(WARNING) << "Build program " << key << " failed";
+        }
+      }
+      // The last one stores all the programs at once.
+      if (--build_threads_running_ == 0 && !stop_building_) {
+        SaveBuiltCLProgram();
+      }
+    });
+  }
+
+  if (wait) {
+    JoinBuildThreads();
+  }
+  return MaceStatus::MACE_SUCCESS;
+}
+
+bool OpenclExecutor::programs_ready() const {
+  return build_threads_running_ == 0;
+}
+
+void OpenclExecutor::StartCollectingPrograms() {
+  std::lock_guard<std::mutex> lock(program_build_mutex_);
+  collecting_thread_ = std::this_thread::get_id();
+  collected_program_keys_.clear();
+}
+
+std::set<std::string> OpenclExecutor::StopCollectingPrograms() {
+  std::lock_guard<std::mutex> lock(program_build_mutex_);
+  collecting_thread_ = std::thread::id();
+  std::set<std::string> keys;
+  keys.swap(collected_program_keys_);
+  return keys;
+}
+
+bool OpenclExecutor::CollectProgram(const std::string &built_program_key) {
+  std::lock_guard<std::mutex> lock(program_build_mutex_);
+  // Other threads, e.g. another engine on this GPU, build as usual
+  if (collecting_thread_ != std::this_thread::get_id() ||
+      built_program_map_.count(built_program_key) > 0) {
+    return false;
+  }
+  collected_program_keys_.insert(built_program_key);
+  return true;
+}
+
+cl_int OpenclExecutor::EnqueueNDRangeKernel(
+    const cl::Kernel &kernel, const cl::NDRange &offset,
+    const cl::NDRange &global, const cl::NDRange &local,
+    const std::vector<cl::Event> *events, cl::Event *event) {
+  cl_int error = command_queue_->enqueueNDRangeKernel(kernel, offset, global,
+                                                      local, events, event);
+  if (recording_ != nullptr && error == CL_SUCCESS) {
+    if (events != nullptr && !events->empty()) {
+      recording_->Invalidate();
+    } else {
+      recording_->AddKernel(kernel, offset, global, local);
+    }
+  }
+  return error;
+}
+
+MaceStatus OpenclExecutor::StartCommandRecord(const void *owner) {
+  MACE_CHECK(recording_ == nullptr, "OpenCL command record of ",
+             recording_owner_, " is not stopped");
+  command_records_.erase(owner);
+  recording_owner_ = owner;
+  recording_ = make_unique<OpenclCommandRecord>(
+      *command_queue_,
+      IsCommandBufferSupported() ? &command_buffer_funcs_ : nullptr);
+  // Tuning runs kernels many times, and a queue window waits for them.
+  if (out_of_range_check_ || tuner()->IsTuning() ||
+      tuner()->GetOpenclQueueWindowSize() > 0) {
+    recording_->Invalidate();
+  }
+  return MaceStatus::MACE_SUCCESS;
+}
+
+MaceStatus OpenclExecutor::StopCommandRecord(const void *owner, bool keep) {
+  MACE_CHECK(recording_ != nullptr && recording_owner_ == owner,
+             "OpenCL command record of ", owner, " is not started");
+  std::unique_ptr<OpenclCommandRecord> record = std::move(recording_);
+  recording_owner_ = nullptr;
+  MaceStatus status = record->Finish();
+  if (status == MaceStatus::MACE_SUCCESS && keep) {
+    VLOG(2) << "Record " << record->size() << " OpenCL kernels"
+            << (record->use_command_buffer() ? " to command buffer" : "");
+    command_records_[owner] = std::move(record);
+  }
+  return status;
+}
+
+MaceStatus OpenclExecutor::ReplayCommands(const void *owner) {
+  auto iter = command_records_.find(owner);
+  if (iter == command_records_.end()) {
+    return MaceStatus::MACE_UNSUPPORTED;
+  }
+  cl_int error = iter->second->Replay();
+  if (error != CL_SUCCESS) {
+    LOG(WARNING) << "Replay OpenCL commands failed: "
+                 << OpenCLErrorToString(error);
+    command_records_.erase(iter);
+    return MaceStatus::MACE_RUNTIME_ERROR;
+  }
+  return MaceStatus::MACE_SUCCESS;
+}
+
+void OpenclExecutor::ReleaseCommandRecord(const void *owner) {
+  command_records_.erase(owner);
+}
+
+void OpenclExecutor::InvalidateCommandRecord() {
+  if (recording_ != nullptr) {
+    recording_->Invalidate();
+  }
+}
+
+bool OpenclExecutor::IsCommandBufferSupported() const {
+  return command_buffer_funcs_.IsValid();
+}
+
+void OpenclExecutor::JoinBuildThreads() {
+  for (auto &thread : build_threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  build_threads_.clear();
+}
+
 void OpenclExecutor::SaveBuiltCLProgram() {
+  std::lock_guard<std::mutex> lock(program_build_mutex_);
   auto cache_storage = opencl_context_->opencl_cache_storage();
-  if (programs_need_store_.empty() || cache_storage == nullptr) {
+  if ((programs_need_store_.empty() && !built_program_keys_changed_) ||
+      cache_storage == nullptr) {
     return;
   }
 
@@ -918,6 +1199,15 @@ void OpenclExecutor::SaveBuiltCLProgram() {
     }
   }
 
+  // update keys of built programs
+  std::string program_keys;
+  for (auto &key : built_program_keys_) {
+    program_keys += key + "\n";
+  }
+  cache_storage->Insert(kOpenCLProgramKeysKey,
+                        std::vector<unsigned char>(program_keys.begin(),
+                                                   program_keys.end()));
+
   // update platform info
   auto platform_info = std::vector<unsigned char>(platform_info_.begin(),
                                                   platform_info_.end());
@@ -930,6 +1220,7 @@ void OpenclExecutor::SaveBuiltCLProgram() {
   }
 
   programs_need_store_.clear();
+  built_program_keys_changed_ = false;
 }
 
 void OpenclExecutor::GetCallStats(const cl::Event &event, CallStats *stats) {
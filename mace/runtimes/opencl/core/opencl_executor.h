@@ -15,14 +15,19 @@
 #ifndef MACE_RUNTIMES_OPENCL_CORE_OPENCL_EXECUTOR_H_
 #define MACE_RUNTIMES_OPENCL_CORE_OPENCL_EXECUTOR_H_
 
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT(build/c++11)
 #include <set>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
 #include <vector>
 
 #include "mace/core/kv_storage.h"
+#include "mace/runtimes/opencl/core/opencl_command_record.h"
 #include "mace/core/future.h"
 #include "mace/runtimes/opencl/core/cl2_header.h"
 #include "mace/runtimes/opencl/core/opencl_context.h"
@@ -33,6 +38,9 @@
 
 namespace mace {
 
+// Key of the manifest of the programs built for the GPU in the OpenCL cache
+extern const char *kOpenCLProgramKeysKey;
+
 enum GPUType {
   QUALCOMM_ADRENO,
   MALI,
@@ -116,14 +124,64 @@ class OpenclExecutor {
 
   void SaveBuiltCLProgram();
 
+  // Build the programs this model built before (recorded in the cache, kept
+  // across driver updates) and the ones in the precompiled binary on
+  // `num_threads` threads, then store them to the cache. If `wait` is false,
+  // return at once; BuildKernel waits for a program still being built.
+  MaceStatus BuildProgramsInParallel(int num_threads, bool wait);
+  // Build the programs of `keys` the same way, e.g. the ones collected from
+  // the ops of a model.
+  MaceStatus BuildProgramsInParallel(const std::set<std::string> &keys,
+                                     int num_threads, bool wait);
+  bool programs_ready() const;
+
+  // Between StartCollectingPrograms and StopCollectingPrograms, BuildKernel
+  // called on this thread records the programs not built yet and fails
+  // instead of building them, so that a fake warmup of the ops tells which
+  // programs they need. StopCollectingPrograms returns the recorded keys.
+  void StartCollectingPrograms();
+  std::set<std::string> StopCollectingPrograms();
+
+  // Ops enqueue kernels by this rather than the command queue, so that the
+  // launches can be recorded.
+  cl_int EnqueueNDRangeKernel(const cl::Kernel &kernel,
+                              const cl::NDRange &offset,
+                              const cl::NDRange &global,
+                              const cl::NDRange &local,
+                              const std::vector<cl::Event> *events = nullptr,
+                              cl::Event *event = nullptr);
+
+  // Record the kernels enqueued between StartCommandRecord and
+  // StopCommandRecord, ReplayCommands enqueues them again. One record is
+  // kept for each owner. Commands other than kernel launches in between
+  // (e.g. map) make the record unusable, call InvalidateCommandRecord for
+  // them.
+  MaceStatus StartCommandRecord(const void *owner);
+  MaceStatus StopCommandRecord(const void *owner, bool keep);
+  MaceStatus ReplayCommands(const void *owner);
+  void ReleaseCommandRecord(const void *owner);
+  void InvalidateCommandRecord();
+  bool IsCommandBufferSupported() const;
+
  protected:
   virtual void InitGpuDeviceProperty(const cl::Device &device);
+  // The keys of the programs built for this GPU, kept in the OpenCL cache
+  static std::string ReadProgramManifest(KVStorage *cache_storage);
+  void RestoreProgramManifest(const std::string &program_keys,
+                              KVStorage *cache_storage);
+  // Builds each program once, however many threads ask for it at the same
+  // time.
+  MaceStatus GetOrBuildProgram(const std::string &program_name,
+                               const std::string &built_program_key,
+                               const std::string &build_options,
+                               cl::Program *program);
+  virtual bool BuildProgram(const std::string &program_file_name,
+                            const std::string &binary_file_name,
+                            const std::string &build_options,
+                            cl::Program *program,
+                            bool *need_store);
 
  private:
-  bool BuildProgram(const std::string &program_file_name,
-                    const std::string &binary_file_name,
-                    const std::string &build_options,
-                    cl::Program *program);
   bool BuildProgramFromCache(
       const std::string &built_program_key,
       const std::string &build_options_str,
@@ -136,7 +194,11 @@ class OpenclExecutor {
       const std::string &program_name,
       const std::string &built_program_key,
       const std::string &build_options_str,
-      cl::Program *program);
+      cl::Program *program,
+      bool *need_store);
+  // Whether BuildKernel should record the program rather than build it
+  bool CollectProgram(const std::string &built_program_key);
+  void JoinBuildThreads();
   OpenCLVersion ParseDeviceVersion(const std::string &device_version);
   std::string ParseAdrenoDeviceName(const std::string &device_version);
 
@@ -154,7 +216,22 @@ class OpenclExecutor {
   std::shared_ptr<cl::CommandQueue> command_queue_;
   std::map<std::string, cl::Program> built_program_map_;
   std::set<std::string> programs_need_store_;
+  // keys of the programs ever built for this GPU
+  std::set<std::string> built_program_keys_;
+  bool built_program_keys_changed_;
+  std::set<std::string> programs_building_;
+  std::thread::id collecting_thread_;
+  std::set<std::string> collected_program_keys_;
   std::mutex program_build_mutex_;
+  std::condition_variable program_build_cond_;
+  std::vector<std::thread> build_threads_;
+  std::atomic<int> build_threads_running_;
+  std::atomic<bool> stop_building_;
+  OpenclCommandBufferFuncs command_buffer_funcs_;
+  const void *recording_owner_;
+  std::unique_ptr<OpenclCommandRecord> recording_;
+  std::unordered_map<const void *, std::unique_ptr<OpenclCommandRecord>>
+      command_records_;
   std::string platform_info_;
   std::string precompiled_binary_platform_info_;
   bool out_of_range_check_;
@@ -41,4 +41,35 @@ typedef cl_uint cl_priority_hint;
 // Cache policy specifying io-coherence
 #define CL_MEM_HOST_IOCOHERENT_QCOM 0x40A9
 
+// Khronos command buffer extension, the functions are got by
+// clGetExtensionFunctionAddressForPlatform.
+#define MACE_CL_KHR_COMMAND_BUFFER_STR "cl_khr_command_buffer"
+#ifndef cl_khr_command_buffer
+typedef struct _cl_command_buffer_khr *cl_command_buffer_khr;
+typedef struct _cl_mutable_command_khr *cl_mutable_command_khr;
+typedef cl_uint cl_sync_point_khr;
+typedef cl_bitfield cl_command_buffer_properties_khr;
+typedef cl_bitfield cl_ndrange_kernel_command_properties_khr;
+
+typedef cl_command_buffer_khr (CL_API_CALL *clCreateCommandBufferKHR_fn)(
+    cl_uint num_queues, const cl_command_queue *queues,
+    const cl_command_buffer_properties_khr *properties, cl_int *errcode_ret);
+typedef cl_int (CL_API_CALL *clFinalizeCommandBufferKHR_fn)(
+    cl_command_buffer_khr command_buffer);
+typedef cl_int (CL_API_CALL *clReleaseCommandBufferKHR_fn)(
+    cl_command_buffer_khr command_buffer);
+typedef cl_int (CL_API_CALL *clEnqueueCommandBufferKHR_fn)(
+    cl_uint num_queues, cl_command_queue *queues,
+    cl_command_buffer_khr command_buffer, cl_uint num_events_in_wait_list,
+    const cl_event *event_wait_list, cl_event *event);
+typedef cl_int (CL_API_CALL *clCommandNDRangeKernelKHR_fn)(
+    cl_command_buffer_khr command_buffer, cl_command_queue command_queue,
+    const cl_ndrange_kernel_command_properties_khr *properties,
+    cl_kernel kernel, cl_uint work_dim, const size_t *global_work_offset,
+    const size_t *global_work_size, const size_t *local_work_size,
+    cl_uint num_sync_points_in_wait_list,
+    const cl_sync_point_khr *sync_point_wait_list,
+    cl_sync_point_khr *sync_point, cl_mutable_command_khr *mutable_handle);
+#endif  // cl_khr_command_buffer
+
 #endif  // MACE_RUNTIMES_OPENCL_CORE_OPENCL_EXTENSION_H_
@@ -236,7 +236,7 @@ MaceStatus TuningOrRun3DKernel(OpenclExecutor *executor,
             (i == num_blocks - 1)) {
           gws2 = (internal_gws[2] - (i * block_size));
         }
-        error = executor->command_queue().enqueueNDRangeKernel(
+        error = executor->EnqueueNDRangeKernel(
             kernel, cl::NDRange(0, 0, i * block_size),
             cl::NDRange(internal_gws[0], internal_gws[1], gws2),
             cl::NDRange(params[0], params[1], params[2]), nullptr, &event);
@@ -245,7 +245,7 @@ MaceStatus TuningOrRun3DKernel(OpenclExecutor *executor,
       }
     } else {
       timer->ClearTiming();
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           kernel, cl::NullRange,
           cl::NDRange(internal_gws[0], internal_gws[1], internal_gws[2]),
           cl::NDRange(params[0], params[1], params[2]), nullptr, &event);
@@ -271,7 +271,7 @@ MaceStatus TuningOrRun3DKernel(OpenclExecutor *executor,
               (i == num_blocks - 1)) {
             gws2 = (internal_gws[2] - (i * block_size));
           }
-          error = executor->command_queue().enqueueNDRangeKernel(
+          error = executor->EnqueueNDRangeKernel(
               kernel, cl::NDRange(0, 0, i * block_size),
               cl::NDRange(internal_gws[0], internal_gws[1], gws2),
               cl::NDRange(params[0], params[1], params[2]), nullptr, &event);
@@ -350,7 +350,7 @@ MaceStatus TuningOrRun2DKernel(OpenclExecutor *executor,
             (i == num_blocks - 1)) {
           gws1 = (internal_gws[1] - (i * block_size));
         }
-        error = executor->command_queue().enqueueNDRangeKernel(
+        error = executor->EnqueueNDRangeKernel(
             kernel, cl::NDRange(0, i * block_size),
             cl::NDRange(internal_gws[0], gws1),
             cl::NDRange(params[0], params[1]), nullptr, &event);
@@ -359,7 +359,7 @@ MaceStatus TuningOrRun2DKernel(OpenclExecutor *executor,
       }
     } else {
       timer->ClearTiming();
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           kernel, cl::NullRange, cl::NDRange(internal_gws[0], internal_gws[1]),
           cl::NDRange(params[0], params[1]), nullptr, &event);
       MACE_CL_RET_ERROR(error);
@@ -384,7 +384,7 @@ MaceStatus TuningOrRun2DKernel(OpenclExecutor *executor,
               (i == num_blocks - 1)) {
             gws1 = (internal_gws[1] - (i * block_size));
           }
-          error = executor->command_queue().enqueueNDRangeKernel(
+          error = executor->EnqueueNDRangeKernel(
               kernel, cl::NDRange(0, i * block_size),
               cl::NDRange(internal_gws[0], gws1),
               cl::NDRange(params[0], params[1]), nullptr, &event);
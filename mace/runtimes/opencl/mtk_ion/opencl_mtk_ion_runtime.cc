@@ -67,6 +67,7 @@ MaceStatus OpenclMtkIonRuntime::MapBuffer(Buffer *buffer, bool wait_for_finish)
       buffer->mem_type == MemoryType::GPU_IMAGE) &&
       opencl_executor->ion_type() == IONType::MTK_ION);
   MACE_LATENCY_LOGGER(1, "OpenclMtkIonRuntime Map OpenCL buffer");
+  opencl_executor->InvalidateCommandRecord();
 
   OpenclBaseMtkIonAllocator *ion_allocator = nullptr;
   if (buffer->mem_type == MemoryType::GPU_IMAGE) {
@@ -37,6 +37,7 @@ MaceStatus OpenclRefRuntime::Init(const MaceEngineCfgImpl *engine_config,
 MaceStatus OpenclRefRuntime::MapBuffer(Buffer *buffer, bool wait_for_finish) {
   MACE_LATENCY_LOGGER(1, "OpenclRefRuntime Map OpenCL buffer/Image");
   MACE_UNUSED(wait_for_finish);
+  opencl_executor_->InvalidateCommandRecord();
 
   void *mapped_ptr = nullptr;
   cl_int error = CL_INVALID_VALUE;
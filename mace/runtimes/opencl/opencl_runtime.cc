@@ -32,7 +32,8 @@ namespace mace {
 OpenclRuntime::OpenclRuntime(RuntimeContext *runtime_context)
     : Runtime(runtime_context),
       opencl_executor_(nullptr),
-      used_memory_type_(MemoryType::GPU_IMAGE) {}
+      used_memory_type_(MemoryType::GPU_IMAGE),
+      command_replay_(false) {}
 
 MaceStatus OpenclRuntime::Init(const MaceEngineCfgImpl *engine_config,
                                const MemoryType mem_type) {
@@ -43,6 +44,13 @@ MaceStatus OpenclRuntime::Init(const MaceEngineCfgImpl *engine_config,
   }
 
   used_memory_type_ = mem_type;
+  command_replay_ = engine_config->gpu_command_replay();
+
+  int build_threads = engine_config->gpu_program_build_threads();
+  if (build_threads != 0) {
+    MACE_RETURN_IF_ERROR(opencl_executor_->BuildProgramsInParallel(
+        build_threads, !engine_config->gpu_program_build_background()));
+  }
 
   return MaceStatus::MACE_SUCCESS;
 }
@@ -52,6 +60,30 @@ MaceStatus OpenclRuntime::BeforeRun(MaceEngineCfgImpl *config) {
   return Runtime::BeforeRun(config);
 }
 
+bool OpenclRuntime::IsReady() {
+  return opencl_executor_ == nullptr || opencl_executor_->programs_ready();
+}
+
+bool OpenclRuntime::CommandReplayEnabled() {
+  return command_replay_;
+}
+
+MaceStatus OpenclRuntime::StartCommandRecord(const void *owner) {
+  return opencl_executor_->StartCommandRecord(owner);
+}
+
+MaceStatus OpenclRuntime::StopCommandRecord(const void *owner, bool keep) {
+  return opencl_executor_->StopCommandRecord(owner, keep);
+}
+
+MaceStatus OpenclRuntime::ReplayCommands(const void *owner) {
+  return opencl_executor_->ReplayCommands(owner);
+}
+
+void OpenclRuntime::ReleaseCommandRecord(const void *owner) {
+  opencl_executor_->ReleaseCommandRecord(owner);
+}
+
 bool OpenclRuntime::CanReuseBuffer(
     const Buffer *buffer, const std::vector<index_t> &shape,
     const BufferContentType content_type, const unsigned int content_param) {
@@ -43,6 +43,12 @@ class OpenclRuntime : public Runtime {
   MaceStatus Init(const MaceEngineCfgImpl *engine_config,
                   const MemoryType mem_type) override;
   MaceStatus BeforeRun(MaceEngineCfgImpl *config) override;
+  bool IsReady() override;
+  bool CommandReplayEnabled() override;
+  MaceStatus StartCommandRecord(const void *owner) override;
+  MaceStatus StopCommandRecord(const void *owner, bool keep) override;
+  MaceStatus ReplayCommands(const void *owner) override;
+  void ReleaseCommandRecord(const void *owner) override;
   bool CanReuseBuffer(
       const Buffer *buffer, const std::vector<index_t> &shape,
       const BufferContentType content_type,
@@ -74,6 +80,7 @@ class OpenclRuntime : public Runtime {
  protected:
   std::unique_ptr<OpenclExecutor> opencl_executor_;
   MemoryType used_memory_type_;
+  bool command_replay_;
 };
 }  // namespace mace
 
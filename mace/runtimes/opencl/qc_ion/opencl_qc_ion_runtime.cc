@@ -67,6 +67,7 @@ MaceStatus OpenclQcIonRuntime::MapBuffer(Buffer *buffer, bool wait_for_finish) {
       buffer->mem_type == MemoryType::GPU_IMAGE) &&
       opencl_executor->ion_type() == IONType::QUALCOMM_ION);
   MACE_LATENCY_LOGGER(1, "OpenclQcIonRuntime Map OpenCL buffer");
+  opencl_executor->InvalidateCommandRecord();
 
   OpenclBaseQcIonAllocator *ion_allocator = nullptr;
   if (buffer->mem_type == MemoryType::GPU_IMAGE) {
@@ -69,12 +69,12 @@ MaceStatus BufferTypeTransform(
   if (!context->fake_warmup()) {
     cl_int error;
     if (executor->IsNonUniformWorkgroupsSupported()) {
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           *kernel, cl::NullRange, cl::NDRange(gws),
           cl::NDRange(lws), nullptr, &event);
     } else {
       uint32_t roundup_gws = RoundUp(gws, lws);
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           *kernel, cl::NullRange, cl::NDRange(roundup_gws),
           cl::NDRange(lws), nullptr, &event);
     }
@@ -91,12 +91,12 @@ class QuantizeTransformer {
     cl::Event event;
     cl_int error;
     if (executor->IsNonUniformWorkgroupsSupported()) {
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           quantize_kernel_, cl::NullRange, cl::NDRange(gws), cl::NDRange(lws),
           nullptr, &event);
     } else {
       uint32_t roundup_gws = RoundUp(gws, lws);
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           quantize_kernel_, cl::NullRange, cl::NDRange(roundup_gws),
           cl::NDRange(lws), nullptr, &event);
     }
@@ -149,12 +149,12 @@ class QuantizeTransformer {
     cl::Event event;
     cl_int error;
     if (executor->IsNonUniformWorkgroupsSupported()) {
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           dequantize_kernel_, cl::NullRange, cl::NDRange(gws), cl::NDRange(lws),
           nullptr, &event);
     } else {
       uint32_t roundup_gws = RoundUp(gws, lws);
-      error = executor->command_queue().enqueueNDRangeKernel(
+      error = executor->EnqueueNDRangeKernel(
           dequantize_kernel_, cl::NullRange, cl::NDRange(roundup_gws),
           cl::NDRange(lws), nullptr, &event);
     }
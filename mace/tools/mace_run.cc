@@ -172,7 +172,9 @@ DEFINE_int32(gpu_perf_hint, 3, "0:DEFAULT/1:LOW/2:NORMAL/3:HIGH");
 DEFINE_int32(gpu_priority_hint, 3, "0:DEFAULT/1:LOW/2:NORMAL/3:HIGH");
 DEFINE_int32(num_threads, -1, "num of threads");
 DEFINE_int32(cpu_affinity_policy, 1,
-             "0:AFFINITY_NONE/1:AFFINITY_BIG_ONLY/2:AFFINITY_LITTLE_ONLY");
+             "0:AFFINITY_NONE/1:AFFINITY_BIG_ONLY/2:AFFINITY_LITTLE_ONLY/"
+             "3:AFFINITY_HIGH_PERFORMANCE/4:AFFINITY_POWER_SAVE/"
+             "5:AFFINITY_PHYSICAL_CORES/6:AFFINITY_SINGLE_LLC");
 DEFINE_int32(apu_boost_hint, 100,
              "APU boost value ranged between 0 (lowest) to 100 (highest)");
 DEFINE_int32(apu_preference_hint, 1,
@@ -185,6 +187,13 @@ DEFINE_int32(opencl_cache_reuse_policy,
 DEFINE_int32(accelerator_cache_policy, 0, "0:NONE/1:STORE/2:LOAD/3:APU_LOAD_OR_STORE");
 DEFINE_bool(benchmark, false, "enable benchmark op");
 DEFINE_bool(fake_warmup, false, "enable fake warmup");
+DEFINE_string(quantize_range_file, "",
+              "calibrate the float model and write the quantization ranges "
+              "of the activations to this file");
+DEFINE_int32(calibration_method, 1,
+             "1:MIN_MAX/2:PERCENTILE/3:KL_DIVERGENCE, see CalibrationMethod");
+DEFINE_double(calibration_percentile, 99.99,
+              "percentile of values kept by PERCENTILE calibration");
 
 namespace {
 std::shared_ptr<char> ReadInputDataFromFile(
@@ -341,6 +350,15 @@ bool RunModel(const std::string &model_name,
   if (status != MaceStatus::MACE_SUCCESS) {
     LOG(WARNING) << "Set cpu affinity failed.";
   }
+  if (!FLAGS_quantize_range_file.empty()) {
+    status = config.SetCalibration(
+        static_cast<CalibrationMethod>(FLAGS_calibration_method),
+        static_cast<float>(FLAGS_calibration_percentile));
+    if (status != MaceStatus::MACE_SUCCESS) {
+      LOG(ERROR) << "Set calibration failed.";
+      return false;
+    }
+  }
 #if defined(MACE_ENABLE_OPENCL) || defined(MACE_ENABLE_HTA)
   std::shared_ptr<OpenclContext> opencl_context;
   const char *storage_path_ptr = getenv("MACE_INTERNAL_STORAGE_PATH");
@@ -693,6 +711,17 @@ bool RunModel(const std::string &model_name,
     }
   }
 
+  if (!FLAGS_quantize_range_file.empty()) {
+    status = engine->SaveCalibrationRanges(FLAGS_quantize_range_file);
+    if (status != MaceStatus::MACE_SUCCESS) {
+      LOG(ERROR) << "Write quantize range file " << FLAGS_quantize_range_file
+                 << " failed: " << status.information();
+      return false;
+    }
+    LOG(INFO) << "Write quantize range file " << FLAGS_quantize_range_file
+              << " done.";
+  }
+
   return true;
 }
 
@@ -742,6 +771,7 @@ int Main(int argc, char **argv) {
   LOG(INFO) << "gpu_priority_hint: " << FLAGS_gpu_priority_hint;
   LOG(INFO) << "num_threads: " << FLAGS_num_threads;
   LOG(INFO) << "cpu_affinity_policy: " << FLAGS_cpu_affinity_policy;
+  LOG(INFO) << "quantize_range_file: " << FLAGS_quantize_range_file;
   auto limit_opencl_kernel_time = getenv("MACE_LIMIT_OPENCL_KERNEL_TIME");
   if (limit_opencl_kernel_time) {
     LOG(INFO) << "limit_opencl_kernel_time: "
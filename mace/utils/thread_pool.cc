@@ -13,7 +13,10 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <cmath>
+#include <map>
 #include <numeric>
+#include <set>
 
 #include "mace/port/port.h"
 #include "mace/port/env.h"
@@ -71,6 +74,13 @@ int GetCpuCoresForPerfomance(
   return cores_to_use;
 }
 
+MaceStatus SetAffinity(const std::vector<size_t> &cores, bool force) {
+  if (force) {
+    return port::Env::Default()->SchedSetNUMAAffinity(cores);
+  }
+  return port::Env::Default()->SchedSetAffinity(cores);
+}
+
 }  // namespace
 
 MaceStatus GetCPUCoresToUse(const std::vector<float> &cpu_max_freqs,
@@ -96,11 +106,11 @@ MaceStatus GetCPUCoresToUse(const std::vector<float> &cpu_max_freqs,
     }
     if (policy == CPUAffinityPolicy::AFFINITY_POWER_SAVE ||
         policy == CPUAffinityPolicy::AFFINITY_LITTLE_ONLY) {
-      std::sort(cpu_freq.begin(),
-                cpu_freq.end(),
-                [=](const CPUFreq &lhs, const CPUFreq &rhs) {
-                  return lhs.freq < rhs.freq;
-                });
+      std::stable_sort(cpu_freq.begin(),
+                       cpu_freq.end(),
+                       [=](const CPUFreq &lhs, const CPUFreq &rhs) {
+                         return lhs.freq < rhs.freq;
+                       });
     } else if (policy == CPUAffinityPolicy::AFFINITY_HIGH_PERFORMANCE ||
         policy == CPUAffinityPolicy::AFFINITY_BIG_ONLY) {
       for (size_t i = 0; i < cpu_max_freqs.size(); ++i) {
@@ -109,11 +119,11 @@ MaceStatus GetCPUCoresToUse(const std::vector<float> &cpu_max_freqs,
           return MaceStatus::MACE_SUCCESS;
         }
       }
-      std::sort(cpu_freq.begin(),
-                cpu_freq.end(),
-                [](const CPUFreq &lhs, const CPUFreq &rhs) {
-                  return lhs.freq > rhs.freq;
-                });
+      std::stable_sort(cpu_freq.begin(),
+                       cpu_freq.end(),
+                       [](const CPUFreq &lhs, const CPUFreq &rhs) {
+                         return lhs.freq > rhs.freq;
+                       });
     }
 
     // decide num of cores to use
@@ -143,10 +153,166 @@ MaceStatus GetCPUCoresToUse(const std::vector<float> &cpu_max_freqs,
   return MaceStatus::MACE_SUCCESS;
 }
 
+MaceStatus GetCPUCoresToUse(const std::vector<float> &cpu_max_freqs,
+                            const CPUAffinityPolicy policy,
+                            const std::vector<size_t> &numa_cpus,
+                            int *thread_count,
+                            std::vector<size_t> *cores) {
+  if (numa_cpus.empty()) {
+    return GetCPUCoresToUse(cpu_max_freqs, policy, thread_count, cores);
+  }
+
+  // CPUs without frequency info (e.g., no cpufreq in VMs) count as equal.
+  std::vector<float> numa_freqs(numa_cpus.size(), 1.0f);
+  if (!cpu_max_freqs.empty()) {
+    for (size_t i = 0; i < numa_cpus.size(); ++i) {
+      numa_freqs[i] = numa_cpus[i] < cpu_max_freqs.size() ?
+                      cpu_max_freqs[numa_cpus[i]] : 0.0f;
+    }
+  }
+  std::vector<size_t> numa_cores;
+  MACE_RETURN_IF_ERROR(GetCPUCoresToUse(numa_freqs, policy,
+                                        thread_count, &numa_cores));
+  cores->clear();
+  if (numa_cores.empty()) {
+    *cores = numa_cpus;
+  } else {
+    for (auto core : numa_cores) {
+      cores->push_back(numa_cpus[core]);
+    }
+  }
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
+MaceStatus GetCPUCoresToUse(const std::vector<float> &cpu_max_freqs,
+                            const port::CPUTopology &topology,
+                            const CPUAffinityPolicy policy,
+                            const std::vector<size_t> &numa_cpus,
+                            int *thread_count,
+                            std::vector<size_t> *cores) {
+  const bool topology_policy = IsTopologyAffinityPolicy(policy);
+  if (topology.cpus.empty()) {
+    if (topology_policy) {
+      LOG(WARNING) << "CPU topology is unknown, use AFFINITY_NONE";
+    }
+    return GetCPUCoresToUse(
+        cpu_max_freqs,
+        topology_policy ? CPUAffinityPolicy::AFFINITY_NONE : policy,
+        numa_cpus, thread_count, cores);
+  }
+
+  std::vector<port::CPUInfo> cpus;
+  for (const auto &cpu : topology.cpus) {
+    if (numa_cpus.empty() || std::find(numa_cpus.begin(), numa_cpus.end(),
+                                       cpu.cpu_id) != numa_cpus.end()) {
+      cpus.push_back(cpu);
+    }
+  }
+  if (cpus.empty()) {
+    LOG(WARNING) << "No CPU of the NUMA node is allowed, use all the others";
+    cpus = topology.cpus;
+  }
+
+  // Put one SMT sibling of each physical core first, so that the threads
+  // don't share the execution units when there are free cores
+  std::vector<port::CPUInfo> physical_cpus;
+  std::vector<port::CPUInfo> sibling_cpus;
+  std::set<int> core_ids;
+  for (const auto &cpu : cpus) {
+    if (core_ids.insert(cpu.core_id).second) {
+      physical_cpus.push_back(cpu);
+    } else {
+      sibling_cpus.push_back(cpu);
+    }
+  }
+
+  int max_thread_count = static_cast<int>(cpus.size());
+  if (topology.cpu_quota > 0) {
+    // More threads than the quota get throttled, and the slowest one holds
+    // all the others at the end of each task. A fractional quota is rounded
+    // to the nearest, e.g. 1.5 CPUs run 2 threads.
+    const int quota_threads =
+        static_cast<int>(std::lround(topology.cpu_quota));
+    max_thread_count = std::min(max_thread_count, std::max(quota_threads, 1));
+  }
+
+  cores->clear();
+  if (topology_policy) {
+    if (policy == CPUAffinityPolicy::AFFINITY_SINGLE_LLC) {
+      // The domain with the most physical cores, the first one for ties
+      std::map<int, int> llc_core_counts;
+      for (const auto &cpu : physical_cpus) {
+        ++llc_core_counts[cpu.llc_id];
+      }
+      int llc_id = physical_cpus[0].llc_id;
+      for (const auto &llc_core_count : llc_core_counts) {
+        if (llc_core_count.second > llc_core_counts[llc_id]) {
+          llc_id = llc_core_count.first;
+        }
+      }
+      physical_cpus.erase(
+          std::remove_if(physical_cpus.begin(), physical_cpus.end(),
+                         [llc_id](const port::CPUInfo &cpu) {
+                           return cpu.llc_id != llc_id;
+                         }),
+          physical_cpus.end());
+    }
+    for (const auto &cpu : physical_cpus) {
+      cores->push_back(cpu.cpu_id);
+    }
+    max_thread_count = std::min(max_thread_count,
+                                static_cast<int>(physical_cpus.size()));
+  } else {
+    std::vector<size_t> cpu_ids;
+    for (const auto &cpu : physical_cpus) {
+      cpu_ids.push_back(cpu.cpu_id);
+    }
+    for (const auto &cpu : sibling_cpus) {
+      cpu_ids.push_back(cpu.cpu_id);
+    }
+    MACE_RETURN_IF_ERROR(GetCPUCoresToUse(cpu_max_freqs, policy, cpu_ids,
+                                          thread_count, cores));
+    if (policy == CPUAffinityPolicy::AFFINITY_NONE && numa_cpus.empty()) {
+      cores->clear();
+    }
+  }
+  if (*thread_count <= 0 || *thread_count > max_thread_count) {
+    *thread_count = max_thread_count;
+  }
+  VLOG(2) << "Use " << *thread_count << " threads on CPUs "
+          << MakeString(*cores);
+
+  return MaceStatus::MACE_SUCCESS;
+}
+
+bool IsTopologyAffinityPolicy(const CPUAffinityPolicy policy) {
+  return policy == CPUAffinityPolicy::AFFINITY_PHYSICAL_CORES ||
+      policy == CPUAffinityPolicy::AFFINITY_SINGLE_LLC;
+}
+
+std::vector<std::vector<size_t>> GetThreadCores(
+    const std::vector<size_t> &cores,
+    const CPUAffinityPolicy policy,
+    const int thread_count) {
+  std::vector<std::vector<size_t>> thread_cores(
+      static_cast<size_t>(thread_count), cores);
+  if (IsTopologyAffinityPolicy(policy) && !cores.empty()) {
+    // The thread count never exceeds the physical cores for these policies
+    MACE_CHECK(static_cast<size_t>(thread_count) <= cores.size());
+    for (size_t i = 0; i < thread_cores.size(); ++i) {
+      thread_cores[i] = {cores[i]};
+    }
+  }
+  return thread_cores;
+}
+
 ThreadPool::ThreadPool(const int thread_count_hint,
-                       const CPUAffinityPolicy policy)
+                       const CPUAffinityPolicy policy,
+                       const int numa_node)
     : event_(kThreadPoolNone),
-      count_down_latch_(kThreadPoolSpinWaitTime) {
+      count_down_latch_(kThreadPoolSpinWaitTime),
+      force_affinity_(false) {
   int thread_count = thread_count_hint;
 
   if (port::Env::Default()->GetCPUMaxFreq(&cpu_max_freqs_)
@@ -154,13 +320,40 @@ ThreadPool::ThreadPool(const int thread_count_hint,
     LOG(ERROR) << "Fail to get cpu max frequencies";
   }
 
+  std::vector<size_t> numa_cpus;
+  if (numa_node >= 0) {
+    if (port::Env::Default()->GetNUMANodeCPUs(numa_node, &numa_cpus)
+        == MaceStatus::MACE_SUCCESS) {
+      force_affinity_ = true;
+    } else {
+      LOG(WARNING) << "Fail to get CPUs of NUMA node " << numa_node
+                   << ", don't bind thread pool to it";
+      numa_cpus.clear();
+    }
+  }
+
+  port::CPUTopology topology;
+  if (port::Env::Default()->GetCPUTopology(&topology)
+      != MaceStatus::MACE_SUCCESS) {
+    topology.cpus.clear();
+  }
+  for (const auto &cpu : topology.cpus) {
+    allowed_cpus_.push_back(cpu.cpu_id);
+  }
+
   std::vector<size_t> cores_to_use;
-  GetCPUCoresToUse(cpu_max_freqs_, policy, &thread_count, &cores_to_use);
+  GetCPUCoresToUse(cpu_max_freqs_, topology, policy, numa_cpus,
+                   &thread_count, &cores_to_use);
   MACE_CHECK(thread_count > 0);
   VLOG(2) << "Use " << thread_count << " threads";
+  if (IsTopologyAffinityPolicy(policy) && !cores_to_use.empty()) {
+    force_affinity_ = true;
+  }
+  std::vector<std::vector<size_t>> thread_cores =
+      GetThreadCores(cores_to_use, policy, thread_count);
 
-  if (!cores_to_use.empty()) {
-    if (port::Env::Default()->SchedSetAffinity(cores_to_use)
+  if (!thread_cores[0].empty()) {
+    if (SetAffinity(thread_cores[0], force_affinity_)
         != MaceStatus::MACE_SUCCESS) {
       LOG(ERROR) << "Failed to sched_set_affinity";
     }
@@ -174,19 +367,25 @@ ThreadPool::ThreadPool(const int thread_count_hint,
 
   threads_ = std::vector<std::thread>(static_cast<size_t>(thread_count));
   thread_infos_ = std::vector<ThreadInfo>(static_cast<size_t>(thread_count));
-  for (auto &thread_info : thread_infos_) {
-    thread_info.cpu_cores = cores_to_use;
+  for (size_t i = 0; i < thread_infos_.size(); ++i) {
+    thread_infos_[i].cpu_cores = thread_cores[i];
   }
 }
 
 ThreadPool::~ThreadPool() {
   // Clear affinity of main thread
-  if (!cpu_max_freqs_.empty()) {
-    std::vector<size_t> cores(cpu_max_freqs_.size());
+  size_t cpu_count = cpu_max_freqs_.size();
+  if (cpu_count == 0 && force_affinity_) {
+    cpu_count = std::thread::hardware_concurrency();
+  }
+  if (!allowed_cpus_.empty()) {
+    SetAffinity(allowed_cpus_, force_affinity_);
+  } else if (cpu_count > 0) {
+    std::vector<size_t> cores(cpu_count);
     for (size_t i = 0; i < cores.size(); ++i) {
       cores[i] = i;
     }
-    port::Env::Default()->SchedSetAffinity(cores);
+    SetAffinity(cores, force_affinity_);
   }
 
   Destroy();
@@ -264,7 +463,7 @@ void ThreadPool::Destroy() {
 // Event is executed synchronously.
 void ThreadPool::ThreadLoop(size_t tid) {
   if (!thread_infos_[tid].cpu_cores.empty()) {
-    if (port::Env::Default()->SchedSetAffinity(thread_infos_[tid].cpu_cores)
+    if (SetAffinity(thread_infos_[tid].cpu_cores, force_affinity_)
         != MaceStatus::MACE_SUCCESS) {
       LOG(ERROR) << "Failed to sched set affinity for tid: " << tid;
     }
@@ -23,6 +23,7 @@
 #include <atomic>
 
 #include "mace/public/mace.h"
+#include "mace/port/env.h"
 #include "mace/port/port.h"
 #include "mace/utils/count_down_latch.h"
 
@@ -34,10 +35,43 @@ MaceStatus GetCPUCoresToUse(const std::vector<float> &cpu_max_freqs,
                             int *thread_count_hint,
                             std::vector<size_t> *cores);
 
+// Same as above, but only picks cores among `numa_cpus` (the CPUs of a NUMA
+// node). All of them are returned for AFFINITY_NONE, so that the threads
+// still stay on the node.
+MaceStatus GetCPUCoresToUse(const std::vector<float> &cpu_max_freqs,
+                            const CPUAffinityPolicy policy,
+                            const std::vector<size_t> &numa_cpus,
+                            int *thread_count_hint,
+                            std::vector<size_t> *cores);
+
+// Same as above, but only picks cores among the CPUs of `topology`, taking
+// one SMT sibling of each physical core before the others, and caps the
+// thread count by the CPU quota. It also handles AFFINITY_PHYSICAL_CORES and
+// AFFINITY_SINGLE_LLC, which fall back to AFFINITY_NONE without a topology.
+MaceStatus GetCPUCoresToUse(const std::vector<float> &cpu_max_freqs,
+                            const port::CPUTopology &topology,
+                            const CPUAffinityPolicy policy,
+                            const std::vector<size_t> &numa_cpus,
+                            int *thread_count_hint,
+                            std::vector<size_t> *cores);
+
+// Whether `policy` binds the threads by the CPU topology
+bool IsTopologyAffinityPolicy(const CPUAffinityPolicy policy);
+
+// The CPUs each of `thread_count` threads is bound to, thread 0 is the
+// calling thread. With a topology policy every thread gets its own core of
+// `cores`, so that no two threads share a physical core, otherwise all the
+// threads share all of `cores`.
+std::vector<std::vector<size_t>> GetThreadCores(
+    const std::vector<size_t> &cores,
+    const CPUAffinityPolicy policy,
+    const int thread_count);
+
 class ThreadPool {
  public:
   ThreadPool(const int thread_count,
-             const CPUAffinityPolicy affinity_policy);
+             const CPUAffinityPolicy affinity_policy,
+             const int numa_node = -1);
   ~ThreadPool();
 
   void Init();
@@ -115,6 +149,10 @@ class ThreadPool {
   std::vector<ThreadInfo> thread_infos_;
   std::vector<std::thread> threads_;
   std::vector<float> cpu_max_freqs_;
+  std::vector<size_t> allowed_cpus_;
+  // Bind by SchedSetNUMAAffinity, which is not a no-op on embedded Linux,
+  // for a NUMA node or a topology policy
+  bool force_affinity_;
 
   int64_t default_tile_count_;
 };
@@ -17,13 +17,17 @@
 
 #if defined(MACE_ENABLE_NEON)
 #include <arm_neon.h>
+#elif defined(__SSE__)
+#include <xmmintrin.h>
 #endif  // MACE_ENABLE_NEON
 #include <algorithm>
+#include <cstring>
 #include <vector>
 
 #include "mace/core/types.h"
 #include "mace/port/port.h"
 #include "mace/public/mace.h"
+#include "mace/utils/math.h"
 #include "mace/utils/thread_pool.h"
 
 namespace mace {
@@ -161,46 +165,194 @@ inline void TransposeNCHWToNHWCC2<float, float>(utils::ThreadPool *thread_pool,
   }, 0, height, 1);
 }
 
+// Drops the unit axes and merges the axes which stay adjacent after the
+// permutation, e.g. {0, 2, 3, 1} of NCHW becomes {0, 2, 1} of {N, C, HW}.
+inline void SimplifyTranspose(const std::vector<int64_t> &input_shape,
+                              const std::vector<int> &dst_dims,
+                              std::vector<index_t> *shape,
+                              std::vector<int> *dims) {
+  const int rank = static_cast<int>(input_shape.size());
+  std::vector<int> new_axis(rank, -1);
+  std::vector<index_t> kept_shape;
+  for (int i = 0; i < rank; ++i) {
+    if (input_shape[i] != 1) {
+      new_axis[i] = static_cast<int>(kept_shape.size());
+      kept_shape.push_back(input_shape[i]);
+    }
+  }
+  std::vector<int> kept_dims;
+  for (int i = 0; i < rank; ++i) {
+    if (new_axis[dst_dims[i]] >= 0) {
+      kept_dims.push_back(new_axis[dst_dims[i]]);
+    }
+  }
+
+  // merge_with_prev[i]: input axis i follows axis i - 1 in the output too
+  const int kept_rank = static_cast<int>(kept_dims.size());
+  std::vector<bool> merge_with_prev(kept_rank, false);
+  for (int i = 1; i < kept_rank; ++i) {
+    merge_with_prev[kept_dims[i]] = kept_dims[i] == kept_dims[i - 1] + 1;
+  }
+  // group[i]: the merged axis which input axis i belongs to
+  std::vector<int> group(kept_rank, 0);
+  shape->clear();
+  for (int i = 0; i < kept_rank; ++i) {
+    if (i > 0 && merge_with_prev[i]) {
+      group[i] = group[i - 1];
+      shape->back() *= kept_shape[i];
+    } else {
+      group[i] = static_cast<int>(shape->size());
+      shape->push_back(kept_shape[i]);
+    }
+  }
+  dims->clear();
+  for (int i = 0; i < kept_rank; ++i) {
+    if (!merge_with_prev[kept_dims[i]]) {
+      dims->push_back(group[kept_dims[i]]);
+    }
+  }
+}
+
+// Walks the outer axes of a transpose in output order, keeping the input
+// and output offsets of the current position.
+class TransposeOuterIterator {
+ public:
+  TransposeOuterIterator(const std::vector<index_t> &sizes,
+                         const std::vector<index_t> &in_strides,
+                         const std::vector<index_t> &out_strides,
+                         index_t position)
+      : sizes_(sizes), in_strides_(in_strides), out_strides_(out_strides),
+        index_(sizes.size(), 0), in_offset_(0), out_offset_(0) {
+    for (int i = static_cast<int>(sizes_.size()) - 1; i >= 0; --i) {
+      index_[i] = position % sizes_[i];
+      position /= sizes_[i];
+      in_offset_ += index_[i] * in_strides_[i];
+      out_offset_ += index_[i] * out_strides_[i];
+    }
+  }
+
+  void Next() {
+    for (int i = static_cast<int>(sizes_.size()) - 1; i >= 0; --i) {
+      in_offset_ += in_strides_[i];
+      out_offset_ += out_strides_[i];
+      if (++index_[i] < sizes_[i]) {
+        return;
+      }
+      in_offset_ -= sizes_[i] * in_strides_[i];
+      out_offset_ -= sizes_[i] * out_strides_[i];
+      index_[i] = 0;
+    }
+  }
+
+  index_t in_offset() const { return in_offset_; }
+  index_t out_offset() const { return out_offset_; }
+
+ private:
+  const std::vector<index_t> &sizes_;
+  const std::vector<index_t> &in_strides_;
+  const std::vector<index_t> &out_strides_;
+  std::vector<index_t> index_;
+  index_t in_offset_;
+  index_t out_offset_;
+};
+
+template<typename SrcT, typename DstT>
+inline void TransposeCopyRow(const SrcT *input, DstT *output,
+                             const index_t size) {
+  for (index_t i = 0; i < size; ++i) {
+    output[i] = input[i];
+  }
+}
+
+template<typename T>
+inline void TransposeCopyRow(const T *input, T *output, const index_t size) {
+  memcpy(output, input, size * sizeof(T));
+}
+
+// output[c * out_stride + r] = input[r * in_stride + c]
+template<typename SrcT, typename DstT>
+inline void TransposeTile(const SrcT *input, const index_t in_stride,
+                          DstT *output, const index_t out_stride,
+                          const index_t rows, const index_t cols) {
+  for (index_t c = 0; c < cols; ++c) {
+    for (index_t r = 0; r < rows; ++r) {
+      output[c * out_stride + r] = input[r * in_stride + c];
+    }
+  }
+}
+
+#if defined(MACE_ENABLE_NEON) || defined(__SSE__)
+template<>
+inline void TransposeTile<float, float>(const float *input,
+                                        const index_t in_stride,
+                                        float *output,
+                                        const index_t out_stride,
+                                        const index_t rows,
+                                        const index_t cols) {
+  const index_t rows4 = rows & ~3;
+  const index_t cols4 = cols & ~3;
+  for (index_t r = 0; r < rows4; r += 4) {
+    for (index_t c = 0; c < cols4; c += 4) {
+      const float *in_ptr = input + r * in_stride + c;
+      float *out_ptr = output + c * out_stride + r;
+#if defined(MACE_ENABLE_NEON)
+      float32x4x2_t v01 = vtrnq_f32(vld1q_f32(in_ptr),
+                                    vld1q_f32(in_ptr + in_stride));
+      float32x4x2_t v23 = vtrnq_f32(vld1q_f32(in_ptr + 2 * in_stride),
+                                    vld1q_f32(in_ptr + 3 * in_stride));
+      vst1q_f32(out_ptr, vcombine_f32(vget_low_f32(v01.val[0]),
+                                      vget_low_f32(v23.val[0])));
+      vst1q_f32(out_ptr + out_stride, vcombine_f32(vget_low_f32(v01.val[1]),
+                                                   vget_low_f32(v23.val[1])));
+      vst1q_f32(out_ptr + 2 * out_stride,
+                vcombine_f32(vget_high_f32(v01.val[0]),
+                             vget_high_f32(v23.val[0])));
+      vst1q_f32(out_ptr + 3 * out_stride,
+                vcombine_f32(vget_high_f32(v01.val[1]),
+                             vget_high_f32(v23.val[1])));
+#else
+      __m128 v0 = _mm_loadu_ps(in_ptr);
+      __m128 v1 = _mm_loadu_ps(in_ptr + in_stride);
+      __m128 v2 = _mm_loadu_ps(in_ptr + 2 * in_stride);
+      __m128 v3 = _mm_loadu_ps(in_ptr + 3 * in_stride);
+      _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+      _mm_storeu_ps(out_ptr, v0);
+      _mm_storeu_ps(out_ptr + out_stride, v1);
+      _mm_storeu_ps(out_ptr + 2 * out_stride, v2);
+      _mm_storeu_ps(out_ptr + 3 * out_stride, v3);
+#endif
+    }
+  }
+  for (index_t c = cols4; c < cols; ++c) {
+    for (index_t r = 0; r < rows4; ++r) {
+      output[c * out_stride + r] = input[r * in_stride + c];
+    }
+  }
+  for (index_t c = 0; c < cols; ++c) {
+    for (index_t r = rows4; r < rows; ++r) {
+      output[c * out_stride + r] = input[r * in_stride + c];
+    }
+  }
+}
+#endif  // MACE_ENABLE_NEON || __SSE__
+
 template<typename SrcT, typename DstT>
 MaceStatus Transpose(utils::ThreadPool *thread_pool,
                      const SrcT *input,
                      const std::vector<int64_t> &input_shape,
                      const std::vector<int> &dst_dims,
                      DstT *output) {
-  MACE_CHECK((input_shape.size() == 2 && dst_dims.size() == 2) ||
-      (input_shape.size() == 3 && dst_dims.size() == 3) ||
-      (input_shape.size() == 4 && dst_dims.size() == 4),
-             "Only support 2D, 3D or 4D transpose");
-
-  std::vector<index_t> output_shape;
-  for (size_t i = 0; i < dst_dims.size(); ++i) {
-    output_shape.push_back(input_shape[dst_dims[i]]);
+  const size_t rank = input_shape.size();
+  MACE_CHECK(dst_dims.size() == rank, "transpose dims size ", dst_dims.size(),
+             " does not match the input rank ", rank);
+  std::vector<bool> used(rank, false);
+  for (size_t i = 0; i < rank; ++i) {
+    MACE_CHECK(dst_dims[i] >= 0 && dst_dims[i] < static_cast<int>(rank) &&
+        !used[dst_dims[i]], "transpose dims should be a permutation");
+    used[dst_dims[i]] = true;
   }
 
-  if (input_shape.size() == 2) {
-    MACE_CHECK(dst_dims[0] == 1 && dst_dims[1] == 0, "no need transform");
-    index_t height = input_shape[0];
-    index_t width = input_shape[1];
-    index_t stride_i = height;
-    index_t stride_j = width;
-    index_t tile_size = height > 512 || width > 512 ? 64 : 32;
-
-    thread_pool->Compute2D([=](index_t start0, index_t end0, index_t step0,
-                               index_t start1, index_t end1, index_t step1) {
-      for (index_t i = start0; i < end0; i += step0) {
-        for (index_t j = start1; j < end1; j += step1) {
-          index_t end_i = std::min(i + tile_size, height);
-          index_t end_j = std::min(j + tile_size, width);
-          for (index_t tile_i = i; tile_i < end_i; ++tile_i) {
-            for (index_t tile_j = j; tile_j < end_j; ++tile_j) {
-              output[tile_j * stride_i + tile_i] =
-                  input[tile_i * stride_j + tile_j];
-            }
-          }
-        }
-      }
-    }, 0, height, tile_size, 0, width, tile_size);
-  } else if (input_shape.size() == 4) {
+  if (rank == 4) {
     std::vector<int> transpose_order_from_NHWC_to_NCHW{0, 3, 1, 2};
     std::vector<int> transpose_order_from_NCHW_to_NHWC{0, 2, 3, 1};
     index_t batch_size = input_shape[1] * input_shape[2] * input_shape[3];
@@ -213,6 +365,7 @@ MaceStatus Transpose(utils::ThreadPool *thread_pool,
                               input_shape[1],
                               input_shape[2]);
       }
+      return MaceStatus::MACE_SUCCESS;
     } else if (dst_dims == transpose_order_from_NCHW_to_NHWC
         && input_shape[1] == 2) {
       for (index_t b = 0; b < input_shape[0]; ++b) {
@@ -222,152 +375,106 @@ MaceStatus Transpose(utils::ThreadPool *thread_pool,
                               input_shape[2],
                               input_shape[3]);
       }
-    } else if (dst_dims == std::vector<int>{0, 2, 1, 3}) {
-      index_t height = input_shape[1];
-      index_t width = input_shape[2];
-      index_t channel = input_shape[3];
-      index_t stride_i = height;
-      index_t stride_j = width;
-      index_t tile_size = std::max(static_cast<index_t>(1),
-                                   static_cast<index_t>(std::sqrt(
-                                       8 * 1024 / channel)));
-      for (index_t b = 0; b < input_shape[0]; ++b) {
-        auto input_offset = input + b * batch_size;
-        auto output_offset = output + b * batch_size;
-        for (index_t i = 0; i < height; i += tile_size) {
-          for (index_t j = 0; j < width; j += tile_size) {
-            index_t end_i = std::min(i + tile_size, height);
-            index_t end_j = std::min(j + tile_size, width);
-            for (index_t tile_i = i; tile_i < end_i; ++tile_i) {
-              for (index_t tile_j = j; tile_j < end_j; ++tile_j) {
-                auto output_ptr =
-                    output_offset + (tile_j * stride_i + tile_i) * channel;
-                auto input_ptr =
-                    input_offset + (tile_i * stride_j + tile_j) * channel;
-                for (index_t k = 0; k < channel; ++k) {
-                  output_ptr[k] = input_ptr[k];
-                }
-              }
-            }
-          }
-        }
-      }
-    } else {
-      std::vector<index_t>
-          in_stride{input_shape[1] * input_shape[2] * input_shape[3],
-                    input_shape[2] * input_shape[3], input_shape[3], 1};
-      std::vector<index_t>
-          out_stride{output_shape[1] * output_shape[2] * output_shape[3],
-                     output_shape[2] * output_shape[3], output_shape[3], 1};
-
-      std::vector<index_t> idim(4, 0);
-      std::vector<index_t> odim(4, 0);
-      for (odim[0] = 0; odim[0] < output_shape[0]; ++odim[0]) {
-        for (odim[1] = 0; odim[1] < output_shape[1]; ++odim[1]) {
-          for (odim[2] = 0; odim[2] < output_shape[2]; ++odim[2]) {
-            for (odim[3] = 0; odim[3] < output_shape[3]; ++odim[3]) {
-              idim[dst_dims[0]] = odim[0];
-              idim[dst_dims[1]] = odim[1];
-              idim[dst_dims[2]] = odim[2];
-              idim[dst_dims[3]] = odim[3];
-
-              output[odim[0] * out_stride[0] + odim[1] * out_stride[1]
-                  + odim[2] * out_stride[2] + odim[3]] =
-                  input[idim[0] * in_stride[0] + idim[1] * in_stride[1]
-                      + idim[2] * in_stride[2] + idim[3]];
-            }
-          }
-        }
-      }
+      return MaceStatus::MACE_SUCCESS;
     }
-  } else if (input_shape.size() == 3) {
-    const index_t batch = input_shape[0];
-    const index_t height = input_shape[1];
-    const index_t width = input_shape[2];
-    if (dst_dims == std::vector<int>{0, 2, 1}) {
-      index_t stride_h = height;
-      index_t stride_w = width;
-      index_t stride_hw = height * width;
-      index_t tile_size = height > 512 || width > 512 ? 64 : 32;
-
-      thread_pool->Compute3D([=](index_t start, index_t end, index_t step,
-                                 index_t start0, index_t end0, index_t step0,
-                                 index_t start1, index_t end1, index_t step1) {
-        for (index_t b = start; b < end; b += step) {
-          for (index_t i = start0; i < end0; i += step0) {
-            for (index_t j = start1; j < end1; j += step1) {
-              index_t end_i = std::min(i + tile_size, height);
-              index_t end_j = std::min(j + tile_size, width);
-              for (index_t tile_i = i; tile_i < end_i; ++tile_i) {
-                for (index_t tile_j = j; tile_j < end_j; ++tile_j) {
-                  output[b * stride_hw + tile_j * stride_h + tile_i] =
-                      input[b * stride_hw + tile_i * stride_w + tile_j];
-                }
-              }
-            }
-          }
-        }
-      }, 0, batch, 1, 0, height, tile_size, 0, width, tile_size);
-    } else if (dst_dims == std::vector<int>{1, 0, 2}) {
-      thread_pool->Compute2D([=](index_t start0, index_t end0, index_t step0,
-                                 index_t start1, index_t end1, index_t step1) {
-        for (int i = start0; i < end0; i += step0) {
-          for (int j = start1; j < end1; j += step1) {
-            auto output_ptr = output + (j * batch + i) * width;
-            auto input_ptr = input + (i * height + j) * width;
-            for (index_t k = 0; k < width; ++k) {
-              output_ptr[k] = input_ptr[k];
-            }
-          }
-        }
-      }, 0, batch, 1, 0, height, 1);
-    } else if (dst_dims == std::vector<int>{1, 2, 0}) {
-      thread_pool->Compute3D([=](index_t start, index_t end, index_t step,
-                                 index_t start0, index_t end0, index_t step0,
-                                 index_t start1, index_t end1, index_t step1) {
-        for (int i = start; i < end; i += step) {
-          for (int j = start0; j < end0; j += step0) {
-            for (int k = start1; k < end1; k += step1) {
-              output[(j * width + k) * batch + i] =
-                  input[(i * height + j) * width + k];
-            }
-          }
-        }
-      }, 0, batch, 1, 0, height, 1, 0, width, 1);
-    } else if (dst_dims == std::vector<int>{2, 0, 1}) {
-      thread_pool->Compute3D([=](index_t start, index_t end, index_t step,
-                                 index_t start0, index_t end0, index_t step0,
-                                 index_t start1, index_t end1, index_t step1) {
-        for (int i = start; i < end; i += step) {
-          for (int j = start0; j < end0; j += step0) {
-            for (int k = start1; k < end1; k += step1) {
-              output[(k * batch + i) * height + j] =
-                  input[(i * height + j) * width + k];
-            }
-          }
-        }
-      }, 0, batch, 1, 0, height, 1, 0, width, 1);
-    } else if (dst_dims == std::vector<int>{2, 1, 0}) {
-      thread_pool->Compute3D([=](index_t start, index_t end, index_t step,
-                                 index_t start0, index_t end0, index_t step0,
-                                 index_t start1, index_t end1, index_t step1) {
-        for (int i = start; i < end; i += step) {
-          for (int j = start0; j < end0; j += step0) {
-            for (int k = start1; k < end1; k += step1) {
-              output[(k * height + j) * batch + i] =
-                  input[(i * height + j) * width + k];
-            }
-          }
-        }
-      }, 0, batch, 1, 0, height, 1, 0, width, 1);
-    } else {
-      MACE_CHECK(false, "no need to transform.");
+  }
+
+  std::vector<index_t> shape;
+  std::vector<int> dims;
+  SimplifyTranspose(input_shape, dst_dims, &shape, &dims);
+  const int merged_rank = static_cast<int>(shape.size());
+  index_t size = 1;
+  for (index_t dim : shape) {
+    size *= dim;
+  }
+  if (size == 0) {
+    return MaceStatus::MACE_SUCCESS;
+  } else if (merged_rank <= 1) {
+    TransposeCopyRow(input, output, size);
+    return MaceStatus::MACE_SUCCESS;
+  }
+
+  std::vector<index_t> in_strides(merged_rank, 1);
+  std::vector<index_t> out_strides(merged_rank, 1);
+  for (int i = merged_rank - 2; i >= 0; --i) {
+    in_strides[i] = in_strides[i + 1] * shape[i + 1];
+    out_strides[i] = out_strides[i + 1] * shape[dims[i + 1]];
+  }
+
+  const int last_axis = merged_rank - 1;
+  if (dims[last_axis] == last_axis) {
+    // Innermost axis kept, copy rows
+    std::vector<index_t> outer_sizes;
+    std::vector<index_t> outer_in_strides;
+    std::vector<index_t> outer_out_strides;
+    for (int i = 0; i < last_axis; ++i) {
+      outer_sizes.push_back(shape[dims[i]]);
+      outer_in_strides.push_back(in_strides[dims[i]]);
+      outer_out_strides.push_back(out_strides[i]);
     }
+    const index_t row_size = shape[last_axis];
+    thread_pool->Compute1D([=](index_t start, index_t end, index_t step) {
+      MACE_UNUSED(step);
+      TransposeOuterIterator outer(outer_sizes, outer_in_strides,
+                                   outer_out_strides, start);
+      for (index_t i = start; i < end; ++i) {
+        TransposeCopyRow(input + outer.in_offset(),
+                         output + outer.out_offset(), row_size);
+        outer.Next();
+      }
+    }, 0, size / row_size, 1);
+    return MaceStatus::MACE_SUCCESS;
+  }
 
-  } else {
-    MACE_NOT_IMPLEMENTED;
+  // The rows of the innermost output axis and the innermost input axis are
+  // transposed tile by tile, the other axes are walked outside.
+  const int row_axis = dims[last_axis];
+  int col_pos = 0;
+  while (dims[col_pos] != last_axis) {
+    ++col_pos;
+  }
+  std::vector<index_t> outer_sizes;
+  std::vector<index_t> outer_in_strides;
+  std::vector<index_t> outer_out_strides;
+  for (int i = 0; i < last_axis; ++i) {
+    if (i != col_pos) {
+      outer_sizes.push_back(shape[dims[i]]);
+      outer_in_strides.push_back(in_strides[dims[i]]);
+      outer_out_strides.push_back(out_strides[i]);
+    }
   }
 
+  const index_t rows = shape[row_axis];
+  const index_t cols = shape[last_axis];
+  const index_t row_in_stride = in_strides[row_axis];
+  const index_t col_out_stride = out_strides[col_pos];
+  const index_t tile_size = rows > 512 || cols > 512 ? 64 : 32;
+  const index_t row_tiles = RoundUpDiv(rows, tile_size);
+  const index_t col_tiles = RoundUpDiv(cols, tile_size);
+  const index_t tile_count = row_tiles * col_tiles;
+  const index_t outer_count = size / (rows * cols);
+
+  thread_pool->Compute1D([=](index_t start, index_t end, index_t step) {
+    MACE_UNUSED(step);
+    TransposeOuterIterator outer(outer_sizes, outer_in_strides,
+                                 outer_out_strides, start / tile_count);
+    index_t tile = start % tile_count;
+    for (index_t i = start; i < end; ++i) {
+      const index_t r = tile / col_tiles * tile_size;
+      const index_t c = tile % col_tiles * tile_size;
+      TransposeTile(input + outer.in_offset() + r * row_in_stride + c,
+                    row_in_stride,
+                    output + outer.out_offset() + c * col_out_stride + r,
+                    col_out_stride,
+                    std::min(tile_size, rows - r),
+                    std::min(tile_size, cols - c));
+      if (++tile == tile_count) {
+        tile = 0;
+        outer.Next();
+      }
+    }
+  }, 0, outer_count * tile_count, 1);
+
   return MaceStatus::MACE_SUCCESS;
 }
 
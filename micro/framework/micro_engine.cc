@@ -106,6 +106,35 @@ MaceMicroEngineConfig *MaceMicroEngine::GetEngineConfig() {
   return engine_config_;
 }
 
+MaceStatus MaceMicroEngine::SetProfiler(MaceMicroProfiler *profiler) {
+  MACE_ASSERT1(initialized_ == true, "The engine has not initialized.");
+  if (profiler != NULL) {
+    MACE_ASSERT1(profiler->op_stats_ != NULL
+                     && profiler->op_stat_size_ >= GetOpSize(),
+                 "The profiler has not enough op stats.");
+    profiler->scratch_peak_ = 0;
+  }
+  engine_config_->profiler_ = profiler;
+  return MACE_SUCCESS;
+}
+
+uint32_t MaceMicroEngine::GetOpSize() {
+  MACE_ASSERT1(initialized_ == true, "The engine has not initialized.");
+  return engine_config_->net_def_->op_size();
+}
+
+MaceStatus MaceMicroEngine::GetOpInfo(const uint32_t op_def_idx,
+                                      const char **op_name,
+                                      const char **op_type) {
+  MACE_ASSERT(op_def_idx < GetOpSize());
+  MACE_ASSERT(op_name != NULL && op_type != NULL);
+
+  const model::OperatorDef *op_def = engine_config_->net_def_->op(op_def_idx);
+  *op_name = op_def->name();
+  *op_type = op_def->type();
+  return MACE_SUCCESS;
+}
+
 MaceStatus CreateMaceMicroEngineFromBinary(uint8_t *model_data,
                                            uint32_t size,
                                            framework::Operator **op_array,
@@ -130,6 +159,8 @@ MaceStatus CreateMaceMicroEngineFromBinary(uint8_t *model_data,
 
   auto tensor_mem = new uint8_t[header->tensor_mem_size];
   auto scratch_buffer = new uint8_t[header->scratch_buffer_size];
+  const uint32_t scratch_buffer_size =
+      static_cast<uint32_t>(header->scratch_buffer_size);
 
   const void **input_buffers = new const void *[input_num];
   const int32_t **input_shapes = new const int32_t *[input_num];
@@ -148,7 +179,8 @@ MaceStatus CreateMaceMicroEngineFromBinary(uint8_t *model_data,
                                        input_buffers,
                                        input_shapes,
                                        scratch_buffer,
-                                       static_cast<uint32_t>(header->scratch_buffer_size)};
+                                       scratch_buffer_size,
+                                       NULL};
   return (*engine)->Init(engine_config);
 }
 
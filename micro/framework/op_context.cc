@@ -14,14 +14,31 @@
 
 #include "micro/framework/op_context.h"
 
+#include "micro/base/utils.h"
 #include "micro/framework/operator.h"
 #include "micro/model/net_def.h"
 #include "micro/model/operator_def.h"
 #include "micro/include/public/micro.h"
+#include "micro/port/api.h"
 
 namespace micro {
 namespace framework {
 
+namespace {
+uint32_t GetDataTypeSize(DataType data_type) {
+  switch (data_type) {
+    case DT_UINT8:
+      return 1;
+    case DT_HALF:
+    case DT_FLOAT16:
+    case DT_BFLOAT16:
+      return 2;
+    default:
+      return 4;
+  }
+}
+}  // namespace
+
 MACE_DEFINE_OBJECT_FUNC(OpContext, uint32_t, op_idx)
 
 MACE_DEFINE_PTR_ARRAY_FUNC(OpContext, OpIOInfo, input_info, input_infos_)
@@ -46,7 +63,49 @@ MaceStatus OpContext::Init(MaceMicroEngineConfig *engine_config,
 }
 
 MaceStatus OpContext::Run(MaceMicroEngineConfig *engine_config) {
-  return engine_config->op_array_[op_idx()]->Run();
+  Operator *op = engine_config->op_array_[op_idx()];
+  MaceMicroProfiler *profiler = engine_config->profiler_;
+  if (profiler == NULL) {
+    return op->Run();
+  }
+
+  profiler->scratch_peak_ = 0;
+  const int64_t start_micros = port::api::NowMicros();
+  const int64_t start_cycles = port::api::NowCycles();
+  MaceStatus status = op->Run();
+  const int64_t end_cycles = port::api::NowCycles();
+  const int64_t end_micros = port::api::NowMicros();
+
+  uint32_t op_i = op_idx();
+  MACE_ASSERT(op_i < profiler->op_stat_size_);
+  MaceMicroOpStat *op_stat = profiler->op_stats_ + op_i;
+  op_stat->cycles_ += end_cycles - start_cycles;
+  op_stat->micros_ += end_micros - start_micros;
+  ++op_stat->run_count_;
+  op_stat->scratch_bytes_ =
+      base::max(op_stat->scratch_bytes_, profiler->scratch_peak_);
+
+  // The outputs' shape may be resized by the op, so compute the arena usage
+  // after running it.
+  const model::OperatorDef *op_def = engine_config->net_def_->op(op_i);
+  uint32_t output_bytes = 0;
+  uint32_t tensor_mem_end = 0;
+  const uint32_t output_size = base::min(op_def->mem_offset_size(),
+                                         output_resize_shape_size());
+  for (uint32_t i = 0; i < output_size; ++i) {
+    const model::OutputShape *output_shape = output_resize_shape(i);
+    const DataType data_type = i < op_def->output_type_size() ?
+                               op_def->output_type(i) : DT_FLOAT;
+    const uint32_t bytes = GetDataTypeSize(data_type) * static_cast<uint32_t>(
+        base::GetShapeSize(output_shape->dim_size(), output_shape->dim()));
+    output_bytes += bytes;
+    tensor_mem_end = base::max(
+        tensor_mem_end, static_cast<uint32_t>(op_def->mem_offset(i)) + bytes);
+  }
+  op_stat->output_bytes_ = output_bytes;
+  op_stat->tensor_mem_end_ = tensor_mem_end;
+
+  return status;
 }
 
 }  // namespace framework
@@ -55,6 +55,11 @@ void *ScratchBuffer::DoGetBuffer(uint32_t size) {
   void *ptr = engine_config_->scratch_buffer_ + offset_;
   offset_ += size;
 
+  MaceMicroProfiler *profiler = engine_config_->profiler_;
+  if (profiler != NULL && offset_ > profiler->scratch_peak_) {
+    profiler->scratch_peak_ = offset_;
+  }
+
   return ptr;
 }
 
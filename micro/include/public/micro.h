@@ -63,6 +63,25 @@ class Graph;
 class Operator;
 }  // namespace framework
 
+// Per-op statistics accumulated while a profiler is attached to the engine.
+struct MaceMicroOpStat {
+  int64_t cycles_;          // accumulated cycles of all the runs
+  int64_t micros_;          // accumulated microseconds of all the runs
+  uint32_t run_count_;
+  uint32_t output_bytes_;   // bytes of the op's outputs in the tensor arena
+  uint32_t tensor_mem_end_;  // end offset of the op's outputs in the arena
+  uint32_t scratch_bytes_;  // peak bytes requested from the scratch buffer
+};
+
+// The op_stats_ buffer is owned by the caller and should hold at least
+// MaceMicroEngine::GetOpSize() items, all zeroed before the first run.
+struct MaceMicroProfiler {
+  MaceMicroOpStat *op_stats_;
+  uint32_t op_stat_size_;
+  // Scratch buffer high-water mark of the running op, used internally.
+  uint32_t scratch_peak_;
+};
+
 struct MaceMicroEngineConfig {
   model::NetDef *net_def_;
   const uint8_t *model_data_;
@@ -73,6 +92,7 @@ struct MaceMicroEngineConfig {
   const int32_t **input_shapes_;
   uint8_t *scratch_buffer_;
   uint32_t scratch_buffer_size_;
+  MaceMicroProfiler *profiler_;
 };
 
 class MaceMicroEngine {
@@ -97,6 +117,13 @@ class MaceMicroEngine {
 
   MaceMicroEngineConfig *GetEngineConfig();
 
+  // Attaches a profiler to collect per-op cost, NULL to detach it.
+  MaceStatus SetProfiler(MaceMicroProfiler *profiler);
+  uint32_t GetOpSize();
+  MaceStatus GetOpInfo(const uint32_t op_def_idx,
+                       const char **op_name,
+                       const char **op_type);
+
  private:
   MaceMicroEngineConfig *engine_config_;
   bool initialized_;
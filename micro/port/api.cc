@@ -53,6 +53,27 @@ int64_t NowMicros() {
 #endif
 }
 
+int64_t NowCycles() {
+#ifdef MACE_MICRO_ENABLE_HEXAGON_HAP
+  return static_cast<int64_t>(HAP_perf_get_pcycles());
+#elif defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+  uint32_t low = 0;
+  uint32_t high = 0;
+  __asm__ __volatile__("rdtsc" : "=a"(low), "=d"(high));
+  return static_cast<int64_t>((static_cast<uint64_t>(high) << 32) | low);
+#elif defined(__linux__) && defined(__aarch64__)
+  uint64_t counter = 0;
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(counter));
+  return static_cast<int64_t>(counter);
+#elif __linux__
+  return NowMicros();
+#else
+  // you should rewrite this file in the platform source file,
+  // e.g., read the DWT->CYCCNT register on Cortex-M.
+  return -1;
+#endif
+}
+
 void Abort() {
   // you should rewrite this file in the platform source file.
   abort();
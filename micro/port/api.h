@@ -23,6 +23,9 @@ namespace api {
 
 void DebugLog(const char *str);
 int64_t NowMicros();
+// Returns the value of the finest free-running counter of the platform,
+// the CPU cycle counter if available, used for op profiling.
+int64_t NowCycles();
 void Abort();
 
 }  // api
@@ -39,6 +39,7 @@ MaceMicroEngineConfig kTmpMicroEngineConfig = {
     NULL,  // input_shapes_;
     kScratchBuffer,
     kScratchBufferSize,
+    NULL,  // profiler_;
 };
 
 MaceStatus Operator::Init(MaceMicroEngineConfig *engine_config,
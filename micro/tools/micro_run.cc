@@ -20,6 +20,8 @@
  *           --output_shape=1,224,224,2   \
  *           --input_file=input_data \
  *           --output_file=micro.out
+ *
+ * Add --benchmark to report the per-op cycles, time and arena usage.
  */
 
 #include <dirent.h>
@@ -28,12 +30,16 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <numeric>
+#include <string>
+#include <vector>
 
 #include "gflags/gflags.h"
 #include "micro/base/logging.h"
@@ -123,6 +129,91 @@ DEFINE_int32(restart_round, 1, "restart round");
 DEFINE_int32(malloc_check_cycle, -1, "malloc debug check cycle, -1 to disable");
 DEFINE_bool(benchmark, false, "enable benchmark op");
 
+void PrintOpStats(MaceMicroEngine *micro_engine,
+                  const std::vector<MaceMicroOpStat> &op_stats) {
+  const uint32_t op_size = micro_engine->GetOpSize();
+  int64_t total_cycles = 0;
+  int64_t total_micros = 0;
+  for (uint32_t i = 0; i < op_size; ++i) {
+    total_cycles += op_stats[i].cycles_;
+    total_micros += op_stats[i].micros_;
+  }
+  if (total_cycles <= 0) total_cycles = 1;
+
+  printf("==================================================="
+         "==================================================\n");
+  printf("Sort by Run Order\n");
+  printf("==================================================="
+         "==================================================\n");
+  printf("%4s %-20s %14s %10s %8s %8s %10s %10s %10s  %s\n",
+         "Idx", "Op Type", "Avg(cycles)", "Avg(ms)", "%", "cdf%",
+         "Output(B)", "Arena(B)", "Scratch(B)", "Name");
+  int64_t accumulate_cycles = 0;
+  uint32_t arena_peak = 0;
+  uint32_t scratch_peak = 0;
+  std::map<std::string, std::vector<int64_t>> type_stats;
+  for (uint32_t i = 0; i < op_size; ++i) {
+    const MaceMicroOpStat &op_stat = op_stats[i];
+    const char *op_name = NULL;
+    const char *op_type = NULL;
+    micro_engine->GetOpInfo(i, &op_name, &op_type);
+    const int64_t round = std::max<int64_t>(op_stat.run_count_, 1);
+    accumulate_cycles += op_stat.cycles_;
+    arena_peak = std::max(arena_peak, op_stat.tensor_mem_end_);
+    scratch_peak = std::max(scratch_peak, op_stat.scratch_bytes_);
+    printf("%4u %-20s %14lld %10.3f %8.3f %8.3f %10u %10u %10u  %s\n",
+           i, op_type, static_cast<long long>(op_stat.cycles_ / round),
+           op_stat.micros_ / 1000.0 / round,
+           op_stat.cycles_ * 100.0 / total_cycles,
+           accumulate_cycles * 100.0 / total_cycles,
+           op_stat.output_bytes_, op_stat.tensor_mem_end_,
+           op_stat.scratch_bytes_, op_name);
+
+    std::vector<int64_t> &type_stat = type_stats[op_type];
+    if (type_stat.empty()) type_stat.resize(3, 0);
+    type_stat[0] += 1;
+    type_stat[1] += op_stat.cycles_ / round;
+    type_stat[2] += op_stat.micros_ / round;
+  }
+
+  std::vector<std::pair<std::string, std::vector<int64_t>>> types(
+      type_stats.begin(), type_stats.end());
+  std::sort(types.begin(), types.end(),
+            [](const std::pair<std::string, std::vector<int64_t>> &lhs,
+               const std::pair<std::string, std::vector<int64_t>> &rhs) {
+              return lhs.second[1] > rhs.second[1];
+            });
+  int64_t round_cycles = 0;
+  for (size_t i = 0; i < types.size(); ++i) {
+    round_cycles += types[i].second[1];
+  }
+  if (round_cycles <= 0) round_cycles = 1;
+
+  printf("==================================================="
+         "==================================================\n");
+  printf("Stat by Op Type\n");
+  printf("==================================================="
+         "==================================================\n");
+  printf("%-20s %6s %14s %10s %8s %8s\n",
+         "Op Type", "Count", "Avg(cycles)", "Avg(ms)", "%", "cdf%");
+  double cdf = 0;
+  for (size_t i = 0; i < types.size(); ++i) {
+    const std::vector<int64_t> &type_stat = types[i].second;
+    const double percentage = type_stat[1] * 100.0 / round_cycles;
+    cdf += percentage;
+    printf("%-20s %6lld %14lld %10.3f %8.3f %8.3f\n",
+           types[i].first.c_str(), static_cast<long long>(type_stat[0]),
+           static_cast<long long>(type_stat[1]), type_stat[2] / 1000.0,
+           percentage, cdf);
+  }
+  printf("==================================================="
+         "==================================================\n");
+  printf("%u ops total, %.3f ms per round, tensor arena peak: %u bytes,"
+         " scratch buffer peak: %u bytes\n",
+         op_size, total_micros / 1000.0 / std::max(FLAGS_round, 1),
+         arena_peak, scratch_peak);
+}
+
 void GetOutputAndStoreToFile(MaceMicroEngine *micro_engine,
                              const std::vector<std::string> &output_names,
                              const std::string &prefix,
@@ -259,6 +350,21 @@ bool RunModel(const std::vector<std::string> &input_names,
       model_run_millis = total_run_duration / 1000.0 / FLAGS_round;
       LOG(INFO) << "Average latency: "
                 << static_cast<float>(model_run_millis) << " ms";
+
+      if (FLAGS_benchmark) {
+        LOG(INFO) << "Benchmark ops";
+        std::vector<MaceMicroOpStat> op_stats(micro_engine->GetOpSize());
+        memset(op_stats.data(), 0, op_stats.size() * sizeof(MaceMicroOpStat));
+        MaceMicroProfiler profiler = {
+            op_stats.data(), static_cast<uint32_t>(op_stats.size()), 0};
+        micro_engine->SetProfiler(&profiler);
+        for (int i = 0; i < FLAGS_round; ++i) {
+          status = micro_engine->Run();
+          MACE_ASSERT(status == MACE_SUCCESS);
+        }
+        micro_engine->SetProfiler(NULL);
+        PrintOpStats(micro_engine, op_stats);
+      }
     }
     GetOutputAndStoreToFile(micro_engine, output_names,
                             FLAGS_output_file + "_", "");
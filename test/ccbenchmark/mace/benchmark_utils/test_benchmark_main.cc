@@ -21,7 +21,9 @@
 DEFINE_string(filter, "all", "op benchmark regex filter, eg:.*CONV.*");
 DEFINE_int32(num_threads, -1, "num of threads");
 DEFINE_int32(cpu_affinity_policy, 1,
-             "0:AFFINITY_NONE/1:AFFINITY_BIG_ONLY/2:AFFINITY_LITTLE_ONLY");
+             "0:AFFINITY_NONE/1:AFFINITY_BIG_ONLY/2:AFFINITY_LITTLE_ONLY/"
+             "3:AFFINITY_HIGH_PERFORMANCE/4:AFFINITY_POWER_SAVE/"
+             "5:AFFINITY_PHYSICAL_CORES/6:AFFINITY_SINGLE_LLC");
 
 int main(int argc, char **argv) {
   std::string usage = "run ops benchmark\nusage: " + std::string(argv[0])
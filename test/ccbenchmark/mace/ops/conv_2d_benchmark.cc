@@ -224,6 +224,14 @@ MACE_BM_CONV_2D(1, 3, 224, 224, 3, 3, 2, 1, VALID, 32);
 // Dilations
 MACE_BM_CONV_2D(1, 32, 256, 256, 3, 3, 1, 2, VALID, 32);
 MACE_BM_CONV_2D(1, 32, 256, 256, 3, 3, 1, 4, VALID, 32);
+MACE_BM_CONV_2D(1, 3, 256, 256, 3, 3, 1, 2, VALID, 4);
+MACE_BM_CONV_2D(1, 256, 65, 65, 3, 3, 1, 6, VALID, 256);
+MACE_BM_CONV_2D(1, 256, 65, 65, 3, 3, 1, 12, VALID, 256);
+MACE_BM_CONV_2D(1, 32, 128, 128, 5, 5, 1, 2, VALID, 32);
+// TDNN layers
+MACE_BM_CONV_2D(1, 512, 1, 300, 1, 3, 1, 3, VALID, 512);
+MACE_BM_CONV_2D(1, 40, 1, 300, 1, 5, 1, 2, VALID, 4);
+MACE_BM_CONV_2D(1, 40, 300, 1, 5, 1, 1, 2, VALID, 4);
 
 // MobileNet
 MACE_BM_CONV_2D(1, 128, 56, 56, 1, 1, 1, 1, SAME, 128);
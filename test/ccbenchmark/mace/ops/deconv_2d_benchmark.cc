@@ -133,6 +133,11 @@ MACE_BM_DECONV_2D(1, 3, 224, 224, 3, 3, 2, 448, 448, SAME, 32);
 
 MACE_BM_DECONV_2D(1, 32, 1014, 762, 9, 9, 2, 2035, 1531, VALID, 1);
 
+// Decoder upsampling: segmentation head and super-resolution
+MACE_BM_DECONV_2D(1, 256, 32, 32, 4, 4, 2, 66, 66, VALID, 256);
+MACE_BM_DECONV_2D(1, 56, 64, 64, 9, 9, 3, 198, 198, VALID, 1);
+MACE_BM_DECONV_2D(1, 64, 64, 64, 6, 6, 3, 195, 195, VALID, 16);
+
 }  // namespace test
 }  // namespace ops
 }  // namespace mace
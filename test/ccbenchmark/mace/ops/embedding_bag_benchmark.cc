@@ -0,0 +1,108 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "mace/benchmark_utils/test_benchmark.h"
+#include "mace/ops/common/reduce_type.h"
+#include "mace/ops/ops_test_util.h"
+
+namespace mace {
+namespace ops {
+namespace test {
+
+namespace {
+template <RuntimeType D, typename T>
+void EmbeddingBagBenchmark(int iters,
+                           index_t num_bags,
+                           index_t bag_size,
+                           index_t vocab_len,
+                           index_t embedding_len,
+                           bool fused) {
+  mace::testing::StopTiming();
+  static unsigned int seed = time(NULL);
+
+  OpsTestNet net;
+  std::vector<int32_t> index(num_bags * bag_size);
+  for (size_t i = 0; i < index.size(); ++i) {
+    index[i] = rand_r(&seed) % vocab_len;
+  }
+  net.AddInputFromArray<D, int32_t>("Indices", {num_bags, bag_size}, index);
+  net.AddRandomInput<D, T>("Params", {vocab_len, embedding_len});
+
+  if (fused) {
+    OpDefBuilder("EmbeddingBag", "EmbeddingBagBM")
+        .Input("Params")
+        .Input("Indices")
+        .AddIntArg("reduce_type", static_cast<int>(ReduceType::SUM))
+        .AddIntArg("T", static_cast<int>(DataTypeToEnum<T>::value))
+        .Output("Output")
+        .Finalize(net.NewOperatorDef());
+  } else {
+    OpDefBuilder("Gather", "GatherBM")
+        .Input("Params")
+        .Input("Indices")
+        .AddIntArg("axis", 0)
+        .AddIntArg("T", static_cast<int>(DataTypeToEnum<T>::value))
+        .Output("Gathered")
+        .Finalize(net.NewOperatorDef());
+    OpDefBuilder("Reduce", "ReduceBM")
+        .Input("Gathered")
+        .AddIntsArg("axis", {1})
+        .AddIntArg("reduce_type", static_cast<int>(ReduceType::SUM))
+        .AddIntArg("has_data_format", 0)
+        .AddIntArg("T", static_cast<int>(DataTypeToEnum<T>::value))
+        .Output("Output")
+        .Finalize(net.AddNewOperatorDef());
+  }
+
+  // Warm-up
+  net.Setup(D);
+  for (int i = 0; i < 2; ++i) {
+    net.Run();
+  }
+  net.Sync();
+
+  mace::testing::StartTiming();
+  while (iters--) {
+    net.Run();
+  }
+  net.Sync();
+}
+}  // namespace
+
+#define MACE_BM_EMBEDDING_BAG_MACRO(N, BAG, VOC, EMBED, FUSED, TYPE, DEVICE) \
+  static void                                                              \
+      MACE_BM_EMBEDDING_BAG##_##N##_##BAG##_##VOC##_##EMBED##_##FUSED##_##  \
+          TYPE##_##DEVICE(int iters) {                                     \
+    const int64_t tot = static_cast<int64_t>(iters) * N * BAG * EMBED;     \
+    mace::testing::BytesProcessed(tot *(sizeof(TYPE)));                    \
+    EmbeddingBagBenchmark<DEVICE, TYPE>(iters, N, BAG, VOC, EMBED, FUSED); \
+  }                                                                        \
+  MACE_BENCHMARK(                                                          \
+      MACE_BM_EMBEDDING_BAG##_##N##_##BAG##_##VOC##_##EMBED##_##FUSED##_## \
+          TYPE##_##DEVICE)
+
+#define MACE_BM_EMBEDDING_BAG(N, BAG, VOCAB, EMBEDDING)                     \
+  MACE_BM_EMBEDDING_BAG_MACRO(N, BAG, VOCAB, EMBEDDING, true, float,        \
+                              RT_CPU);                                      \
+  MACE_BM_EMBEDDING_BAG_MACRO(N, BAG, VOCAB, EMBEDDING, false, float,       \
+                              RT_CPU);
+
+MACE_BM_EMBEDDING_BAG(32, 20, 48165, 64);
+MACE_BM_EMBEDDING_BAG(128, 50, 1000000, 64);
+
+}  // namespace test
+}  // namespace ops
+}  // namespace mace
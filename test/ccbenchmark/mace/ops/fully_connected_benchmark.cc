@@ -148,6 +148,15 @@ MACE_BM_FC(1, 8, 8, 32, 1000);
 MACE_BM_FC(1, 2, 2, 512, 2);
 MACE_BM_FC(1, 7, 7, 512, 2048);
 
+// Batched serving, the weight is reused across the batch
+MACE_BM_FC(1, 1, 1, 1024, 1024);
+MACE_BM_FC(2, 1, 1, 1024, 1024);
+MACE_BM_FC(4, 1, 1, 1024, 1024);
+MACE_BM_FC(8, 1, 1, 1024, 1024);
+MACE_BM_FC(16, 1, 1, 1024, 1024);
+MACE_BM_FC(32, 1, 1, 1024, 1024);
+MACE_BM_FC(64, 1, 1, 1024, 1024);
+
 }  // namespace test
 }  // namespace ops
 }  // namespace mace
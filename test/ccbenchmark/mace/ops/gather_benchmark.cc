@@ -32,8 +32,8 @@ void GatherBenchmark(int iters,
   static unsigned int seed = time(NULL);
 
   OpsTestNet net;
-  std::vector<int32_t> index(index_len);
-  for (int i = 0; i < index_len; ++i) {
+  std::vector<int32_t> index(n * index_len);
+  for (size_t i = 0; i < index.size(); ++i) {
     index[i] = rand_r(&seed) % vocab_len;
   }
   net.AddInputFromArray<D, int32_t>("Indices", {n, index_len}, index);
@@ -79,6 +79,7 @@ void GatherBenchmark(int iters,
 MACE_BM_GATHER(1, 7, 48165, 256);
 MACE_BM_GATHER(1, 20, 48165, 256);
 MACE_BM_GATHER(1, 100, 48165, 256);
+MACE_BM_GATHER(32, 100, 1000000, 64);
 
 }  // namespace test
 }  // namespace ops
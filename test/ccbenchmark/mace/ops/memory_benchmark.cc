@@ -17,6 +17,8 @@
 #include <vector>
 
 #include "mace/benchmark_utils/test_benchmark.h"
+#include "mace/runtimes/cpu/cpu_ref_allocator.h"
+#include "mace/utils/logging.h"
 
 namespace mace {
 namespace ops {
@@ -88,8 +90,60 @@ void MemoryAccessBenchmark_NHCW(
   }
 }
 
+// Touch one float per 4KB page in a scattered order, which is bound by TLB
+// misses (and remote memory latency when running on the wrong NUMA node).
+void PageAccessBenchmark(int iters, int megabytes,
+                         CPUMemoryPolicy policy, int numa_node) {
+  mace::testing::StopTiming();
+  CpuRefAllocator allocator;
+  allocator.SetMemoryPolicy(policy, numa_node);
+  const index_t bytes = static_cast<index_t>(megabytes) * 1024 * 1024;
+  MemInfo mem_info(MemoryType::CPU_BUFFER, DataType::DT_UINT8, {bytes});
+  void *data = nullptr;
+  MACE_CHECK_SUCCESS(allocator.New(mem_info, &data));
+  float *buffer = static_cast<float *>(data);
+  std::fill_n(buffer, bytes / sizeof(float), 0.1f);
+
+  const index_t page_stride = 4096 / sizeof(float);
+  // megabytes is a power of 2, so an odd step visits every page
+  const index_t page_mask = bytes / 4096 - 1;
+  const index_t page_step = 997;
+  mace::testing::StartTiming();
+
+  while (iters--) {
+    index_t page = 0;
+    for (index_t i = 0; i <= page_mask; ++i) {
+      buffer[page * page_stride] += 1.0f;
+      page = (page + page_step) & page_mask;
+    }
+  }
+
+  mace::testing::StopTiming();
+  allocator.Delete(data);
+}
+
 }  // namespace
 
+#define MACE_BM_PAGE_ACCESS(MB, POLICY, NUMA)                              \
+  static void MACE_BM_PAGE_ACCESS_##MB##MB_##POLICY##_NUMA##NUMA(          \
+      int iters) {                                                         \
+    const int64_t pages = static_cast<int64_t>(MB) * 1024 * 1024 / 4096;   \
+    mace::testing::BytesProcessed(                                         \
+        static_cast<int64_t>(iters) * pages * kCpuCacheLineSize);          \
+    PageAccessBenchmark(iters, MB, CPUMemoryPolicy::CPU_MEMORY_##POLICY,   \
+                        NUMA ? 0 : -1);                                    \
+  }                                                                        \
+  MACE_BENCHMARK(MACE_BM_PAGE_ACCESS_##MB##MB_##POLICY##_NUMA##NUMA)
+
+MACE_BM_PAGE_ACCESS(64, DEFAULT, 0);
+MACE_BM_PAGE_ACCESS(64, HUGE_PAGE, 0);
+MACE_BM_PAGE_ACCESS(64, EXPLICIT_HUGE_PAGE, 0);
+MACE_BM_PAGE_ACCESS(256, DEFAULT, 0);
+MACE_BM_PAGE_ACCESS(256, HUGE_PAGE, 0);
+MACE_BM_PAGE_ACCESS(256, EXPLICIT_HUGE_PAGE, 0);
+MACE_BM_PAGE_ACCESS(256, DEFAULT, 1);
+MACE_BM_PAGE_ACCESS(256, HUGE_PAGE, 1);
+
 #define MACE_BM_MEMORY_ACCESS(N, H, W, C, ORDER)                     \
   static void MACE_BM_MEMORY_ACCESS_##N##_##H##_##W##_##C##_##ORDER( \
       int iters) {                                                   \
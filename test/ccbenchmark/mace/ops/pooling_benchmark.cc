@@ -28,7 +28,8 @@ void Pooling(int iters,
              int channels,
              int height,
              int width,
-             int kernel,
+             int kernel_h,
+             int kernel_w,
              int stride,
              Padding padding,
              PoolingType pooling_type) {
@@ -56,7 +57,7 @@ void Pooling(int iters,
       .Input("Input")
       .Output("Output")
       .AddIntArg("pooling_type", pooling_type)
-      .AddIntsArg("kernels", {kernel, kernel})
+      .AddIntsArg("kernels", {kernel_h, kernel_w})
       .AddIntsArg("strides", {stride, stride})
       .AddIntArg("padding", padding)
       .AddIntsArg("dilations", {1, 1})
@@ -85,13 +86,31 @@ void Pooling(int iters,
           int iters) {                                                         \
     const int64_t tot = static_cast<int64_t>(iters) * N * C * H * W;           \
     mace::testing::BytesProcessed(tot *(sizeof(TYPE)));                        \
-    Pooling<DEVICE, TYPE>(iters, N, C, H, W, KE, STRIDE, Padding::PA,          \
+    Pooling<DEVICE, TYPE>(iters, N, C, H, W, KE, KE, STRIDE, Padding::PA,      \
                     PoolingType::PO);                                          \
   }                                                                            \
   MACE_BENCHMARK(                                                              \
       MACE_BM_POOLING_##N##_##C##_##H##_##W##_K##KE##S##STRIDE##_##PA##_##PO##_\
         ##TYPE##_##DEVICE)
 
+#define MACE_BM_POOLING_KHW_MACRO(                                             \
+    N, C, H, W, KH, KW, STRIDE, PA, PO, TYPE, DEVICE)                          \
+  static void                                                                  \
+      MACE_BM_POOLING_##N##_##C##_##H##_##W##_K##KH##x##KW##S##STRIDE##_##PA##_\
+        ##PO##_##TYPE##_##DEVICE(                                              \
+          int iters) {                                                         \
+    const int64_t tot = static_cast<int64_t>(iters) * N * C * H * W;           \
+    mace::testing::BytesProcessed(tot *(sizeof(TYPE)));                        \
+    Pooling<DEVICE, TYPE>(iters, N, C, H, W, KH, KW, STRIDE, Padding::PA,      \
+                    PoolingType::PO);                                          \
+  }                                                                            \
+  MACE_BENCHMARK(                                                              \
+      MACE_BM_POOLING_##N##_##C##_##H##_##W##_K##KH##x##KW##S##STRIDE##_##PA##_\
+        ##PO##_##TYPE##_##DEVICE)
+
+#define MACE_BM_POOLING_KHW(N, C, H, W, KH, KW, S, PA, PO)                    \
+  MACE_BM_POOLING_KHW_MACRO(N, C, H, W, KH, KW, S, PA, PO, float, RT_CPU)
+
 #if defined(MACE_ENABLE_OPENCL) && defined(MACE_ENABLE_QUANTIZE)
 #define MACE_BM_POOLING(N, C, H, W, K, S, PA, PO)       \
   MACE_BM_POOLING_MACRO(N, C, H, W, K, S, PA, PO, float, RT_CPU); \
@@ -120,6 +139,13 @@ MACE_BM_POOLING(1, 3, 1025, 1025, 2, 2, SAME, MAX);
 MACE_BM_POOLING(1, 32, 480, 640, 480, 640, VALID, AVG);
 MACE_BM_POOLING(1, 1024, 7, 7, 7, 1, VALID, AVG);
 
+// Large windows over time (audio) and global pooling of few big planes
+MACE_BM_POOLING_KHW(1, 64, 1, 1000, 1, 50, 1, SAME, AVG);
+MACE_BM_POOLING_KHW(1, 64, 1, 1000, 1, 50, 1, SAME, MAX);
+MACE_BM_POOLING_KHW(1, 32, 64, 64, 7, 7, 1, SAME, MAX);
+MACE_BM_POOLING_KHW(1, 2, 512, 512, 512, 512, 1, VALID, AVG);
+MACE_BM_POOLING_KHW(1, 2, 512, 512, 512, 512, 1, VALID, MAX);
+
 }  // namespace test
 }  // namespace ops
 }  // namespace mace
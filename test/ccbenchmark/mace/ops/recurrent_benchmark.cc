@@ -0,0 +1,86 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "mace/benchmark_utils/test_benchmark.h"
+#include "mace/ops/ops_test_util.h"
+
+namespace mace {
+namespace ops {
+namespace test {
+
+namespace {
+template <RuntimeType D, typename T>
+void Recurrent(int iters, const std::string &type, int seq_length, int batch,
+               int input_size, int hidden, int directions) {
+  mace::testing::StopTiming();
+
+  const int gates = type == "LSTM" ? 4 : 3;
+  OpsTestNet net;
+  net.AddRandomInput<D, T>("X", {seq_length, batch, input_size});
+  net.AddRandomInput<D, T>("W", {directions, gates * hidden, input_size},
+                           true);
+  net.AddRandomInput<D, T>("R", {directions, gates * hidden, hidden}, true);
+  net.AddRandomInput<D, T>("B", {directions, 2 * gates * hidden}, true);
+
+  OpDefBuilder(type.c_str(), "RecurrentBM")
+      .Input("X")
+      .Input("W")
+      .Input("R")
+      .Input("B")
+      .Output("Y")
+      .AddStringArg("direction",
+                    directions == 2 ? "bidirectional" : "forward")
+      .Finalize(net.NewOperatorDef());
+
+  // Warm-up
+  net.Setup(D);
+  for (int i = 0; i < 5; ++i) {
+    net.Run();
+  }
+  net.Sync();
+
+  mace::testing::StartTiming();
+  while (iters--) {
+    net.Run();
+  }
+  net.Sync();
+}
+}  // namespace
+
+#define MACE_BM_RECURRENT_MACRO(OP, T, N, I, H, DIR, TYPE, DEVICE)            \
+  static void MACE_BM_##OP##_##T##_##N##_##I##_##H##_##DIR##_##TYPE##_##DEVICE(\
+      int iters) {                                                            \
+    const int64_t gates = std::string(#OP) == "LSTM" ? 4 : 3;                 \
+    const int64_t macs = static_cast<int64_t>(iters) * T * N * DIR *          \
+        gates * H * (I + H);                                                  \
+    mace::testing::MacsProcessed(macs);                                       \
+    Recurrent<DEVICE, TYPE>(iters, #OP, T, N, I, H, DIR);                     \
+  }                                                                           \
+  MACE_BENCHMARK(                                                             \
+      MACE_BM_##OP##_##T##_##N##_##I##_##H##_##DIR##_##TYPE##_##DEVICE)
+
+#define MACE_BM_RECURRENT(OP, T, N, I, H, DIR) \
+  MACE_BM_RECURRENT_MACRO(OP, T, N, I, H, DIR, float, RT_CPU)
+
+MACE_BM_RECURRENT(LSTM, 100, 1, 256, 256, 1);
+MACE_BM_RECURRENT(LSTM, 100, 8, 256, 256, 1);
+MACE_BM_RECURRENT(LSTM, 50, 1, 128, 128, 2);
+MACE_BM_RECURRENT(GRU, 100, 1, 256, 256, 1);
+MACE_BM_RECURRENT(GRU, 50, 4, 128, 128, 2);
+
+}  // namespace test
+}  // namespace ops
+}  // namespace mace
@@ -55,6 +55,33 @@ void Reduce(int iters, int batch, int channels,
   }
   net.Sync();
 }
+
+// Reduces the channels of NCHW input, a non-innermost axis
+void ReduceChannels(int iters, int batch, int channels, int height,
+                    int width) {
+  mace::testing::StopTiming();
+
+  OpsTestNet net;
+  net.AddRandomInput<RuntimeType::RT_CPU, float>(
+      "Input", {batch, channels, height, width});
+
+  OpDefBuilder("Reduce", "ReduceBM")
+      .Input("Input")
+      .AddIntsArg("axis", {1})
+      .Output("Output")
+      .Finalize(net.NewOperatorDef());
+
+  // Warm-up
+  net.Setup(RuntimeType::RT_CPU);
+  for (int i = 0; i < 5; ++i) {
+    net.Run();
+  }
+
+  mace::testing::StartTiming();
+  while (iters--) {
+    net.Run();
+  }
+}
 }  // namespace
 
 #define MACE_BM_REDUCE_MACRO(N, C, H, W, TYPE, DEVICE)       \
@@ -86,6 +113,18 @@ MACE_BM_REDUCE(16, 32, 112, 112);
 MACE_BM_REDUCE(8, 64, 256, 256);
 MACE_BM_REDUCE(1, 32, 480, 640);
 
+#define MACE_BM_REDUCE_CHANNELS(N, C, H, W)                                \
+  static void MACE_BM_REDUCE_CHANNELS_##N##_##C##_##H##_##W(int iters) {  \
+    const int64_t tot = static_cast<int64_t>(iters) * N * C * H * W;     \
+    mace::testing::BytesProcessed(tot * sizeof(float));                  \
+    ReduceChannels(iters, N, C, H, W);                                   \
+  }                                                                      \
+  MACE_BENCHMARK(MACE_BM_REDUCE_CHANNELS_##N##_##C##_##H##_##W)
+
+MACE_BM_REDUCE_CHANNELS(1, 64, 56, 56);
+MACE_BM_REDUCE_CHANNELS(1, 1024, 7, 7);
+MACE_BM_REDUCE_CHANNELS(1, 256, 1, 1);
+
 
 }  // namespace test
 }  // namespace ops
@@ -0,0 +1,88 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/benchmark_utils/test_benchmark.h"
+#include "mace/ops/ops_test_util.h"
+
+namespace mace {
+namespace ops {
+namespace test {
+
+namespace {
+template <RuntimeType D, typename T>
+void TopK(int iters, int batch, int classes, int k) {
+  mace::testing::StopTiming();
+
+  OpsTestNet net;
+  net.AddRandomInput<D, T>("Input", {batch, classes});
+
+  if (k == 0) {
+    net.AddInputFromArray<D, int32_t>("Axis", {}, {-1});
+    OpDefBuilder("ArgMax", "ArgMaxBM")
+        .Input("Input")
+        .Input("Axis")
+        .Output("Output")
+        .OutputType({DT_INT32})
+        .AddIntArg("keepdims", 0)
+        .AddIntArg("T", static_cast<int>(DataTypeToEnum<T>::value))
+        .Finalize(net.NewOperatorDef());
+  } else {
+    OpDefBuilder("TopK", "TopKBM")
+        .Input("Input")
+        .Output("Values")
+        .Output("Indices")
+        .OutputType({DataTypeToEnum<T>::value, DT_INT32})
+        .AddIntArg("top_k", k)
+        .AddIntArg("T", static_cast<int>(DataTypeToEnum<T>::value))
+        .Finalize(net.NewOperatorDef());
+  }
+
+  // Warm-up
+  net.Setup(D);
+  for (int i = 0; i < 5; ++i) {
+    net.Run();
+  }
+  net.Sync();
+
+  mace::testing::StartTiming();
+  while (iters--) {
+    net.Run();
+  }
+  net.Sync();
+}
+}  // namespace
+
+// K = 0 benchmarks ArgMax.
+#define MACE_BM_TOP_K_MACRO(N, C, K, TYPE, DEVICE)                    \
+  static void MACE_BM_TOP_K_##N##_##C##_##K##_##TYPE##_##DEVICE(      \
+      int iters) {                                                    \
+    const int64_t tot = static_cast<int64_t>(iters) * N * C;          \
+    mace::testing::BytesProcessed(tot *(sizeof(TYPE)));               \
+    TopK<DEVICE, TYPE>(iters, N, C, K);                               \
+  }                                                                   \
+  MACE_BENCHMARK(MACE_BM_TOP_K_##N##_##C##_##K##_##TYPE##_##DEVICE)
+
+#define MACE_BM_TOP_K(N, C, K) \
+  MACE_BM_TOP_K_MACRO(N, C, K, float, RT_CPU)
+
+MACE_BM_TOP_K(1, 32000, 0);
+MACE_BM_TOP_K(1, 500000, 0);
+MACE_BM_TOP_K(16, 32000, 0);
+MACE_BM_TOP_K(1, 32000, 10);
+MACE_BM_TOP_K(1, 500000, 10);
+MACE_BM_TOP_K(16, 32000, 50);
+
+}  // namespace test
+}  // namespace ops
+}  // namespace mace
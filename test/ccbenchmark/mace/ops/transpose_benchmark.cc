@@ -87,6 +87,9 @@ MACE_BM_TRANSPOSE4D(1, 2, 512, 512, 0, 2, 3, 1);
 MACE_BM_TRANSPOSE4D(1, 64, 64, 512, 0, 3, 1, 2);
 MACE_BM_TRANSPOSE4D(1, 512, 64, 64, 0, 2, 3, 1);
 MACE_BM_TRANSPOSE4D(1, 4, 20, 64, 0, 2, 1, 3);
+MACE_BM_TRANSPOSE4D(1, 128, 12, 64, 0, 2, 1, 3);
+MACE_BM_TRANSPOSE4D(1, 12, 128, 64, 0, 2, 3, 1);
+MACE_BM_TRANSPOSE4D(8, 32, 64, 48, 3, 2, 0, 1);
 MACE_BM_TRANSPOSE2D(128, 128);
 MACE_BM_TRANSPOSE2D(512, 512);
 MACE_BM_TRANSPOSE2D(1024, 1024);
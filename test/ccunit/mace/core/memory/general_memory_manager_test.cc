@@ -0,0 +1,154 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mace/core/memory/general_memory_manager.h"
+#include "mace/runtimes/cpu/cpu_ref_allocator.h"
+
+namespace mace {
+namespace test {
+
+namespace {
+
+// Counts the allocations the arena makes
+class CountingAllocator : public Allocator {
+ public:
+  CountingAllocator() : new_count_(0), delete_count_(0) {}
+
+  MemoryType GetMemType() override { return allocator_.GetMemType(); }
+  MaceStatus New(const MemInfo &info, void **result) override {
+    ++new_count_;
+    return allocator_.New(info, result);
+  }
+  void Delete(void *data) override {
+    ++delete_count_;
+    allocator_.Delete(data);
+  }
+
+  int new_count() const { return new_count_; }
+  int delete_count() const { return delete_count_; }
+
+ private:
+  CpuRefAllocator allocator_;
+  int new_count_;
+  int delete_count_;
+};
+
+MemInfo BytesInfo(Allocator *allocator, index_t bytes) {
+  return MemInfo(allocator->GetMemType(), DT_UINT8, {bytes});
+}
+
+}  // namespace
+
+class ScratchArenaTest : public ::testing::Test {
+ protected:
+  const index_t kBytes = static_cast<index_t>(kMaceAlignment) * 4;
+};
+
+TEST_F(ScratchArenaTest, OverflowAndGrowToPeak) {
+  CountingAllocator allocator;
+  GeneralMemoryManager::ScratchArena arena(&allocator);
+
+  // Nothing is reserved yet, so every request of the first op overflows.
+  void *first = arena.ObtainMemory(BytesInfo(&allocator, kBytes));
+  void *second = arena.ObtainMemory(BytesInfo(&allocator, kBytes * 2));
+  EXPECT_NE(first, second);
+  EXPECT_EQ(allocator.new_count(), 2);
+  EXPECT_EQ(arena.GetMemoryRealSize(first), kBytes);
+  EXPECT_EQ(arena.GetMemoryRealSize(second), kBytes * 2);
+
+  // The release frees the overflow memory and grows the block to the peak.
+  arena.ReleaseAllMemory(false);
+  EXPECT_EQ(allocator.delete_count(), 2);
+  EXPECT_EQ(allocator.new_count(), 3);
+
+  // A smaller op after a bigger one still fits in the block.
+  void *small = arena.ObtainMemory(BytesInfo(&allocator, kBytes));
+  EXPECT_EQ(allocator.new_count(), 3);
+  arena.ReleaseAllMemory(false);
+  EXPECT_EQ(allocator.new_count(), 3);
+  EXPECT_EQ(arena.GetMemoryRealSize(small), 0);
+
+  // An op needing more than the block overflows once, then the block grows.
+  arena.ObtainMemory(BytesInfo(&allocator, kBytes * 2));
+  arena.ObtainMemory(BytesInfo(&allocator, kBytes * 2));
+  EXPECT_EQ(allocator.new_count(), 4);
+  arena.ReleaseAllMemory(false);
+  EXPECT_EQ(allocator.new_count(), 5);
+  EXPECT_EQ(allocator.delete_count(), 4);
+
+  arena.ReleaseAllMemory(true);
+  EXPECT_EQ(allocator.delete_count(), 5);
+}
+
+TEST_F(ScratchArenaTest, BumpAllocation) {
+  CountingAllocator allocator;
+  GeneralMemoryManager::ScratchArena arena(&allocator);
+  arena.ObtainMemory(BytesInfo(&allocator, kBytes * 3));
+  arena.ReleaseAllMemory(false);
+  const int new_count = allocator.new_count();
+
+  // Small requests are padded to the alignment and bumped out of the block.
+  uint8_t *first = static_cast<uint8_t *>(
+      arena.ObtainMemory(BytesInfo(&allocator, 1)));
+  uint8_t *second = static_cast<uint8_t *>(
+      arena.ObtainMemory(BytesInfo(&allocator, kBytes)));
+  uint8_t *third = static_cast<uint8_t *>(
+      arena.ObtainMemory(BytesInfo(&allocator, kBytes)));
+  EXPECT_EQ(second, first + kMaceAlignment);
+  EXPECT_EQ(third, second + kBytes);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(first) % kMaceAlignment, 0u);
+  EXPECT_EQ(arena.GetMemoryRealSize(first),
+            static_cast<index_t>(kMaceAlignment));
+  EXPECT_EQ(arena.GetMemoryRealSize(third), kBytes);
+  EXPECT_EQ(allocator.new_count(), new_count);
+
+  // Released memory is reused from the start of the block by the next op.
+  arena.ReleaseAllMemory(false);
+  EXPECT_EQ(arena.GetMemoryRealSize(second), 0);
+  EXPECT_EQ(arena.GetMemoryRealSize(third), 0);
+  EXPECT_EQ(arena.ObtainMemory(BytesInfo(&allocator, kBytes)), first);
+  EXPECT_EQ(allocator.new_count(), new_count);
+
+  int not_owned = 0;
+  EXPECT_EQ(arena.GetMemoryRealSize(&not_owned), -1);
+}
+
+TEST_F(ScratchArenaTest, MemoryManager) {
+  CountingAllocator allocator;
+  GeneralMemoryManager manager(&allocator, true);
+  const MemInfo info = BytesInfo(&allocator, kBytes);
+
+  for (int run = 0; run < 3; ++run) {
+    void *ptr = manager.ObtainMemory(info, RENT_SCRATCH);
+    EXPECT_EQ(manager.GetMemoryRealSize(ptr), std::vector<index_t>({kBytes}));
+    // Scratch memory is only given back with the rest of the op's.
+    manager.ReleaseMemory(ptr, RENT_SCRATCH);
+    manager.ReleaseAllMemory(RENT_SCRATCH, false);
+  }
+  // One overflow in the first run and the block, nothing after.
+  EXPECT_EQ(allocator.new_count(), 2);
+
+  // The other rent types still come from the pools.
+  void *shared = manager.ObtainMemory(info, RENT_SHARE);
+  EXPECT_EQ(allocator.new_count(), 3);
+  EXPECT_EQ(manager.GetMemoryRealSize(shared), std::vector<index_t>({kBytes}));
+  manager.ReleaseMemory(shared, RENT_SHARE);
+}
+
+}  // namespace test
+}  // namespace mace
@@ -0,0 +1,184 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mace/core/memory/weight_registry.h"
+
+namespace mace {
+namespace test {
+
+class WeightRegistryTest : public ::testing::Test {};
+
+TEST_F(WeightRegistryTest, ShareAndRelease) {
+  WeightRegistry *registry = WeightRegistry::Get();
+  const size_t base_count = registry->EntryCount();
+  const index_t base_bytes = registry->TotalBytes();
+  const std::vector<float> weight = {1.f, 2.f, 3.f, 4.f};
+  const index_t bytes = static_cast<index_t>(weight.size() * sizeof(float));
+  const std::string key = WeightRegistry::MakeKey(
+      weight.data(), bytes, "WeightRegistryTest.ShareAndRelease");
+  auto fill = [&weight, bytes](void *dst) {
+    memcpy(dst, weight.data(), static_cast<size_t>(bytes));
+  };
+
+  std::shared_ptr<void> first =
+      registry->Acquire(key, weight.data(), bytes, bytes, fill);
+  std::shared_ptr<void> second =
+      registry->Acquire(key, weight.data(), bytes, bytes, fill);
+  EXPECT_EQ(first.get(), second.get());
+  EXPECT_EQ(registry->EntryCount(), base_count + 1);
+  EXPECT_EQ(registry->TotalBytes(), base_bytes + bytes);
+
+  first.reset();
+  EXPECT_EQ(registry->TotalBytes(), base_bytes + bytes);
+  second.reset();
+  EXPECT_EQ(registry->EntryCount(), base_count);
+  EXPECT_EQ(registry->TotalBytes(), base_bytes);
+}
+
+TEST_F(WeightRegistryTest, ReplaceExpiredEntry) {
+  WeightRegistry *registry = WeightRegistry::Get();
+  const size_t base_count = registry->EntryCount();
+  const index_t base_bytes = registry->TotalBytes();
+  const std::vector<float> weight(64, 1.f);
+  const index_t bytes = static_cast<index_t>(weight.size() * sizeof(float));
+  const std::string key = WeightRegistry::MakeKey(
+      weight.data(), bytes, "WeightRegistryTest.ReplaceExpiredEntry");
+  auto fill = [&weight, bytes](void *dst) {
+    memcpy(dst, weight.data(), static_cast<size_t>(bytes));
+  };
+  std::shared_ptr<void> expired =
+      registry->Acquire(key, weight.data(), bytes, bytes, fill);
+
+  // Hold the registry lock in the fill of another key, so that the expired
+  // block is released only after the key is acquired again.
+  std::mutex mutex;
+  std::condition_variable cond;
+  bool filling = false;
+  bool done = false;
+  std::thread holder([&]() {
+    const std::string other_key = key + ":other";
+    registry->Acquire(other_key, weight.data(), bytes, bytes, [&](void *dst) {
+      fill(dst);
+      std::unique_lock<std::mutex> lock(mutex);
+      filling = true;
+      cond.notify_all();
+      cond.wait(lock, [&done]() { return done; });
+    });
+  });
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [&filling]() { return filling; });
+  }
+  std::shared_ptr<void> replaced;
+  std::thread acquirer([&]() {
+    replaced = registry->Acquire(key, weight.data(), bytes, bytes, fill);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  std::thread releaser([&expired]() { expired.reset(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    cond.notify_all();
+  }
+  holder.join();
+  acquirer.join();
+  releaser.join();
+
+  EXPECT_NE(replaced, nullptr);
+  EXPECT_EQ(registry->EntryCount(), base_count + 1);
+  EXPECT_EQ(registry->TotalBytes(), base_bytes + bytes);
+  replaced.reset();
+  EXPECT_EQ(registry->EntryCount(), base_count);
+  EXPECT_EQ(registry->TotalBytes(), base_bytes);
+}
+
+TEST_F(WeightRegistryTest, KeyCollision) {
+  WeightRegistry *registry = WeightRegistry::Get();
+  const size_t base_count = registry->EntryCount();
+  const index_t base_bytes = registry->TotalBytes();
+  const std::vector<float> weight = {1.f, 2.f, 3.f, 4.f};
+  const std::vector<float> other = {5.f, 6.f, 7.f, 8.f};
+  const index_t bytes = static_cast<index_t>(weight.size() * sizeof(float));
+  // Two different weights registered under one key, as if their hashes
+  // collided.
+  const std::string key = WeightRegistry::MakeKey(
+      weight.data(), bytes, "WeightRegistryTest.KeyCollision");
+  auto fill_from = [bytes](const std::vector<float> &src) {
+    return [&src, bytes](void *dst) {
+      memcpy(dst, src.data(), static_cast<size_t>(bytes));
+    };
+  };
+
+  std::shared_ptr<void> first = registry->Acquire(
+      key, weight.data(), bytes, bytes, fill_from(weight));
+  std::shared_ptr<void> second = registry->Acquire(
+      key, other.data(), bytes, bytes, fill_from(other));
+  std::shared_ptr<void> third = registry->Acquire(
+      key, weight.data(), bytes, bytes, fill_from(weight));
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_EQ(first.get(), third.get());
+  EXPECT_EQ(memcmp(second.get(), other.data(), bytes), 0);
+  EXPECT_EQ(registry->EntryCount(), base_count + 1);
+  EXPECT_EQ(registry->TotalBytes(), base_bytes + bytes);
+
+  second.reset();
+  EXPECT_EQ(registry->EntryCount(), base_count + 1);
+  first.reset();
+  third.reset();
+  EXPECT_EQ(registry->EntryCount(), base_count);
+  EXPECT_EQ(registry->TotalBytes(), base_bytes);
+}
+
+TEST_F(WeightRegistryTest, KeyCollisionConverted) {
+  WeightRegistry *registry = WeightRegistry::Get();
+  const std::vector<float> weight = {1.f, 2.f, 3.f, 4.f};
+  const std::vector<float> other = {5.f, 6.f, 7.f, 8.f};
+  const index_t bytes = static_cast<index_t>(weight.size() * sizeof(float));
+  const std::string key = WeightRegistry::MakeKey(
+      weight.data(), bytes, "WeightRegistryTest.KeyCollisionConverted");
+  // The block is a converted copy of the source, so the content produced by
+  // the fill is compared instead of the source.
+  auto fill_from = [](const std::vector<float> &src) {
+    return [&src](void *dst) {
+      float *dst_data = static_cast<float *>(dst);
+      for (size_t i = 0; i < src.size(); ++i) {
+        dst_data[i] = src[i] * 2.f;
+      }
+    };
+  };
+
+  std::shared_ptr<void> first = registry->Acquire(
+      key, weight.data(), bytes, bytes, fill_from(weight));
+  std::shared_ptr<void> second = registry->Acquire(
+      key, other.data(), bytes, bytes, fill_from(other));
+  std::shared_ptr<void> third = registry->Acquire(
+      key, weight.data(), bytes, bytes, fill_from(weight));
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_EQ(first.get(), third.get());
+  EXPECT_EQ(static_cast<float *>(second.get())[3], 16.f);
+}
+
+}  // namespace test
+}  // namespace mace
@@ -12,9 +12,21 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <utility>
+
 #include "mace/core/memory/memory_manager.h"
+#include "mace/core/memory/weight_registry.h"
 #include "mace/core/proto/arg_helper.h"
+#include "mace/flows/cpu/transpose_const.h"
+#include "mace/libmace/engines/engine_snapshot.h"
 #include "mace/libmace/mace_api_test.h"
+#include "mace/ops/common/eltwise_type.h"
 #ifdef MACE_ENABLE_OPENCL
 #include "mace/runtimes/opencl/opencl_runtime.h"
 #endif  // MACE_ENABLE_OPENCL
@@ -123,7 +135,8 @@ void MaceRun(const int in_out_size,
              const std::vector<std::vector<int64_t>> &input_shapes,
              const std::vector<std::vector<int64_t>> &output_shapes,
              const std::vector<int64_t> &filter_shape,
-             const MemoryType in_out_mt = CPU_BUFFER) {
+             const MemoryType in_out_mt = CPU_BUFFER,
+             const bool command_replay = false) {
   std::vector<std::string> input_names;
   std::vector<std::string> output_names;
   for (int i = 0; i < in_out_size; ++i) {
@@ -162,6 +175,7 @@ void MaceRun(const int in_out_size,
 #ifdef MACE_ENABLE_OPENCL
   config.SetGPUContext(mace::ops::test::OpTestContext::Get()->gpu_context());
 #endif  // MACE_ENABLE_OPENCL
+  config.SetGPUCommandReplay(command_replay);
   SetProtoArg(net_def, "runtime_type", static_cast<int>(D));
   auto mem_type = (D == RT_OPENCL ? GPU_IMAGE : CPU_BUFFER);
   SetProtoArg(net_def, "opencl_mem_type", static_cast<int>(mem_type));
@@ -257,5 +271,729 @@ TEST_F(MaceAPITest, VariableInputShape) {
                            {16, 16, 3, 3});
 }
 
+TEST_F(MaceAPITest, GPUCommandReplay) {
+  MaceRun<RT_OPENCL, float>(1,
+                            {1, 32, 32, 16},
+                            {{1, 32, 32, 16}},
+                            {{1, 32, 32, 16}},
+                            {16, 16, 3, 3},
+                            CPU_BUFFER, true);
+  MaceRun<RT_OPENCL, half>(2,
+                           {1, 32, 64, 16},
+                           {{1, 16, 32, 16}, {1, 32, 64, 16}},
+                           {{1, 16, 32, 16}, {1, 32, 64, 16}},
+                           {16, 16, 3, 3},
+                           CPU_BUFFER, true);
+}
+
+namespace {
+
+// input0 -> Conv3x3(filter) -> output0, running on CPU
+void BuildCpuConvNet(const std::vector<int64_t> &shape,
+                     const std::vector<int64_t> &filter_shape,
+                     MultiNetDef *multi_net_def,
+                     std::vector<float> *data) {
+  NetDef *net_def = multi_net_def->add_net_def();
+  ops::test::GenerateRandomRealTypeData<float>(filter_shape, data);
+  AddTensor<float>("filter", filter_shape, 0, data->size(), net_def);
+  InputOutputInfo *input_info = net_def->add_input_info();
+  input_info->set_data_format(static_cast<int>(DataFormat::NHWC));
+  input_info->set_name("input0");
+  for (auto d : shape) {
+    input_info->add_dims(static_cast<int>(d));
+  }
+  multi_net_def->add_input_tensor("input0");
+  net_def->add_output_info()->set_name("output0");
+  multi_net_def->add_output_tensor("output0");
+  Conv3x3<float>("input0", "filter", "output0", shape, net_def);
+  SetProtoArg(net_def, "runtime_type", static_cast<int>(RT_CPU));
+}
+
+}  // namespace
+
+#ifdef MACE_ENABLE_OPENCL
+TEST_F(MaceAPITest, GPUProgramBuildInBackground) {
+  // The GPU engine builds the programs of its ops in background, the
+  // application serves with a CPU engine of the same model meanwhile.
+  const std::vector<int64_t> shape = {1, 16, 16, 8};
+  const std::vector<int64_t> filter_shape = {8, 8, 3, 3};
+  std::vector<std::string> input_names = {"input0"};
+  std::vector<std::string> output_names = {"output0"};
+
+  std::shared_ptr<MultiNetDef> cpu_multi_net_def(new MultiNetDef());
+  std::vector<float> data;
+  BuildCpuConvNet(shape, filter_shape, cpu_multi_net_def.get(), &data);
+  std::shared_ptr<MultiNetDef> gpu_multi_net_def(
+      new MultiNetDef(*cpu_multi_net_def));
+  NetDef *gpu_net_def = gpu_multi_net_def->mutable_net_def(0);
+  SetProtoArg(gpu_net_def, "runtime_type", static_cast<int>(RT_OPENCL));
+  SetProtoArg(gpu_net_def, "opencl_mem_type", static_cast<int>(GPU_IMAGE));
+
+  MaceEngineConfig cpu_config;
+  MaceEngine cpu_engine(cpu_config);
+  EXPECT_EQ(cpu_engine.Init(cpu_multi_net_def.get(), input_names,
+                            output_names,
+                            reinterpret_cast<unsigned char *>(data.data()),
+                            data.size() * sizeof(float)),
+            MaceStatus::MACE_SUCCESS);
+  MaceEngineConfig gpu_config;
+  gpu_config.SetGPUContext(
+      mace::ops::test::OpTestContext::Get()->gpu_context());
+  EXPECT_EQ(gpu_config.SetGPUProgramBuildPolicy(2, true),
+            MaceStatus::MACE_SUCCESS);
+  MaceEngine gpu_engine(gpu_config);
+  EXPECT_EQ(gpu_engine.Init(gpu_multi_net_def.get(), input_names,
+                            output_names,
+                            reinterpret_cast<unsigned char *>(data.data()),
+                            data.size() * sizeof(float)),
+            MaceStatus::MACE_SUCCESS);
+
+  std::map<std::string, mace::MaceTensor> inputs;
+  std::map<std::string, mace::MaceTensor> outputs;
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::minutes(1);
+  while (!gpu_engine.IsGPUReady() &&
+         std::chrono::steady_clock::now() < deadline) {
+    GenerateInputs(input_names, shape, &inputs, CPU_BUFFER);
+    GenerateOutputs(output_names, shape, &outputs, CPU_BUFFER);
+    EXPECT_EQ(cpu_engine.Run(inputs, &outputs), MaceStatus::MACE_SUCCESS);
+    CheckOutputs<RT_CPU, float>(cpu_multi_net_def->net_def(0), inputs,
+                                outputs, data);
+  }
+  EXPECT_TRUE(gpu_engine.IsGPUReady());
+
+  // Twice, the ops set their kernel arguments again after the fake warmup
+  // of Init.
+  for (int i = 0; i < 2; ++i) {
+    GenerateInputs(input_names, shape, &inputs, CPU_BUFFER);
+    GenerateOutputs(output_names, shape, &outputs, CPU_BUFFER);
+    EXPECT_EQ(gpu_engine.Run(inputs, &outputs), MaceStatus::MACE_SUCCESS);
+    CheckOutputs<RT_OPENCL, float>(*gpu_net_def, inputs, outputs, data);
+  }
+}
+#endif  // MACE_ENABLE_OPENCL
+
+TEST_F(MaceAPITest, WeightSharing) {
+  const std::vector<int64_t> shape = {1, 16, 16, 8};
+  const std::vector<int64_t> filter_shape = {8, 8, 3, 3};
+  std::vector<std::string> input_names = {"input0"};
+  std::vector<std::string> output_names = {"output0"};
+
+  std::shared_ptr<MultiNetDef> multi_net_def(new MultiNetDef());
+  std::vector<float> data;
+  BuildCpuConvNet(shape, filter_shape, multi_net_def.get(), &data);
+  const NetDef *net_def = &multi_net_def->net_def(0);
+
+  WeightRegistry *registry = WeightRegistry::Get();
+  const size_t base_count = registry->EntryCount();
+  const index_t base_bytes = registry->TotalBytes();
+  MaceEngineConfig config;
+  EXPECT_EQ(config.SetWeightSharing(true), MaceStatus::MACE_SUCCESS);
+  std::vector<std::shared_ptr<MaceEngine>> engines;
+  size_t shared_count = 0;
+  index_t shared_bytes = 0;
+  for (int i = 0; i < 2; ++i) {
+    engines.emplace_back(std::make_shared<MaceEngine>(config));
+    bool model_data_unused = false;
+    MaceStatus status = engines.back()->Init(
+        multi_net_def.get(), input_names, output_names,
+        reinterpret_cast<unsigned char *>(data.data()),
+        data.size() * sizeof(float), &model_data_unused);
+    EXPECT_EQ(status, MaceStatus::MACE_SUCCESS);
+    EXPECT_TRUE(model_data_unused);
+    if (i == 0) {
+      shared_count = registry->EntryCount();
+      shared_bytes = registry->TotalBytes();
+      EXPECT_GT(shared_count, base_count);
+      EXPECT_GT(shared_bytes, base_bytes);
+    } else {
+      // The second engine takes the blocks of the first one.
+      EXPECT_EQ(registry->EntryCount(), shared_count);
+      EXPECT_EQ(registry->TotalBytes(), shared_bytes);
+    }
+  }
+
+  // The weights are copied, so the model data can go away.
+  std::vector<float> expected_filter = data;
+  std::fill(data.begin(), data.end(), 0.f);
+  for (auto &engine : engines) {
+    std::map<std::string, mace::MaceTensor> inputs;
+    std::map<std::string, mace::MaceTensor> outputs;
+    GenerateInputs(input_names, shape, &inputs, CPU_BUFFER);
+    GenerateOutputs(output_names, shape, &outputs, CPU_BUFFER);
+    EXPECT_EQ(engine->Run(inputs, &outputs), MaceStatus::MACE_SUCCESS);
+    CheckOutputs<RT_CPU, float>(*net_def, inputs, outputs, expected_filter);
+  }
+
+  engines.pop_back();
+  EXPECT_EQ(registry->EntryCount(), shared_count);
+  EXPECT_EQ(registry->TotalBytes(), shared_bytes);
+  engines.clear();
+  EXPECT_EQ(registry->EntryCount(), base_count);
+  EXPECT_EQ(registry->TotalBytes(), base_bytes);
+}
+
+TEST_F(MaceAPITest, Snapshot) {
+  const std::vector<int64_t> shape = {1, 16, 16, 8};
+  const std::vector<int64_t> filter_shape = {8, 8, 3, 3};
+  std::vector<std::string> input_names = {"input0"};
+  std::vector<std::string> output_names = {"output0"};
+
+  std::shared_ptr<MultiNetDef> multi_net_def(new MultiNetDef());
+  std::vector<float> data;
+  BuildCpuConvNet(shape, filter_shape, multi_net_def.get(), &data);
+  const NetDef *net_def = &multi_net_def->net_def(0);
+
+  const std::string snapshot_file = "mace_api_test_snapshot.bin";
+  {
+    // The graph is not kept unless snapshot is enabled.
+    MaceEngineConfig config;
+    MaceEngine engine(config);
+    EXPECT_EQ(engine.Init(multi_net_def.get(), input_names, output_names,
+                          reinterpret_cast<unsigned char *>(data.data()),
+                          data.size() * sizeof(float)),
+              MaceStatus::MACE_SUCCESS);
+    EXPECT_EQ(engine.SaveSnapshot(snapshot_file),
+              MaceStatus::MACE_INVALID_ARGS);
+  }
+  std::map<std::string, mace::MaceTensor> inputs;
+  std::map<std::string, mace::MaceTensor> outputs;
+  GenerateInputs(input_names, shape, &inputs, CPU_BUFFER);
+  GenerateOutputs(output_names, shape, &outputs, CPU_BUFFER);
+  {
+    MaceEngineConfig config;
+    config.SetEngineSnapshot(true);
+    MaceEngine engine(config);
+    EXPECT_EQ(engine.Init(multi_net_def.get(), input_names, output_names,
+                          reinterpret_cast<unsigned char *>(data.data()),
+                          data.size() * sizeof(float)),
+              MaceStatus::MACE_SUCCESS);
+    EXPECT_EQ(engine.Run(inputs, &outputs), MaceStatus::MACE_SUCCESS);
+    EXPECT_EQ(engine.SaveSnapshot(snapshot_file), MaceStatus::MACE_SUCCESS);
+  }
+
+  // The graph is saved as adapted to CPU, with the memory plan of the net.
+  MultiNetDef snapshot_def;
+  EXPECT_EQ(ReadEngineSnapshot(snapshot_file, &snapshot_def),
+            MaceStatus::MACE_SUCCESS);
+  const NetDef &snapshot_net_def = snapshot_def.net_def(0);
+  const int adapted = ProtoArgHelper::GetOptionalArg<NetDef, int>(
+      snapshot_net_def, "adapted_graph", 0);
+  EXPECT_EQ(1, adapted);
+  const std::vector<int64_t> mem_blocks =
+      ProtoArgHelper::GetRepeatedArgs<NetDef, int64_t>(snapshot_net_def,
+                                                       "mem_blocks");
+  EXPECT_FALSE(mem_blocks.empty());
+  EXPECT_LT(0, snapshot_net_def.op_size());
+  for (auto &op : snapshot_net_def.op()) {
+    EXPECT_EQ(op.output_size(), op.mem_id_size());
+  }
+
+  MaceEngineConfig config;
+  config.SetEngineSnapshot(true);
+  std::shared_ptr<MaceEngine> engine;
+  EXPECT_EQ(CreateMaceEngineFromSnapshot(snapshot_file, config, &engine),
+            MaceStatus::MACE_SUCCESS);
+  EXPECT_EQ(engine->Run(inputs, &outputs), MaceStatus::MACE_SUCCESS);
+  CheckOutputs<RT_CPU, float>(*net_def, inputs, outputs, data);
+  engine.reset();
+
+  // A snapshot saved from a restored engine is usable as well.
+  const std::string resaved_file = snapshot_file + ".resaved";
+  EXPECT_EQ(CreateMaceEngineFromSnapshot(snapshot_file, config, &engine),
+            MaceStatus::MACE_SUCCESS);
+  EXPECT_EQ(engine->SaveSnapshot(resaved_file), MaceStatus::MACE_SUCCESS);
+  EXPECT_EQ(CreateMaceEngineFromSnapshot(resaved_file, config, &engine),
+            MaceStatus::MACE_SUCCESS);
+  EXPECT_EQ(engine->Run(inputs, &outputs), MaceStatus::MACE_SUCCESS);
+  CheckOutputs<RT_CPU, float>(*net_def, inputs, outputs, data);
+  engine.reset();
+  remove(snapshot_file.c_str());
+  remove(resaved_file.c_str());
+}
+
+TEST_F(MaceAPITest, SnapshotTransposedWeight) {
+  // The NHWC const operand of Eltwise is transposed for CPU at init time.
+  const std::vector<int64_t> shape = {1, 16, 16, 8};
+  std::vector<std::string> input_names = {"input0"};
+  std::vector<std::string> output_names = {"output0"};
+  MultiNetDef multi_net_def;
+  NetDef *net_def = multi_net_def.add_net_def();
+  std::vector<float> data;
+  ops::test::GenerateRandomRealTypeData<float>(shape, &data);
+  AddTensor<float>("addend", shape, 0, data.size(), net_def);
+  InputOutputInfo *input_info = net_def->add_input_info();
+  input_info->set_data_format(static_cast<int>(DataFormat::NHWC));
+  input_info->set_name("input0");
+  for (auto d : shape) {
+    input_info->add_dims(static_cast<int>(d));
+  }
+  multi_net_def.add_input_tensor("input0");
+  net_def->add_output_info()->set_name("output0");
+  multi_net_def.add_output_tensor("output0");
+  ops::test::OpDefBuilder("Eltwise", "EltwiseTest")
+      .Input("addend")
+      .Input("input0")
+      .Output("output0")
+      .AddIntArg("type", static_cast<int>(ops::EltwiseType::SUM))
+      .AddIntArg("T", static_cast<int>(DataType::DT_FLOAT))
+      .AddIntArg("data_format", static_cast<int>(DataFormat::AUTO))
+      .Finalize(net_def->add_op());
+  SetProtoArg(net_def, "runtime_type", static_cast<int>(RT_CPU));
+
+  std::map<std::string, mace::MaceTensor> inputs;
+  std::map<std::string, mace::MaceTensor> expected_outputs;
+  GenerateInputs(input_names, shape, &inputs, CPU_BUFFER);
+  GenerateOutputs(output_names, shape, &expected_outputs, CPU_BUFFER);
+  const std::string snapshot_file = "mace_api_test_transposed_snapshot.bin";
+  {
+    MaceEngineConfig config;
+    config.SetEngineSnapshot(true);
+    MaceEngine engine(config);
+    EXPECT_EQ(engine.Init(&multi_net_def, input_names, output_names,
+                          reinterpret_cast<unsigned char *>(data.data()),
+                          data.size() * sizeof(float)),
+              MaceStatus::MACE_SUCCESS);
+    EXPECT_EQ(engine.Run(inputs, &expected_outputs), MaceStatus::MACE_SUCCESS);
+    EXPECT_EQ(engine.SaveSnapshot(snapshot_file), MaceStatus::MACE_SUCCESS);
+  }
+
+  // Only the transposed copy is saved, as the original one is dead.
+  MultiNetDef snapshot_def;
+  EXPECT_EQ(ReadEngineSnapshot(snapshot_file, &snapshot_def),
+            MaceStatus::MACE_SUCCESS);
+  const NetDef &snapshot_net_def = snapshot_def.net_def(0);
+  EXPECT_EQ(1, snapshot_net_def.tensors_size());
+  EXPECT_EQ(std::string("addend") + kCpuConstSuffix,
+            snapshot_net_def.tensors(0).name());
+  EXPECT_EQ(snapshot_net_def.tensors(0).name(),
+            snapshot_net_def.op(0).input(0));
+
+  MaceEngineConfig config;
+  std::shared_ptr<MaceEngine> engine;
+  EXPECT_EQ(CreateMaceEngineFromSnapshot(snapshot_file, config, &engine),
+            MaceStatus::MACE_SUCCESS);
+  std::map<std::string, mace::MaceTensor> outputs;
+  GenerateOutputs(output_names, shape, &outputs, CPU_BUFFER);
+  EXPECT_EQ(engine->Run(inputs, &outputs), MaceStatus::MACE_SUCCESS);
+  const float *expected = expected_outputs["output0"].data<float>().get();
+  const float *output = outputs["output0"].data<float>().get();
+  for (size_t i = 0; i < data.size(); ++i) {
+    EXPECT_EQ(expected[i], output[i]);
+  }
+  engine.reset();
+  remove(snapshot_file.c_str());
+}
+
+TEST_F(MaceAPITest, SnapshotPackedWeight) {
+  // The fully connected op packs its weight for a batch of 4, the packed
+  // copy is saved and taken by the restored engine.
+  const std::vector<int64_t> shape = {4, 1, 1, 16};
+  const std::vector<int64_t> weight_shape = {8, 16, 1, 1};
+  const std::vector<int64_t> output_shape = {4, 1, 1, 8};
+  std::vector<std::string> input_names = {"input0"};
+  std::vector<std::string> output_names = {"output0"};
+  MultiNetDef multi_net_def;
+  NetDef *net_def = multi_net_def.add_net_def();
+  std::vector<float> data;
+  ops::test::GenerateRandomRealTypeData<float>(weight_shape, &data);
+  AddTensor<float>("weight", weight_shape, 0, data.size(), net_def);
+  InputOutputInfo *input_info = net_def->add_input_info();
+  input_info->set_data_format(static_cast<int>(DataFormat::NHWC));
+  input_info->set_name("input0");
+  for (auto d : shape) {
+    input_info->add_dims(static_cast<int>(d));
+  }
+  multi_net_def.add_input_tensor("input0");
+  net_def->add_output_info()->set_name("output0");
+  multi_net_def.add_output_tensor("output0");
+  ops::test::OpDefBuilder("FullyConnected", "FullyConnectedTest")
+      .Input("input0")
+      .Input("weight")
+      .Output("output0")
+      .AddIntArg("T", static_cast<int>(DataType::DT_FLOAT))
+      .AddIntArg("data_format", static_cast<int>(DataFormat::AUTO))
+      .Finalize(net_def->add_op());
+  SetProtoArg(net_def, "runtime_type", static_cast<int>(RT_CPU));
+
+  std::map<std::string, mace::MaceTensor> inputs;
+  std::map<std::string, mace::MaceTensor> expected_outputs;
+  GenerateInputs(input_names, shape, &inputs, CPU_BUFFER);
+  GenerateOutputs(output_names, output_shape, &expected_outputs, CPU_BUFFER);
+  const std::string snapshot_file = "mace_api_test_packed_snapshot.bin";
+  {
+    MaceEngineConfig config;
+    config.SetEngineSnapshot(true);
+    MaceEngine engine(config);
+    EXPECT_EQ(engine.Init(&multi_net_def, input_names, output_names,
+                          reinterpret_cast<unsigned char *>(data.data()),
+                          data.size() * sizeof(float)),
+              MaceStatus::MACE_SUCCESS);
+    EXPECT_EQ(engine.Run(inputs, &expected_outputs), MaceStatus::MACE_SUCCESS);
+    EXPECT_EQ(engine.SaveSnapshot(snapshot_file), MaceStatus::MACE_SUCCESS);
+  }
+
+  MultiNetDef snapshot_def;
+  EXPECT_EQ(ReadEngineSnapshot(snapshot_file, &snapshot_def),
+            MaceStatus::MACE_SUCCESS);
+  bool packed_saved = false;
+  for (auto &const_tensor : snapshot_def.net_def(0).tensors()) {
+    packed_saved |= const_tensor.name().find("weight_gemm_") == 0;
+  }
+  EXPECT_TRUE(packed_saved);
+
+  MaceEngineConfig config;
+  std::shared_ptr<MaceEngine> engine;
+  EXPECT_EQ(CreateMaceEngineFromSnapshot(snapshot_file, config, &engine),
+            MaceStatus::MACE_SUCCESS);
+  std::map<std::string, mace::MaceTensor> outputs;
+  GenerateOutputs(output_names, output_shape, &outputs, CPU_BUFFER);
+  EXPECT_EQ(engine->Run(inputs, &outputs), MaceStatus::MACE_SUCCESS);
+  const float *expected = expected_outputs["output0"].data<float>().get();
+  const float *output = outputs["output0"].data<float>().get();
+  for (int i = 0; i < 4 * 8; ++i) {
+    EXPECT_EQ(expected[i], output[i]);
+  }
+  engine.reset();
+  remove(snapshot_file.c_str());
+}
+
+TEST_F(MaceAPITest, ArgLookup) {
+  OperatorDef op_def;
+  // The last one wins if an argument is duplicated.
+  ops::test::OpDefBuilder("Conv2D", "ArgLookupTest")
+      .AddIntArg("padding", 1)
+      .AddIntsArg("strides", {2, 2})
+      .AddFloatArg("scale", 0.5f)
+      .AddIntArg("padding", 3)
+      .Finalize(&op_def);
+
+  int padding = ProtoArgHelper::GetOptionalArg<OperatorDef, int>(
+      op_def, "padding", 0);
+  EXPECT_EQ(padding, 3);
+  float scale = ProtoArgHelper::GetOptionalArg<OperatorDef, float>(
+      op_def, "scale", 1.0f);
+  EXPECT_EQ(scale, 0.5f);
+  int missing = ProtoArgHelper::GetOptionalArg<OperatorDef, int>(
+      op_def, "not_exist", 7);
+  EXPECT_EQ(missing, 7);
+  std::vector<int> strides =
+      ProtoArgHelper::GetRepeatedArgs<OperatorDef, int>(op_def, "strides");
+  EXPECT_EQ(strides, std::vector<int>({2, 2}));
+  std::vector<int> dilations =
+      ProtoArgHelper::GetRepeatedArgs<OperatorDef, int>(op_def, "dilations",
+                                                        {1, 1});
+  EXPECT_EQ(dilations, std::vector<int>({1, 1}));
+  EXPECT_TRUE(ProtoArgHelper::ExistArg(op_def, "strides"));
+  EXPECT_FALSE(ProtoArgHelper::ExistArg(op_def, "dilations"));
+
+  ProtoArgHelper arg_helper(op_def);
+  EXPECT_EQ(arg_helper.GetOptionalArg<int>("padding", 0), 3);
+  EXPECT_EQ(arg_helper.GetRepeatedArgs<int>("strides"),
+            std::vector<int>({2, 2}));
+  EXPECT_FALSE(arg_helper.ExistArg("not_exist"));
+}
+
+TEST_F(MaceAPITest, CPUMemoryPolicy) {
+  // Big enough for the tensors to be mapped page by page
+  const std::vector<int64_t> shape = {1, 128, 128, 32};
+  const std::vector<int64_t> filter_shape = {32, 32, 3, 3};
+  std::vector<std::string> input_names = {"input0"};
+  std::vector<std::string> output_names = {"output0"};
+
+  std::shared_ptr<MultiNetDef> multi_net_def(new MultiNetDef());
+  std::vector<float> data;
+  BuildCpuConvNet(shape, filter_shape, multi_net_def.get(), &data);
+  const NetDef *net_def = &multi_net_def->net_def(0);
+
+  for (auto policy : {CPU_MEMORY_HUGE_PAGE, CPU_MEMORY_EXPLICIT_HUGE_PAGE}) {
+    MaceEngineConfig config;
+    EXPECT_EQ(config.SetCPUMemoryPolicy(policy, 0), MaceStatus::MACE_SUCCESS);
+    MaceEngine engine(config);
+    EXPECT_EQ(engine.Init(multi_net_def.get(), input_names, output_names,
+                          reinterpret_cast<unsigned char *>(data.data()),
+                          data.size() * sizeof(float)),
+              MaceStatus::MACE_SUCCESS);
+    std::map<std::string, mace::MaceTensor> inputs;
+    std::map<std::string, mace::MaceTensor> outputs;
+    GenerateInputs(input_names, shape, &inputs, CPU_BUFFER);
+    GenerateOutputs(output_names, shape, &outputs, CPU_BUFFER);
+    EXPECT_EQ(engine.Run(inputs, &outputs), MaceStatus::MACE_SUCCESS);
+    CheckOutputs<RT_CPU, float>(*net_def, inputs, outputs, data);
+  }
+}
+
+TEST_F(MaceAPITest, Calibration) {
+  const std::vector<int64_t> shape = {1, 32, 32, 8};
+  const std::vector<int64_t> filter_shape = {8, 8, 3, 3};
+  std::vector<std::string> input_names = {"input0"};
+  std::vector<std::string> output_names = {"output0"};
+
+  std::shared_ptr<MultiNetDef> multi_net_def(new MultiNetDef());
+  std::vector<float> data;
+  BuildCpuConvNet(shape, filter_shape, multi_net_def.get(), &data);
+
+  {
+    MaceEngineConfig config;
+    MaceEngine engine(config);
+    EXPECT_EQ(engine.Init(multi_net_def.get(), input_names, output_names,
+                          reinterpret_cast<unsigned char *>(data.data()),
+                          data.size() * sizeof(float)),
+              MaceStatus::MACE_SUCCESS);
+    std::map<std::string, std::pair<float, float>> ranges;
+    EXPECT_EQ(engine.GetCalibrationRanges(&ranges),
+              MaceStatus::MACE_INVALID_ARGS);
+  }
+
+  std::vector<std::map<std::string, mace::MaceTensor>> samples(4);
+  for (auto &inputs : samples) {
+    GenerateInputs(input_names, shape, &inputs, CPU_BUFFER);
+  }
+  const std::vector<std::pair<CalibrationMethod, float>> methods = {
+      {CALIBRATION_MIN_MAX, 100.f}, {CALIBRATION_PERCENTILE, 100.f},
+      {CALIBRATION_PERCENTILE, 99.f}, {CALIBRATION_KL_DIVERGENCE, 100.f}};
+  for (const auto &method : methods) {
+    MaceEngineConfig config;
+    EXPECT_EQ(config.SetCalibration(method.first, method.second),
+              MaceStatus::MACE_SUCCESS);
+    MaceEngine engine(config);
+    EXPECT_EQ(engine.Init(multi_net_def.get(), input_names, output_names,
+                          reinterpret_cast<unsigned char *>(data.data()),
+                          data.size() * sizeof(float)),
+              MaceStatus::MACE_SUCCESS);
+
+    float output_min = std::numeric_limits<float>::max();
+    float output_max = std::numeric_limits<float>::lowest();
+    for (auto &inputs : samples) {
+      std::map<std::string, mace::MaceTensor> outputs;
+      GenerateOutputs(output_names, shape, &outputs, CPU_BUFFER);
+      EXPECT_EQ(engine.Run(inputs, &outputs), MaceStatus::MACE_SUCCESS);
+      const float *output_data = outputs["output0"].data().get();
+      const int64_t size = std::accumulate(shape.begin(), shape.end(), 1,
+                                           std::multiplies<int64_t>());
+      for (int64_t i = 0; i < size; ++i) {
+        output_min = std::min(output_min, output_data[i]);
+        output_max = std::max(output_max, output_data[i]);
+      }
+    }
+
+    std::map<std::string, std::pair<float, float>> ranges;
+    EXPECT_EQ(engine.GetCalibrationRanges(&ranges), MaceStatus::MACE_SUCCESS);
+    ASSERT_EQ(ranges.count("output0"), 1u);
+    const auto &range = ranges["output0"];
+    if (method.second == 100.f && method.first != CALIBRATION_KL_DIVERGENCE) {
+      EXPECT_EQ(range.first, output_min);
+      EXPECT_EQ(range.second, output_max);
+    } else {
+      EXPECT_LT(range.first, range.second);
+      EXPECT_GE(range.first, output_min);
+      EXPECT_LE(range.second, output_max);
+    }
+    if (method.first == CALIBRATION_PERCENTILE && method.second < 100.f) {
+      EXPECT_GT(range.first, output_min);
+      EXPECT_LT(range.second, output_max);
+    }
+
+    const std::string range_file = "mace_api_test_quantize_range";
+    EXPECT_EQ(engine.SaveCalibrationRanges(range_file),
+              MaceStatus::MACE_SUCCESS);
+    std::ifstream range_stream(range_file);
+    std::string line;
+    bool found = false;
+    while (std::getline(range_stream, line)) {
+      const size_t separator = line.find("@@");
+      ASSERT_NE(separator, std::string::npos);
+      if (line.substr(0, separator) == "output0") {
+        found = true;
+        float min = 0;
+        float max = 0;
+        ASSERT_EQ(sscanf(line.c_str() + separator + 2, "%f,%f", &min, &max),
+                  2);
+        EXPECT_EQ(min, range.first);
+        EXPECT_EQ(max, range.second);
+      }
+    }
+    EXPECT_TRUE(found);
+    remove(range_file.c_str());
+  }
+}
+
+TEST_F(MaceAPITest, InputPreprocess) {
+  const std::vector<int64_t> shape = {1, 16, 20, 3};
+  const std::vector<int64_t> image_shape = {1, 21, 27, 3};
+  const std::vector<int64_t> filter_shape = {3, 3, 3, 3};
+  std::vector<std::string> input_names = {"input0"};
+  std::vector<std::string> output_names = {"output0"};
+
+  std::shared_ptr<MultiNetDef> multi_net_def(new MultiNetDef());
+  std::vector<float> data;
+  BuildCpuConvNet(shape, filter_shape, multi_net_def.get(), &data);
+  const NetDef *net_def = &multi_net_def->net_def(0);
+
+  InputPreprocess preprocess;
+  preprocess.source_order = PIXEL_BGR;
+  preprocess.model_order = PIXEL_RGB;
+  preprocess.mean = {123.675f, 116.28f, 103.53f};
+  preprocess.std = {58.395f, 57.12f, 57.375f};
+  preprocess.crop_top = 3;
+  preprocess.crop_left = 5;
+  preprocess.crop_height = 16;
+  preprocess.crop_width = 20;
+
+  MaceEngineConfig config;
+  InputPreprocess zero_std = preprocess;
+  zero_std.std[1] = 0.f;
+  EXPECT_EQ(config.SetInputPreprocess("input0", zero_std),
+            MaceStatus::MACE_INVALID_ARGS);
+  EXPECT_EQ(config.SetInputPreprocess("input0", preprocess),
+            MaceStatus::MACE_SUCCESS);
+  MaceEngine engine(config);
+  EXPECT_EQ(engine.Init(multi_net_def.get(), input_names, output_names,
+                        reinterpret_cast<unsigned char *>(data.data()),
+                        data.size() * sizeof(float)),
+            MaceStatus::MACE_SUCCESS);
+
+  const int64_t image_size = std::accumulate(
+      image_shape.begin(), image_shape.end(), 1, std::multiplies<int64_t>());
+  std::shared_ptr<uint8_t> pixels(new uint8_t[image_size],
+                                  std::default_delete<uint8_t[]>());
+  for (int64_t i = 0; i < image_size; ++i) {
+    pixels.get()[i] = static_cast<uint8_t>((i * 37 + 11) % 256);
+  }
+  std::shared_ptr<float> expected_input(
+      new float[shape[1] * shape[2] * shape[3]],
+      std::default_delete<float[]>());
+  for (int64_t h = 0; h < shape[1]; ++h) {
+    for (int64_t w = 0; w < shape[2]; ++w) {
+      for (int64_t c = 0; c < 3; ++c) {
+        const uint8_t pixel = pixels.get()[
+            ((h + 3) * image_shape[2] + w + 5) * 3 + 2 - c];
+        expected_input.get()[(h * shape[2] + w) * 3 + c] =
+            (pixel - preprocess.mean[c]) / preprocess.std[c];
+      }
+    }
+  }
+
+  std::map<std::string, mace::MaceTensor> image_inputs;
+  image_inputs["input0"] = mace::MaceTensor(image_shape, pixels,
+                                            DataFormat::NHWC, IDT_UINT8);
+  std::map<std::string, mace::MaceTensor> inputs;
+  inputs["input0"] = mace::MaceTensor(shape, expected_input);
+  // Float inputs are fed as they are.
+  std::map<std::string, mace::MaceTensor> outputs;
+  GenerateOutputs(output_names, shape, &outputs, CPU_BUFFER);
+  EXPECT_EQ(engine.Run(inputs, &outputs), MaceStatus::MACE_SUCCESS);
+  CheckOutputs<RT_CPU, float>(*net_def, inputs, outputs, data);
+
+  std::map<std::string, mace::MaceTensor> image_outputs;
+  GenerateOutputs(output_names, shape, &image_outputs, CPU_BUFFER);
+  EXPECT_EQ(engine.Run(image_inputs, &image_outputs),
+            MaceStatus::MACE_SUCCESS);
+  const float *expected = outputs["output0"].data().get();
+  const float *actual = image_outputs["output0"].data().get();
+  for (int64_t i = 0; i < shape[1] * shape[2] * shape[3]; ++i) {
+    EXPECT_NEAR(expected[i], actual[i], 1e-4) << "at " << i;
+  }
+
+  // A frame smaller than the crop window is rejected
+  std::map<std::string, mace::MaceTensor> small_inputs;
+  small_inputs["input0"] = mace::MaceTensor({1, 18, 24, 3}, pixels,
+                                            DataFormat::NHWC, IDT_UINT8);
+  EXPECT_EQ(engine.Run(small_inputs, &image_outputs),
+            MaceStatus::MACE_INVALID_ARGS);
+}
+
+TEST_F(MaceAPITest, BindBuffers) {
+  const std::vector<int64_t> shape = {1, 16, 20, 3};
+  const std::vector<int64_t> nchw_shape = {1, 3, 16, 20};
+  const std::vector<int64_t> filter_shape = {3, 3, 3, 3};
+  const int64_t size = std::accumulate(shape.begin(), shape.end(), 1,
+                                       std::multiplies<int64_t>());
+  std::vector<std::string> input_names = {"input0"};
+  std::vector<std::string> output_names = {"output0"};
+
+  std::shared_ptr<MultiNetDef> multi_net_def(new MultiNetDef());
+  std::vector<float> data;
+  BuildCpuConvNet(shape, filter_shape, multi_net_def.get(), &data);
+
+  MaceEngineConfig config;
+  MaceEngine engine(config);
+  EXPECT_EQ(engine.Init(multi_net_def.get(), input_names, output_names,
+                        reinterpret_cast<unsigned char *>(data.data()),
+                        data.size() * sizeof(float)),
+            MaceStatus::MACE_SUCCESS);
+
+  auto new_buffer = [size]() {
+    return std::shared_ptr<float>(new float[size],
+                                  std::default_delete<float[]>());
+  };
+  std::vector<float> input_data;
+  ops::test::GenerateRandomRealTypeData(nchw_shape, &input_data);
+
+  // NHWC inputs are transposed to NCHW when fed, so they can not be bound
+  std::map<std::string, mace::MaceTensor> nhwc_inputs;
+  nhwc_inputs["input0"] = mace::MaceTensor(shape, new_buffer());
+  EXPECT_EQ(engine.BindBuffers(nhwc_inputs, {}),
+            MaceStatus::MACE_UNSUPPORTED);
+  std::map<std::string, mace::MaceTensor> unknown_outputs;
+  unknown_outputs["output1"] =
+      mace::MaceTensor(nchw_shape, new_buffer(), DataFormat::NCHW);
+  EXPECT_EQ(engine.BindBuffers({}, unknown_outputs),
+            MaceStatus::MACE_INVALID_ARGS);
+
+  // The expected outputs of the unbound engine
+  std::map<std::string, mace::MaceTensor> inputs;
+  std::map<std::string, mace::MaceTensor> expected_outputs;
+  inputs["input0"] =
+      mace::MaceTensor(nchw_shape, new_buffer(), DataFormat::NCHW);
+  expected_outputs["output0"] =
+      mace::MaceTensor(nchw_shape, new_buffer(), DataFormat::NCHW);
+  memcpy(inputs["input0"].data().get(), input_data.data(),
+         size * sizeof(float));
+  EXPECT_EQ(engine.Run(inputs, &expected_outputs), MaceStatus::MACE_SUCCESS);
+
+  std::map<std::string, mace::MaceTensor> bound_inputs;
+  std::map<std::string, mace::MaceTensor> bound_outputs;
+  bound_inputs["input0"] =
+      mace::MaceTensor(nchw_shape, new_buffer(), DataFormat::NCHW);
+  bound_outputs["output0"] =
+      mace::MaceTensor(nchw_shape, new_buffer(), DataFormat::NCHW);
+  EXPECT_EQ(engine.BindBuffers(bound_inputs, bound_outputs),
+            MaceStatus::MACE_SUCCESS);
+  float *bound_in = bound_inputs["input0"].data().get();
+  const float *bound_out = bound_outputs["output0"].data().get();
+  const float *expected = expected_outputs["output0"].data().get();
+  for (int round = 0; round < 2; ++round) {
+    memcpy(bound_in, input_data.data(), size * sizeof(float));
+    std::fill_n(bound_outputs["output0"].data().get(), size, 0.f);
+    EXPECT_EQ(engine.Run(bound_inputs, &bound_outputs),
+              MaceStatus::MACE_SUCCESS);
+    for (int64_t i = 0; i < size; ++i) {
+      EXPECT_NEAR(expected[i], bound_out[i], 1e-5) << "at " << i;
+    }
+  }
+
+  // Other buffers are copied from and to the bound ones, which the net
+  // still writes
+  std::map<std::string, mace::MaceTensor> outputs;
+  outputs["output0"] =
+      mace::MaceTensor(nchw_shape, new_buffer(), DataFormat::NCHW);
+  std::fill_n(bound_outputs["output0"].data().get(), size, 0.f);
+  EXPECT_EQ(engine.Run(inputs, &outputs), MaceStatus::MACE_SUCCESS);
+  const float *actual = outputs["output0"].data().get();
+  for (int64_t i = 0; i < size; ++i) {
+    EXPECT_NEAR(expected[i], actual[i], 1e-5) << "at " << i;
+    EXPECT_NEAR(expected[i], bound_out[i], 1e-5) << "at " << i;
+  }
+
+  EXPECT_EQ(engine.BindBuffers({}, {}), MaceStatus::MACE_SUCCESS);
+  std::fill_n(bound_outputs["output0"].data().get(), size, 0.f);
+  EXPECT_EQ(engine.Run(inputs, &outputs), MaceStatus::MACE_SUCCESS);
+  for (int64_t i = 0; i < size; ++i) {
+    EXPECT_NEAR(expected[i], actual[i], 1e-5) << "at " << i;
+    EXPECT_EQ(0.f, bound_out[i]) << "at " << i;
+  }
+}
+
 }  // namespace test
 }  // namespace mace
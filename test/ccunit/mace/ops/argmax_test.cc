@@ -67,6 +67,21 @@ TEST_F(ArgMaxOpTest, HighRank) {
       {1, 2, 2}, {2, 2, 2, 2});
 }
 
+TEST_F(ArgMaxOpTest, LargeClassCount) {
+  // Long enough to be split into chunks and selected in parallel.
+  const index_t classes = 100000;
+  std::vector<float> input(2 * classes);
+  for (index_t i = 0; i < classes; ++i) {
+    input[i] = static_cast<float>((i * 7919) % classes);
+    input[classes + i] = -static_cast<float>((i * 7919) % classes);
+  }
+  input[classes + 99999] = 1.f;
+  const int32_t first = static_cast<int32_t>(
+      std::max_element(input.begin(), input.begin() + classes)
+          - input.begin());
+  ArgMaxTest<RuntimeType::RT_CPU>({2, classes}, input, {2}, {first, 99999});
+}
+
 }  // namespace test
 }  // namespace ops
 }  // namespace mace
@@ -14,7 +14,11 @@
 
 
 #include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
 
+#include "mace/core/memory/weight_registry.h"
 #include "mace/core/ops/op_context.h"
 #include "mace/core/tensor.h"
 #include "mace/ops/delegator/gemm.h"
@@ -120,6 +124,70 @@ TEST(ArmGemm, TestGemmFloat32) {
   TestGemmFloat32(16, 31, 61, 67, RowMajor, ColMajor, RowMajor, true, true);
 }
 
+TEST(ArmGemm, TestGemmSharedWeight) {
+  // Two engines map one weight block of the WeightRegistry, the first one
+  // caching its packed copy must not release the pages the second reads.
+  const index_t rows = 256;
+  const index_t cols = 32;
+  const index_t depth = 256;
+  auto *cpu_runtime = OpTestContext::Get()->GetRuntime(RuntimeType::RT_CPU);
+  std::vector<float> weight;
+  GenerateRandomRealTypeData<float>({rows, depth}, &weight);
+  const index_t weight_bytes = weight.size() * sizeof(float);
+  const std::string key = WeightRegistry::MakeKey(
+      weight.data(), weight_bytes, "arm_gemm_shared_weight_test");
+  auto fill = [&weight, weight_bytes](void *dst) {
+    memcpy(dst, weight.data(), weight_bytes);
+  };
+
+  OpsTestNet nets[2];
+  std::unique_ptr<Tensor> lhs[2];
+  for (int i = 0; i < 2; ++i) {
+    lhs[i] = make_unique<Tensor>(cpu_runtime, DataType::DT_FLOAT,
+                                 std::vector<index_t>{rows, depth}, true);
+    EXPECT_EQ(nets[i].ws()->MapSharedWeight(lhs[i].get(), cpu_runtime, key,
+                                            weight.data(), weight_bytes,
+                                            fill),
+              MaceStatus::MACE_SUCCESS);
+    EXPECT_TRUE(lhs[i]->is_shared());
+  }
+  EXPECT_EQ(lhs[0]->data<float>(), lhs[1]->data<float>());
+
+  Tensor rhs(cpu_runtime, DataType::DT_FLOAT);
+  rhs.Resize({depth, cols});
+  {
+    Tensor::MappingGuard rhs_guard(&rhs);
+    GenerateRandomRealTypeData<float>(rhs.shape(), rhs.mutable_data<float>());
+  }
+
+  OpContext ref_context(nets[0].ws(), cpu_runtime);
+  Tensor expected_output(cpu_runtime, DataType::DT_FLOAT);
+  expected_output.Resize({rows, cols});
+  std::unique_ptr<delegator::Gemm> gemm_ref = delegator::Gemm::Create(
+      ref_context.workspace(),
+      MACE_DELEGATOR_KEY(Gemm, RuntimeType::RT_CPU, float, ImplType::REF),
+      delegator::GemmParam());
+  gemm_ref->Compute(&ref_context, lhs[0].get(), &rhs, 1, rows, cols, depth,
+                    RowMajor, RowMajor, RowMajor, false, false,
+                    &expected_output);
+
+  for (int i = 0; i < 2; ++i) {
+    OpContext context(nets[i].ws(), cpu_runtime);
+    std::unique_ptr<delegator::Gemm> gemm = delegator::Gemm::Create(
+        context.workspace(),
+        MACE_DELEGATOR_KEY(Gemm, RuntimeType::RT_CPU, float, ImplType::NEON),
+        delegator::GemmParam(true));
+    Tensor output(cpu_runtime, DataType::DT_FLOAT);
+    output.Resize({rows, cols});
+    // The second run takes the packed cache
+    for (int run = 0; run < 2; ++run) {
+      gemm->Compute(&context, lhs[i].get(), &rhs, 1, rows, cols, depth,
+                    RowMajor, RowMajor, RowMajor, false, false, &output);
+      ExpectTensorNear<float>(expected_output, output);
+    }
+  }
+}
+
 }  // namespace test
 }  // namespace ops
 }  // namespace mace
@@ -12,8 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "mace/ops/ops_test_util.h"
@@ -169,6 +171,73 @@ TEST_F(ConcatOpTest, CPURandom) {
   CPURandomTest(4, 1);
 }
 
+TEST_F(ConcatOpTest, CPUZeroCopy) {
+  // Relu outputs are planned as views of the channel concat output
+  OpsTestNet net;
+  const std::vector<index_t> shape0 = {1, 2, 3, 4};
+  const std::vector<index_t> shape1 = {1, 3, 3, 4};
+  const std::vector<index_t> output_shape = {1, 5, 3, 4};
+  for (int i = 0; i < 2; ++i) {
+    OpDefBuilder("Activation", MakeString("ReluTest", i))
+        .Input(MakeString("Input", i))
+        .Output(MakeString("Relu", i))
+        .OutputShape(i == 0 ? shape0 : shape1)
+        .AddStringArg("activation", "RELU")
+        .Finalize(net.AddNewOperatorDef());
+  }
+  OpDefBuilder("Concat", "ConcatTest")
+      .Input("Relu0")
+      .Input("Relu1")
+      .Output("Output")
+      .OutputShape(output_shape)
+      .AddIntArg("axis", 1)
+      .Finalize(net.AddNewOperatorDef());
+
+  auto run_and_check = [&](const std::vector<index_t> &input_shape0,
+                           const std::vector<index_t> &input_shape1,
+                           const bool setup) {
+    std::vector<float> input0;
+    GenerateRandomRealTypeData(input_shape0, &input0);
+    std::vector<float> input1;
+    GenerateRandomRealTypeData(input_shape1, &input1);
+    net.AddInputFromArray<RuntimeType::RT_CPU, float>("Input0",
+                                                      input_shape0, input0);
+    net.AddInputFromArray<RuntimeType::RT_CPU, float>("Input1",
+                                                      input_shape1, input1);
+    if (setup) {
+      net.Setup(RuntimeType::RT_CPU);
+    }
+    net.Run();
+
+    std::vector<float> expected;
+    const index_t batch = input_shape0[0];
+    const index_t size0 = input0.size() / batch;
+    const index_t size1 = input1.size() / batch;
+    for (index_t b = 0; b < batch; ++b) {
+      for (index_t i = 0; i < size0; ++i) {
+        expected.push_back(std::max(input0[b * size0 + i], 0.f));
+      }
+      for (index_t i = 0; i < size1; ++i) {
+        expected.push_back(std::max(input1[b * size1 + i], 0.f));
+      }
+    }
+    std::vector<index_t> expected_shape = input_shape0;
+    expected_shape[1] += input_shape1[1];
+    auto expected_output = net.CreateTensor<float>(expected_shape, expected);
+    ExpectTensorNear<float>(*expected_output, *net.GetOutput("Output"));
+  };
+
+  run_and_check(shape0, shape1, true);
+  const float *output_data = net.GetOutput("Output")->data<float>();
+  EXPECT_EQ(output_data, net.GetOutput("Relu0")->data<float>());
+  EXPECT_EQ(output_data + 24, net.GetOutput("Relu1")->data<float>());
+
+  // The views no longer match the output, inputs are staged or copied
+  run_and_check({1, 1, 3, 4}, shape1, false);
+  run_and_check({1, 3, 3, 4}, {1, 1, 3, 4}, false);
+  run_and_check({2, 2, 3, 4}, {2, 3, 3, 4}, false);
+}
+
 TEST_F(ConcatOpTest, QuantizedCPURandom) {
   static unsigned int seed = time(NULL);
   int dim = 4;
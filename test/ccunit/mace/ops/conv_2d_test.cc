@@ -1035,6 +1035,96 @@ TEST_F(Conv2dOpTest, OPENCLUnalignedDilation4) {
   TestDilationConvNxN<RuntimeType::RT_OPENCL, float>({107, 113, 5, 7}, 4);
 }
 
+namespace {
+// Compares a dilated convolution with the dense convolution of the filter
+// expanded with zeros between the taps.
+void TestCPUDilationConv(const std::vector<index_t> &shape,
+                         const int kernel_h, const int kernel_w,
+                         const int dilation_h, const int dilation_w) {
+  auto func = [&](Padding type) {
+    index_t batch = 2;
+    index_t height = shape[0];
+    index_t width = shape[1];
+    index_t input_channels = shape[2];
+    index_t output_channels = shape[3];
+    const index_t dilated_h = (kernel_h - 1) * dilation_h + 1;
+    const index_t dilated_w = (kernel_w - 1) * dilation_w + 1;
+
+    OpsTestNet net;
+    net.AddRandomInput<RuntimeType::RT_CPU, float>(
+        "Input", {batch, input_channels, height, width});
+    net.AddRandomInput<RuntimeType::RT_CPU, float>(
+        "Filter", {output_channels, input_channels, kernel_h, kernel_w}, true);
+    net.AddRandomInput<RuntimeType::RT_CPU, float>(
+        "Bias", {output_channels}, true);
+
+    const float *filter_data = net.GetTensor("Filter")->data<float>();
+    std::vector<float> dilated_filter(
+        output_channels * input_channels * dilated_h * dilated_w, 0.f);
+    for (index_t i = 0; i < output_channels * input_channels; ++i) {
+      for (index_t h = 0; h < kernel_h; ++h) {
+        for (index_t w = 0; w < kernel_w; ++w) {
+          const index_t dilated_idx =
+              (i * dilated_h + h * dilation_h) * dilated_w + w * dilation_w;
+          dilated_filter[dilated_idx] =
+              filter_data[(i * kernel_h + h) * kernel_w + w];
+        }
+      }
+    }
+    net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+        "DilatedFilter", {output_channels, input_channels, dilated_h,
+                          dilated_w}, dilated_filter, true);
+
+    OpDefBuilder("Conv2D", "Conv2dTest")
+        .Input("Input")
+        .Input("DilatedFilter")
+        .Input("Bias")
+        .Output("ExpectedOutput")
+        .AddIntsArg("strides", {1, 1})
+        .AddIntArg("padding", type)
+        .AddIntsArg("dilations", {1, 1})
+        .Finalize(net.NewOperatorDef());
+    net.RunOp();
+    auto expected = net.CreateTensor<float>();
+    expected->Copy(*net.GetOutput("ExpectedOutput"));
+
+    OpDefBuilder("Conv2D", "Conv2dTest")
+        .Input("Input")
+        .Input("Filter")
+        .Input("Bias")
+        .Output("Output")
+        .AddIntsArg("strides", {1, 1})
+        .AddIntArg("padding", type)
+        .AddIntsArg("dilations", {dilation_h, dilation_w})
+        .Finalize(net.NewOperatorDef());
+    net.RunOp();
+    ExpectTensorNear<float>(*expected, *net.GetOutput("Output"), 1e-4, 1e-4);
+  };
+
+  func(VALID);
+  func(SAME);
+}
+}  // namespace
+
+TEST_F(Conv2dOpTest, CPUDilation3x3) {
+  TestCPUDilationConv({17, 19, 3, 4}, 3, 3, 2, 2);
+  TestCPUDilationConv({17, 19, 3, 5}, 3, 3, 2, 3);
+  TestCPUDilationConv({32, 31, 16, 16}, 3, 3, 2, 2);
+  TestCPUDilationConv({33, 29, 32, 64}, 3, 3, 4, 4);
+}
+
+TEST_F(Conv2dOpTest, CPUDilation1xN) {
+  TestCPUDilationConv({1, 50, 5, 3}, 1, 3, 1, 3);
+  TestCPUDilationConv({1, 50, 64, 32}, 1, 3, 1, 3);
+  TestCPUDilationConv({50, 1, 5, 3}, 3, 1, 2, 1);
+  TestCPUDilationConv({50, 3, 64, 32}, 5, 1, 3, 1);
+}
+
+TEST_F(Conv2dOpTest, CPUDilationNxN) {
+  TestCPUDilationConv({27, 25, 8, 16}, 5, 5, 2, 2);
+  TestCPUDilationConv({27, 25, 3, 5}, 7, 7, 3, 3);
+}
+
 namespace {
 template <RuntimeType D>
 void TestGeneralHalfAtrousConv(const std::vector<index_t> &image_shape,
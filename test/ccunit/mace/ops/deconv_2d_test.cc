@@ -343,6 +343,106 @@ TEST_F(Deconv2dOpTest, CPUSimple3X3PaddingValid_S2) {
   TestNHWCSimple3x3VALID_S2<RuntimeType::RT_CPU>();
 }
 
+namespace {
+void TestCPUDeconvGemm(const int batch,
+                       const std::vector<index_t> &shape,
+                       const int kernel_h, const int kernel_w,
+                       const int stride_h, const int stride_w) {
+  auto func = [&](int padding) {
+    const index_t height = shape[0];
+    const index_t width = shape[1];
+    const index_t input_channels = shape[2];
+    const index_t output_channels = shape[3];
+    const index_t full_h = (height - 1) * stride_h + kernel_h;
+    const index_t full_w = (width - 1) * stride_w + kernel_w;
+    const index_t out_h = full_h - padding;
+    const index_t out_w = full_w - padding;
+
+    OpsTestNet net;
+    net.AddRandomInput<RuntimeType::RT_CPU, float>(
+        "Input", {batch, input_channels, height, width});
+    net.AddRandomInput<RuntimeType::RT_CPU, float>(
+        "Filter", {output_channels, input_channels, kernel_h, kernel_w}, true);
+    net.AddRandomInput<RuntimeType::RT_CPU, float>(
+        "Bias", {output_channels}, true);
+
+    // scatter every input pixel into the full output, then crop it
+    const float *input_data = net.GetTensor("Input")->data<float>();
+    const float *filter_data = net.GetTensor("Filter")->data<float>();
+    const float *bias_data = net.GetTensor("Bias")->data<float>();
+    std::vector<float> full(batch * output_channels * full_h * full_w, 0.f);
+    for (index_t b = 0; b < batch; ++b) {
+      for (index_t m = 0; m < output_channels; ++m) {
+        float *full_ptr = full.data() + (b * output_channels + m)
+            * full_h * full_w;
+        for (index_t c = 0; c < input_channels; ++c) {
+          const float *in_ptr = input_data + (b * input_channels + c)
+              * height * width;
+          const float *filter_ptr = filter_data + (m * input_channels + c)
+              * kernel_h * kernel_w;
+          for (index_t h = 0; h < height; ++h) {
+            for (index_t w = 0; w < width; ++w) {
+              for (index_t kh = 0; kh < kernel_h; ++kh) {
+                for (index_t kw = 0; kw < kernel_w; ++kw) {
+                  full_ptr[(h * stride_h + kh) * full_w + w * stride_w + kw]
+                      += in_ptr[h * width + w]
+                      * filter_ptr[kh * kernel_w + kw];
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+    const index_t pad = padding / 2;
+    std::vector<float> expected_data;
+    for (index_t b = 0; b < batch; ++b) {
+      for (index_t m = 0; m < output_channels; ++m) {
+        for (index_t h = 0; h < out_h; ++h) {
+          for (index_t w = 0; w < out_w; ++w) {
+            expected_data.push_back(
+                full[((b * output_channels + m) * full_h + h + pad) * full_w
+                    + w + pad] + bias_data[m]);
+          }
+        }
+      }
+    }
+    auto expected = net.CreateTensor<float>(
+        {batch, output_channels, out_h, out_w}, expected_data);
+
+    OpDefBuilder("Deconv2D", "Deconv2dTest")
+        .Input("Input")
+        .Input("Filter")
+        .Input("Bias")
+        .Output("Output")
+        .AddIntsArg("strides", {stride_h, stride_w})
+        .AddIntsArg("padding_values", {padding, padding})
+        .AddIntArg("framework_type", FrameworkType::CAFFE)
+        .Finalize(net.NewOperatorDef());
+    net.RunOp();
+
+    ExpectTensorNear<float>(*expected, *net.GetOutput("Output"), 1e-4, 1e-4);
+  };
+
+  func(0);
+  func(1);
+  func(2);
+}
+}  // namespace
+
+TEST_F(Deconv2dOpTest, CPUDeconvGemmGeneral) {
+  TestCPUDeconvGemm(1, {13, 11, 16, 8}, 5, 5, 1, 1);
+  TestCPUDeconvGemm(2, {13, 11, 9, 5}, 7, 7, 3, 3);
+  TestCPUDeconvGemm(1, {9, 17, 32, 3}, 3, 5, 2, 1);
+  TestCPUDeconvGemm(1, {8, 8, 8, 16}, 2, 2, 3, 3);
+  TestCPUDeconvGemm(4, {7, 6, 16, 12}, 3, 3, 2, 2);
+}
+
+TEST_F(Deconv2dOpTest, CPUDeconvGemmLargeChannels) {
+  TestCPUDeconvGemm(1, {15, 16, 64, 64}, 3, 3, 2, 2);
+  TestCPUDeconvGemm(2, {8, 9, 64, 72}, 4, 4, 2, 2);
+}
+
 TEST_F(Deconv2dOpTest, OPENCLSimple2X2PaddingSame) {
   TestNHWCSimple2x2SAME<RuntimeType::RT_OPENCL>();
 }
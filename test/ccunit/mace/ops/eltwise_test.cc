@@ -515,6 +515,53 @@ TEST_F(EltwiseOpTest, CPUSimpleTensorTensor) {
       {1, 2, 3, 4, 5, 1, 2, 3, 4, 5}, {},
       {}, {2, 2, 3, 3, 3, 2, 2, 3, 3, 3}, {2.0f, 3.0f});
 }
+
+TEST_F(EltwiseOpTest, CPUInPlace) {
+  // Sum and Output are planned into the memory of the dying Relu0 and Sum
+  OpsTestNet net;
+  const std::vector<index_t> shape = {1, 2, 2, 3};
+  OpDefBuilder("Activation", "Relu0Test")
+      .Input("Input0")
+      .Output("Relu0")
+      .OutputShape(shape)
+      .AddStringArg("activation", "RELU")
+      .Finalize(net.AddNewOperatorDef());
+  OpDefBuilder("Eltwise", "SumTest")
+      .Input("Relu0")
+      .Input("Input1")
+      .Output("Sum")
+      .OutputShape(shape)
+      .AddIntArg("type", static_cast<int>(ops::EltwiseType::SUM))
+      .Finalize(net.AddNewOperatorDef());
+  OpDefBuilder("Activation", "Relu1Test")
+      .Input("Sum")
+      .Output("Output")
+      .OutputShape(shape)
+      .AddStringArg("activation", "RELU")
+      .Finalize(net.AddNewOperatorDef());
+
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+      "Input0", shape, {-1, 2, -3, 4, -5, 6, -7, 8, -9, 10, -11, 12});
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+      "Input1", shape, {1, -4, 1, -8, 1, -12, 1, -16, 1, -20, 1, -24});
+  net.Setup(RuntimeType::RT_CPU);
+  net.Run();
+  auto expected = net.CreateTensor<float>(
+      shape, {1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0});
+  ExpectTensorNear<float>(*expected, *net.GetOutput("Output"));
+  const float *relu_data = net.GetOutput("Relu0")->data<float>();
+  EXPECT_EQ(relu_data, net.GetOutput("Sum")->data<float>());
+  EXPECT_EQ(relu_data, net.GetOutput("Output")->data<float>());
+
+  // Relu0 is broadcast inside its own memory, it is staged before the sum
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+      "Input0", {1, 1, 2, 3}, {5, 2, 6, 4, 7, 6});
+  net.Run();
+  EXPECT_EQ(relu_data, net.GetOutput("Sum")->data<float>());
+  expected = net.CreateTensor<float>(
+      shape, {6, 0, 7, 0, 8, 0, 6, 0, 7, 0, 8, 0});
+  ExpectTensorNear<float>(*expected, *net.GetOutput("Output"));
+}
 TEST_F(EltwiseOpTest, GPUSimpleTensorTensor) {
   SimpleTensorEltwise<RuntimeType::RT_OPENCL, float, float>(
       ops::EltwiseType::SUM, {1, 1, 2, 3}, {1, 2, 3, 4, 5, 6}, {1, 1, 2, 3},
@@ -0,0 +1,127 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <vector>
+
+#include "mace/ops/common/reduce_type.h"
+#include "mace/ops/ops_test_util.h"
+
+namespace mace {
+namespace ops {
+namespace test {
+
+class EmbeddingBagOpTest : public OpsTestBase {};
+
+namespace {
+void TestEmbeddingBag(const std::vector<index_t> &params_shape,
+                      const std::vector<float> &params,
+                      const std::vector<index_t> &indices_shape,
+                      const std::vector<int32_t> &indices,
+                      const ReduceType reduce_type,
+                      const bool keep_dims,
+                      const std::vector<index_t> &output_shape,
+                      const std::vector<float> &output) {
+  OpsTestNet net;
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>("Params", params_shape,
+                                                    params);
+  net.AddInputFromArray<RuntimeType::RT_CPU, int32_t>("Indices",
+                                                      indices_shape, indices);
+
+  OpDefBuilder("EmbeddingBag", "EmbeddingBagTest")
+      .Input("Params")
+      .Input("Indices")
+      .AddIntArg("reduce_type", static_cast<int>(reduce_type))
+      .AddIntArg("keepdims", keep_dims ? 1 : 0)
+      .Output("Output")
+      .Finalize(net.NewOperatorDef());
+  net.RunOp(RuntimeType::RT_CPU);
+
+  auto expected = net.CreateTensor<float>(output_shape, output);
+  ExpectTensorNear<float>(*expected, *net.GetOutput("Output"), 1e-5);
+}
+
+// Pools the bags with Gather followed by Reduce, the pattern EmbeddingBag
+// is folded from.
+void TestEmbeddingBagWithGatherReduce(const index_t vocab_size,
+                                      const index_t embedding_size,
+                                      const index_t num_bags,
+                                      const index_t bag_size,
+                                      const ReduceType reduce_type) {
+  OpsTestNet net;
+  std::vector<int32_t> indices(num_bags * bag_size);
+  unsigned int seed = 1;
+  for (auto &index : indices) {
+    index = rand_r(&seed) % vocab_size;
+  }
+  net.AddRandomInput<RuntimeType::RT_CPU, float>(
+      "Params", {vocab_size, embedding_size});
+  net.AddInputFromArray<RuntimeType::RT_CPU, int32_t>(
+      "Indices", {num_bags, bag_size}, indices);
+
+  OpDefBuilder("Gather", "GatherTest")
+      .Input("Params")
+      .Input("Indices")
+      .AddIntArg("axis", 0)
+      .Output("Gathered")
+      .Finalize(net.NewOperatorDef());
+  OpDefBuilder("Reduce", "ReduceTest")
+      .Input("Gathered")
+      .AddIntsArg("axis", {1})
+      .AddIntArg("keepdims", 0)
+      .AddIntArg("reduce_type", static_cast<int>(reduce_type))
+      .AddIntArg("has_data_format", 0)
+      .Output("Expected")
+      .Finalize(net.AddNewOperatorDef());
+  OpDefBuilder("EmbeddingBag", "EmbeddingBagTest")
+      .Input("Params")
+      .Input("Indices")
+      .AddIntArg("reduce_type", static_cast<int>(reduce_type))
+      .Output("Output")
+      .Finalize(net.AddNewOperatorDef());
+  net.RunOp(RuntimeType::RT_CPU);
+
+  ExpectTensorNear<float>(*net.GetOutput("Expected"),
+                          *net.GetOutput("Output"), 1e-5, 1e-4);
+}
+}  // namespace
+
+TEST_F(EmbeddingBagOpTest, CPUSimple) {
+  const std::vector<float> params = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+                                     10, 11, 12, 13, 14, 15, 16, 17, 18, 19};
+  TestEmbeddingBag({10, 2}, params, {2, 3}, {2, 4, 6, 9, 0, 0}, SUM, false,
+                   {2, 2}, {24, 27, 18, 21});
+  TestEmbeddingBag({10, 2}, params, {2, 3}, {2, 4, 6, 9, 0, 0}, MEAN, false,
+                   {2, 2}, {8, 9, 6, 7});
+  TestEmbeddingBag({10, 2}, params, {2, 3}, {2, 4, 6, 9, 0, 0}, MAX, true,
+                   {2, 1, 2}, {12, 13, 18, 19});
+}
+
+TEST_F(EmbeddingBagOpTest, CPURank1Index) {
+  TestEmbeddingBag({5, 2, 2}, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+                               10, 11, 12, 13, 14, 15, 16, 17, 18, 19},
+                   {2}, {1, 3}, SUM, false,
+                   {2, 2}, {16, 18, 20, 22});
+}
+
+TEST_F(EmbeddingBagOpTest, CPUWithGatherReduce) {
+  TestEmbeddingBagWithGatherReduce(1000, 64, 37, 20, SUM);
+  TestEmbeddingBagWithGatherReduce(1000, 64, 37, 20, MEAN);
+  TestEmbeddingBagWithGatherReduce(1000, 64, 37, 20, MAX);
+  TestEmbeddingBagWithGatherReduce(100, 3, 5, 1, SUM);
+}
+
+}  // namespace test
+}  // namespace ops
+}  // namespace mace
@@ -12,7 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <fstream>
+#include <string>
+#include <vector>
 
 #include "mace/ops/ops_test_util.h"
 
@@ -199,6 +202,75 @@ TEST_F(FullyConnectedOpTest, ComplexMultiBatch) {
   Random<float>(7, 14, 14, 13, 23);
 }
 
+namespace {
+void CPUMultiBatch(const index_t batch,
+                   const index_t channels,
+                   const index_t height,
+                   const index_t width,
+                   const index_t out_channel,
+                   const std::string &activation) {
+  // Construct graph
+  OpsTestNet net;
+
+  // Add input data
+  net.AddRandomInput<RuntimeType::RT_CPU, float>(
+      "Input", {batch, channels, height, width}, false, false);
+  net.AddRandomInput<RuntimeType::RT_CPU, float>(
+      "Weight", {out_channel, channels, height, width}, true, false);
+  net.AddRandomInput<RuntimeType::RT_CPU, float>(
+      "Bias", {out_channel}, true, false);
+
+  OpDefBuilder("FullyConnected", "FullyConnectedTest")
+      .Input("Input")
+      .Input("Weight")
+      .Input("Bias")
+      .Output("Output")
+      .AddStringArg("activation", activation.c_str())
+      .AddFloatArg("max_limit", 0.5f)
+      .AddFloatArg("activation_coefficient", 0.1f)
+      .Finalize(net.NewOperatorDef());
+
+  // Run twice, the second run reads the cached packed weight
+  net.Setup(RuntimeType::RT_CPU);
+  net.Run();
+  net.Run();
+
+  // Check
+  const index_t input_size = channels * height * width;
+  const float *input_data = net.GetTensor("Input")->data<float>();
+  const float *weight_data = net.GetTensor("Weight")->data<float>();
+  const float *bias_data = net.GetTensor("Bias")->data<float>();
+  std::vector<float> expected_data(batch * out_channel);
+  for (index_t b = 0; b < batch; ++b) {
+    for (index_t o = 0; o < out_channel; ++o) {
+      float sum = bias_data[o];
+      for (index_t i = 0; i < input_size; ++i) {
+        sum += input_data[b * input_size + i] *
+            weight_data[o * input_size + i];
+      }
+      if (activation == "RELUX") {
+        sum = std::max(0.f, std::min(0.5f, sum));
+      } else if (activation == "LEAKYRELU") {
+        sum = std::max(sum, 0.f) + std::min(sum, 0.f) * 0.1f;
+      }
+      expected_data[b * out_channel + o] = sum;
+    }
+  }
+  auto expected = net.CreateTensor<float>({batch, out_channel, 1, 1},
+                                          expected_data);
+
+  ExpectTensorNear<float>(*expected, *net.GetOutput("Output"), 1e-3, 1e-3);
+}
+}  // namespace
+
+TEST_F(FullyConnectedOpTest, CPUMultiBatch) {
+  CPUMultiBatch(1, 32, 1, 1, 16, "RELUX");
+  CPUMultiBatch(4, 32, 1, 1, 16, "RELUX");
+  CPUMultiBatch(7, 13, 3, 3, 23, "LEAKYRELU");
+  CPUMultiBatch(16, 512, 1, 1, 128, "NOOP");
+  CPUMultiBatch(33, 67, 1, 1, 37, "LEAKYRELU");
+}
+
 TEST_F(FullyConnectedOpTest, ComplexHalfWidthFormatAligned) {
   Random<half>(1, 2, 2, 512, 2);
   Random<half>(1, 11, 11, 32, 16);
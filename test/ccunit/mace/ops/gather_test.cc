@@ -89,6 +89,26 @@ TEST_F(GatherOpTest, CPURankHighIndex) {
              {1, 3}, {2, 4, 6}, 0, {1, 3, 2}, {4, 5, 8, 9, 12, 13});
 }
 
+TEST_F(GatherOpTest, CPULargeIndex) {
+  // Enough rows to be split across the thread pool and prefetched ahead.
+  const index_t vocab_size = 500;
+  const index_t embedding_size = 48;
+  std::vector<float> weight(vocab_size * embedding_size);
+  for (size_t i = 0; i < weight.size(); ++i) {
+    weight[i] = static_cast<float>(i);
+  }
+  std::vector<int32_t> input(301);
+  std::vector<float> output;
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = static_cast<int32_t>((i * 37 + 11) % vocab_size);
+    output.insert(output.end(),
+                  weight.begin() + input[i] * embedding_size,
+                  weight.begin() + (input[i] + 1) * embedding_size);
+  }
+  TestGather<float>({vocab_size, embedding_size}, weight,
+                    {7, 43}, input, 0, {7, 43, embedding_size}, output);
+}
+
 }  // namespace test
 }  // namespace ops
 }  // namespace mace
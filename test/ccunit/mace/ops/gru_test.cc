@@ -0,0 +1,157 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "mace/ops/ops_test_util.h"
+
+namespace mace {
+namespace ops {
+namespace test {
+
+class GRUOpTest : public OpsTestBase {};
+
+namespace {
+std::vector<float> RandomVector(index_t size, unsigned int *seed) {
+  std::vector<float> data(size);
+  for (auto &value : data) {
+    value = static_cast<float>(rand_r(seed) % 2001 - 1000) / 1000.f;
+  }
+  return data;
+}
+
+float Sigmoid(float x) {
+  return 1.f / (1.f + std::exp(-x));
+}
+
+void GRUTest(const index_t seq_length, const index_t batch,
+             const index_t input_size, const index_t hidden,
+             const std::string &direction, const bool initial_state,
+             const bool linear_before_reset) {
+  const index_t dirs = direction == "bidirectional" ? 2 : 1;
+  const index_t gate_size = 3 * hidden;
+  unsigned int seed = 1;
+  const auto x = RandomVector(seq_length * batch * input_size, &seed);
+  const auto w = RandomVector(dirs * gate_size * input_size, &seed);
+  const auto r = RandomVector(dirs * gate_size * hidden, &seed);
+  const auto b = RandomVector(dirs * 2 * gate_size, &seed);
+  const auto initial_h = RandomVector(dirs * batch * hidden, &seed);
+
+  OpsTestNet net;
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+      "X", {seq_length, batch, input_size}, x);
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+      "W", {dirs, gate_size, input_size}, w, true);
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+      "R", {dirs, gate_size, hidden}, r, true);
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+      "B", {dirs, 2 * gate_size}, b, true);
+  OpDefBuilder builder("GRU", "GRUTest");
+  builder.Input("X").Input("W").Input("R").Input("B");
+  if (initial_state) {
+    net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+        "InitialH", {dirs, batch, hidden}, initial_h);
+    builder.Input("InitialH");
+  }
+  builder.Output("Y")
+      .Output("YH")
+      .AddStringArg("direction", direction.c_str())
+      .AddIntArg("linear_before_reset", linear_before_reset ? 1 : 0)
+      .Finalize(net.NewOperatorDef());
+  net.RunOp(RuntimeType::RT_CPU);
+
+  // Reference, gates in order z, r, h
+  std::vector<float> y(seq_length * dirs * batch * hidden);
+  std::vector<float> y_h(dirs * batch * hidden);
+  for (index_t d = 0; d < dirs; ++d) {
+    const bool reverse = direction == "reverse" || d == 1;
+    const float *wb = b.data() + d * 2 * gate_size;
+    const float *rb = wb + gate_size;
+    for (index_t n = 0; n < batch; ++n) {
+      std::vector<float> h(hidden, 0.f);
+      if (initial_state) {
+        std::copy_n(initial_h.begin() + (d * batch + n) * hidden, hidden,
+                    h.begin());
+      }
+      for (index_t s = 0; s < seq_length; ++s) {
+        const index_t t = reverse ? seq_length - 1 - s : s;
+        // xw[g] = x . W[g] + Wb[g], hr[g] = h . R[g] + Rb[g]
+        std::vector<float> xw(gate_size), hr(gate_size);
+        for (index_t g = 0; g < gate_size; ++g) {
+          xw[g] = wb[g];
+          for (index_t k = 0; k < input_size; ++k) {
+            xw[g] += x[(t * batch + n) * input_size + k]
+                * w[(d * gate_size + g) * input_size + k];
+          }
+          hr[g] = rb[g];
+          for (index_t k = 0; k < hidden; ++k) {
+            hr[g] += h[k] * r[(d * gate_size + g) * hidden + k];
+          }
+        }
+        std::vector<float> z(hidden), reset(hidden);
+        for (index_t j = 0; j < hidden; ++j) {
+          z[j] = Sigmoid(xw[j] + hr[j]);
+          reset[j] = Sigmoid(xw[hidden + j] + hr[hidden + j]);
+        }
+        std::vector<float> new_h(hidden);
+        for (index_t j = 0; j < hidden; ++j) {
+          float n_in;
+          if (linear_before_reset) {
+            n_in = xw[2 * hidden + j] + reset[j] * hr[2 * hidden + j];
+          } else {
+            n_in = xw[2 * hidden + j] + rb[2 * hidden + j];
+            for (index_t k = 0; k < hidden; ++k) {
+              n_in += reset[k] * h[k]
+                  * r[(d * gate_size + 2 * hidden + j) * hidden + k];
+            }
+          }
+          new_h[j] = (1.f - z[j]) * std::tanh(n_in) + z[j] * h[j];
+        }
+        h = new_h;
+        std::copy(h.begin(), h.end(),
+                  y.begin() + ((t * dirs + d) * batch + n) * hidden);
+      }
+      std::copy(h.begin(), h.end(), y_h.begin() + (d * batch + n) * hidden);
+    }
+  }
+
+  auto expected_y = net.CreateTensor<float>(
+      {seq_length, dirs, batch, hidden}, y);
+  ExpectTensorNear<float>(*expected_y, *net.GetOutput("Y"), 1e-4, 1e-4);
+  auto expected_h = net.CreateTensor<float>({dirs, batch, hidden}, y_h);
+  ExpectTensorNear<float>(*expected_h, *net.GetOutput("YH"), 1e-4, 1e-4);
+}
+}  // namespace
+
+TEST_F(GRUOpTest, Forward) {
+  GRUTest(5, 1, 7, 8, "forward", false, false);
+  GRUTest(4, 3, 5, 13, "forward", true, false);
+}
+
+TEST_F(GRUOpTest, LinearBeforeReset) {
+  GRUTest(5, 2, 7, 10, "forward", true, true);
+  GRUTest(6, 2, 9, 11, "reverse", false, true);
+}
+
+TEST_F(GRUOpTest, Bidirectional) {
+  GRUTest(7, 2, 16, 32, "bidirectional", false, false);
+  GRUTest(3, 4, 10, 6, "bidirectional", true, true);
+}
+
+}  // namespace test
+}  // namespace ops
+}  // namespace mace
@@ -0,0 +1,90 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mace/ops/common/image_preprocess.h"
+
+namespace mace {
+namespace ops {
+namespace test {
+
+class ImagePreprocessTest : public ::testing::Test {};
+
+namespace {
+void TestPreprocessImage(const index_t channels, const bool swap_rb,
+                         const bool nchw) {
+  ImagePreprocessParam param;
+  param.batch = 2;
+  param.src_height = 9;
+  param.src_width = 23;
+  param.channels = channels;
+  param.crop_top = 2;
+  param.crop_left = 3;
+  param.height = 6;
+  // Covers the vectorized pixels and the tail
+  param.width = 19;
+  for (index_t c = 0; c < channels; ++c) {
+    param.channel_map.push_back(swap_rb ? channels - 1 - c : c);
+    param.scale.push_back(1.f / (50.f + c));
+    param.bias.push_back(-0.5f * c);
+  }
+
+  std::vector<uint8_t> input(
+      param.batch * param.src_height * param.src_width * channels);
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = static_cast<uint8_t>((i * 37 + 11) % 256);
+  }
+  std::vector<float> output(
+      param.batch * param.height * param.width * channels);
+  utils::ThreadPool thread_pool(1, AFFINITY_NONE);
+  thread_pool.Init();
+  PreprocessImage(&thread_pool, input.data(), param, nchw, output.data());
+
+  for (index_t b = 0; b < param.batch; ++b) {
+    for (index_t h = 0; h < param.height; ++h) {
+      for (index_t w = 0; w < param.width; ++w) {
+        for (index_t c = 0; c < channels; ++c) {
+          const uint8_t pixel = input[
+              ((b * param.src_height + param.crop_top + h) * param.src_width +
+                  param.crop_left + w) * channels + param.channel_map[c]];
+          const index_t out_idx = nchw ?
+              ((b * channels + c) * param.height + h) * param.width + w :
+              ((b * param.height + h) * param.width + w) * channels + c;
+          EXPECT_NEAR(pixel * param.scale[c] + param.bias[c],
+                      output[out_idx], 1e-5)
+              << "at " << b << ", " << h << ", " << w << ", " << c;
+        }
+      }
+    }
+  }
+}
+}  // namespace
+
+TEST_F(ImagePreprocessTest, RGB) {
+  TestPreprocessImage(3, false, true);
+  TestPreprocessImage(3, false, false);
+  TestPreprocessImage(3, true, true);
+  TestPreprocessImage(3, true, false);
+}
+
+TEST_F(ImagePreprocessTest, OtherChannels) {
+  TestPreprocessImage(1, false, true);
+  TestPreprocessImage(4, false, false);
+}
+
+}  // namespace test
+}  // namespace ops
+}  // namespace mace
@@ -0,0 +1,159 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "mace/ops/ops_test_util.h"
+
+namespace mace {
+namespace ops {
+namespace test {
+
+class LSTMOpTest : public OpsTestBase {};
+
+namespace {
+std::vector<float> RandomVector(index_t size, unsigned int *seed) {
+  std::vector<float> data(size);
+  for (auto &value : data) {
+    value = static_cast<float>(rand_r(seed) % 2001 - 1000) / 1000.f;
+  }
+  return data;
+}
+
+float Sigmoid(float x) {
+  return 1.f / (1.f + std::exp(-x));
+}
+
+float Clip(float x, float clip) {
+  return clip > 0.f ? std::max(-clip, std::min(clip, x)) : x;
+}
+
+void LSTMTest(const index_t seq_length, const index_t batch,
+              const index_t input_size, const index_t hidden,
+              const std::string &direction, const bool initial_state,
+              const float clip) {
+  const index_t dirs = direction == "bidirectional" ? 2 : 1;
+  const index_t gate_size = 4 * hidden;
+  unsigned int seed = 1;
+  const auto x = RandomVector(seq_length * batch * input_size, &seed);
+  const auto w = RandomVector(dirs * gate_size * input_size, &seed);
+  const auto r = RandomVector(dirs * gate_size * hidden, &seed);
+  const auto b = RandomVector(dirs * 2 * gate_size, &seed);
+  const auto initial_h = RandomVector(dirs * batch * hidden, &seed);
+  const auto initial_c = RandomVector(dirs * batch * hidden, &seed);
+
+  OpsTestNet net;
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+      "X", {seq_length, batch, input_size}, x);
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+      "W", {dirs, gate_size, input_size}, w, true);
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+      "R", {dirs, gate_size, hidden}, r, true);
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+      "B", {dirs, 2 * gate_size}, b, true);
+  OpDefBuilder builder("LSTM", "LSTMTest");
+  builder.Input("X").Input("W").Input("R").Input("B");
+  if (initial_state) {
+    net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+        "InitialH", {dirs, batch, hidden}, initial_h);
+    net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+        "InitialC", {dirs, batch, hidden}, initial_c);
+    builder.Input("InitialH").Input("InitialC");
+  }
+  builder.Output("Y")
+      .Output("YH")
+      .Output("YC")
+      .AddStringArg("direction", direction.c_str())
+      .AddFloatArg("clip", clip)
+      .Finalize(net.NewOperatorDef());
+  net.RunOp(RuntimeType::RT_CPU);
+
+  // Reference, gates in order i, o, f, c
+  std::vector<float> y(seq_length * dirs * batch * hidden);
+  std::vector<float> y_h(dirs * batch * hidden);
+  std::vector<float> y_c(dirs * batch * hidden);
+  for (index_t d = 0; d < dirs; ++d) {
+    const bool reverse = direction == "reverse" || d == 1;
+    for (index_t n = 0; n < batch; ++n) {
+      std::vector<float> h(hidden, 0.f), c(hidden, 0.f);
+      if (initial_state) {
+        std::copy_n(initial_h.begin() + (d * batch + n) * hidden, hidden,
+                    h.begin());
+        std::copy_n(initial_c.begin() + (d * batch + n) * hidden, hidden,
+                    c.begin());
+      }
+      for (index_t s = 0; s < seq_length; ++s) {
+        const index_t t = reverse ? seq_length - 1 - s : s;
+        std::vector<float> gates(gate_size);
+        for (index_t g = 0; g < gate_size; ++g) {
+          float sum = b[d * 2 * gate_size + g]
+              + b[d * 2 * gate_size + gate_size + g];
+          for (index_t k = 0; k < input_size; ++k) {
+            sum += x[(t * batch + n) * input_size + k]
+                * w[(d * gate_size + g) * input_size + k];
+          }
+          for (index_t k = 0; k < hidden; ++k) {
+            sum += h[k] * r[(d * gate_size + g) * hidden + k];
+          }
+          gates[g] = Clip(sum, clip);
+        }
+        for (index_t j = 0; j < hidden; ++j) {
+          const float i_t = Sigmoid(gates[j]);
+          const float o_t = Sigmoid(gates[hidden + j]);
+          const float f_t = Sigmoid(gates[2 * hidden + j]);
+          const float c_in = std::tanh(gates[3 * hidden + j]);
+          c[j] = f_t * c[j] + i_t * c_in;
+          h[j] = o_t * std::tanh(c[j]);
+          y[((t * dirs + d) * batch + n) * hidden + j] = h[j];
+        }
+      }
+      std::copy(h.begin(), h.end(), y_h.begin() + (d * batch + n) * hidden);
+      std::copy(c.begin(), c.end(), y_c.begin() + (d * batch + n) * hidden);
+    }
+  }
+
+  auto expected_y = net.CreateTensor<float>(
+      {seq_length, dirs, batch, hidden}, y);
+  ExpectTensorNear<float>(*expected_y, *net.GetOutput("Y"), 1e-4, 1e-4);
+  auto expected_h = net.CreateTensor<float>({dirs, batch, hidden}, y_h);
+  ExpectTensorNear<float>(*expected_h, *net.GetOutput("YH"), 1e-4, 1e-4);
+  auto expected_c = net.CreateTensor<float>({dirs, batch, hidden}, y_c);
+  ExpectTensorNear<float>(*expected_c, *net.GetOutput("YC"), 1e-4, 1e-4);
+}
+}  // namespace
+
+TEST_F(LSTMOpTest, Forward) {
+  LSTMTest(5, 1, 7, 8, "forward", false, 0.f);
+  LSTMTest(4, 3, 5, 13, "forward", true, 0.f);
+}
+
+TEST_F(LSTMOpTest, Reverse) {
+  LSTMTest(6, 2, 9, 11, "reverse", true, 0.f);
+}
+
+TEST_F(LSTMOpTest, Bidirectional) {
+  LSTMTest(7, 2, 16, 32, "bidirectional", false, 0.f);
+  LSTMTest(3, 4, 10, 6, "bidirectional", true, 0.f);
+}
+
+TEST_F(LSTMOpTest, Clip) {
+  LSTMTest(5, 2, 12, 9, "forward", true, 0.5f);
+}
+
+}  // namespace test
+}  // namespace ops
+}  // namespace mace
@@ -0,0 +1,217 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <set>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mace/core/kv_storage.h"
+#include "mace/runtimes/opencl/core/opencl_context.h"
+#include "mace/runtimes/opencl/core/opencl_executor.h"
+#include "mace/utils/macros.h"
+
+namespace mace {
+namespace ops {
+namespace test {
+namespace {
+
+class FakeStorage : public KVStorage {
+ public:
+  int Load() override { return 0; }
+  bool Clear() override {
+    data_.clear();
+    return true;
+  }
+  bool Insert(const std::string &key,
+              const std::vector<unsigned char> &value) override {
+    data_[key] = value;
+    return true;
+  }
+  const std::vector<unsigned char> *Find(const std::string &key) override {
+    auto iter = data_.find(key);
+    return iter == data_.end() ? nullptr : &iter->second;
+  }
+  std::vector<std::string> Keys() override {
+    std::vector<std::string> keys;
+    for (auto &item : data_) {
+      keys.push_back(item.first);
+    }
+    return keys;
+  }
+  int Flush() override { return 0; }
+
+ private:
+  std::map<std::string, std::vector<unsigned char>> data_;
+};
+
+// Counts the builds instead of compiling anything on the device.
+class CountingExecutor : public OpenclExecutor {
+ public:
+  using OpenclExecutor::GetOrBuildProgram;
+  using OpenclExecutor::ReadProgramManifest;
+  using OpenclExecutor::RestoreProgramManifest;
+
+  int BuildCount(const std::string &key) {
+    std::lock_guard<std::mutex> lock(count_mutex_);
+    return build_counts_[key];
+  }
+
+ protected:
+  bool BuildProgram(const std::string &program_file_name,
+                    const std::string &binary_file_name,
+                    const std::string &build_options,
+                    cl::Program *program,
+                    bool *need_store) override {
+    MACE_UNUSED(program_file_name);
+    MACE_UNUSED(build_options);
+    MACE_UNUSED(program);
+    *need_store = false;
+    // Widen the window in which the other threads ask for the same program.
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    std::lock_guard<std::mutex> lock(count_mutex_);
+    ++build_counts_[binary_file_name];
+    return true;
+  }
+
+ private:
+  std::mutex count_mutex_;
+  std::map<std::string, int> build_counts_;
+};
+
+}  // namespace
+
+TEST(OpenclExecutorTest, BuildEachProgramOnce) {
+  const std::vector<std::pair<std::string, std::string>> programs = {
+      {"activation", " -DACTIVATION"},
+      {"addn", " -DINPUT_NUM=2"},
+      {"conv_2d", " -DUSE_RELU"},
+      {"conv_2d", " -DUSE_RELU6"},
+  };
+  // Not an OpenCL program, so nothing should build it from the manifest.
+  const std::string unknown_key = "not_a_program -DA";
+
+  std::string manifest;
+  for (auto &program : programs) {
+    manifest += program.first + program.second + "\n";
+  }
+  manifest += unknown_key + "\n";
+  FakeStorage storage;
+  storage.Insert(kOpenCLProgramKeysKey,
+                 std::vector<unsigned char>(manifest.begin(), manifest.end()));
+
+  CountingExecutor executor;
+  executor.SetOpenclContext(std::make_shared<OpenclContext>());
+  executor.RestoreProgramManifest(
+      CountingExecutor::ReadProgramManifest(&storage), &storage);
+
+  std::vector<std::thread> threads;
+  executor.BuildProgramsInParallel(4, false);
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&executor, &programs]() {
+      for (auto &program : programs) {
+        cl::Program built;
+        EXPECT_EQ(executor.GetOrBuildProgram(program.first,
+                                             program.first + program.second,
+                                             program.second, &built),
+                  MaceStatus::MACE_SUCCESS);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  executor.BuildProgramsInParallel(4, true);
+  EXPECT_TRUE(executor.programs_ready());
+
+  for (auto &program : programs) {
+    EXPECT_EQ(1, executor.BuildCount(program.first + program.second))
+        << program.first + program.second;
+  }
+  EXPECT_EQ(0, executor.BuildCount(unknown_key));
+}
+
+TEST(OpenclExecutorTest, RestoreMissingManifest) {
+  const std::string manifest = "activation -DA\naddn -DB\n";
+  FakeStorage storage;
+  storage.Insert(kOpenCLProgramKeysKey,
+                 std::vector<unsigned char>(manifest.begin(), manifest.end()));
+  // Init reads the manifest before a driver update clears the cache, then
+  // puts it back so that the programs are built ahead of time next run too.
+  const std::string program_keys =
+      CountingExecutor::ReadProgramManifest(&storage);
+  storage.Clear();
+  CountingExecutor executor;
+  executor.SetOpenclContext(std::make_shared<OpenclContext>());
+  executor.RestoreProgramManifest(program_keys, &storage);
+  auto *restored = storage.Find(kOpenCLProgramKeysKey);
+  ASSERT_NE(nullptr, restored);
+  EXPECT_EQ(manifest, std::string(restored->begin(), restored->end()));
+
+  executor.BuildProgramsInParallel(2, true);
+  EXPECT_EQ(1, executor.BuildCount("activation -DA"));
+  EXPECT_EQ(1, executor.BuildCount("addn -DB"));
+}
+
+TEST(OpenclExecutorTest, CollectPrograms) {
+  CountingExecutor executor;
+  executor.SetOpenclContext(std::make_shared<OpenclContext>());
+  cl::Program built;
+  EXPECT_EQ(executor.GetOrBuildProgram("activation", "activation -DA", " -DA",
+                                       &built),
+            MaceStatus::MACE_SUCCESS);
+
+  executor.StartCollectingPrograms();
+  // Recorded, not built
+  cl::Kernel kernel;
+  EXPECT_NE(executor.BuildKernel("addn", "addn", {"-DB"}, &kernel),
+            MaceStatus::MACE_SUCCESS);
+  EXPECT_NE(executor.BuildKernel("addn", "addn", {"-DB"}, &kernel),
+            MaceStatus::MACE_SUCCESS);
+  EXPECT_NE(executor.BuildKernel("conv_2d", "conv_2d", {"-DC", "-DD"},
+                                 &kernel),
+            MaceStatus::MACE_SUCCESS);
+  // Other threads build as usual
+  std::thread other([&executor]() {
+    cl::Program program;
+    EXPECT_EQ(executor.GetOrBuildProgram("pooling", "pooling -DE", " -DE",
+                                         &program),
+              MaceStatus::MACE_SUCCESS);
+  });
+  other.join();
+  const std::set<std::string> keys = executor.StopCollectingPrograms();
+  EXPECT_EQ(std::set<std::string>({"addn -DB", "conv_2d -DC -DD"}), keys);
+  EXPECT_EQ(0, executor.BuildCount("addn -DB"));
+  EXPECT_EQ(1, executor.BuildCount("pooling -DE"));
+
+  executor.BuildProgramsInParallel(keys, 2, true);
+  EXPECT_TRUE(executor.programs_ready());
+  EXPECT_EQ(1, executor.BuildCount("addn -DB"));
+  EXPECT_EQ(1, executor.BuildCount("conv_2d -DC -DD"));
+  EXPECT_EQ(1, executor.BuildCount("activation -DA"));
+
+  // Nothing is recorded once stopped
+  executor.StartCollectingPrograms();
+  EXPECT_TRUE(executor.StopCollectingPrograms().empty());
+}
+
+}  // namespace test
+}  // namespace ops
+}  // namespace mace
@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <limits>
 #include <vector>
 
 #include "mace/ops/common/conv_pool_2d_util.h"
@@ -364,6 +366,91 @@ void SimpleAvgPoolingTest() {
 }
 }  // namespace
 
+namespace {
+void TestCPUPoolingWithReference(const std::vector<index_t> &input_shape,
+                                 const std::vector<int> &kernels,
+                                 const std::vector<int> &strides,
+                                 const std::vector<int> &paddings,
+                                 PoolingType pooling) {
+  OpsTestNet net;
+  net.AddRandomInput<RuntimeType::RT_CPU, float>(
+      "Input", input_shape, false, false);
+  OpDefBuilder("Pooling", "PoolingTest")
+      .Input("Input")
+      .Output("Output")
+      .AddIntArg("pooling_type", pooling)
+      .AddIntsArg("kernels", kernels)
+      .AddIntsArg("strides", strides)
+      .AddIntsArg("padding_values", paddings)
+      .AddIntsArg("dilations", {1, 1})
+      .Finalize(net.NewOperatorDef());
+  net.RunOp(RuntimeType::RT_CPU);
+
+  const Tensor *output = net.GetOutput("Output");
+  const index_t planes = input_shape[0] * input_shape[1];
+  const index_t in_height = input_shape[2];
+  const index_t in_width = input_shape[3];
+  const index_t out_height = output->dim(2);
+  const index_t out_width = output->dim(3);
+  const float *input_data = net.GetTensor("Input")->data<float>();
+  std::vector<float> expected_data;
+  for (index_t p = 0; p < planes; ++p) {
+    for (index_t h = 0; h < out_height; ++h) {
+      for (index_t w = 0; w < out_width; ++w) {
+        float res = pooling == PoolingType::MAX ?
+                    std::numeric_limits<float>::lowest() : 0.f;
+        int count = 0;
+        for (index_t kh = 0; kh < kernels[0]; ++kh) {
+          for (index_t kw = 0; kw < kernels[1]; ++kw) {
+            const index_t ih = h * strides[0] - paddings[0] / 2 + kh;
+            const index_t iw = w * strides[1] - paddings[1] / 2 + kw;
+            if (ih < 0 || ih >= in_height || iw < 0 || iw >= in_width) {
+              continue;
+            }
+            const float in = input_data[(p * in_height + ih) * in_width + iw];
+            res = pooling == PoolingType::MAX ? std::max(res, in) : res + in;
+            ++count;
+          }
+        }
+        expected_data.push_back(
+            pooling == PoolingType::MAX ? res : res / count);
+      }
+    }
+  }
+  auto expected = net.CreateTensor<float>(output->shape(), expected_data);
+
+  ExpectTensorNear<float>(*expected, *output, 1e-5, 1e-4);
+}
+}  // namespace
+
+TEST_F(PoolingOpTest, CPUSlidingWindow) {
+  for (PoolingType pooling : {PoolingType::AVG, PoolingType::MAX}) {
+    TestCPUPoolingWithReference({1, 4, 1, 300}, {1, 50}, {1, 1}, {0, 48},
+                                pooling);
+    TestCPUPoolingWithReference({2, 3, 1, 301}, {1, 50}, {1, 10}, {0, 0},
+                                pooling);
+    TestCPUPoolingWithReference({2, 3, 33, 35}, {7, 7}, {1, 1}, {6, 6},
+                                pooling);
+    TestCPUPoolingWithReference({1, 5, 40, 41}, {5, 9}, {2, 3}, {4, 8},
+                                pooling);
+    TestCPUPoolingWithReference({1, 2, 200, 3}, {60, 1}, {1, 1}, {0, 0},
+                                pooling);
+    TestCPUPoolingWithReference({1, 2, 100, 20}, {8, 8}, {8, 8}, {0, 0},
+                                pooling);
+  }
+}
+
+TEST_F(PoolingOpTest, CPUGlobal) {
+  for (PoolingType pooling : {PoolingType::AVG, PoolingType::MAX}) {
+    TestCPUPoolingWithReference({1, 2, 300, 400}, {300, 400}, {1, 1}, {0, 0},
+                                pooling);
+    TestCPUPoolingWithReference({2, 3, 130, 130}, {130, 130}, {1, 1}, {0, 0},
+                                pooling);
+    TestCPUPoolingWithReference({1, 32, 21, 19}, {21, 19}, {1, 1}, {0, 0},
+                                pooling);
+  }
+}
+
 TEST_F(PoolingOpTest, OPENCLSimpleAvgPooling) {
   SimpleAvgPoolingTest<RT_OPENCL>();
 }
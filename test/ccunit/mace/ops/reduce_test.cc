@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <vector>
 
 #include "mace/ops/common/reduce_type.h"
@@ -348,6 +349,102 @@ TEST_F(ReduceOpTest, GPURandomHalf) {
   RandomTest<RuntimeType::RT_OPENCL, half>({1, 511, 561, 11}, {1, 2});
 }
 
+namespace {
+// Compares the CPU reduction of any rank and axes with a plain loop.
+void CPURandomTest(const std::vector<index_t> &input_shape,
+                   const std::vector<int> &axis) {
+  const int rank = static_cast<int>(input_shape.size());
+  std::vector<bool> reduced(rank, axis.empty());
+  for (int a : axis) {
+    reduced[a < 0 ? a + rank : a] = true;
+  }
+  std::vector<index_t> output_shape(input_shape);
+  index_t size = 1;
+  index_t count = 1;
+  for (int i = 0; i < rank; ++i) {
+    size *= input_shape[i];
+    if (reduced[i]) {
+      count *= input_shape[i];
+      output_shape[i] = 1;
+    }
+  }
+  std::vector<float> input(size);
+  for (auto &value : input) {
+    value = 0.5f + static_cast<float>(rand()) / RAND_MAX;  // NOLINT
+  }
+  std::vector<index_t> output_index(size);
+  for (index_t i = 0; i < size; ++i) {
+    index_t rest = i;
+    index_t stride = 1;
+    output_index[i] = 0;
+    for (int d = rank - 1; d >= 0; --d) {
+      if (!reduced[d]) {
+        output_index[i] += rest % input_shape[d] * stride;
+        stride *= input_shape[d];
+      }
+      rest /= input_shape[d];
+    }
+  }
+  const index_t output_size = size / count;
+
+  for (ReduceType type : {MEAN, MIN, MAX, PROD, SUM}) {
+    if (type == PROD && count > 32) {
+      continue;
+    }
+    OpsTestNet net;
+    net.AddInputFromArray<RuntimeType::RT_CPU, float>("Input", input_shape,
+                                                      input);
+    OpDefBuilder("Reduce", "ReduceTest")
+        .Input("Input")
+        .AddIntsArg("axis", axis)
+        .AddIntArg("keepdims", 1)
+        .AddIntArg("reduce_type", type)
+        .Output("Output")
+        .Finalize(net.NewOperatorDef());
+    net.RunOp();
+
+    // the inputs are in [0.5, 1.5]
+    std::vector<double> expected(
+        output_size, type == MIN ? 2. : (type == PROD ? 1. : 0.));
+    for (index_t i = 0; i < size; ++i) {
+      double &out = expected[output_index[i]];
+      switch (type) {
+        case MIN: out = std::min<double>(out, input[i]); break;
+        case MAX: out = std::max<double>(out, input[i]); break;
+        case PROD: out *= input[i]; break;
+        default: out += input[i]; break;
+      }
+    }
+    if (type == MEAN) {
+      for (auto &out : expected) {
+        out /= count;
+      }
+    }
+    auto expected_tensor = net.CreateTensor<float>(
+        output_shape, std::vector<float>(expected.begin(), expected.end()));
+    ExpectTensorNear<float>(*expected_tensor, *net.GetOutput("Output"),
+                            1e-5, 1e-4);
+  }
+}
+}  // namespace
+
+TEST_F(ReduceOpTest, CPURandom) {
+  // rows, columns and both
+  CPURandomTest({64, 33, 130}, {2});
+  CPURandomTest({64, 33, 130}, {1});
+  CPURandomTest({64, 33, 130}, {0, 2});
+  CPURandomTest({2, 3, 4, 5, 6}, {1, 3});
+  CPURandomTest({3, 1, 5, 7, 2, 4}, {0, 2, 5});
+  CPURandomTest({3, 4, 5, 6}, {});
+  CPURandomTest({3, 4, 5, 6}, {-1, -3});
+  // the reduce axis split among threads
+  CPURandomTest({1, 200003}, {1});
+  CPURandomTest({70001, 3}, {0});
+  CPURandomTest({2, 30001, 5}, {1});
+  // nothing to reduce
+  CPURandomTest({4, 1, 5}, {1});
+}
+
 namespace {
 
 void TestQuant(const std::vector<index_t> &input_shape,
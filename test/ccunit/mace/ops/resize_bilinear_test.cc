@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #include "mace/ops/ops_test_util.h"
@@ -220,8 +222,106 @@ void TestQuantizedResizeBilinear() {
   }
 }
 
+void ResizeBilinearReference(const Tensor &input,
+                             const index_t out_height,
+                             const index_t out_width,
+                             const bool align_corners,
+                             const int coordinate_transformation_mode,
+                             std::vector<float> *output) {
+  const index_t planes = input.dim(0) * input.dim(1);
+  const index_t in_height = input.dim(2);
+  const index_t in_width = input.dim(3);
+  auto source = [&](index_t out_size, index_t in_size, index_t i,
+                    index_t *lower, index_t *upper, float *lerp) {
+    const float scale = (align_corners && out_size > 1) ?
+        (in_size - 1) / static_cast<float>(out_size - 1) :
+        in_size / static_cast<float>(out_size);
+    float in = i * scale;
+    if (coordinate_transformation_mode == 1 ||
+        (coordinate_transformation_mode == 2 && out_size > 1)) {
+      in = (i + 0.5f) * scale - 0.5f;
+    } else if (coordinate_transformation_mode == 2) {
+      in = 0;
+    }
+    *lower = std::max<index_t>(static_cast<index_t>(std::floor(in)), 0);
+    *upper = std::min<index_t>(static_cast<index_t>(std::ceil(in)),
+                               in_size - 1);
+    *lerp = in - std::floor(in);
+  };
+  const float *input_data = input.data<float>();
+  output->resize(planes * out_height * out_width);
+  for (index_t p = 0; p < planes; ++p) {
+    const float *in = input_data + p * in_height * in_width;
+    for (index_t y = 0; y < out_height; ++y) {
+      index_t y0, y1;
+      float ly;
+      source(out_height, in_height, y, &y0, &y1, &ly);
+      for (index_t x = 0; x < out_width; ++x) {
+        index_t x0, x1;
+        float lx;
+        source(out_width, in_width, x, &x0, &x1, &lx);
+        const float top = in[y0 * in_width + x0] +
+            (in[y0 * in_width + x1] - in[y0 * in_width + x0]) * lx;
+        const float bottom = in[y1 * in_width + x0] +
+            (in[y1 * in_width + x1] - in[y1 * in_width + x0]) * lx;
+        (*output)[(p * out_height + y) * out_width + x] =
+            top + (bottom - top) * ly;
+      }
+    }
+  }
+}
+
+// Runs one op over inputs of changing shapes, which have to rebuild the
+// cached interpolation plan. The first input is the largest one, the
+// buffers are planned at setup.
+void TestResizeBilinearWithReference(const index_t out_height,
+                                     const index_t out_width,
+                                     const int align_corners,
+                                     const int coordinate_transformation_mode) {
+  const std::vector<std::vector<index_t>> input_shapes = {
+      {2, 5, 64, 20}, {1, 3, 37, 53}, {2, 5, 30, 40}};
+
+  OpsTestNet net;
+  net.AddRandomInput<RuntimeType::RT_CPU, float>("Input", input_shapes[0],
+                                                 false, false);
+  OpDefBuilder("ResizeBilinear", "ResizeBilinearTest")
+      .Input("Input")
+      .Output("Output")
+      .AddIntArg("align_corners", align_corners)
+      .AddIntArg("coordinate_transformation_mode",
+                 coordinate_transformation_mode)
+      .AddIntsArg("size", {static_cast<int>(out_height),
+                           static_cast<int>(out_width)})
+      .Finalize(net.NewOperatorDef());
+  net.Setup(RuntimeType::RT_CPU);
+
+  for (const auto &input_shape : input_shapes) {
+    net.AddRandomInput<RuntimeType::RT_CPU, float>("Input", input_shape,
+                                                   false, false);
+    net.Run();
+
+    std::vector<float> expected_data;
+    ResizeBilinearReference(*net.GetTensor("Input"), out_height, out_width,
+                            align_corners, coordinate_transformation_mode,
+                            &expected_data);
+    auto expected = net.CreateTensor<float>(
+        {input_shape[0], input_shape[1], out_height, out_width},
+        expected_data);
+    ExpectTensorNear<float>(*expected, *net.GetOutput("Output"), 1e-5,
+                            1e-5);
+  }
+}
+
 }  // namespace
 
+TEST_F(ResizeBilinearTest, CPUResizeBilinearWithReference) {
+  TestResizeBilinearWithReference(111, 75, 0, 0);
+  TestResizeBilinearWithReference(111, 75, 1, 0);
+  TestResizeBilinearWithReference(20, 160, 0, 1);
+  TestResizeBilinearWithReference(1, 33, 0, 2);
+  TestResizeBilinearWithReference(29, 19, 0, 2);
+}
+
 TEST_F(ResizeBilinearTest, OPENCLRandomResizeBilinear) {
   TestRandomResizeBilinear<RuntimeType::RT_OPENCL>();
 }
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <functional>
 #include <vector>
 
@@ -192,6 +193,74 @@ TEST_F(SplitOpTest, CPUAxis1) {
   RandomTest<RuntimeType::RT_CPU, float>(11, 3);
 }
 
+TEST_F(SplitOpTest, CPUZeroCopy) {
+  // Split outputs are planned as views of the input, and the channel
+  // shuffled consumers as views of the concat output.
+  OpsTestNet net;
+  const std::vector<index_t> input_shape = {1, 6, 3, 4};
+  const std::vector<index_t> output_shape = {1, 3, 3, 4};
+  OpDefBuilder("Activation", "ReluTest")
+      .Input("Input")
+      .Output("Relu")
+      .OutputShape(input_shape)
+      .AddStringArg("activation", "RELU")
+      .Finalize(net.AddNewOperatorDef());
+  OpDefBuilder("Split", "SplitTest")
+      .Input("Relu")
+      .Output("Split0")
+      .Output("Split1")
+      .OutputShape(output_shape)
+      .OutputShape(output_shape)
+      .AddIntArg("axis", 1)
+      .Finalize(net.AddNewOperatorDef());
+  for (int i = 0; i < 2; ++i) {
+    OpDefBuilder("Activation", MakeString("ReluTest", i))
+        .Input(MakeString("Split", i))
+        .Output(MakeString("Relu", i))
+        .OutputShape(output_shape)
+        .AddStringArg("activation", "RELU")
+        .Finalize(net.AddNewOperatorDef());
+  }
+  OpDefBuilder("Concat", "ConcatTest")
+      .Input("Relu1")
+      .Input("Relu0")
+      .Output("Output")
+      .OutputShape(input_shape)
+      .AddIntArg("axis", 1)
+      .Finalize(net.AddNewOperatorDef());
+
+  auto run_and_check = [&](const std::vector<index_t> &shape,
+                           const bool setup) {
+    std::vector<float> input;
+    GenerateRandomRealTypeData(shape, &input);
+    net.AddInputFromArray<RuntimeType::RT_CPU, float>("Input", shape, input);
+    if (setup) {
+      net.Setup(RuntimeType::RT_CPU);
+    }
+    net.Run();
+
+    const index_t half = input.size() / 2;
+    std::vector<float> expected(input.size());
+    for (index_t i = 0; i < half; ++i) {
+      expected[i] = std::max(input[half + i], 0.f);
+      expected[half + i] = std::max(input[i], 0.f);
+    }
+    auto expected_output = net.CreateTensor<float>(shape, expected);
+    ExpectTensorNear<float>(*expected_output, *net.GetOutput("Output"));
+  };
+
+  run_and_check(input_shape, true);
+  const float *relu_data = net.GetOutput("Relu")->data<float>();
+  EXPECT_EQ(relu_data, net.GetOutput("Split0")->data<float>());
+  EXPECT_EQ(relu_data + 36, net.GetOutput("Split1")->data<float>());
+  const float *output_data = net.GetOutput("Output")->data<float>();
+  EXPECT_EQ(output_data, net.GetOutput("Relu1")->data<float>());
+  EXPECT_EQ(output_data + 36, net.GetOutput("Relu0")->data<float>());
+
+  // Smaller inputs leave the views out of place
+  run_and_check({1, 4, 3, 4}, false);
+}
+
 TEST_F(SplitOpTest, OPENCLFloat) {
   RandomTest<RuntimeType::RT_OPENCL, float>(2, 3);
   RandomTest<RuntimeType::RT_OPENCL, float>(4, 3);
@@ -0,0 +1,140 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <vector>
+
+#include "mace/ops/ops_test_util.h"
+
+namespace mace {
+namespace ops {
+namespace test {
+
+class TopKOpTest : public OpsTestBase {};
+
+namespace {
+void TopKTest(const std::vector<index_t> &input_shape,
+              const std::vector<float> &input,
+              const int k,
+              const int axis,
+              const bool largest,
+              const std::vector<index_t> &output_shape,
+              const std::vector<float> &values,
+              const std::vector<int32_t> &indices,
+              const bool k_as_input = false) {
+  OpsTestNet net;
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>("Input", input_shape,
+                                                    input);
+  OpDefBuilder builder("TopK", "TopKTest");
+  builder.Input("Input");
+  if (k_as_input) {
+    net.AddInputFromArray<RuntimeType::RT_CPU, int32_t>("K", {1}, {k});
+    builder.Input("K");
+  } else {
+    builder.AddIntArg("top_k", k);
+  }
+  builder.AddIntArg("axis", axis)
+      .AddIntArg("largest", largest ? 1 : 0)
+      .Output("Values")
+      .Output("Indices")
+      .OutputType({DT_FLOAT, DT_INT32})
+      .Finalize(net.NewOperatorDef());
+  net.RunOp(RuntimeType::RT_CPU);
+
+  auto expected_values = net.CreateTensor<float>(output_shape, values);
+  ExpectTensorNear<float>(*expected_values, *net.GetOutput("Values"), 1e-5);
+  auto expected_indices = net.CreateTensor<int32_t>(output_shape, indices);
+  ExpectTensorNear<int32_t>(*expected_indices, *net.GetOutput("Indices"),
+                            0);
+}
+
+void RandomTopKTest(const index_t rows, const index_t size, const int k,
+                    const bool largest, const bool sorted) {
+  OpsTestNet net;
+  std::vector<float> input(rows * size);
+  unsigned int seed = 1;
+  for (auto &value : input) {
+    // Small integers so that there are plenty of equal values.
+    value = static_cast<float>(rand_r(&seed) % 1000);
+  }
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>("Input", {rows, size},
+                                                    input);
+  OpDefBuilder("TopK", "TopKTest")
+      .Input("Input")
+      .AddIntArg("top_k", k)
+      .AddIntArg("largest", largest ? 1 : 0)
+      .AddIntArg("sorted", sorted ? 1 : 0)
+      .Output("Values")
+      .Output("Indices")
+      .OutputType({DT_FLOAT, DT_INT32})
+      .Finalize(net.NewOperatorDef());
+  net.RunOp(RuntimeType::RT_CPU);
+
+  auto values = net.GetOutput("Values");
+  auto indices = net.GetOutput("Indices");
+  ASSERT_EQ(values->dim(1), k);
+  const float *values_data = values->data<float>();
+  const int32_t *indices_data = indices->data<int32_t>();
+  for (index_t r = 0; r < rows; ++r) {
+    std::vector<std::pair<float, int32_t>> expected(size);
+    for (index_t i = 0; i < size; ++i) {
+      const float value = input[r * size + i];
+      expected[i] = std::make_pair(largest ? -value : value,
+                                   static_cast<int32_t>(i));
+    }
+    std::partial_sort(expected.begin(), expected.begin() + k,
+                      expected.end());
+    std::vector<std::pair<float, int32_t>> actual(k);
+    for (int j = 0; j < k; ++j) {
+      const float value = values_data[r * k + j];
+      actual[j] = std::make_pair(largest ? -value : value,
+                                 indices_data[r * k + j]);
+      EXPECT_EQ(input[r * size + actual[j].second], value);
+    }
+    if (!sorted) {
+      std::sort(actual.begin(), actual.end());
+    }
+    for (int j = 0; j < k; ++j) {
+      EXPECT_EQ(expected[j], actual[j]) << "row " << r << " top " << j;
+    }
+  }
+}
+}  // namespace
+
+TEST_F(TopKOpTest, Simple) {
+  TopKTest({2, 4}, {1, 7, 3, 7, 5, 2, 8, 0}, 2, -1, true,
+           {2, 2}, {7, 7, 8, 5}, {1, 3, 2, 0});
+  TopKTest({2, 4}, {1, 7, 3, 7, 5, 2, 8, 0}, 3, 1, false,
+           {2, 3}, {1, 3, 7, 0, 2, 5}, {0, 2, 1, 3, 1, 0});
+  TopKTest({2, 4}, {1, 7, 3, 7, 5, 2, 8, 0}, 1, 1, true,
+           {2, 1}, {7, 8}, {1, 2}, true);
+}
+
+TEST_F(TopKOpTest, Axis) {
+  TopKTest({3, 2}, {1, 6, 5, 2, 3, 4}, 2, 0, true,
+           {2, 2}, {5, 6, 3, 4}, {1, 0, 2, 2});
+}
+
+TEST_F(TopKOpTest, Random) {
+  RandomTopKTest(3, 40000, 5, true, true);
+  RandomTopKTest(3, 40000, 5, false, false);
+  RandomTopKTest(5, 3000, 50, true, true);
+  RandomTopKTest(5, 3000, 500, false, true);
+  RandomTopKTest(5, 3000, 500, true, false);
+  RandomTopKTest(2, 35000, 20000, true, true);
+}
+
+}  // namespace test
+}  // namespace ops
+}  // namespace mace
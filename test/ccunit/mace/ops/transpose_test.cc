@@ -159,6 +159,71 @@ Transpose3DTest({2, 3, 2},
                 {1, 7, 3, 9, 5, 11, 2, 8, 4, 10, 6, 12});
 }
 
+namespace {
+void TransposeRankNTest(const std::vector<index_t> &input_shape,
+                        const std::vector<int> &dest_dims) {
+  // Construct graph
+  OpsTestNet net;
+  // Add input data
+  net.AddRandomInput<RuntimeType::RT_CPU, float>("Input", input_shape);
+
+  OpDefBuilder("Transpose", "TransposeRankNTest")
+      .Input("Input")
+      .Output("Output")
+      .AddIntsArg("dims", dest_dims)
+      .Finalize(net.NewOperatorDef());
+
+  // Run on cpu
+  net.RunOp();
+
+  // Reference: walk the output and read the input by strides
+  const int rank = static_cast<int>(input_shape.size());
+  std::vector<index_t> in_strides(rank, 1);
+  for (int i = rank - 2; i >= 0; --i) {
+    in_strides[i] = in_strides[i + 1] * input_shape[i + 1];
+  }
+  std::vector<index_t> expected_shape(rank);
+  for (int i = 0; i < rank; ++i) {
+    expected_shape[i] = input_shape[dest_dims[i]];
+  }
+  const Tensor *input = net.GetTensor("Input");
+  const float *input_data = input->data<float>();
+  std::vector<float> expected_data(input->size());
+  std::vector<index_t> index(rank, 0);
+  for (size_t i = 0; i < expected_data.size(); ++i) {
+    index_t in_offset = 0;
+    for (int k = 0; k < rank; ++k) {
+      in_offset += index[k] * in_strides[dest_dims[k]];
+    }
+    expected_data[i] = input_data[in_offset];
+    for (int k = rank - 1; k >= 0; --k) {
+      if (++index[k] < expected_shape[k]) break;
+      index[k] = 0;
+    }
+  }
+  net.AddInputFromArray<RuntimeType::RT_CPU, float>(
+      "ExpectedOutput", expected_shape, expected_data);
+
+  ExpectTensorNear<float>(*net.GetOutput("ExpectedOutput"),
+                          *net.GetOutput("Output"));
+}
+}  // namespace
+
+TEST_F(TransposeOpTest, RankN) {
+  TransposeRankNTest({37, 45}, {1, 0});
+  TransposeRankNTest({3, 70, 33}, {0, 2, 1});
+  TransposeRankNTest({3, 70, 33}, {2, 1, 0});
+  TransposeRankNTest({2, 1, 17, 5}, {2, 0, 3, 1});
+  TransposeRankNTest({2, 5, 7, 8}, {0, 2, 1, 3});
+  TransposeRankNTest({2, 5, 7, 8}, {0, 1, 2, 3});
+  // attention head split and merge
+  TransposeRankNTest({2, 16, 4, 24}, {0, 2, 1, 3});
+  TransposeRankNTest({2, 3, 4, 5, 6}, {0, 3, 1, 4, 2});
+  TransposeRankNTest({2, 3, 4, 5, 6}, {4, 3, 2, 1, 0});
+  TransposeRankNTest({2, 4, 3, 5, 6, 7}, {0, 1, 3, 2, 5, 4});
+  TransposeRankNTest({1, 8, 2, 9, 3, 10}, {5, 0, 4, 2, 1, 3});
+}
+
 }  // namespace test
 }  // namespace ops
 }  // namespace mace
@@ -0,0 +1,248 @@
+// Copyright 2021 The MACE Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mace/ops/x86/bf16/gemm.h"
+#include "mace/ops/x86/bf16/gemv.h"
+
+#include <gtest/gtest.h>
+
+#include "mace/core/ops/op_context.h"
+#include "mace/core/tensor.h"
+#include "mace/ops/common/gemm_epilogue.h"
+#include "mace/ops/ops_test_util.h"
+#include "mace/ops/testing/test_utils.h"
+#include "mace/ops/x86/base/cpu_features.h"
+
+namespace mace {
+namespace ops {
+namespace test {
+
+namespace {
+// The x86 kernels are created directly instead of through the delegator
+// registry, which falls back to REF on a cpu without the features, so the
+// tests compare them with REF only where they can run.
+bool SkipWithoutFeatures(const bool supported) {
+  if (!supported) {
+    LOG(WARNING) << "Skip the test, the cpu has no AVX-512 BF16 or AMX-BF16";
+  }
+  return !supported;
+}
+
+bool HasGemmFeatures() {
+  const x86::CpuFeatures &features = x86::GetCpuFeatures();
+  return features.avx512bf16 || features.amx_bf16;
+}
+}  // namespace
+
+void TestGemmBFloat16(const index_t batch,
+                      const index_t rows,
+                      const index_t cols,
+                      const index_t depth,
+                      const MatrixMajor lhs_major,
+                      const MatrixMajor rhs_major,
+                      const MatrixMajor output_major,
+                      const bool lhs_batched,
+                      const bool rhs_batched) {
+  auto *cpu_runtime = OpTestContext::Get()->GetRuntime(RuntimeType::RT_CPU);
+  Tensor lhs(cpu_runtime, DT_BFLOAT16);
+  Tensor rhs(cpu_runtime, DT_BFLOAT16);
+  Tensor output(cpu_runtime, DT_BFLOAT16);
+  lhs.Resize({lhs_batched ? batch : 1, rows, depth});
+  rhs.Resize({rhs_batched ? batch : 1, depth, cols});
+  output.Resize({batch, rows, cols});
+  {
+    Tensor::MappingGuard lhs_guard(&lhs);
+    Tensor::MappingGuard rhs_guard(&rhs);
+    auto lhs_data = lhs.mutable_data<BFloat16>();
+    auto rhs_data = rhs.mutable_data<BFloat16>();
+    auto output_data = output.mutable_data<BFloat16>();
+    GenerateRandomRealTypeData<BFloat16>(lhs.shape(), lhs_data);
+    GenerateRandomRealTypeData<BFloat16>(rhs.shape(), rhs_data);
+    GenerateRandomRealTypeData<BFloat16>(output.shape(), output_data);
+  }
+
+  utils::ThreadPool thread_pool(1, AFFINITY_NONE);
+  thread_pool.Init();
+  OpsTestNet net;
+  OpContext context(net.ws(), cpu_runtime);
+  std::unique_ptr<delegator::Gemm> gemm =
+      make_unique<x86::bf16::Gemm>(delegator::GemmParam());
+  gemm->Compute(&context, &lhs, &rhs, batch, rows, cols, depth, lhs_major,
+                rhs_major, output_major, lhs_batched, rhs_batched, &output);
+
+  Tensor expected_output(cpu_runtime, DataType::DT_BFLOAT16);
+  expected_output.Resize({batch, rows, cols});
+  std::unique_ptr<delegator::Gemm> gemm_ref = delegator::Gemm::Create(
+      context.workspace(),
+      MACE_DELEGATOR_KEY(Gemm, RuntimeType::RT_CPU, BFloat16, ImplType::REF),
+      delegator::GemmParam());
+  gemm_ref->Compute(&context, &lhs, &rhs, batch, rows, cols, depth, lhs_major,
+                    rhs_major, output_major, lhs_batched, rhs_batched,
+                    &expected_output);
+
+  ExpectTensorSimilar<BFloat16>(expected_output, output, 1e-4);
+}
+
+TEST(X86Gemm, TestGemmBF16) {
+  if (SkipWithoutFeatures(HasGemmFeatures())) {
+    return;
+  }
+  TestGemmBFloat16(1, 47, 69, 37, RowMajor, RowMajor, RowMajor, true, true);
+  TestGemmBFloat16(1, 47, 69, 37, RowMajor, RowMajor, ColMajor, true, true);
+  TestGemmBFloat16(1, 47, 69, 37, RowMajor, ColMajor, RowMajor, true, true);
+  TestGemmBFloat16(1, 47, 69, 37, RowMajor, ColMajor, ColMajor, true, true);
+  TestGemmBFloat16(1, 47, 69, 37, ColMajor, RowMajor, RowMajor, true, true);
+  TestGemmBFloat16(1, 47, 69, 37, ColMajor, RowMajor, ColMajor, true, true);
+  TestGemmBFloat16(1, 47, 69, 37, ColMajor, ColMajor, RowMajor, true, true);
+  TestGemmBFloat16(1, 47, 69, 37, ColMajor, ColMajor, ColMajor, true, true);
+
+  TestGemmBFloat16(3, 47, 69, 37, RowMajor, RowMajor, RowMajor, true, true);
+  TestGemmBFloat16(3, 47, 69, 37, RowMajor, RowMajor, ColMajor, true, true);
+  TestGemmBFloat16(3, 47, 69, 37, RowMajor, ColMajor, RowMajor, true, true);
+  TestGemmBFloat16(3, 47, 69, 37, RowMajor, ColMajor, ColMajor, true, true);
+  TestGemmBFloat16(3, 47, 69, 37, ColMajor, RowMajor, RowMajor, true, true);
+  TestGemmBFloat16(3, 47, 69, 37, ColMajor, RowMajor, ColMajor, true, true);
+  TestGemmBFloat16(3, 47, 69, 37, ColMajor, ColMajor, RowMajor, true, true);
+  TestGemmBFloat16(3, 47, 69, 37, ColMajor, ColMajor, ColMajor, true, true);
+
+  TestGemmBFloat16(3, 47, 69, 37, RowMajor, RowMajor, RowMajor, true, false);
+  TestGemmBFloat16(3, 47, 69, 37, RowMajor, RowMajor, RowMajor, false, true);
+
+  TestGemmBFloat16(16, 31, 61, 67, RowMajor, ColMajor, RowMajor, true, true);
+  TestGemmBFloat16(2, 64, 128, 96, RowMajor, RowMajor, RowMajor, true, false);
+}
+
+void TestGemmBFloat16WithEpilogue(const index_t rows,
+                                  const index_t cols,
+                                  const index_t depth,
+                                  const MatrixMajor lhs_major,
+                                  const MatrixMajor rhs_major,
+                                  const ActivationType activation,
+                                  const bool with_bias) {
+  auto *cpu_runtime = OpTestContext::Get()->GetRuntime(RuntimeType::RT_CPU);
+  Tensor lhs(cpu_runtime, DT_BFLOAT16);
+  Tensor rhs(cpu_runtime, DT_BFLOAT16);
+  Tensor bias(cpu_runtime, DT_BFLOAT16);
+  Tensor output(cpu_runtime, DT_BFLOAT16);
+  lhs.Resize({rows, depth});
+  rhs.Resize({depth, cols});
+  bias.Resize({cols});
+  output.Resize({rows, cols});
+  {
+    Tensor::MappingGuard lhs_guard(&lhs);
+    Tensor::MappingGuard rhs_guard(&rhs);
+    Tensor::MappingGuard bias_guard(&bias);
+    GenerateRandomRealTypeData<BFloat16>(lhs.shape(),
+                                         lhs.mutable_data<BFloat16>());
+    GenerateRandomRealTypeData<BFloat16>(rhs.shape(),
+                                         rhs.mutable_data<BFloat16>());
+    GenerateRandomRealTypeData<BFloat16>(bias.shape(),
+                                         bias.mutable_data<BFloat16>());
+  }
+  GemmEpilogue epilogue;
+  epilogue.bias = with_bias ? &bias : nullptr;
+  epilogue.activation = activation;
+  epilogue.relux_max_limit = 0.5f;
+  epilogue.activation_coefficient = 0.1f;
+
+  OpsTestNet net;
+  OpContext context(net.ws(), cpu_runtime);
+  std::unique_ptr<delegator::Gemm> gemm =
+      make_unique<x86::bf16::Gemm>(delegator::GemmParam());
+  gemm->ComputeWithEpilogue(&context, &lhs, &rhs, rows, cols, depth,
+                            lhs_major, rhs_major, epilogue, &output);
+
+  Tensor expected_output(cpu_runtime, DataType::DT_BFLOAT16);
+  expected_output.Resize({rows, cols});
+  std::unique_ptr<delegator::Gemm> gemm_ref = delegator::Gemm::Create(
+      context.workspace(),
+      MACE_DELEGATOR_KEY(Gemm, RuntimeType::RT_CPU, BFloat16, ImplType::REF),
+      delegator::GemmParam());
+  gemm_ref->ComputeWithEpilogue(&context, &lhs, &rhs, rows, cols, depth,
+                                lhs_major, rhs_major, epilogue,
+                                &expected_output);
+
+  ExpectTensorSimilar<BFloat16>(expected_output, output, 1e-4);
+}
+
+TEST(X86Gemm, TestGemmBF16WithEpilogue) {
+  if (SkipWithoutFeatures(HasGemmFeatures())) {
+    return;
+  }
+  TestGemmBFloat16WithEpilogue(47, 69, 37, RowMajor, RowMajor, NOOP, true);
+  TestGemmBFloat16WithEpilogue(47, 69, 37, RowMajor, ColMajor, RELU, true);
+  TestGemmBFloat16WithEpilogue(47, 69, 37, ColMajor, RowMajor, RELUX, false);
+  TestGemmBFloat16WithEpilogue(64, 128, 96, RowMajor, RowMajor, LEAKYRELU,
+                               true);
+  TestGemmBFloat16WithEpilogue(1, 61, 67, RowMajor, ColMajor, TANH, true);
+}
+
+void TestGemvBFloat16(const index_t batch,
+                      const index_t height,
+                      const index_t width,
+                      const bool lhs_batched,
+                      const bool rhs_batched) {
+  auto *cpu_runtime = OpTestContext::Get()->GetRuntime(RuntimeType::RT_CPU);
+  Tensor lhs(cpu_runtime, DT_BFLOAT16);
+  Tensor rhs(cpu_runtime, DT_BFLOAT16);
+  Tensor bias(cpu_runtime, DT_BFLOAT16);
+  Tensor output(cpu_runtime, DT_BFLOAT16);
+  lhs.Resize({lhs_batched ? batch : 1, height, width});
+  rhs.Resize({rhs_batched ? batch : 1, width});
+  bias.Resize({height});
+  output.Resize({batch, height});
+  {
+    Tensor::MappingGuard lhs_guard(&lhs);
+    Tensor::MappingGuard rhs_guard(&rhs);
+    Tensor::MappingGuard bias_guard(&bias);
+    GenerateRandomRealTypeData<BFloat16>(lhs.shape(),
+                                         lhs.mutable_data<BFloat16>());
+    GenerateRandomRealTypeData<BFloat16>(rhs.shape(),
+                                         rhs.mutable_data<BFloat16>());
+    GenerateRandomRealTypeData<BFloat16>(bias.shape(),
+                                         bias.mutable_data<BFloat16>());
+  }
+
+  OpsTestNet net;
+  OpContext context(net.ws(), cpu_runtime);
+  std::unique_ptr<delegator::Gemv> gemv =
+      make_unique<x86::bf16::Gemv>(DelegatorParam());
+  gemv->Compute(&context, &lhs, &rhs, &bias, batch, height, width,
+                lhs_batched, rhs_batched, &output);
+
+  Tensor expected_output(cpu_runtime, DataType::DT_BFLOAT16);
+  expected_output.Resize({batch, height});
+  std::unique_ptr<delegator::Gemv> gemv_ref = delegator::Gemv::Create(
+      context.workspace(),
+      MACE_DELEGATOR_KEY(Gemv, RuntimeType::RT_CPU, BFloat16, ImplType::REF),
+      DelegatorParam());
+  gemv_ref->Compute(&context, &lhs, &rhs, &bias, batch, height, width,
+                    lhs_batched, rhs_batched, &expected_output);
+
+  ExpectTensorSimilar<BFloat16>(expected_output, output, 1e-4);
+}
+
+TEST(X86Gemv, TestGemvBF16) {
+  if (SkipWithoutFeatures(x86::GetCpuFeatures().avx512bf16)) {
+    return;
+  }
+  TestGemvBFloat16(1, 47, 69, true, true);
+  TestGemvBFloat16(3, 47, 69, true, true);
+  TestGemvBFloat16(3, 64, 256, false, true);
+  TestGemvBFloat16(3, 13, 1000, true, false);
+}
+
+}  // namespace test
+}  // namespace ops
+}  // namespace mace
@@ -37,5 +37,16 @@ TEST_F(EnvTest, CPUInfo) {
   SchedSetAffinity(cpu_ids);
 }
 
+TEST_F(EnvTest, CPUTopology) {
+  port::CPUTopology topology;
+  if (GetCPUTopology(&topology) == MaceStatus::MACE_SUCCESS) {
+    EXPECT_FALSE(topology.cpus.empty());
+    EXPECT_GE(topology.cpu_quota, 0);
+    for (size_t i = 1; i < topology.cpus.size(); ++i) {
+      EXPECT_LT(topology.cpus[i - 1].cpu_id, topology.cpus[i].cpu_id);
+    }
+  }
+}
+
 }  // namespace
 }  // namespace mace
@@ -13,7 +13,14 @@
 // limitations under the License.
 
 #include <gtest/gtest.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
 #include <cstdlib>
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
+#include <set>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 #include "mace/utils/thread_pool.h"
 
@@ -105,6 +112,154 @@ TEST_F(ThreadPoolTest, Compute3D) {
   }
 }
 
+TEST(CPUCoresToUseTest, Topology) {
+  // Four cores with SMT siblings and a single-threaded one, the last level
+  // caches are shared by CPUs {0, 1, 4, 5} and {2, 3, 6, 7, 8}
+  port::CPUTopology topology;
+  const int core_ids[] = {0, 1, 2, 3, 0, 1, 2, 3, 8};
+  const int llc_ids[] = {0, 0, 2, 2, 0, 0, 2, 2, 2};
+  for (size_t cpu_id = 0; cpu_id < 9; ++cpu_id) {
+    topology.cpus.push_back({cpu_id, core_ids[cpu_id], llc_ids[cpu_id], 0});
+  }
+  const std::vector<float> no_freqs;
+  const std::vector<size_t> no_numa_cpus;
+  int thread_count = -1;
+  std::vector<size_t> cores;
+
+  GetCPUCoresToUse(no_freqs, topology,
+                   CPUAffinityPolicy::AFFINITY_PHYSICAL_CORES, no_numa_cpus,
+                   &thread_count, &cores);
+  EXPECT_EQ(5, thread_count);
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2, 3, 8}), cores);
+
+  thread_count = -1;
+  GetCPUCoresToUse(no_freqs, topology, CPUAffinityPolicy::AFFINITY_SINGLE_LLC,
+                   no_numa_cpus, &thread_count, &cores);
+  EXPECT_EQ(3, thread_count);
+  EXPECT_EQ(std::vector<size_t>({2, 3, 8}), cores);
+
+  thread_count = 4;
+  GetCPUCoresToUse(no_freqs, topology,
+                   CPUAffinityPolicy::AFFINITY_HIGH_PERFORMANCE, no_numa_cpus,
+                   &thread_count, &cores);
+  EXPECT_EQ(4, thread_count);
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2, 3}), cores);
+
+  thread_count = -1;
+  GetCPUCoresToUse(no_freqs, topology,
+                   CPUAffinityPolicy::AFFINITY_PHYSICAL_CORES,
+                   std::vector<size_t>({2, 3, 6, 7}), &thread_count, &cores);
+  EXPECT_EQ(2, thread_count);
+  EXPECT_EQ(std::vector<size_t>({2, 3}), cores);
+
+  // The quota caps the threads but not the cores, rounded to the nearest
+  topology.cpu_quota = 2.5f;
+  thread_count = -1;
+  GetCPUCoresToUse(no_freqs, topology,
+                   CPUAffinityPolicy::AFFINITY_PHYSICAL_CORES, no_numa_cpus,
+                   &thread_count, &cores);
+  EXPECT_EQ(3, thread_count);
+  EXPECT_EQ(5u, cores.size());
+
+  thread_count = -1;
+  GetCPUCoresToUse(no_freqs, topology, CPUAffinityPolicy::AFFINITY_NONE,
+                   no_numa_cpus, &thread_count, &cores);
+  EXPECT_EQ(3, thread_count);
+  EXPECT_TRUE(cores.empty());
+
+  const float quotas[] = {0.2f, 1.2f, 1.5f};
+  const int quota_threads[] = {1, 1, 2};
+  for (int i = 0; i < 3; ++i) {
+    topology.cpu_quota = quotas[i];
+    thread_count = -1;
+    GetCPUCoresToUse(no_freqs, topology, CPUAffinityPolicy::AFFINITY_NONE,
+                     no_numa_cpus, &thread_count, &cores);
+    EXPECT_EQ(quota_threads[i], thread_count);
+  }
+
+  // Without a topology they fall back to AFFINITY_NONE
+  thread_count = -1;
+  cores.clear();
+  GetCPUCoresToUse(std::vector<float>(4, 1.0f), port::CPUTopology(),
+                   CPUAffinityPolicy::AFFINITY_PHYSICAL_CORES, no_numa_cpus,
+                   &thread_count, &cores);
+  EXPECT_EQ(4, thread_count);
+  EXPECT_TRUE(cores.empty());
+}
+
+TEST(CPUCoresToUseTest, ThreadCores) {
+  // Two cores with SMT siblings
+  port::CPUTopology topology;
+  const int core_ids[] = {0, 1, 0, 1};
+  for (size_t cpu_id = 0; cpu_id < 4; ++cpu_id) {
+    topology.cpus.push_back({cpu_id, core_ids[cpu_id], 0, 0});
+  }
+  const std::vector<size_t> no_numa_cpus;
+  int thread_count = -1;
+  std::vector<size_t> cores;
+  GetCPUCoresToUse(std::vector<float>(), topology,
+                   CPUAffinityPolicy::AFFINITY_PHYSICAL_CORES, no_numa_cpus,
+                   &thread_count, &cores);
+  auto thread_cores = GetThreadCores(
+      cores, CPUAffinityPolicy::AFFINITY_PHYSICAL_CORES, thread_count);
+  ASSERT_EQ(2u, thread_cores.size());
+  std::set<int> used_core_ids;
+  for (const auto &cpus : thread_cores) {
+    ASSERT_EQ(1u, cpus.size());
+    EXPECT_TRUE(used_core_ids.insert(core_ids[cpus[0]]).second);
+  }
+
+  // The other policies share the cores
+  thread_cores = GetThreadCores({0, 1, 2, 3},
+                                CPUAffinityPolicy::AFFINITY_HIGH_PERFORMANCE,
+                                4);
+  ASSERT_EQ(4u, thread_cores.size());
+  for (const auto &cpus : thread_cores) {
+    EXPECT_EQ(std::vector<size_t>({0, 1, 2, 3}), cpus);
+  }
+}
+
+#ifdef __linux__
+TEST(CPUCoresToUseTest, PhysicalCoresAffinity) {
+  port::CPUTopology topology;
+  if (port::Env::Default()->GetCPUTopology(&topology) !=
+      MaceStatus::MACE_SUCCESS || topology.cpus.empty()) {
+    return;
+  }
+  std::map<size_t, int> cpu_core_ids;
+  for (const auto &cpu : topology.cpus) {
+    cpu_core_ids[cpu.cpu_id] = cpu.core_id;
+  }
+
+  ThreadPool thread_pool(-1, CPUAffinityPolicy::AFFINITY_PHYSICAL_CORES);
+  thread_pool.Init();
+  std::mutex mutex;
+  std::map<std::thread::id, std::vector<size_t>> thread_masks;
+  thread_pool.Run([&](const int64_t) {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    ASSERT_EQ(0, sched_getaffinity(0, sizeof(mask), &mask));
+    std::vector<size_t> cpus;
+    for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &mask)) {
+        cpus.push_back(cpu);
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    thread_masks[std::this_thread::get_id()] = cpus;
+  }, 1024);
+
+  // Each thread is bound to its own physical core
+  std::set<int> used_core_ids;
+  for (const auto &thread_mask : thread_masks) {
+    ASSERT_EQ(1u, thread_mask.second.size());
+    const size_t cpu = thread_mask.second[0];
+    ASSERT_EQ(1u, cpu_core_ids.count(cpu));
+    EXPECT_TRUE(used_core_ids.insert(cpu_core_ids[cpu]).second);
+  }
+}
+#endif  // __linux__
+
 }  // namespace
 }  // namespace utils
 }  // namespace mace
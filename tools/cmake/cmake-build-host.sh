@@ -19,8 +19,14 @@ if [[ "$BFLOAT16" == "ON" ]]; then
     DMACE_ENABLE_BFLOAT16=ON
 fi
 
+MACE_ENABLE_X86=OFF
+if [[ "$(uname -m)" == "x86_64" ]]; then
+    MACE_ENABLE_X86=ON
+fi
+
 mkdir -p ${BUILD_DIR} && cd ${BUILD_DIR}
 cmake -DMACE_ENABLE_NEON=OFF         \
+      -DMACE_ENABLE_X86=${MACE_ENABLE_X86}     \
       -DMACE_ENABLE_QUANTIZE=OFF     \
       -DMACE_ENABLE_OPENCL=OFF       \
       -DMACE_ENABLE_BFLOAT16=${DMACE_ENABLE_BFLOAT16}     \
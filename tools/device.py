@@ -243,6 +243,10 @@ class DeviceWrapper:
             else:
                 model_data_file = "%s/%s.data" % (self.data_dir, model_tag)
 
+        quantize_range_file_name = ""
+        if quantize_stat:
+            quantize_range_file_name = "%s_quantize_range" % model_tag
+
         if self.system == SystemType.host:
             libmace_dynamic_lib_path = \
                 os.path.dirname(libmace_dynamic_library_path)
@@ -253,7 +257,6 @@ class DeviceWrapper:
                     "LD_LIBRARY_PATH=%s" % libmace_dynamic_lib_path,
                     "MACE_CPP_MIN_VLOG_LEVEL=%s" % vlog_level,
                     "MACE_RUNTIME_FAILURE_RATIO=%f" % runtime_failure_ratio,
-                    "MACE_LOG_TENSOR_RANGE=%d" % (1 if quantize_stat else 0),
                     "%s/%s" % (target_dir, target_name),
                     "--model_name=%s" % model_tag,
                     "--input_node=%s" % ",".join(input_nodes),
@@ -279,6 +282,9 @@ class DeviceWrapper:
                     "--gpu_perf_hint=%s" % gpu_perf_hint,
                     "--gpu_priority_hint=%s" % gpu_priority_hint,
                     "--model_file=%s" % mace_model_path,
+                    "--quantize_range_file=%s" % (
+                        "%s/%s" % (model_output_dir, quantize_range_file_name)
+                        if quantize_stat else ""),
                 ],
                 stderr=subprocess.PIPE,
                 stdout=subprocess.PIPE,
@@ -289,6 +295,9 @@ class DeviceWrapper:
             mace_check(p.returncode == 0,
                        ModuleName.RUN,
                        "Failed to run the model")
+            if quantize_stat:
+                six.print_("Quantize range file: %s/%s" %
+                           (model_output_dir, quantize_range_file_name))
             six.print_("Running finished!\n")
         elif self.system in [SystemType.android, SystemType.arm_linux]:
             self.rm(self.data_dir)
@@ -333,7 +342,6 @@ class DeviceWrapper:
                 "MACE_LIMIT_OPENCL_KERNEL_TIME=%s" % limit_opencl_kernel_time,
                 "MACE_OPENCL_QUEUE_WINDOW_SIZE=%s" % opencl_queue_window_size,
                 "MACE_RUNTIME_FAILURE_RATIO=%f" % runtime_failure_ratio,
-                "MACE_LOG_TENSOR_RANGE=%d" % (1 if quantize_stat else 0),
             ]
 
             apu_storage_cpy = False
@@ -474,6 +482,9 @@ class DeviceWrapper:
                 cmd.append("--benchmark=%s" % benchmark)
             if fake_warmup:
                 cmd.append("--fake_warmup=%s" % fake_warmup)
+            if quantize_stat:
+                cmd.append("--quantize_range_file=%s/%s" %
+                           (self.data_dir, quantize_range_file_name))
 
             cmd = ' '.join(cmd)
             cmd_file_name = "%s-%s-%s" % ('cmd_file',
@@ -498,6 +509,12 @@ class DeviceWrapper:
             if not sh_commands.stdout_success(self.stdout):
                 common.MaceLogger.error("Mace Run", "Mace run failed.")
 
+            if quantize_stat:
+                self.pull_from_data_dir(quantize_range_file_name,
+                                        model_output_dir)
+                six.print_("Quantize range file: %s/%s" %
+                           (model_output_dir, quantize_range_file_name))
+
             six.print_("Running finished!\n")
         else:
             six.print_('Unsupported system %s' % self.system, file=sys.stderr)
@@ -49,6 +49,13 @@ python tools/python/run_model.py \
 
 """
 
+# The values of mace_run's --calibration_method, see CalibrationMethod
+CALIBRATION_METHODS = {
+    "min_max": 1,
+    "percentile": 2,
+    "kl_divergence": 3,
+}
+
 
 def join_2d_array(xs):
     return ":".join([",".join([str(y) for y in x]) for x in xs])
@@ -203,7 +210,11 @@ def run_model_for_device(flags, args, dev, model_name, model_conf):
                "vlog_level should be greater than zeror")
     envs += ["MACE_CPP_MIN_VLOG_LEVEL=%s" % flags.vlog_level]
     if flags.quantize_stat:
-        envs += ["MACE_LOG_TENSOR_RANGE=1"]
+        opts += ["--quantize_range_file=%s/quantize_range" % install_dir,
+                 "--calibration_method=%s" %
+                 CALIBRATION_METHODS[flags.calibration_method],
+                 "--calibration_percentile=%s" %
+                 flags.calibration_percentile]
 
     build_dir = flags.build_dir + "/" + target_abi
     libs = []
@@ -246,6 +257,13 @@ def run_model_for_device(flags, args, dev, model_name, model_conf):
                          dev.info()["ro.product.model"].replace(' ', ''),
                          dev.info()["ro.board.platform"]))
 
+    if flags.quantize_stat:
+        range_file = flags.range_file
+        if not range_file:
+            range_file = workdir + "/" + model_name + "_quantize_range"
+        dev.pull(Target(install_dir + "/quantize_range"), range_file)
+        MaceLogger.info("Quantize range file: %s" % range_file)
+
     if flags.validate:
         validate_model_file = util.download_or_get_model(
             model_conf[ModelKeys.model_file_path],
@@ -407,6 +425,23 @@ def parse_args():
         "--quantize_stat",
         action="store_true",
         help="whether to stat quantization range.")
+    parser.add_argument(
+        "--calibration_method",
+        type=str,
+        default="min_max",
+        choices=sorted(CALIBRATION_METHODS.keys()),
+        help="statistics to choose the quantization ranges with.")
+    parser.add_argument(
+        "--calibration_percentile",
+        type=float,
+        default=99.99,
+        help="percentile of values kept by percentile calibration.")
+    parser.add_argument(
+        "--range_file",
+        type=str,
+        default="",
+        help="path to write the quantization ranges, "
+             "<output>/<model_name>/<model_name>_quantize_range by default.")
 
     return parser.parse_known_args()
 
@@ -121,6 +121,7 @@ MaceSupportedOps = [
     'DepthwiseDeconv2d',
     'Dequantize',
     'Eltwise',
+    'EmbeddingBag',
     'ExpandDims',
     'ExtractImagePatches',
     'ExtractPooling',
@@ -128,6 +129,7 @@ MaceSupportedOps = [
     'FullyConnected',
     'Gather',
     'GroupNorm',
+    'GRU',
     'Identity',
     'IfDefined',
     'InferConv2dShape',
@@ -135,6 +137,7 @@ MaceSupportedOps = [
     'KaldiBatchNorm',
     'LocalResponseNorm',
     'LpNorm',
+    'LSTM',
     'LSTMCell',
     'LstmNonlinear',
     'DynamicLSTM',
@@ -176,6 +179,7 @@ MaceSupportedOps = [
     'SumGroup',
     'TargetRMSNorm',
     'Tile',
+    'TopK',
     'Transpose',
     'DetectionOutput',
     'Where',
@@ -297,6 +301,10 @@ class MaceKeyword(object):
     mace_argmin_str = 'argmin'
     mace_out_val_str = 'out_val'
     mace_top_k_str = 'top_k'
+    mace_largest_str = 'largest'
+    mace_sorted_str = 'sorted'
+    mace_direction_str = 'direction'
+    mace_linear_before_reset_str = 'linear_before_reset'
     mace_round_mode_str = 'round_mode'
     mace_min_size_str = 'min_size'
     mace_max_size_str = 'max_size'
@@ -399,6 +407,7 @@ class TransformerRule(Enum):
     TRANSFORM_BIASADD_TO_ADD = 57
     TRANSFORM_SLICE_TO_STRIDED_SLICE = 58
     ADD_TRANSPOSE_FOR_HTP = 59
+    FOLD_EMBEDDING_BAG = 60
 
 
 class ConverterInterface(object):
@@ -697,6 +706,7 @@ class ConverterOption(object):
                 TransformerRule.FLATTEN_ATROUS_CONV,
                 TransformerRule.FOLD_ACTIVATION,
                 TransformerRule.FOLD_SQRDIFF_MEAN,
+                TransformerRule.FOLD_EMBEDDING_BAG,
                 # FOLD_INSTANCE_NORM depends on FOLD_SQRDIFF_MEAN
                 TransformerRule.FOLD_INSTANCE_NORM,
                 TransformerRule.FOLD_MOMENTS,
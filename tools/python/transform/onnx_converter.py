@@ -100,7 +100,7 @@ OnnxSupportedOps = [
     # 'EyeLike',
     'Flatten',
     # 'Floor',
-    # 'GRU',
+    'GRU',
     'Gather',
     'Gemm',
     'GlobalAveragePool',
@@ -193,7 +193,7 @@ OnnxSupportedOps = [
     'Tanh',
     'TargetRMSNorm',
     # 'Tile',
-    # 'TopK',
+    'TopK',
     'Transpose',
     'Where',
     'Unsqueeze',
@@ -369,6 +369,7 @@ class OnnxConverter(base_converter.ConverterInterface):
             OnnxOpType.Flatten.name: self.convert_flatten,
             OnnxOpType.Gather.name: self.convert_gather,
             OnnxOpType.Gemm.name: self.convert_gemm,
+            OnnxOpType.GRU.name: self.convert_gru,
             OnnxOpType.GlobalAveragePool.name: self.convert_reduce,
             OnnxOpType.GlobalMaxPool.name: self.convert_reduce,
             OnnxOpType.HardSigmoid.name: self.convert_activation,
@@ -380,6 +381,7 @@ class OnnxConverter(base_converter.ConverterInterface):
             OnnxOpType.Linear.name: self.convert_affine,
             OnnxOpType.LogSoftmax.name: self.convert_softmax,
             OnnxOpType.LpNormalization: self.convert_lpnormalization,
+            OnnxOpType.LSTM.name: self.convert_lstm,
             OnnxOpType.LstmNonlinear.name: self.convert_lstm_nonlinear,
             OnnxOpType.DynamicLSTM.name: self.convert_dynamic_lstm,
             OnnxOpType.Max.name: self.convert_eltwise,
@@ -423,6 +425,7 @@ class OnnxConverter(base_converter.ConverterInterface):
             OnnxOpType.SumGroup.name: self.convert_sum_group,
             OnnxOpType.Tanh.name: self.convert_activation,
             OnnxOpType.TargetRMSNorm: self.convert_target_rms_norm,
+            OnnxOpType.TopK.name: self.convert_top_k,
             OnnxOpType.Transpose.name: self.convert_transpose,
             OnnxOpType.Unsqueeze.name: self.convert_unsqueeze,
             OnnxOpType.Upsample.name: self.convert_upsample,
@@ -841,6 +844,36 @@ class OnnxConverter(base_converter.ConverterInterface):
             min_arg.name = MaceKeyword.mace_argmin_str
             min_arg.i = 1
 
+    def convert_top_k(self, node):
+        op = self.convert_general_op(node)
+        op.type = MaceOp.TopK.name
+        op.output_type.extend([self._option.data_type, mace_pb2.DT_INT32])
+
+        # k is an attribute before opset 10 and an input since then, a
+        # non-constant k input is read at runtime
+        k = None
+        if 'k' in node.attrs:
+            k = node.attrs['k']
+        elif node.inputs[1] in self._consts:
+            k = self._consts[node.inputs[1]].int32_data[0]
+            del op.input[1]
+        if k is not None:
+            top_k_arg = op.arg.add()
+            top_k_arg.name = MaceKeyword.mace_top_k_str
+            top_k_arg.i = k
+
+        axis_arg = op.arg.add()
+        axis_arg.name = MaceKeyword.mace_axis_str
+        axis_arg.i = node.attrs.get('axis', -1)
+
+        largest_arg = op.arg.add()
+        largest_arg.name = MaceKeyword.mace_largest_str
+        largest_arg.i = node.attrs.get('largest', 1)
+
+        sorted_arg = op.arg.add()
+        sorted_arg.name = MaceKeyword.mace_sorted_str
+        sorted_arg.i = node.attrs.get('sorted', 1)
+
     def convert_biasadd(self, node):
         self.convert_general_op(node)
         op.type = MaceOp.BiasAdd.name
@@ -1477,9 +1510,63 @@ class OnnxConverter(base_converter.ConverterInterface):
                         mace_pb2.DT_FLOAT, bias_value)
         op.input.extend([scale_name, bias_name])
 
-    def convert_lstm(self, node):
+    def convert_recurrent(self, node, gates, default_activations):
         op = self.convert_general_op(node)
-        op.type = MaceOp.LSTMCell.name
+        mace_check(node.attrs.get('layout', 0) == 0,
+                   "%s: only the [seq_length, batch, input_size] layout is "
+                   "supported" % node.name)
+        direction = node.attrs.get('direction', 'forward')
+        directions = 2 if direction == 'bidirectional' else 1
+        if 'activations' in node.attrs:
+            mace_check(list(node.attrs['activations']) ==
+                       default_activations * directions,
+                       "%s: only the default activations are supported"
+                       % node.name)
+
+        # X, W, R, B, sequence_lens, initial_h, initial_c, P
+        inputs = list(op.input) + [''] * (8 - len(op.input))
+        mace_check(inputs[4] == '',
+                   "%s: sequence_lens is not supported" % node.name)
+        mace_check(inputs[7] == '',
+                   "%s: peepholes are not supported" % node.name)
+        mace_check(inputs[5] != '' or inputs[6] == '',
+                   "%s: initial_c needs initial_h" % node.name)
+        if inputs[3] == '':
+            hidden_size = node.attrs['hidden_size']
+            bias_shape = [directions, 2 * gates * hidden_size]
+            inputs[3] = node.name + '_bias'
+            self.add_tensor(inputs[3], bias_shape, mace_pb2.DT_FLOAT,
+                            np.zeros(bias_shape))
+        del op.input[:]
+        op.input.extend([name for name in inputs[:7] if name != ''])
+        # Unused outputs keep a name so that the others stay in place
+        for i in range(len(op.output)):
+            if op.output[i] == '':
+                op.output[i] = '%s_output_%d' % (node.name, i)
+
+        direction_arg = op.arg.add()
+        direction_arg.name = MaceKeyword.mace_direction_str
+        direction_arg.s = six.b(direction)
+        if 'clip' in node.attrs:
+            clip_arg = op.arg.add()
+            clip_arg.name = MaceKeyword.mace_clip_str
+            clip_arg.f = node.attrs['clip']
+        return op
+
+    def convert_gru(self, node):
+        op = self.convert_recurrent(node, 3, ['Sigmoid', 'Tanh'])
+        op.type = MaceOp.GRU.name
+
+        linear_before_reset_arg = op.arg.add()
+        linear_before_reset_arg.name = \
+            MaceKeyword.mace_linear_before_reset_str
+        linear_before_reset_arg.i = node.attrs.get('linear_before_reset', 0)
+
+    def convert_lstm(self, node):
+        op = self.convert_recurrent(node, 4, ['Sigmoid', 'Tanh', 'Tanh'])
+        op.type = MaceOp.LSTM.name
+        mace_check(node.attrs.get('input_forget', 0) == 0,
+                   "%s: input_forget is not supported" % node.name)
 
     def convert_lstm_nonlinear(self, node):
         op = self.convert_general_op(node)
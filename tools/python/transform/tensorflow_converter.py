@@ -134,6 +134,7 @@ TFSupportedOps = [
     'Sum',
     'Tanh',
     'Tile',
+    'TopKV2',
     'Transpose',
     'Unpack',
     'Unstack',
@@ -302,6 +303,7 @@ class TensorflowConverter(base_converter.ConverterInterface):
             TFOpType.StridedSlice.name: self.convert_stridedslice,
             TFOpType.Sum.name: self.convert_reduce,
             TFOpType.Tile.name: self.convert_tile,
+            TFOpType.TopKV2.name: self.convert_top_k,
             TFOpType.Transpose.name: self.convert_transpose,
             TFOpType.Unpack.name: self.convert_unstack,
             TFOpType.Unstack.name: self.convert_unstack,
@@ -1126,6 +1128,22 @@ class TensorflowConverter(base_converter.ConverterInterface):
         keep_dims_arg.name = MaceKeyword.mace_keepdims_str
         keep_dims_arg.i = 0
 
+    def convert_top_k(self, tf_op):
+        op = self.convert_general_op(tf_op)
+        op.type = MaceOp.TopK.name
+        op.output_type.extend([self._option.data_type, mace_pb2.DT_INT32])
+
+        if tf_op.inputs[1].op.type == TFOpType.Const.name:
+            top_k_arg = op.arg.add()
+            top_k_arg.name = MaceKeyword.mace_top_k_str
+            top_k_arg.i = int(tf_op.inputs[1].eval().astype(np.int32))
+            del op.input[1]
+            self._skip_tensor.add(tf_op.inputs[1].name)
+
+        sorted_arg = op.arg.add()
+        sorted_arg.name = MaceKeyword.mace_sorted_str
+        sorted_arg.i = int(tf_op.get_attr('sorted'))
+
     def convert_split(self, tf_op, axis_idx=0):
         op = self.convert_general_op(tf_op)
         num_or_size_splits = tf_op.get_attr('num_split')
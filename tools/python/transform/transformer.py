@@ -86,6 +86,7 @@ class Transformer(base_converter.ConverterInterface):
             TransformerRule.FLATTEN_ATROUS_CONV: self.flatten_atrous_conv,
             TransformerRule.FOLD_ACTIVATION: self.fold_activation,
             TransformerRule.FOLD_SQRDIFF_MEAN: self.fold_squared_diff_mean,
+            TransformerRule.FOLD_EMBEDDING_BAG: self.fold_embedding_bag,
             # fold_instance_norm depends on fold_squared_diff_mean
             TransformerRule.FOLD_INSTANCE_NORM: self.fold_instance_norm,
             TransformerRule.FOLD_MOMENTS: self.fold_moments,
@@ -543,6 +544,61 @@ class Transformer(base_converter.ConverterInterface):
 
         return False
 
+    def fold_embedding_bag(self):
+        if self._option.device != DeviceType.CPU.value:
+            return False
+        net = self._model
+        for op in net.op:
+            # gather -> reduce over the last axis of the indices
+            if op.type != MaceOp.Gather.name or \
+                    op.input[0] not in self._consts or \
+                    len(op.output_shape) != 1 or \
+                    self.consumer_count(op.output[0]) != 1:
+                continue
+            gather_axis = ConverterUtil.get_arg(op, MaceKeyword.mace_axis_str)
+            if gather_axis is not None and gather_axis.i != 0:
+                continue
+            consumer_op = self._consumers[op.output[0]][0]
+            if consumer_op.type != MaceOp.Reduce.name or \
+                    len(consumer_op.input) != 1:
+                continue
+            reduce_type = ConverterUtil.get_arg(
+                consumer_op, MaceKeyword.mace_reduce_type_str).i
+            if reduce_type not in [ReduceType.SUM.value,
+                                   ReduceType.MEAN.value,
+                                   ReduceType.MAX.value]:
+                continue
+            output_rank = len(op.output_shape[0].dims)
+            bag_axis = output_rank - len(self._consts[op.input[0]].dims)
+            axis = ConverterUtil.get_arg(
+                consumer_op, MaceKeyword.mace_axis_str).ints
+            axis = [a + output_rank if a < 0 else a for a in axis]
+            if bag_axis < 0 or axis != [bag_axis]:
+                continue
+            keep_dims = ConverterUtil.get_arg(
+                consumer_op, MaceKeyword.mace_keepdims_str)
+
+            print("Fold Gather and Reduce to EmbeddingBag: %s" % op.name)
+            op.type = MaceOp.EmbeddingBag.name
+            args = [arg for arg in op.arg
+                    if arg.name != MaceKeyword.mace_axis_str]
+            del op.arg[:]
+            op.arg.extend(args)
+            reduce_type_arg = op.arg.add()
+            reduce_type_arg.name = MaceKeyword.mace_reduce_type_str
+            reduce_type_arg.i = reduce_type
+            keep_dims_arg = op.arg.add()
+            keep_dims_arg.name = MaceKeyword.mace_keepdims_str
+            keep_dims_arg.i = keep_dims.i if keep_dims is not None else 0
+            op.output[0] = consumer_op.output[0]
+            del op.output_shape[0].dims[:]
+            op.output_shape[0].dims.extend(consumer_op.output_shape[0].dims)
+            self.replace_quantize_info(op, consumer_op)
+            self.safe_remove_node(consumer_op, op)
+            return True
+
+        return False
+
     def fold_moments(self):
         if self._option.device != DeviceType.HTP.value:
             return False
@@ -2578,7 +2634,7 @@ class Transformer(base_converter.ConverterInterface):
 
     def fp16_gather_weight(self):
         for op in self._model.op:
-            if op.type != MaceOp.Gather.name:
+            if op.type not in [MaceOp.Gather.name, MaceOp.EmbeddingBag.name]:
                 continue
             if op.input[0] not in self._consts:
                 raise KeyError("Not in const tensor: " + str(op.input[0]))
@@ -2590,35 +2646,17 @@ class Transformer(base_converter.ConverterInterface):
 
             print("FP16 Embedding Lookup Weights: %s" % const_tensor.name)
 
-            op_outputs = [x for x in op.output]
-            new_gather_name = op.name + '_fp16'
-            new_gather_output_name = new_gather_name + ":0"
-            dehalve_name = op.name
-
             # fp16 weights
             const_tensor.data_type = mace_pb2.DT_FLOAT16
 
-            # change gather
-            op.name = new_gather_name
-            op.output[:] = [new_gather_output_name]
-            # op.output.extend([new_gather_output_name])
+            # the op reads the fp16 weights and writes fp32 rows directly
             data_type_arg = ConverterUtil.get_arg(op, MaceKeyword.mace_op_data_type_str)  # noqa
             if data_type_arg is None:
                 data_type_arg = op.arg.add()
                 data_type_arg.name = MaceKeyword.mace_op_data_type_str
             data_type_arg.i = mace_pb2.DT_FLOAT16
-
-            # add dehalve
-            dehalve_op = self._model.op.add()
-            dehalve_op.name = dehalve_name
-            dehalve_op.type = MaceOp.Cast.name
-            dehalve_op.input.extend([new_gather_output_name])
-            dehalve_op.output.extend(op_outputs)
-            dehalve_op.output_shape.extend(op.output_shape)
-            dehalve_op.output_type.extend([mace_pb2.DT_FLOAT])
-            data_type_arg = dehalve_op.arg.add()
-            data_type_arg.name = MaceKeyword.mace_op_data_type_str
-            data_type_arg.i = mace_pb2.DT_FLOAT16
+            del op.output_type[:]
+            op.output_type.extend([mace_pb2.DT_FLOAT])
 
     def fp16_matmul_weight(self):
         if self._option.device != DeviceType.CPU.value: